@@ -169,4 +169,9 @@ void checkGLError(const char* file, int32_t line);
 #define CHECK_GL_ERROR() checkGLError(__FILE__, __LINE__)
 #endif
 
+// Route GL calls through the dispatch table (see NvGLUtils/NvGLDispatch.h)
+#ifdef NV_GL_DISPATCH
+#include <NvGLUtils/NvGLDispatch.h>
+#endif
+
 #endif
@@ -0,0 +1,201 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2008-2014 NVIDIA Corporation. All rights reserved.
+// Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
+// Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
+
+
+#ifndef NV_NSFOUNDATION_NSCONCURRENTPOOL_H
+#define NV_NSFOUNDATION_NSCONCURRENTPOOL_H
+
+#include "NsMutex.h"
+#include "NsSList.h"
+#include "NsUserAllocated.h"
+
+namespace nvidia
+{
+namespace shdfnd
+{
+/*!
+Element pool that may be used from several threads at once.
+
+Each thread keeps two magazines of free elements and only touches shared
+state when both are empty or both are full. Then it swaps a magazine with
+the lock-free lists of full and empty magazines. Only when those run dry or
+hold too many elements do elements move to or from their slabs, under a
+lock. Every slab counts its live elements, so a slab is released as soon as
+its last element comes back.
+
+Elements carry a hidden pointer to their slab. A thread that is done with
+the pool, for example because it is about to exit, should call
+releaseThreadCache so that the elements in its magazines go back to their
+slabs; otherwise they are only reclaimed when the pool is destroyed.
+*/
+class NV_FOUNDATION_API ConcurrentPoolImpl
+{
+	NV_NOCOPY(ConcurrentPoolImpl)
+  public:
+	ConcurrentPoolImpl(uint32_t elementSize, uint32_t elementAlignment, uint32_t elementsPerSlab);
+	~ConcurrentPoolImpl();
+
+	void* allocate();
+	void deallocate(void* element);
+
+	// returns the calling thread's magazines to the pool; the thread gets new
+	// ones if it uses the pool again
+	void releaseThreadCache();
+
+	// calls destroy for every element that has not been deallocated, not thread safe
+	void disposeElements(void (*destroy)(void*));
+
+	uint32_t getSlabCount() const
+	{
+		return mSlabCount;
+	}
+
+	// defined in NsConcurrentPool.cpp
+	struct Slab;
+	struct Magazine;
+	struct ThreadCache;
+
+  private:
+	ThreadCache& getThreadCache();
+	ThreadCache* createThreadCache();
+	Magazine* createMagazine();
+
+	void fillFromSlabs(Magazine& magazine);
+	void returnToSlabs(Magazine& magazine);
+	Slab* createSlab();
+	void releaseSlab(Slab* slab);
+
+	uint32_t mHeaderSize; // element's slab pointer, padded to the element alignment
+	uint32_t mStride;
+	uint32_t mElementsPerSlab;
+	uint32_t mSlabSize;
+	uint32_t mTlsIndex;
+
+	SList mFullMagazines;
+	SList mEmptyMagazines;
+	volatile int32_t mFullMagazineCount;
+
+	Mutex mSlabLock;
+	Slab* mPartialSlabs; // slabs with free elements
+	Slab* mFullSlabs;    // slabs without free elements
+	Slab* mEmptySlab;    // one empty slab is kept to avoid thrashing
+	uint32_t mSlabCount;
+
+	Mutex mThreadCacheLock;
+	ThreadCache* mThreadCaches;
+};
+
+template <class T>
+class ConcurrentPool : public UserAllocated
+{
+	NV_NOCOPY(ConcurrentPool)
+  public:
+	// types whose size is a multiple of 16 keep their 16 byte alignment
+	ConcurrentPool(uint32_t elementsPerSlab = 64)
+	: mImpl(sizeof(T), (sizeof(T) & 15) ? uint32_t(sizeof(void*)) : 16u, elementsPerSlab)
+	{
+		NV_COMPILE_TIME_ASSERT(sizeof(T) >= sizeof(size_t));
+	}
+
+	~ConcurrentPool()
+	{
+		mImpl.disposeElements(&destroyElement);
+	}
+
+	NV_INLINE T* allocate()
+	{
+		return reinterpret_cast<T*>(mImpl.allocate());
+	}
+
+	NV_INLINE void deallocate(T* p)
+	{
+		if(p)
+			mImpl.deallocate(p);
+	}
+
+	NV_INLINE T* construct()
+	{
+		T* t = allocate();
+		return t ? new (t) T() : 0;
+	}
+
+	template <class A1>
+	NV_INLINE T* construct(A1& a)
+	{
+		T* t = allocate();
+		return t ? new (t) T(a) : 0;
+	}
+
+	template <class A1, class A2>
+	NV_INLINE T* construct(A1& a, A2& b)
+	{
+		T* t = allocate();
+		return t ? new (t) T(a, b) : 0;
+	}
+
+	template <class A1, class A2, class A3>
+	NV_INLINE T* construct(A1& a, A2& b, A3& c)
+	{
+		T* t = allocate();
+		return t ? new (t) T(a, b, c) : 0;
+	}
+
+	NV_INLINE void destroy(T* const p)
+	{
+		if(p)
+		{
+			p->~T();
+			deallocate(p);
+		}
+	}
+
+	// see ConcurrentPoolImpl::releaseThreadCache
+	void releaseThreadCache()
+	{
+		mImpl.releaseThreadCache();
+	}
+
+	uint32_t getSlabCount() const
+	{
+		return mImpl.getSlabCount();
+	}
+
+  private:
+	static void destroyElement(void* p)
+	{
+		reinterpret_cast<T*>(p)->~T();
+	}
+
+	ConcurrentPoolImpl mImpl;
+};
+
+} // namespace shdfnd
+} // namespace nvidia
+
+#endif // #ifndef NV_NSFOUNDATION_NSCONCURRENTPOOL_H
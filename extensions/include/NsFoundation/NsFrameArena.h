@@ -0,0 +1,238 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2008-2014 NVIDIA Corporation. All rights reserved.
+// Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
+// Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
+
+
+#ifndef NV_NSFOUNDATION_NSFRAMEARENA_H
+#define NV_NSFOUNDATION_NSFRAMEARENA_H
+
+#include "NsAllocator.h"
+#include "NsMutex.h"
+#include "NsUserAllocated.h"
+#include "NvAssert.h"
+
+#include <stddef.h>
+
+namespace nvidia
+{
+namespace shdfnd
+{
+/**
+Linear allocator for data that does not outlive the frame it was created in.
+
+Allocations bump an offset into the buffer of the current frame and are never
+freed individually. nextFrame() moves on to the next buffer and resets it, so
+with N buffers memory stays valid until nextFrame() has been called N times.
+Allocations that do not fit fall back to the base allocator and are released
+when their frame's buffer is reset.
+
+allocate() may be called from any thread, nextFrame() must not run
+concurrently with it.
+*/
+class NV_FOUNDATION_API FrameArena : public UserAllocated
+{
+	NV_NOCOPY(FrameArena)
+  public:
+	static const uint32_t sMaxFrameCount = 3;
+
+	struct Stats
+	{
+		uint32_t mAllocations;
+		uint32_t mBytes; // including alignment
+		uint32_t mOverflowAllocations;
+		uint32_t mOverflowBytes;
+	};
+
+	FrameArena(uint32_t bytesPerFrame, uint32_t frameCount = 2);
+	~FrameArena();
+
+	// 16 byte aligned
+	void* allocate(size_t size, const char* file, int line);
+	void deallocate(void*)
+	{
+	}
+
+	void nextFrame();
+
+	Stats getFrameStats() const;
+	const Stats& getLastFrameStats() const
+	{
+		return mLastFrameStats;
+	}
+	// most bytes, including overflow, used by any frame so far
+	uint32_t getPeakBytes() const
+	{
+		return mPeakBytes;
+	}
+	uint32_t getBytesPerFrame() const
+	{
+		return mBytesPerFrame;
+	}
+
+	// arena used by default constructed FrameArenaAllocator and FrameArenaStlAllocator
+	static void setCurrent(FrameArena* arena);
+	static FrameArena* getCurrent();
+
+  private:
+	void* allocateOverflow(size_t size, const char* file, int line);
+	void releaseOverflow(uint32_t frame);
+
+	struct Frame
+	{
+		uint8_t* mBuffer;
+		volatile int32_t mOffset;
+		volatile int32_t mAllocations;
+		volatile int32_t mOverflowAllocations;
+		volatile int32_t mOverflowBytes;
+		void* mOverflow; // singly linked through the first word of each block
+	};
+
+	Frame mFrames[sMaxFrameCount];
+	uint32_t mFrameCount;
+	uint32_t mCurrentFrame;
+	uint32_t mBytesPerFrame;
+	Stats mLastFrameStats;
+	uint32_t mPeakBytes;
+	Mutex mOverflowLock;
+};
+
+/**
+Allocator policy for Array, HashMap etc. that takes memory from a FrameArena.
+*/
+class FrameArenaAllocator
+{
+  public:
+	NV_FORCE_INLINE FrameArenaAllocator(const char* = 0) : mArena(FrameArena::getCurrent())
+	{
+		NV_ASSERT(mArena);
+	}
+	NV_FORCE_INLINE FrameArenaAllocator(FrameArena& arena) : mArena(&arena)
+	{
+	}
+	NV_FORCE_INLINE void* allocate(size_t size, const char* file, int line)
+	{
+		return mArena->allocate(size, file, line);
+	}
+	NV_FORCE_INLINE void deallocate(void*)
+	{
+	}
+
+  private:
+	FrameArena* mArena;
+};
+
+/**
+Standard library allocator that takes memory from a FrameArena, e.g. for
+std::vector or std::basic_string temporaries built during a frame.
+*/
+template <typename T>
+class FrameArenaStlAllocator
+{
+  public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template <typename U>
+	struct rebind
+	{
+		typedef FrameArenaStlAllocator<U> other;
+	};
+
+	FrameArenaStlAllocator() : mArena(FrameArena::getCurrent())
+	{
+		NV_ASSERT(mArena);
+	}
+	FrameArenaStlAllocator(FrameArena& arena) : mArena(&arena)
+	{
+	}
+	template <typename U>
+	FrameArenaStlAllocator(const FrameArenaStlAllocator<U>& other) : mArena(other.getArena())
+	{
+	}
+
+	pointer address(reference x) const
+	{
+		return &x;
+	}
+	const_pointer address(const_reference x) const
+	{
+		return &x;
+	}
+
+	pointer allocate(size_type n, const void* = 0)
+	{
+		return reinterpret_cast<pointer>(mArena->allocate(n * sizeof(T), __FILE__, __LINE__));
+	}
+	void deallocate(pointer, size_type)
+	{
+	}
+
+	void construct(pointer p, const T& val)
+	{
+		NV_PLACEMENT_NEW(p, T)(val);
+	}
+	void destroy(pointer p)
+	{
+		NV_UNUSED(p);
+		p->~T();
+	}
+
+	size_type max_size() const
+	{
+		return size_type(0x7fffffff) / sizeof(T);
+	}
+
+	FrameArena* getArena() const
+	{
+		return mArena;
+	}
+
+	template <typename U>
+	bool operator==(const FrameArenaStlAllocator<U>& other) const
+	{
+		return mArena == other.getArena();
+	}
+	template <typename U>
+	bool operator!=(const FrameArenaStlAllocator<U>& other) const
+	{
+		return mArena != other.getArena();
+	}
+
+  private:
+	FrameArena* mArena;
+};
+
+} // namespace shdfnd
+} // namespace nvidia
+
+#endif // #ifndef NV_NSFOUNDATION_NSFRAMEARENA_H
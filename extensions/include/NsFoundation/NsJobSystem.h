@@ -0,0 +1,166 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2008-2014 NVIDIA Corporation. All rights reserved.
+// Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
+// Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
+
+#ifndef NV_NSFOUNDATION_NSJOBSYSTEM_H
+#define NV_NSFOUNDATION_NSJOBSYSTEM_H
+
+#include "NsConcurrentPool.h"
+#include "NsMutex.h"
+#include "NsSync.h"
+#include "NsUserAllocated.h"
+
+namespace nvidia
+{
+namespace shdfnd
+{
+class JobSystem;
+
+/**
+Counts the jobs that have been run against it and not yet finished. Jobs
+can wait for a counter to reach zero, either by JobSystem::wait() or by
+being run with the counter as a dependency. A counter must outlive the
+jobs that are run against it and that depend on it.
+*/
+class JobCounter
+{
+	NV_NOCOPY(JobCounter)
+
+  public:
+	JobCounter() : mCount(0), mDependents(NULL)
+	{
+	}
+
+	/** True once every job run against the counter has finished */
+	bool isDone() const
+	{
+		return mCount == 0;
+	}
+
+  private:
+	friend class JobSystem;
+
+	volatile int32_t mCount;
+	void* mDependents; // jobs waiting for mCount to reach zero
+};
+
+/**
+Work-stealing job scheduler.
+
+Each worker thread owns a deque of jobs; it pushes and pops at one end and
+idle workers steal from the other. The thread that creates the job system
+takes part as worker 0, but only runs jobs while it waits on a counter, so
+it should never block on anything else while jobs that it waits on may be
+queued behind it. Jobs may run further jobs and wait on them.
+
+Jobs may be run from the creating thread and from within jobs. Jobs run
+from any other thread execute immediately on that thread.
+*/
+class NV_FOUNDATION_API JobSystem : public UserAllocated
+{
+	NV_NOCOPY(JobSystem)
+
+  public:
+	/** A job. workerIndex is the index of the thread running it, 0 for the creating thread */
+	typedef void (*JobFunction)(void* userData, uint32_t workerIndex);
+
+	/** A slice [begin, end) of a parallel for */
+	typedef void (*RangeFunction)(void* userData, uint32_t begin, uint32_t end, uint32_t workerIndex);
+
+	/** One worker per core, less one for the creating thread, but at least one */
+	static const uint32_t defaultWorkerCount = 0xffffffff;
+
+	/**
+	Start the worker threads.
+	\param workerCount the number of threads besides the creating one. With
+	none, jobs only run while the creating thread waits.
+	\param affinityMask if non-zero, worker n is bound to the n-th set bit of
+	the mask, wrapping around. See ThreadImpl::setAffinityMask()
+	*/
+	JobSystem(uint32_t workerCount = defaultWorkerCount, uint32_t affinityMask = 0);
+
+	/** Stop the worker threads. Every job must have finished. */
+	~JobSystem();
+
+	/** The number of threads that run jobs, including the creating thread */
+	uint32_t getThreadCount() const
+	{
+		return mWorkerCount + 1;
+	}
+
+	/** The index of the calling thread, 0 for the creating thread and any thread not in the system */
+	uint32_t getCurrentThreadIndex() const;
+
+	/** Queue a job, counted by counter */
+	void run(JobFunction function, void* userData, JobCounter& counter);
+
+	/** Queue a job, counted by counter, that starts once dependency reaches zero */
+	void run(JobFunction function, void* userData, JobCounter& counter, JobCounter& dependency);
+
+	/**
+	Queue a parallel for over [begin, end), counted by counter. The range is
+	split in halves as idle workers steal it, down to grainSize items.
+	*/
+	void parallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, RangeFunction function, void* userData,
+	                 JobCounter& counter);
+
+	/** Run a parallel for over [begin, end) and wait for it to finish */
+	void parallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, RangeFunction function, void* userData);
+
+	/** Run queued jobs on the calling thread until counter reaches zero */
+	void wait(JobCounter& counter);
+
+  private:
+	struct Job;
+	struct DependentJob;
+	struct Worker;
+
+	bool push(uint32_t threadIndex, const Job& job);
+	bool takeJob(uint32_t threadIndex, Job& job);
+	void execute(uint32_t threadIndex, Job& job);
+	void schedule(const Job& job);
+	void finish(JobCounter& counter);
+	void workerLoop(uint32_t threadIndex);
+	static void* workerThunk(void* arg);
+
+	uint32_t mWorkerCount;
+	Worker* mWorkers; // mWorkerCount + 1, the creating thread first
+	uint32_t mTlsIndex;
+
+	Mutex mDependencyLock;
+	ConcurrentPool<DependentJob> mDependentJobs; // freed by whichever thread finishes the dependency
+	Sync mWakeup;
+	volatile int32_t mQueuedJobs;
+	volatile int32_t mSleepingWorkers;
+	volatile int32_t mQuit;
+};
+
+} // namespace shdfnd
+} // namespace nvidia
+
+#endif // #ifndef NV_NSFOUNDATION_NSJOBSYSTEM_H
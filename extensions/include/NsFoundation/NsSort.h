@@ -34,8 +34,11 @@
 @{
 */
 
+#include "NvMath.h"
 #include "NsSortInternals.h"
 #include "NsAlloca.h"
+#include "NsBitUtils.h"
+#include "NsJobSystem.h"
 
 #define NV_SORT_PARANOIA NV_DEBUG
 
@@ -120,6 +123,257 @@ void sort(T* elements, uint32_t count)
 	sort(elements, count, shdfnd::Less<T>(), typename shdfnd::AllocatorTraits<T>::Type());
 }
 
+/**
+\brief Computes the permutation that stably sorts keys in ascending order, with
+an LSD radix sort. Keys may be uint32_t, int32_t or float.
+
+indices receives the sorted order, scratch must also hold count entries. If
+indicesAreValid is set, indices holds a permutation to start from, typically
+the previous result, and the sort returns early when it is still in order.
+*/
+template <class Key>
+void radixSortIndices(const Key* keys, uint32_t count, uint32_t* indices, uint32_t* scratch,
+                      bool indicesAreValid = false)
+{
+	typedef internal::RadixKey<Key> Radix;
+
+	if(!count)
+		return;
+
+	if(indicesAreValid)
+	{
+		uint32_t i = 1;
+		for(uint32_t previous = Radix::toBits(keys[indices[0]]); i < count; i++)
+		{
+			const uint32_t bits = Radix::toBits(keys[indices[i]]);
+			if(bits < previous)
+				break;
+			previous = bits;
+		}
+		if(i == count)
+			return;
+	}
+	else
+	{
+		for(uint32_t i = 0; i < count; i++)
+			indices[i] = i;
+	}
+
+	uint32_t histograms[4 * 256];
+	uint32_t offsets[256];
+	const uint32_t passes = internal::radixHistograms(keys, count, histograms);
+
+	uint32_t* src = indices;
+	uint32_t* dst = scratch;
+	for(uint32_t pass = 0, shift = 0; pass < 4; pass++, shift += 8)
+	{
+		if(!(passes & (1 << pass)))
+			continue;
+
+		internal::radixOffsets(histograms + pass * 256, offsets);
+		for(uint32_t i = 0; i < count; i++)
+		{
+			const uint32_t index = src[i];
+			dst[offsets[(Radix::toBits(keys[index]) >> shift) & 255]++] = index;
+		}
+		swap(src, dst);
+	}
+
+	if(src != indices)
+		intrinsics::memCopy(indices, src, count * sizeof(uint32_t));
+
+#if NV_SORT_PARANOIA
+	for(uint32_t i = 1; i < count; i++)
+		NV_ASSERT(Radix::toBits(keys[indices[i - 1]]) <= Radix::toBits(keys[indices[i]]));
+#endif
+}
+
+template <class Key, class Allocator>
+void radixSortIndices(const Key* keys, uint32_t count, uint32_t* indices, const Allocator& inAllocator)
+{
+	Allocator allocator(inAllocator);
+	uint32_t* scratch = reinterpret_cast<uint32_t*>(allocator.allocate(sizeof(uint32_t) * count, __FILE__, __LINE__));
+	radixSortIndices(keys, count, indices, scratch);
+	allocator.deallocate(scratch);
+}
+
+/**
+\brief Stably sorts key-value pairs by key with an LSD radix sort. Keys may be
+uint32_t, int32_t or float; keyScratch and valueScratch must hold count entries.
+*/
+template <class Key, class Value>
+void radixSortPairs(Key* keys, Value* values, uint32_t count, Key* keyScratch, Value* valueScratch)
+{
+	typedef internal::RadixKey<Key> Radix;
+
+	if(!count)
+		return;
+
+	uint32_t histograms[4 * 256];
+	uint32_t offsets[256];
+	const uint32_t passes = internal::radixHistograms(keys, count, histograms);
+
+	Key* srcKeys = keys;
+	Key* dstKeys = keyScratch;
+	Value* srcValues = values;
+	Value* dstValues = valueScratch;
+	for(uint32_t pass = 0, shift = 0; pass < 4; pass++, shift += 8)
+	{
+		if(!(passes & (1 << pass)))
+			continue;
+
+		internal::radixOffsets(histograms + pass * 256, offsets);
+		for(uint32_t i = 0; i < count; i++)
+		{
+			const uint32_t to = offsets[(Radix::toBits(srcKeys[i]) >> shift) & 255]++;
+			dstKeys[to] = srcKeys[i];
+			dstValues[to] = srcValues[i];
+		}
+		swap(srcKeys, dstKeys);
+		swap(srcValues, dstValues);
+	}
+
+	if(srcKeys != keys)
+	{
+		for(uint32_t i = 0; i < count; i++)
+		{
+			keys[i] = srcKeys[i];
+			values[i] = srcValues[i];
+		}
+	}
+}
+
+namespace internal
+{
+template <class T, class Predicate, class Allocator>
+struct ParallelSort
+{
+	T* elements;
+	T* temp;
+	uint32_t count;
+	const Predicate* compare;
+	const Allocator* allocator;
+
+	uint32_t chunkSize;
+	T* src;
+	T* dst;
+	uint32_t width; // of the sorted runs being merged
+	uint32_t segmentsPerMerge;
+
+	// sorts the chunks and copies them into the temporary buffer
+	static void sortChunks(void* userData, uint32_t begin, uint32_t end, uint32_t)
+	{
+		ParallelSort& ps = *reinterpret_cast<ParallelSort*>(userData);
+		for(uint32_t chunk = begin; chunk < end; chunk++)
+		{
+			const uint32_t first = chunk * ps.chunkSize;
+			const uint32_t last = NvMin(first + ps.chunkSize, ps.count);
+			sort(ps.elements + first, last - first, *ps.compare, *ps.allocator);
+			for(uint32_t i = first; i < last; i++)
+				NV_PLACEMENT_NEW(ps.temp + i, T)(ps.elements[i]);
+		}
+	}
+
+	// each merge of two runs is split into segments of the output
+	static void mergeSegments(void* userData, uint32_t begin, uint32_t end, uint32_t)
+	{
+		ParallelSort& ps = *reinterpret_cast<ParallelSort*>(userData);
+		for(uint32_t segment = begin; segment < end; segment++)
+		{
+			const uint32_t part = segment % ps.segmentsPerMerge;
+			const uint32_t lo = (segment / ps.segmentsPerMerge) * 2 * ps.width;
+			const uint32_t mid = NvMin(lo + ps.width, ps.count);
+			const uint32_t hi = NvMin(mid + ps.width, ps.count);
+
+			const T* a = ps.src + lo;
+			const T* b = ps.src + mid;
+			const uint32_t aCount = mid - lo, bCount = hi - mid;
+			const uint32_t k0 = uint32_t(uint64_t(hi - lo) * part / ps.segmentsPerMerge);
+			const uint32_t k1 = uint32_t(uint64_t(hi - lo) * (part + 1) / ps.segmentsPerMerge);
+			const uint32_t i0 = mergeCoRank(a, aCount, b, bCount, k0, *ps.compare);
+			const uint32_t i1 = mergeCoRank(a, aCount, b, bCount, k1, *ps.compare);
+
+			merge(a + i0, a + i1, b + k0 - i0, b + k1 - i1, ps.dst + lo + k0, *ps.compare);
+		}
+	}
+
+	static void copyBack(void* userData, uint32_t begin, uint32_t end, uint32_t)
+	{
+		ParallelSort& ps = *reinterpret_cast<ParallelSort*>(userData);
+		for(uint32_t i = begin; i < end; i++)
+			ps.elements[i] = ps.temp[i];
+	}
+};
+} // namespace internal
+
+/**
+\brief Sorts an array on the threads of a job system: chunks are sorted in
+parallel, then merged pairwise with each merge split across the threads.
+The sort is not stable. Small arrays are sorted on the calling thread.
+*/
+template <class T, class Predicate, class Allocator>
+void parallelSort(T* elements, uint32_t count, const Predicate& compare, JobSystem& jobSystem,
+                  const Allocator& inAllocator)
+{
+	static const uint32_t PARALLEL_SORT_CUTOFF = 16384;
+
+	const uint32_t threadCount = jobSystem.getThreadCount();
+	if(count < PARALLEL_SORT_CUTOFF || threadCount == 1)
+	{
+		sort(elements, count, compare, inAllocator);
+		return;
+	}
+
+	// a few chunks per thread so that work stealing can even out the merges
+	const uint32_t chunkCount = NvMin(nextPowerOfTwo(threadCount * 4 - 1), count / (PARALLEL_SORT_CUTOFF / 4));
+
+	Allocator allocator(inAllocator);
+	internal::ParallelSort<T, Predicate, Allocator> ps;
+	ps.elements = elements;
+	ps.temp = reinterpret_cast<T*>(allocator.allocate(sizeof(T) * count, __FILE__, __LINE__));
+	ps.count = count;
+	ps.compare = &compare;
+	ps.allocator = &allocator;
+	ps.chunkSize = (count + chunkCount - 1) / chunkCount;
+
+	jobSystem.parallelFor(0, chunkCount, 1, ps.sortChunks, &ps);
+
+	// the sorted chunks are in both buffers, merge from temp first
+	ps.src = ps.temp;
+	ps.dst = elements;
+	for(ps.width = ps.chunkSize; ps.width < count; ps.width *= 2)
+	{
+		const uint32_t mergeCount = (count + 2 * ps.width - 1) / (2 * ps.width);
+		ps.segmentsPerMerge = NvMax(chunkCount / mergeCount, 1u);
+		jobSystem.parallelFor(0, mergeCount * ps.segmentsPerMerge, 1, ps.mergeSegments, &ps);
+		swap(ps.src, ps.dst);
+	}
+
+	if(ps.src != elements)
+		jobSystem.parallelFor(0, count, PARALLEL_SORT_CUTOFF, ps.copyBack, &ps);
+
+	for(uint32_t i = 0; i < count; i++)
+		ps.temp[i].~T();
+	allocator.deallocate(ps.temp);
+
+#if NV_SORT_PARANOIA
+	for(uint32_t i = 1; i < count; i++)
+		NV_ASSERT(!compare(elements[i], elements[i - 1]));
+#endif
+}
+
+template <class T, class Predicate>
+void parallelSort(T* elements, uint32_t count, const Predicate& compare, JobSystem& jobSystem)
+{
+	parallelSort(elements, count, compare, jobSystem, typename shdfnd::AllocatorTraits<T>::Type());
+}
+
+template <class T>
+void parallelSort(T* elements, uint32_t count, JobSystem& jobSystem)
+{
+	parallelSort(elements, count, shdfnd::Less<T>(), jobSystem, typename shdfnd::AllocatorTraits<T>::Type());
+}
+
 } // namespace shdfnd
 } // namespace nvidia
 
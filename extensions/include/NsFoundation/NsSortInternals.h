@@ -179,6 +179,105 @@ class Stack
 		return mSize == 0;
 	}
 };
+
+// Maps keys to unsigned integers with the same ordering
+template <class Key>
+struct RadixKey;
+
+template <>
+struct RadixKey<uint32_t>
+{
+	static NV_FORCE_INLINE uint32_t toBits(uint32_t key)
+	{
+		return key;
+	}
+};
+
+template <>
+struct RadixKey<int32_t>
+{
+	static NV_FORCE_INLINE uint32_t toBits(int32_t key)
+	{
+		return uint32_t(key) ^ 0x80000000;
+	}
+};
+
+template <>
+struct RadixKey<float>
+{
+	// negative floats have all bits flipped so that they order in reverse
+	static NV_FORCE_INLINE uint32_t toBits(float key)
+	{
+		union
+		{
+			float f;
+			uint32_t u;
+		} bits;
+		bits.f = key;
+		return bits.u ^ (uint32_t(int32_t(bits.u) >> 31) | 0x80000000);
+	}
+};
+
+// Counts the four byte histograms in one pass over the keys. Returns a bit
+// per byte that needs sorting, i.e. not all keys share its value.
+template <class Key>
+uint32_t radixHistograms(const Key* keys, uint32_t count, uint32_t* histograms)
+{
+	intrinsics::memZero(histograms, 4 * 256 * sizeof(uint32_t));
+	for(uint32_t i = 0; i < count; i++)
+	{
+		const uint32_t bits = RadixKey<Key>::toBits(keys[i]);
+		histograms[bits & 255]++;
+		histograms[256 + ((bits >> 8) & 255)]++;
+		histograms[512 + ((bits >> 16) & 255)]++;
+		histograms[768 + (bits >> 24)]++;
+	}
+
+	const uint32_t first = RadixKey<Key>::toBits(keys[0]);
+	uint32_t passes = 0;
+	for(uint32_t pass = 0; pass < 4; pass++)
+	{
+		if(histograms[pass * 256 + ((first >> (pass * 8)) & 255)] != count)
+			passes |= 1 << pass;
+	}
+	return passes;
+}
+
+NV_INLINE void radixOffsets(const uint32_t* histogram, uint32_t* offsets)
+{
+	offsets[0] = 0;
+	for(uint32_t i = 1; i < 256; i++)
+		offsets[i] = offsets[i - 1] + histogram[i - 1];
+}
+
+// Finds how many elements of a come before output position k when merging
+// a and b, taking from a first on ties.
+template <class T, class Predicate>
+uint32_t mergeCoRank(const T* a, uint32_t aCount, const T* b, uint32_t bCount, uint32_t k, const Predicate& compare)
+{
+	uint32_t lo = k > bCount ? k - bCount : 0;
+	uint32_t hi = k < aCount ? k : aCount;
+	while(lo < hi)
+	{
+		const uint32_t i = (lo + hi) / 2;
+		if(compare(b[k - i - 1], a[i]))
+			hi = i;
+		else
+			lo = i + 1;
+	}
+	return lo;
+}
+
+template <class T, class Predicate>
+void merge(const T* a, const T* aEnd, const T* b, const T* bEnd, T* out, const Predicate& compare)
+{
+	while(a < aEnd && b < bEnd)
+		*out++ = compare(*b, *a) ? *b++ : *a++;
+	while(a < aEnd)
+		*out++ = *a++;
+	while(b < bEnd)
+		*out++ = *b++;
+}
 } // namespace internal
 
 } // namespace shdfnd
@@ -46,6 +46,37 @@ union TempAllocatorChunk
 	uint8_t mPad[16];          // 16 byte aligned allocations
 };
 
+// Counters are gathered from all threads without synchronization, so they
+// are approximate while other threads allocate.
+struct TempAllocatorStats
+{
+	static const uint32_t sClassCount = 9; // 512B to 128kB chunks
+
+	uint64_t mThreadCacheHits[sClassCount]; // served from the calling thread's cache
+	uint64_t mGlobalHits[sClassCount];      // served from a batch on the shared free lists
+	uint64_t mMisses[sClassCount];          // new chunk from the base allocator
+	uint64_t mLargeAllocations;             // too big for a size class, forwarded
+	uint32_t mBytesCached[sClassCount];     // free bytes in thread caches and shared lists
+	uint32_t mHighWaterMark; // bytes taken from the base allocator for the size classes
+
+	static uint32_t getChunkSize(uint32_t sizeClass)
+	{
+		return 512u << sizeClass;
+	}
+
+	// fraction of size class allocations served without the base allocator
+	float getHitRate() const
+	{
+		uint64_t hits = 0, total = 0;
+		for(uint32_t i = 0; i < sClassCount; ++i)
+		{
+			hits += mThreadCacheHits[i] + mGlobalHits[i];
+			total += mThreadCacheHits[i] + mGlobalHits[i] + mMisses[i];
+		}
+		return total ? float(hits) / float(total) : 0.0f;
+	}
+};
+
 class TempAllocator
 {
   public:
@@ -54,6 +85,13 @@ class TempAllocator
 	}
 	NV_FOUNDATION_API void* allocate(size_t size, const char* file, int line);
 	NV_FOUNDATION_API void deallocate(void* ptr);
+
+	NV_FOUNDATION_API static void getStats(TempAllocatorStats& stats);
+
+	// Hands the calling thread's cached chunks back to the shared lists.
+	// Foundation threads do this when they exit; other threads that use the
+	// temp allocator should call it before they exit.
+	NV_FOUNDATION_API static void releaseThreadCache();
 };
 
 void initializeTempAllocatorGlobals();
@@ -199,6 +199,20 @@ public:
     /// \return true on success, false on failure.
     bool writeLogFile(const std::string& path, bool append, const char* fmt, ...);
 
+    /// Write a data file.
+    /// Writes a block of text, such as CSV or JSON, to a file beside the log files.
+    /// \param[in] path the partial path and filename (no extension) to write.
+    /// \param[in] extension the file extension, without the dot
+    /// \param[in] data the text to be written; any existing file is replaced
+    /// \return true on success, false on failure.
+    bool writeDataFile(const std::string& path, const char* extension, const std::string& data);
+
+    /// Writable directory.
+    /// The directory that data files are written to.  It exists and is writable
+    /// while the app runs, so it also holds caches of processed assets.
+    /// \return the directory path, without a trailing separator
+    static const char* getDataDirectory();
+
     /// Linker hack.
     /// An empty function that ensures the linker does not strip the framework
     // Function must be called in the concrete app subclass constructor to avoid link issues
@@ -0,0 +1,167 @@
+//----------------------------------------------------------------------------------
+// File:        NvAppBase/NvFrameStats.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+ 
+/* Frame time distribution stats */
+
+#ifndef NVFRAMESTATS_H
+#define NVFRAMESTATS_H
+
+#include <NvSimpleTypes.h>
+#include <string>
+#include <vector>
+
+/// \file
+/// Per-frame timing history and percentile summaries
+
+/// Frame timing recorder.
+/// Records CPU frame, update, draw and GPU times for every frame.  The most
+/// recent frames are kept in a ring buffer for export, while every frame is
+/// added to a log-linear (HDR-style) histogram per channel, so percentiles
+/// over arbitrarily long runs cost a fixed amount of memory and are accurate
+/// to within 1% of the value.
+class NvFrameStats
+{
+public:
+    /// Timing channels recorded per frame
+    enum Channel {
+        CHANNEL_FRAME = 0, ///< CPU wall-clock time of the whole frame
+        CHANNEL_UPDATE,    ///< CPU time spent in the app's update callback
+        CHANNEL_DRAW,      ///< CPU time spent recording and submitting the frame
+        CHANNEL_GPU,       ///< GPU time of the frame, when a GPU timer is present
+        CHANNEL_COUNT
+    };
+
+    /// Frame times in milliseconds; negative if the channel had no value
+    struct Sample {
+        float mTimes[CHANNEL_COUNT];
+    };
+
+    /// Summary of one channel.  All times are in milliseconds
+    struct Summary {
+        uint32_t mCount;
+        float mMean;
+        float mMin;
+        float mP50;
+        float mP95;
+        float mP99;
+        float mMax;
+    };
+
+    /// Constructor.
+    /// \param[in] historyFrames the number of most recent frames kept for export
+    NvFrameStats(uint32_t historyFrames = 16384);
+
+    /// Clears the history and the histograms
+    void reset();
+
+    /// Records one frame.
+    /// \param[in] sample the frame's times in milliseconds; a negative time
+    /// marks the channel as not available for this frame
+    void addFrame(const Sample& sample);
+
+    /// Get the number of frames recorded since the last reset
+    /// \return the frame count
+    uint32_t getFrameCount() const { return m_frameCount; }
+
+    /// Get the value below which the given fraction of a channel's frames fall.
+    /// \param[in] channel the channel to query
+    /// \param[in] percentile the percentile, in [0, 100]
+    /// \return the time in milliseconds, or 0 if the channel has no samples
+    float getPercentile(Channel channel, float percentile) const;
+
+    /// Get the number of frames of a channel that took longer than a time.
+    /// \param[in] channel the channel to query
+    /// \param[in] ms the threshold in milliseconds
+    /// \return the number of frames above the threshold
+    uint32_t getCountAbove(Channel channel, float ms) const;
+
+    /// Summarize a channel
+    /// \param[in] channel the channel to summarize
+    /// \param[out] summary the channel's statistics; mCount is 0 if the channel
+    /// had no samples
+    void getSummary(Channel channel, Summary& summary) const;
+
+    /// Get the number of stutters.
+    /// A stutter is a frame whose CPU frame time exceeds STUTTER_FACTOR times
+    /// the median frame time
+    /// \return the number of stuttering frames
+    uint32_t getStutterCount() const;
+
+    /// Get the name of a channel, as used in the exported files
+    /// \param[in] channel the channel
+    /// \return the null-terminated channel name
+    static const char* getChannelName(Channel channel);
+
+    /// Format the frame history as CSV, one line per frame, oldest first
+    /// \param[out] out the string the CSV text is appended to
+    void writeCSV(std::string& out) const;
+
+    /// Format the summary as a JSON object.
+    /// \param[out] out the string the JSON text is appended to
+    /// \param[in] config comma-separated "key": value pairs describing the run;
+    /// inserted verbatim into the object ahead of the statistics
+    void writeJSON(std::string& out, const std::string& config) const;
+
+    /// Frames slower than this multiple of the median count as stutters
+    static const float STUTTER_FACTOR;
+
+protected:
+    /// \privatesection
+    // Histogram values are microseconds.  Values below 2 * SUB_BUCKET_COUNT
+    // get one bucket each; above that every power of two is split into
+    // SUB_BUCKET_COUNT linear buckets.
+    enum {
+        SUB_BUCKET_BITS = 7,
+        SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS,
+        BUCKET_COUNT = (33 - SUB_BUCKET_BITS) * SUB_BUCKET_COUNT
+    };
+
+    static uint32_t bucketIndex(uint32_t us);
+    static uint32_t bucketHighestValue(uint32_t index);
+
+    struct Histogram {
+        uint32_t mCounts[BUCKET_COUNT];
+        uint32_t mTotal;
+        double mSum;
+        float mMin;
+        float mMax;
+    };
+
+    std::vector<Sample> m_history;
+    uint32_t m_historyNext;
+    uint32_t m_frameCount;
+    std::vector<Histogram> m_histograms;
+};
+
+#endif
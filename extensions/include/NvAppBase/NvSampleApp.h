@@ -40,6 +40,8 @@
 #include <NvAssert.h>
 #include <NsThread.h>
 #include <NsSync.h>
+#include <NsFrameArena.h>
+#include <NsJobSystem.h>
 
 #include "NvAppBase.h"
 #include "NV/NvStopWatch.h"
@@ -53,6 +55,7 @@
 /// Sample app base class.
 
 class NvFramerateCounter;
+class NvFrameStats;
 class NvInputTransformer;
 class NvInputHandler;
 class NvTweakBar;
@@ -112,6 +115,21 @@ public:
     /// \return the time since the last frame in seconds
     float getFrameDeltaTime() { return mFrameDelta; }
 
+    /// Per-frame scratch memory.
+    /// The arena is reset at frame boundaries; memory allocated from it stays
+    /// valid until the end of the following frame.  It is also the current
+    /// arena for default constructed nvidia::shdfnd::FrameArenaAllocator and
+    /// nvidia::shdfnd::FrameArenaStlAllocator.
+    /// \return the frame arena
+    nvidia::shdfnd::FrameArena& getFrameArena() { return *mFrameArena; }
+
+    /// Shared job system.
+    /// Created with the app, so that loaders and samples can split work across
+    /// the cores without starting threads of their own.  Jobs run from threads
+    /// other than the main thread execute immediately on the calling thread.
+    /// \return the job system
+    nvidia::shdfnd::JobSystem& getJobSystem() { return *mJobSystem; }
+
     /// Key binding.
     /// Adds a key binding.
     /// \param[in] var the tweak variable to be bound
@@ -229,6 +247,26 @@ protected:
     void baseHandleReaction(void);
     virtual void platformLogTestResults(float frameRate, int32_t frames) = 0;
     void logTestResults(float frameRate, int32_t frames);
+    void logFrameStats(float frameRate);
+
+    /// GPU frame timing for test mode.
+    /// The begin/end calls bracket the rendering of each test mode frame.
+    /// platformGetGPUFrameTime returns the GPU time of the most recent frame
+    /// whose results have arrived, which may lag a few frames behind.  Platforms
+    /// without a GPU timer leave these as they are and report no GPU times
+    virtual void platformBeginGPUFrameTimer(void) { }
+    virtual void platformEndGPUFrameTimer(void) { }
+    virtual bool platformGetGPUFrameTime(float& /*ms*/) { return false; }
+
+    /// Headless test mode (-headless <frames> <name>).
+    /// Called before the context issues any rendering calls; platforms that
+    /// can keep API calls away from the driver start doing so here and
+    /// return true; the others call #errorExit with the reason and return
+    /// false.  The GPU frame timer calls still bracket every frame
+    virtual bool platformBeginHeadless(void) {
+        errorExit("Headless mode is not supported by this build");
+        return false;
+    }
 
     void requestThreadedRendering(bool threaded);
     bool isRenderThreadRunning();
@@ -249,6 +287,7 @@ protected:
     int32_t m_desiredHeight;
     bool mTestMode;
     float mTestDuration;
+    int32_t mHeadlessFrames;
     int32_t mTestRepeatFrames;
     std::string mTestName;
     float mSumDrawTime;
@@ -258,8 +297,21 @@ protected:
     bool mHasInitializedRendering;
     NvStopWatch* mDrawTime;
 
+    nvidia::shdfnd::FrameArena* mFrameArena;
+    nvidia::shdfnd::JobSystem* mJobSystem;
+    uint64_t mTestModeArenaAllocations;
+    uint64_t mTestModeArenaOverflows;
+
     NvStopWatch* mTestModeTimer;
     int32_t mTestModeFrames;
+
+    // Per-frame test mode timings; the update time is accumulated on the
+    // main thread, so with threaded rendering it is attributed approximately
+    NvFrameStats* mFrameStats;
+    NvStopWatch* mTestModeFrameTimer;
+    NvStopWatch* mUpdateTimer;
+    float mTestModeUpdateTime;
+    float mTestModeDrawTime;
     float mTotalTime;
 
     bool mUseRenderThread;
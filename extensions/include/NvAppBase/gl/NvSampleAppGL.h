@@ -41,6 +41,9 @@
 #include "NvAppBase/NvSampleApp.h"
 #include "NvAppBase/gl/NvAppContextGL.h"
 
+class NvGPUTimer;
+class NvGLRecorder;
+
 /// \file
 /// GL-based Sample app base class.
 
@@ -111,7 +114,17 @@ protected:
 
     virtual void platformLogTestResults(float frameRate, int32_t frames);
 
+    virtual void platformShutdownRendering(void);
+
+    virtual void platformBeginGPUFrameTimer(void);
+    virtual void platformEndGPUFrameTimer(void);
+    virtual bool platformGetGPUFrameTime(float& ms);
+
+    virtual bool platformBeginHeadless(void);
+
 private:
+    NvGPUTimer* mGPUFrameTimer;
+    NvGLRecorder* mGLRecorder;
 };
 
 #endif
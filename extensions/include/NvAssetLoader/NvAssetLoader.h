@@ -106,6 +106,24 @@ bool NvAssetLoaderAddSearchPath(const char *path);
 /// on the list is considered success)
 bool NvAssetLoaderRemoveSearchPath(const char *path);
 
+/// Enables or disables the index of the assets trees.
+/// When enabled, every file below each "assets" directory that the search
+/// paths lead to is indexed once, so that opening an asset or testing
+/// whether it exists is a single lookup, with no probing of the file system.
+/// The index is dropped whenever the search paths change, and on Linux
+/// whenever a file or directory in the trees is created, deleted or renamed.
+/// Without the index, successfully resolved paths are still cached.  Only
+/// path-based platforms (Linux) are affected.
+/// \param[in] enable true to build the index on the next lookup, false to drop it
+/// \return true on success and false on failure
+bool NvAssetLoaderEnableIndex(bool enable);
+
+/// Forgets every cached asset path and the index of the assets trees.
+/// Call this after changing the working directory, or after adding or
+/// removing asset files on a platform that cannot watch for changes.
+/// \return true on success and false on failure
+bool NvAssetLoaderInvalidatePathCache();
+
 /// Reads an asset file as a block.
 /// Reads an asset file, returning a pointer to a block of memory
 /// that contains the entire file, along with the length.  The block
@@ -123,6 +141,26 @@ char *NvAssetLoaderRead(const char *filePath, int32_t &length);
 /// \return true on success and false on failure
 bool NvAssetLoaderFree(char* asset);
 
+/// Maps an asset file read-only into memory.
+/// Maps an asset file into the address space of the process where the
+/// platform supports it, so that the contents are paged in on demand and
+/// are not duplicated into a heap block.  The mapping base is at least
+/// page-aligned.  Platforms or files that cannot be mapped fall back to
+/// #NvAssetLoaderRead, so callers need not handle the two cases differently.
+/// Unlike #NvAssetLoaderRead, the block is NOT null-terminated and must be
+/// treated as read-only
+/// \param[in] filePath the partial path (below "assets") to the file
+/// \param[out] length the length of the file in bytes
+/// \return a pointer to the start of the file contents or NULL on error.
+/// This block must be released with a call to #NvAssetLoaderUnmap.  Do NOT
+/// pass it to #NvAssetLoaderFree, free or delete[]
+char *NvAssetLoaderMap(const char *filePath, int32_t &length);
+
+/// Releases a block returned from #NvAssetLoaderMap.
+/// \param[in] asset a pointer returned from #NvAssetLoaderMap
+/// \return true on success and false on failure
+bool NvAssetLoaderUnmap(char* asset);
+
 /// Returns a boolean indicating whether the desired file exists
 /// \param[in] filePath the partial path to the file to be tested
 /// \return true if file exists and is readable, false otherwise
@@ -180,6 +218,71 @@ int64_t NvAssetFileRead64(NvAssetFilePtr file, int32_t size, void* data);
 /// \return zero on success, non-zero otherwise
 int64_t NvAssetFileSeek64(NvAssetFilePtr fp, int64_t offset, NvAssetSeekBase whence);
 
+/// Opaque handle to an asynchronous read
+typedef struct NvAssetReadRequest* NvAssetReadHandle;
+
+/// Priority of an asynchronous read.  Queued reads of a higher priority are
+/// started before those of a lower one, and reads of the same priority are
+/// started in the order that they were issued
+enum NvAssetReadPriority {
+    NV_ASSET_READ_PRIORITY_LOW = 0,
+    NV_ASSET_READ_PRIORITY_NORMAL = 1,
+    NV_ASSET_READ_PRIORITY_HIGH = 2
+};
+
+/// Sets the limits of the asynchronous reader.
+/// The reads are performed by a small pool of I/O threads that is started by
+/// the first asynchronous read and stopped by #NvAssetLoaderShutdown.
+/// \param[in] threadCount the number of I/O threads, used the next time the
+/// pool is started (2 by default)
+/// \param[in] maxBytesInFlight the number of bytes that may be being read at
+/// once, plus prefetched data that has not yet been claimed (64MB by default).
+/// A file larger than this is still read, but on its own
+/// \return true on success and false on failure
+bool NvAssetLoaderSetAsyncReadLimits(int32_t threadCount, int32_t maxBytesInFlight);
+
+/// Starts reading an asset file in the background.
+/// If the file has been prefetched by #NvAssetLoaderPrefetch, the prefetched
+/// read is claimed instead of reading the file again.
+/// \param[in] filePath the partial path (below "assets") to the file
+/// \param[in] priority the priority of the read
+/// \return a handle to the read, which must be passed to either
+/// #NvAssetLoaderReadAsyncWait or #NvAssetLoaderReadAsyncCancel
+NvAssetReadHandle NvAssetLoaderReadAsync(const char* filePath,
+    NvAssetReadPriority priority = NV_ASSET_READ_PRIORITY_NORMAL);
+
+/// Returns whether an asynchronous read has finished, successfully or not
+/// \param[in] handle a handle returned by #NvAssetLoaderReadAsync
+/// \return true if #NvAssetLoaderReadAsyncWait will return without blocking
+bool NvAssetLoaderReadAsyncIsComplete(NvAssetReadHandle handle);
+
+/// Waits for an asynchronous read to finish and releases its handle
+/// \param[in] handle a handle returned by #NvAssetLoaderReadAsync
+/// \param[out] length the length of the file in bytes
+/// \return a pointer to a null-terminated block containing the contents of
+/// the file or NULL on error, exactly as #NvAssetLoaderRead returns.  The
+/// block should be freed with a call to #NvAssetLoaderFree
+char *NvAssetLoaderReadAsyncWait(NvAssetReadHandle handle, int32_t &length);
+
+/// Cancels an asynchronous read and releases its handle.  A read that has
+/// not started is dropped, and the data of one that has is discarded.
+/// \param[in] handle a handle returned by #NvAssetLoaderReadAsync
+void NvAssetLoaderReadAsyncCancel(NvAssetReadHandle handle);
+
+/// Starts reading a batch of asset files in the background, so that they
+/// are ready by the time that the application reads them.  Prefetched files
+/// are claimed by #NvAssetLoaderRead or #NvAssetLoaderReadAsync, which then
+/// return the data as soon as it has been read.  Prefetched files that are
+/// never claimed are held until #NvAssetLoaderShutdown.  Prefetching helps
+/// when the files come from slow storage; when they are already in the OS
+/// file cache, reading them on demand is faster.
+/// \param[in] filePaths the partial paths (below "assets") to the files
+/// \param[in] count the number of paths
+/// \param[in] priority the priority of the reads
+/// \return true on success and false on failure
+bool NvAssetLoaderPrefetch(const char* const* filePaths, int32_t count,
+    NvAssetReadPriority priority = NV_ASSET_READ_PRIORITY_LOW);
+
 /// Load the text in the given file and return it as an STL string
 /// \param[in] fileName the path and filename of the file to be opened
 /// \return A string containing the file text
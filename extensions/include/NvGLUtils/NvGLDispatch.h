@@ -0,0 +1,311 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvGLDispatch.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef NV_GL_DISPATCH_H
+#define NV_GL_DISPATCH_H
+
+#include "NV/NvPlatformGL.h"
+
+/// \file
+/// Pluggable GL dispatch table.
+///
+/// Code built with NV_GL_DISPATCH defined calls the GL entry points listed in
+/// NvGLDispatchFuncs.h through #g_nvGLDispatch instead of the loader, so that
+/// tools such as NvGLRecorder can intercept them.  Every module that should be
+/// observed (NvGLUtils, NvUI, NvAppBase and the sample itself) must be built
+/// with the define; entry points that are not in the list, and code built
+/// without the define, always call GL directly.  The table is only available
+/// with GLEW (Windows, Linux and Mac desktop builds).
+
+#if defined(__glew_h__) && !defined(USE_REGAL)
+#define NV_GL_DISPATCH_SUPPORTED 1
+#endif
+
+/// Entry points in the dispatch table.
+struct NvGLEntry {
+    enum Enum {
+#define NV_GL_DISPATCH_FUNC(ret, func, formals, actuals) ID_ ## func,
+#define NV_GL_DISPATCH_FUNC_RET(ret, func, formals, actuals) ID_ ## func,
+#include "NvGLUtils/NvGLDispatchFuncs.h"
+#undef NV_GL_DISPATCH_FUNC
+#undef NV_GL_DISPATCH_FUNC_RET
+        COUNT ///< Number of entry points
+    };
+};
+
+/// Whether the dispatch table exists in this build.
+/// \return true if GL calls made by code built with NV_GL_DISPATCH can be
+/// intercepted through #g_nvGLDispatch
+bool NvGLDispatchIsAvailable();
+
+/// Name of an entry point.
+/// \param[in] entry the entry point
+/// \return the GL function name, e.g. "glDrawElements"
+const char* NvGLDispatchGetEntryName(NvGLEntry::Enum entry);
+
+#ifdef NV_GL_DISPATCH_SUPPORTED
+
+/// One function pointer per entry point; glDrawElements is called through
+/// glDrawElementsProc, and so on.  The names are pasted so that loader macros
+/// for the GL names do not leak into the member names.
+struct NvGLDispatchTable {
+#define NV_GL_DISPATCH_FUNC(ret, func, formals, actuals) ret (*func ## Proc) formals;
+#define NV_GL_DISPATCH_FUNC_RET(ret, func, formals, actuals) ret (*func ## Proc) formals;
+#include "NvGLUtils/NvGLDispatchFuncs.h"
+#undef NV_GL_DISPATCH_FUNC
+#undef NV_GL_DISPATCH_FUNC_RET
+};
+
+/// The table that code built with NV_GL_DISPATCH calls through.  Starts out
+/// as a copy of NvGLDispatchGetDefault(); interceptors replace entries and
+/// must restore them when they are done.
+extern NvGLDispatchTable g_nvGLDispatch;
+
+/// Table that calls straight into GL.
+/// \return a table whose entries forward to the current GLEW entry points
+const NvGLDispatchTable& NvGLDispatchGetDefault();
+
+#if defined(NV_GL_DISPATCH) && !defined(NV_GL_DISPATCH_IMPL)
+#undef glActiveTexture
+#define glActiveTexture g_nvGLDispatch.glActiveTextureProc
+#undef glAttachShader
+#define glAttachShader g_nvGLDispatch.glAttachShaderProc
+#undef glBindAttribLocation
+#define glBindAttribLocation g_nvGLDispatch.glBindAttribLocationProc
+#undef glBindBuffer
+#define glBindBuffer g_nvGLDispatch.glBindBufferProc
+#undef glBindBufferBase
+#define glBindBufferBase g_nvGLDispatch.glBindBufferBaseProc
+#undef glBindBufferRange
+#define glBindBufferRange g_nvGLDispatch.glBindBufferRangeProc
+#undef glBindFramebuffer
+#define glBindFramebuffer g_nvGLDispatch.glBindFramebufferProc
+#undef glBindRenderbuffer
+#define glBindRenderbuffer g_nvGLDispatch.glBindRenderbufferProc
+#undef glBindSampler
+#define glBindSampler g_nvGLDispatch.glBindSamplerProc
+#undef glBindTexture
+#define glBindTexture g_nvGLDispatch.glBindTextureProc
+#undef glBindVertexArray
+#define glBindVertexArray g_nvGLDispatch.glBindVertexArrayProc
+#undef glBlendEquation
+#define glBlendEquation g_nvGLDispatch.glBlendEquationProc
+#undef glBlendFunc
+#define glBlendFunc g_nvGLDispatch.glBlendFuncProc
+#undef glBlendFuncSeparate
+#define glBlendFuncSeparate g_nvGLDispatch.glBlendFuncSeparateProc
+#undef glBufferData
+#define glBufferData g_nvGLDispatch.glBufferDataProc
+#undef glBufferSubData
+#define glBufferSubData g_nvGLDispatch.glBufferSubDataProc
+#undef glCheckFramebufferStatus
+#define glCheckFramebufferStatus g_nvGLDispatch.glCheckFramebufferStatusProc
+#undef glClear
+#define glClear g_nvGLDispatch.glClearProc
+#undef glClearBufferfv
+#define glClearBufferfv g_nvGLDispatch.glClearBufferfvProc
+#undef glClearColor
+#define glClearColor g_nvGLDispatch.glClearColorProc
+#undef glClearStencil
+#define glClearStencil g_nvGLDispatch.glClearStencilProc
+#undef glColorMask
+#define glColorMask g_nvGLDispatch.glColorMaskProc
+#undef glCompileShader
+#define glCompileShader g_nvGLDispatch.glCompileShaderProc
+#undef glCreateProgram
+#define glCreateProgram g_nvGLDispatch.glCreateProgramProc
+#undef glCreateShader
+#define glCreateShader g_nvGLDispatch.glCreateShaderProc
+#undef glCullFace
+#define glCullFace g_nvGLDispatch.glCullFaceProc
+#undef glDeleteBuffers
+#define glDeleteBuffers g_nvGLDispatch.glDeleteBuffersProc
+#undef glDeleteFramebuffers
+#define glDeleteFramebuffers g_nvGLDispatch.glDeleteFramebuffersProc
+#undef glDeleteProgram
+#define glDeleteProgram g_nvGLDispatch.glDeleteProgramProc
+#undef glDeleteRenderbuffers
+#define glDeleteRenderbuffers g_nvGLDispatch.glDeleteRenderbuffersProc
+#undef glDeleteShader
+#define glDeleteShader g_nvGLDispatch.glDeleteShaderProc
+#undef glDeleteTextures
+#define glDeleteTextures g_nvGLDispatch.glDeleteTexturesProc
+#undef glDeleteVertexArrays
+#define glDeleteVertexArrays g_nvGLDispatch.glDeleteVertexArraysProc
+#undef glDepthFunc
+#define glDepthFunc g_nvGLDispatch.glDepthFuncProc
+#undef glDepthMask
+#define glDepthMask g_nvGLDispatch.glDepthMaskProc
+#undef glDisable
+#define glDisable g_nvGLDispatch.glDisableProc
+#undef glDisableVertexAttribArray
+#define glDisableVertexAttribArray g_nvGLDispatch.glDisableVertexAttribArrayProc
+#undef glDrawArrays
+#define glDrawArrays g_nvGLDispatch.glDrawArraysProc
+#undef glDrawArraysInstanced
+#define glDrawArraysInstanced g_nvGLDispatch.glDrawArraysInstancedProc
+#undef glDrawBuffers
+#define glDrawBuffers g_nvGLDispatch.glDrawBuffersProc
+#undef glDrawElements
+#define glDrawElements g_nvGLDispatch.glDrawElementsProc
+#undef glDrawElementsInstanced
+#define glDrawElementsInstanced g_nvGLDispatch.glDrawElementsInstancedProc
+#undef glEnable
+#define glEnable g_nvGLDispatch.glEnableProc
+#undef glEnableVertexAttribArray
+#define glEnableVertexAttribArray g_nvGLDispatch.glEnableVertexAttribArrayProc
+#undef glFramebufferRenderbuffer
+#define glFramebufferRenderbuffer g_nvGLDispatch.glFramebufferRenderbufferProc
+#undef glFramebufferTexture2D
+#define glFramebufferTexture2D g_nvGLDispatch.glFramebufferTexture2DProc
+#undef glFrontFace
+#define glFrontFace g_nvGLDispatch.glFrontFaceProc
+#undef glGenBuffers
+#define glGenBuffers g_nvGLDispatch.glGenBuffersProc
+#undef glGenFramebuffers
+#define glGenFramebuffers g_nvGLDispatch.glGenFramebuffersProc
+#undef glGenRenderbuffers
+#define glGenRenderbuffers g_nvGLDispatch.glGenRenderbuffersProc
+#undef glGenTextures
+#define glGenTextures g_nvGLDispatch.glGenTexturesProc
+#undef glGenVertexArrays
+#define glGenVertexArrays g_nvGLDispatch.glGenVertexArraysProc
+#undef glGenerateMipmap
+#define glGenerateMipmap g_nvGLDispatch.glGenerateMipmapProc
+#undef glGetActiveUniform
+#define glGetActiveUniform g_nvGLDispatch.glGetActiveUniformProc
+#undef glGetAttribLocation
+#define glGetAttribLocation g_nvGLDispatch.glGetAttribLocationProc
+#undef glGetError
+#define glGetError g_nvGLDispatch.glGetErrorProc
+#undef glGetIntegerv
+#define glGetIntegerv g_nvGLDispatch.glGetIntegervProc
+#undef glGetProgramInfoLog
+#define glGetProgramInfoLog g_nvGLDispatch.glGetProgramInfoLogProc
+#undef glGetProgramiv
+#define glGetProgramiv g_nvGLDispatch.glGetProgramivProc
+#undef glGetShaderInfoLog
+#define glGetShaderInfoLog g_nvGLDispatch.glGetShaderInfoLogProc
+#undef glGetShaderiv
+#define glGetShaderiv g_nvGLDispatch.glGetShaderivProc
+#undef glGetString
+#define glGetString g_nvGLDispatch.glGetStringProc
+#undef glGetUniformLocation
+#define glGetUniformLocation g_nvGLDispatch.glGetUniformLocationProc
+#undef glLineWidth
+#define glLineWidth g_nvGLDispatch.glLineWidthProc
+#undef glLinkProgram
+#define glLinkProgram g_nvGLDispatch.glLinkProgramProc
+#undef glMapBuffer
+#define glMapBuffer g_nvGLDispatch.glMapBufferProc
+#undef glMapBufferRange
+#define glMapBufferRange g_nvGLDispatch.glMapBufferRangeProc
+#undef glPixelStorei
+#define glPixelStorei g_nvGLDispatch.glPixelStoreiProc
+#undef glPolygonOffset
+#define glPolygonOffset g_nvGLDispatch.glPolygonOffsetProc
+#undef glRenderbufferStorage
+#define glRenderbufferStorage g_nvGLDispatch.glRenderbufferStorageProc
+#undef glScissor
+#define glScissor g_nvGLDispatch.glScissorProc
+#undef glShaderSource
+#define glShaderSource g_nvGLDispatch.glShaderSourceProc
+#undef glStencilFunc
+#define glStencilFunc g_nvGLDispatch.glStencilFuncProc
+#undef glStencilMask
+#define glStencilMask g_nvGLDispatch.glStencilMaskProc
+#undef glStencilOp
+#define glStencilOp g_nvGLDispatch.glStencilOpProc
+#undef glTexImage2D
+#define glTexImage2D g_nvGLDispatch.glTexImage2DProc
+#undef glTexParameterf
+#define glTexParameterf g_nvGLDispatch.glTexParameterfProc
+#undef glTexParameteri
+#define glTexParameteri g_nvGLDispatch.glTexParameteriProc
+#undef glTexStorage2D
+#define glTexStorage2D g_nvGLDispatch.glTexStorage2DProc
+#undef glTexSubImage2D
+#define glTexSubImage2D g_nvGLDispatch.glTexSubImage2DProc
+#undef glUniform1f
+#define glUniform1f g_nvGLDispatch.glUniform1fProc
+#undef glUniform1fv
+#define glUniform1fv g_nvGLDispatch.glUniform1fvProc
+#undef glUniform1i
+#define glUniform1i g_nvGLDispatch.glUniform1iProc
+#undef glUniform1iv
+#define glUniform1iv g_nvGLDispatch.glUniform1ivProc
+#undef glUniform2f
+#define glUniform2f g_nvGLDispatch.glUniform2fProc
+#undef glUniform2fv
+#define glUniform2fv g_nvGLDispatch.glUniform2fvProc
+#undef glUniform2i
+#define glUniform2i g_nvGLDispatch.glUniform2iProc
+#undef glUniform2iv
+#define glUniform2iv g_nvGLDispatch.glUniform2ivProc
+#undef glUniform3f
+#define glUniform3f g_nvGLDispatch.glUniform3fProc
+#undef glUniform3fv
+#define glUniform3fv g_nvGLDispatch.glUniform3fvProc
+#undef glUniform3i
+#define glUniform3i g_nvGLDispatch.glUniform3iProc
+#undef glUniform3iv
+#define glUniform3iv g_nvGLDispatch.glUniform3ivProc
+#undef glUniform4f
+#define glUniform4f g_nvGLDispatch.glUniform4fProc
+#undef glUniform4fv
+#define glUniform4fv g_nvGLDispatch.glUniform4fvProc
+#undef glUniform4i
+#define glUniform4i g_nvGLDispatch.glUniform4iProc
+#undef glUniform4iv
+#define glUniform4iv g_nvGLDispatch.glUniform4ivProc
+#undef glUniformMatrix2fv
+#define glUniformMatrix2fv g_nvGLDispatch.glUniformMatrix2fvProc
+#undef glUniformMatrix3fv
+#define glUniformMatrix3fv g_nvGLDispatch.glUniformMatrix3fvProc
+#undef glUniformMatrix4fv
+#define glUniformMatrix4fv g_nvGLDispatch.glUniformMatrix4fvProc
+#undef glUnmapBuffer
+#define glUnmapBuffer g_nvGLDispatch.glUnmapBufferProc
+#undef glUseProgram
+#define glUseProgram g_nvGLDispatch.glUseProgramProc
+#undef glVertexAttribDivisor
+#define glVertexAttribDivisor g_nvGLDispatch.glVertexAttribDivisorProc
+#undef glVertexAttribPointer
+#define glVertexAttribPointer g_nvGLDispatch.glVertexAttribPointerProc
+#undef glViewport
+#define glViewport g_nvGLDispatch.glViewportProc
+#endif
+
+#endif // NV_GL_DISPATCH_SUPPORTED
+
+#endif
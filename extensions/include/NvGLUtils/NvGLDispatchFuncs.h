@@ -0,0 +1,142 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvGLDispatchFuncs.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+// GL entry points routed through NvGLDispatchTable when NV_GL_DISPATCH is defined.
+// NV_GL_DISPATCH_FUNC(ret, func, formals, actuals) is defined by the includer;
+// entry points that return a value use NV_GL_DISPATCH_FUNC_RET.  Signatures
+// follow GLEW, which is the only loader the dispatch layer supports.
+NV_GL_DISPATCH_FUNC(void, glActiveTexture, (GLenum texture), (texture))
+NV_GL_DISPATCH_FUNC(void, glAttachShader, (GLuint program, GLuint shader), (program, shader))
+NV_GL_DISPATCH_FUNC(void, glBindAttribLocation, (GLuint program, GLuint index, const GLchar* name), (program, index, name))
+NV_GL_DISPATCH_FUNC(void, glBindBuffer, (GLenum target, GLuint buffer), (target, buffer))
+NV_GL_DISPATCH_FUNC(void, glBindBufferBase, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer))
+NV_GL_DISPATCH_FUNC(void, glBindBufferRange, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size), (target, index, buffer, offset, size))
+NV_GL_DISPATCH_FUNC(void, glBindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer))
+NV_GL_DISPATCH_FUNC(void, glBindRenderbuffer, (GLenum target, GLuint renderbuffer), (target, renderbuffer))
+NV_GL_DISPATCH_FUNC(void, glBindSampler, (GLuint unit, GLuint sampler), (unit, sampler))
+NV_GL_DISPATCH_FUNC(void, glBindTexture, (GLenum target, GLuint texture), (target, texture))
+NV_GL_DISPATCH_FUNC(void, glBindVertexArray, (GLuint array), (array))
+NV_GL_DISPATCH_FUNC(void, glBlendEquation, (GLenum mode), (mode))
+NV_GL_DISPATCH_FUNC(void, glBlendFunc, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor))
+NV_GL_DISPATCH_FUNC(void, glBlendFuncSeparate, (GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfactorAlpha, GLenum dfactorAlpha), (sfactorRGB, dfactorRGB, sfactorAlpha, dfactorAlpha))
+NV_GL_DISPATCH_FUNC(void, glBufferData, (GLenum target, GLsizeiptr size, const void* data, GLenum usage), (target, size, data, usage))
+NV_GL_DISPATCH_FUNC(void, glBufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void* data), (target, offset, size, data))
+NV_GL_DISPATCH_FUNC_RET(GLenum, glCheckFramebufferStatus, (GLenum target), (target))
+NV_GL_DISPATCH_FUNC(void, glClear, (GLbitfield mask), (mask))
+NV_GL_DISPATCH_FUNC(void, glClearBufferfv, (GLenum buffer, GLint drawBuffer, const GLfloat* value), (buffer, drawBuffer, value))
+NV_GL_DISPATCH_FUNC(void, glClearColor, (GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha), (red, green, blue, alpha))
+NV_GL_DISPATCH_FUNC(void, glClearStencil, (GLint s), (s))
+NV_GL_DISPATCH_FUNC(void, glColorMask, (GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha), (red, green, blue, alpha))
+NV_GL_DISPATCH_FUNC(void, glCompileShader, (GLuint shader), (shader))
+NV_GL_DISPATCH_FUNC_RET(GLuint, glCreateProgram, (void), ())
+NV_GL_DISPATCH_FUNC_RET(GLuint, glCreateShader, (GLenum type), (type))
+NV_GL_DISPATCH_FUNC(void, glCullFace, (GLenum mode), (mode))
+NV_GL_DISPATCH_FUNC(void, glDeleteBuffers, (GLsizei n, const GLuint* buffers), (n, buffers))
+NV_GL_DISPATCH_FUNC(void, glDeleteFramebuffers, (GLsizei n, const GLuint* framebuffers), (n, framebuffers))
+NV_GL_DISPATCH_FUNC(void, glDeleteProgram, (GLuint program), (program))
+NV_GL_DISPATCH_FUNC(void, glDeleteRenderbuffers, (GLsizei n, const GLuint* renderbuffers), (n, renderbuffers))
+NV_GL_DISPATCH_FUNC(void, glDeleteShader, (GLuint shader), (shader))
+NV_GL_DISPATCH_FUNC(void, glDeleteTextures, (GLsizei n, const GLuint* textures), (n, textures))
+NV_GL_DISPATCH_FUNC(void, glDeleteVertexArrays, (GLsizei n, const GLuint* arrays), (n, arrays))
+NV_GL_DISPATCH_FUNC(void, glDepthFunc, (GLenum func), (func))
+NV_GL_DISPATCH_FUNC(void, glDepthMask, (GLboolean flag), (flag))
+NV_GL_DISPATCH_FUNC(void, glDisable, (GLenum cap), (cap))
+NV_GL_DISPATCH_FUNC(void, glDisableVertexAttribArray, (GLuint index), (index))
+NV_GL_DISPATCH_FUNC(void, glDrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count))
+NV_GL_DISPATCH_FUNC(void, glDrawArraysInstanced, (GLenum mode, GLint first, GLsizei count, GLsizei primcount), (mode, first, count, primcount))
+NV_GL_DISPATCH_FUNC(void, glDrawBuffers, (GLsizei n, const GLenum* bufs), (n, bufs))
+NV_GL_DISPATCH_FUNC(void, glDrawElements, (GLenum mode, GLsizei count, GLenum type, const void* indices), (mode, count, type, indices))
+NV_GL_DISPATCH_FUNC(void, glDrawElementsInstanced, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei primcount), (mode, count, type, indices, primcount))
+NV_GL_DISPATCH_FUNC(void, glEnable, (GLenum cap), (cap))
+NV_GL_DISPATCH_FUNC(void, glEnableVertexAttribArray, (GLuint index), (index))
+NV_GL_DISPATCH_FUNC(void, glFramebufferRenderbuffer, (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer), (target, attachment, renderbuffertarget, renderbuffer))
+NV_GL_DISPATCH_FUNC(void, glFramebufferTexture2D, (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level), (target, attachment, textarget, texture, level))
+NV_GL_DISPATCH_FUNC(void, glFrontFace, (GLenum mode), (mode))
+NV_GL_DISPATCH_FUNC(void, glGenBuffers, (GLsizei n, GLuint* buffers), (n, buffers))
+NV_GL_DISPATCH_FUNC(void, glGenFramebuffers, (GLsizei n, GLuint* framebuffers), (n, framebuffers))
+NV_GL_DISPATCH_FUNC(void, glGenRenderbuffers, (GLsizei n, GLuint* renderbuffers), (n, renderbuffers))
+NV_GL_DISPATCH_FUNC(void, glGenTextures, (GLsizei n, GLuint* textures), (n, textures))
+NV_GL_DISPATCH_FUNC(void, glGenVertexArrays, (GLsizei n, GLuint* arrays), (n, arrays))
+NV_GL_DISPATCH_FUNC(void, glGenerateMipmap, (GLenum target), (target))
+NV_GL_DISPATCH_FUNC(void, glGetActiveUniform, (GLuint program, GLuint index, GLsizei maxLength, GLsizei* length, GLint* size, GLenum* type, GLchar* name), (program, index, maxLength, length, size, type, name))
+NV_GL_DISPATCH_FUNC_RET(GLint, glGetAttribLocation, (GLuint program, const GLchar* name), (program, name))
+NV_GL_DISPATCH_FUNC_RET(GLenum, glGetError, (void), ())
+NV_GL_DISPATCH_FUNC(void, glGetIntegerv, (GLenum pname, GLint* params), (pname, params))
+NV_GL_DISPATCH_FUNC(void, glGetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog), (program, bufSize, length, infoLog))
+NV_GL_DISPATCH_FUNC(void, glGetProgramiv, (GLuint program, GLenum pname, GLint* param), (program, pname, param))
+NV_GL_DISPATCH_FUNC(void, glGetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog), (shader, bufSize, length, infoLog))
+NV_GL_DISPATCH_FUNC(void, glGetShaderiv, (GLuint shader, GLenum pname, GLint* param), (shader, pname, param))
+NV_GL_DISPATCH_FUNC_RET(const GLubyte*, glGetString, (GLenum name), (name))
+NV_GL_DISPATCH_FUNC_RET(GLint, glGetUniformLocation, (GLuint program, const GLchar* name), (program, name))
+NV_GL_DISPATCH_FUNC(void, glLineWidth, (GLfloat width), (width))
+NV_GL_DISPATCH_FUNC(void, glLinkProgram, (GLuint program), (program))
+NV_GL_DISPATCH_FUNC_RET(void*, glMapBuffer, (GLenum target, GLenum access), (target, access))
+NV_GL_DISPATCH_FUNC_RET(void*, glMapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access), (target, offset, length, access))
+NV_GL_DISPATCH_FUNC(void, glPixelStorei, (GLenum pname, GLint param), (pname, param))
+NV_GL_DISPATCH_FUNC(void, glPolygonOffset, (GLfloat factor, GLfloat units), (factor, units))
+NV_GL_DISPATCH_FUNC(void, glRenderbufferStorage, (GLenum target, GLenum internalformat, GLsizei width, GLsizei height), (target, internalformat, width, height))
+NV_GL_DISPATCH_FUNC(void, glScissor, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height))
+NV_GL_DISPATCH_FUNC(void, glShaderSource, (GLuint shader, GLsizei count, const GLchar** strings, const GLint* lengths), (shader, count, strings, lengths))
+NV_GL_DISPATCH_FUNC(void, glStencilFunc, (GLenum func, GLint ref, GLuint mask), (func, ref, mask))
+NV_GL_DISPATCH_FUNC(void, glStencilMask, (GLuint mask), (mask))
+NV_GL_DISPATCH_FUNC(void, glStencilOp, (GLenum fail, GLenum zfail, GLenum zpass), (fail, zfail, zpass))
+NV_GL_DISPATCH_FUNC(void, glTexImage2D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels), (target, level, internalformat, width, height, border, format, type, pixels))
+NV_GL_DISPATCH_FUNC(void, glTexParameterf, (GLenum target, GLenum pname, GLfloat param), (target, pname, param))
+NV_GL_DISPATCH_FUNC(void, glTexParameteri, (GLenum target, GLenum pname, GLint param), (target, pname, param))
+NV_GL_DISPATCH_FUNC(void, glTexStorage2D, (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height), (target, levels, internalformat, width, height))
+NV_GL_DISPATCH_FUNC(void, glTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels), (target, level, xoffset, yoffset, width, height, format, type, pixels))
+NV_GL_DISPATCH_FUNC(void, glUniform1f, (GLint location, GLfloat v0), (location, v0))
+NV_GL_DISPATCH_FUNC(void, glUniform1fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value))
+NV_GL_DISPATCH_FUNC(void, glUniform1i, (GLint location, GLint v0), (location, v0))
+NV_GL_DISPATCH_FUNC(void, glUniform1iv, (GLint location, GLsizei count, const GLint* value), (location, count, value))
+NV_GL_DISPATCH_FUNC(void, glUniform2f, (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1))
+NV_GL_DISPATCH_FUNC(void, glUniform2fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value))
+NV_GL_DISPATCH_FUNC(void, glUniform2i, (GLint location, GLint v0, GLint v1), (location, v0, v1))
+NV_GL_DISPATCH_FUNC(void, glUniform2iv, (GLint location, GLsizei count, const GLint* value), (location, count, value))
+NV_GL_DISPATCH_FUNC(void, glUniform3f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2), (location, v0, v1, v2))
+NV_GL_DISPATCH_FUNC(void, glUniform3fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value))
+NV_GL_DISPATCH_FUNC(void, glUniform3i, (GLint location, GLint v0, GLint v1, GLint v2), (location, v0, v1, v2))
+NV_GL_DISPATCH_FUNC(void, glUniform3iv, (GLint location, GLsizei count, const GLint* value), (location, count, value))
+NV_GL_DISPATCH_FUNC(void, glUniform4f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (location, v0, v1, v2, v3))
+NV_GL_DISPATCH_FUNC(void, glUniform4fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value))
+NV_GL_DISPATCH_FUNC(void, glUniform4i, (GLint location, GLint v0, GLint v1, GLint v2, GLint v3), (location, v0, v1, v2, v3))
+NV_GL_DISPATCH_FUNC(void, glUniform4iv, (GLint location, GLsizei count, const GLint* value), (location, count, value))
+NV_GL_DISPATCH_FUNC(void, glUniformMatrix2fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value))
+NV_GL_DISPATCH_FUNC(void, glUniformMatrix3fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value))
+NV_GL_DISPATCH_FUNC(void, glUniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value))
+NV_GL_DISPATCH_FUNC_RET(GLboolean, glUnmapBuffer, (GLenum target), (target))
+NV_GL_DISPATCH_FUNC(void, glUseProgram, (GLuint program), (program))
+NV_GL_DISPATCH_FUNC(void, glVertexAttribDivisor, (GLuint index, GLuint divisor), (index, divisor))
+NV_GL_DISPATCH_FUNC(void, glVertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer), (index, size, type, normalized, stride, pointer))
+NV_GL_DISPATCH_FUNC(void, glViewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height))
@@ -0,0 +1,242 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvGLRecorder.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef NV_GL_RECORDER_H
+#define NV_GL_RECORDER_H
+
+#include "NvGLUtils/NvGLDispatch.h"
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// \file
+/// GL call recording for CPU-side render path benchmarks.  Like the dispatch
+/// table, only available where NV_GL_DISPATCH_SUPPORTED is defined.
+
+#ifdef NV_GL_DISPATCH_SUPPORTED
+
+/// A recorded sequence of GL calls.
+/// Array arguments that GL reads (buffer and texture data, uniform arrays,
+/// shader sources, names) are copied into the trace, so it can be replayed
+/// after the application has freed them.  Offsets into bound buffers are
+/// kept as they were; object names are not remapped, so a trace replays
+/// correctly against the state it was recorded against (typically the same
+/// frame in the same run).
+class NvGLTrace
+{
+public:
+    NvGLTrace();
+
+    /// Removes all recorded calls.
+    void clear();
+
+    /// Number of recorded calls.
+    /// \return the number of calls in the trace
+    uint32_t getCallCount() const { return (uint32_t)mCalls.size(); }
+
+    /// Whether the trace uses client-side vertex arrays, whose contents are
+    /// not captured; such traces can only be replayed into a headless recorder.
+    /// \return true if any glVertexAttribPointer call had no array buffer bound
+    bool usesClientArrays() const { return mClientArrays; }
+
+    /// Issues every call in the trace through #g_nvGLDispatch, so a replay is
+    /// itself recorded if an NvGLRecorder is installed.
+    /// \return false if the trace cannot be replayed into the current table
+    bool replay() const;
+
+protected:
+    friend class NvGLRecorder;
+
+    enum { MAX_ARGS = 9 };
+
+    struct Call {
+        uint16_t mEntry;
+        int8_t mPayloadArg;      ///< argument replaced by the payload, or -1
+        uint8_t mArgCount;
+        uint32_t mPointerMask;   ///< arguments that point at client memory
+        uint32_t mPayloadOffset;
+        uint32_t mPayloadSize;
+        uint64_t mArgs[MAX_ARGS];
+    };
+
+    std::vector<Call> mCalls;
+    std::vector<uint8_t> mPayload;
+    bool mClientArrays;
+};
+
+/// Counts, and optionally swallows, the GL calls made through #g_nvGLDispatch.
+/// While installed, every call is counted per entry point and per frame, the
+/// bytes uploaded to buffers, textures and uniforms are summed, and state
+/// changes that set the value already in place (rebinding the bound program,
+/// re-enabling an enabled cap, re-uploading an unchanged uniform, ...) are
+/// counted as redundant.  In passthrough mode the calls then go on to the
+/// driver; in headless mode they do not, and the recorder returns plausible
+/// results itself (fresh object names, complete framebuffers, successful
+/// compiles and links, stable uniform locations), so a sample's CPU render
+/// path can be timed without the GPU or the driver in the loop.
+///
+/// Only one recorder can be installed at a time.
+class NvGLRecorder
+{
+public:
+    /// What happens to recorded calls
+    enum Mode {
+        MODE_PASSTHROUGH = 0, ///< Calls are forwarded to the previous table
+        MODE_HEADLESS         ///< Calls are dropped and results are faked
+    };
+
+    /// Per-frame call statistics between beginFrame() and endFrame()
+    struct FrameSummary {
+        uint32_t mFrames;
+        float mCallsMean;
+        uint64_t mCallsMin;
+        uint64_t mCallsMax;
+        float mDrawsMean;
+        float mUploadBytesMean;
+        float mRedundantMean;
+    };
+
+    NvGLRecorder();
+    ~NvGLRecorder();
+
+    /// Routes #g_nvGLDispatch through the recorder.
+    /// \param[in] mode whether calls reach the driver
+    /// \return false if the dispatch table is not available or another
+    /// recorder is installed
+    bool install(Mode mode);
+
+    /// Restores the table that was in place when install() was called.
+    void uninstall();
+
+    bool isInstalled() const;
+    Mode getMode() const { return mMode; }
+
+    /// Clears the counters and frame statistics.  Tracked GL state, and in
+    /// headless mode the names handed out so far, are kept.
+    void reset();
+
+    /// Marks the start of a frame.
+    void beginFrame();
+
+    /// Marks the end of a frame and adds its counts to the frame statistics.
+    void endFrame();
+
+    /// Appends every subsequent call to a trace.
+    /// \param[in] trace the trace to append to, or NULL to stop tracing
+    void setTrace(NvGLTrace* trace) { mTrace = trace; }
+
+    /// The trace calls are appended to, if any.
+    NvGLTrace* getTrace() const { return mTrace; }
+
+    /// Total calls since install() or reset().
+    uint64_t getCallCount() const { return mCallCount; }
+
+    /// Calls to one entry point since install() or reset().
+    uint64_t getCallCount(NvGLEntry::Enum entry) const { return mEntryCounts[entry]; }
+
+    /// Draw calls since install() or reset().
+    uint64_t getDrawCount() const { return mDrawCount; }
+
+    /// Bytes passed to buffer and texture uploads and written through
+    /// write-mapped buffers.
+    uint64_t getUploadBytes() const { return mUploadBytes; }
+
+    /// Bytes passed to glUniform* calls.
+    uint64_t getUniformBytes() const { return mUniformBytes; }
+
+    /// State changes that set the value already in place.
+    uint64_t getRedundantStateChanges() const { return mRedundantCount; }
+
+    /// Statistics of the frames recorded between beginFrame() and endFrame().
+    void getFrameSummary(FrameSummary& summary) const;
+
+    /// Formats the counters as text, one line per item.
+    /// \param[out] out receives the report
+    /// \param[in] topEntries number of entry points to list, busiest first
+    void writeReport(std::string& out, uint32_t topEntries = 16) const;
+
+    /// Formats the per-entry counts as CSV with columns entry, calls, per_frame.
+    /// \param[out] out receives the CSV text
+    void writeEntryCSV(std::string& out) const;
+
+    /// \privatesection
+    // Called by the recording table for every call; returns true if the call
+    // should be forwarded and otherwise sets result
+    bool record(NvGLEntry::Enum entry, const uint64_t* args, uint32_t argCount,
+        uint32_t pointerMask, uint64_t& result);
+
+protected:
+    bool trackState(uint64_t key, uint64_t value);
+    uint32_t boundObject(NvGLEntry::Enum entry, uint32_t a, uint32_t b) const;
+    void fakeResult(NvGLEntry::Enum entry, const uint64_t* args, uint64_t& result);
+    void traceCall(NvGLEntry::Enum entry, const uint64_t* args, uint32_t argCount,
+        uint32_t pointerMask);
+
+    Mode mMode;
+    NvGLTrace* mTrace;
+
+    uint64_t mEntryCounts[NvGLEntry::COUNT];
+    uint64_t mCallCount;
+    uint64_t mDrawCount;
+    uint64_t mUploadBytes;
+    uint64_t mUniformBytes;
+    uint64_t mRedundantCount;
+
+    // Frame statistics
+    bool mInFrame;
+    uint32_t mFrames;
+    uint64_t mFrameStart[4];
+    uint64_t mFrameSums[4];
+    uint64_t mFrameCallsMin;
+    uint64_t mFrameCallsMax;
+
+    // Current value of each tracked piece of state, keyed by entry point
+    // and target/unit/cap
+    std::unordered_map<uint64_t, uint64_t> mState;
+    uint32_t mProgram;
+    uint32_t mActiveTexture;
+    uint32_t mVertexArray;
+
+    // Headless results
+    uint32_t mNextName;
+    std::map<uint32_t, uint64_t> mBufferSizes;
+    std::map<std::pair<uint32_t, std::string>, int32_t> mLocations;
+    std::map<uint32_t, int32_t> mNextLocation;
+    std::vector<uint8_t> mMapScratch;
+    int32_t mViewport[4];
+};
+
+#endif
+
+#endif
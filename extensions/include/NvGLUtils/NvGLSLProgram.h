@@ -37,6 +37,8 @@
 
 #include <NvSimpleTypes.h>
 #include "NV/NvPlatformGL.h"
+#include <string>
+#include <vector>
 
 /// \file
 /// GLSL shader program wrapper
@@ -331,6 +333,36 @@ public:
     /// \param[in] transpose if true, the matrices are transposed on input
     void setUniformMatrix4fv(GLint index, GLfloat *m, int32_t count=1, bool transpose=false);
 
+    ///@{
+    /// Stage program uniforms by index.
+    /// Records the value in the program's staging block; the next #flushUniforms
+    /// uploads it, unless it equals the value this program last uploaded.  Use
+    /// this for uniforms that are set before every draw but rarely change.
+    /// Locations that were not reflected at link time, or whose type does not
+    /// match the call, are set immediately instead.  The value is copied, so the
+    /// arrays need not outlive the call
+    /// \param[in] index the index of the uniform
+    /// \param[in] value array of values
+    /// \param[in] count number of values in array unform
+    void stageUniform1i(GLint index, int32_t value);
+    void stageUniform1f(GLint index, float value);
+    void stageUniform2f(GLint index, float x, float y);
+    void stageUniform3f(GLint index, float x, float y, float z);
+    void stageUniform4f(GLint index, float x, float y, float z, float w);
+    void stageUniform2fv(GLint index, const float *value, int32_t count=1);
+    void stageUniform3fv(GLint index, const float *value, int32_t count=1);
+    void stageUniform4fv(GLint index, const float *value, int32_t count=1);
+    void stageUniformMatrix4fv(GLint index, const GLfloat *m, int32_t count=1);
+    ///@}
+
+    /// Uploads the staged uniforms whose values changed.
+    /// Call once before each draw that uses staged uniforms.
+    /// Assumes that the given shader is bound via #enable.  Setting a uniform
+    /// through the setUniform* functions above drops any value staged for it;
+    /// raw glUniform* calls bypass the staging block entirely, so do not mix
+    /// them with staging on the same uniform
+    void flushUniforms();
+
     /// Returns the index containing the named vertex attribute
     /// \param[in] uniform the null-terminated string name of the attribute
     /// \param[in] isOptional if true, the function logs an error if the attribute is not found
@@ -338,6 +370,9 @@ public:
     GLint getAttribLocation(const char* attribute, bool isOptional = false);
 
     /// Returns the index containing the named uniform
+    /// Active uniforms are reflected into a hashed table when the program is
+    /// linked, so this normally does not call into GL; other names (such as
+    /// individual array elements) are queried once and then cached
     /// \param[in] uniform the null-terminated string name of the uniform
     /// \param[in] isOptional if true, the function logs an error if the uniform is not found
     /// \return the non-negative index of the uniform if found.  -1 if not found
@@ -362,9 +397,39 @@ protected:
         const char** fragSrcArray, int32_t fragSrcCount);
     GLuint compileProgram(ShaderSourceItem* src, int32_t count);
 
+    void reflectUniforms();
+    int32_t findUniformName(const char* name, uint32_t hash) const;
+    void addUniformName(const std::string& name, uint32_t hash, GLint location);
+    bool stageUniform(GLint index, const void* value, int32_t count, GLenum type);
+    void dropStagedUniform(GLint index);
+
+    struct UniformName {
+        std::string mName;
+        uint32_t mHash;
+        GLint mLocation;
+    };
+
+    struct StagedUniform {
+        GLint mLocation;
+        GLenum mType;
+        int32_t mArraySize;
+        uint32_t mWords;      // 32-bit words per element
+        uint32_t mOffset;     // first word in m_stagedValues
+        int32_t mKnownCount;  // leading elements known to match the program
+        int32_t mDirtyCount;  // elements to upload at the next flush, 0 if clean
+        bool mIsFloat;
+    };
+
     bool m_strict;
     GLuint m_program;
 
+    std::vector<UniformName> m_uniformNames;
+    std::vector<int32_t> m_uniformNameSlots;  // open-addressed hash of m_uniformNames
+    std::vector<StagedUniform> m_stagedUniforms;
+    std::vector<int32_t> m_locationToStaged;
+    std::vector<uint32_t> m_stagedValues;
+    std::vector<int32_t> m_dirtyUniforms;
+
     static bool ms_logAllMissing;
     static const char* ms_shaderHeader;
 };
@@ -66,6 +66,14 @@ public:
 	/// \return a pointer to the new model
 	static NvModelGL* CreateFromPreprocessed(uint8_t* data);
 
+	/// Create a renderable model from a preprocessed "NVM" asset file.
+	/// The file is memory-mapped and the model references the mapping in
+	/// place rather than reading and copying it, so the data is held in
+	/// client memory only once; the mapping is released with the model
+	/// \param[in] filename the partial path (below "assets") to the NVM file
+	/// \return a pointer to the new model
+	static NvModelGL* CreateFromPreprocessedFile(const char* filename);
+
 	/// Create a renderable model from an unoptimized NvModel object
 	/// \param[in] model the unoptimized model to be converted
 	/// \return a pointer to the new model
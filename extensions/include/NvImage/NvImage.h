@@ -38,6 +38,14 @@
 #include <NvSimpleTypes.h>
 #include <vector>
 
+namespace nvidia
+{
+namespace shdfnd
+{
+    class JobSystem;
+}
+}
+
 // These enums DO and MUST match the Khronos/GL enum values, so that GL runs well
 // Other APIs will map a subset for now
 #define    NVIMAGE_BYTE    0x1400
@@ -279,6 +287,18 @@ public:
     /// \return a pointer to the NvImage representing the file or null on failure
     static NvImage* CreateFromDDSFile(const char* filename);
 
+    /// Create a new NvImage (no texture) that streams its levels from a DDS file.
+    /// Only the header is read up front, along with the smallest mipmap levels
+    /// requested; more detailed levels are read with #streamLevel when needed,
+    /// and can be released again with #evictLevel.  The file stays open until the
+    /// image is deleted.  Levels that are not resident return NULL from #getLevel
+    /// and #getLayerLevel, and streamed images have no #getDataBlock.
+    /// Uses #NvAssetLoaderOpenFile for opening the file.
+    /// \param[in] filename the image filename (and path) to load
+    /// \param[in] residentLevels the number of the smallest mipmap levels to read immediately
+    /// \return a pointer to the NvImage representing the file or null on failure
+    static NvImage* CreateStreamingFromDDSFile(const char* filename, int32_t residentLevels = 1);
+
     NvImage();
     virtual ~NvImage();
 
@@ -408,6 +428,44 @@ public:
 	uint32_t getLayerLevelOffset(int32_t level, int32_t slice) const;
 	///@}
 
+    /// Whether or not the image streams its levels from a file
+    /// \return true if the image was created by #CreateStreamingFromDDSFile
+    bool isStreaming() const { return _stream != NULL; }
+
+    /// Get the location of a level of a layer within a streamed file.
+    /// \param[in] level the mipmap level [0, #getMipLevels)
+    /// \param[in] layer the layer or cubemap face index [0, #getLayers)
+    /// \param[out] offset the offset of the level's data from the start of the file
+    /// \param[out] size the size of the level's data in the file, which differs from the
+    /// size in memory if the level is expanded when it is read
+    /// \return true on success, false if the image is not streaming or the level is out of range
+    bool getLevelFileRange(int32_t level, int32_t layer, int32_t& offset, int32_t& size) const;
+
+    /// Whether or not a mipmap level is in memory.
+    /// Every level of an image that is not streaming is resident.
+    /// \param[in] level the mipmap level [0, #getMipLevels)
+    /// \return true if the level's data for every layer can be retrieved with #getLayerLevel
+    bool isLevelResident(int32_t level) const;
+
+    /// The most detailed mipmap level below which every level is resident.
+    /// \return the first level of the resident mip chain, or #getMipLevels if the
+    /// smallest level is not resident
+    int32_t getFirstResidentLevel() const;
+
+    /// Reads a mipmap level of every layer from a streamed file, flipping, swapping and
+    /// expanding it as #CreateFromDDSFile would.  Does nothing if the level is resident.
+    /// \param[in] level the mipmap level [0, #getMipLevels)
+    /// \return true if the level is resident
+    bool streamLevel(int32_t level);
+
+    /// Releases the memory of a streamed mipmap level.  It can be read again with #streamLevel.
+    /// \param[in] level the mipmap level [0, #getMipLevels)
+    void evictLevel(int32_t level);
+
+    /// The memory held by the resident levels of the image
+    /// \return the size in bytes of all resident levels and layers
+    int32_t getResidentSize() const;
+
     /// Loads an image from file-formatted data.
     /// Initialize an image from file-formatted memory; only DDS files are supported
     /// \param[in] fileData the block of memory representing the entire image file
@@ -441,6 +499,25 @@ public:
     /// \return true if DXT images will be expanded, false if they will be passed through
     static bool getDXTExpansion() { return m_expandDXT; }
 
+    /// Sets the job system used to expand the levels of large DXT images in parallel
+    /// \param[in] jobSystem the job system to run expansion on, or NULL (the default)
+    /// to expand images on the loading thread only
+    static void setJobSystem(nvidia::shdfnd::JobSystem* jobSystem) { m_jobSystem = jobSystem; }
+
+    /// Gets the job system used to expand DXT images
+    /// \return the job system, or NULL if images are expanded on the loading thread
+    static nvidia::shdfnd::JobSystem* getJobSystem() { return m_jobSystem; }
+
+    /// Enables or disables automatic expansion of RGTC and LATC images to RGBA.
+    /// Only unsigned formats are expanded, and only while DXT expansion is enabled.
+    /// \param[in] expand true enables RGTC/LATC-to-RGBA expansion.  False passes
+    /// RGTC and LATC images through as-is
+    static void setRGTCExpansion(bool expand) { m_expandRGTC = expand; }
+
+    /// Gets the status of automatic RGTC and LATC expansion
+    /// \return true if RGTC and LATC images will be expanded, false if they will be passed through
+    static bool getRGTCExpansion() { return m_expandRGTC; }
+
 protected:
     /// \privatesection
 
@@ -465,11 +542,31 @@ protected:
 	int32_t _dataArrayCount;
 	int32_t _dataBlockSize;
 
+    // the open file and level table of a streamed image
+    struct DDSStream;
+    DDSStream* _stream;
+
     void freeData();
+    void closeStream();
     void flipSurface(uint8_t *surf, int32_t width, int32_t height, int32_t depth);
     uint32_t componentSwapSurface(uint8_t *surf, int32_t width, int32_t height, int32_t depth);
 	void expandDXT(uint8_t *surf, int32_t width, int32_t height, int32_t depth, int32_t srcSize);
 
+    // A single level of a single face/layer that is waiting to be expanded
+    struct DXTSurface {
+        uint8_t* surf;
+        int32_t width;
+        int32_t height;
+        int32_t depth;
+        int32_t srcSize;
+    };
+
+    // Expands all of the given surfaces, spreading them across the job system when there is enough to do
+    void expandDXTSurfaces(DXTSurface* surfaces, int32_t count);
+    struct ExpandDXTJob;
+    static void expandDXTRange(void* job, uint32_t begin, uint32_t end, uint32_t workerIndex);
+    bool canExpandDXT() const;
+
     //
     // Static elements used to dispatch to proper sub-readers
     //
@@ -483,9 +580,13 @@ protected:
     static FormatInfo formatTable[]; 
     static bool vertFlip;
     static bool m_expandDXT;
+    static bool m_expandRGTC;
     static bool m_supportsBGR;
+    static nvidia::shdfnd::JobSystem* m_jobSystem;
 
     static bool readDDS(const uint8_t* fileData, size_t size, NvImage& i);
+    static bool readDDSHeader(const uint8_t* fileData, size_t size, NvImage& i, int32_t& bytesPerElement,
+        bool& btcCompressed, int32_t& headerSize);
 
     static void flip_blocks_dxtc1(uint8_t *ptr, uint32_t numBlocks);
     static void flip_blocks_dxtc3(uint8_t *ptr, uint32_t numBlocks);
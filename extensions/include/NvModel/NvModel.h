@@ -57,6 +57,10 @@ struct NvModelPrimType {
     };
 };
 
+/// Releases the block passed to NvModel::CreateFromPreprocessedInPlace.
+/// \param[in] data the block originally passed to the model
+typedef void (*NvModelDataReleaseFunc)(uint8_t* data);
+
 /// Non-rendering geometry model.
 /// Graphics-API-agnostic geometric model class, including model loading from
 /// OBJ file data, optimization, bounding volumes and rescaling.  
@@ -80,6 +84,29 @@ public:
 	/// \return a pointer to the new model
 	static NvModel* CreateFromPreprocessed(uint8_t* data);
 
+	/// Create a model that references preprocessed "NVM" file data in place.
+	/// The compiled vertex and index arrays point directly into the given
+	/// block rather than into copies of it, so a memory-mapped file is never
+	/// duplicated on the heap.  The model takes ownership of the block and
+	/// calls release on it when destroyed.  If the arrays in the block are
+	/// not suitably aligned, the data is copied and release is called
+	/// before returning.  On failure, the block is left with the caller
+	/// \param[in] data pointer to NVM file data, which must stay valid and
+	/// unmodified until released
+	/// \param[in] size the size of the data in bytes; files whose blocks do
+	/// not fit within it are rejected
+	/// \param[in] release the function used to free the block, or NULL if the
+	/// block outlives the model
+	/// \return a pointer to the new model
+	static NvModel* CreateFromPreprocessedInPlace(uint8_t* data, size_t size, NvModelDataReleaseFunc release);
+
+	/// Enables or disables vertex cache optimization in CreateFromObj.  While
+	/// enabled, the triangles of OBJ models are reordered for better reuse of
+	/// the GPU's post-transform vertex cache, and their vertices are reordered
+	/// to match, so NVM files written from them get the optimized order too.
+	/// \param[in] enable true to optimize, false (the default) to keep the file's order
+	static void SetVertexCacheOptimization(bool enable) { ms_optimizeVertexCache = enable; }
+
 	static NvModel* CreateFromData(const float* verts, uint32_t vertCount, uint32_t vertSize, 
 		const uint32_t* indices, uint32_t indexCount,
 		uint32_t posSize, int32_t posOffset,
@@ -146,8 +173,16 @@ public:
 
 	/// Load a preprocessed NVM model from preloaded data
 	/// \param[in] data pointer to the model data
+	/// \param[in] inPlace if true, reference the vertex and index arrays
+	/// inside data rather than copying them, when their alignment allows
+	/// \param[in] size the size of the data in bytes, if known; the header's
+	/// offsets and counts are checked against it
 	/// \return true on success and false on failure
-	bool LoadPreprocessedModel(uint8_t* data);
+	bool LoadPreprocessedModel(uint8_t* data, bool inPlace = false, size_t size = ~(size_t)0);
+
+	/// Query whether the compiled arrays reference the source block in place
+	/// \return true if the model was loaded in place, false if it owns copies
+	bool isInPlace() const;
 
 	/// Load model data into a model object (assumed to be triangle list)
 	/// \param[in] verts pointer to an array of floats containing all vertex data
@@ -173,6 +208,10 @@ public:
 		uint32_t colorSize = 0, int32_t colorOffset = -1);
 
 protected:
+	/// Frees the compiled arrays, or releases the source block if the model
+	/// was loaded in place
+	void releaseData();
+
     //data structures optimized for rendering, compiled model
     uint32_t* _indices;
     float* _vertices;
@@ -190,6 +229,13 @@ protected:
 	int32_t _indexCount;
 	nv::vec3f m_minExtent;
 	nv::vec3f m_maxExtent;
+
+	// non-NULL if _vertices and _indices point into this block
+	uint8_t* _sourceData;
+	NvModelDataReleaseFunc _releaseSourceData;
+
+	// Whether OBJ models are optimized for the vertex cache when compiled
+	static bool ms_optimizeVertexCache;
 };
 
 #endif
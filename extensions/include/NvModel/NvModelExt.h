@@ -37,6 +37,14 @@
 #include "NV/NvMath.h"
 #include <string>
 
+namespace nvidia
+{
+namespace shdfnd
+{
+	class JobSystem;
+}
+}
+
 namespace Nv
 {
 	class Material;
@@ -60,6 +68,18 @@ namespace Nv
         ///         called on the returned buffer.
         virtual char* LoadDataFromFile(const char* fileName) = 0;
 
+        /// Method to be called to load a preprocessed model file, which is checked
+        /// against the size of the file.  Loaders that know the size should override
+        /// it; by default it calls LoadDataFromFile() and reports the size as unknown.
+        /// \param[in] fileName Name of the file to load
+        /// \param[out] size Size of the file in bytes, or 0 if unknown
+        /// \return As LoadDataFromFile()
+        virtual char* LoadDataFromFileWithSize(const char* fileName, size_t& size)
+        {
+            size = 0;
+            return LoadDataFromFile(fileName);
+        }
+
         /// Releases the memory used by the file loader
         /// \param[in] pData Pointer to the data to release
         virtual void ReleaseData(char* pData) = 0;
@@ -93,6 +113,53 @@ namespace Nv
 		/// \param[in] pLoader Pointer to the file loader to request file data from
 		static void SetFileLoader(NvModelFileLoader* pLoader) { ms_pLoader = pLoader; }
 
+		/// Sets the job system used to tokenize large OBJ files.  The file is
+		/// split at line boundaries into chunks that are tokenized as jobs and
+		/// then merged in file order, so the loaded model is identical to the
+		/// one produced by a single-threaded load.
+		/// \param[in] pJobSystem Job system to run the chunks on, or NULL (the
+		///            default) to parse on the loading thread only.
+		static void SetJobSystem(nvidia::shdfnd::JobSystem* pJobSystem) { ms_pJobSystem = pJobSystem; }
+
+		/// Sets the number of OBJ chunks that are tokenized at once on the job
+		/// system set by SetJobSystem.
+		/// \param[in] threadCount Number of chunks to keep in flight.  0 (the default)
+		///            uses one per job system thread, and 1 forces single-threaded parsing.
+		static void SetObjParseThreadCount(uint32_t threadCount) { ms_objParseThreadCount = threadCount; }
+
+		/// Enables or disables the cache of preprocessed models used by CreateFromObj.
+		/// While enabled, loading an OBJ file also writes the resulting model to a
+		/// cache file in the preprocessed format, tagged with a hash of the OBJ file,
+		/// its material libraries and the load options.  Later loads whose hash matches
+		/// read the cache file instead of parsing and processing the OBJ file again.
+		/// Cache files are replaced atomically, so processes may share a cache.
+		/// The cache is only used once a directory is set with SetObjCacheDirectory,
+		/// which NvSampleApp does with the app's data directory.
+		/// \param[in] enable True (the default) to read and write cached models,
+		///            false to always load from the OBJ file
+		static void SetObjCacheEnabled(bool enable) { ms_objCacheEnabled = enable; }
+
+		/// Sets the directory in which CreateFromObj reads and writes its cached models
+		/// \param[in] cacheDir Path of an existing, writable directory to keep cache
+		///            files in, or NULL (the default) to disable the cache
+		static void SetObjCacheDirectory(const char* cacheDir) { ms_objCacheDirectory = (NULL == cacheDir) ? "" : cacheDir; }
+
+		/// Enables or disables vertex cache optimization of models loaded from OBJ
+		/// files.  While enabled, the triangles of each submesh are reordered for
+		/// better reuse of the GPU's post-transform vertex cache, and its vertices are
+		/// reordered into the order the triangles first use them.  Cached models and
+		/// NVE files written from the model keep the optimized order.
+		/// \param[in] enable True to optimize, false (the default) to keep the file's order
+		static void SetVertexCacheOptimization(bool enable) { ms_optimizeVertexCache = enable; }
+
+		/// Sets whether packed vertices are decoded when a preprocessed model
+		/// written with packVertices is loaded.  Decoding produces the usual float
+		/// vertices and 32-bit indices, so the model can be used like any other.
+		/// Without it, each submesh keeps only its packed data, described by
+		/// SubMesh::getPackedLayout(), and getVertices() and getIndices() return NULL.
+		/// \param[in] decode True (the default) to decode packed vertices, false to keep them packed
+		static void SetDecodePackedVertices(bool decode) { ms_decodePackedVertices = decode; }
+
 		/// Get the point defined by the minimum values in each axis contained
 		/// within the axis-aligned bounding box of the model.
 		/// \return Vector containing the minimum X,Y and Z of the bounding box
@@ -145,20 +212,28 @@ namespace Nv
         /// Serializes the model out to a file in a binary format that 
         /// can quickly be loaded back in
         /// \param filename Name of the file in which to write the model's data
+        /// \param packVertices If true, each submesh's vertices are written with
+        ///        positions quantized to 16 bits within the submesh's bounds,
+        ///        normals and tangents in 16-bit octahedral encoding and texture
+        ///        coordinates as half floats, and its indices with 16 bits when
+        ///        they fit.  The size and precision of the result is logged.
         /// \return True if the model was successfully written to the file,
         ///         False if an error occurred during file creation or writing.
-		bool WritePreprocessedModel(const char* filename);
+		bool WritePreprocessedModel(const char* filename, bool packVertices = false);
 
 	protected:
 		/// \privatesection
 		// Constructor is protected to force the factory method to be used to create a new NvModelExt
 		NvModelExt();
 
+        bool WritePreprocessedModel(FILE* fp, bool packVertices = false);
+        bool WriteCacheFile(const std::string& cachePath, uint64_t sourceKey);
+
         int32_t WriteFileHeader(FILE* fp) const;
         int32_t WriteTextureBlock(FILE* fp) const;
         int32_t WriteSkeletonBlock(FILE* fp) const;
         int32_t WriteMaterials(FILE* fp);
-        int32_t WriteMeshes(FILE* fp);
+        int32_t WriteMeshes(FILE* fp, bool packVertices);
         int32_t WritePaddedString(FILE* fp, const std::string& str) const;
 
         uint32_t GetPaddedStringLength(const std::string& str) const;
@@ -166,6 +241,24 @@ namespace Nv
 		// Pointer to the NvModelFileLoader object to use for all File I/O operations
 		static NvModelFileLoader* ms_pLoader;
 
+		// Job system to tokenize OBJ files on, or NULL to parse them on the loading thread
+		static nvidia::shdfnd::JobSystem* ms_pJobSystem;
+
+		// Number of OBJ chunks to tokenize at once (0 = one per job system thread)
+		static uint32_t ms_objParseThreadCount;
+
+		// Whether CreateFromObj reads and writes cached preprocessed models
+		static bool ms_objCacheEnabled;
+
+		// Directory to keep cached models in, or empty to disable the cache
+		static std::string ms_objCacheDirectory;
+
+		// Whether submeshes loaded from OBJ files are optimized for the vertex cache
+		static bool ms_optimizeVertexCache;
+
+		// Whether packed vertices are decoded to floats when a preprocessed model is loaded
+		static bool ms_decodePackedVertices;
+
         // Pointer to the skeleton for the model. NULL if it doesn't contain one.
         NvSkeleton* m_pSkeleton;
 
@@ -39,6 +39,60 @@
 
 namespace Nv
 {
+    // Storage formats of the attributes of a packed vertex
+    enum VertexFormat
+    {
+        VERTEX_FORMAT_FLOAT32 = 0,      // 32-bit floats
+        VERTEX_FORMAT_UNORM16 = 1,      // 16-bit normalized unsigned integers, scaled and biased to the submesh bounds
+        VERTEX_FORMAT_OCTAHEDRAL16 = 2, // Unit vector as two 16-bit normalized signed integers in octahedral encoding
+        VERTEX_FORMAT_HALF = 3,         // 16-bit floats
+        VERTEX_FORMAT_FORCE32BIT = 0x7FFFFFFF
+    };
+
+    // Describes the layout of a submesh's packed vertices.  Attributes that
+    // have no packed format (colors, bone indices and weights) are stored as
+    // 32-bit floats.
+    struct PackedVertexLayout
+    {
+        PackedVertexLayout()
+            : m_positionFormat(VERTEX_FORMAT_FLOAT32)
+            , m_normalFormat(VERTEX_FORMAT_FLOAT32)
+            , m_texCoordFormat(VERTEX_FORMAT_FLOAT32)
+            , m_tangentFormat(VERTEX_FORMAT_FLOAT32)
+            , m_positionOffset(0)
+            , m_normalOffset(-1)
+            , m_texCoordOffset(-1)
+            , m_tangentOffset(-1)
+            , m_colorOffset(-1)
+            , m_boneIndexOffset(-1)
+            , m_boneWeightOffset(-1)
+            , m_vertexSize(0)
+            , m_indexSize(sizeof(uint32_t))
+            , m_positionScale(1.0f, 1.0f, 1.0f)
+            , m_positionBias(0.0f, 0.0f, 0.0f)
+        {
+        }
+
+        VertexFormat m_positionFormat;
+        VertexFormat m_normalFormat;
+        VertexFormat m_texCoordFormat;
+        VertexFormat m_tangentFormat;
+
+        int32_t m_positionOffset;   // in bytes
+        int32_t m_normalOffset;     // in bytes (-1 == no component)
+        int32_t m_texCoordOffset;   // in bytes (-1 == no component)
+        int32_t m_tangentOffset;    // in bytes (-1 == no component)
+        int32_t m_colorOffset;      // in bytes (-1 == no component)
+        int32_t m_boneIndexOffset;  // in bytes (-1 == no component)
+        int32_t m_boneWeightOffset; // in bytes (-1 == no component)
+        int32_t m_vertexSize;       // in bytes
+        int32_t m_indexSize;        // in bytes (2 or 4)
+
+        // A UNORM16 position decodes to m_positionBias + (value / 65535) * m_positionScale
+        nv::vec3f m_positionScale;
+        nv::vec3f m_positionBias;
+    };
+
     // Used to define a mesh that uses a single material and an array of faces
     class SubMesh
     {
@@ -60,6 +114,8 @@ namespace Nv
             , m_boneIndexOffset(-1)
             , m_boneWeightOffset(-1)
             , m_vertSize(0)
+            , m_packedVertices(NULL)
+            , m_packedIndices(NULL)
         {
         }
 
@@ -113,6 +169,35 @@ namespace Nv
         int32_t getBonesPerVertex() const { return m_bonesPerVertex; }
         int32_t getNumBonesInMesh() const { return m_boneMap.size(); }
 
+		/// Checks to see if the submesh holds its vertices and indices in packed form.
+		/// Packed submeshes are only created by loading a packed preprocessed model
+		/// while NvModelExt::SetDecodePackedVertices(false) is in effect, and have no
+		/// float vertex array.
+		/// \return True if getPackedVertices() and getPackedIndices() are valid
+		bool HasPackedVertices() const { return NULL != m_packedVertices; }
+
+		/// Get the array of packed vertices.
+		/// \return pointer to the first packed vertex, or NULL if the submesh isn't packed
+		const uint8_t* getPackedVertices() const { return m_packedVertices; }
+
+		/// Get the array of packed indices, each of getPackedLayout().m_indexSize bytes
+		/// \return pointer to the first packed index, or NULL if the submesh isn't packed
+		const uint8_t* getPackedIndices() const { return m_packedIndices; }
+
+		/// Get the layout of the packed vertices
+		/// \return the offsets and formats of each attrib in a packed vertex
+		const PackedVertexLayout& getPackedLayout() const { return m_packedLayout; }
+
+		///@{
+		/// Get the storage format of each attrib.
+		/// \return the format of the attrib in the packed vertices, or
+		/// VERTEX_FORMAT_FLOAT32 if the submesh isn't packed
+		VertexFormat getPositionFormat() const { return HasPackedVertices() ? m_packedLayout.m_positionFormat : VERTEX_FORMAT_FLOAT32; }
+		VertexFormat getNormalFormat() const { return HasPackedVertices() ? m_packedLayout.m_normalFormat : VERTEX_FORMAT_FLOAT32; }
+		VertexFormat getTexCoordFormat() const { return HasPackedVertices() ? m_packedLayout.m_texCoordFormat : VERTEX_FORMAT_FLOAT32; }
+		VertexFormat getTangentFormat() const { return HasPackedVertices() ? m_packedLayout.m_tangentFormat : VERTEX_FORMAT_FLOAT32; }
+		///@}
+
 		/// Get the size of a compiled vertex.
 		/// \return the size of the merged vertex (in number of floats)
 		virtual int32_t getVertexSize() const { return m_vertSize; }
@@ -156,6 +241,10 @@ namespace Nv
         int32_t m_boneIndexOffset;   // in floats (zero == no component)
         int32_t m_boneWeightOffset; //  in floats (zero == no component)
 		int32_t m_vertSize; // in floats
+
+		uint8_t* m_packedVertices; // NULL unless the submesh is packed
+		uint8_t* m_packedIndices; // NULL unless the submesh is packed
+		PackedVertexLayout m_packedLayout;
 	};
 }
 #endif
\ No newline at end of file
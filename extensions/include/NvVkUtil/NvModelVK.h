@@ -65,6 +65,15 @@ public:
 	/// \return a pointer to the new model
 	static NvModelVK* CreateFromPreprocessed(NvVkContext& vk, uint8_t* data);
 
+	/// Create a renderable model from a preprocessed "NVM" asset file.
+	/// The file is memory-mapped and the model references the mapping in
+	/// place rather than reading and copying it, so the data is held in
+	/// client memory only once; the mapping is released with the model
+	/// \param[in] vk Vulkan device/queue to render to
+	/// \param[in] filename the partial path (below "assets") to the NVM file
+	/// \return a pointer to the new model
+	static NvModelVK* CreateFromPreprocessedFile(NvVkContext& vk, const char* filename);
+
 	~NvModelVK();
 
 	/// Draw to an open command buffer
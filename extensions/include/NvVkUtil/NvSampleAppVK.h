@@ -114,6 +114,8 @@ protected:
 
     virtual void platformLogTestResults(float frameRate, int32_t frames);
 
+    virtual bool platformGetGPUFrameTime(float& ms);
+
 private:
 	bool mUseWSI;
 	bool mUseGLUI;
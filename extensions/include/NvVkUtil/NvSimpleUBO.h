@@ -56,7 +56,7 @@ public:
 		if (result != VK_SUCCESS)
 			return false;
 
-		result = vkMapMemory(vk.device(), m_buffer.mem, 0, size, 0, (void**)&m_mapped);
+		result = vk.mapMemory(m_buffer, 0, size, (void**)&m_mapped);
 		if (result != VK_SUCCESS)
 			return false;
 
@@ -129,7 +129,7 @@ public:
 
 		m_offset = 0;
 
-		result = vkMapMemory(m_device, m_ubo.mem, m_offset, size, 0, (void**)&m_mapped);
+		result = vk.mapMemory(m_ubo, m_offset, size, (void**)&m_mapped);
 		if (result != VK_SUCCESS)
 			return false;
 
@@ -186,7 +186,7 @@ public:
 		memcpy(((uint8_t*)m_mapped) + index * m_stride, &m_cpuCopy, sizeof(UBOType));
 
 		VkMappedMemoryRange range = { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
-		range.offset = m_offset + m_stride * index;
+		range.offset = m_ubo.memOffset + m_offset + m_stride * index;
 		range.size = m_stride;
 		range.memory = m_ubo.mem;
 		result = vkFlushMappedMemoryRanges(m_device, 1, &range);
@@ -70,25 +70,32 @@ struct NvVKConfiguration : public NvGfxConfiguration {
 class NvImage;
 class NvVkContext;
 class NvGPUTimerVK;
+class NvVkMemorySource;
+class NvVkMemoryAllocator;
+struct NvVkAllocation;
 
 /// A wrapper for a VkBuffer and its memory
 struct NvVkBuffer {
-	VkDeviceMemory mem; ///< Buffer memory object
+	VkDeviceMemory mem; ///< Memory object the buffer is bound to; may be shared with other resources
+	VkDeviceSize memOffset; ///< Offset of the buffer within mem
+	NvVkAllocation* allocation; ///< Allocator range backing the buffer
 	VkBuffer buffer; ///< Buffer object
 	/// Value-of operator.  Returns the VkBuffer
 	/// \return the VkBuffer
 	VkBuffer& operator ()() { return buffer; }
-	NvVkBuffer() : mem(0), buffer(0) {}
+	NvVkBuffer() : mem(0), memOffset(0), allocation(NULL), buffer(0) {}
 };
 
 /// A wrapper for a VkImage and its memory
 struct NvVkImage {
-	VkDeviceMemory mem; ///< Image memory object
+	VkDeviceMemory mem; ///< Memory object the image is bound to; may be shared with other resources
+	VkDeviceSize memOffset; ///< Offset of the image within mem
+	NvVkAllocation* allocation; ///< Allocator range backing the image
 	VkImage image; ///< Image object
 	/// Value-of operator.  Returns the VkImage
 	/// \return the VkImage
 	VkImage& operator ()() { return image; }
-	NvVkImage() : mem(0), image(0) {}
+	NvVkImage() : mem(0), memOffset(0), allocation(NULL), image(0) {}
 };
 
 /// A "texture": a wrapper for a VkImage and its VkImageView
@@ -217,7 +224,9 @@ public:
 		_device(NULL),
 		_queue(NULL),
 		_queueFamilyIndex(0),
-		_queueIndex(0)
+		_queueIndex(0),
+		mMemorySource(NULL),
+		mMemoryAllocator(NULL)
 	{ }
 
 	/// VkInstance access
@@ -251,12 +260,49 @@ public:
 	/// Get the on-screen (or main) render target
 	virtual NvVkRenderTarget* mainRenderTarget() = 0;
 
-	VkResult allocMemAndBindImage(NvVkImage& image, VkFlags memProps = 0);
+	/// Sub-allocates memory for an image from #memoryAllocator and binds it
+	/// \param[in] image the image; mem, memOffset and allocation are filled in
+	/// \param[in] memProps the memory property flags required
+	/// \param[in] tiling the tiling the image was created with
+	/// \return VK_SUCCESS on success or the allocation or binding error
+	VkResult allocMemAndBindImage(NvVkImage& image, VkFlags memProps = 0, VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL);
 	VkResult createImage(VkImageCreateInfo& info, NvVkImage& image, VkFlags memProps = 0);
 
+	/// Sub-allocates memory for a buffer from #memoryAllocator and binds it
+	/// \param[in] buffer the buffer; mem, memOffset and allocation are filled in
+	/// \param[in] memProps the memory property flags required
+	/// \return VK_SUCCESS on success or the allocation or binding error
 	VkResult allocMemAndBindBuffer(NvVkBuffer& buffer, VkFlags memProps = 0);
 	VkResult createAndFillBuffer(size_t size, VkFlags usage, VkFlags memProps, NvVkBuffer& buffer, const void* data = NULL, NvVkStagingBuffer* staging = NULL);
 
+	/// Releases the memory bound by #allocMemAndBindImage.  The image must
+	/// already be destroyed or no longer in use.
+	void freeMemory(NvVkImage& image);
+
+	/// Releases the memory bound by #allocMemAndBindBuffer.  The buffer must
+	/// already be destroyed or no longer in use.
+	void freeMemory(NvVkBuffer& buffer);
+
+	/// Retrieves the host address of a host-visible buffer's memory.  The
+	/// memory is shared with other resources and stays mapped until
+	/// #freeMemory, so there is no matching unmap; do not call vkMapMemory
+	/// on buffer.mem directly.  Flushes of non-coherent memory must add
+	/// buffer.memOffset to their offsets.
+	/// \param[in] buffer the buffer to map
+	/// \param[in] offset the offset into the buffer
+	/// \param[in] size the number of bytes that will be accessed
+	/// \param[out] data the host address of the buffer at offset
+	/// \return VK_SUCCESS or VK_ERROR_MEMORY_MAP_FAILED if the memory is not host-visible
+	VkResult mapMemory(NvVkBuffer& buffer, VkDeviceSize offset, VkDeviceSize size, void** data);
+
+	/// The device memory allocator behind allocMemAndBind*; created on first use
+	NvVkMemoryAllocator& memoryAllocator();
+
+	/// Frees all of the device memory held by #memoryAllocator, along with the
+	/// staging buffer.  Resources bound to that memory must already have been
+	/// destroyed, and the device must not yet have been destroyed
+	void shutdownMemoryAllocator();
+
 	/// Creates a texture from an asset-based DDS file
 	/// \param[in] filename the asset-path of the DDS file to load
 	/// \param[out] tex the loaded texture
@@ -431,6 +477,9 @@ protected:
 
 	NvVkStagingBuffer mStaging;
 
+	NvVkMemorySource* mMemorySource;
+	NvVkMemoryAllocator* mMemoryAllocator;
+
 	NvGPUTimerVK* m_frameTimer;
 
 #if VK_EXT_debug_report 
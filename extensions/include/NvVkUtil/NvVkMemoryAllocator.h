@@ -0,0 +1,198 @@
+//----------------------------------------------------------------------------------
+// File:        NvVkUtil/NvVkMemoryAllocator.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef NV_VKMEMORYALLOCATOR_H
+#define NV_VKMEMORYALLOCATOR_H
+
+/// \file
+/// Pooled sub-allocation of VK device memory.
+
+#include <NvSimpleTypes.h>
+#include "NvPlatformVK.h"
+#include <vector>
+
+/// A range of device memory returned by NvVkMemoryAllocator
+struct NvVkAllocation {
+	VkDeviceMemory memory; ///< Memory object containing the range
+	VkDeviceSize offset; ///< Offset of the range within memory
+	VkDeviceSize size; ///< Size of the range in bytes
+	uint8_t* mapped; ///< Host address of the range, or NULL if the memory is not host-visible
+	uint32_t memoryTypeIndex; ///< Memory type of memory
+};
+
+/// The source of the memory objects that NvVkMemoryAllocator divides up.
+/// Implement this over a synthetic memory-type table to exercise the
+/// allocator without a device.
+class NvVkMemorySource {
+public:
+	virtual ~NvVkMemorySource() {}
+
+	/// Allocate a memory object
+	/// \param[in] memoryTypeIndex the memory type to allocate from
+	/// \param[in] size the size of the object in bytes
+	/// \param[out] memory the new memory object
+	/// \return VK_SUCCESS or the allocation error
+	virtual VkResult allocate(uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory& memory) = 0;
+
+	/// Release a memory object returned by #allocate
+	virtual void free(VkDeviceMemory memory) = 0;
+
+	/// Map an entire host-visible memory object.  The mapping lasts until #free.
+	/// \param[in] memory the memory object to map
+	/// \param[in] size the size the object was allocated with
+	/// \param[out] data the host address of the object
+	/// \return VK_SUCCESS or the mapping error
+	virtual VkResult map(VkDeviceMemory memory, VkDeviceSize size, void** data) = 0;
+};
+
+/// An NvVkMemorySource that allocates from a VkDevice
+class NvVkDeviceMemorySource : public NvVkMemorySource {
+public:
+	NvVkDeviceMemorySource(VkDevice device) : mDevice(device) {}
+
+	virtual VkResult allocate(uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory& memory);
+	virtual void free(VkDeviceMemory memory);
+	virtual VkResult map(VkDeviceMemory memory, VkDeviceSize size, void** data);
+
+private:
+	VkDevice mDevice;
+};
+
+/// Sub-allocates buffer and image memory from large per-memory-type blocks.
+///
+/// Each pool keeps a two-level segregated fit (TLSF) index of the free ranges
+/// in its blocks, so allocation and release are constant time regardless of
+/// the number of live allocations.  Freed ranges merge with their free
+/// neighbours immediately, and a pool keeps at most one empty block.
+///
+/// When bufferImageGranularity is coarser than the allocator's 16 byte
+/// minimum alignment, linear resources (buffers and linear images) and
+/// optimal-tiling images are placed in separate pools so they never share a
+/// granularity page.  Requests too large to pool, and large images, get a
+/// dedicated memory object of their own.
+///
+/// Host-visible blocks are mapped once when created and stay mapped.  The
+/// allocator is not thread-safe.
+class NvVkMemoryAllocator {
+public:
+	/// Resource classes kept apart by bufferImageGranularity
+	enum ResourceKind {
+		RESOURCE_LINEAR = 0, ///< Buffers and linear-tiling images
+		RESOURCE_OPTIMAL, ///< Optimal-tiling images
+		RESOURCE_KIND_COUNT
+	};
+
+	/// Default size of a pooled memory block in bytes
+	static const VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+	/// Occupancy and fragmentation counters for a pool or the whole allocator
+	struct Stats {
+		uint32_t blockCount; ///< Pooled memory objects
+		uint32_t allocationCount; ///< Live allocations placed in blocks
+		uint32_t dedicatedCount; ///< Live dedicated allocations
+		uint32_t freeRangeCount; ///< Free ranges across all blocks
+		uint32_t deviceAllocations; ///< Memory objects allocated from the source so far
+		VkDeviceSize blockBytes; ///< Bytes of all blocks
+		VkDeviceSize usedBytes; ///< Bytes of blocks handed out
+		VkDeviceSize dedicatedBytes; ///< Bytes of live dedicated allocations
+		VkDeviceSize largestFreeRange; ///< Largest single free range in any block
+		VkDeviceSize fragmentedBytes; ///< Free block bytes outside the largest free range of their block
+
+		/// The share of free block memory that is split off from the largest
+		/// free range of its block: 0 when every block's free space is contiguous
+		float fragmentation() const {
+			VkDeviceSize freeBytes = blockBytes - usedBytes;
+			return freeBytes ? float(double(fragmentedBytes) / double(freeBytes)) : 0.0f;
+		}
+	};
+
+	/// Create an allocator
+	/// \param[in] source the provider of memory objects; must outlive the allocator
+	/// \param[in] memoryProperties the memory types and heaps of the device
+	/// \param[in] limits the device limits; bufferImageGranularity and nonCoherentAtomSize are honoured
+	/// \param[in] blockSize the preferred block size; pools on small heaps use an eighth of the heap
+	NvVkMemoryAllocator(NvVkMemorySource& source,
+		const VkPhysicalDeviceMemoryProperties& memoryProperties,
+		const VkPhysicalDeviceLimits& limits,
+		VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE);
+
+	/// Releases all blocks and dedicated allocations back to the source
+	~NvVkMemoryAllocator();
+
+	/// Allocate memory for a resource
+	/// \param[in] reqs the memory requirements of the resource
+	/// \param[in] memProps the memory property flags required
+	/// \param[in] kind the resource class of the resource
+	/// \param[out] allocation the allocated range
+	/// \return VK_SUCCESS, VK_ERROR_FORMAT_NOT_SUPPORTED if no allowed memory type
+	/// has memProps, or the source's allocation error
+	VkResult allocate(const VkMemoryRequirements& reqs, VkFlags memProps,
+		ResourceKind kind, NvVkAllocation*& allocation);
+
+	/// Release an allocation returned by #allocate.  NULL is ignored.
+	void free(NvVkAllocation* allocation);
+
+	/// Retrieve the counters summed over all memory types
+	void getStats(Stats& stats) const;
+
+	/// Retrieve the counters of one memory type
+	void getStats(uint32_t memoryTypeIndex, Stats& stats) const;
+
+	/// \privatesection
+	struct Pool;
+	struct Block;
+	struct Range;
+
+private:
+	NvVkMemoryAllocator(const NvVkMemoryAllocator&);
+	NvVkMemoryAllocator& operator=(const NvVkMemoryAllocator&);
+
+	VkResult allocateFromType(uint32_t memoryTypeIndex, VkDeviceSize size,
+		VkDeviceSize alignment, ResourceKind kind, Range*& range);
+	VkResult createBlock(Pool& pool, VkDeviceSize size, bool dedicated, Block*& block);
+	void destroyBlock(Pool& pool, Block* block);
+	void addPoolStats(const Pool& pool, Stats& stats) const;
+
+	Range* newRange();
+	void deleteRange(Range* range);
+
+	NvVkMemorySource& mSource;
+	VkPhysicalDeviceMemoryProperties mMemoryProperties;
+	VkDeviceSize mBlockSize;
+	VkDeviceSize mNonCoherentAtomSize;
+	bool mSeparateKinds;
+	std::vector<Pool*> mPools;
+	Range* mSpareRanges;
+};
+
+#endif
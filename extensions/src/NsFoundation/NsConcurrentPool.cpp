@@ -0,0 +1,427 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2008-2014 NVIDIA Corporation. All rights reserved.
+// Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
+// Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
+
+
+#include "NsConcurrentPool.h"
+#include "NsAtomic.h"
+#include "NsBasicTemplates.h"
+#include "NsThread.h"
+#include "NvMath.h"
+
+namespace nvidia
+{
+namespace shdfnd
+{
+namespace
+{
+const uint32_t sMagazineSize = 64;
+
+// full magazines kept in the depot before elements go back to their slabs
+const int32_t sMaxFullMagazines = 8;
+}
+
+struct ConcurrentPoolImpl::Slab
+{
+	Slab* mPrev;
+	Slab* mNext;
+	void* mFree; // linked through the first word of the elements
+	uint32_t mFreeCount;
+	uint32_t mLive; // elements in magazines or in use
+};
+
+struct ConcurrentPoolImpl::Magazine
+{
+	SListEntry mEntry;
+	uint32_t mCount;
+	void* mElements[sMagazineSize];
+};
+
+struct ConcurrentPoolImpl::ThreadCache
+{
+	Magazine* mLoaded;
+	Magazine* mPrevious;
+	ThreadCache* mNext;
+};
+
+namespace
+{
+typedef ConcurrentPoolImpl::Slab Slab;
+
+const uint32_t sSlabHeaderSize = (sizeof(Slab) + 15) & ~15u;
+
+NV_INLINE Slab*& getSlab(void* element)
+{
+	return reinterpret_cast<Slab**>(element)[-1];
+}
+
+NV_INLINE void*& getNextFree(void* element)
+{
+	return *reinterpret_cast<void**>(element);
+}
+
+void linkSlab(Slab*& head, Slab* slab)
+{
+	slab->mPrev = 0;
+	slab->mNext = head;
+	if(head)
+		head->mPrev = slab;
+	head = slab;
+}
+
+void unlinkSlab(Slab*& head, Slab* slab)
+{
+	if(slab->mPrev)
+		slab->mPrev->mNext = slab->mNext;
+	else
+		head = slab->mNext;
+	if(slab->mNext)
+		slab->mNext->mPrev = slab->mPrev;
+}
+}
+
+ConcurrentPoolImpl::ConcurrentPoolImpl(uint32_t elementSize, uint32_t elementAlignment, uint32_t elementsPerSlab)
+: mHeaderSize(NvMax(uint32_t(sizeof(void*)), elementAlignment))
+, mElementsPerSlab(NvMax(elementsPerSlab, 1u))
+, mTlsIndex(TlsAlloc())
+, mFullMagazineCount(0)
+, mPartialSlabs(0)
+, mFullSlabs(0)
+, mEmptySlab(0)
+, mSlabCount(0)
+, mThreadCaches(0)
+{
+	NV_ASSERT(elementAlignment <= 16 && !(elementAlignment & (elementAlignment - 1)));
+	mStride = (mHeaderSize + elementSize + mHeaderSize - 1) & ~(mHeaderSize - 1);
+	mSlabSize = sSlabHeaderSize + mStride * mElementsPerSlab;
+}
+
+ConcurrentPoolImpl::~ConcurrentPoolImpl()
+{
+	for(ThreadCache* cache = mThreadCaches; cache;)
+	{
+		ThreadCache* next = cache->mNext;
+		NV_FREE(cache->mLoaded);
+		NV_FREE(cache->mPrevious);
+		NV_FREE(cache);
+		cache = next;
+	}
+
+	for(SListEntry* entry = mFullMagazines.flush(); entry;)
+	{
+		SListEntry* next = entry->next();
+		NV_FREE(entry);
+		entry = next;
+	}
+	for(SListEntry* entry = mEmptyMagazines.flush(); entry;)
+	{
+		SListEntry* next = entry->next();
+		NV_FREE(entry);
+		entry = next;
+	}
+
+	Slab* lists[] = { mPartialSlabs, mFullSlabs };
+	for(uint32_t i = 0; i < 2; ++i)
+	{
+		for(Slab* slab = lists[i]; slab;)
+		{
+			Slab* next = slab->mNext;
+			NV_FREE(slab);
+			slab = next;
+		}
+	}
+	// not linked into a list, its mNext is stale
+	NV_FREE(mEmptySlab);
+
+	TlsFree(mTlsIndex);
+}
+
+void* ConcurrentPoolImpl::allocate()
+{
+	ThreadCache& cache = getThreadCache();
+
+	if(!cache.mLoaded->mCount)
+	{
+		if(cache.mPrevious->mCount)
+		{
+			swap(cache.mLoaded, cache.mPrevious);
+		}
+		else if(SListEntry* entry = mFullMagazines.pop())
+		{
+			atomicDecrement(&mFullMagazineCount);
+			mEmptyMagazines.push(cache.mPrevious->mEntry);
+			cache.mPrevious = cache.mLoaded;
+			cache.mLoaded = reinterpret_cast<Magazine*>(entry);
+		}
+		else
+		{
+			Mutex::ScopedLock lock(mSlabLock);
+			fillFromSlabs(*cache.mLoaded);
+		}
+
+		if(!cache.mLoaded->mCount)
+			return 0;
+	}
+
+	Magazine& loaded = *cache.mLoaded;
+	return loaded.mElements[--loaded.mCount];
+}
+
+void ConcurrentPoolImpl::deallocate(void* element)
+{
+	ThreadCache& cache = getThreadCache();
+
+	if(cache.mLoaded->mCount == sMagazineSize)
+	{
+		if(!cache.mPrevious->mCount)
+		{
+			swap(cache.mLoaded, cache.mPrevious);
+		}
+		else
+		{
+			Magazine* full = cache.mPrevious;
+			SListEntry* entry = mEmptyMagazines.pop();
+			cache.mPrevious = cache.mLoaded;
+			cache.mLoaded = entry ? reinterpret_cast<Magazine*>(entry) : createMagazine();
+
+			if(atomicIncrement(&mFullMagazineCount) > sMaxFullMagazines)
+			{
+				atomicDecrement(&mFullMagazineCount);
+				{
+					Mutex::ScopedLock lock(mSlabLock);
+					returnToSlabs(*full);
+				}
+				mEmptyMagazines.push(full->mEntry);
+			}
+			else
+			{
+				mFullMagazines.push(full->mEntry);
+			}
+		}
+	}
+
+	Magazine& loaded = *cache.mLoaded;
+	loaded.mElements[loaded.mCount++] = element;
+}
+
+void ConcurrentPoolImpl::releaseThreadCache()
+{
+	ThreadCache* cache = reinterpret_cast<ThreadCache*>(TlsGet(mTlsIndex));
+	if(!cache)
+		return;
+
+	{
+		Mutex::ScopedLock lock(mSlabLock);
+		returnToSlabs(*cache->mLoaded);
+		returnToSlabs(*cache->mPrevious);
+	}
+	mEmptyMagazines.push(cache->mLoaded->mEntry);
+	mEmptyMagazines.push(cache->mPrevious->mEntry);
+
+	TlsSet(mTlsIndex, 0);
+
+	{
+		Mutex::ScopedLock lock(mThreadCacheLock);
+		ThreadCache** link = &mThreadCaches;
+		while(*link != cache)
+			link = &(*link)->mNext;
+		*link = cache->mNext;
+	}
+	NV_FREE(cache);
+}
+
+void ConcurrentPoolImpl::disposeElements(void (*destroy)(void*))
+{
+	// clear the slab pointer of every free element
+	for(ThreadCache* cache = mThreadCaches; cache; cache = cache->mNext)
+	{
+		for(uint32_t i = 0; i < cache->mLoaded->mCount; ++i)
+			getSlab(cache->mLoaded->mElements[i]) = 0;
+		for(uint32_t i = 0; i < cache->mPrevious->mCount; ++i)
+			getSlab(cache->mPrevious->mElements[i]) = 0;
+	}
+
+	SListEntry* fullMagazines = mFullMagazines.flush();
+	for(SListEntry* entry = fullMagazines; entry; entry = entry->next())
+	{
+		Magazine* magazine = reinterpret_cast<Magazine*>(entry);
+		for(uint32_t i = 0; i < magazine->mCount; ++i)
+			getSlab(magazine->mElements[i]) = 0;
+	}
+
+	for(Slab* slab = mPartialSlabs; slab; slab = slab->mNext)
+	{
+		for(void* element = slab->mFree; element; element = getNextFree(element))
+			getSlab(element) = 0;
+	}
+
+	Slab* lists[] = { mPartialSlabs, mFullSlabs };
+	for(uint32_t i = 0; i < 2; ++i)
+	{
+		for(Slab* slab = lists[i]; slab; slab = slab->mNext)
+		{
+			uint8_t* element = reinterpret_cast<uint8_t*>(slab) + sSlabHeaderSize + mHeaderSize;
+			for(uint32_t j = 0; j < mElementsPerSlab; ++j, element += mStride)
+			{
+				if(getSlab(element))
+					destroy(element);
+			}
+		}
+	}
+
+	// the magazines are released by the destructor
+	for(SListEntry* entry = fullMagazines; entry;)
+	{
+		SListEntry* next = entry->next();
+		mEmptyMagazines.push(*entry);
+		entry = next;
+	}
+}
+
+ConcurrentPoolImpl::ThreadCache& ConcurrentPoolImpl::getThreadCache()
+{
+	ThreadCache* cache = reinterpret_cast<ThreadCache*>(TlsGet(mTlsIndex));
+	return cache ? *cache : *createThreadCache();
+}
+
+ConcurrentPoolImpl::ThreadCache* ConcurrentPoolImpl::createThreadCache()
+{
+	ThreadCache* cache = reinterpret_cast<ThreadCache*>(NV_ALLOC(sizeof(ThreadCache), "ConcurrentPool"));
+	cache->mLoaded = createMagazine();
+	cache->mPrevious = createMagazine();
+
+	{
+		Mutex::ScopedLock lock(mThreadCacheLock);
+		cache->mNext = mThreadCaches;
+		mThreadCaches = cache;
+	}
+
+	TlsSet(mTlsIndex, cache);
+	return cache;
+}
+
+ConcurrentPoolImpl::Magazine* ConcurrentPoolImpl::createMagazine()
+{
+	Magazine* magazine = reinterpret_cast<Magazine*>(NV_ALLOC(sizeof(Magazine), "ConcurrentPool"));
+	NV_PLACEMENT_NEW(&magazine->mEntry, SListEntry)();
+	magazine->mCount = 0;
+	return magazine;
+}
+
+void ConcurrentPoolImpl::fillFromSlabs(Magazine& magazine)
+{
+	while(magazine.mCount < sMagazineSize)
+	{
+		Slab* slab = mPartialSlabs;
+		if(!slab)
+		{
+			if(mEmptySlab)
+				slab = mEmptySlab, mEmptySlab = 0;
+			else if(!(slab = createSlab()))
+				return;
+			linkSlab(mPartialSlabs, slab);
+		}
+
+		while(slab->mFreeCount && magazine.mCount < sMagazineSize)
+		{
+			void* element = slab->mFree;
+			slab->mFree = getNextFree(element);
+			slab->mFreeCount--;
+			slab->mLive++;
+			magazine.mElements[magazine.mCount++] = element;
+		}
+
+		if(!slab->mFreeCount)
+		{
+			unlinkSlab(mPartialSlabs, slab);
+			linkSlab(mFullSlabs, slab);
+		}
+	}
+}
+
+void ConcurrentPoolImpl::returnToSlabs(Magazine& magazine)
+{
+	for(uint32_t i = 0; i < magazine.mCount; ++i)
+	{
+		void* element = magazine.mElements[i];
+		Slab* slab = getSlab(element);
+
+		if(!slab->mFreeCount)
+		{
+			unlinkSlab(mFullSlabs, slab);
+			linkSlab(mPartialSlabs, slab);
+		}
+
+		getNextFree(element) = slab->mFree;
+		slab->mFree = element;
+		slab->mFreeCount++;
+
+		if(!--slab->mLive)
+		{
+			unlinkSlab(mPartialSlabs, slab);
+			if(mEmptySlab)
+				releaseSlab(slab);
+			else
+				mEmptySlab = slab;
+		}
+	}
+	magazine.mCount = 0;
+}
+
+ConcurrentPoolImpl::Slab* ConcurrentPoolImpl::createSlab()
+{
+	Slab* slab = reinterpret_cast<Slab*>(NV_ALLOC(mSlabSize, "ConcurrentPoolSlab"));
+	if(!slab)
+		return 0;
+
+	slab->mFree = 0;
+	slab->mFreeCount = mElementsPerSlab;
+	slab->mLive = 0;
+
+	// build the free list so that elements are handed out in address order
+	uint8_t* element = reinterpret_cast<uint8_t*>(slab) + sSlabHeaderSize + mHeaderSize + mStride * mElementsPerSlab;
+	for(uint32_t i = 0; i < mElementsPerSlab; ++i)
+	{
+		element -= mStride;
+		getSlab(element) = slab;
+		getNextFree(element) = slab->mFree;
+		slab->mFree = element;
+	}
+
+	mSlabCount++;
+	return slab;
+}
+
+void ConcurrentPoolImpl::releaseSlab(Slab* slab)
+{
+	mSlabCount--;
+	NV_FREE(slab);
+}
+
+} // namespace shdfnd
+} // namespace nvidia
@@ -0,0 +1,442 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2008-2014 NVIDIA Corporation. All rights reserved.
+// Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
+// Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
+
+// Stress test and benchmark of ConcurrentPool.
+//
+// Each thread allocates a few elements, stamps them with its index and their
+// address, checks the stamps, and frees them again. One element per round is
+// handed to a random slot of a shared ring and freed by whichever thread
+// takes it out, so elements keep moving between the threads' magazines.  An
+// element handed out twice shows up as a broken stamp.  Further checks cover
+// releaseThreadCache, destruction of live elements with the pool and the
+// JobSystem's dependent jobs, which come from a ConcurrentPool.
+//
+// With "bench" as the first argument it instead times the same loop against
+// malloc, Pool and Pool2 behind a mutex, and ConcurrentPool, from 1 to 32
+// threads, in millions of allocations and frees per second.
+//
+// Usage: NsConcurrentPoolTest [threads] [rounds]
+//        NsConcurrentPoolTest bench [rounds]
+// Returns 0 if all checks pass.  It builds with, from the extensions directory:
+//   g++ -O2 -std=c++11 -pthread -DLINUX -DNDEBUG -Iinclude -Iinclude/NsFoundation
+//       -Iinclude/NvFoundation src/NsFoundation/NsConcurrentPoolTest.cpp
+//       src/NsFoundation/unix/NsUnixAtomic.cpp src/NsFoundation/unix/NsUnixCpu.cpp
+//       src/NsFoundation/unix/NsUnixFPU.cpp src/NsFoundation/unix/NsUnixMutex.cpp
+//       src/NsFoundation/unix/NsUnixPrintString.cpp src/NsFoundation/unix/NsUnixSList.cpp
+//       src/NsFoundation/unix/NsUnixSocket.cpp src/NsFoundation/unix/NsUnixSync.cpp
+//       src/NsFoundation/unix/NsUnixThread.cpp src/NsFoundation/unix/NsUnixTime.cpp
+//       src/NsFoundation/NsAllocator.cpp src/NsFoundation/NsAssert.cpp
+//       src/NsFoundation/NsConcurrentPool.cpp src/NsFoundation/NsGlobals.cpp
+//       src/NsFoundation/NsJobSystem.cpp src/NsFoundation/NsString.cpp
+//       src/NsFoundation/NsTempAllocator.cpp
+
+#include "NsConcurrentPool.h"
+#include "NsGlobals.h"
+#include "NsJobSystem.h"
+#include "NsPool.h"
+#include "NsThread.h"
+#include "NsVersionNumber.h"
+#include "NvAllocatorCallback.h"
+#include "NvErrorCallback.h"
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+using namespace nvidia;
+using namespace nvidia::shdfnd;
+
+namespace
+{
+class TestAllocator : public NvAllocatorCallback
+{
+  public:
+	virtual void* allocate(size_t size, const char*, const char*, int)
+	{
+		// the foundation expects 16 byte aligned allocations
+#if defined(_WIN32)
+		return _aligned_malloc(size, 16);
+#else
+		void* ptr = NULL;
+		return posix_memalign(&ptr, 16, size) == 0 ? ptr : NULL;
+#endif
+	}
+
+	virtual void deallocate(void* ptr)
+	{
+#if defined(_WIN32)
+		_aligned_free(ptr);
+#else
+		free(ptr);
+#endif
+	}
+};
+
+class TestErrorCallback : public NvErrorCallback
+{
+  public:
+	virtual void reportError(NvErrorCode::Enum, const char* message, const char* file, int line)
+	{
+		fprintf(stderr, "%s(%d): %s\n", file, line, message);
+	}
+};
+
+std::atomic<uint32_t> gDestroyed(0);
+
+struct TestElement
+{
+	uint64_t self;
+	uint64_t owner;
+	uint64_t payload[6];
+
+	TestElement() : self(0), owner(0)
+	{
+	}
+	~TestElement()
+	{
+		gDestroyed++;
+	}
+};
+
+static const uint32_t ELEMENTS_PER_ROUND = 32;
+static const uint32_t RING_SIZE = 1024; // power of two
+
+// Allocation and free through the pool under test, fixed at compile time so
+// that the benchmark measures the pools rather than indirect calls.
+struct MallocAdapter : public UserAllocated
+{
+	TestElement* allocate()
+	{
+		return reinterpret_cast<TestElement*>(malloc(sizeof(TestElement)));
+	}
+	void deallocate(TestElement* element)
+	{
+		free(element);
+	}
+};
+
+template <class P>
+struct LockedAdapter : public UserAllocated
+{
+	P pool;
+	Mutex mutex;
+
+	TestElement* allocate()
+	{
+		Mutex::ScopedLock lock(mutex);
+		return pool.allocate();
+	}
+	void deallocate(TestElement* element)
+	{
+		Mutex::ScopedLock lock(mutex);
+		pool.deallocate(element);
+	}
+};
+
+struct ConcurrentAdapter : public UserAllocated
+{
+	ConcurrentPool<TestElement> pool;
+
+	TestElement* allocate()
+	{
+		return pool.allocate();
+	}
+	void deallocate(TestElement* element)
+	{
+		pool.deallocate(element);
+	}
+};
+
+template <class A>
+struct StressState
+{
+	A* adapter;
+	std::atomic<TestElement*> ring[RING_SIZE];
+	std::atomic<uint32_t> violations;
+	uint32_t rounds;
+};
+
+template <class A>
+void stressThread(StressState<A>* state, uint32_t threadIndex)
+{
+	TestElement* held[ELEMENTS_PER_ROUND];
+	uint32_t random = 0x9e3779b9u * (threadIndex + 1);
+
+	for(uint32_t i = 0; i < state->rounds; i++)
+	{
+		for(uint32_t j = 0; j < ELEMENTS_PER_ROUND; j++)
+		{
+			TestElement* element = state->adapter->allocate();
+			element->self = uint64_t(size_t(element));
+			element->owner = threadIndex;
+			held[j] = element;
+		}
+		for(uint32_t j = 0; j < ELEMENTS_PER_ROUND; j++)
+		{
+			if(held[j]->self != uint64_t(size_t(held[j])) || held[j]->owner != threadIndex)
+				state->violations++;
+		}
+
+		random ^= random << 13;
+		random ^= random >> 17;
+		random ^= random << 5;
+		held[0]->owner = ~uint64_t(0);
+		if(TestElement* element = state->ring[random & (RING_SIZE - 1)].exchange(held[0]))
+			state->adapter->deallocate(element);
+
+		for(uint32_t j = ELEMENTS_PER_ROUND - 1; j > 0; j--)
+			state->adapter->deallocate(held[j]);
+	}
+}
+
+// Returns millions of allocations and frees per second.
+template <class A>
+double runStress(A& adapter, uint32_t threadCount, uint32_t rounds, uint32_t& violations)
+{
+	StressState<A>* state = new StressState<A>;
+	state->adapter = &adapter;
+	for(uint32_t i = 0; i < RING_SIZE; i++)
+		state->ring[i] = NULL;
+	state->violations = 0;
+	state->rounds = rounds;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for(uint32_t t = 0; t < threadCount; t++)
+		threads.push_back(std::thread(stressThread<A>, state, t));
+	for(uint32_t t = 0; t < threadCount; t++)
+		threads[t].join();
+	for(uint32_t i = 0; i < RING_SIZE; i++)
+	{
+		if(TestElement* element = state->ring[i].exchange(NULL))
+			adapter.deallocate(element);
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	violations = state->violations;
+	delete state;
+	return double(threadCount) * rounds * ELEMENTS_PER_ROUND * 2 / ms / 1000.0;
+}
+
+bool runConcurrentStress(uint32_t threadCount, uint32_t rounds)
+{
+	uint32_t violations;
+	ConcurrentAdapter* adapter = NV_NEW(ConcurrentAdapter);
+	double rate = runStress(*adapter, threadCount, rounds, violations);
+	NV_DELETE(adapter);
+
+	bool passed = violations == 0;
+	printf("%u threads, %u rounds: %.1f M allocations and frees per second, %u broken elements: %s\n", threadCount,
+	       rounds, rate, violations, passed ? "passed" : "FAILED");
+	return passed;
+}
+
+struct ReleaseState
+{
+	ConcurrentPool<TestElement>* pool;
+	uint32_t count;
+	bool release;
+};
+
+void* releaseThread(void* arg)
+{
+	ReleaseState* state = reinterpret_cast<ReleaseState*>(arg);
+	std::vector<TestElement*> elements(state->count);
+	for(uint32_t i = 0; i < state->count; i++)
+		elements[i] = state->pool->allocate();
+	for(uint32_t i = 0; i < state->count; i++)
+		state->pool->deallocate(elements[i]);
+	if(state->release)
+		state->pool->releaseThreadCache();
+	return NULL;
+}
+
+// A thread that frees 100 elements leaves them in its two magazines, so both
+// of the 64 element slabs stay live until the thread hands them back.
+bool runReleaseThreadCache()
+{
+	bool passed = true;
+	for(uint32_t release = 0; release < 2; release++)
+	{
+		ConcurrentPool<TestElement>* pool = NV_NEW(ConcurrentPool<TestElement>)(64);
+		ReleaseState state = { pool, 100, release != 0 };
+		Thread* thread = NV_NEW(Thread)(releaseThread, &state);
+		thread->waitForQuit();
+		NV_DELETE(thread);
+
+		uint32_t slabs = pool->getSlabCount();
+		NV_DELETE(pool);
+
+		// one empty slab is kept for reuse
+		uint32_t expected = release ? 1u : 2u;
+		printf("%s releaseThreadCache: %u slabs left, expected %u\n", release ? "with" : "without", slabs, expected);
+		passed = passed && slabs == expected;
+	}
+	printf("releaseThreadCache: %s\n", passed ? "passed" : "FAILED");
+	return passed;
+}
+
+bool runDisposeElements()
+{
+	gDestroyed = 0;
+	uint32_t destroyedBefore;
+	{
+		ConcurrentPool<TestElement> pool;
+		std::vector<TestElement*> elements;
+		for(uint32_t i = 0; i < 1000; i++)
+			elements.push_back(pool.construct());
+		for(uint32_t i = 0; i < 1000; i += 2)
+			pool.destroy(elements[i]);
+		destroyedBefore = gDestroyed;
+	}
+
+	bool passed = destroyedBefore == 500 && gDestroyed == 1000;
+	printf("%u elements destroyed explicitly and %u with the pool, expected 500 and 500: %s\n", destroyedBefore,
+	       gDestroyed - destroyedBefore, passed ? "passed" : "FAILED");
+	return passed;
+}
+
+struct DependencyState
+{
+	std::atomic<uint32_t> gateOpen;
+	std::atomic<uint32_t> earlyRuns;
+	std::atomic<uint32_t> runs;
+};
+
+void gateJob(void* userData, uint32_t)
+{
+	DependencyState* state = reinterpret_cast<DependencyState*>(userData);
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	state->gateOpen = 1;
+}
+
+void dependentJob(void* userData, uint32_t)
+{
+	DependencyState* state = reinterpret_cast<DependencyState*>(userData);
+	if(!state->gateOpen)
+		state->earlyRuns++;
+	state->runs++;
+}
+
+// Dependent jobs are allocated by the thread that runs them and freed by the
+// worker that finishes the job they depend on.
+bool runJobDependencies(uint32_t threadCount)
+{
+	static const uint32_t JOB_COUNT = 10000;
+	DependencyState state;
+	state.gateOpen = 0;
+	state.earlyRuns = 0;
+	state.runs = 0;
+
+	JobSystem* jobSystem = NV_NEW(JobSystem)(threadCount);
+	for(uint32_t i = 0; i < 10; i++)
+	{
+		state.gateOpen = 0;
+		JobCounter gate, done;
+		jobSystem->run(gateJob, &state, gate);
+		for(uint32_t j = 0; j < JOB_COUNT; j++)
+			jobSystem->run(dependentJob, &state, done, gate);
+		jobSystem->wait(done);
+		jobSystem->wait(gate);
+	}
+	NV_DELETE(jobSystem);
+
+	bool passed = state.runs == 10 * JOB_COUNT && state.earlyRuns == 0;
+	printf("%u dependent jobs on %u workers, %u ran early: %s\n", uint32_t(state.runs), threadCount,
+	       uint32_t(state.earlyRuns), passed ? "passed" : "FAILED");
+	return passed;
+}
+
+template <class A>
+double benchmark(uint32_t threadCount, uint32_t rounds, uint32_t& violations)
+{
+	A* adapter = NV_NEW(A);
+	double rate = runStress(*adapter, threadCount, rounds, violations);
+	NV_DELETE(adapter);
+	return rate;
+}
+
+bool runBenchmark(uint32_t totalRounds)
+{
+	uint32_t violations = 0;
+	printf("threads     malloc  Pool+mutex  Pool2+mutex  ConcurrentPool   (M allocations and frees per second)\n");
+	for(uint32_t threadCount = 1; threadCount <= 32; threadCount *= 2)
+	{
+		uint32_t rounds = totalRounds / threadCount;
+		uint32_t v[4];
+		double m = benchmark<MallocAdapter>(threadCount, rounds, v[0]);
+		double p = benchmark<LockedAdapter<Pool<TestElement> > >(threadCount, rounds, v[1]);
+		double p2 = benchmark<LockedAdapter<Pool2<TestElement, 4096> > >(threadCount, rounds, v[2]);
+		double c = benchmark<ConcurrentAdapter>(threadCount, rounds, v[3]);
+		violations += v[0] + v[1] + v[2] + v[3];
+		printf("%7u %10.1f %11.1f %12.1f %15.1f\n", threadCount, m, p, p2, c);
+	}
+	printf("%u broken elements: %s\n", violations, violations ? "FAILED" : "passed");
+	return violations == 0;
+}
+}
+
+int main(int argc, char** argv)
+{
+	bool bench = argc > 1 && strcmp(argv[1], "bench") == 0;
+	uint32_t threadCount = argc > 1 && !bench ? uint32_t(atoi(argv[1])) : 0;
+	uint32_t rounds = argc > 2 ? uint32_t(atoi(argv[2])) : 100000;
+	if(threadCount == 0)
+	{
+		threadCount = std::thread::hardware_concurrency();
+		threadCount = threadCount < 4 ? 4 : threadCount;
+	}
+
+	TestAllocator allocator;
+	TestErrorCallback errorCallback;
+	initializeSharedFoundation(NV_FOUNDATION_VERSION, allocator, errorCallback);
+
+	bool passed;
+	if(bench)
+	{
+		passed = runBenchmark(rounds);
+	}
+	else
+	{
+		passed = runConcurrentStress(1, rounds);
+		passed = runConcurrentStress(threadCount, rounds) && passed;
+		passed = runReleaseThreadCache() && passed;
+		passed = runDisposeElements() && passed;
+		passed = runJobDependencies(threadCount - 1) && passed;
+	}
+
+	terminateSharedFoundation();
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2008-2014 NVIDIA Corporation. All rights reserved.
+// Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
+// Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
+
+
+#include "NsFrameArena.h"
+#include "NsAtomic.h"
+#include "NvMath.h"
+
+namespace nvidia
+{
+namespace shdfnd
+{
+namespace
+{
+FrameArena* gCurrentFrameArena = 0;
+
+// keeps overflow blocks 16 byte aligned
+const uint32_t sOverflowHeaderSize = 16;
+}
+
+FrameArena::FrameArena(uint32_t bytesPerFrame, uint32_t frameCount)
+: mFrameCount(NvClamp(frameCount, 1u, sMaxFrameCount))
+, mCurrentFrame(0)
+, mBytesPerFrame((bytesPerFrame + 15) & ~15u)
+, mPeakBytes(0)
+{
+	uint8_t* buffer = reinterpret_cast<uint8_t*>(NV_ALLOC(mBytesPerFrame * mFrameCount, "FrameArena"));
+	NV_ASSERT((size_t(buffer) & 0xf) == 0);
+
+	for(uint32_t i = 0; i < sMaxFrameCount; ++i)
+	{
+		Frame& frame = mFrames[i];
+		frame.mBuffer = i < mFrameCount ? buffer + i * mBytesPerFrame : 0;
+		frame.mOffset = 0;
+		frame.mAllocations = 0;
+		frame.mOverflowAllocations = 0;
+		frame.mOverflowBytes = 0;
+		frame.mOverflow = 0;
+	}
+
+	mLastFrameStats.mAllocations = 0;
+	mLastFrameStats.mBytes = 0;
+	mLastFrameStats.mOverflowAllocations = 0;
+	mLastFrameStats.mOverflowBytes = 0;
+}
+
+FrameArena::~FrameArena()
+{
+	if(gCurrentFrameArena == this)
+		gCurrentFrameArena = 0;
+
+	for(uint32_t i = 0; i < mFrameCount; ++i)
+		releaseOverflow(i);
+
+	NV_FREE(mFrames[0].mBuffer);
+}
+
+void* FrameArena::allocate(size_t size, const char* file, int line)
+{
+	if(!size)
+		return 0;
+
+	Frame& frame = mFrames[mCurrentFrame];
+	size_t alignedSize = (size + 15) & ~size_t(15);
+
+	// once the buffer is full, skip the atomic so the offset cannot wrap
+	if(alignedSize <= mBytesPerFrame && uint32_t(frame.mOffset) <= mBytesPerFrame)
+	{
+		uint32_t end = uint32_t(atomicAdd(&frame.mOffset, int32_t(alignedSize)));
+		if(end <= mBytesPerFrame)
+		{
+			atomicIncrement(&frame.mAllocations);
+			return frame.mBuffer + end - alignedSize;
+		}
+	}
+
+	return allocateOverflow(size, file, line);
+}
+
+void* FrameArena::allocateOverflow(size_t size, const char* file, int line)
+{
+	Frame& frame = mFrames[mCurrentFrame];
+
+	void** block =
+	    reinterpret_cast<void**>(getAllocator().allocate(size + sOverflowHeaderSize, "FrameArenaOverflow", file, line));
+	if(!block)
+		return 0;
+
+	{
+		Mutex::ScopedLock lock(mOverflowLock);
+		*block = frame.mOverflow;
+		frame.mOverflow = block;
+	}
+
+	atomicIncrement(&frame.mOverflowAllocations);
+	atomicAdd(&frame.mOverflowBytes, int32_t(size));
+	return reinterpret_cast<uint8_t*>(block) + sOverflowHeaderSize;
+}
+
+void FrameArena::releaseOverflow(uint32_t index)
+{
+	Frame& frame = mFrames[index];
+	for(void* block = frame.mOverflow; block;)
+	{
+		void* next = *reinterpret_cast<void**>(block);
+		getAllocator().deallocate(block);
+		block = next;
+	}
+	frame.mOverflow = 0;
+}
+
+void FrameArena::nextFrame()
+{
+	mLastFrameStats = getFrameStats();
+	mPeakBytes = NvMax(mPeakBytes, mLastFrameStats.mBytes + mLastFrameStats.mOverflowBytes);
+
+	mCurrentFrame = (mCurrentFrame + 1) % mFrameCount;
+
+	// the oldest frame's memory is released for reuse
+	Frame& frame = mFrames[mCurrentFrame];
+	releaseOverflow(mCurrentFrame);
+	frame.mOffset = 0;
+	frame.mAllocations = 0;
+	frame.mOverflowAllocations = 0;
+	frame.mOverflowBytes = 0;
+}
+
+FrameArena::Stats FrameArena::getFrameStats() const
+{
+	const Frame& frame = mFrames[mCurrentFrame];
+
+	Stats stats;
+	stats.mAllocations = uint32_t(frame.mAllocations);
+	stats.mBytes = NvMin(uint32_t(frame.mOffset), mBytesPerFrame);
+	stats.mOverflowAllocations = uint32_t(frame.mOverflowAllocations);
+	stats.mOverflowBytes = uint32_t(frame.mOverflowBytes);
+	return stats;
+}
+
+void FrameArena::setCurrent(FrameArena* arena)
+{
+	gCurrentFrameArena = arena;
+}
+
+FrameArena* FrameArena::getCurrent()
+{
+	return gCurrentFrameArena;
+}
+
+} // namespace shdfnd
+} // namespace nvidia
@@ -41,13 +41,16 @@
 #include "NsAtomic.h"
 #include "NsBasicTemplates.h"
 #include "NsBitUtils.h"
+#include "NsConcurrentPool.h"
 #include "NsCpu.h"
 #include "NsFPU.h"
+#include "NsFrameArena.h"
 #include "NsHash.h"
 #include "NsHashSet.h"
 #include "NsHashInternals.h"
 #include "NsInlineAllocator.h"
 #include "NsIntrinsics.h"
+#include "NsJobSystem.h"
 #include "NsMutex.h"
 #include "NsPool.h"
 #include "NsSList.h"
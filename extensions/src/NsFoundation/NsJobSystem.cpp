@@ -0,0 +1,435 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2008-2014 NVIDIA Corporation. All rights reserved.
+// Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
+// Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
+
+#include "NsJobSystem.h"
+#include "NsAtomic.h"
+#include "NsIntrinsics.h"
+#include "NsThread.h"
+
+namespace nvidia
+{
+namespace shdfnd
+{
+namespace
+{
+// Failed attempts to find a job before an idle worker goes to sleep
+const uint32_t gSpinCount = 256;
+}
+
+struct JobSystem::Job
+{
+	JobFunction function;
+	RangeFunction rangeFunction; // set instead of function for a slice of a parallel for
+	void* userData;
+	JobCounter* counter;
+	uint32_t begin;
+	uint32_t end;
+	uint32_t grainSize;
+};
+
+struct JobSystem::DependentJob
+{
+	Job job;
+	DependentJob* next;
+};
+
+// Chase-Lev deque: the owning thread pushes and pops at the bottom, other
+// threads steal from the top. top and bottom only ever grow, and the jobs
+// live in a ring indexed by their low bits.
+struct JobSystem::Worker
+{
+	enum
+	{
+		eQUEUE_SIZE = 1024 // power of two
+	};
+
+	volatile int32_t top;
+	uint8_t pad0[64 - sizeof(int32_t)];
+	volatile int32_t bottom;
+	uint8_t pad1[64 - sizeof(int32_t)];
+
+	Thread* thread;
+	JobSystem* system;
+	uint32_t index;
+	uint32_t random; // xorshift state for picking victims
+	Job jobs[eQUEUE_SIZE];
+
+	bool push(const Job& job)
+	{
+		int32_t b = bottom;
+		int32_t t = top;
+		if(b - t >= eQUEUE_SIZE)
+			return false;
+
+		jobs[b & (eQUEUE_SIZE - 1)] = job;
+		// the job must be visible before a thief can see the new bottom
+		memoryBarrier();
+		bottom = b + 1;
+		return true;
+	}
+
+	bool pop(Job& job)
+	{
+		int32_t b = bottom - 1;
+		bottom = b;
+		// a thief must see the new bottom before we read top
+		memoryBarrier();
+		int32_t t = top;
+
+		if(t > b)
+		{
+			bottom = t;
+			return false;
+		}
+
+		job = jobs[b & (eQUEUE_SIZE - 1)];
+		if(t == b)
+		{
+			// last job, race the thieves for it
+			bool won = atomicCompareExchange(&top, t + 1, t) == t;
+			bottom = t + 1;
+			return won;
+		}
+		return true;
+	}
+
+	bool steal(Job& job)
+	{
+		int32_t t = top;
+		memoryBarrier();
+		int32_t b = bottom;
+
+		if(t >= b)
+			return false;
+
+		// the copy may be overwritten while we read it, but then top has
+		// moved on and the exchange below fails
+		job = jobs[t & (eQUEUE_SIZE - 1)];
+		return atomicCompareExchange(&top, t + 1, t) == t;
+	}
+
+	uint32_t nextRandom()
+	{
+		random ^= random << 13;
+		random ^= random >> 17;
+		random ^= random << 5;
+		return random;
+	}
+};
+
+JobSystem::JobSystem(uint32_t workerCount, uint32_t affinityMask)
+: mQueuedJobs(0), mSleepingWorkers(0), mQuit(0)
+{
+	if(workerCount == defaultWorkerCount)
+	{
+		uint32_t cores = Thread::getNbPhysicalCores();
+		workerCount = cores > 2 ? cores - 1 : 1;
+	}
+
+	mWorkerCount = workerCount;
+	mWorkers = reinterpret_cast<Worker*>(NV_ALLOC(sizeof(Worker) * (workerCount + 1), "JobSystem::Worker"));
+	for(uint32_t i = 0; i <= workerCount; i++)
+	{
+		Worker& worker = mWorkers[i];
+		worker.top = 0;
+		worker.bottom = 0;
+		worker.thread = NULL;
+		worker.system = this;
+		worker.index = i;
+		worker.random = 0x9e3779b9u * (i + 1);
+	}
+
+	mTlsIndex = TlsAlloc();
+	TlsSet(mTlsIndex, &mWorkers[0]);
+
+	uint32_t affinityBit = 0;
+	for(uint32_t i = 1; i <= workerCount; i++)
+	{
+		mWorkers[i].thread = NV_NEW(Thread)(workerThunk, &mWorkers[i]);
+
+		if(affinityMask)
+		{
+			do
+			{
+				affinityBit = (affinityBit + 1) & 31;
+			} while(!(affinityMask & (1u << affinityBit)));
+			mWorkers[i].thread->setAffinityMask(1u << affinityBit);
+		}
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	atomicExchange(&mQuit, 1);
+	mWakeup.set();
+
+	for(uint32_t i = 1; i <= mWorkerCount; i++)
+	{
+		mWorkers[i].thread->waitForQuit();
+		NV_DELETE(mWorkers[i].thread);
+	}
+
+	TlsFree(mTlsIndex);
+	NV_FREE(mWorkers);
+}
+
+uint32_t JobSystem::getCurrentThreadIndex() const
+{
+	Worker* worker = reinterpret_cast<Worker*>(TlsGet(mTlsIndex));
+	return worker ? worker->index : 0;
+}
+
+void JobSystem::run(JobFunction function, void* userData, JobCounter& counter)
+{
+	Job job = { function, NULL, userData, &counter, 0, 0, 0 };
+	atomicIncrement(&counter.mCount);
+	schedule(job);
+}
+
+void JobSystem::run(JobFunction function, void* userData, JobCounter& counter, JobCounter& dependency)
+{
+	Job job = { function, NULL, userData, &counter, 0, 0, 0 };
+	atomicIncrement(&counter.mCount);
+
+	{
+		Mutex::ScopedLock lock(mDependencyLock);
+		// finish() drops the count to zero under the lock, so either it
+		// sees this job in the list or we see the count at zero
+		if(!dependency.isDone())
+		{
+			DependentJob* dependent = mDependentJobs.allocate();
+			dependent->job = job;
+			dependent->next = reinterpret_cast<DependentJob*>(dependency.mDependents);
+			dependency.mDependents = dependent;
+			return;
+		}
+	}
+
+	schedule(job);
+}
+
+void JobSystem::parallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, RangeFunction function, void* userData,
+                            JobCounter& counter)
+{
+	if(begin >= end)
+		return;
+
+	Job job = { NULL, function, userData, &counter, begin, end, grainSize ? grainSize : 1 };
+	atomicIncrement(&counter.mCount);
+	schedule(job);
+}
+
+void JobSystem::parallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, RangeFunction function, void* userData)
+{
+	JobCounter counter;
+	parallelFor(begin, end, grainSize, function, userData, counter);
+	wait(counter);
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+	Worker* worker = reinterpret_cast<Worker*>(TlsGet(mTlsIndex));
+	if(!worker)
+	{
+		// not one of ours, so nothing can be queued on this thread
+		while(!counter.isDone())
+			Thread::yield();
+		return;
+	}
+
+	uint32_t spins = 0;
+	Job job;
+	while(!counter.isDone())
+	{
+		if(takeJob(worker->index, job))
+		{
+			execute(worker->index, job);
+			spins = 0;
+		}
+		else if(++spins < gSpinCount)
+		{
+			NvSpinLockPause();
+		}
+		else
+		{
+			// the remaining jobs are running on other threads
+			Thread::yield();
+		}
+	}
+}
+
+bool JobSystem::push(uint32_t threadIndex, const Job& job)
+{
+	if(!mWorkers[threadIndex].push(job))
+		return false;
+
+	atomicIncrement(&mQueuedJobs);
+	if(mSleepingWorkers)
+		mWakeup.set();
+	return true;
+}
+
+bool JobSystem::takeJob(uint32_t threadIndex, Job& job)
+{
+	bool found = mWorkers[threadIndex].pop(job);
+
+	if(!found && mQueuedJobs)
+	{
+		// try every other worker once, starting at a random one
+		uint32_t count = mWorkerCount + 1;
+		uint32_t victim = mWorkers[threadIndex].nextRandom() % count;
+		for(uint32_t i = 0; i < count && !found; i++, victim = (victim + 1) % count)
+		{
+			if(victim != threadIndex)
+				found = mWorkers[victim].steal(job);
+		}
+	}
+
+	if(found)
+		atomicDecrement(&mQueuedJobs);
+	return found;
+}
+
+void JobSystem::execute(uint32_t threadIndex, Job& job)
+{
+	if(job.rangeFunction)
+	{
+		// hand out the upper halves to thieves until a grain is left
+		while(job.end - job.begin > job.grainSize)
+		{
+			Job upper = job;
+			upper.begin = job.begin + (job.end - job.begin) / 2;
+			atomicIncrement(&job.counter->mCount);
+			if(!push(threadIndex, upper))
+			{
+				atomicDecrement(&job.counter->mCount);
+				break;
+			}
+			job.end = upper.begin;
+		}
+		job.rangeFunction(job.userData, job.begin, job.end, threadIndex);
+	}
+	else
+	{
+		job.function(job.userData, threadIndex);
+	}
+
+	finish(*job.counter);
+}
+
+void JobSystem::schedule(const Job& job)
+{
+	Worker* worker = reinterpret_cast<Worker*>(TlsGet(mTlsIndex));
+
+	// foreign threads and full queues run the job right away
+	if(!worker || !push(worker->index, job))
+	{
+		Job copy = job;
+		execute(worker ? worker->index : 0, copy);
+	}
+}
+
+void JobSystem::finish(JobCounter& counter)
+{
+	// Once the count reads zero, wait() may return and the counter may be
+	// gone, so the last job detaches the dependents under the lock first and
+	// only then drops the count. Nothing touches the counter afterwards.
+	DependentJob* dependents;
+	for(;;)
+	{
+		int32_t count = counter.mCount;
+		if(count > 1)
+		{
+			if(atomicCompareExchange(&counter.mCount, count - 1, count) == count)
+				return;
+			continue;
+		}
+
+		Mutex::ScopedLock lock(mDependencyLock);
+		dependents = reinterpret_cast<DependentJob*>(counter.mDependents);
+		counter.mDependents = NULL;
+		if(atomicCompareExchange(&counter.mCount, 0, 1) == 1)
+			break;
+
+		// another job was counted in the meantime, so this isn't the last one
+		counter.mDependents = dependents;
+	}
+
+	while(dependents)
+	{
+		DependentJob* next = dependents->next;
+		schedule(dependents->job);
+		mDependentJobs.deallocate(dependents);
+		dependents = next;
+	}
+}
+
+void JobSystem::workerLoop(uint32_t threadIndex)
+{
+	TlsSet(mTlsIndex, &mWorkers[threadIndex]);
+
+	uint32_t spins = 0;
+	Job job;
+	while(!mQuit)
+	{
+		if(takeJob(threadIndex, job))
+		{
+			execute(threadIndex, job);
+			spins = 0;
+		}
+		else if(++spins < gSpinCount)
+		{
+			NvSpinLockPause();
+		}
+		else
+		{
+			// Sleep until a job is pushed. Whoever resets the event
+			// checks the queued count afterwards, so a push can't be missed.
+			atomicIncrement(&mSleepingWorkers);
+			mWakeup.reset();
+			memoryBarrier();
+			if(!mQueuedJobs && !mQuit)
+				mWakeup.wait();
+			atomicDecrement(&mSleepingWorkers);
+			spins = 0;
+		}
+	}
+
+	mDependentJobs.releaseThreadCache();
+}
+
+void* JobSystem::workerThunk(void* arg)
+{
+	Worker* worker = reinterpret_cast<Worker*>(arg);
+	worker->system->workerLoop(worker->index);
+	return NULL;
+}
+
+} // namespace shdfnd
+} // namespace nvidia
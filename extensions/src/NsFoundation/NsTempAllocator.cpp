@@ -32,6 +32,8 @@
 #include "NsArray.h"
 #include "NsMutex.h"
 #include "NsAtomic.h"
+#include "NsSList.h"
+#include "NsThread.h"
 #include "NvMath.h"
 #include "NsIntrinsics.h"
 #include "NsBitUtils.h"
@@ -47,32 +49,152 @@ namespace shdfnd
 namespace
 {
 typedef TempAllocatorChunk Chunk;
-typedef Array<Chunk*, NonTrackingAllocator> AllocFreeTable;
+
+const uint32_t sMinIndex = 8;  // 256B min
+const uint32_t sMaxIndex = 17; // 128kB max
+const uint32_t sClassCount = sMaxIndex - sMinIndex;
+NV_COMPILE_TIME_ASSERT(sClassCount == TempAllocatorStats::sClassCount);
+
+// Free bytes a thread keeps per size class before it hands half of its
+// chunks back to the shared lists.
+const uint32_t sThreadCacheBytes = 64 * 1024;
+
+NV_INLINE uint32_t getChunkSize(uint32_t index)
+{
+	return 2u << index;
+}
+
+NV_INLINE uint32_t getCacheLimit(uint32_t index)
+{
+	return NvMax(sThreadCacheBytes / getChunkSize(index), 2u);
+}
+
+// Chunks move between threads in batches. The first chunk of a batch is
+// the list entry, the rest stay linked through mNext.
+struct ChunkBatch
+{
+	SListEntry mEntry;
+	Chunk* mRest;
+	uint32_t mCount;
+};
+
+// Only touched by its thread, except for the statistics and shutdown.
+// Released back to the shared lists when its thread exits.
+struct ThreadCache
+{
+	Chunk* mFreeList[sClassCount];
+	uint32_t mFreeCount[sClassCount];
+
+	uint64_t mHits[sClassCount];
+	uint64_t mGlobalHits[sClassCount];
+	uint64_t mMisses[sClassCount];
+	uint64_t mLargeAllocations;
+};
+
+typedef Array<ThreadCache*, NonTrackingAllocator> ThreadCacheArray;
 
 class TempAllocatorGlobals
 {
 	NV_NOCOPY(TempAllocatorGlobals)
   public:
-	TempAllocatorGlobals()
+	TempAllocatorGlobals() : tlsIndex(TlsAlloc()), reservedBytes(0)
 	{
+		for(uint32_t i = 0; i < sClassCount; ++i)
+			globalChunks[i] = 0;
+		intrinsics::memZero(&retired, sizeof(ThreadCache));
 	}
-	AllocFreeTable allocFreeTable;
-	Mutex allocMutex;
+	~TempAllocatorGlobals()
+	{
+		TlsFree(tlsIndex);
+	}
+
+	uint32_t tlsIndex;
+	SList globalBatches[sClassCount];
+	volatile int32_t globalChunks[sClassCount];
+	volatile int32_t reservedBytes;
+
+	// thread caches are created once per thread and released when the
+	// thread exits or on shutdown; retired keeps the counters of released
+	// caches so that the statistics don't go backwards
+	ThreadCacheArray threadCaches;
+	ThreadCache retired;
+	Mutex threadCacheMutex;
 };
 
 TempAllocatorGlobals* gTempAllocatorGlobals = 0;
 
-NV_INLINE AllocFreeTable& getFreeTable()
+ThreadCache* createThreadCache()
 {
-	return gTempAllocatorGlobals->allocFreeTable;
+	ThreadCache* cache = reinterpret_cast<ThreadCache*>(
+	    NonTrackingAllocator().allocate(sizeof(ThreadCache), __FILE__, __LINE__));
+	intrinsics::memZero(cache, sizeof(ThreadCache));
+
+	TlsSet(gTempAllocatorGlobals->tlsIndex, cache);
+
+	Mutex::ScopedLock lock(gTempAllocatorGlobals->threadCacheMutex);
+	gTempAllocatorGlobals->threadCaches.pushBack(cache);
+	return cache;
 }
-NV_INLINE Mutex& getMutex()
+
+NV_INLINE ThreadCache& getThreadCache()
 {
-	return gTempAllocatorGlobals->allocMutex;
+	ThreadCache* cache = reinterpret_cast<ThreadCache*>(TlsGet(gTempAllocatorGlobals->tlsIndex));
+	return cache ? *cache : *createThreadCache();
 }
 
-const uint32_t sMinIndex = 8;  // 256B min
-const uint32_t sMaxIndex = 17; // 128kB max
+// moves count chunks from the top of the thread's free list to the shared list
+void releaseBatch(ThreadCache& cache, uint32_t sizeClass, uint32_t count)
+{
+	Chunk* first = cache.mFreeList[sizeClass];
+	Chunk* last = first;
+	for(uint32_t i = 1; i < count; ++i)
+		last = last->mNext;
+
+	cache.mFreeList[sizeClass] = last->mNext;
+	cache.mFreeCount[sizeClass] -= count;
+
+	Chunk* rest = first->mNext;
+	ChunkBatch* batch = reinterpret_cast<ChunkBatch*>(first);
+	NV_PLACEMENT_NEW(&batch->mEntry, SListEntry)();
+	batch->mRest = count > 1 ? rest : 0;
+	batch->mCount = count;
+
+	if(count > 1)
+		last->mNext = 0;
+
+	atomicAdd(&gTempAllocatorGlobals->globalChunks[sizeClass], int32_t(count));
+	gTempAllocatorGlobals->globalBatches[sizeClass].push(batch->mEntry);
+}
+
+// takes a batch from the shared list into the thread's empty free list
+bool acquireBatch(ThreadCache& cache, uint32_t sizeClass)
+{
+	NV_ASSERT(!cache.mFreeList[sizeClass]);
+
+	ChunkBatch* batch = reinterpret_cast<ChunkBatch*>(gTempAllocatorGlobals->globalBatches[sizeClass].pop());
+	if(!batch)
+		return false;
+
+	uint32_t count = batch->mCount;
+	Chunk* first = reinterpret_cast<Chunk*>(batch);
+	first->mNext = batch->mRest;
+
+	atomicAdd(&gTempAllocatorGlobals->globalChunks[sizeClass], -int32_t(count));
+	cache.mFreeList[sizeClass] = first;
+	cache.mFreeCount[sizeClass] = count;
+	return true;
+}
+
+void deallocateChunkList(Chunk* chunk)
+{
+	NonTrackingAllocator alloc;
+	while(chunk)
+	{
+		Chunk* next = chunk->mNext;
+		alloc.deallocate(chunk);
+		chunk = next;
+	}
+}
 }
 
 void initializeTempAllocatorGlobals()
@@ -82,21 +204,31 @@ void initializeTempAllocatorGlobals()
 	new (gTempAllocatorGlobals) TempAllocatorGlobals();
 }
 
+// Caches of threads that were not started by the foundation and never
+// called TempAllocator::releaseThreadCache are only released here.
 void terminateTempAllocatorGlobals()
 {
-	AllocFreeTable& table = getFreeTable();
+	ThreadCacheArray& caches = gTempAllocatorGlobals->threadCaches;
+	for(uint32_t i = 0; i < caches.size(); ++i)
+	{
+		for(uint32_t j = 0; j < sClassCount; ++j)
+			deallocateChunkList(caches[i]->mFreeList[j]);
+		NonTrackingAllocator().deallocate(caches[i]);
+	}
+	caches.reset();
 
-	NonTrackingAllocator alloc;
-	for(uint32_t i = 0; i < table.size(); ++i)
+	for(uint32_t i = 0; i < sClassCount; ++i)
 	{
-		for(TempAllocatorChunk* ptr = table[i]; ptr;)
+		for(SListEntry* entry = gTempAllocatorGlobals->globalBatches[i].flush(); entry;)
 		{
-			TempAllocatorChunk* next = ptr->mNext;
-			alloc.deallocate(ptr);
-			ptr = next;
+			SListEntry* next = entry->next();
+			ChunkBatch* batch = reinterpret_cast<ChunkBatch*>(entry);
+			Chunk* rest = batch->mRest;
+			NonTrackingAllocator().deallocate(batch);
+			deallocateChunkList(rest);
+			entry = next;
 		}
 	}
-	table.reset();
 
 	gTempAllocatorGlobals->~TempAllocatorGlobals();
 	NV_FREE(gTempAllocatorGlobals);
@@ -113,24 +245,42 @@ void* TempAllocator::allocate(size_t size, const char* filename, int line)
 	Chunk* chunk = 0;
 	if(index < sMaxIndex)
 	{
-		Mutex::ScopedLock lock(getMutex());
+		ThreadCache& cache = getThreadCache();
+		uint32_t sizeClass = index - sMinIndex;
 
-		// find chunk up to 16x bigger than necessary
-		Chunk** it = getFreeTable().begin() + index - sMinIndex;
-		Chunk** end = NvMin(it + 3, getFreeTable().end());
-		while(it < end && !(*it))
+		// find chunk up to 4x bigger than necessary
+		uint32_t it = sizeClass;
+		uint32_t end = NvMin(sizeClass + 3, sClassCount);
+		while(it < end && !cache.mFreeList[it])
 			++it;
 
 		if(it < end)
+			++cache.mHits[sizeClass];
+		else if(acquireBatch(cache, it = sizeClass))
+			++cache.mGlobalHits[sizeClass];
+		else
+			it = sClassCount;
+
+		if(it < sClassCount)
+		{
 			// pop top off freelist
-			chunk = *it, *it = chunk->mNext, index = uint32_t(it - getFreeTable().begin() + sMinIndex);
+			chunk = cache.mFreeList[it];
+			cache.mFreeList[it] = chunk->mNext;
+			--cache.mFreeCount[it];
+			index = it + sMinIndex;
+		}
 		else
+		{
 			// create new chunk
-			chunk = (Chunk*)NonTrackingAllocator().allocate(size_t(2 << index), filename, line);
+			++cache.mMisses[sizeClass];
+			atomicAdd(&gTempAllocatorGlobals->reservedBytes, int32_t(getChunkSize(index)));
+			chunk = (Chunk*)NonTrackingAllocator().allocate(size_t(getChunkSize(index)), filename, line);
+		}
 	}
 	else
 	{
 		// too big for temp allocation, forward to base allocator
+		++getThreadCache().mLargeAllocations;
 		chunk = (Chunk*)NonTrackingAllocator().allocate(size + sizeof(Chunk), filename, line);
 	}
 
@@ -151,14 +301,83 @@ void TempAllocator::deallocate(void* ptr)
 	if(index >= sMaxIndex)
 		return NonTrackingAllocator().deallocate(chunk);
 
-	Mutex::ScopedLock lock(getMutex());
+	ThreadCache& cache = getThreadCache();
+	uint32_t sizeClass = index - sMinIndex;
+
+	chunk->mNext = cache.mFreeList[sizeClass];
+	cache.mFreeList[sizeClass] = chunk;
+
+	// keep half of the chunks so that alternating allocate/deallocate
+	// around the limit does not bounce batches to the shared list
+	uint32_t count = ++cache.mFreeCount[sizeClass];
+	if(count > getCacheLimit(index))
+		releaseBatch(cache, sizeClass, count / 2);
+}
+
+void TempAllocator::releaseThreadCache()
+{
+	if(!gTempAllocatorGlobals)
+		return;
 
-	index -= sMinIndex;
-	if(getFreeTable().size() <= index)
-		getFreeTable().resize(index + 1);
+	ThreadCache* cache = reinterpret_cast<ThreadCache*>(TlsGet(gTempAllocatorGlobals->tlsIndex));
+	if(!cache)
+		return;
 
-	chunk->mNext = getFreeTable()[index];
-	getFreeTable()[index] = chunk;
+	for(uint32_t i = 0; i < sClassCount; ++i)
+	{
+		if(cache->mFreeCount[i])
+			releaseBatch(*cache, i, cache->mFreeCount[i]);
+	}
+
+	TlsSet(gTempAllocatorGlobals->tlsIndex, 0);
+
+	{
+		Mutex::ScopedLock lock(gTempAllocatorGlobals->threadCacheMutex);
+		ThreadCache& retired = gTempAllocatorGlobals->retired;
+		for(uint32_t i = 0; i < sClassCount; ++i)
+		{
+			retired.mHits[i] += cache->mHits[i];
+			retired.mGlobalHits[i] += cache->mGlobalHits[i];
+			retired.mMisses[i] += cache->mMisses[i];
+		}
+		retired.mLargeAllocations += cache->mLargeAllocations;
+		gTempAllocatorGlobals->threadCaches.findAndReplaceWithLast(cache);
+	}
+
+	NonTrackingAllocator().deallocate(cache);
+}
+
+void TempAllocator::getStats(TempAllocatorStats& stats)
+{
+	intrinsics::memZero(&stats, sizeof(TempAllocatorStats));
+
+	for(uint32_t i = 0; i < sClassCount; ++i)
+		stats.mBytesCached[i] = uint32_t(gTempAllocatorGlobals->globalChunks[i]) * getChunkSize(i + sMinIndex);
+	stats.mHighWaterMark = uint32_t(gTempAllocatorGlobals->reservedBytes);
+
+	Mutex::ScopedLock lock(gTempAllocatorGlobals->threadCacheMutex);
+	const ThreadCache& retired = gTempAllocatorGlobals->retired;
+	for(uint32_t j = 0; j < sClassCount; ++j)
+	{
+		stats.mThreadCacheHits[j] = retired.mHits[j];
+		stats.mGlobalHits[j] = retired.mGlobalHits[j];
+		stats.mMisses[j] = retired.mMisses[j];
+	}
+	stats.mLargeAllocations = retired.mLargeAllocations;
+
+	ThreadCacheArray& caches = gTempAllocatorGlobals->threadCaches;
+	for(uint32_t i = 0; i < caches.size(); ++i)
+	{
+		const ThreadCache& cache = *caches[i];
+		for(uint32_t j = 0; j < sClassCount; ++j)
+		{
+			stats.mThreadCacheHits[j] += cache.mHits[j];
+			stats.mGlobalHits[j] += cache.mGlobalHits[j];
+			stats.mMisses[j] += cache.mMisses[j];
+			stats.mBytesCached[j] += cache.mFreeCount[j] * getChunkSize(j + sMinIndex);
+		}
+		stats.mLargeAllocations += cache.mLargeAllocations;
+	}
 }
 
 } // namespace shdfnd
@@ -28,14 +28,7 @@
 // Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
 
 #include "NsAllocator.h"
-#include "NsAtomic.h"
 #include "NsSList.h"
-#include "NsThread.h"
-#include <pthread.h>
-
-#if NV_IOS
-#define USE_MUTEX
-#endif
 
 namespace nvidia
 {
@@ -43,108 +36,138 @@ namespace shdfnd
 {
 namespace
 {
-#if defined(USE_MUTEX)
-class ScopedMutexLock
+// Treiber stack.  The head is paired with a tag that every pop and flush
+// increments, and the pair is swapped as a unit, so that an entry that is
+// popped and pushed again while another thread is half way through a pop
+// cannot corrupt the list (the ABA problem).  As with the Windows SList,
+// the memory of a popped entry may still be read by a concurrent pop, so
+// it must stay mapped while the list is in use.
+struct SListDetail
 {
-	pthread_mutex_t& mMutex;
-
-  public:
-	NV_INLINE ScopedMutexLock(pthread_mutex_t& mutex) : mMutex(mutex)
-	{
-		pthread_mutex_lock(&mMutex);
-	}
-
-	NV_INLINE ~ScopedMutexLock()
-	{
-		pthread_mutex_unlock(&mMutex);
-	}
+	SListEntry* head;
+	size_t tag;
 };
 
-typedef ScopedMutexLock ScopedLock;
-#else
-struct ScopedSpinLock
-{
-	NV_FORCE_INLINE ScopedSpinLock(volatile int32_t& lock) : mLock(lock)
-	{
-		while(__sync_lock_test_and_set(&mLock, 1))
-		{
-			// spinning without atomics is usually
-			// causing less bus traffic. -> only one
-			// CPU is modifying the cache line.
-			while(lock)
-				NvSpinLockPause();
-		}
-	}
+NV_COMPILE_TIME_ASSERT(sizeof(SListDetail) == NV_SLIST_ALIGNMENT);
 
-	NV_FORCE_INLINE ~ScopedSpinLock()
-	{
-		__sync_lock_release(&mLock);
-	}
-
-  private:
-	volatile int32_t& mLock;
-};
+template <typename T>
+SListDetail* getDetail(T* impl)
+{
+	return reinterpret_cast<SListDetail*>(impl);
+}
 
-typedef ScopedSpinLock ScopedLock;
-#endif
+// Either half may be stale or torn, which only makes the following swap fail
+NV_FORCE_INLINE SListDetail loadDetail(const SListDetail* detail)
+{
+	SListDetail result;
+	result.tag = reinterpret_cast<const volatile SListDetail*>(detail)->tag;
+	result.head = reinterpret_cast<const volatile SListDetail*>(detail)->head;
+	return result;
+}
 
-struct SListDetail
+// Replaces the head and tag with desired if they still match expected,
+// otherwise loads their current values into expected.  Full barrier.
+NV_FORCE_INLINE bool compareAndSwapDetail(SListDetail* detail, SListDetail& expected, const SListDetail& desired)
 {
+#if NV_X64
+	bool success;
+	__asm__ __volatile__("lock cmpxchg16b %1\n\t"
+	                     "sete %0"
+	                     : "=q"(success), "+m"(*detail), "+a"(expected.head), "+d"(expected.tag)
+	                     : "b"(desired.head), "c"(desired.tag)
+	                     : "cc", "memory");
+	return success;
+#elif NV_A64
+	// exclusive pair load/store rather than a CAS instruction, which only
+	// exists from ARMv8.1 on; the store fails if anything wrote the pair
+	// since the load, so a torn load can never be written back
 	SListEntry* head;
-#if defined(USE_MUTEX)
-	pthread_mutex_t lock;
+	size_t tag;
+	uint32_t failed;
+	__asm__ __volatile__("1:\n\t"
+	                     "ldaxp %0, %1, %3\n\t"
+	                     "cmp %0, %4\n\t"
+	                     "ccmp %1, %5, #0, eq\n\t"
+	                     "b.ne 2f\n\t"
+	                     "stlxp %w2, %6, %7, %3\n\t"
+	                     "cbnz %w2, 1b\n\t"
+	                     "2:"
+	                     : "=&r"(head), "=&r"(tag), "=&r"(failed), "+Q"(*detail)
+	                     : "r"(expected.head), "r"(expected.tag), "r"(desired.head), "r"(desired.tag)
+	                     : "cc", "memory");
+	bool success = (head == expected.head) && (tag == expected.tag);
+	expected.head = head;
+	expected.tag = tag;
+	return success;
 #else
-	volatile int32_t lock;
+	// 32-bit pointers: the pair fits a 64-bit swap (cmpxchg8b, ldrexd/strexd)
+	NV_COMPILE_TIME_ASSERT(sizeof(SListDetail) == sizeof(uint64_t));
+	union
+	{
+		SListDetail detail;
+		uint64_t bits;
+	} oldValue, newValue, result;
+	oldValue.detail = expected;
+	newValue.detail = desired;
+	result.bits = __sync_val_compare_and_swap(reinterpret_cast<uint64_t*>(detail), oldValue.bits, newValue.bits);
+	expected = result.detail;
+	return result.bits == oldValue.bits;
 #endif
-};
-
-template <typename T>
-SListDetail* getDetail(T* impl)
-{
-	return reinterpret_cast<SListDetail*>(impl);
 }
 }
 
 SListImpl::SListImpl()
 {
 	getDetail(this)->head = NULL;
-
-#if defined(USE_MUTEX)
-	pthread_mutex_init(&getDetail(this)->lock, NULL);
-#else
-	getDetail(this)->lock = 0; // 0 == unlocked
-#endif
+	getDetail(this)->tag = 0;
 }
 
 SListImpl::~SListImpl()
 {
-#if defined(USE_MUTEX)
-	pthread_mutex_destroy(&getDetail(this)->lock);
-#endif
 }
 
 void SListImpl::push(SListEntry* entry)
 {
-	ScopedLock lock(getDetail(this)->lock);
-	entry->mNext = getDetail(this)->head;
-	getDetail(this)->head = entry;
+	SListDetail* detail = getDetail(this);
+	SListDetail expected = loadDetail(detail);
+	SListDetail desired;
+	do
+	{
+		// pushing cannot cause ABA, so the tag is left alone
+		entry->mNext = expected.head;
+		desired.head = entry;
+		desired.tag = expected.tag;
+	} while(!compareAndSwapDetail(detail, expected, desired));
 }
 
 SListEntry* SListImpl::pop()
 {
-	ScopedLock lock(getDetail(this)->lock);
-	SListEntry* result = getDetail(this)->head;
-	if(result != NULL)
-		getDetail(this)->head = result->mNext;
-	return result;
+	SListDetail* detail = getDetail(this);
+	SListDetail expected = loadDetail(detail);
+	SListDetail desired;
+	do
+	{
+		if(expected.head == NULL)
+			return NULL;
+		desired.head = reinterpret_cast<SListEntry* volatile&>(expected.head->mNext);
+		desired.tag = expected.tag + 1;
+	} while(!compareAndSwapDetail(detail, expected, desired));
+	return expected.head;
 }
 
 SListEntry* SListImpl::flush()
 {
-	ScopedLock lock(getDetail(this)->lock);
-	SListEntry* result = getDetail(this)->head;
-	getDetail(this)->head = NULL;
-	return result;
+	SListDetail* detail = getDetail(this);
+	SListDetail expected = loadDetail(detail);
+	SListDetail desired;
+	do
+	{
+		if(expected.head == NULL)
+			return NULL;
+		desired.head = NULL;
+		desired.tag = expected.tag + 1;
+	} while(!compareAndSwapDetail(detail, expected, desired));
+	return expected.head;
 }
 
 static const uint32_t gSize = sizeof(SListDetail);
@@ -0,0 +1,239 @@
+// This code contains NVIDIA Confidential Information and is disclosed to you
+// under a form of NVIDIA software license agreement provided separately to you.
+//
+// Notice
+// NVIDIA Corporation and its licensors retain all intellectual property and
+// proprietary rights in and to this software and related documentation and
+// any modifications thereto. Any use, reproduction, disclosure, or
+// distribution of this software and related documentation without an express
+// license agreement from NVIDIA Corporation is strictly prohibited.
+//
+// ALL NVIDIA DESIGN SPECIFICATIONS, CODE ARE PROVIDED "AS IS.". NVIDIA MAKES
+// NO WARRANTIES, EXPRESSED, IMPLIED, STATUTORY, OR OTHERWISE WITH RESPECT TO
+// THE MATERIALS, AND EXPRESSLY DISCLAIMS ALL IMPLIED WARRANTIES OF NONINFRINGEMENT,
+// MERCHANTABILITY, AND FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Information and code furnished is believed to be accurate and reliable.
+// However, NVIDIA Corporation assumes no responsibility for the consequences of use of such
+// information or for any infringement of patents or other rights of third parties that may
+// result from its use. No license is granted by implication or otherwise under any patent
+// or patent rights of NVIDIA Corporation. Details are subject to change without notice.
+// This code supersedes and replaces all information previously supplied.
+// NVIDIA Corporation products are not authorized for use as critical
+// components in life support devices or systems without express written approval of
+// NVIDIA Corporation.
+//
+// Copyright (c) 2008-2014 NVIDIA Corporation. All rights reserved.
+// Copyright (c) 2004-2008 AGEIA Technologies, Inc. All rights reserved.
+// Copyright (c) 2001-2004 NovodeX AG. All rights reserved.
+
+// Stress test of the tagged SList.
+//
+// Each thread repeatedly pops a few entries, claims each one with an atomic
+// owner field, then releases and pushes them back, while one thread also
+// flushes the whole list and pushes it back entry by entry.  An entry that is
+// popped by two threads at once (a lost ABA race) fails the claim, and a
+// corrupted head shows up as lost or duplicated entries in the final count.
+// Few entries and many threads make ABA races most likely, so the test runs
+// once with as many entries as threads and once with a large pool.
+//
+// Usage: NsUnixSListTest [threads] [iterations]
+// Returns 0 if all checks pass.  It builds with, from the extensions directory:
+//   g++ -O2 -std=c++11 -pthread -DLINUX -DNDEBUG -Iinclude -Iinclude/NsFoundation
+//       -Iinclude/NvFoundation src/NsFoundation/unix/NsUnixSListTest.cpp
+//       src/NsFoundation/unix/NsUnixAtomic.cpp src/NsFoundation/unix/NsUnixCpu.cpp
+//       src/NsFoundation/unix/NsUnixFPU.cpp src/NsFoundation/unix/NsUnixMutex.cpp
+//       src/NsFoundation/unix/NsUnixPrintString.cpp src/NsFoundation/unix/NsUnixSList.cpp
+//       src/NsFoundation/unix/NsUnixSocket.cpp src/NsFoundation/unix/NsUnixSync.cpp
+//       src/NsFoundation/unix/NsUnixThread.cpp src/NsFoundation/unix/NsUnixTime.cpp
+//       src/NsFoundation/NsAllocator.cpp src/NsFoundation/NsAssert.cpp
+//       src/NsFoundation/NsGlobals.cpp src/NsFoundation/NsJobSystem.cpp
+//       src/NsFoundation/NsString.cpp src/NsFoundation/NsTempAllocator.cpp
+// ABA races need real parallelism; on a single core they are rarely hit.
+
+#include "NsSList.h"
+#include "NsGlobals.h"
+#include "NsVersionNumber.h"
+#include "NvAllocatorCallback.h"
+#include "NvErrorCallback.h"
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+using namespace nvidia;
+using namespace nvidia::shdfnd;
+
+namespace
+{
+class TestAllocator : public NvAllocatorCallback
+{
+  public:
+	virtual void* allocate(size_t size, const char*, const char*, int)
+	{
+		// the list head is swapped 16 bytes at a time and must be aligned
+		void* ptr = NULL;
+		return posix_memalign(&ptr, 16, size) == 0 ? ptr : NULL;
+	}
+
+	virtual void deallocate(void* ptr)
+	{
+		free(ptr);
+	}
+};
+
+class TestErrorCallback : public NvErrorCallback
+{
+  public:
+	virtual void reportError(NvErrorCode::Enum, const char* message, const char* file, int line)
+	{
+		fprintf(stderr, "%s(%d): %s\n", file, line, message);
+	}
+};
+
+struct TestEntry : public SListEntry
+{
+	std::atomic<int> owner;
+	uint32_t id;
+};
+
+static const int NO_OWNER = -1;
+static const uint32_t ENTRIES_PER_ITERATION = 4;
+static const uint32_t FLUSH_INTERVAL = 1024;
+
+struct StressState
+{
+	SList list;
+	std::atomic<uint32_t> violations;
+};
+
+static void claim(StressState& state, TestEntry* entry, int from, int to)
+{
+	int expected = from;
+	if(!entry->owner.compare_exchange_strong(expected, to))
+		state.violations++;
+}
+
+static void stressThread(StressState* state, int threadIndex, uint32_t iterations)
+{
+	TestEntry* held[ENTRIES_PER_ITERATION];
+	std::vector<SListEntry*> flushed;
+
+	for(uint32_t i = 0; i < iterations; i++)
+	{
+		uint32_t count = 0;
+		while(count < ENTRIES_PER_ITERATION)
+		{
+			TestEntry* entry = static_cast<TestEntry*>(state->list.pop());
+			if(entry == NULL)
+				break;
+			claim(*state, entry, NO_OWNER, threadIndex);
+			held[count++] = entry;
+		}
+		for(uint32_t j = 0; j < count; j++)
+		{
+			claim(*state, held[j], threadIndex, NO_OWNER);
+			state->list.push(*held[j]);
+		}
+
+		if(threadIndex == 0 && (i % FLUSH_INTERVAL) == 0)
+		{
+			flushed.clear();
+			for(SListEntry* entry = state->list.flush(); entry != NULL; entry = entry->next())
+				flushed.push_back(entry);
+			for(size_t j = 0; j < flushed.size(); j++)
+			{
+				TestEntry* entry = static_cast<TestEntry*>(flushed[j]);
+				claim(*state, entry, NO_OWNER, threadIndex);
+				claim(*state, entry, threadIndex, NO_OWNER);
+				state->list.push(*entry);
+			}
+		}
+	}
+}
+
+static bool runStress(uint32_t threadCount, uint32_t entryCount, uint32_t iterations)
+{
+	StressState state;
+	state.violations = 0;
+
+	std::vector<TestEntry> entries(entryCount);
+	for(uint32_t i = 0; i < entryCount; i++)
+	{
+		entries[i].owner = NO_OWNER;
+		entries[i].id = i;
+		state.list.push(entries[i]);
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for(uint32_t t = 0; t < threadCount; t++)
+		threads.push_back(std::thread(stressThread, &state, int(t), iterations));
+	for(uint32_t t = 0; t < threadCount; t++)
+		threads[t].join();
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// every entry must be back on the list exactly once
+	std::vector<uint32_t> seen(entryCount, 0);
+	uint32_t count = 0, duplicates = 0, strays = 0;
+	for(SListEntry* entry = state.list.flush(); entry != NULL && count <= entryCount; entry = entry->next())
+	{
+		uint32_t id = static_cast<TestEntry*>(entry)->id;
+		if(entry < &entries[0] || entry > &entries[entryCount - 1])
+			strays++;
+		else if(seen[id]++)
+			duplicates++;
+		count++;
+	}
+
+	bool passed = count == entryCount && duplicates == 0 && strays == 0 && state.violations == 0;
+	double operations = double(threadCount) * iterations * ENTRIES_PER_ITERATION * 2;
+	printf("%u threads, %u entries: %.1f ms, %.1f M push/pop per second\n", threadCount, entryCount, ms,
+	       operations / ms / 1000.0);
+	printf("%u of %u entries returned, %u duplicated, %u invalid, %u ownership violations: %s\n", count, entryCount,
+	       duplicates, strays, uint32_t(state.violations), passed ? "passed" : "FAILED");
+	return passed;
+}
+
+static bool runSingleThreaded()
+{
+	SList list;
+	TestEntry entries[3];
+	for(uint32_t i = 0; i < 3; i++)
+	{
+		entries[i].id = i;
+		list.push(entries[i]);
+	}
+
+	bool passed = list.pop() == &entries[2];
+	SListEntry* chain = list.flush();
+	passed = passed && chain == &entries[1] && chain->next() == &entries[0] && chain->next()->next() == NULL;
+	passed = passed && list.pop() == NULL && list.flush() == NULL;
+	printf("single-threaded push, pop and flush: %s\n", passed ? "passed" : "FAILED");
+	return passed;
+}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t threadCount = argc > 1 ? uint32_t(atoi(argv[1])) : 0;
+	uint32_t iterations = argc > 2 ? uint32_t(atoi(argv[2])) : 200000;
+	if(threadCount == 0)
+	{
+		threadCount = std::thread::hardware_concurrency();
+		threadCount = threadCount < 4 ? 4 : threadCount;
+	}
+
+	TestAllocator allocator;
+	TestErrorCallback errorCallback;
+	initializeSharedFoundation(NV_FOUNDATION_VERSION, allocator, errorCallback);
+
+	bool passed = runSingleThreaded();
+	passed = runStress(threadCount, threadCount, iterations) && passed;
+	passed = runStress(threadCount, 4096, iterations) && passed;
+
+	terminateSharedFoundation();
+	return passed ? 0 : 1;
+}
@@ -30,6 +30,7 @@
 #include "Ns.h"
 #include "NsAtomic.h"
 #include "NsThread.h"
+#include "NsTempAllocator.h"
 #include "NvAssert.h"
 #include "NvErrorCallback.h"
 
@@ -125,6 +126,9 @@ void* NvThreadStart(void* arg)
 		(*impl->fn)(impl->arg);
 	else if(impl->arg)
 		((Runnable*)impl->arg)->execute();
+
+	// hand the thread's temp allocator chunks to the threads that remain
+	TempAllocator::releaseThreadCache();
 	return 0;
 }
 }
@@ -241,6 +245,7 @@ bool ThreadImpl::quitIsSignalled()
 void ThreadImpl::quit()
 {
 	getThread(this)->state = _NvThreadStopped;
+	TempAllocator::releaseThreadCache();
 	pthread_exit(0);
 }
 
@@ -29,6 +29,7 @@
 
 #include "windows/NsWindowsInclude.h"
 #include "NsThread.h"
+#include "NsTempAllocator.h"
 #include "NvErrorCallback.h"
 #include "NvAssert.h"
 
@@ -96,6 +97,9 @@ DWORD WINAPI NvThreadStart(LPVOID arg)
 		(*impl->fn)(impl->arg);
 	else if(impl->arg)
 		((Runnable*)impl->arg)->execute();
+
+	// hand the thread's temp allocator chunks to the threads that remain
+	TempAllocator::releaseThreadCache();
 	return 0;
 }
 
@@ -256,6 +260,7 @@ bool ThreadImpl::quitIsSignalled()
 void ThreadImpl::quit()
 {
 	getThread(this)->state = _ThreadImpl::Stopped;
+	TempAllocator::releaseThreadCache();
 	ExitThread(0);
 }
 
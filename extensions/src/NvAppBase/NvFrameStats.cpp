@@ -0,0 +1,224 @@
+//----------------------------------------------------------------------------------
+// File:        NvAppBase/NvFrameStats.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+ 
+/* Frame time distribution stats */
+#include <NvAppBase/NvFrameStats.h>
+#include <NsBitUtils.h>
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+const float NvFrameStats::STUTTER_FACTOR = 2.0f;
+
+static void appendf(std::string& out, const char* fmt, ...);
+
+NvFrameStats::NvFrameStats(uint32_t historyFrames) {
+    m_history.resize(historyFrames > 0 ? historyFrames : 1);
+    m_histograms.resize(CHANNEL_COUNT);
+    reset();
+}
+
+void NvFrameStats::reset() {
+    m_historyNext = 0;
+    m_frameCount = 0;
+    for (uint32_t i = 0; i < CHANNEL_COUNT; i++) {
+        Histogram& hist = m_histograms[i];
+        memset(hist.mCounts, 0, sizeof(hist.mCounts));
+        hist.mTotal = 0;
+        hist.mSum = 0.0;
+        hist.mMin = 0.0f;
+        hist.mMax = 0.0f;
+    }
+}
+
+uint32_t NvFrameStats::bucketIndex(uint32_t us) {
+    // Keep the top SUB_BUCKET_BITS + 1 bits of the value; the shift that
+    // took to get there selects the power-of-two range
+    uint32_t shift = 0;
+    if (us >= 2 * SUB_BUCKET_COUNT)
+        shift = nvidia::shdfnd::highestSetBit(us) - SUB_BUCKET_BITS;
+    return (shift << SUB_BUCKET_BITS) + (us >> shift);
+}
+
+uint32_t NvFrameStats::bucketHighestValue(uint32_t index) {
+    uint32_t shift = 0;
+    if (index >= 2 * SUB_BUCKET_COUNT)
+        shift = (index >> SUB_BUCKET_BITS) - 1;
+    const uint32_t top = index - (shift << SUB_BUCKET_BITS);
+    return (uint32_t)((((uint64_t)top + 1) << shift) - 1);
+}
+
+void NvFrameStats::addFrame(const Sample& sample) {
+    m_history[m_historyNext] = sample;
+    m_historyNext = (m_historyNext + 1) % (uint32_t)m_history.size();
+    m_frameCount++;
+
+    for (uint32_t i = 0; i < CHANNEL_COUNT; i++) {
+        const float ms = sample.mTimes[i];
+        if (ms < 0.0f)
+            continue;
+
+        Histogram& hist = m_histograms[i];
+        const double us = ms * 1000.0 + 0.5;
+        hist.mCounts[bucketIndex(us < 4294967295.0 ? (uint32_t)us : 0xffffffffu)]++;
+        if (!hist.mTotal || ms < hist.mMin)
+            hist.mMin = ms;
+        if (!hist.mTotal || ms > hist.mMax)
+            hist.mMax = ms;
+        hist.mTotal++;
+        hist.mSum += ms;
+    }
+}
+
+float NvFrameStats::getPercentile(Channel channel, float percentile) const {
+    const Histogram& hist = m_histograms[channel];
+    if (!hist.mTotal)
+        return 0.0f;
+
+    // Nearest-rank: the rank of the sample we want, counting from 1
+    uint64_t target = (uint64_t)ceil(double(percentile) * 0.01 * hist.mTotal);
+    if (target < 1)
+        target = 1;
+
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+        count += hist.mCounts[i];
+        if (count >= target) {
+            // Report the top of the bucket, but never more than the true max
+            const float ms = bucketHighestValue(i) * 0.001f;
+            return ms < hist.mMax ? ms : hist.mMax;
+        }
+    }
+
+    return hist.mMax;
+}
+
+uint32_t NvFrameStats::getCountAbove(Channel channel, float ms) const {
+    const Histogram& hist = m_histograms[channel];
+    const double us = ms * 1000.0 + 0.5;
+    const uint32_t first = bucketIndex(us < 4294967295.0 ? (uint32_t)us : 0xffffffffu) + 1;
+
+    uint32_t count = 0;
+    for (uint32_t i = first; i < BUCKET_COUNT; i++)
+        count += hist.mCounts[i];
+    return count;
+}
+
+void NvFrameStats::getSummary(Channel channel, Summary& summary) const {
+    const Histogram& hist = m_histograms[channel];
+    summary.mCount = hist.mTotal;
+    summary.mMean = hist.mTotal ? float(hist.mSum / hist.mTotal) : 0.0f;
+    summary.mMin = hist.mMin;
+    summary.mP50 = getPercentile(channel, 50.0f);
+    summary.mP95 = getPercentile(channel, 95.0f);
+    summary.mP99 = getPercentile(channel, 99.0f);
+    summary.mMax = hist.mMax;
+}
+
+uint32_t NvFrameStats::getStutterCount() const {
+    if (!m_histograms[CHANNEL_FRAME].mTotal)
+        return 0;
+    return getCountAbove(CHANNEL_FRAME, STUTTER_FACTOR * getPercentile(CHANNEL_FRAME, 50.0f));
+}
+
+const char* NvFrameStats::getChannelName(Channel channel) {
+    static const char* names[CHANNEL_COUNT] = { "frame", "update", "draw", "gpu" };
+    return names[channel];
+}
+
+void NvFrameStats::writeCSV(std::string& out) const {
+    out += "frame";
+    for (uint32_t c = 0; c < CHANNEL_COUNT; c++)
+        appendf(out, ",%s_ms", getChannelName((Channel)c));
+    out += "\n";
+
+    const uint32_t capacity = (uint32_t)m_history.size();
+    const uint32_t count = m_frameCount < capacity ? m_frameCount : capacity;
+    const uint32_t firstFrame = m_frameCount - count;
+    uint32_t slot = (m_historyNext + capacity - count) % capacity;
+
+    for (uint32_t i = 0; i < count; i++) {
+        const Sample& sample = m_history[slot];
+        appendf(out, "%u", firstFrame + i);
+        for (uint32_t c = 0; c < CHANNEL_COUNT; c++) {
+            // Unavailable values are left empty
+            if (sample.mTimes[c] >= 0.0f)
+                appendf(out, ",%.4f", sample.mTimes[c]);
+            else
+                out += ",";
+        }
+        out += "\n";
+        slot = (slot + 1) % capacity;
+    }
+}
+
+void NvFrameStats::writeJSON(std::string& out, const std::string& config) const {
+    out += "{\n";
+    if (!config.empty())
+        out += "  " + config + ",\n";
+    appendf(out, "  \"frames\": %u,\n", m_frameCount);
+    appendf(out, "  \"stutters\": %u,\n", getStutterCount());
+    appendf(out, "  \"stutterFactor\": %.2f,\n", STUTTER_FACTOR);
+    out += "  \"channels\": {";
+
+    for (uint32_t c = 0; c < CHANNEL_COUNT; c++) {
+        Summary summary;
+        getSummary((Channel)c, summary);
+
+        appendf(out, "%s\n    \"%s\": ", c ? "," : "", getChannelName((Channel)c));
+        if (!summary.mCount) {
+            out += "null";
+            continue;
+        }
+        appendf(out, "{ \"count\": %u, \"meanMs\": %.4f, \"minMs\": %.4f, \"p50Ms\": %.4f, "
+            "\"p95Ms\": %.4f, \"p99Ms\": %.4f, \"maxMs\": %.4f }",
+            summary.mCount, summary.mMean, summary.mMin, summary.mP50,
+            summary.mP95, summary.mP99, summary.mMax);
+    }
+
+    out += "\n  }\n}\n";
+}
+
+static void appendf(std::string& out, const char* fmt, ...) {
+    char buffer[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int32_t len = vsnprintf(buffer, sizeof(buffer), fmt, ap);
+    va_end(ap);
+
+    if (len > 0)
+        out.append(buffer, len < (int32_t)sizeof(buffer) ? len : (int32_t)sizeof(buffer) - 1);
+}
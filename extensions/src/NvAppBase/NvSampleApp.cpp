@@ -34,8 +34,10 @@
 #include "NvAppBase/NvSampleApp.h"
 #include "NV/NvLogs.h"
 #include "NvAppBase/NvFramerateCounter.h"
+#include "NvAppBase/NvFrameStats.h"
 #include "NvAppBase/NvInputTransformer.h"
 #include "NvImage/NvImage.h"
+#include "NvModel/NvModelExt.h"
 #include "NvUI/NvGestureDetector.h"
 #include "NvUI/NvTweakBar.h"
 #include "NV/NvString.h"
@@ -48,6 +50,11 @@
 #include <stdarg.h>
 #include <sstream>
 
+// Two frames of scratch memory, so that data built while one frame is
+// recorded stays valid while the next one is prepared.
+#define FRAME_ARENA_SIZE (1024 * 1024)
+#define FRAME_ARENA_FRAMES 2
+
 NvSampleApp::NvSampleApp() : 
     NvAppBase()
     , mFramerate(0L)
@@ -60,8 +67,16 @@ NvSampleApp::NvSampleApp() :
     , m_desiredHeight(0)
     , mTestMode(false)
     , mTestDuration(0.0f)
+    , mHeadlessFrames(0)
     , mTestRepeatFrames(1)
     , m_testModeIssues(TEST_MODE_ISSUE_NONE)
+    , mFrameArena(NULL)
+    , mJobSystem(NULL)
+    , mTestModeArenaAllocations(0)
+    , mTestModeArenaOverflows(0)
+    , mFrameStats(NULL)
+    , mTestModeUpdateTime(0.0f)
+    , mTestModeDrawTime(0.0f)
     , mEnableInputCallbacks(true)
     , mUseRenderThread(false)
     , mThread(NULL)
@@ -82,6 +97,9 @@ NvSampleApp::NvSampleApp() :
     mAutoRepeatButton = 0; // none yet! :)
     mAutoRepeatTriggered = false;
 
+    mTestModeFrameTimer = createStopWatch();
+    mUpdateTimer = createStopWatch();
+
     const std::vector<std::string>& cmd = getCommandLine();
     std::vector<std::string>::const_iterator iter = cmd.begin();
 
@@ -98,6 +116,13 @@ NvSampleApp::NvSampleApp() :
             std::stringstream(*iter) >> mTestDuration;
             iter++;
             mTestName = (*iter); // both std::string
+        } else if (0 == (*iter).compare("-headless")) {
+            // test mode that runs a fixed number of frames without the driver
+            mTestMode = true;
+            iter++;
+            std::stringstream(*iter) >> mHeadlessFrames;
+            iter++;
+            mTestName = (*iter);
         } else if (0 == (*iter).compare("-repeat")) {
             iter++;
             std::stringstream(*iter) >> mTestRepeatFrames;
@@ -112,7 +137,16 @@ NvSampleApp::NvSampleApp() :
         iter++;
     }
 
+    if (mTestMode)
+        mFrameStats = new NvFrameStats;
+
     nvidia::shdfnd::initializeNamedAllocatorGlobals();
+    mFrameArena = NV_NEW(nvidia::shdfnd::FrameArena)(FRAME_ARENA_SIZE, FRAME_ARENA_FRAMES);
+    nvidia::shdfnd::FrameArena::setCurrent(mFrameArena);
+    mJobSystem = NV_NEW(nvidia::shdfnd::JobSystem)();
+    NvImage::setJobSystem(mJobSystem);
+    // keep preprocessed copies of the OBJ models that samples load
+    Nv::NvModelExt::SetObjCacheDirectory(getDataDirectory());
     mThread = NULL;
     mRenderSync = new nvidia::shdfnd::Sync;
     mMainSync = new nvidia::shdfnd::Sync;
@@ -124,11 +158,22 @@ NvSampleApp::~NvSampleApp()
     delete mFrameTimer;
     delete mEventTickTimer;
     delete mAutoRepeatTimer;
+    delete mTestModeFrameTimer;
+    delete mUpdateTimer;
+    delete mFrameStats;
 
     delete m_transformer;
+
+    Nv::NvModelExt::SetObjCacheDirectory(NULL);
+    NvImage::setJobSystem(NULL);
+    NV_DELETE(mJobSystem);
+    NV_DELETE(mFrameArena);
 }
 
 bool NvSampleApp::baseInitRendering(void) {
+    if (mHeadlessFrames > 0 && !platformBeginHeadless())
+        return false;
+
     if (mUseFBOPair)
         mUseFBOPair = getAppContext()->useOffscreenRendering(m_fboWidth, m_fboHeight);
 
@@ -211,7 +256,14 @@ void NvSampleApp::baseReshape(int32_t w, int32_t h) {
 }
 
 void NvSampleApp::baseUpdate(void) {
-    update();
+    if (mTestMode) {
+        mUpdateTimer->start();
+        update();
+        mUpdateTimer->stop();
+        mTestModeUpdateTime += mUpdateTimer->getTime();
+    } else {
+        update();
+    }
 }
 
 void NvSampleApp::baseDraw(void) {
@@ -748,6 +800,9 @@ void NvSampleApp::renderLoopRenderFrame() {
 
 		getAppContext()->beginFrame();
 
+		if (mTestMode)
+			platformBeginGPUFrameTimer();
+
 		getAppContext()->beginScene();
 		baseDraw();
 
@@ -779,10 +834,22 @@ void NvSampleApp::renderLoopRenderFrame() {
 				m_testModeIssues |= TEST_MODE_FBO_ISSUE;
 		}
 
+		if (mTestMode)
+			platformEndGPUFrameTimer();
+
 		getAppContext()->endFrame();
 
+        // Frame boundary: recycle the scratch memory of the previous frame
+        mFrameArena->nextFrame();
+        if (mTestMode && mTestModeFrames >= 0) {
+            const nvidia::shdfnd::FrameArena::Stats& arenaStats = mFrameArena->getLastFrameStats();
+            mTestModeArenaAllocations += arenaStats.mAllocations + arenaStats.mOverflowAllocations;
+            mTestModeArenaOverflows += arenaStats.mOverflowAllocations;
+        }
+
         mDrawTime->stop();
-        mSumDrawTime += mDrawTime->getTime();
+        mTestModeDrawTime = mDrawTime->getTime();
+        mSumDrawTime += mTestModeDrawTime;
         mDrawTime->reset();
 
         mDrawTimeFrames++;
@@ -807,9 +874,26 @@ void NvSampleApp::renderLoopRenderFrame() {
         if (mTestModeFrames == 0) {
             mTotalTime = 0.0f;
             mTestModeTimer->start();
+            mTestModeFrameTimer->start();
+            mTestModeUpdateTime = 0.0f;
+        } else if (mTestModeFrames > 0) {
+            // Times are recorded in milliseconds; the frame time runs from
+            // the end of the previous frame to the end of this one
+            NvFrameStats::Sample sample;
+            sample.mTimes[NvFrameStats::CHANNEL_FRAME] = mTestModeFrameTimer->getTime() * 1000.0f;
+            sample.mTimes[NvFrameStats::CHANNEL_UPDATE] = mTestModeUpdateTime * 1000.0f;
+            sample.mTimes[NvFrameStats::CHANNEL_DRAW] = mTestModeDrawTime * 1000.0f;
+            float gpuTime;
+            sample.mTimes[NvFrameStats::CHANNEL_GPU] = platformGetGPUFrameTime(gpuTime) ? gpuTime : -1.0f;
+            mFrameStats->addFrame(sample);
+
+            mTestModeFrameTimer->start();
+            mTestModeUpdateTime = 0.0f;
         }
 
-        if (mTotalTime > mTestDuration) {
+        const bool testDone = (mHeadlessFrames > 0) ?
+            (mTestModeFrames >= mHeadlessFrames) : (mTotalTime > mTestDuration);
+        if (testDone) {
             mTestModeTimer->stop();
             double frameRate = mTestModeFrames / mTestModeTimer->getTime();
             logTestResults((float)frameRate, mTestModeFrames);
@@ -1026,6 +1110,12 @@ void NvSampleApp::logTestResults(float frameRate, int32_t frames) {
     LOGI("Test Frame Rate = %lf (frames = %d) (%d x %d)\n", frameRate, frames, m_width, m_height);
     writeLogFile(mTestName, true, "\n%s %lf fps (%d frames) (%d x %d)\n", mTestName.c_str(), 
 		frameRate, frames, m_width, m_height);
+    if (frames > 0) {
+        writeLogFile(mTestName, true, "Frame arena: %.1f allocations per frame, %u overflowed, peak %u of %u bytes\n",
+            double(mTestModeArenaAllocations) / frames, uint32_t(mTestModeArenaOverflows),
+            mFrameArena->getPeakBytes(), mFrameArena->getBytesPerFrame());
+        logFrameStats(frameRate);
+    }
 
     if (m_testModeIssues != TEST_MODE_ISSUE_NONE) {
         writeLogFile(mTestName, true, "\nWARNING - there were potential test mode anomalies\n");
@@ -1038,6 +1128,12 @@ void NvSampleApp::logTestResults(float frameRate, int32_t frames) {
     }
     platformLogTestResults(frameRate, frames);
 
+    // Nothing was rendered in headless mode
+    if (mHeadlessFrames > 0) {
+        writeLogFile(mTestName, true, "Test Complete!");
+        return;
+    }
+
     int32_t w = 1, h = 1;
 
     if (!getAppContext()->readFramebufferRGBX32(NULL, w, h)) {
@@ -1055,3 +1151,54 @@ void NvSampleApp::logTestResults(float frameRate, int32_t frames) {
 
     delete[] data;
 }
+
+static std::string jsonString(const std::string& str) {
+    std::string quoted = "\"";
+    for (size_t i = 0; i < str.size(); i++) {
+        const char c = str[i];
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if ((unsigned char)c >= 0x20) {
+            quoted += c;
+        }
+    }
+    quoted += '"';
+    return quoted;
+}
+
+void NvSampleApp::logFrameStats(float frameRate) {
+    for (uint32_t c = 0; c < NvFrameStats::CHANNEL_COUNT; c++) {
+        NvFrameStats::Summary summary;
+        mFrameStats->getSummary((NvFrameStats::Channel)c, summary);
+        if (!summary.mCount)
+            continue;
+        writeLogFile(mTestName, true, "%-6s ms: mean %.3f, p50 %.3f, p95 %.3f, p99 %.3f, max %.3f",
+            NvFrameStats::getChannelName((NvFrameStats::Channel)c),
+            summary.mMean, summary.mP50, summary.mP95, summary.mP99, summary.mMax);
+    }
+    writeLogFile(mTestName, true, "Stutters: %u frames over %.1fx the median frame time\n",
+        mFrameStats->getStutterCount(), NvFrameStats::STUTTER_FACTOR);
+
+    // Machine-readable copies: every frame as CSV and the summary as JSON,
+    // tagged with the run configuration so results can be compared
+    std::stringstream config;
+    config << "\"name\": " << jsonString(mTestName)
+        << ", \"title\": " << jsonString(getAppTitle())
+        << ", \"width\": " << m_width
+        << ", \"height\": " << m_height
+        << ", \"offscreen\": " << (mUseFBOPair ? "true" : "false")
+        << ", \"repeatFrames\": " << mTestRepeatFrames
+        << ", \"durationSeconds\": " << mTestDuration
+        << ", \"headlessFrames\": " << mHeadlessFrames
+        << ", \"warmupFrames\": " << TESTMODE_WARMUP_FRAMES
+        << ", \"fps\": " << frameRate;
+
+    std::string data;
+    mFrameStats->writeCSV(data);
+    writeDataFile(mTestName + "_frames", "csv", data);
+
+    data.clear();
+    mFrameStats->writeJSON(data, config.str());
+    writeDataFile(mTestName + "_stats", "json", data);
+}
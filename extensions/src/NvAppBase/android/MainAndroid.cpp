@@ -377,6 +377,22 @@ bool NvAppBase::writeLogFile(const std::string& path, bool append, const char* f
     return true;
 }
 
+bool NvAppBase::writeDataFile(const std::string& path, const char* extension, const std::string& data) {
+    std::string filename = std::string(getDataDirectory()) + "/" + path + "." + extension;
+    FILE* fp = fopen(filename.c_str(), "wb");
+    if (!fp)
+        return false;
+
+    bool written = fwrite(data.c_str(), 1, data.size(), fp) == data.size();
+    fclose(fp);
+
+    return written;
+}
+
+const char* NvAppBase::getDataDirectory() {
+    return "/sdcard";
+}
+
 void NvAppBase::forceLinkHack() {
 }
 
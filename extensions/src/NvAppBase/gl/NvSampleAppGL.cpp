@@ -44,6 +44,7 @@
 #include "NvAppBase/NvFramerateCounter.h"
 #include "NvAppBase/NvInputTransformer.h"
 #include "NvImage/NvImage.h"
+#include "NvGLUtils/NvGLRecorder.h"
 #include "NvGLUtils/NvImageGL.h"
 #include "NvGLUtils/NvSimpleFBO.h"
 #include "NvGLUtils/NvTimers.h"
@@ -60,11 +61,17 @@
 
 NvSampleAppGL::NvSampleAppGL() : 
     NvSampleApp()
+    , mGPUFrameTimer(NULL)
+    , mGLRecorder(NULL)
 {
 }
 
 NvSampleAppGL::~NvSampleAppGL() 
 { 
+    delete mGPUFrameTimer;
+#ifdef NV_GL_DISPATCH_SUPPORTED
+    delete mGLRecorder;
+#endif
 }
 
 bool NvSampleAppGL::platformInitRendering(void) {
@@ -74,6 +81,13 @@ bool NvSampleAppGL::platformInitRendering(void) {
 
     NvGPUTimer::globalInit(*getGLContext());
 
+    // Headless runs never reach the GPU, so there is nothing to time there
+    if (mTestMode && !mGLRecorder) {
+        delete mGPUFrameTimer;
+        mGPUFrameTimer = new NvGPUTimer;
+        mGPUFrameTimer->init();
+    }
+
     LOGI("GL_EXTENSIONS =");
 
     // Break the extensions into lines without breaking extensions
@@ -112,6 +126,13 @@ bool NvSampleAppGL::platformInitRendering(void) {
 
     }
 
+    bool hasRGTC = getGLContext()->isExtensionSupported("GL_ARB_texture_compression_rgtc") ||
+        getGLContext()->isExtensionSupported("GL_EXT_texture_compression_rgtc");
+    if (!hasRGTC) {
+        LOGI("Device has no RGTC texture support - enabling RGTC expansion");
+        NvImage::setRGTCExpansion(true);
+    }
+
 	return true;
 }
 
@@ -176,6 +197,81 @@ void NvSampleAppGL::platformLogTestResults(float frameRate, int32_t frames) {
                 "\tThe application should be checked for glBindFramebuffer of 0\n\n");
         }
     }
+
+#ifdef NV_GL_DISPATCH_SUPPORTED
+    if (mGLRecorder) {
+        std::string report;
+        mGLRecorder->writeReport(report);
+        writeLogFile(mTestName, true, "\nHeadless GL calls\n%s", report.c_str());
+
+        report.clear();
+        mGLRecorder->writeEntryCSV(report);
+        writeDataFile(mTestName + "_glcalls", "csv", report);
+    }
+#endif
+}
+
+void NvSampleAppGL::platformShutdownRendering(void) {
+    // The queries go away with the context
+    delete mGPUFrameTimer;
+    mGPUFrameTimer = NULL;
+}
+
+void NvSampleAppGL::platformBeginGPUFrameTimer(void) {
+#ifdef NV_GL_DISPATCH_SUPPORTED
+    if (mGLRecorder)
+        mGLRecorder->beginFrame();
+#endif
+    if (mGPUFrameTimer)
+        mGPUFrameTimer->start();
+}
+
+void NvSampleAppGL::platformEndGPUFrameTimer(void) {
+#ifdef NV_GL_DISPATCH_SUPPORTED
+    if (mGLRecorder) {
+        mGLRecorder->endFrame();
+        // Warm-up frames are not part of the results
+        if (mTestModeFrames < 0)
+            mGLRecorder->reset();
+    }
+#endif
+    if (mGPUFrameTimer)
+        mGPUFrameTimer->stop();
+}
+
+bool NvSampleAppGL::platformGetGPUFrameTime(float& ms) {
+    if (!mGPUFrameTimer)
+        return false;
+
+    // Average whatever frames completed since the last query
+    const float elapsed = mGPUFrameTimer->getScaledCycles();
+    const int32_t cycles = mGPUFrameTimer->getStartStopCycles();
+    if (cycles == 0)
+        return false;
+
+    ms = elapsed / cycles;
+    mGPUFrameTimer->reset();
+    return true;
+}
+
+bool NvSampleAppGL::platformBeginHeadless(void) {
+#if !defined(NV_GL_DISPATCH_SUPPORTED)
+    errorExit("Headless mode needs the GL dispatch table, which is only built with GLEW");
+    return false;
+#elif !defined(NV_GL_DISPATCH)
+    // The framework's own GL calls would reach the driver
+    errorExit("Headless mode needs NvAppBase, NvUI, NvGLUtils and the sample built with NV_GL_DISPATCH");
+    return false;
+#else
+    // Rendering may be re-initialized; the recorder stays installed throughout
+    if (!mGLRecorder)
+        mGLRecorder = new NvGLRecorder;
+    if (!mGLRecorder->isInstalled() && !mGLRecorder->install(NvGLRecorder::MODE_HEADLESS)) {
+        errorExit("Could not install the GL recorder for headless mode");
+        return false;
+    }
+    return true;
+#endif
 }
 
 static const int32_t uniqueTypeID = 0x20000001;
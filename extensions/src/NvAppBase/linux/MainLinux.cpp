@@ -381,6 +381,22 @@ bool NvAppBase::writeLogFile(const std::string&, bool, const char*, ...) {
     return false;
 }
 
+bool NvAppBase::writeDataFile(const std::string& path, const char* extension, const std::string& data) {
+    std::string filename = path + "." + extension;
+    FILE* fp = fopen(filename.c_str(), "wb");
+    if (!fp)
+        return false;
+
+    bool written = fwrite(data.c_str(), 1, data.size(), fp) == data.size();
+    fclose(fp);
+
+    return written;
+}
+
+const char* NvAppBase::getDataDirectory() {
+    return ".";
+}
+
 void NvAppBase::forceLinkHack() {
 }
 
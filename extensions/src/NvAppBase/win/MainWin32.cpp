@@ -332,6 +332,23 @@ bool NvAppBase::writeLogFile(const std::string& path, bool append, const char* f
     return true;
 }
 
+bool NvAppBase::writeDataFile(const std::string& path, const char* extension, const std::string& data) {
+    std::string filename = path + "." + extension;
+    FILE* fp = NULL;
+    errno_t errnum = fopen_s(&fp, filename.c_str(), "wb");
+    if (!fp || errnum)
+        return false;
+
+    bool written = fwrite(data.c_str(), 1, data.size(), fp) == data.size();
+
+    fclose(fp);
+    return written;
+}
+
+
+const char* NvAppBase::getDataDirectory() {
+    return ".";
+}
 
 void NvAppBase::forceLinkHack() {
 }
@@ -0,0 +1,348 @@
+//----------------------------------------------------------------------------------
+// File:        NvAssetLoader/NvAssetLoaderAsync.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvAssetLoader/NvAssetLoader.h"
+#include "NvAssetLoaderAsync.h"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Every read is a request.  Until the read completes, a queued or running
+// request belongs to the reader; afterwards it waits for its handle to be
+// waited on or cancelled.  Prefetched requests belong to the prefetch table
+// until they are claimed, at which point they become ordinary requests.
+struct NvAssetReadRequest {
+    enum State {
+        QUEUED,
+        READING,
+        COMPLETE
+    };
+
+    std::string path;
+    NvAssetReadPriority priority;
+    uint64_t sequence;
+    State state;
+    bool cancelled;
+    bool prefetched;
+
+    char* data;
+    int32_t length;
+};
+
+static std::mutex s_asyncMutex;
+static std::condition_variable s_asyncQueueChanged;
+static std::condition_variable s_asyncRequestDone;
+static std::vector<std::thread> s_asyncThreads;
+static std::vector<NvAssetReadRequest*> s_asyncQueue;
+static std::map<std::string, NvAssetReadRequest*> s_prefetched;
+static bool s_asyncStopping = false;
+static uint64_t s_asyncSequence = 0;
+
+static int32_t s_asyncThreadCount = 2;
+static int32_t s_maxBytesInFlight = 64 * 1024 * 1024;
+
+// Bytes of files being read right now, and of completed prefetches nobody has claimed
+static int32_t s_bytesReading = 0;
+static int32_t s_bytesPrefetched = 0;
+
+static void DeleteRequest(NvAssetReadRequest* request)
+{
+    NvAssetLoaderFree(request->data);
+    delete request;
+}
+
+// Picks the next request to read: the oldest of the highest priority.
+// Prefetches wait while unclaimed prefetched data fills the budget
+static std::vector<NvAssetReadRequest*>::iterator NextRequestLocked()
+{
+    std::vector<NvAssetReadRequest*>::iterator best = s_asyncQueue.end();
+    bool prefetchAllowed = s_bytesPrefetched < s_maxBytesInFlight;
+
+    for (std::vector<NvAssetReadRequest*>::iterator it = s_asyncQueue.begin(); it != s_asyncQueue.end(); ++it) {
+        NvAssetReadRequest* request = *it;
+        if (request->prefetched && !prefetchAllowed)
+            continue;
+        if ((best == s_asyncQueue.end()) || (request->priority > (*best)->priority) ||
+            ((request->priority == (*best)->priority) && (request->sequence < (*best)->sequence)))
+            best = it;
+    }
+
+    return best;
+}
+
+// Finishes a request, handing it over to whoever holds it
+static void CompleteRequestLocked(NvAssetReadRequest* request, char* data, int32_t length)
+{
+    request->state = NvAssetReadRequest::COMPLETE;
+    request->data = data;
+    request->length = length;
+
+    if (request->cancelled) {
+        DeleteRequest(request);
+    } else if (request->prefetched && data) {
+        s_bytesPrefetched += length;
+    }
+
+    s_asyncRequestDone.notify_all();
+}
+
+static void AsyncReadThread()
+{
+    std::unique_lock<std::mutex> lock(s_asyncMutex);
+
+    while (true) {
+        std::vector<NvAssetReadRequest*>::iterator next;
+        while (!s_asyncStopping && ((next = NextRequestLocked()) == s_asyncQueue.end()))
+            s_asyncQueueChanged.wait(lock);
+
+        if (s_asyncStopping)
+            break;
+
+        NvAssetReadRequest* request = *next;
+        s_asyncQueue.erase(next);
+        request->state = NvAssetReadRequest::READING;
+        std::string path = request->path;
+
+        lock.unlock();
+        NvAssetFilePtr fp = NvAssetLoaderOpenFile(path.c_str());
+        int32_t size = fp ? NvAssetFileGetSize(fp) : 0;
+        lock.lock();
+
+        // Wait for room in the budget, unless nothing else is being read
+        while ((s_bytesReading > 0) && (s_bytesReading + size > s_maxBytesInFlight) && !request->cancelled)
+            s_asyncRequestDone.wait(lock);
+
+        char* data = NULL;
+        if (fp && !request->cancelled) {
+            s_bytesReading += size;
+            lock.unlock();
+
+            data = new char[size + 1];
+            if (NvAssetFileRead(fp, size, data) == size) {
+                data[size] = '\0';
+            } else {
+                delete[] data;
+                data = NULL;
+            }
+
+            lock.lock();
+            s_bytesReading -= size;
+        }
+
+        if (fp) {
+            lock.unlock();
+            NvAssetLoaderCloseFile(fp);
+            lock.lock();
+        }
+
+        CompleteRequestLocked(request, data, size);
+    }
+}
+
+static void StartAsyncThreadsLocked()
+{
+    if (!s_asyncThreads.empty())
+        return;
+
+    s_asyncStopping = false;
+    for (int32_t i = 0; i < s_asyncThreadCount; i++)
+        s_asyncThreads.push_back(std::thread(AsyncReadThread));
+}
+
+static NvAssetReadRequest* QueueRequestLocked(const char* filePath, NvAssetReadPriority priority, bool prefetched)
+{
+    StartAsyncThreadsLocked();
+
+    NvAssetReadRequest* request = new NvAssetReadRequest;
+    request->path = filePath;
+    request->priority = priority;
+    request->sequence = s_asyncSequence++;
+    request->state = NvAssetReadRequest::QUEUED;
+    request->cancelled = false;
+    request->prefetched = prefetched;
+    request->data = NULL;
+    request->length = 0;
+
+    s_asyncQueue.push_back(request);
+    s_asyncQueueChanged.notify_one();
+    return request;
+}
+
+// Takes a request out of the prefetch table so that it can be waited on like any other
+static NvAssetReadRequest* ClaimPrefetchedLocked(const char* filePath, NvAssetReadPriority priority)
+{
+    std::map<std::string, NvAssetReadRequest*>::iterator it = s_prefetched.find(filePath);
+    if (it == s_prefetched.end())
+        return NULL;
+
+    NvAssetReadRequest* request = it->second;
+    s_prefetched.erase(it);
+
+    request->prefetched = false;
+    if (request->state == NvAssetReadRequest::COMPLETE) {
+        if (request->data)
+            s_bytesPrefetched -= request->length;
+    } else if (request->priority < priority) {
+        request->priority = priority;
+    }
+
+    // Claiming may have made room for further prefetches
+    s_asyncQueueChanged.notify_all();
+    return request;
+}
+
+static char* WaitLocked(std::unique_lock<std::mutex>& lock, NvAssetReadRequest* request, int32_t& length)
+{
+    while (request->state != NvAssetReadRequest::COMPLETE)
+        s_asyncRequestDone.wait(lock);
+
+    char* data = request->data;
+    length = request->length;
+    request->data = NULL;
+    DeleteRequest(request);
+    return data;
+}
+
+bool NvAssetLoaderSetAsyncReadLimits(int32_t threadCount, int32_t maxBytesInFlight)
+{
+    if ((threadCount < 1) || (maxBytesInFlight < 1))
+        return false;
+
+    std::lock_guard<std::mutex> lock(s_asyncMutex);
+    s_asyncThreadCount = threadCount;
+    s_maxBytesInFlight = maxBytesInFlight;
+    s_asyncQueueChanged.notify_all();
+    s_asyncRequestDone.notify_all();
+    return true;
+}
+
+NvAssetReadHandle NvAssetLoaderReadAsync(const char* filePath, NvAssetReadPriority priority)
+{
+    std::lock_guard<std::mutex> lock(s_asyncMutex);
+
+    NvAssetReadRequest* request = ClaimPrefetchedLocked(filePath, priority);
+    if (!request)
+        request = QueueRequestLocked(filePath, priority, false);
+    return request;
+}
+
+bool NvAssetLoaderReadAsyncIsComplete(NvAssetReadHandle handle)
+{
+    std::lock_guard<std::mutex> lock(s_asyncMutex);
+    return handle->state == NvAssetReadRequest::COMPLETE;
+}
+
+char *NvAssetLoaderReadAsyncWait(NvAssetReadHandle handle, int32_t &length)
+{
+    std::unique_lock<std::mutex> lock(s_asyncMutex);
+    return WaitLocked(lock, handle, length);
+}
+
+void NvAssetLoaderReadAsyncCancel(NvAssetReadHandle handle)
+{
+    std::lock_guard<std::mutex> lock(s_asyncMutex);
+
+    if (handle->state == NvAssetReadRequest::QUEUED) {
+        for (std::vector<NvAssetReadRequest*>::iterator it = s_asyncQueue.begin(); it != s_asyncQueue.end(); ++it) {
+            if (*it == handle) {
+                s_asyncQueue.erase(it);
+                break;
+            }
+        }
+        DeleteRequest(handle);
+    } else if (handle->state == NvAssetReadRequest::READING) {
+        // The reading thread releases it once the read returns
+        handle->cancelled = true;
+        s_asyncRequestDone.notify_all();
+    } else {
+        DeleteRequest(handle);
+    }
+}
+
+bool NvAssetLoaderPrefetch(const char* const* filePaths, int32_t count, NvAssetReadPriority priority)
+{
+    std::lock_guard<std::mutex> lock(s_asyncMutex);
+
+    for (int32_t i = 0; i < count; i++) {
+        if (s_prefetched.find(filePaths[i]) == s_prefetched.end())
+            s_prefetched[filePaths[i]] = QueueRequestLocked(filePaths[i], priority, true);
+    }
+    return true;
+}
+
+bool NvAssetLoaderClaimPrefetched(const char* filePath, char*& data, int32_t& length)
+{
+    std::unique_lock<std::mutex> lock(s_asyncMutex);
+
+    if (s_prefetched.empty())
+        return false;
+
+    NvAssetReadRequest* request = ClaimPrefetchedLocked(filePath, NV_ASSET_READ_PRIORITY_HIGH);
+    if (!request)
+        return false;
+
+    data = WaitLocked(lock, request, length);
+    return data != NULL;
+}
+
+void NvAssetLoaderShutdownAsync()
+{
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(s_asyncMutex);
+        s_asyncStopping = true;
+        s_asyncThreads.swap(threads);
+        s_asyncQueueChanged.notify_all();
+        s_asyncRequestDone.notify_all();
+    }
+
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+
+    std::lock_guard<std::mutex> lock(s_asyncMutex);
+
+    // Reads that never started fail, so that their handles can still be waited on
+    for (size_t i = 0; i < s_asyncQueue.size(); i++) {
+        if (!s_asyncQueue[i]->prefetched)
+            CompleteRequestLocked(s_asyncQueue[i], NULL, 0);
+    }
+    s_asyncQueue.clear();
+
+    for (std::map<std::string, NvAssetReadRequest*>::iterator it = s_prefetched.begin(); it != s_prefetched.end(); ++it)
+        DeleteRequest(it->second);
+    s_prefetched.clear();
+    s_bytesPrefetched = 0;
+}
@@ -32,13 +32,23 @@
 //
 //----------------------------------------------------------------------------------
 #include "NvAssetLoader/NvAssetLoader.h"
+#include "../NvAssetLoaderAsync.h"
 #include "NV/NvLogs.h"
 #include <string>
+#include <map>
+#include <mutex>
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
 
 static AAssetManager* s_assetManager = NULL;
 
+// Open asset owning each live buffer returned by NvAssetLoaderMap, keyed on
+// the buffer address.  Uncompressed APK entries are mmapped by the asset
+// manager, so the buffer stays valid only while the asset is open.  Assets
+// may be mapped and unmapped from any thread.
+static std::mutex s_mappingMutex;
+static std::map<char*, AAsset*> s_mappings;
+
 bool NvAssetLoaderInit(void* platform)
 {
     if (!platform)
@@ -51,6 +61,9 @@ bool NvAssetLoaderInit(void* platform)
 
 bool NvAssetLoaderShutdown()
 {
+    // the I/O threads may still be opening files
+    NvAssetLoaderShutdownAsync();
+
     s_assetManager = NULL;
     return true;
 }
@@ -65,10 +78,24 @@ bool NvAssetLoaderRemoveSearchPath(const char *)
     return true;
 }
 
+bool NvAssetLoaderEnableIndex(bool)
+{
+    // assets are looked up by the AssetManager
+    return true;
+}
+
+bool NvAssetLoaderInvalidatePathCache()
+{
+    return true;
+}
+
 char *NvAssetLoaderRead(const char *filePath, int32_t &length)
 {
     char *buff = NULL;
 
+    if (NvAssetLoaderClaimPrefetched(filePath, buff, length))
+        return buff;
+
     if (!s_assetManager)
         return NULL;
 
@@ -96,6 +123,54 @@ bool NvAssetLoaderFree(char* asset)
     return true;
 }
 
+char *NvAssetLoaderMap(const char *filePath, int32_t &length)
+{
+    if (!s_assetManager)
+        return NULL;
+
+    AAsset *fileAsset = AAssetManager_open(s_assetManager, filePath, AASSET_MODE_BUFFER);
+
+    if (fileAsset == NULL)
+        return NULL;
+
+    char* buff = (char*)AAsset_getBuffer(fileAsset);
+    if (!buff) {
+        // compressed entries cannot be mapped; fall back to a heap copy
+        AAsset_close(fileAsset);
+        return NvAssetLoaderRead(filePath, length);
+    }
+
+    length = AAsset_getLength(fileAsset);
+    {
+        std::lock_guard<std::mutex> lock(s_mappingMutex);
+        s_mappings[buff] = fileAsset;
+    }
+
+    LOGI("Mapped asset '%s', %d bytes", filePath, length);
+
+    return buff;
+}
+
+bool NvAssetLoaderUnmap(char* asset)
+{
+    AAsset* fileAsset = NULL;
+    {
+        std::lock_guard<std::mutex> lock(s_mappingMutex);
+        std::map<char*, AAsset*>::iterator it = s_mappings.find(asset);
+        if (it != s_mappings.end())
+        {
+            fileAsset = it->second;
+            s_mappings.erase(it);
+        }
+    }
+
+    if (!fileAsset)
+        return NvAssetLoaderFree(asset);
+
+    AAsset_close(fileAsset);
+    return true;
+}
+
 bool NvAssetLoaderFileExists(const char *filePath) {
     NvAssetFilePtr fp = NvAssetLoaderOpenFile(filePath);
     if (fp != NULL) {
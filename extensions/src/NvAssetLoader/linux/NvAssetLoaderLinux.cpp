@@ -32,13 +32,265 @@
 //
 //----------------------------------------------------------------------------------
 #include "NvAssetLoader/NvAssetLoader.h"
+#include "../NvAssetLoaderAsync.h"
 #include "NV/NvLogs.h"
 #include <string>
 #include <stdio.h>
+#include <time.h>
 #include <vector>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 static std::vector<std::string> s_searchPath;
 
+// Asset path resolution.  Rather than probing every search path at every level
+// up the directory tree for each asset, the "assets" roots that exist are found
+// once, and each asset's resolved path is remembered.  With the index enabled,
+// every file below the roots is listed up front, and an inotify watch on each
+// directory drops the index when the trees change.
+static std::mutex s_pathMutex;
+static std::vector<std::string> s_assetRoots;
+static bool s_assetRootsValid = false;
+static std::unordered_map<std::string, std::string> s_resolvedPaths;
+static std::unordered_map<std::string, std::string> s_index;
+static bool s_indexEnabled = false;
+static bool s_indexValid = false;
+static int s_indexNotifyFd = -1;
+static double s_indexLastPollTime = 0.0;
+
+// Changes to the trees are noticed no more often than this, so that lookups
+// don't each cost a read of the inotify queue
+static const double INDEX_POLL_INTERVAL = 0.1;
+
+// Symbolic links could otherwise make the index recurse forever
+static const int32_t INDEX_MAX_DEPTH = 32;
+
+// Length of each live mapping returned by NvAssetLoaderMap, keyed on base
+// address; munmap needs the length back.  Assets may be mapped and unmapped
+// from any thread, and s_pathMutex can be held while the index is built, so
+// the table has a lock of its own.
+static std::mutex s_mappingMutex;
+static std::map<char*, size_t> s_mappings;
+
+static double GetMonotonicTime()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static bool IsDirectory(const std::string& path)
+{
+    struct stat st;
+    return (stat(path.c_str(), &st) == 0) && S_ISDIR(st.st_mode);
+}
+
+// Whether an asset name can only be spelled one way, so that its absence from
+// the index means the asset does not exist
+static bool IsCanonicalAssetName(const char* name)
+{
+    if (!*name || (*name == '/'))
+        return false;
+
+    for (const char* segment = name; *segment; ) {
+        const char* end = segment;
+        while (*end && (*end != '/') && (*end != '\\'))
+            end++;
+        size_t length = end - segment;
+        if ((length == 0) || (*end == '\\') ||
+            ((segment[0] == '.') && ((length == 1) || ((length == 2) && (segment[1] == '.')))))
+            return false;
+        segment = *end ? end + 1 : end;
+    }
+    return true;
+}
+
+static void DropIndexLocked()
+{
+    s_index.clear();
+    s_indexValid = false;
+    if (s_indexNotifyFd >= 0) {
+        close(s_indexNotifyFd);
+        s_indexNotifyFd = -1;
+    }
+}
+
+static void InvalidatePathCacheLocked()
+{
+    s_assetRoots.clear();
+    s_assetRootsValid = false;
+    s_resolvedPaths.clear();
+    DropIndexLocked();
+}
+
+static void FindAssetRootsLocked()
+{
+    if (s_assetRootsValid)
+        return;
+
+    // The roots are listed in the order that they were always searched: up
+    // to 10 levels up the hierarchy, each search path and then "assets" itself
+    s_assetRoots.clear();
+    std::string upPath;
+    std::string root;
+    for (int32_t i = 0; i < 10; i++) {
+        std::vector<std::string>::iterator src = s_searchPath.begin();
+        while (src != s_searchPath.end()) {
+            root.assign(upPath);
+            root.append(*src);
+            root.append("/assets/");
+            if (IsDirectory(root))
+                s_assetRoots.push_back(root);
+            src++;
+        }
+
+        root.assign(upPath);
+        root.append("assets/");
+        if (IsDirectory(root))
+            s_assetRoots.push_back(root);
+
+        upPath.append("../");
+    }
+
+    s_assetRootsValid = true;
+}
+
+static void IndexDirectoryLocked(const std::string& root, const std::string& relativeDir, int32_t depth)
+{
+    std::string dirPath = root + relativeDir;
+    DIR* dir = opendir(dirPath.c_str());
+    if (!dir)
+        return;
+
+    if (s_indexNotifyFd >= 0) {
+        inotify_add_watch(s_indexNotifyFd, dirPath.c_str(),
+            IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF);
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        const char* name = entry->d_name;
+        if ((name[0] == '.') && (!name[1] || ((name[1] == '.') && !name[2])))
+            continue;
+
+        std::string relativePath = relativeDir + name;
+        bool isDir = (entry->d_type == DT_DIR);
+        if ((entry->d_type == DT_UNKNOWN) || (entry->d_type == DT_LNK))
+            isDir = IsDirectory(root + relativePath);
+
+        if (isDir) {
+            if (depth < INDEX_MAX_DEPTH)
+                IndexDirectoryLocked(root, relativePath + "/", depth + 1);
+        } else {
+            // An asset in an earlier root hides any of the same name in later ones
+            s_index.insert(std::make_pair(relativePath, root + relativePath));
+        }
+    }
+
+    closedir(dir);
+}
+
+static void BuildIndexLocked()
+{
+    if (s_indexValid)
+        return;
+
+    FindAssetRootsLocked();
+
+    // Without inotify the index still works, but only the explicit
+    // invalidation will notice changes
+    s_indexNotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    s_indexLastPollTime = GetMonotonicTime();
+
+    std::vector<std::string>::iterator root = s_assetRoots.begin();
+    while (root != s_assetRoots.end()) {
+        IndexDirectoryLocked(*root, "", 0);
+        root++;
+    }
+
+    s_indexValid = true;
+}
+
+static void PollIndexChangesLocked()
+{
+    if (s_indexNotifyFd < 0)
+        return;
+
+    double now = GetMonotonicTime();
+    if (now - s_indexLastPollTime < INDEX_POLL_INTERVAL)
+        return;
+    s_indexLastPollTime = now;
+
+    // The events themselves don't matter; any change can add, remove or hide assets
+    char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    if (read(s_indexNotifyFd, events, sizeof(events)) > 0) {
+        DropIndexLocked();
+        s_resolvedPaths.clear();
+    }
+}
+
+// Finds the full path of an asset.  trusted is set if the path comes from the
+// watched index or was just found on disk, rather than from the cache
+static bool ResolveAssetPath(const char* name, std::string& fullPath, bool& trusted)
+{
+    std::lock_guard<std::mutex> lock(s_pathMutex);
+
+    PollIndexChangesLocked();
+
+    if (s_indexEnabled && IsCanonicalAssetName(name)) {
+        BuildIndexLocked();
+        std::unordered_map<std::string, std::string>::iterator it = s_index.find(name);
+        if (it == s_index.end())
+            return false;
+        fullPath = it->second;
+        trusted = (s_indexNotifyFd >= 0);
+        return true;
+    }
+
+    std::unordered_map<std::string, std::string>::iterator it = s_resolvedPaths.find(name);
+    if (it != s_resolvedPaths.end()) {
+        fullPath = it->second;
+        trusted = false;
+        return true;
+    }
+
+    FindAssetRootsLocked();
+
+    std::vector<std::string>::iterator root = s_assetRoots.begin();
+    while (root != s_assetRoots.end()) {
+        fullPath.assign(*root);
+        fullPath.append(name);
+
+#ifdef DEBUG
+        fprintf(stderr, "Trying to open %s\n", fullPath.c_str());
+#endif
+        if (access(fullPath.c_str(), R_OK) == 0) {
+            s_resolvedPaths[name] = fullPath;
+            trusted = true;
+            return true;
+        }
+        root++;
+    }
+
+    return false;
+}
+
+// Forgets a resolved path that turned out to be stale
+static void ForgetAssetPath(const char* name)
+{
+    std::lock_guard<std::mutex> lock(s_pathMutex);
+
+    s_resolvedPaths.erase(name);
+    if (s_index.count(name))
+        DropIndexLocked();
+}
+
 bool NvAssetLoaderInit(void*)
 {
     return true;
@@ -46,12 +298,19 @@ bool NvAssetLoaderInit(void*)
 
 bool NvAssetLoaderShutdown()
 {
+    // the I/O threads may still be opening files
+    NvAssetLoaderShutdownAsync();
+
+    std::lock_guard<std::mutex> lock(s_pathMutex);
     s_searchPath.clear();
+    InvalidatePathCacheLocked();
+    s_indexEnabled = false;
     return true;
 }
 
 bool NvAssetLoaderAddSearchPath(const char *path)
 {
+    std::lock_guard<std::mutex> lock(s_pathMutex);
     std::vector<std::string>::iterator src = s_searchPath.begin();
 
     while (src != s_searchPath.end()) {
@@ -61,16 +320,19 @@ bool NvAssetLoaderAddSearchPath(const char *path)
     }
 
     s_searchPath.push_back(path);
+    InvalidatePathCacheLocked();
     return true;
 }
 
 bool NvAssetLoaderRemoveSearchPath(const char *path)
 {
+    std::lock_guard<std::mutex> lock(s_pathMutex);
     std::vector<std::string>::iterator src = s_searchPath.begin();
 
     while (src != s_searchPath.end()) {
         if (!(*src).compare(path)) {
             s_searchPath.erase(src);
+            InvalidatePathCacheLocked();
             return true;
         }
         src++;
@@ -78,8 +340,28 @@ bool NvAssetLoaderRemoveSearchPath(const char *path)
     return true;
 }
 
+bool NvAssetLoaderEnableIndex(bool enable)
+{
+    std::lock_guard<std::mutex> lock(s_pathMutex);
+    s_indexEnabled = enable;
+    if (!enable)
+        DropIndexLocked();
+    return true;
+}
+
+bool NvAssetLoaderInvalidatePathCache()
+{
+    std::lock_guard<std::mutex> lock(s_pathMutex);
+    InvalidatePathCacheLocked();
+    return true;
+}
+
 char *NvAssetLoaderRead(const char *filePath, int32_t &length)
 {
+    char *data = NULL;
+    if (NvAssetLoaderClaimPrefetched(filePath, data, length))
+        return data;
+
     FILE* fp = (FILE*)NvAssetLoaderOpenFile(filePath);
 
     if (!fp) {
@@ -91,7 +373,7 @@ char *NvAssetLoaderRead(const char *filePath, int32_t &length)
     length = ftell(fp);
     fseek(fp, 0, SEEK_SET);
 
-    char *data = new char[length + 1];
+    data = new char[length + 1];
     fread(data, 1, length, fp);
     data[length] = '\0';
 
@@ -109,49 +391,85 @@ bool NvAssetLoaderFree(char* asset)
     return true;
 }
 
+char *NvAssetLoaderMap(const char *filePath, int32_t &length)
+{
+    FILE* fp = (FILE*)NvAssetLoaderOpenFile(filePath);
+
+    if (!fp) {
+        fprintf(stderr, "Error opening file '%s'\n", filePath);
+        return NULL;
+    }
+
+    int64_t size = NvAssetFileGetSize64(fp);
+    void* base = MAP_FAILED;
+    if (size > 0)
+        base = mmap(NULL, (size_t)size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+
+    // the mapping holds its own reference to the file
+    NvAssetLoaderCloseFile(fp);
+
+    if (base == MAP_FAILED) {
+        // empty files and filesystems that cannot be mapped get a heap copy
+        return NvAssetLoaderRead(filePath, length);
+    }
+
+    length = (int32_t)size;
+    {
+        std::lock_guard<std::mutex> lock(s_mappingMutex);
+        s_mappings[(char*)base] = (size_t)size;
+    }
+
+#ifdef DEBUG
+    fprintf(stderr, "Mapped file '%s', %d bytes\n", filePath, length);
+#endif
+    return (char*)base;
+}
+
+bool NvAssetLoaderUnmap(char* asset)
+{
+    size_t size;
+    {
+        std::lock_guard<std::mutex> lock(s_mappingMutex);
+        std::map<char*, size_t>::iterator it = s_mappings.find(asset);
+        if (it == s_mappings.end())
+            return NvAssetLoaderFree(asset);
+
+        size = it->second;
+        s_mappings.erase(it);
+    }
+
+    return munmap(asset, size) == 0;
+}
+
 bool NvAssetLoaderFileExists(const char *filePath) {
-    NvAssetFilePtr fp = NvAssetLoaderOpenFile(filePath);
-    if (fp != NULL) {
-        NvAssetLoaderCloseFile(fp);
+    std::string fullPath;
+    bool trusted;
+    if (!ResolveAssetPath(filePath, fullPath, trusted))
+        return false;
+
+    if (trusted || (access(fullPath.c_str(), R_OK) == 0))
         return true;
-    }
-    return false;
+
+    // The cached path is stale, so search again
+    ForgetAssetPath(filePath);
+    return ResolveAssetPath(filePath, fullPath, trusted);
 }
 
 NvAssetFilePtr NvAssetLoaderOpenFile(const char* name) {
-    FILE *fp = NULL;
-    // loop N times up the hierarchy, testing at each level
-    std::string upPath;
     std::string fullPath;
-    for (int32_t i = 0; i < 10; i++) {
-        std::vector<std::string>::iterator src = s_searchPath.begin();
-        bool looping = true;
-        while (looping) {
-            fullPath.assign(upPath);  // reset to current upPath.
-            if (src != s_searchPath.end()) {
-                //sprintf_s(fullPath, "%s%s/assets/%s", upPath, *src, filePath);
-                fullPath.append(*src);
-                fullPath.append("/assets/");
-                src++;
-            }
-            else {
-                //sprintf_s(fullPath, "%sassets/%s", upPath, filePath);
-                fullPath.append("assets/");
-                looping = false;
-            }
-            fullPath.append(name);
-
-#ifdef DEBUG
-            fprintf(stderr, "Trying to open %s\n", fullPath.c_str());
-#endif
-            if ((fopen_s(&fp, fullPath.c_str(), "rb") == 0) || (fp != NULL))
-                return (NvAssetFilePtr)fp;
-        }
+    bool trusted;
+    if (!ResolveAssetPath(name, fullPath, trusted))
+        return NULL;
 
-        upPath.append("../");
+    FILE *fp = fopen(fullPath.c_str(), "rb");
+    if (!fp) {
+        // The file has gone since its path was cached, so search again
+        ForgetAssetPath(name);
+        if (ResolveAssetPath(name, fullPath, trusted))
+            fp = fopen(fullPath.c_str(), "rb");
     }
 
-    return NULL;
+    return (NvAssetFilePtr)fp;
 }
 
 void NvAssetLoaderCloseFile(NvAssetFilePtr fp) {
@@ -32,13 +32,26 @@
 //
 //----------------------------------------------------------------------------------
 #include "NvAssetLoader/NvAssetLoader.h"
+#include "../NvAssetLoaderAsync.h"
 #include "NV/NvLogs.h"
 #include <string>
 #include <stdio.h>
 #include <vector>
+#include <map>
+#include <mutex>
+#include <io.h>
+#include <windows.h>
 
+// The async I/O threads open files too, so the search path is locked
+static std::mutex s_pathMutex;
 static std::vector<std::string> s_searchPath;
 
+// File mapping object backing each live view returned by NvAssetLoaderMap,
+// keyed on the view base address.  Assets may be mapped and unmapped from
+// any thread.
+static std::mutex s_mappingMutex;
+static std::map<char*, HANDLE> s_mappings;
+
 bool NvAssetLoaderInit(void*)
 {
     return true;
@@ -46,12 +59,17 @@ bool NvAssetLoaderInit(void*)
 
 bool NvAssetLoaderShutdown()
 {
+    // the I/O threads may still be opening files
+    NvAssetLoaderShutdownAsync();
+
+    std::lock_guard<std::mutex> lock(s_pathMutex);
     s_searchPath.clear();
     return true;
 }
 
 bool NvAssetLoaderAddSearchPath(const char *path)
 {
+    std::lock_guard<std::mutex> lock(s_pathMutex);
     std::vector<std::string>::iterator src = s_searchPath.begin();
 
     while (src != s_searchPath.end()) {
@@ -66,6 +84,7 @@ bool NvAssetLoaderAddSearchPath(const char *path)
 
 bool NvAssetLoaderRemoveSearchPath(const char *path)
 {
+    std::lock_guard<std::mutex> lock(s_pathMutex);
     std::vector<std::string>::iterator src = s_searchPath.begin();
 
     while (src != s_searchPath.end()) {
@@ -78,8 +97,23 @@ bool NvAssetLoaderRemoveSearchPath(const char *path)
     return true;
 }
 
+bool NvAssetLoaderEnableIndex(bool)
+{
+    // paths are not cached on this platform
+    return true;
+}
+
+bool NvAssetLoaderInvalidatePathCache()
+{
+    return true;
+}
+
 char *NvAssetLoaderRead(const char *filePath, int32_t &length)
 {
+    char *data = NULL;
+    if (NvAssetLoaderClaimPrefetched(filePath, data, length))
+        return data;
+
     FILE* fp = (FILE*)NvAssetLoaderOpenFile(filePath);
 
     if (!fp) {
@@ -91,7 +125,7 @@ char *NvAssetLoaderRead(const char *filePath, int32_t &length)
     length = ftell(fp);
     fseek(fp, 0, SEEK_SET);
 
-    char *data = new char [length + 1];
+    data = new char [length + 1];
     fread(data, 1, length, fp);
     data[length] = '\0';
 
@@ -109,6 +143,68 @@ bool NvAssetLoaderFree(char* asset)
     return true;
 }
 
+char *NvAssetLoaderMap(const char *filePath, int32_t &length)
+{
+    FILE* fp = (FILE*)NvAssetLoaderOpenFile(filePath);
+
+    if (!fp) {
+        fprintf(stderr, "Error opening file '%s'\n", filePath);
+        return NULL;
+    }
+
+    int64_t size = NvAssetFileGetSize64(fp);
+    HANDLE mapping = NULL;
+    void* base = NULL;
+    if (size > 0) {
+        HANDLE file = (HANDLE)_get_osfhandle(_fileno(fp));
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping) {
+            base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (!base) {
+                CloseHandle(mapping);
+                mapping = NULL;
+            }
+        }
+    }
+
+    // the mapping object holds its own reference to the file
+    NvAssetLoaderCloseFile(fp);
+
+    if (!base) {
+        // empty files and files that cannot be mapped get a heap copy
+        return NvAssetLoaderRead(filePath, length);
+    }
+
+    length = (int32_t)size;
+    {
+        std::lock_guard<std::mutex> lock(s_mappingMutex);
+        s_mappings[(char*)base] = mapping;
+    }
+
+#ifdef DEBUG
+    fprintf(stderr, "Mapped file '%s', %d bytes\n", filePath, length);
+#endif
+    return (char*)base;
+}
+
+bool NvAssetLoaderUnmap(char* asset)
+{
+    HANDLE mapping;
+    {
+        std::lock_guard<std::mutex> lock(s_mappingMutex);
+        std::map<char*, HANDLE>::iterator it = s_mappings.find(asset);
+        if (it == s_mappings.end())
+            return NvAssetLoaderFree(asset);
+
+        mapping = it->second;
+        s_mappings.erase(it);
+    }
+
+    bool success = UnmapViewOfFile(asset) != 0;
+    CloseHandle(mapping);
+    return success;
+}
+
 bool NvAssetLoaderFileExists(const char *filePath) {
     NvAssetFilePtr fp = NvAssetLoaderOpenFile(filePath);
     if (fp != NULL) {
@@ -119,16 +215,23 @@ bool NvAssetLoaderFileExists(const char *filePath) {
 }
 
 NvAssetFilePtr NvAssetLoaderOpenFile(const char* name) {
+    // probe a copy, so that other threads aren't held up while files are opened
+    std::vector<std::string> searchPath;
+    {
+        std::lock_guard<std::mutex> lock(s_pathMutex);
+        searchPath = s_searchPath;
+    }
+
     FILE *fp = NULL;
     // loop N times up the hierarchy, testing at each level
     std::string upPath;
     std::string fullPath;
     for (int32_t i = 0; i < 10; i++) {
-        std::vector<std::string>::iterator src = s_searchPath.begin();
+        std::vector<std::string>::iterator src = searchPath.begin();
         bool looping = true;
         while (looping) {
             fullPath.assign(upPath);  // reset to current upPath.
-            if (src != s_searchPath.end()) {
+            if (src != searchPath.end()) {
                 //sprintf_s(fullPath, "%s%s/assets/%s", upPath, *src, filePath);
                 fullPath.append(*src);
                 fullPath.append("/assets/");
@@ -0,0 +1,97 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvGLDispatch.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+// The table itself must call the real entry points
+#define NV_GL_DISPATCH_IMPL
+#include "NvGLUtils/NvGLDispatch.h"
+
+static const char* const s_entryNames[NvGLEntry::COUNT] = {
+#define NV_GL_DISPATCH_FUNC(ret, func, formals, actuals) #func,
+#define NV_GL_DISPATCH_FUNC_RET(ret, func, formals, actuals) #func,
+#include "NvGLUtils/NvGLDispatchFuncs.h"
+#undef NV_GL_DISPATCH_FUNC
+#undef NV_GL_DISPATCH_FUNC_RET
+};
+
+const char* NvGLDispatchGetEntryName(NvGLEntry::Enum entry)
+{
+    if (entry < 0 || entry >= NvGLEntry::COUNT)
+        return "unknown";
+    return s_entryNames[entry];
+}
+
+#ifdef NV_GL_DISPATCH_SUPPORTED
+
+// GLEW only fills in its pointers in glewInit, after static initialization,
+// so the default table holds forwarding functions that read them per call
+#define NV_GL_DISPATCH_FUNC(ret, func, formals, actuals) \
+    static ret NvGLForward_ ## func formals { func actuals; }
+#define NV_GL_DISPATCH_FUNC_RET(ret, func, formals, actuals) \
+    static ret NvGLForward_ ## func formals { return func actuals; }
+#include "NvGLUtils/NvGLDispatchFuncs.h"
+#undef NV_GL_DISPATCH_FUNC
+#undef NV_GL_DISPATCH_FUNC_RET
+
+#define NV_GL_DISPATCH_FUNC(ret, func, formals, actuals) NvGLForward_ ## func,
+#define NV_GL_DISPATCH_FUNC_RET(ret, func, formals, actuals) NvGLForward_ ## func,
+
+static const NvGLDispatchTable s_defaultTable = {
+#include "NvGLUtils/NvGLDispatchFuncs.h"
+};
+
+// Same initializer, so that the table is usable before any constructor runs
+NvGLDispatchTable g_nvGLDispatch = {
+#include "NvGLUtils/NvGLDispatchFuncs.h"
+};
+
+#undef NV_GL_DISPATCH_FUNC
+#undef NV_GL_DISPATCH_FUNC_RET
+
+bool NvGLDispatchIsAvailable()
+{
+    return true;
+}
+
+const NvGLDispatchTable& NvGLDispatchGetDefault()
+{
+    return s_defaultTable;
+}
+
+#else
+
+bool NvGLDispatchIsAvailable()
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,939 @@
+//----------------------------------------------------------------------------------
+// File:        NvGLUtils/NvGLRecorder.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+// The recording table forwards to the table it replaced, not to itself
+#define NV_GL_DISPATCH_IMPL
+#include "NvGLUtils/NvGLRecorder.h"
+#include "NV/NvLogs.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef NV_GL_DISPATCH_SUPPORTED
+
+static NvGLRecorder* s_recorder = NULL;
+static NvGLDispatchTable s_next;
+
+// Every argument is stored in a 64-bit slot: integers by value, floats by
+// their bits and pointers by address
+template<typename T> struct NvGLSlot {
+    enum { IS_POINTER = 0 };
+    static uint64_t to(T v) { return (uint64_t)v; }
+    static T from(uint64_t s) { return (T)s; }
+};
+
+template<typename T> struct NvGLSlot<T*> {
+    enum { IS_POINTER = 1 };
+    static uint64_t to(T* v) { return (uint64_t)(size_t)v; }
+    static T* from(uint64_t s) { return (T*)(size_t)s; }
+};
+
+template<> struct NvGLSlot<float> {
+    enum { IS_POINTER = 0 };
+    static uint64_t to(float v) { uint32_t b; memcpy(&b, &v, sizeof(b)); return b; }
+    static float from(uint64_t s) { uint32_t b = (uint32_t)s; float v; memcpy(&v, &b, sizeof(v)); return v; }
+};
+
+template<> struct NvGLSlot<void> {
+    static void from(uint64_t) { }
+};
+
+// One recorded call: packs the arguments, lets the recorder see them and
+// then either forwards the call or returns the recorder's result
+template<typename R, typename... P>
+struct NvGLRecordedCall {
+    NvGLEntry::Enum mEntry;
+    R (*mNext)(P...);
+
+    R operator()(P... args) const {
+        uint64_t slots[] = { NvGLSlot<P>::to(args)..., 0 };
+        uint32_t pointerMask = 0;
+        uint32_t bit = 1;
+        const int expand[] = { 0, (pointerMask |= NvGLSlot<P>::IS_POINTER ? bit : 0, bit <<= 1, 0)... };
+        (void)expand;
+        (void)bit;
+
+        uint64_t result = 0;
+        if (s_recorder->record(mEntry, slots, sizeof...(P), pointerMask, result))
+            return mNext(args...);
+        return NvGLSlot<R>::from(result);
+    }
+};
+
+template<typename R, typename... P>
+static NvGLRecordedCall<R, P...> makeRecordedCall(NvGLEntry::Enum entry, R (*next)(P...))
+{
+    NvGLRecordedCall<R, P...> call = { entry, next };
+    return call;
+}
+
+#define NV_GL_DISPATCH_FUNC(ret, func, formals, actuals) \
+    static ret NvGLRecord_ ## func formals { return makeRecordedCall(NvGLEntry::ID_ ## func, s_next.func ## Proc) actuals; }
+#define NV_GL_DISPATCH_FUNC_RET(ret, func, formals, actuals) \
+    static ret NvGLRecord_ ## func formals { return makeRecordedCall(NvGLEntry::ID_ ## func, s_next.func ## Proc) actuals; }
+#include "NvGLUtils/NvGLDispatchFuncs.h"
+#undef NV_GL_DISPATCH_FUNC
+#undef NV_GL_DISPATCH_FUNC_RET
+
+static const NvGLDispatchTable s_recordTable = {
+#define NV_GL_DISPATCH_FUNC(ret, func, formals, actuals) NvGLRecord_ ## func,
+#define NV_GL_DISPATCH_FUNC_RET(ret, func, formals, actuals) NvGLRecord_ ## func,
+#include "NvGLUtils/NvGLDispatchFuncs.h"
+#undef NV_GL_DISPATCH_FUNC
+#undef NV_GL_DISPATCH_FUNC_RET
+};
+
+// Replay: unpacks the slots back into a call through g_nvGLDispatch
+template<uint32_t... I> struct NvGLIndices { };
+template<uint32_t N, uint32_t... I> struct NvGLMakeIndices : NvGLMakeIndices<N - 1, N - 1, I...> { };
+template<uint32_t... I> struct NvGLMakeIndices<0, I...> { typedef NvGLIndices<I...> Type; };
+
+template<typename R, typename... P, uint32_t... I>
+static void replayCall(R (*func)(P...), const uint64_t* args, NvGLIndices<I...>)
+{
+    (void)args;
+    func(NvGLSlot<P>::from(args[I])...);
+}
+
+template<typename R, typename... P>
+static void replayCall(R (*func)(P...), const uint64_t* args)
+{
+    replayCall(func, args, typename NvGLMakeIndices<sizeof...(P)>::Type());
+}
+
+#define NV_GL_DISPATCH_FUNC(ret, func, formals, actuals) \
+    static void NvGLReplay_ ## func(const uint64_t* args) { replayCall(g_nvGLDispatch.func ## Proc, args); }
+#define NV_GL_DISPATCH_FUNC_RET(ret, func, formals, actuals) \
+    static void NvGLReplay_ ## func(const uint64_t* args) { replayCall(g_nvGLDispatch.func ## Proc, args); }
+#include "NvGLUtils/NvGLDispatchFuncs.h"
+#undef NV_GL_DISPATCH_FUNC
+#undef NV_GL_DISPATCH_FUNC_RET
+
+typedef void (*NvGLReplayFunc)(const uint64_t* args);
+
+static const NvGLReplayFunc s_replayFuncs[NvGLEntry::COUNT] = {
+#define NV_GL_DISPATCH_FUNC(ret, func, formals, actuals) NvGLReplay_ ## func,
+#define NV_GL_DISPATCH_FUNC_RET(ret, func, formals, actuals) NvGLReplay_ ## func,
+#include "NvGLUtils/NvGLDispatchFuncs.h"
+#undef NV_GL_DISPATCH_FUNC
+#undef NV_GL_DISPATCH_FUNC_RET
+};
+
+// Tracked state shared by several entry points (all uniform setters) uses
+// ids past the end of the entry list
+enum {
+    STATE_UNIFORM = NvGLEntry::COUNT,
+    STATE_DRAW_FRAMEBUFFER,
+    STATE_READ_FRAMEBUFFER
+};
+
+static uint64_t stateKey(uint32_t id, uint32_t a = 0, uint32_t b = 0)
+{
+    return ((uint64_t)id << 48) ^ ((uint64_t)(a & 0xffffff) << 24) ^ (b & 0xffffff);
+}
+
+static uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ULL)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static const void* argPointer(uint64_t slot)
+{
+    return (const void*)(size_t)slot;
+}
+
+// Bytes per pixel of a client-side image; row padding is not counted
+static uint32_t pixelBytes(uint32_t format, uint32_t type)
+{
+    switch (type) {
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+        return 2;
+    case GL_UNSIGNED_INT_24_8:
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_10F_11F_11F_REV:
+    case GL_UNSIGNED_INT_5_9_9_9_REV:
+        return 4;
+    case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+        return 8;
+    }
+
+    uint32_t components = 4;
+    switch (format) {
+    case GL_RED:
+    case GL_RED_INTEGER:
+    case GL_ALPHA:
+    case GL_LUMINANCE:
+    case GL_DEPTH_COMPONENT:
+        components = 1;
+        break;
+    case GL_RG:
+    case GL_RG_INTEGER:
+    case GL_LUMINANCE_ALPHA:
+        components = 2;
+        break;
+    case GL_RGB:
+    case GL_BGR:
+    case GL_RGB_INTEGER:
+        components = 3;
+        break;
+    }
+
+    switch (type) {
+    case GL_UNSIGNED_BYTE:
+    case GL_BYTE:
+        return components;
+    case GL_UNSIGNED_SHORT:
+    case GL_SHORT:
+    case GL_HALF_FLOAT:
+        return components * 2;
+    default:
+        return components * 4;
+    }
+}
+
+static uint32_t indexBytes(uint32_t type)
+{
+    return (type == GL_UNSIGNED_BYTE) ? 1 : ((type == GL_UNSIGNED_SHORT) ? 2 : 4);
+}
+
+// Components per element of glUniform*v, and the matrix size of glUniformMatrix*fv
+static uint32_t uniformComponents(NvGLEntry::Enum entry)
+{
+    switch (entry) {
+    case NvGLEntry::ID_glUniform1fv: case NvGLEntry::ID_glUniform1iv: return 1;
+    case NvGLEntry::ID_glUniform2fv: case NvGLEntry::ID_glUniform2iv: return 2;
+    case NvGLEntry::ID_glUniform3fv: case NvGLEntry::ID_glUniform3iv: return 3;
+    case NvGLEntry::ID_glUniform4fv: case NvGLEntry::ID_glUniform4iv: return 4;
+    case NvGLEntry::ID_glUniformMatrix2fv: return 4;
+    case NvGLEntry::ID_glUniformMatrix3fv: return 9;
+    case NvGLEntry::ID_glUniformMatrix4fv: return 16;
+    default: return 0;
+    }
+}
+
+static bool isDraw(NvGLEntry::Enum entry)
+{
+    return entry == NvGLEntry::ID_glDrawArrays || entry == NvGLEntry::ID_glDrawArraysInstanced ||
+        entry == NvGLEntry::ID_glDrawElements || entry == NvGLEntry::ID_glDrawElementsInstanced;
+}
+
+NvGLTrace::NvGLTrace()
+    : mClientArrays(false)
+{
+}
+
+void NvGLTrace::clear()
+{
+    mCalls.clear();
+    mPayload.clear();
+    mClientArrays = false;
+}
+
+bool NvGLTrace::replay() const
+{
+    if (s_recorder && s_recorder->getTrace() == this) {
+        LOGI("NvGLTrace: cannot replay a trace into itself");
+        return false;
+    }
+    if (mClientArrays && !(s_recorder && s_recorder->getMode() == NvGLRecorder::MODE_HEADLESS)) {
+        LOGI("NvGLTrace: trace uses client-side vertex arrays and can only be replayed headless");
+        return false;
+    }
+
+    // Out-parameters (queries, generated names) are written to scratch memory
+    const uint32_t SCRATCH_BYTES = 64 * 1024;
+    std::vector<uint64_t> scratch(SCRATCH_BYTES / sizeof(uint64_t));
+    const uint64_t scratchSlot = (uint64_t)(size_t)&scratch[0];
+
+    for (size_t i = 0; i < mCalls.size(); i++) {
+        const Call& call = mCalls[i];
+        uint64_t args[MAX_ARGS];
+        memcpy(args, call.mArgs, sizeof(args));
+
+        for (uint32_t a = 0; a < call.mArgCount; a++) {
+            if ((call.mPointerMask & (1u << a)) && args[a])
+                args[a] = scratchSlot;
+        }
+
+        switch (call.mEntry) {
+        case NvGLEntry::ID_glGenBuffers:
+        case NvGLEntry::ID_glGenFramebuffers:
+        case NvGLEntry::ID_glGenRenderbuffers:
+        case NvGLEntry::ID_glGenTextures:
+        case NvGLEntry::ID_glGenVertexArrays:
+            args[0] = std::min<uint64_t>(args[0], SCRATCH_BYTES / sizeof(GLuint));
+            break;
+        case NvGLEntry::ID_glGetProgramInfoLog:
+        case NvGLEntry::ID_glGetShaderInfoLog:
+            args[1] = std::min<uint64_t>(args[1], SCRATCH_BYTES);
+            break;
+        case NvGLEntry::ID_glGetActiveUniform:
+            args[2] = std::min<uint64_t>(args[2], SCRATCH_BYTES);
+            break;
+        }
+
+        if (call.mPayloadArg >= 0) {
+            const uint8_t* payload = call.mPayloadSize ? &mPayload[call.mPayloadOffset] : NULL;
+            args[call.mPayloadArg] = (uint64_t)(size_t)payload;
+
+            // Sources are stored concatenated and replayed as one string
+            if (call.mEntry == NvGLEntry::ID_glShaderSource) {
+                args[1] = 1;
+                args[2] = (uint64_t)(size_t)&payload;
+                args[3] = 0;
+            }
+        }
+
+        s_replayFuncs[call.mEntry](args);
+    }
+    return true;
+}
+
+NvGLRecorder::NvGLRecorder()
+    : mMode(MODE_PASSTHROUGH)
+    , mTrace(NULL)
+    , mProgram(0)
+    , mActiveTexture(0)
+    , mVertexArray(0)
+    , mNextName(0)
+{
+    mViewport[0] = mViewport[1] = mViewport[2] = mViewport[3] = 0;
+    reset();
+}
+
+NvGLRecorder::~NvGLRecorder()
+{
+    uninstall();
+}
+
+bool NvGLRecorder::install(Mode mode)
+{
+    if (s_recorder)
+        return false;
+
+    s_next = g_nvGLDispatch;
+    g_nvGLDispatch = s_recordTable;
+    s_recorder = this;
+    mMode = mode;
+    return true;
+}
+
+void NvGLRecorder::uninstall()
+{
+    if (s_recorder != this)
+        return;
+
+    g_nvGLDispatch = s_next;
+    s_recorder = NULL;
+}
+
+bool NvGLRecorder::isInstalled() const
+{
+    return s_recorder == this;
+}
+
+void NvGLRecorder::reset()
+{
+    memset(mEntryCounts, 0, sizeof(mEntryCounts));
+    mCallCount = 0;
+    mDrawCount = 0;
+    mUploadBytes = 0;
+    mUniformBytes = 0;
+    mRedundantCount = 0;
+
+    mInFrame = false;
+    mFrames = 0;
+    memset(mFrameStart, 0, sizeof(mFrameStart));
+    memset(mFrameSums, 0, sizeof(mFrameSums));
+    mFrameCallsMin = 0;
+    mFrameCallsMax = 0;
+}
+
+void NvGLRecorder::beginFrame()
+{
+    mFrameStart[0] = mCallCount;
+    mFrameStart[1] = mDrawCount;
+    mFrameStart[2] = mUploadBytes + mUniformBytes;
+    mFrameStart[3] = mRedundantCount;
+    mInFrame = true;
+}
+
+void NvGLRecorder::endFrame()
+{
+    if (!mInFrame)
+        return;
+
+    const uint64_t calls = mCallCount - mFrameStart[0];
+    mFrameSums[0] += calls;
+    mFrameSums[1] += mDrawCount - mFrameStart[1];
+    mFrameSums[2] += mUploadBytes + mUniformBytes - mFrameStart[2];
+    mFrameSums[3] += mRedundantCount - mFrameStart[3];
+
+    mFrameCallsMin = mFrames ? std::min(mFrameCallsMin, calls) : calls;
+    mFrameCallsMax = mFrames ? std::max(mFrameCallsMax, calls) : calls;
+    mFrames++;
+    mInFrame = false;
+}
+
+void NvGLRecorder::getFrameSummary(FrameSummary& summary) const
+{
+    const float scale = mFrames ? 1.0f / mFrames : 0.0f;
+    summary.mFrames = mFrames;
+    summary.mCallsMean = mFrameSums[0] * scale;
+    summary.mCallsMin = mFrameCallsMin;
+    summary.mCallsMax = mFrameCallsMax;
+    summary.mDrawsMean = mFrameSums[1] * scale;
+    summary.mUploadBytesMean = mFrameSums[2] * scale;
+    summary.mRedundantMean = mFrameSums[3] * scale;
+}
+
+void NvGLRecorder::writeReport(std::string& out, uint32_t topEntries) const
+{
+    char line[256];
+    FrameSummary frames;
+    getFrameSummary(frames);
+
+    sprintf(line, "GL calls: %llu total, %llu draws, %llu redundant state changes\n",
+        (unsigned long long)mCallCount, (unsigned long long)mDrawCount,
+        (unsigned long long)mRedundantCount);
+    out += line;
+    sprintf(line, "GL uploads: %llu bytes to buffers and textures, %llu bytes of uniforms\n",
+        (unsigned long long)mUploadBytes, (unsigned long long)mUniformBytes);
+    out += line;
+    if (frames.mFrames) {
+        sprintf(line, "Per frame over %u frames: %.1f calls (min %llu, max %llu), %.1f draws, "
+            "%.0f bytes uploaded, %.1f redundant state changes\n",
+            frames.mFrames, frames.mCallsMean, (unsigned long long)frames.mCallsMin,
+            (unsigned long long)frames.mCallsMax, frames.mDrawsMean,
+            frames.mUploadBytesMean, frames.mRedundantMean);
+        out += line;
+    }
+
+    std::vector<std::pair<uint64_t, uint32_t> > entries;
+    for (uint32_t i = 0; i < NvGLEntry::COUNT; i++) {
+        if (mEntryCounts[i])
+            entries.push_back(std::make_pair(mEntryCounts[i], i));
+    }
+    std::sort(entries.rbegin(), entries.rend());
+    if (entries.size() > topEntries)
+        entries.resize(topEntries);
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        sprintf(line, "  %-28s %10llu", NvGLDispatchGetEntryName((NvGLEntry::Enum)entries[i].second),
+            (unsigned long long)entries[i].first);
+        out += line;
+        if (frames.mFrames) {
+            sprintf(line, " (%.1f per frame)", (float)entries[i].first / frames.mFrames);
+            out += line;
+        }
+        out += "\n";
+    }
+}
+
+void NvGLRecorder::writeEntryCSV(std::string& out) const
+{
+    char line[128];
+    out += "entry,calls,per_frame\n";
+    for (uint32_t i = 0; i < NvGLEntry::COUNT; i++) {
+        if (!mEntryCounts[i])
+            continue;
+        sprintf(line, "%s,%llu,%.3f\n", NvGLDispatchGetEntryName((NvGLEntry::Enum)i),
+            (unsigned long long)mEntryCounts[i], mFrames ? (float)mEntryCounts[i] / mFrames : 0.0f);
+        out += line;
+    }
+}
+
+bool NvGLRecorder::trackState(uint64_t key, uint64_t value)
+{
+    std::pair<std::unordered_map<uint64_t, uint64_t>::iterator, bool> it =
+        mState.insert(std::make_pair(key, value));
+    if (!it.second) {
+        if (it.first->second == value) {
+            mRedundantCount++;
+            return true;
+        }
+        it.first->second = value;
+    }
+    return false;
+}
+
+uint32_t NvGLRecorder::boundObject(NvGLEntry::Enum entry, uint32_t a, uint32_t b) const
+{
+    std::unordered_map<uint64_t, uint64_t>::const_iterator it = mState.find(stateKey(entry, a, b));
+    return (it == mState.end()) ? 0 : (uint32_t)it->second;
+}
+
+bool NvGLRecorder::record(NvGLEntry::Enum entry, const uint64_t* args, uint32_t argCount,
+    uint32_t pointerMask, uint64_t& result)
+{
+    mEntryCounts[entry]++;
+    mCallCount++;
+    if (isDraw(entry))
+        mDrawCount++;
+
+    // Traced before the state below changes, since payload sizes and
+    // offsets depend on the buffers bound when the call was made
+    if (mTrace)
+        traceCall(entry, args, argCount, pointerMask);
+
+    const uint32_t a0 = (uint32_t)args[0];
+    const uint32_t a1 = (uint32_t)args[1];
+    const uint32_t elementKey = mVertexArray;
+
+    switch (entry) {
+    // Bindings
+    case NvGLEntry::ID_glUseProgram:
+        trackState(stateKey(entry), a0);
+        mProgram = a0;
+        break;
+    case NvGLEntry::ID_glBindBuffer:
+        // The element array binding belongs to the vertex array object
+        trackState(stateKey(entry, a0, (a0 == GL_ELEMENT_ARRAY_BUFFER) ? elementKey : 0), a1);
+        break;
+    case NvGLEntry::ID_glBindBufferBase:
+        trackState(stateKey(entry, a0, a1), hashBytes(&args[2], sizeof(uint64_t)));
+        mState[stateKey(NvGLEntry::ID_glBindBuffer, a0)] = (uint32_t)args[2];
+        break;
+    case NvGLEntry::ID_glBindBufferRange:
+        trackState(stateKey(NvGLEntry::ID_glBindBufferBase, a0, a1), hashBytes(&args[2], 3 * sizeof(uint64_t)));
+        mState[stateKey(NvGLEntry::ID_glBindBuffer, a0)] = (uint32_t)args[2];
+        break;
+    case NvGLEntry::ID_glActiveTexture:
+        trackState(stateKey(entry), a0);
+        mActiveTexture = a0 - GL_TEXTURE0;
+        break;
+    case NvGLEntry::ID_glBindTexture:
+        trackState(stateKey(entry, mActiveTexture, a0), a1);
+        break;
+    case NvGLEntry::ID_glBindSampler:
+        trackState(stateKey(entry, a0), a1);
+        break;
+    case NvGLEntry::ID_glBindFramebuffer:
+        if (a0 == GL_FRAMEBUFFER) {
+            const bool draw = boundObject((NvGLEntry::Enum)STATE_DRAW_FRAMEBUFFER, 0, 0) == a1 &&
+                mState.count(stateKey(STATE_DRAW_FRAMEBUFFER));
+            const bool read = boundObject((NvGLEntry::Enum)STATE_READ_FRAMEBUFFER, 0, 0) == a1 &&
+                mState.count(stateKey(STATE_READ_FRAMEBUFFER));
+            if (draw && read)
+                mRedundantCount++;
+            mState[stateKey(STATE_DRAW_FRAMEBUFFER)] = a1;
+            mState[stateKey(STATE_READ_FRAMEBUFFER)] = a1;
+        } else {
+            trackState(stateKey((a0 == GL_READ_FRAMEBUFFER) ? STATE_READ_FRAMEBUFFER : STATE_DRAW_FRAMEBUFFER), a1);
+        }
+        break;
+    case NvGLEntry::ID_glBindRenderbuffer:
+        trackState(stateKey(entry, a0), a1);
+        break;
+    case NvGLEntry::ID_glBindVertexArray:
+        trackState(stateKey(entry), a0);
+        mVertexArray = a0;
+        break;
+
+    // Fixed-function state
+    case NvGLEntry::ID_glEnable:
+    case NvGLEntry::ID_glDisable:
+        trackState(stateKey(NvGLEntry::ID_glEnable, a0), entry == NvGLEntry::ID_glEnable);
+        break;
+    case NvGLEntry::ID_glBlendFunc: {
+        const uint64_t separate[4] = { args[0], args[1], args[0], args[1] };
+        trackState(stateKey(NvGLEntry::ID_glBlendFuncSeparate), hashBytes(separate, sizeof(separate)));
+        break;
+    }
+    case NvGLEntry::ID_glBlendFuncSeparate:
+    case NvGLEntry::ID_glBlendEquation:
+    case NvGLEntry::ID_glClearColor:
+    case NvGLEntry::ID_glClearStencil:
+    case NvGLEntry::ID_glColorMask:
+    case NvGLEntry::ID_glCullFace:
+    case NvGLEntry::ID_glDepthFunc:
+    case NvGLEntry::ID_glDepthMask:
+    case NvGLEntry::ID_glFrontFace:
+    case NvGLEntry::ID_glLineWidth:
+    case NvGLEntry::ID_glPolygonOffset:
+    case NvGLEntry::ID_glScissor:
+    case NvGLEntry::ID_glStencilFunc:
+    case NvGLEntry::ID_glStencilMask:
+    case NvGLEntry::ID_glStencilOp:
+        trackState(stateKey(entry), hashBytes(args, argCount * sizeof(uint64_t)));
+        break;
+    case NvGLEntry::ID_glViewport:
+        trackState(stateKey(entry), hashBytes(args, argCount * sizeof(uint64_t)));
+        for (uint32_t i = 0; i < 4; i++)
+            mViewport[i] = (int32_t)args[i];
+        break;
+    case NvGLEntry::ID_glPixelStorei:
+        trackState(stateKey(entry, a0), a1);
+        break;
+    case NvGLEntry::ID_glTexParameteri:
+    case NvGLEntry::ID_glTexParameterf: {
+        const uint32_t texture = boundObject(NvGLEntry::ID_glBindTexture, mActiveTexture, a0);
+        trackState(stateKey(entry, texture, a1), args[2]);
+        break;
+    }
+
+    // Vertex array object state
+    case NvGLEntry::ID_glEnableVertexAttribArray:
+    case NvGLEntry::ID_glDisableVertexAttribArray:
+        trackState(stateKey(NvGLEntry::ID_glEnableVertexAttribArray, a0, mVertexArray),
+            entry == NvGLEntry::ID_glEnableVertexAttribArray);
+        break;
+    case NvGLEntry::ID_glVertexAttribPointer: {
+        const uint64_t buffer = boundObject(NvGLEntry::ID_glBindBuffer, GL_ARRAY_BUFFER, 0);
+        trackState(stateKey(entry, a0, mVertexArray), hashBytes(args, argCount * sizeof(uint64_t),
+            hashBytes(&buffer, sizeof(buffer))));
+        break;
+    }
+    case NvGLEntry::ID_glVertexAttribDivisor:
+        trackState(stateKey(entry, a0, mVertexArray), a1);
+        break;
+
+    // Uploads
+    case NvGLEntry::ID_glBufferData: {
+        const uint32_t buffer = boundObject(NvGLEntry::ID_glBindBuffer, a0,
+            (a0 == GL_ELEMENT_ARRAY_BUFFER) ? elementKey : 0);
+        mBufferSizes[buffer] = args[1];
+        if (args[2])
+            mUploadBytes += args[1];
+        break;
+    }
+    case NvGLEntry::ID_glBufferSubData:
+        mUploadBytes += args[2];
+        break;
+    case NvGLEntry::ID_glMapBuffer:
+        if (a1 != GL_READ_ONLY) {
+            const uint32_t buffer = boundObject(NvGLEntry::ID_glBindBuffer, a0,
+                (a0 == GL_ELEMENT_ARRAY_BUFFER) ? elementKey : 0);
+            mUploadBytes += mBufferSizes[buffer];
+        }
+        break;
+    case NvGLEntry::ID_glMapBufferRange:
+        if (args[3] & GL_MAP_WRITE_BIT)
+            mUploadBytes += args[2];
+        break;
+    case NvGLEntry::ID_glTexImage2D:
+        if (args[8])
+            mUploadBytes += args[3] * args[4] * pixelBytes((uint32_t)args[6], (uint32_t)args[7]);
+        break;
+    case NvGLEntry::ID_glTexSubImage2D:
+        if (args[8])
+            mUploadBytes += args[4] * args[5] * pixelBytes((uint32_t)args[6], (uint32_t)args[7]);
+        break;
+
+    // Uniforms are keyed by program and location, whichever setter is used
+    case NvGLEntry::ID_glUniform1f:
+    case NvGLEntry::ID_glUniform1i:
+    case NvGLEntry::ID_glUniform2f:
+    case NvGLEntry::ID_glUniform2i:
+    case NvGLEntry::ID_glUniform3f:
+    case NvGLEntry::ID_glUniform3i:
+    case NvGLEntry::ID_glUniform4f:
+    case NvGLEntry::ID_glUniform4i:
+        mUniformBytes += (argCount - 1) * 4;
+        trackState(stateKey(STATE_UNIFORM, mProgram, a0),
+            hashBytes(args + 1, (argCount - 1) * sizeof(uint64_t), entry));
+        break;
+    case NvGLEntry::ID_glUniform1fv:
+    case NvGLEntry::ID_glUniform1iv:
+    case NvGLEntry::ID_glUniform2fv:
+    case NvGLEntry::ID_glUniform2iv:
+    case NvGLEntry::ID_glUniform3fv:
+    case NvGLEntry::ID_glUniform3iv:
+    case NvGLEntry::ID_glUniform4fv:
+    case NvGLEntry::ID_glUniform4iv:
+    case NvGLEntry::ID_glUniformMatrix2fv:
+    case NvGLEntry::ID_glUniformMatrix3fv:
+    case NvGLEntry::ID_glUniformMatrix4fv: {
+        const uint32_t size = (int32_t)a1 * uniformComponents(entry) * 4;
+        const void* value = argPointer(args[argCount - 1]);
+        mUniformBytes += size;
+        if (value) {
+            // The transpose flag of the matrix setters is part of the value
+            trackState(stateKey(STATE_UNIFORM, mProgram, a0),
+                hashBytes(value, size, hashBytes(args + 1, (argCount - 2) * sizeof(uint64_t), entry)));
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    if (mMode == MODE_PASSTHROUGH)
+        return true;
+
+    fakeResult(entry, args, result);
+    return false;
+}
+
+void NvGLRecorder::fakeResult(NvGLEntry::Enum entry, const uint64_t* args, uint64_t& result)
+{
+    result = 0;
+
+    switch (entry) {
+    case NvGLEntry::ID_glCreateProgram:
+    case NvGLEntry::ID_glCreateShader:
+        result = ++mNextName;
+        break;
+    case NvGLEntry::ID_glGenBuffers:
+    case NvGLEntry::ID_glGenFramebuffers:
+    case NvGLEntry::ID_glGenRenderbuffers:
+    case NvGLEntry::ID_glGenTextures:
+    case NvGLEntry::ID_glGenVertexArrays: {
+        GLuint* names = (GLuint*)argPointer(args[1]);
+        for (int32_t i = 0; names && i < (int32_t)args[0]; i++)
+            names[i] = ++mNextName;
+        break;
+    }
+    case NvGLEntry::ID_glCheckFramebufferStatus:
+        result = GL_FRAMEBUFFER_COMPLETE;
+        break;
+    case NvGLEntry::ID_glGetString:
+        switch ((uint32_t)args[0]) {
+        case GL_VENDOR: result = (uint64_t)(size_t)"NVIDIA Corporation"; break;
+        case GL_RENDERER: result = (uint64_t)(size_t)"NvGLRecorder (headless)"; break;
+        case GL_VERSION: result = (uint64_t)(size_t)"4.5.0 NvGLRecorder"; break;
+        case GL_SHADING_LANGUAGE_VERSION: result = (uint64_t)(size_t)"4.50 NvGLRecorder"; break;
+        default: result = (uint64_t)(size_t)""; break;
+        }
+        break;
+    case NvGLEntry::ID_glGetIntegerv: {
+        GLint* params = (GLint*)argPointer(args[1]);
+        if (!params)
+            break;
+        switch ((uint32_t)args[0]) {
+        case GL_VIEWPORT:
+            for (uint32_t i = 0; i < 4; i++)
+                params[i] = mViewport[i];
+            break;
+        case GL_CURRENT_PROGRAM: params[0] = mProgram; break;
+        case GL_ACTIVE_TEXTURE: params[0] = GL_TEXTURE0 + mActiveTexture; break;
+        case GL_VERTEX_ARRAY_BINDING: params[0] = mVertexArray; break;
+        case GL_DRAW_FRAMEBUFFER_BINDING: params[0] = boundObject((NvGLEntry::Enum)STATE_DRAW_FRAMEBUFFER, 0, 0); break;
+        case GL_READ_FRAMEBUFFER_BINDING: params[0] = boundObject((NvGLEntry::Enum)STATE_READ_FRAMEBUFFER, 0, 0); break;
+        case GL_ARRAY_BUFFER_BINDING: params[0] = boundObject(NvGLEntry::ID_glBindBuffer, GL_ARRAY_BUFFER, 0); break;
+        case GL_ELEMENT_ARRAY_BUFFER_BINDING:
+            params[0] = boundObject(NvGLEntry::ID_glBindBuffer, GL_ELEMENT_ARRAY_BUFFER, mVertexArray);
+            break;
+        case GL_TEXTURE_BINDING_2D: params[0] = boundObject(NvGLEntry::ID_glBindTexture, mActiveTexture, GL_TEXTURE_2D); break;
+        case GL_MAJOR_VERSION: params[0] = 4; break;
+        case GL_MINOR_VERSION: params[0] = 5; break;
+        default: params[0] = 0; break;
+        }
+        break;
+    }
+    case NvGLEntry::ID_glGetShaderiv:
+    case NvGLEntry::ID_glGetProgramiv: {
+        GLint* param = (GLint*)argPointer(args[2]);
+        if (param) {
+            const uint32_t pname = (uint32_t)args[1];
+            *param = (pname == GL_COMPILE_STATUS || pname == GL_LINK_STATUS || pname == GL_VALIDATE_STATUS)
+                ? GL_TRUE : 0;
+        }
+        break;
+    }
+    case NvGLEntry::ID_glGetShaderInfoLog:
+    case NvGLEntry::ID_glGetProgramInfoLog: {
+        GLsizei* length = (GLsizei*)argPointer(args[2]);
+        GLchar* log = (GLchar*)argPointer(args[3]);
+        if (length)
+            *length = 0;
+        if (log && (int32_t)args[1] > 0)
+            log[0] = 0;
+        break;
+    }
+    case NvGLEntry::ID_glGetActiveUniform: {
+        GLsizei* length = (GLsizei*)argPointer(args[3]);
+        GLint* size = (GLint*)argPointer(args[4]);
+        GLenum* type = (GLenum*)argPointer(args[5]);
+        GLchar* name = (GLchar*)argPointer(args[6]);
+        if (length) *length = 0;
+        if (size) *size = 0;
+        if (type) *type = 0;
+        if (name && (int32_t)args[2] > 0)
+            name[0] = 0;
+        break;
+    }
+    case NvGLEntry::ID_glGetUniformLocation:
+    case NvGLEntry::ID_glGetAttribLocation: {
+        // Stable per program and name, so repeated lookups agree
+        const char* name = (const char*)argPointer(args[1]);
+        const uint32_t program = (uint32_t)args[0];
+        std::pair<std::map<std::pair<uint32_t, std::string>, int32_t>::iterator, bool> it =
+            mLocations.insert(std::make_pair(std::make_pair(program, std::string(name ? name : "")), 0));
+        if (it.second)
+            it.first->second = mNextLocation[program]++;
+        result = (uint64_t)(int64_t)it.first->second;
+        break;
+    }
+    case NvGLEntry::ID_glMapBuffer:
+    case NvGLEntry::ID_glMapBufferRange: {
+        uint64_t size = args[2];
+        if (entry == NvGLEntry::ID_glMapBuffer) {
+            const uint32_t target = (uint32_t)args[0];
+            size = mBufferSizes[boundObject(NvGLEntry::ID_glBindBuffer, target,
+                (target == GL_ELEMENT_ARRAY_BUFFER) ? mVertexArray : 0)];
+        }
+        if (mMapScratch.size() < size)
+            mMapScratch.resize((size_t)size);
+        result = mMapScratch.empty() ? 0 : (uint64_t)(size_t)&mMapScratch[0];
+        break;
+    }
+    case NvGLEntry::ID_glUnmapBuffer:
+        result = GL_TRUE;
+        break;
+    default:
+        break;
+    }
+}
+
+void NvGLRecorder::traceCall(NvGLEntry::Enum entry, const uint64_t* args, uint32_t argCount,
+    uint32_t pointerMask)
+{
+    NvGLTrace::Call call;
+    call.mEntry = (uint16_t)entry;
+    call.mArgCount = (uint8_t)argCount;
+    call.mPayloadArg = -1;
+    call.mPayloadOffset = 0;
+    call.mPayloadSize = 0;
+    memset(call.mArgs, 0, sizeof(call.mArgs));
+    memcpy(call.mArgs, args, argCount * sizeof(uint64_t));
+
+    const void* payload = NULL;
+    uint64_t size = 0;
+    int32_t payloadArg = -1;
+    std::string sources;
+
+    switch (entry) {
+    case NvGLEntry::ID_glBufferData:
+        payloadArg = 2; size = args[1];
+        break;
+    case NvGLEntry::ID_glBufferSubData:
+        payloadArg = 3; size = args[2];
+        break;
+    case NvGLEntry::ID_glTexImage2D:
+    case NvGLEntry::ID_glTexSubImage2D:
+        // With an unpack buffer bound the pointer is an offset into it
+        if (boundObject(NvGLEntry::ID_glBindBuffer, GL_PIXEL_UNPACK_BUFFER, 0)) {
+            pointerMask &= ~(1u << 8);
+        } else {
+            const uint32_t w = (entry == NvGLEntry::ID_glTexImage2D) ? 3 : 4;
+            payloadArg = 8;
+            size = args[w] * args[w + 1] * pixelBytes((uint32_t)args[6], (uint32_t)args[7]);
+        }
+        break;
+    case NvGLEntry::ID_glDrawElements:
+    case NvGLEntry::ID_glDrawElementsInstanced:
+        if (boundObject(NvGLEntry::ID_glBindBuffer, GL_ELEMENT_ARRAY_BUFFER, mVertexArray)) {
+            pointerMask &= ~(1u << 3);
+        } else {
+            payloadArg = 3;
+            size = (int32_t)args[1] * indexBytes((uint32_t)args[2]);
+        }
+        break;
+    case NvGLEntry::ID_glVertexAttribPointer:
+        // Client-side arrays are read at draw time and cannot be captured here
+        if (!boundObject(NvGLEntry::ID_glBindBuffer, GL_ARRAY_BUFFER, 0) && args[5])
+            mTrace->mClientArrays = true;
+        pointerMask &= ~(1u << 5);
+        break;
+    case NvGLEntry::ID_glDeleteBuffers:
+    case NvGLEntry::ID_glDeleteFramebuffers:
+    case NvGLEntry::ID_glDeleteRenderbuffers:
+    case NvGLEntry::ID_glDeleteTextures:
+    case NvGLEntry::ID_glDeleteVertexArrays:
+    case NvGLEntry::ID_glDrawBuffers:
+        payloadArg = 1; size = (int32_t)args[0] * sizeof(GLuint);
+        break;
+    case NvGLEntry::ID_glClearBufferfv:
+        payloadArg = 2; size = ((uint32_t)args[0] == GL_COLOR) ? 4 * sizeof(GLfloat) : sizeof(GLfloat);
+        break;
+    case NvGLEntry::ID_glGetUniformLocation:
+    case NvGLEntry::ID_glGetAttribLocation:
+    case NvGLEntry::ID_glBindAttribLocation: {
+        payloadArg = (entry == NvGLEntry::ID_glBindAttribLocation) ? 2 : 1;
+        const char* name = (const char*)argPointer(args[payloadArg]);
+        size = name ? strlen(name) + 1 : 0;
+        break;
+    }
+    case NvGLEntry::ID_glShaderSource: {
+        const GLchar* const* strings = (const GLchar* const*)argPointer(args[2]);
+        const GLint* lengths = (const GLint*)argPointer(args[3]);
+        for (int32_t i = 0; strings && i < (int32_t)args[1]; i++) {
+            if (lengths && lengths[i] >= 0)
+                sources.append(strings[i], lengths[i]);
+            else
+                sources.append(strings[i]);
+        }
+        payloadArg = 2;
+        payload = sources.c_str();
+        size = sources.size() + 1;
+        pointerMask &= ~(1u << 3);
+        break;
+    }
+    default: {
+        uint32_t components = uniformComponents(entry);
+        if (components) {
+            payloadArg = argCount - 1;
+            size = (int32_t)args[1] * components * 4;
+        }
+        break;
+    }
+    }
+
+    if (payloadArg >= 0) {
+        if (!payload)
+            payload = argPointer(args[payloadArg]);
+        pointerMask &= ~(1u << payloadArg);
+        if (payload) {
+            call.mPayloadArg = (int8_t)payloadArg;
+            call.mPayloadOffset = (uint32_t)mTrace->mPayload.size();
+            call.mPayloadSize = (uint32_t)size;
+            mTrace->mPayload.insert(mTrace->mPayload.end(), (const uint8_t*)payload,
+                (const uint8_t*)payload + size);
+        }
+    }
+
+    // Any remaining pointers are out-parameters; null ones stay null on replay
+    call.mPointerMask = pointerMask;
+    mTrace->mCalls.push_back(call);
+}
+
+#endif
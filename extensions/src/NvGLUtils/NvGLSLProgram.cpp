@@ -34,6 +34,7 @@
 #include "NvGLUtils/NvGLSLProgram.h"
 #include "NvAssetLoader/NvAssetLoader.h"
 #include "NV/NvLogs.h"
+#include <string.h>
 #include <string>
 
 bool NvGLSLProgram::ms_logAllMissing = false;
@@ -116,6 +117,7 @@ bool NvGLSLProgram::setSourceFromStrings(const char* vertSrc, const char* fragSr
     m_strict = strict;
 
     m_program = compileProgram(vertSrc, fragSrc);
+    reflectUniforms();
 
     return m_program != 0;
 }
@@ -131,6 +133,7 @@ bool NvGLSLProgram::setSourceFromStrings(const char** vertSrcArray, int32_t vert
     m_strict = strict;
 
     m_program = compileProgram(vertSrcArray, vertSrcCount, fragSrcArray, fragSrcCount);
+    reflectUniforms();
 
     return m_program != 0;
 }
@@ -145,6 +148,7 @@ bool NvGLSLProgram::setSourceFromStrings(ShaderSourceItem* src, int32_t count, b
     m_strict = strict;
 
     m_program = compileProgram(src, count);
+    reflectUniforms();
 
     return m_program != 0;
 }
@@ -402,6 +406,9 @@ bool NvGLSLProgram::relink()
         }
         return false;
     }
+
+    // Linking assigns new locations and resets every uniform
+    reflectUniforms();
     return true;
 }
 
@@ -424,9 +431,193 @@ GLint NvGLSLProgram::getAttribLocation(const char* attribute, bool isOptional)
     return result;
 }
 
+// FNV-1a; uniform names are short, so this is cheap next to a GL call
+static uint32_t hashUniformName(const char* name)
+{
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Size of one element of a uniform in 32-bit words, or 0 for types that are
+// not staged (those are always set immediately)
+static uint32_t uniformWords(GLenum type, bool& isFloat)
+{
+    isFloat = true;
+    switch (type) {
+    case GL_FLOAT:          return 1;
+    case GL_FLOAT_VEC2:     return 2;
+    case GL_FLOAT_VEC3:     return 3;
+    case GL_FLOAT_VEC4:     return 4;
+    case GL_FLOAT_MAT2:     return 4;
+    case GL_FLOAT_MAT3:     return 9;
+    case GL_FLOAT_MAT4:     return 16;
+    }
+
+    isFloat = false;
+    switch (type) {
+    case GL_INT:
+    case GL_BOOL:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_CUBE:
+    case 0x8B5F: // GL_SAMPLER_3D
+    case 0x8B62: // GL_SAMPLER_2D_SHADOW
+    case 0x8DC1: // GL_SAMPLER_2D_ARRAY
+    case 0x8DC4: // GL_SAMPLER_2D_ARRAY_SHADOW
+    case 0x8DC5: // GL_SAMPLER_CUBE_SHADOW
+    case 0x8DCA: // GL_INT_SAMPLER_2D
+    case 0x8DD2: // GL_UNSIGNED_INT_SAMPLER_2D
+    case 0x9108: // GL_SAMPLER_2D_MULTISAMPLE
+        return 1;
+    case GL_INT_VEC2:
+    case GL_BOOL_VEC2:
+        return 2;
+    case GL_INT_VEC3:
+    case GL_BOOL_VEC3:
+        return 3;
+    case GL_INT_VEC4:
+    case GL_BOOL_VEC4:
+        return 4;
+    }
+
+    return 0;
+}
+
+// Locations beyond this are looked up by name but never staged
+static const GLint MAX_STAGED_LOCATION = 4096;
+
+void NvGLSLProgram::reflectUniforms()
+{
+    m_uniformNames.clear();
+    m_uniformNameSlots.clear();
+    m_stagedUniforms.clear();
+    m_locationToStaged.clear();
+    m_stagedValues.clear();
+    m_dirtyUniforms.clear();
+
+    if (!m_program)
+        return;
+
+    GLint count = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    if (count <= 0 || maxLength <= 0)
+        return;
+
+    char* name = new char[maxLength + 1];
+
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(m_program, i, maxLength + 1, &length, &size, &type, name);
+        name[length] = 0;
+
+        // Members of uniform blocks have no location
+        GLint location = glGetUniformLocation(m_program, name);
+        if (location < 0)
+            continue;
+
+        addUniformName(name, hashUniformName(name), location);
+
+        // Arrays are reported as "name[0]", but are usually set by their bare name
+        if (length > 3 && !strcmp(name + length - 3, "[0]")) {
+            name[length - 3] = 0;
+            const uint32_t hash = hashUniformName(name);
+            if (findUniformName(name, hash) < 0)
+                addUniformName(name, hash, location);
+        }
+
+        bool isFloat;
+        const uint32_t words = uniformWords(type, isFloat);
+        if (!words || location + size > MAX_STAGED_LOCATION)
+            continue;
+
+        StagedUniform staged;
+        staged.mLocation = location;
+        staged.mType = type;
+        staged.mArraySize = size;
+        staged.mWords = words;
+        staged.mOffset = (uint32_t)m_stagedValues.size();
+        staged.mKnownCount = 0;
+        staged.mDirtyCount = 0;
+        staged.mIsFloat = isFloat;
+        m_stagedValues.resize(m_stagedValues.size() + words * size);
+
+        // Every element location maps to the array, so that setting any one
+        // element immediately invalidates the staged copy
+        if ((GLint)m_locationToStaged.size() < location + size)
+            m_locationToStaged.resize(location + size, -1);
+        for (GLint j = 0; j < size; j++)
+            m_locationToStaged[location + j] = (int32_t)m_stagedUniforms.size();
+
+        m_stagedUniforms.push_back(staged);
+    }
+
+    delete[] name;
+}
+
+int32_t NvGLSLProgram::findUniformName(const char* name, uint32_t hash) const
+{
+    if (m_uniformNameSlots.empty())
+        return -1;
+
+    const uint32_t mask = (uint32_t)m_uniformNameSlots.size() - 1;
+    for (uint32_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+        const int32_t entry = m_uniformNameSlots[slot];
+        if (entry < 0)
+            return -1;
+        if (m_uniformNames[entry].mHash == hash && m_uniformNames[entry].mName == name)
+            return entry;
+    }
+}
+
+void NvGLSLProgram::addUniformName(const std::string& name, uint32_t hash, GLint location)
+{
+    UniformName entry;
+    entry.mName = name;
+    entry.mHash = hash;
+    entry.mLocation = location;
+    m_uniformNames.push_back(entry);
+
+    // Keep the table at most half full; rebuild it when it grows
+    uint32_t slotCount = (uint32_t)m_uniformNameSlots.size();
+    if (m_uniformNames.size() * 2 > slotCount) {
+        slotCount = slotCount ? slotCount * 2 : 32;
+        m_uniformNameSlots.assign(slotCount, -1);
+    } else {
+        slotCount = 0;
+    }
+
+    const uint32_t mask = (uint32_t)m_uniformNameSlots.size() - 1;
+    const uint32_t first = slotCount ? 0 : (uint32_t)m_uniformNames.size() - 1;
+    for (uint32_t i = first; i < m_uniformNames.size(); i++) {
+        uint32_t slot = m_uniformNames[i].mHash & mask;
+        while (m_uniformNameSlots[slot] >= 0)
+            slot = (slot + 1) & mask;
+        m_uniformNameSlots[slot] = (int32_t)i;
+    }
+}
+
 GLint NvGLSLProgram::getUniformLocation(const char* uniform, bool isOptional)
 {
-    GLint result = glGetUniformLocation(m_program, uniform);
+    GLint result;
+
+    const uint32_t hash = hashUniformName(uniform);
+    const int32_t entry = findUniformName(uniform, hash);
+    if (entry >= 0) {
+        result = m_uniformNames[entry].mLocation;
+    } else {
+        // Not an active uniform name; ask GL once and remember the answer,
+        // including -1 for names that do not exist
+        result = glGetUniformLocation(m_program, uniform);
+        if (m_program)
+            addUniformName(uniform, hash, result);
+    }
 
     if (result == -1)
     {
@@ -443,18 +634,101 @@ GLint NvGLSLProgram::getUniformLocation(const char* uniform, bool isOptional)
     return result;
 }
 
+bool NvGLSLProgram::stageUniform(GLint index, const void* value, int32_t count, GLenum type)
+{
+    if (index < 0 || index >= (GLint)m_locationToStaged.size() || count <= 0)
+        return false;
+
+    const int32_t stagedIndex = m_locationToStaged[index];
+    if (stagedIndex < 0)
+        return false;
+
+    // Only the whole uniform, from its first element, and with a matching
+    // call type; integer calls also cover bools and samplers
+    StagedUniform& staged = m_stagedUniforms[stagedIndex];
+    if (staged.mLocation != index || count > staged.mArraySize)
+        return false;
+    if (staged.mType != type && (type != GL_INT || staged.mIsFloat || staged.mWords != 1))
+        return false;
+
+    uint32_t* dest = &m_stagedValues[staged.mOffset];
+    const size_t bytes = count * staged.mWords * sizeof(uint32_t);
+
+    if (!staged.mDirtyCount && count <= staged.mKnownCount && !memcmp(dest, value, bytes))
+        return true;
+
+    memcpy(dest, value, bytes);
+    if (!staged.mDirtyCount)
+        m_dirtyUniforms.push_back(stagedIndex);
+    if (count > staged.mDirtyCount)
+        staged.mDirtyCount = count;
+
+    return true;
+}
+
+void NvGLSLProgram::dropStagedUniform(GLint index)
+{
+    if (index < 0 || index >= (GLint)m_locationToStaged.size())
+        return;
+
+    const int32_t stagedIndex = m_locationToStaged[index];
+    if (stagedIndex >= 0) {
+        // The immediate value wins over anything staged earlier
+        StagedUniform& staged = m_stagedUniforms[stagedIndex];
+        staged.mKnownCount = 0;
+        staged.mDirtyCount = 0;
+    }
+}
+
+void NvGLSLProgram::flushUniforms()
+{
+    for (size_t i = 0; i < m_dirtyUniforms.size(); i++) {
+        StagedUniform& staged = m_stagedUniforms[m_dirtyUniforms[i]];
+        const int32_t count = staged.mDirtyCount;
+        if (!count)
+            continue;
+
+        const GLint loc = staged.mLocation;
+        const uint32_t* value = &m_stagedValues[staged.mOffset];
+        const GLfloat* fvalue = (const GLfloat*)value;
+        const GLint* ivalue = (const GLint*)value;
+
+        switch (staged.mType) {
+        case GL_FLOAT:      glUniform1fv(loc, count, fvalue); break;
+        case GL_FLOAT_VEC2: glUniform2fv(loc, count, fvalue); break;
+        case GL_FLOAT_VEC3: glUniform3fv(loc, count, fvalue); break;
+        case GL_FLOAT_VEC4: glUniform4fv(loc, count, fvalue); break;
+        case GL_FLOAT_MAT2: glUniformMatrix2fv(loc, count, GL_FALSE, fvalue); break;
+        case GL_FLOAT_MAT3: glUniformMatrix3fv(loc, count, GL_FALSE, fvalue); break;
+        case GL_FLOAT_MAT4: glUniformMatrix4fv(loc, count, GL_FALSE, fvalue); break;
+        default:
+            switch (staged.mWords) {
+            case 1: glUniform1iv(loc, count, ivalue); break;
+            case 2: glUniform2iv(loc, count, ivalue); break;
+            case 3: glUniform3iv(loc, count, ivalue); break;
+            case 4: glUniform4iv(loc, count, ivalue); break;
+            }
+            break;
+        }
+
+        if (count > staged.mKnownCount)
+            staged.mKnownCount = count;
+        staged.mDirtyCount = 0;
+    }
+
+    m_dirtyUniforms.clear();
+}
+
 void NvGLSLProgram::bindTexture2D(const char *name, int32_t unit, GLuint tex)
 {
     GLint loc = getUniformLocation(name, false);
-    if (loc >= 0) {
-        glUniform1i(loc, unit);
-        glActiveTexture(GL_TEXTURE0 + unit);
-        glBindTexture(GL_TEXTURE_2D, tex);
-    }
+    if (loc >= 0)
+        bindTexture2D(loc, unit, tex);
 }
 
 void NvGLSLProgram::bindTexture2D(GLint index, int32_t unit, GLuint tex)
 {
+    dropStagedUniform(index);
     glUniform1i(index, unit);
     glActiveTexture(GL_TEXTURE0 + unit);
     glBindTexture(GL_TEXTURE_2D, tex);
@@ -463,15 +737,13 @@ void NvGLSLProgram::bindTexture2D(GLint index, int32_t unit, GLuint tex)
 void NvGLSLProgram::bindTexture2DMultisample(const char *name, int32_t unit, GLuint tex)
 {
     GLint loc = getUniformLocation(name, false);
-    if (loc >= 0) {
-        glUniform1i(loc, unit);
-        glActiveTexture(GL_TEXTURE0 + unit);
-        glBindTexture(0x9100/*GL_TEXTURE_2D_MULTISAMPLE*/, tex);
-    }
+    if (loc >= 0)
+        bindTexture2DMultisample(loc, unit, tex);
 }
 
 void NvGLSLProgram::bindTexture2DMultisample(GLint index, int32_t unit, GLuint tex)
 {
+    dropStagedUniform(index);
     glUniform1i(index, unit);
     glActiveTexture(GL_TEXTURE0 + unit);
     glBindTexture(0x9100/*GL_TEXTURE_2D_MULTISAMPLE*/, tex);
@@ -480,15 +752,13 @@ void NvGLSLProgram::bindTexture2DMultisample(GLint index, int32_t unit, GLuint t
 void NvGLSLProgram::bindTextureRect(const char *name, int32_t unit, GLuint tex)
 {
     GLint loc = getUniformLocation(name, false);
-    if (loc >= 0) {
-        glUniform1i(loc, unit);
-        glActiveTexture(GL_TEXTURE0 + unit);
-        glBindTexture(0x84F5/*GL_TEXTURE_RECT*/, tex);
-    }
+    if (loc >= 0)
+        bindTextureRect(loc, unit, tex);
 }
 
 void NvGLSLProgram::bindTextureRect(GLint index, int32_t unit, GLuint tex)
 {
+    dropStagedUniform(index);
     glUniform1i(index, unit);
     glActiveTexture(GL_TEXTURE0 + unit);
     glBindTexture(0x84F5/*GL_TEXTURE_RECT*/, tex);
@@ -497,15 +767,13 @@ void NvGLSLProgram::bindTextureRect(GLint index, int32_t unit, GLuint tex)
 void NvGLSLProgram::bindTextureArray(const char *name, int32_t unit, GLuint tex)
 {
     GLint loc = getUniformLocation(name, false);
-    if (loc >= 0) {
-        glUniform1i(loc, unit);
-        glActiveTexture(GL_TEXTURE0 + unit);
-        glBindTexture(0x8c1a, tex); // GL_TEXTURE_2D_ARRAY
-    }
+    if (loc >= 0)
+        bindTextureArray(loc, unit, tex);
 }
 
 void NvGLSLProgram::bindTextureArray(GLint index, int32_t unit, GLuint tex)
 {
+    dropStagedUniform(index);
     glUniform1i(index, unit);
     glActiveTexture(GL_TEXTURE0 + unit);
     glBindTexture(0x8c1a, tex); // GL_TEXTURE_2D_ARRAY
@@ -515,16 +783,14 @@ void NvGLSLProgram::bindTextureArray(GLint index, int32_t unit, GLuint tex)
 void
 NvGLSLProgram::setUniform1i(const char *name, int32_t value)
 {
-    GLint loc = getUniformLocation(name, false);
-    if (loc >= 0) {
-        glUniform1i(loc, value);
-    }
+    setUniform1i(getUniformLocation(name, false), value);
 }
 
 void
 NvGLSLProgram::setUniform1i(GLint index, int32_t value)
 {
     if (index >= 0) {
+        dropStagedUniform(index);
         glUniform1i(index, value);
     }
 }
@@ -532,16 +798,14 @@ NvGLSLProgram::setUniform1i(GLint index, int32_t value)
 void
 NvGLSLProgram::setUniform2i(const char *name, int32_t x, int32_t y)
 {
-    GLint loc = getUniformLocation(name, false);
-    if (loc >= 0) {
-        glUniform2i(loc, x, y);
-    }
+    setUniform2i(getUniformLocation(name, false), x, y);
 }
 
 void
 NvGLSLProgram::setUniform2i(GLint index, int32_t x, int32_t y)
 {
     if (index >= 0) {
+        dropStagedUniform(index);
         glUniform2i(index, x, y);
     }
 }
@@ -549,16 +813,14 @@ NvGLSLProgram::setUniform2i(GLint index, int32_t x, int32_t y)
 void
 NvGLSLProgram::setUniform3i(const char *name, int32_t x, int32_t y, int32_t z)
 {
-    GLint loc = getUniformLocation(name, false);
-    if (loc >= 0) {
-        glUniform3i(loc, x, y, z);
-    }
+    setUniform3i(getUniformLocation(name, false), x, y, z);
 }
 
 void
 NvGLSLProgram::setUniform3i(GLint index, int32_t x, int32_t y, int32_t z)
 {
     if (index >= 0) {
+        dropStagedUniform(index);
         glUniform3i(index, x, y, z);
     }
 }
@@ -566,16 +828,14 @@ NvGLSLProgram::setUniform3i(GLint index, int32_t x, int32_t y, int32_t z)
 void
 NvGLSLProgram::setUniform1f(const char *name, float value)
 {
-    GLint loc = getUniformLocation(name, false);
-    if (loc >= 0) {
-        glUniform1f(loc, value);
-    }
+    setUniform1f(getUniformLocation(name, false), value);
 }
 
 void
 NvGLSLProgram::setUniform1f(GLint index, float value)
 {
     if (index >= 0) {
+        dropStagedUniform(index);
         glUniform1f(index, value);
     }
 }
@@ -583,16 +843,14 @@ NvGLSLProgram::setUniform1f(GLint index, float value)
 void
 NvGLSLProgram::setUniform2f(const char *name, float x, float y)
 {
-    GLint loc = getUniformLocation(name, false);
-    if (loc >= 0) {
-        glUniform2f(loc, x, y);
-    }
+    setUniform2f(getUniformLocation(name, false), x, y);
 }
 
 void
 NvGLSLProgram::setUniform2f(GLint index, float x, float y)
 {
     if (index >= 0) {
+        dropStagedUniform(index);
         glUniform2f(index, x, y);
     }
 }
@@ -600,16 +858,14 @@ NvGLSLProgram::setUniform2f(GLint index, float x, float y)
 void
 NvGLSLProgram::setUniform3f(const char *name, float x, float y, float z)
 {
-    GLint loc = getUniformLocation(name, false);
-    if (loc >= 0) {
-        glUniform3f(loc, x, y, z);
-    }
+    setUniform3f(getUniformLocation(name, false), x, y, z);
 }
 
 void
 NvGLSLProgram::setUniform3f(GLint index, float x, float y, float z)
 {
     if (index >= 0) {
+        dropStagedUniform(index);
         glUniform3f(index, x, y, z);
     }
 }
@@ -617,16 +873,14 @@ NvGLSLProgram::setUniform3f(GLint index, float x, float y, float z)
 void
 NvGLSLProgram::setUniform4f(const char *name, float x, float y, float z, float w)
 {
-    GLint loc = getUniformLocation(name, false);
-    if (loc >= 0) {
-        glUniform4f(loc, x, y, z, w);
-    }
+    setUniform4f(getUniformLocation(name, false), x, y, z, w);
 }
 
 void
 NvGLSLProgram::setUniform4f(GLint index, float x, float y, float z, float w)
 {
     if (index >= 0) {
+        dropStagedUniform(index);
         glUniform4f(index, x, y, z, w);
     }
 }
@@ -634,17 +888,14 @@ NvGLSLProgram::setUniform4f(GLint index, float x, float y, float z, float w)
 void
 NvGLSLProgram::setUniform3fv(const char *name, const float *value, int32_t count)
 {
-    GLint loc = getUniformLocation(name, false);
-    if (loc >= 0) {
-        glUniform3fv(loc, count, value);
-    }
-
+    setUniform3fv(getUniformLocation(name, false), value, count);
 }
 
 void
 NvGLSLProgram::setUniform3fv(GLint index, const float *value, int32_t count)
 {
     if (index >= 0) {
+        dropStagedUniform(index);
         glUniform3fv(index, count, value);
     }
 
@@ -653,16 +904,14 @@ NvGLSLProgram::setUniform3fv(GLint index, const float *value, int32_t count)
 void
 NvGLSLProgram::setUniform4fv(const char *name, const float *value, int32_t count)
 {
-    GLint loc = getUniformLocation(name, false);
-    if (loc >= 0) {
-        glUniform4fv(loc, count, value);
-    }
+    setUniform4fv(getUniformLocation(name, false), value, count);
 }
 
 void
 NvGLSLProgram::setUniform4fv(GLint index, const float *value, int32_t count)
 {
     if (index >= 0) {
+        dropStagedUniform(index);
         glUniform4fv(index, count, value);
     }
 }
@@ -670,16 +919,82 @@ NvGLSLProgram::setUniform4fv(GLint index, const float *value, int32_t count)
 void
 NvGLSLProgram::setUniformMatrix4fv(const char *name, float *m, int32_t count, bool transpose)
 {
-    GLint loc = getUniformLocation(name, false);
-    if (loc >= 0) {
-        glUniformMatrix4fv(loc, count, transpose, m);
-    }
+    setUniformMatrix4fv(getUniformLocation(name, false), m, count, transpose);
 }
 
 void
 NvGLSLProgram::setUniformMatrix4fv(GLint index, float *m, int32_t count, bool transpose)
 {
     if (index >= 0) {
+        dropStagedUniform(index);
         glUniformMatrix4fv(index, count, transpose, m);
     }
 }
+
+void
+NvGLSLProgram::stageUniform1i(GLint index, int32_t value)
+{
+    if (!stageUniform(index, &value, 1, GL_INT))
+        setUniform1i(index, value);
+}
+
+void
+NvGLSLProgram::stageUniform1f(GLint index, float value)
+{
+    if (!stageUniform(index, &value, 1, GL_FLOAT))
+        setUniform1f(index, value);
+}
+
+void
+NvGLSLProgram::stageUniform2f(GLint index, float x, float y)
+{
+    const float value[2] = { x, y };
+    if (!stageUniform(index, value, 1, GL_FLOAT_VEC2))
+        setUniform2f(index, x, y);
+}
+
+void
+NvGLSLProgram::stageUniform3f(GLint index, float x, float y, float z)
+{
+    const float value[3] = { x, y, z };
+    if (!stageUniform(index, value, 1, GL_FLOAT_VEC3))
+        setUniform3f(index, x, y, z);
+}
+
+void
+NvGLSLProgram::stageUniform4f(GLint index, float x, float y, float z, float w)
+{
+    const float value[4] = { x, y, z, w };
+    if (!stageUniform(index, value, 1, GL_FLOAT_VEC4))
+        setUniform4f(index, x, y, z, w);
+}
+
+void
+NvGLSLProgram::stageUniform2fv(GLint index, const float *value, int32_t count)
+{
+    if (!stageUniform(index, value, count, GL_FLOAT_VEC2) && index >= 0) {
+        dropStagedUniform(index);
+        glUniform2fv(index, count, value);
+    }
+}
+
+void
+NvGLSLProgram::stageUniform3fv(GLint index, const float *value, int32_t count)
+{
+    if (!stageUniform(index, value, count, GL_FLOAT_VEC3))
+        setUniform3fv(index, value, count);
+}
+
+void
+NvGLSLProgram::stageUniform4fv(GLint index, const float *value, int32_t count)
+{
+    if (!stageUniform(index, value, count, GL_FLOAT_VEC4))
+        setUniform4fv(index, value, count);
+}
+
+void
+NvGLSLProgram::stageUniformMatrix4fv(GLint index, const GLfloat *m, int32_t count)
+{
+    if (!stageUniform(index, m, count, GL_FLOAT_MAT4))
+        setUniformMatrix4fv(index, const_cast<GLfloat*>(m), count, false);
+}
@@ -35,6 +35,7 @@
 #include "NV/NvLogs.h"
 #include "NvGLUtils/NvModelGL.h"
 #include "NvModel/NvModel.h"
+#include "NvAssetLoader/NvAssetLoader.h"
 #include "../NvModel/NvModelObj.h"
 
 #define OFFSET(n) ((char *)NULL + (n))
@@ -80,6 +81,30 @@ NvModelGL* NvModelGL::CreateFromPreprocessed(uint8_t* data) {
 	return modelGL;
 }
 
+static void ReleaseMappedModelData(uint8_t* data) {
+	NvAssetLoaderUnmap((char*)data);
+}
+
+NvModelGL* NvModelGL::CreateFromPreprocessedFile(const char* filename) {
+	int32_t length;
+	char* data = NvAssetLoaderMap(filename, length);
+	if (!data)
+		return NULL;
+
+	NvModel* model = NvModel::CreateFromPreprocessedInPlace((uint8_t*)data, (size_t)length, ReleaseMappedModelData);
+	if (!model) {
+		NvAssetLoaderUnmap(data);
+		return NULL;
+	}
+
+	NvModelGL* modelGL = new NvModelGL;
+	modelGL->model = model;
+	modelGL->computeCenter();
+	modelGL->initBuffers();
+
+	return modelGL;
+}
+
 NvModelGL* NvModelGL::CreateFromModel(NvModel* model) {
 	if (!model)
 		return NULL;
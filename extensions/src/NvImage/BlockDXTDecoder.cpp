@@ -0,0 +1,374 @@
+//----------------------------------------------------------------------------------
+// File:        NvImage/BlockDXTDecoder.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include "BlockDXTDecoder.h"
+
+#include <string.h>
+
+// Define NV_BLOCKDXT_NO_SIMD to build the scalar fallback on any target, as
+// BlockDXTDecoderTest does to check it
+#if defined(NV_BLOCKDXT_NO_SIMD)
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define NV_BLOCKDXT_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define NV_BLOCKDXT_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace nv;
+
+// The decoders below produce bit-identical results to BlockDXT1::decodeBlock and
+// friends, including their palette rounding, but write whole rows of texels
+// straight into the destination rather than going through a ColorBlock.
+
+namespace
+{
+    inline uint16_t readU16(const uint8_t* p)
+    {
+        return uint16_t(p[0] | (p[1] << 8));
+    }
+
+    inline uint32_t readU32(const uint8_t* p)
+    {
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    }
+
+    inline uint64_t readU64(const uint8_t* p)
+    {
+        return uint64_t(readU32(p)) | (uint64_t(readU32(p + 4)) << 32);
+    }
+
+    inline uint32_t packRGBA(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+    {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    /// Same as BlockDXT1::evaluatePalette, packed as RGBA8.
+    void evaluateColorPalette(const uint8_t* block, uint32_t palette[4])
+    {
+        uint16_t col0 = readU16(block);
+        uint16_t col1 = readU16(block + 2);
+
+        uint32_t r0 = (col0 >> 11) & 0x1F, g0 = (col0 >> 5) & 0x3F, b0 = col0 & 0x1F;
+        uint32_t r1 = (col1 >> 11) & 0x1F, g1 = (col1 >> 5) & 0x3F, b1 = col1 & 0x1F;
+        r0 = (r0 << 3) | (r0 >> 2); g0 = (g0 << 2) | (g0 >> 4); b0 = (b0 << 3) | (b0 >> 2);
+        r1 = (r1 << 3) | (r1 >> 2); g1 = (g1 << 2) | (g1 >> 4); b1 = (b1 << 3) | (b1 >> 2);
+
+        palette[0] = packRGBA(r0, g0, b0, 0xFF);
+        palette[1] = packRGBA(r1, g1, b1, 0xFF);
+        if (col0 > col1) {
+            palette[2] = packRGBA((2 * r0 + r1) / 3, (2 * g0 + g1) / 3, (2 * b0 + b1) / 3, 0xFF);
+            palette[3] = packRGBA((2 * r1 + r0) / 3, (2 * g1 + g0) / 3, (2 * b1 + b0) / 3, 0xFF);
+        } else {
+            palette[2] = packRGBA((r0 + r1) / 2, (g0 + g1) / 2, (b0 + b1) / 2, 0xFF);
+            palette[3] = 0;
+        }
+    }
+
+    /// Same as AlphaBlockDXT5::evaluatePalette.
+    void evaluateAlphaPalette(const uint8_t* block, uint8_t palette[8])
+    {
+        uint32_t a0 = block[0];
+        uint32_t a1 = block[1];
+        palette[0] = uint8_t(a0);
+        palette[1] = uint8_t(a1);
+        if (a0 > a1) {
+            palette[2] = uint8_t((6 * a0 + 1 * a1) / 7);
+            palette[3] = uint8_t((5 * a0 + 2 * a1) / 7);
+            palette[4] = uint8_t((4 * a0 + 3 * a1) / 7);
+            palette[5] = uint8_t((3 * a0 + 4 * a1) / 7);
+            palette[6] = uint8_t((2 * a0 + 5 * a1) / 7);
+            palette[7] = uint8_t((1 * a0 + 6 * a1) / 7);
+        } else {
+            palette[2] = uint8_t((4 * a0 + 1 * a1) / 5);
+            palette[3] = uint8_t((3 * a0 + 2 * a1) / 5);
+            palette[4] = uint8_t((2 * a0 + 3 * a1) / 5);
+            palette[5] = uint8_t((1 * a0 + 4 * a1) / 5);
+            palette[6] = 0x00;
+            palette[7] = 0xFF;
+        }
+    }
+
+    /// Decodes the 16 values of a DXT5 alpha / BC4 block.
+    void decodeAlphaBlock(const uint8_t* block, uint8_t values[16])
+    {
+        uint8_t palette[8];
+        evaluateAlphaPalette(block, palette);
+
+        uint64_t bits = readU64(block) >> 16;
+        for (uint32_t i = 0; i < 16; i++) {
+            values[i] = palette[bits & 0x7];
+            bits >>= 3;
+        }
+    }
+
+    /// Decodes the 16 values of a DXT3 alpha block, as AlphaBlockDXT3::decodeBlock.
+    void decodeExplicitAlphaBlock(const uint8_t* block, uint8_t values[16])
+    {
+#if NV_BLOCKDXT_SSE2
+        const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+        __m128i bits = _mm_loadl_epi64((const __m128i*)block);
+        __m128i lo = _mm_and_si128(bits, nibbleMask);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(bits, 4), nibbleMask);
+        __m128i a = _mm_unpacklo_epi8(lo, hi);
+        _mm_storeu_si128((__m128i*)values, _mm_or_si128(a, _mm_slli_epi16(a, 4)));
+#elif NV_BLOCKDXT_NEON
+        uint8x8_t bits = vld1_u8(block);
+        uint8x8x2_t a = vzip_u8(vand_u8(bits, vdup_n_u8(0x0F)), vshr_n_u8(bits, 4));
+        uint8x16_t n = vcombine_u8(a.val[0], a.val[1]);
+        vst1q_u8(values, vorrq_u8(n, vshlq_n_u8(n, 4)));
+#else
+        uint64_t bits = readU64(block);
+        for (uint32_t i = 0; i < 16; i++) {
+            uint8_t a = uint8_t(bits & 0xF);
+            values[i] = uint8_t((a << 4) | a);
+            bits >>= 4;
+        }
+#endif
+    }
+
+    /// Decodes the 16 texels of a DXT1 color block, selecting each texel's
+    /// palette entry four texels at a time where SIMD is available.
+    void decodeColorBlock(const uint8_t* block, uint32_t texels[16])
+    {
+        uint32_t palette[4];
+        evaluateColorPalette(block, palette);
+
+#if NV_BLOCKDXT_SSE2
+        const __m128i laneMask = _mm_setr_epi32(0x03, 0x0C, 0x30, 0xC0);
+        const __m128i index1 = _mm_setr_epi32(0x01, 0x04, 0x10, 0x40);
+        const __m128i index2 = _mm_setr_epi32(0x02, 0x08, 0x20, 0x80);
+        const __m128i p0 = _mm_set1_epi32(int(palette[0]));
+        const __m128i p1 = _mm_set1_epi32(int(palette[1]));
+        const __m128i p2 = _mm_set1_epi32(int(palette[2]));
+        const __m128i p3 = _mm_set1_epi32(int(palette[3]));
+        for (uint32_t y = 0; y < 4; y++) {
+            __m128i idx = _mm_and_si128(_mm_set1_epi32(block[4 + y]), laneMask);
+            __m128i c = _mm_and_si128(_mm_cmpeq_epi32(idx, _mm_setzero_si128()), p0);
+            c = _mm_or_si128(c, _mm_and_si128(_mm_cmpeq_epi32(idx, index1), p1));
+            c = _mm_or_si128(c, _mm_and_si128(_mm_cmpeq_epi32(idx, index2), p2));
+            c = _mm_or_si128(c, _mm_and_si128(_mm_cmpeq_epi32(idx, laneMask), p3));
+            _mm_storeu_si128((__m128i*)(texels + 4 * y), c);
+        }
+#elif NV_BLOCKDXT_NEON
+        static const uint32_t laneMaskBits[4] = { 0x03, 0x0C, 0x30, 0xC0 };
+        static const uint32_t index1Bits[4] = { 0x01, 0x04, 0x10, 0x40 };
+        static const uint32_t index2Bits[4] = { 0x02, 0x08, 0x20, 0x80 };
+        const uint32x4_t laneMask = vld1q_u32(laneMaskBits);
+        const uint32x4_t index1 = vld1q_u32(index1Bits);
+        const uint32x4_t index2 = vld1q_u32(index2Bits);
+        const uint32x4_t p0 = vdupq_n_u32(palette[0]);
+        const uint32x4_t p1 = vdupq_n_u32(palette[1]);
+        const uint32x4_t p2 = vdupq_n_u32(palette[2]);
+        const uint32x4_t p3 = vdupq_n_u32(palette[3]);
+        for (uint32_t y = 0; y < 4; y++) {
+            uint32x4_t idx = vandq_u32(vdupq_n_u32(block[4 + y]), laneMask);
+            uint32x4_t c = vandq_u32(vceqq_u32(idx, vdupq_n_u32(0)), p0);
+            c = vorrq_u32(c, vandq_u32(vceqq_u32(idx, index1), p1));
+            c = vorrq_u32(c, vandq_u32(vceqq_u32(idx, index2), p2));
+            c = vorrq_u32(c, vandq_u32(vceqq_u32(idx, laneMask), p3));
+            vst1q_u32(texels + 4 * y, c);
+        }
+#else
+        uint32_t indices = readU32(block + 4);
+        for (uint32_t i = 0; i < 16; i++) {
+            texels[i] = palette[indices & 0x3];
+            indices >>= 2;
+        }
+#endif
+    }
+
+    /// Replaces the alpha of 16 texels.
+    void mergeAlpha(uint32_t texels[16], const uint8_t alpha[16])
+    {
+#if NV_BLOCKDXT_SSE2
+        const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+        __m128i a = _mm_loadu_si128((const __m128i*)alpha);
+        __m128i zero = _mm_setzero_si128();
+        __m128i lo = _mm_unpacklo_epi8(zero, a);
+        __m128i hi = _mm_unpackhi_epi8(zero, a);
+        __m128i alphas[4] = {
+            _mm_unpacklo_epi16(zero, lo), _mm_unpackhi_epi16(zero, lo),
+            _mm_unpacklo_epi16(zero, hi), _mm_unpackhi_epi16(zero, hi) };
+        for (uint32_t y = 0; y < 4; y++) {
+            __m128i c = _mm_loadu_si128((const __m128i*)(texels + 4 * y));
+            c = _mm_or_si128(_mm_and_si128(c, colorMask), alphas[y]);
+            _mm_storeu_si128((__m128i*)(texels + 4 * y), c);
+        }
+#elif NV_BLOCKDXT_NEON
+        uint8x16_t a = vld1q_u8(alpha);
+        uint16x8_t lo = vshll_n_u8(vget_low_u8(a), 8);
+        uint16x8_t hi = vshll_n_u8(vget_high_u8(a), 8);
+        uint32x4_t alphas[4] = {
+            vshll_n_u16(vget_low_u16(lo), 16), vshll_n_u16(vget_high_u16(lo), 16),
+            vshll_n_u16(vget_low_u16(hi), 16), vshll_n_u16(vget_high_u16(hi), 16) };
+        const uint32x4_t colorMask = vdupq_n_u32(0x00FFFFFF);
+        for (uint32_t y = 0; y < 4; y++) {
+            uint32x4_t c = vld1q_u32(texels + 4 * y);
+            vst1q_u32(texels + 4 * y, vorrq_u32(vandq_u32(c, colorMask), alphas[y]));
+        }
+#else
+        for (uint32_t i = 0; i < 16; i++) {
+            texels[i] = (texels[i] & 0x00FFFFFF) | (uint32_t(alpha[i]) << 24);
+        }
+#endif
+    }
+
+    void decodeBlock(BlockFormat format, const uint8_t* block, uint32_t texels[16])
+    {
+        uint8_t values[16];
+        uint8_t values2[16];
+
+        switch (format) {
+        case BLOCK_FORMAT_DXT1:
+            decodeColorBlock(block, texels);
+            break;
+
+        case BLOCK_FORMAT_DXT3:
+            decodeColorBlock(block + 8, texels);
+            decodeExplicitAlphaBlock(block, values);
+            mergeAlpha(texels, values);
+            break;
+
+        case BLOCK_FORMAT_DXT5:
+            decodeColorBlock(block + 8, texels);
+            decodeAlphaBlock(block, values);
+            mergeAlpha(texels, values);
+            break;
+
+        case BLOCK_FORMAT_BC4_RED:
+            decodeAlphaBlock(block, values);
+            for (uint32_t i = 0; i < 16; i++) {
+                texels[i] = packRGBA(values[i], 0, 0, 0xFF);
+            }
+            break;
+
+        case BLOCK_FORMAT_BC4_LUMINANCE:
+            decodeAlphaBlock(block, values);
+            for (uint32_t i = 0; i < 16; i++) {
+                texels[i] = packRGBA(values[i], values[i], values[i], 0xFF);
+            }
+            break;
+
+        case BLOCK_FORMAT_BC5_RED_GREEN:
+            decodeAlphaBlock(block, values);
+            decodeAlphaBlock(block + 8, values2);
+            for (uint32_t i = 0; i < 16; i++) {
+                texels[i] = packRGBA(values[i], values2[i], 0, 0xFF);
+            }
+            break;
+
+        case BLOCK_FORMAT_BC5_LUMINANCE_ALPHA:
+            decodeAlphaBlock(block, values);
+            decodeAlphaBlock(block + 8, values2);
+            for (uint32_t i = 0; i < 16; i++) {
+                texels[i] = packRGBA(values[i], values[i], values[i], values2[i]);
+            }
+            break;
+        }
+    }
+}
+
+uint32_t nv::blockFormatSize(BlockFormat format)
+{
+    switch (format) {
+    case BLOCK_FORMAT_DXT1:
+    case BLOCK_FORMAT_BC4_RED:
+    case BLOCK_FORMAT_BC4_LUMINANCE:
+        return 8;
+    default:
+        return 16;
+    }
+}
+
+void nv::decodeBlockRow(BlockFormat format, const uint8_t* src, uint32_t blockCount,
+    uint32_t* dest, uint32_t width, uint32_t height, uint32_t pitch)
+{
+    uint32_t blockSize = blockFormatSize(format);
+    uint32_t texels[16];
+
+    for (uint32_t i = blockCount; i-- > 0; ) {
+        // Decode the whole block before writing any of it, since its texels
+        // may overwrite the block itself
+        decodeBlock(format, src + i * blockSize, texels);
+
+        uint32_t x = 4 * i;
+        uint32_t xCount = (width - x < 4) ? (width - x) : 4;
+        uint32_t* row = dest + x;
+        if (xCount == 4) {
+            for (uint32_t y = 0; y < height; y++, row += pitch) {
+                memcpy(row, texels + 4 * y, 4 * sizeof(uint32_t));
+            }
+        } else {
+            for (uint32_t y = 0; y < height; y++, row += pitch) {
+                memcpy(row, texels + 4 * y, xCount * sizeof(uint32_t));
+            }
+        }
+    }
+}
+
+void nv::decodeSurfaceInPlace(BlockFormat format, uint8_t* surf, uint32_t width, uint32_t height, uint32_t depth)
+{
+    uint32_t blockSize = blockFormatSize(format);
+    uint32_t bw = (width + 3) / 4;
+    uint32_t bh = (height + 3) / 4;
+    uint32_t sliceBlockBytes = bw * bh * blockSize;
+    uint32_t sliceTexelBytes = width * height * 4;
+
+    // Decoding from the last block to the first never overwrites a block that
+    // is still to be decoded, as long as each slice of texels is at least as
+    // large as a slice of blocks.  Only 1 and 2 texel wide or high mips of 3D
+    // textures fall short; their few blocks are copied out first.
+    const uint8_t* src = surf;
+    uint8_t* copy = NULL;
+    if ((depth > 1) && (sliceTexelBytes < sliceBlockBytes)) {
+        copy = new uint8_t[sliceBlockBytes * depth];
+        memcpy(copy, surf, sliceBlockBytes * depth);
+        src = copy;
+    }
+
+    for (uint32_t k = depth; k-- > 0; ) {
+        const uint8_t* sliceSrc = src + k * sliceBlockBytes;
+        uint32_t* sliceDest = (uint32_t*)(surf + k * sliceTexelBytes);
+
+        for (uint32_t j = bh; j-- > 0; ) {
+            uint32_t rows = (height - 4 * j < 4) ? (height - 4 * j) : 4;
+            decodeBlockRow(format, sliceSrc + j * bw * blockSize, bw,
+                sliceDest + 4 * j * width, width, rows, width);
+        }
+    }
+
+    delete[] copy;
+}
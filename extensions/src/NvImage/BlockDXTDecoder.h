@@ -0,0 +1,82 @@
+//----------------------------------------------------------------------------------
+// File:        NvImage/BlockDXTDecoder.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_IMAGE_BLOCKDXTDECODER_H
+#define NV_IMAGE_BLOCKDXTDECODER_H
+
+#include <NvSimpleTypes.h>
+
+namespace nv
+{
+    /// Block compressed formats that can be expanded to RGBA8.
+    enum BlockFormat
+    {
+        BLOCK_FORMAT_DXT1,
+        BLOCK_FORMAT_DXT3,
+        BLOCK_FORMAT_DXT5,
+        BLOCK_FORMAT_BC4_RED,               // RGTC1: red, with green and blue 0
+        BLOCK_FORMAT_BC4_LUMINANCE,         // LATC1: luminance replicated to red, green and blue
+        BLOCK_FORMAT_BC5_RED_GREEN,         // RGTC2: red and green, with blue 0
+        BLOCK_FORMAT_BC5_LUMINANCE_ALPHA    // LATC2: luminance replicated to red, green and blue, and alpha
+    };
+
+    /// Size in bytes of a 4x4 block of the given format.
+    uint32_t blockFormatSize(BlockFormat format);
+
+    /// Decodes a row of blocks into the four rows of RGBA8 texels they cover.
+    /// Blocks are decoded from last to first, so the source may overlap the
+    /// destination as long as each block's texels start at or after the block.
+    /// @param format Format of the blocks.
+    /// @param src First block of the row.
+    /// @param blockCount Number of blocks in the row.
+    /// @param dest First texel of the top row of texels covered by the blocks.
+    /// @param width Number of texels in each destination row; the last block
+    /// is clipped to it.
+    /// @param height Number of texel rows to write, at most 4.
+    /// @param pitch Distance in texels between destination rows.
+    void decodeBlockRow(BlockFormat format, const uint8_t* src, uint32_t blockCount,
+        uint32_t* dest, uint32_t width, uint32_t height, uint32_t pitch);
+
+    /// Decodes a surface of blocks to RGBA8 in place.  The blocks must be at
+    /// the start of the surface, which must be large enough to hold the texels.
+    /// @param format Format of the blocks.
+    /// @param surf Surface holding the blocks, and receiving the texels.
+    /// @param width Width of the surface in texels.
+    /// @param height Height of the surface in texels.
+    /// @param depth Number of slices in the surface.
+    void decodeSurfaceInPlace(BlockFormat format, uint8_t* surf, uint32_t width, uint32_t height, uint32_t depth);
+
+} // nv namespace
+
+#endif // NV_IMAGE_BLOCKDXTDECODER_H
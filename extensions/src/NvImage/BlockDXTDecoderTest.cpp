@@ -0,0 +1,344 @@
+//----------------------------------------------------------------------------------
+// File:        NvImage/BlockDXTDecoderTest.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+// Test and benchmark of BlockDXTDecoder.
+//
+// Every format is decoded at a range of sizes, including partial edge blocks,
+// tiny mips and volumes whose slices of texels are smaller than their slices
+// of blocks, and compared texel for texel with the scalar BlockDXT/ColorBlock
+// decoders that expandDXT used before.  The blocks are random, with a share
+// of them given equal endpoints and endpoints in both orders, so both palette
+// modes of DXT1 and the DXT5/BC4 alpha blocks are covered.  Surfaces are
+// decoded in place with decodeSurfaceInPlace, and rows are also decoded with
+// decodeBlockRow into a wider destination, to check that nothing is written
+// outside the clipped blocks.
+//
+// With "bench" as the first argument it instead times both decoders on a
+// 2048x2048 surface of each format, in MB of texels per second.
+//
+// Usage: BlockDXTDecoderTest [bench]
+// Returns 0 if all checks pass.  Besides the Visual Studio project, it builds
+// with, from the extensions directory:
+//   g++ -O2 -DLINUX -DNDEBUG -Iinclude/NvFoundation src/NvImage/BlockDXTDecoderTest.cpp
+//       src/NvImage/BlockDXTDecoder.cpp src/NvImage/BlockDXT.cpp src/NvImage/ColorBlock.cpp
+// Adding -DNV_BLOCKDXT_NO_SIMD checks the scalar fallback of the decoder instead
+// of its SSE2 or NEON code.
+
+#include "BlockDXT.h"
+#include "BlockDXTDecoder.h"
+#include "ColorBlock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+using namespace nv;
+
+namespace
+{
+    const char* const FORMAT_NAMES[] = {
+        "DXT1", "DXT3", "DXT5", "BC4 red", "BC4 luminance", "BC5 red green", "BC5 luminance alpha"
+    };
+    const uint32_t FORMAT_COUNT = sizeof(FORMAT_NAMES) / sizeof(FORMAT_NAMES[0]);
+
+    uint32_t s_seed = 12345;
+
+    uint32_t nextRandom()
+    {
+        s_seed = s_seed * 1664525 + 1013904223;
+        return s_seed >> 8;
+    }
+
+    /// Fills blocks with random bytes.  Every third block gets equal endpoints
+    /// and every other one has its endpoints swapped, for each palette.
+    void makeBlocks(BlockFormat format, uint8_t* blocks, uint32_t blockCount)
+    {
+        uint32_t blockSize = blockFormatSize(format);
+        for (uint32_t i = 0; i < blockCount * blockSize; i++) {
+            blocks[i] = uint8_t(nextRandom());
+        }
+
+        for (uint32_t i = 0; i < blockCount; i++) {
+            // Offsets of the endpoints in each half of the block
+            for (uint32_t half = 0; half < blockSize; half += 8) {
+                uint8_t* block = blocks + i * blockSize + half;
+                bool color = (format == BLOCK_FORMAT_DXT1) ||
+                    (half == 8 && (format == BLOCK_FORMAT_DXT3 || format == BLOCK_FORMAT_DXT5));
+                if (format == BLOCK_FORMAT_DXT3 && half == 0) {
+                    continue;
+                }
+                uint32_t endpointSize = color ? 2 : 1;
+                if (i % 3 == 0) {
+                    memcpy(block + endpointSize, block, endpointSize);
+                } else if (i % 2 == 0) {
+                    uint8_t endpoint[2];
+                    memcpy(endpoint, block, endpointSize);
+                    memcpy(block, block + endpointSize, endpointSize);
+                    memcpy(block + endpointSize, endpoint, endpointSize);
+                }
+            }
+        }
+    }
+
+    /// Decodes one block with the scalar decoders.  BC4 and BC5 channels are
+    /// DXT5 alpha blocks, expanded the way BlockDXTDecoder documents.
+    void referenceDecodeBlock(BlockFormat format, const uint8_t* block, ColorBlock& color)
+    {
+        ColorBlock channel0;
+        ColorBlock channel1;
+
+        switch (format) {
+        case BLOCK_FORMAT_DXT1:
+            reinterpret_cast<const BlockDXT1*>(block)->decodeBlock(&color);
+            return;
+        case BLOCK_FORMAT_DXT3:
+            reinterpret_cast<const BlockDXT3*>(block)->decodeBlock(&color);
+            return;
+        case BLOCK_FORMAT_DXT5:
+            reinterpret_cast<const BlockDXT5*>(block)->decodeBlock(&color);
+            return;
+        default:
+            break;
+        }
+
+        reinterpret_cast<const AlphaBlockDXT5*>(block)->decodeBlock(&channel0);
+        if (blockFormatSize(format) == 16) {
+            reinterpret_cast<const AlphaBlockDXT5*>(block + 8)->decodeBlock(&channel1);
+        }
+        for (uint32_t i = 0; i < 16; i++) {
+            uint8_t v0 = channel0.color(i).a;
+            uint8_t v1 = channel1.color(i).a;
+            switch (format) {
+            case BLOCK_FORMAT_BC4_RED:
+                color.color(i).setRGBA(v0, 0, 0, 0xFF);
+                break;
+            case BLOCK_FORMAT_BC4_LUMINANCE:
+                color.color(i).setRGBA(v0, v0, v0, 0xFF);
+                break;
+            case BLOCK_FORMAT_BC5_RED_GREEN:
+                color.color(i).setRGBA(v0, v1, 0, 0xFF);
+                break;
+            default:
+                color.color(i).setRGBA(v0, v0, v0, v1);
+                break;
+            }
+        }
+    }
+
+    /// Decodes a surface block by block into separate texels, as expandDXT did.
+    void referenceDecodeSurface(BlockFormat format, const uint8_t* src, uint32_t* dest,
+        uint32_t width, uint32_t height, uint32_t depth)
+    {
+        uint32_t blockSize = blockFormatSize(format);
+        uint32_t bw = (width + 3) / 4;
+        uint32_t bh = (height + 3) / 4;
+
+        for (uint32_t k = 0; k < depth; k++) {
+            uint32_t* plane = dest + k * width * height;
+            for (uint32_t j = 0; j < bh; j++) {
+                for (uint32_t i = 0; i < bw; i++, src += blockSize) {
+                    ColorBlock color;
+                    referenceDecodeBlock(format, src, color);
+                    for (uint32_t y = 0; (y < 4) && (4 * j + y < height); y++) {
+                        for (uint32_t x = 0; (x < 4) && (4 * i + x < width); x++) {
+                            plane[4 * i + x + (4 * j + y) * width] = (uint32_t)color.color(x, y);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /// Decodes a surface in place and compares it with the reference.
+    bool checkSurface(BlockFormat format, uint32_t width, uint32_t height, uint32_t depth)
+    {
+        uint32_t blockCount = ((width + 3) / 4) * ((height + 3) / 4) * depth;
+        uint32_t blockBytes = blockCount * blockFormatSize(format);
+        uint32_t texelCount = width * height * depth;
+
+        std::vector<uint8_t> blocks(blockBytes);
+        makeBlocks(format, &blocks[0], blockCount);
+        std::vector<uint32_t> expected(texelCount);
+        referenceDecodeSurface(format, &blocks[0], &expected[0], width, height, depth);
+
+        // Surfaces are sized as the DDS loader sizes them, for whichever of
+        // the blocks and the texels is larger, with a guard byte past the end
+        uint32_t surfBytes = (blockBytes > texelCount * 4) ? blockBytes : texelCount * 4;
+        std::vector<uint8_t> surf(surfBytes + 1);
+        memcpy(&surf[0], &blocks[0], blockBytes);
+        surf[surfBytes] = 0xA5;
+        decodeSurfaceInPlace(format, &surf[0], width, height, depth);
+
+        if (surf[surfBytes] != 0xA5) {
+            printf("%s %ux%ux%u: wrote past the surface\n", FORMAT_NAMES[format], width, height, depth);
+            return false;
+        }
+        for (uint32_t t = 0; t < texelCount; t++) {
+            uint32_t texel;
+            memcpy(&texel, &surf[4 * t], 4);
+            if (texel != expected[t]) {
+                uint32_t x = t % width;
+                uint32_t y = (t / width) % height;
+                uint32_t z = t / (width * height);
+                printf("%s %ux%ux%u: texel (%u, %u, %u) is %08x, expected %08x\n", FORMAT_NAMES[format],
+                    width, height, depth, x, y, z, texel, expected[t]);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Decodes each row of blocks of a surface into a destination 3 texels wider
+    /// than the surface, and checks that the margin is untouched.
+    bool checkRows(BlockFormat format, uint32_t width, uint32_t height)
+    {
+        const uint32_t MARGIN = 3;
+        const uint32_t FILL = 0xDEADBEEF;
+        uint32_t bw = (width + 3) / 4;
+        uint32_t bh = (height + 3) / 4;
+        uint32_t rowBytes = bw * blockFormatSize(format);
+        uint32_t pitch = width + MARGIN;
+
+        std::vector<uint8_t> blocks(rowBytes * bh);
+        makeBlocks(format, &blocks[0], bw * bh);
+        std::vector<uint32_t> expected(width * height);
+        referenceDecodeSurface(format, &blocks[0], &expected[0], width, height, 1);
+
+        std::vector<uint32_t> dest(pitch * height, FILL);
+        for (uint32_t j = 0; j < bh; j++) {
+            uint32_t rows = (height - 4 * j < 4) ? (height - 4 * j) : 4;
+            decodeBlockRow(format, &blocks[j * rowBytes], bw, &dest[4 * j * pitch], width, rows, pitch);
+        }
+
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < pitch; x++) {
+                uint32_t want = (x < width) ? expected[y * width + x] : FILL;
+                if (dest[y * pitch + x] != want) {
+                    printf("%s %ux%u rows: texel (%u, %u) is %08x, expected %08x\n", FORMAT_NAMES[format],
+                        width, height, x, y, dest[y * pitch + x], want);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    double megabytesPerSecond(uint32_t bytes, uint32_t repeats,
+        std::chrono::high_resolution_clock::time_point start)
+    {
+        std::chrono::duration<double> seconds = std::chrono::high_resolution_clock::now() - start;
+        return double(bytes) * repeats / (seconds.count() * 1.0e6);
+    }
+
+    void bench()
+    {
+        const uint32_t SIZE = 2048;
+        const uint32_t REPEATS = 10;
+        uint32_t texelBytes = SIZE * SIZE * 4;
+
+        printf("format                  scalar    BlockDXTDecoder   (MB of texels per second)\n");
+        for (uint32_t f = 0; f < FORMAT_COUNT; f++) {
+            BlockFormat format = BlockFormat(f);
+            uint32_t blockCount = (SIZE / 4) * (SIZE / 4);
+            uint32_t blockBytes = blockCount * blockFormatSize(format);
+            std::vector<uint8_t> blocks(blockBytes);
+            makeBlocks(format, &blocks[0], blockCount);
+            std::vector<uint32_t> texels(SIZE * SIZE);
+
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            for (uint32_t r = 0; r < REPEATS; r++) {
+                referenceDecodeSurface(format, &blocks[0], &texels[0], SIZE, SIZE, 1);
+            }
+            double scalar = megabytesPerSecond(texelBytes, REPEATS, start);
+
+            // The copy of the blocks into the surface is timed too, as the
+            // scalar path has its own copy
+            std::vector<uint8_t> surf(texelBytes);
+            start = std::chrono::high_resolution_clock::now();
+            for (uint32_t r = 0; r < REPEATS; r++) {
+                memcpy(&surf[0], &blocks[0], blockBytes);
+                decodeSurfaceInPlace(format, &surf[0], SIZE, SIZE, 1);
+            }
+            double decoder = megabytesPerSecond(texelBytes, REPEATS, start);
+
+            printf("%-20s %9.0f %17.0f\n", FORMAT_NAMES[f], scalar, decoder);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if ((argc > 1) && (strcmp(argv[1], "bench") == 0)) {
+        bench();
+        return 0;
+    }
+
+    // Whole blocks, partial edge blocks, 1 and 2 texel mips, and volumes,
+    // including the small ones whose blocks are copied out before decoding
+    static const uint32_t SIZES[][3] = {
+        { 1, 1, 1 }, { 2, 2, 1 }, { 4, 4, 1 }, { 3, 5, 1 }, { 8, 1, 1 }, { 1, 8, 1 },
+        { 7, 9, 1 }, { 64, 32, 1 }, { 257, 129, 1 },
+        { 1, 1, 4 }, { 2, 2, 8 }, { 4, 1, 3 }, { 1, 4, 2 }, { 3, 2, 5 }, { 4, 4, 4 },
+        { 13, 7, 3 }, { 16, 16, 4 }, { 33, 17, 6 }
+    };
+    static const uint32_t SIZE_COUNT = sizeof(SIZES) / sizeof(SIZES[0]);
+
+    uint32_t checks = 0;
+    uint32_t failures = 0;
+    for (uint32_t f = 0; f < FORMAT_COUNT; f++) {
+        BlockFormat format = BlockFormat(f);
+        for (uint32_t s = 0; s < SIZE_COUNT; s++) {
+            checks++;
+            if (!checkSurface(format, SIZES[s][0], SIZES[s][1], SIZES[s][2])) {
+                failures++;
+            }
+            if (SIZES[s][2] == 1) {
+                checks++;
+                if (!checkRows(format, SIZES[s][0], SIZES[s][1])) {
+                    failures++;
+                }
+            }
+        }
+    }
+
+#if defined(NV_BLOCKDXT_NO_SIMD)
+    const char* decoder = "scalar";
+#else
+    const char* decoder = "default";
+#endif
+    printf("%u of %u checks failed with the %s decoder: %s\n", failures, checks, decoder,
+        (failures == 0) ? "passed" : "FAILED");
+    return (failures == 0) ? 0 : 1;
+}
@@ -37,7 +37,9 @@
 #include <NvAssert.h>
 #include "NvAssetLoader/NvAssetLoader.h"
 #include "NvImage/NvImage.h"
-#include "BlockDXT.h"
+#include "BlockDXTDecoder.h"
+#include <NsAllocator.h>
+#include <NsJobSystem.h>
 
 using std::vector;
 using std::max;
@@ -52,7 +54,9 @@ NvImage::FormatInfo NvImage::formatTable[] = {
 
 bool NvImage::vertFlip = true;
 bool NvImage::m_expandDXT = true;
+bool NvImage::m_expandRGTC = false;
 bool NvImage::m_supportsBGR = true;
+nvidia::shdfnd::JobSystem* NvImage::m_jobSystem = NULL;
 
 //
 //
@@ -71,6 +75,7 @@ NvImage::NvImage() : _width(0), _height(0), _depth(0), _levelCount(0), _layers(0
 	_dataArrayCount = 0;
 	_data = NULL;
 	_dataBlockSize = 0;
+	_stream = NULL;
 }
 
 //
@@ -84,8 +89,13 @@ NvImage::~NvImage() {
 //
 ////////////////////////////////////////////////////////////
 void NvImage::freeData() {
+    closeStream();
     delete[] _data;
     delete[] _dataBlock;
+    _data = NULL;
+    _dataBlock = NULL;
+    _dataArrayCount = 0;
+    _dataBlockSize = 0;
 }
 
 //
@@ -364,108 +374,112 @@ uint32_t NvImage::componentSwapSurface(uint8_t *surf, int32_t width, int32_t hei
     return _format;
 }    
 
-static inline int32_t min(int32_t a, int32_t b) {
-    return (a <= b) ? a : b;
+static bool getBlockFormat(uint32_t format, nv::BlockFormat& blockFormat) {
+    switch (format) {
+        case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1:
+            blockFormat = nv::BLOCK_FORMAT_DXT1;
+            return true;
+        case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT3:
+            blockFormat = nv::BLOCK_FORMAT_DXT3;
+            return true;
+        case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT5:
+            blockFormat = nv::BLOCK_FORMAT_DXT5;
+            return true;
+        case NVIMAGE_COMPRESSED_RED_RGTC1:
+            blockFormat = nv::BLOCK_FORMAT_BC4_RED;
+            return true;
+        case NVIMAGE_COMPRESSED_LUMINANCE_LATC1:
+            blockFormat = nv::BLOCK_FORMAT_BC4_LUMINANCE;
+            return true;
+        case NVIMAGE_COMPRESSED_RG_RGTC2:
+            blockFormat = nv::BLOCK_FORMAT_BC5_RED_GREEN;
+            return true;
+        case NVIMAGE_COMPRESSED_LUMINANCE_ALPHA_LATC2:
+            blockFormat = nv::BLOCK_FORMAT_BC5_LUMINANCE_ALPHA;
+            return true;
+        default:
+            return false;
+    }
 }
 
 //
 //
 ////////////////////////////////////////////////////////////
-void NvImage::expandDXT(uint8_t *surf, int32_t width, int32_t height, int32_t depth, int32_t srcSize)
+bool NvImage::canExpandDXT() const
 {
-    depth = (depth) ? depth : 1;
-
-	uint32_t* dest = (uint32_t*)surf;
-    uint32_t* plane = dest;
-
-	uint8_t* srcBlock = new uint8_t[srcSize];
-	uint8_t* src = srcBlock;
-	memcpy(src, surf, srcSize);
-
-    int32_t bh = (height + 3) / 4;
-    int32_t bw = (width + 3) / 4;
-
-    if (_format == NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1) {
-        for (int32_t k = 0; k < depth; k++) {
-
-            for (int32_t j = 0; j < bh; j++) {
-                int32_t yBlockSize = min(4, height - 4 * j);
-
-                for (int32_t i = 0; i < bw; i++) {
-                    int32_t xBlockSize = min(4, width - 4 * i);
-                    nv::BlockDXT1* block = (nv::BlockDXT1*)src;
-                    nv::ColorBlock color;
-
-                    block->decodeBlock(&color);
-
-                    // Write color block.
-                    for (int32_t y = 0; y < yBlockSize; y++) {
-                        for (int32_t x = 0; x < xBlockSize; x++) {
-                            plane[4*i+x + (4*j+y)*width] = (uint32_t)color.color(x, y);
-                        }
-                    }
-
-                    src += sizeof(nv::BlockDXT1); // 64bits
-                }
-            }
-
-            plane += width * height;
-        }
-    } else if (_format == NVIMAGE_COMPRESSED_RGBA_S3TC_DXT3) {
-        for (int32_t k = 0; k < depth; k++) {
-
-            for (int32_t j = 0; j < bh; j++) {
-                int32_t yBlockSize = min(4, height - 4 * j);
-
-                for (int32_t i = 0; i < bw; i++) {
-                    int32_t xBlockSize = min(4, width - 4 * i);
-                    nv::BlockDXT3* block = (nv::BlockDXT3*)src;
-                    nv::ColorBlock color;
-
-                    block->decodeBlock(&color);
-
-                    // Write color block.
-                    for (int32_t y = 0; y < yBlockSize; y++) {
-                        for (int32_t x = 0; x < xBlockSize; x++) {
-                            plane[4*i+x + (4*j+y)*width] = (uint32_t)color.color(x, y);
-                        }
-                    }
+    nv::BlockFormat blockFormat;
+    if (!m_expandDXT || !getBlockFormat(_format, blockFormat))
+        return false;
 
-                    src += sizeof(nv::BlockDXT3); // 64bits
-                }
-            }
+    switch (blockFormat) {
+        case nv::BLOCK_FORMAT_DXT1:
+        case nv::BLOCK_FORMAT_DXT3:
+        case nv::BLOCK_FORMAT_DXT5:
+            return true;
+        default:
+            return m_expandRGTC;
+    }
+}
 
-            plane += width * height;
-        }
-    } else {
-        for (int32_t k = 0; k < depth; k++) {
+//
+//
+////////////////////////////////////////////////////////////
+void NvImage::expandDXT(uint8_t *surf, int32_t width, int32_t height, int32_t depth, int32_t srcSize)
+{
+    nv::BlockFormat blockFormat;
+    if (!getBlockFormat(_format, blockFormat))
+        return;
 
-            for (int32_t j = 0; j < bh; j++) {
-                int32_t yBlockSize = min(4U, height - 4 * j);
+    // The blocks are decoded in place, last to first, so no copy of the source is needed
+    depth = (depth) ? depth : 1;
+    // A truncated level is left alone rather than decoded from past its end
+    if (srcSize < (int32_t)(((width + 3) / 4) * ((height + 3) / 4) * depth * nv::blockFormatSize(blockFormat)))
+        return;
+    nv::decodeSurfaceInPlace(blockFormat, surf, width, height, depth);
+}
 
-                for (int32_t i = 0; i < bw; i++) {
-                    int32_t xBlockSize = min(4, width - 4 * i);
-                    nv::BlockDXT5* block = (nv::BlockDXT5*)src;
-                    nv::ColorBlock color;
+// Below this many bytes of blocks, handing them to the job system costs more than it saves
+static const int32_t sParallelExpandMinSize = 256 * 1024;
 
-                    block->decodeBlock(&color);
+struct NvImage::ExpandDXTJob {
+    NvImage* image;
+    DXTSurface* surfaces;
+};
 
-                    // Write color block.
-                    for (int32_t y = 0; y < yBlockSize; y++) {
-                        for (int32_t x = 0; x < xBlockSize; x++) {
-                            plane[4*i+x + (4*j+y)*width] = (uint32_t)color.color(x, y);
-                        }
-                    }
+//
+//
+////////////////////////////////////////////////////////////
+void NvImage::expandDXTRange(void* arg, uint32_t begin, uint32_t end, uint32_t /*workerIndex*/) {
+    ExpandDXTJob& job = *(ExpandDXTJob*)arg;
 
-                    src += sizeof(nv::BlockDXT5); // 64bits
-                }
-            }
+    for (uint32_t index = begin; index < end; index++) {
+        DXTSurface& s = job.surfaces[index];
+        job.image->expandDXT(s.surf, s.width, s.height, s.depth, s.srcSize);
+    }
+}
 
-            plane += width * height;
-        }
+//
+//
+////////////////////////////////////////////////////////////
+void NvImage::expandDXTSurfaces(DXTSurface* surfaces, int32_t count)
+{
+    int32_t totalSize = 0;
+    for (int32_t i = 0; i < count; i++)
+        totalSize += surfaces[i].srcSize;
+
+    if (!m_jobSystem || (m_jobSystem->getThreadCount() <= 1) || (count <= 1) ||
+        (totalSize < sParallelExpandMinSize)) {
+        for (int32_t i = 0; i < count; i++)
+            expandDXT(surfaces[i].surf, surfaces[i].width, surfaces[i].height, surfaces[i].depth, surfaces[i].srcSize);
+        return;
     }
 
-	delete[] srcBlock;
+    ExpandDXTJob job;
+    job.image = this;
+    job.surfaces = surfaces;
+
+    // One surface per job at most; this thread works through jobs while it waits
+    m_jobSystem->parallelFor(0, (uint32_t)count, 1, expandDXTRange, &job);
 }
 
 //
@@ -480,6 +494,10 @@ bool NvImage::convertCrossToCubemap() {
     if (_levelCount != 1)
         return false;
 
+    //streamed images are not supported
+    if (isStreaming())
+        return false;
+
     //compressed textures are not supported
     if (isCompressed())
         return false;
@@ -34,9 +34,11 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 
 #include "NvImage/NvImage.h"
 #include "NvFilePtr.h"
+#include "NvAssetLoader/NvAssetLoader.h"
 #include "NV/NvLogs.h"
 
 using std::vector;
@@ -877,7 +879,8 @@ bool TranslateDX10Format( const void *ptr, NvImage &i, int32_t &bytesPerElement,
 //
 //
 ////////////////////////////////////////////////////////////
-bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
+bool NvImage::readDDSHeader(const uint8_t* data, size_t length, NvImage& i, int32_t& bytesPerElement,
+    bool& btcCompressed, int32_t& headerSize) {
 
     // open file
     //FILE *fp = fopen(file, "rb");
@@ -890,9 +893,7 @@ bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
     char filecode[4];
     
     //fread(filecode, 1, 4, fp);
-    fp->Read( 4, filecode);
-
-    if (strncmp(filecode, "DDS ", 4) != 0)
+    if ((fp->Read( 4, filecode) != 4) || (strncmp(filecode, "DDS ", 4) != 0))
     {
         //fclose(fp);
         delete fp;
@@ -904,7 +905,12 @@ bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
     DDS_HEADER_10 ddsh10;
     
     //fread(&ddsh, sizeof(DDS_HEADER), 1, fp);
-    fp->Read( sizeof(DDS_HEADER), &ddsh);
+    if (fp->Read( sizeof(DDS_HEADER), &ddsh) != sizeof(DDS_HEADER))
+    {
+        delete fp;
+        return false;
+    }
+    headerSize = 4 + sizeof(DDS_HEADER);
 
     // check if image is a volume texture
     if ((ddsh.dwCaps2 & DDSF_VOLUME) && (ddsh.dwDepth > 0))
@@ -915,7 +921,12 @@ bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
     if ((ddsh.ddspf.dwFlags & DDSF_FOURCC) && (ddsh.ddspf.dwFourCC == FOURCC_DX10)) {
         //This DDS file uses the DX10 header extension
         //fread(&ddsh10, sizeof(DDS_HEADER_10), 1, fp);
-        fp->Read( sizeof(DDS_HEADER_10), &ddsh10);
+        if (fp->Read( sizeof(DDS_HEADER_10), &ddsh10) != sizeof(DDS_HEADER_10))
+        {
+            delete fp;
+            return false;
+        }
+        headerSize += sizeof(DDS_HEADER_10);
     }
 
     // There are flags that are supposed to mark these fields as valid, but some dds files don't set them properly
@@ -954,8 +965,8 @@ bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
         i._cubeMap = false;
     }
 
-    bool btcCompressed = false;
-    int32_t bytesPerElement = 0;
+    btcCompressed = false;
+    bytesPerElement = 0;
 
     // figure out what the image format is
     if (ddsh.ddspf.dwFlags & DDSF_FOURCC) 
@@ -1353,13 +1364,30 @@ bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
 
     i._elementSize = bytesPerElement;
 
-	delete[] i._dataBlock;
-	delete[] i._data;
+    //fclose(fp);
+    delete fp;
+    return true;
+}
+
+//
+//
+////////////////////////////////////////////////////////////
+bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
+    int32_t bytesPerElement;
+    bool btcCompressed;
+    int32_t headerSize;
+
+    if (!readDDSHeader(data, length, i, bytesPerElement, btcCompressed, headerSize))
+        return false;
 
-    bool mustExpandDXT = m_expandDXT &&
-        ((i._format == NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1) ||
-        (i._format == NVIMAGE_COMPRESSED_RGBA_S3TC_DXT3) ||
-        (i._format == NVIMAGE_COMPRESSED_RGBA_S3TC_DXT5));
+    NvFilePtr* fp = NvFilePtr::Create( (uint8_t*)data + headerSize, length - headerSize, NvFileMode::READ);
+
+    if (fp == NULL)
+        return false;
+
+    i.freeData();
+
+    bool mustExpandDXT = i.canExpandDXT();
 
 	i._dataArrayCount = i._layers * i._levelCount;
 	i._data = new uint8_t*[i._dataArrayCount];
@@ -1372,7 +1400,8 @@ bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
 				int32_t bw = (btcCompressed) ? (w - 1) / i._blockSize_x + 1 : w;
 				int32_t bh = (btcCompressed) ? (h - 1) / i._blockSize_y + 1 : h;
 				int32_t readSize = bw*bh*d*bytesPerElement;
-				int32_t allocSize = mustExpandDXT ? (w * h * 4) : readSize;
+				// expanded levels are decoded in place, so each slot must also hold the blocks
+				int32_t allocSize = mustExpandDXT ? std::max(readSize, w * h * d * 4) : readSize;
 
 				totalSize += allocSize;
 
@@ -1396,13 +1425,18 @@ bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
     uint32_t originalFormat = i._format;
     uint32_t finalFormat = i._format;
 
+    // Expansion is left until every level has been read, so that the levels can be expanded in parallel
+    vector<NvImage::DXTSurface> expandSurfaces;
+    if (mustExpandDXT)
+        expandSurfaces.reserve(i._dataArrayCount);
+
     for (int32_t face = 0; face < i._layers; face++) {
         int32_t w = i._width, h = i._height, d = (i._depth) ? i._depth : 1;
         for (int32_t level = 0; level < i._levelCount; level++) {
 			int32_t bw = (btcCompressed) ? (w-1)/i._blockSize_x+1 : w;
 			int32_t bh = (btcCompressed) ? (h-1)/i._blockSize_y+1 : h;
             int32_t readSize = bw*bh*d*bytesPerElement;
-			int32_t allocSize = mustExpandDXT ? (w * h * 4) : readSize;
+			int32_t allocSize = mustExpandDXT ? std::max(readSize, w * h * d * 4) : readSize;
 
 			uint8_t *pixels = ptr;
 			i._data[currentLevel++] = ptr;
@@ -1418,8 +1452,10 @@ bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
                 finalFormat = i.componentSwapSurface(pixels, w, h, d);
 
             // do we need to expand DXT?
-            if (mustExpandDXT)
-				i.expandDXT(pixels, w, h, d, readSize);
+            if (mustExpandDXT) {
+                NvImage::DXTSurface surface = { pixels, w, h, d, readSize };
+                expandSurfaces.push_back(surface);
+            }
 
             //reduce mip sizes
             w = ( w > 1) ? w >> 1 : 1;
@@ -1429,9 +1465,11 @@ bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
     }
 
     if (mustExpandDXT) {
+        i.expandDXTSurfaces(&expandSurfaces[0], (int32_t)expandSurfaces.size());
         i._format = NVIMAGE_RGBA;
         i._type = NVIMAGE_UNSIGNED_BYTE;
 		i._internalFormat = NVIMAGE_RGBA8;
+        i._elementSize = 4;
     }
     else
     {
@@ -1443,6 +1481,277 @@ bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
     return true;
 }
 
+//
+// Streamed DDS files
+//
+////////////////////////////////////////////////////////////
+struct NvImage::DDSStream {
+    NvAssetFilePtr file;
+
+    // the format of the data in the file, before any swap or expansion
+    uint32_t fileFormat;
+    uint32_t fileInternalFormat;
+    uint32_t fileType;
+    int32_t fileElementSize;
+
+    // the load-time options in effect when the file was opened
+    bool flip;
+    bool swap;
+    bool expand;
+
+    // the location of each level of each layer in the file, indexed like _data
+    vector<int32_t> fileOffsets;
+    vector<int32_t> fileSizes;
+
+    // the size in memory of one layer of each level, and the memory holding every layer of
+    // each resident level
+    vector<int32_t> levelSizes;
+    vector<uint8_t*> levels;
+};
+
+//
+//
+////////////////////////////////////////////////////////////
+NvImage* NvImage::CreateStreamingFromDDSFile(const char* filename, int32_t residentLevels) {
+    NvAssetFilePtr file = NvAssetLoaderOpenFile(filename);
+
+    if (!file)
+        return NULL;
+
+    uint8_t header[4 + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_10)];
+    int32_t headerRead = NvAssetFileRead(file, sizeof(header), header);
+    int32_t fileSize = NvAssetFileGetSize(file);
+
+    NvImage* image = new NvImage;
+    int32_t bytesPerElement;
+    bool btcCompressed;
+    int32_t headerSize;
+
+    if ((headerRead <= 0) ||
+        !readDDSHeader(header, headerRead, *image, bytesPerElement, btcCompressed, headerSize)) {
+        NvAssetLoaderCloseFile(file);
+        delete image;
+        return NULL;
+    }
+
+    DDSStream* stream = new DDSStream;
+    stream->file = file;
+    stream->fileFormat = image->_format;
+    stream->fileInternalFormat = image->_internalFormat;
+    stream->fileType = image->_type;
+    stream->fileElementSize = image->_elementSize;
+    stream->flip = vertFlip && !image->_cubeMap;
+    stream->swap = !m_supportsBGR;
+    stream->expand = image->canExpandDXT();
+    image->_stream = stream;
+
+    int32_t count = image->_layers * image->_levelCount;
+    stream->fileOffsets.resize(count);
+    stream->fileSizes.resize(count);
+    stream->levelSizes.resize(image->_levelCount);
+    stream->levels.assign(image->_levelCount, (uint8_t*)NULL);
+
+    // The file holds every level of the first layer, then every level of the next
+    int32_t offset = headerSize;
+    for (int32_t face = 0; face < image->_layers; face++) {
+        int32_t w = image->_width, h = image->_height, d = (image->_depth) ? image->_depth : 1;
+        for (int32_t level = 0; level < image->_levelCount; level++) {
+            int32_t bw = (btcCompressed) ? (w - 1) / image->_blockSize_x + 1 : w;
+            int32_t bh = (btcCompressed) ? (h - 1) / image->_blockSize_y + 1 : h;
+            int32_t readSize = bw*bh*d*bytesPerElement;
+
+            stream->fileOffsets[face*image->_levelCount + level] = offset;
+            stream->fileSizes[face*image->_levelCount + level] = readSize;
+            // expanded levels are decoded in place, so they must also hold the blocks
+            stream->levelSizes[level] = stream->expand ? std::max(readSize, w * h * d * 4) : readSize;
+            offset += readSize;
+
+            //reduce mip sizes
+            w = ( w > 1) ? w >> 1 : 1;
+            h = ( h > 1) ? h >> 1 : 1;
+            d = ( d > 1) ? d >> 1 : 1;
+        }
+    }
+
+    if (offset > fileSize) {
+        delete image;
+        return NULL;
+    }
+
+    // Report the format the levels will have once they are read
+    if (stream->expand) {
+        image->_format = NVIMAGE_RGBA;
+        image->_type = NVIMAGE_UNSIGNED_BYTE;
+        image->_internalFormat = NVIMAGE_RGBA8;
+        image->_elementSize = 4;
+    } else if (stream->swap) {
+        // An empty surface just reports the swapped format
+        image->_format = image->componentSwapSurface(NULL, 0, 0, 1);
+    }
+
+    image->_dataArrayCount = count;
+    image->_data = new uint8_t*[count];
+    memset(image->_data, 0, count * sizeof(uint8_t*));
+
+    // Read the smallest levels, so that the image can be used right away
+    for (int32_t level = image->_levelCount - 1; (level >= 0) && (level >= image->_levelCount - residentLevels); level--) {
+        if (!image->streamLevel(level)) {
+            delete image;
+            return NULL;
+        }
+    }
+
+    return image;
+}
+
+//
+//
+////////////////////////////////////////////////////////////
+bool NvImage::streamLevel(int32_t level) {
+    if (level < 0 || level >= _levelCount)
+        return false;
+
+    if (!_stream || _stream->levels[level])
+        return true;
+
+    int32_t w = _width >> level, h = _height >> level, d = _depth >> level;
+    w = (w) ? w : 1;
+    h = (h) ? h : 1;
+    d = (d) ? d : 1;
+
+    int32_t levelSize = _stream->levelSizes[level];
+    uint8_t* data = new uint8_t[levelSize * _layers];
+
+    // Flip, swap and expand the level in the file's format, just as readDDS does
+    uint32_t format = _format;
+    uint32_t internalFormat = _internalFormat;
+    uint32_t type = _type;
+    int32_t elementSize = _elementSize;
+    _format = _stream->fileFormat;
+    _internalFormat = _stream->fileInternalFormat;
+    _type = _stream->fileType;
+    _elementSize = _stream->fileElementSize;
+
+    vector<DXTSurface> expandSurfaces;
+    bool result = true;
+    for (int32_t layer = 0; layer < _layers; layer++) {
+        int32_t index = layer*_levelCount + level;
+        uint8_t* pixels = data + layer * levelSize;
+        int32_t readSize = _stream->fileSizes[index];
+
+        if ((NvAssetFileSeek(_stream->file, _stream->fileOffsets[index], NV_SEEK_SET) < 0) ||
+            (NvAssetFileRead(_stream->file, readSize, pixels) != readSize)) {
+            result = false;
+            break;
+        }
+
+        if (_stream->flip)
+            flipSurface(pixels, w, h, d);
+
+        if (_stream->swap)
+            componentSwapSurface(pixels, w, h, d);
+
+        if (_stream->expand) {
+            DXTSurface surface = { pixels, w, h, d, readSize };
+            expandSurfaces.push_back(surface);
+        }
+    }
+
+    if (result && _stream->expand)
+        expandDXTSurfaces(&expandSurfaces[0], (int32_t)expandSurfaces.size());
+
+    _format = format;
+    _internalFormat = internalFormat;
+    _type = type;
+    _elementSize = elementSize;
+
+    if (!result) {
+        delete[] data;
+        return false;
+    }
+
+    _stream->levels[level] = data;
+    for (int32_t layer = 0; layer < _layers; layer++)
+        _data[layer*_levelCount + level] = data + layer * levelSize;
+
+    return true;
+}
+
+//
+//
+////////////////////////////////////////////////////////////
+void NvImage::evictLevel(int32_t level) {
+    if (!_stream || level < 0 || level >= _levelCount)
+        return;
+
+    delete[] _stream->levels[level];
+    _stream->levels[level] = NULL;
+    for (int32_t layer = 0; layer < _layers; layer++)
+        _data[layer*_levelCount + level] = NULL;
+}
+
+//
+//
+////////////////////////////////////////////////////////////
+bool NvImage::isLevelResident(int32_t level) const {
+    if (level < 0 || level >= _levelCount)
+        return false;
+
+    return !_stream || (_stream->levels[level] != NULL);
+}
+
+//
+//
+////////////////////////////////////////////////////////////
+int32_t NvImage::getFirstResidentLevel() const {
+    int32_t level = _levelCount;
+    while ((level > 0) && isLevelResident(level - 1))
+        level--;
+    return level;
+}
+
+//
+//
+////////////////////////////////////////////////////////////
+int32_t NvImage::getResidentSize() const {
+    if (!_stream)
+        return _dataBlockSize;
+
+    int32_t size = 0;
+    for (int32_t level = 0; level < _levelCount; level++) {
+        if (_stream->levels[level])
+            size += _stream->levelSizes[level] * _layers;
+    }
+    return size;
+}
+
+//
+//
+////////////////////////////////////////////////////////////
+bool NvImage::getLevelFileRange(int32_t level, int32_t layer, int32_t& offset, int32_t& size) const {
+    if (!_stream || level < 0 || level >= _levelCount || layer < 0 || layer >= _layers)
+        return false;
+
+    offset = _stream->fileOffsets[layer*_levelCount + level];
+    size = _stream->fileSizes[layer*_levelCount + level];
+    return true;
+}
+
+//
+//
+////////////////////////////////////////////////////////////
+void NvImage::closeStream() {
+    if (!_stream)
+        return;
+
+    for (size_t level = 0; level < _stream->levels.size(); level++)
+        delete[] _stream->levels[level];
+
+    NvAssetLoaderCloseFile(_stream->file);
+    delete _stream;
+    _stream = NULL;
+}
+
 //
 // flip a DXT1 color block
 ////////////////////////////////////////////////////////////
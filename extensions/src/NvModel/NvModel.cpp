@@ -39,7 +39,13 @@
 
 using namespace nv;
 
-struct NvModelFileHeader {
+static const uint32_t NVMODEL_NVM_VERSION = 2;
+
+// Vertex and index blocks in a v2 file start on this boundary (in bytes) so
+// that they can be used in place from a mapped or page-aligned load
+static const uint32_t NVMODEL_NVM_BLOCK_ALIGNMENT = 16;
+
+struct NvModelFileHeader_v1 {
 	uint8_t _magic[4];
 	uint32_t _headerSize; // includes magic
 	uint32_t _version;
@@ -61,19 +67,75 @@ struct NvModelFileHeader {
 	// ptr + headersize + vertexCount * vertexSize = index base
 };
 
+struct NvModelFileHeader {
+	uint8_t _magic[4];
+	uint32_t _headerSize; // includes magic
+	uint32_t _version;
+	uint32_t _vertexCount;
+	uint32_t _indexCount;
+	uint32_t _vertexSize; // size of each vert IN BYTES!
+	uint32_t _indexSize; // size of each index IN BYTES!
+	int32_t _pOffset;
+	int32_t _nOffset;
+	int32_t _tcOffset;
+	int32_t _sTanOffset;
+	int32_t _cOffset;
+	int32_t _posSize;
+	int32_t _tcSize;
+	int32_t _cSize;
+	float _minExtent[3];
+	float _maxExtent[3];
+	// offsets in bytes from the start of the file, each a multiple
+	// of NVMODEL_NVM_BLOCK_ALIGNMENT
+	uint32_t _vertexBase;
+	uint32_t _indexBase;
+};
+
+static uint32_t AlignBlockOffset(uint32_t offset) {
+	return (offset + NVMODEL_NVM_BLOCK_ALIGNMENT - 1) & ~(NVMODEL_NVM_BLOCK_ALIGNMENT - 1);
+}
+
+// True if an attribute of the given size at the given offset (both in floats)
+// lies within a vertex; a negative offset means the attribute is absent
+static bool IsAttributeInVertex(int32_t offset, int32_t size, int32_t vtxSize) {
+	return (offset < 0) || ((size >= 0) && (int64_t(offset) + size <= vtxSize));
+}
+
 //////////////////////////////////////////////////////////////////////
 //
 //  Static data
 //
 //////////////////////////////////////////////////////////////////////
+bool NvModel::ms_optimizeVertexCache = false;
+
 NvModel* NvModel::CreateFromObj(uint8_t* data, float scale, bool computeNormals, bool computeTangents)  {
 	return NvModelObj::CreateFromObj(data, scale, computeNormals, computeTangents);
 }
 
 NvModel* NvModel::CreateFromPreprocessed(uint8_t* data) {
 	NvModel* model = new NvModel;
-	if (!model->LoadPreprocessedModel(data))
+	if (!model->LoadPreprocessedModel(data)) {
+		delete model;
+		return NULL;
+	}
+
+	return model;
+}
+
+NvModel* NvModel::CreateFromPreprocessedInPlace(uint8_t* data, size_t size, NvModelDataReleaseFunc release) {
+	NvModel* model = new NvModel;
+	if (!model->LoadPreprocessedModel(data, true, size)) {
+		delete model;
 		return NULL;
+	}
+
+	// if the data could not be referenced in place, the model holds a copy
+	// and the caller's block is no longer needed
+	if (model->_sourceData) {
+		model->_releaseSourceData = release;
+	} else if (release) {
+		release(data);
+	}
 
 	return model;
 }
@@ -82,10 +144,12 @@ NvModel* NvModel::CreateFromPreprocessed(uint8_t* data) {
 //
 ////////////////////////////////////////////////////////////
 NvModel::NvModel() : 
+	_indices(NULL), _vertices(NULL),
 	_pOffset(-1), _nOffset(-1), _tcOffset(-1), _sTanOffset(-1), _cOffset(-1), 
 	_posSize(0), _tcSize(0), _cSize(0),
 	_vtxSize(0),
-	_vertexCount(0), _indexCount(0)
+	_vertexCount(0), _indexCount(0),
+	_sourceData(NULL), _releaseSourceData(NULL)
 {
 }
 
@@ -93,7 +157,33 @@ NvModel::NvModel() :
 //
 //////////////////////////////////////////////////////////////////////
 NvModel::~NvModel() {
-    //dynamic allocations presently all handled via stl
+	releaseData();
+}
+
+//
+//
+////////////////////////////////////////////////////////////
+void NvModel::releaseData() {
+	if (_sourceData) {
+		// _vertices and _indices point into the source block
+		if (_releaseSourceData)
+			_releaseSourceData(_sourceData);
+	} else {
+		delete[] _vertices;
+		delete[] _indices;
+	}
+
+	_vertices = NULL;
+	_indices = NULL;
+	_sourceData = NULL;
+	_releaseSourceData = NULL;
+}
+
+//
+//
+////////////////////////////////////////////////////////////
+bool NvModel::isInPlace() const {
+	return _sourceData != NULL;
 }
 
 //
@@ -131,19 +221,49 @@ int32_t NvModel::getColorSize() const {
 	return _cSize;
 }
 
-bool NvModel::LoadPreprocessedModel(uint8_t* data) {
-	if (!data)
+bool NvModel::LoadPreprocessedModel(uint8_t* data, bool inPlace, size_t size) {
+	if (!data || size < sizeof(NvModelFileHeader_v1))
 		return false;
 
+	// v1 and v2 share every field up to the extents
 	NvModelFileHeader* hdr = (NvModelFileHeader*)data;
 
 	if (hdr->_magic[0] != 'N' || hdr->_magic[1] != 'V' ||
 		hdr->_magic[2] != 'M' || hdr->_magic[3] != 'B' ||
-		hdr->_headerSize != sizeof(NvModelFileHeader) ||
-		hdr->_version != 1 ||
-		hdr->_indexSize != sizeof(uint32_t))
+		hdr->_indexSize != sizeof(uint32_t) ||
+		(hdr->_vertexSize % sizeof(float)) != 0)
+		return false;
+
+	// Sizes are computed in 64 bits so that corrupt counts cannot wrap around
+	uint64_t vertexBytes = uint64_t(hdr->_vertexCount) * hdr->_vertexSize;
+	uint64_t indexBytes = uint64_t(hdr->_indexCount) * sizeof(uint32_t);
+	uint64_t vertexBase;
+	uint64_t indexBase;
+	if (hdr->_version == 1 && hdr->_headerSize == sizeof(NvModelFileHeader_v1)) {
+		vertexBase = sizeof(NvModelFileHeader_v1);
+		indexBase = vertexBase + vertexBytes;
+	} else if (hdr->_version == 2 && hdr->_headerSize == sizeof(NvModelFileHeader) &&
+		size >= sizeof(NvModelFileHeader)) {
+		vertexBase = hdr->_vertexBase;
+		indexBase = hdr->_indexBase;
+	} else {
+		return false;
+	}
+
+	// Both blocks must lie between the header and the end of the data, and
+	// every attribute must lie within a vertex
+	int32_t vtxSize = hdr->_vertexSize / sizeof(float);
+	if (vertexBase < hdr->_headerSize || vertexBase + vertexBytes > size ||
+		indexBase < hdr->_headerSize || indexBase + indexBytes > size ||
+		!IsAttributeInVertex(hdr->_pOffset, hdr->_posSize, vtxSize) ||
+		!IsAttributeInVertex(hdr->_nOffset, 3, vtxSize) ||
+		!IsAttributeInVertex(hdr->_tcOffset, hdr->_tcSize, vtxSize) ||
+		!IsAttributeInVertex(hdr->_sTanOffset, 3, vtxSize) ||
+		!IsAttributeInVertex(hdr->_cOffset, hdr->_cSize, vtxSize))
 		return false;
 
+	releaseData();
+
 	_vertexCount = hdr->_vertexCount;
 	_indexCount = hdr->_indexCount;
 	_vtxSize = hdr->_vertexSize / sizeof(float);
@@ -161,14 +281,28 @@ bool NvModel::LoadPreprocessedModel(uint8_t* data) {
 	for (int i = 0; i < 3; i++)
 		m_maxExtent[i] = hdr->_maxExtent[i];
 
+	uint8_t* vertexData = data + vertexBase;
+	uint8_t* indexData = data + indexBase;
+
+	// Referencing the blocks in place needs naturally-aligned floats and
+	// indices; v2 files guarantee it for any 16-byte-aligned base, and v1
+	// files happen to satisfy it for any 4-byte-aligned base
+	if (inPlace && 
+		((uintptr_t)vertexData & (sizeof(float) - 1)) == 0 &&
+		((uintptr_t)indexData & (sizeof(uint32_t) - 1)) == 0) {
+		_vertices = (float*)vertexData;
+		_indices = (uint32_t*)indexData;
+		_sourceData = data;
+		return true;
+	}
+
 	_vertices = new float[_vertexCount * _vtxSize];
 	_indices = new uint32_t[_indexCount];
 
-	memcpy(_vertices, data + sizeof(NvModelFileHeader),
+	memcpy(_vertices, vertexData,
 		_vertexCount * _vtxSize * sizeof(float));
 
-	memcpy(_indices, data + sizeof(NvModelFileHeader) +
-		_vertexCount * _vtxSize * sizeof(float),
+	memcpy(_indices, indexData,
 		_indexCount * sizeof(uint32_t));
 
 	return true;
@@ -203,6 +337,8 @@ bool NvModel::LoadFromData(const float* verts, uint32_t vertCount, uint32_t vert
 	int32_t tanOffset,
 	uint32_t colorSize, int32_t colorOffset) {
 
+	releaseData();
+
 	_vertexCount = vertCount;
 	_indexCount = indexCount;
 	_vtxSize = vertSize;
@@ -264,7 +400,7 @@ bool NvModel::WritePreprocessedModel(const char* filename) {
 	hdr._magic[2] = 'M';
 	hdr._magic[3] = 'B';
 	hdr._headerSize = sizeof(NvModelFileHeader);
-	hdr._version = 1;
+	hdr._version = NVMODEL_NVM_VERSION;
 	hdr._vertexCount = _vertexCount;
 	hdr._indexCount = _indexCount;
 	hdr._vertexSize = _vtxSize * sizeof(float);
@@ -283,9 +419,18 @@ bool NvModel::WritePreprocessedModel(const char* filename) {
 		hdr._maxExtent[i] = m_maxExtent[i];
 	}
 
+	uint32_t vertexBytes = hdr._vertexSize * _vertexCount;
+	hdr._vertexBase = AlignBlockOffset(sizeof(NvModelFileHeader));
+	hdr._indexBase = AlignBlockOffset(hdr._vertexBase + vertexBytes);
+
+	static const uint8_t padding[NVMODEL_NVM_BLOCK_ALIGNMENT] = { 0 };
+
 	fwrite(&hdr, sizeof(NvModelFileHeader), 1, fp);
+	fwrite(padding, 1, hdr._vertexBase - sizeof(NvModelFileHeader), fp);
+
+	fwrite(_vertices, 1, vertexBytes, fp);
+	fwrite(padding, 1, hdr._indexBase - (hdr._vertexBase + vertexBytes), fp);
 
-	fwrite(_vertices, 1, hdr._vertexSize * _vertexCount, fp);
 	fwrite(_indices, sizeof(uint32_t), _indexCount, fp);
 	
 	fclose(fp);
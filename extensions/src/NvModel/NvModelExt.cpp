@@ -39,16 +39,203 @@
 #include "NvModel/NvModelSubMesh.h"
 #include "NvModel/NvSkeleton.h"
 #include "NvModelExtFile.h"
+#include "NvModelVertexPacker.h"
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace Nv
 {
 	NvModelFileLoader* NvModelExt::ms_pLoader = NULL;
+	nvidia::shdfnd::JobSystem* NvModelExt::ms_pJobSystem = NULL;
+	uint32_t NvModelExt::ms_objParseThreadCount = 0;
+	bool NvModelExt::ms_objCacheEnabled = true;
+	std::string NvModelExt::ms_objCacheDirectory;
+	bool NvModelExt::ms_optimizeVertexCache = false;
+	bool NvModelExt::ms_decodePackedVertices = true;
+
+    static FILE* OpenModelFile(const char* filename, const char* mode)
+    {
+#ifdef _WIN32
+        FILE* fp = NULL;
+        errno_t err = fopen_s(&fp, filename, mode);
+        return err ? NULL : fp;
+#else
+        return fopen(filename, mode);
+#endif
+    }
+
+    // 64-bit FNV-1a hash, used to identify the source data of cached models
+    static const uint64_t sHashOffsetBasis = 14695981039346656037ULL;
+
+    static uint64_t HashBytes(const void* pData, size_t size, uint64_t hash)
+    {
+        const uint8_t* pBytes = (const uint8_t*)pData;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= pBytes[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // Computes the key that a cached model must match to be used in place of
+    // loading the given OBJ file data with the given options.  This covers the
+    // contents of the OBJ file and of the material libraries it includes, along
+    // with all options that affect the resulting model.
+    static uint64_t ComputeObjSourceKey(NvModelFileLoader* pLoader, const char* pObjData, float scale,
+        bool generateNormals, bool generateTangents, float vertMergeThreshold, float normMergeThreshold,
+        bool optimizeVertexCache)
+    {
+        uint64_t key = HashBytes(&NVMODEL_CACHE_VERSION, sizeof(NVMODEL_CACHE_VERSION), sHashOffsetBasis);
+        key = HashBytes(&scale, sizeof(scale), key);
+        key = HashBytes(&vertMergeThreshold, sizeof(vertMergeThreshold), key);
+        key = HashBytes(&normMergeThreshold, sizeof(normMergeThreshold), key);
+        uint8_t flags = (generateNormals ? 1 : 0) | (generateTangents ? 2 : 0) | (optimizeVertexCache ? 4 : 0);
+        key = HashBytes(&flags, sizeof(flags), key);
+        key = HashBytes(pObjData, strlen(pObjData), key);
+
+        // Material libraries are referenced by "mtllib" statements, which the OBJ
+        // loader recognizes by the 'm' at the start of the line
+        const char* pLine = pObjData;
+        while (*pLine)
+        {
+            while ((*pLine == ' ') || (*pLine == '\t'))
+            {
+                ++pLine;
+            }
+            if (*pLine == 'm')
+            {
+                NvTokenizer tok(pLine, "/");
+                std::string libName;
+                if (tok.readToken() && tok.getTokenString(libName))
+                {
+                    key = HashBytes(libName.c_str(), libName.length() + 1, key);
+                    char* pLibData = pLoader->LoadDataFromFile(libName.c_str());
+                    if (NULL != pLibData)
+                    {
+                        key = HashBytes(pLibData, strlen(pLibData), key);
+                        pLoader->ReleaseData(pLibData);
+                    }
+                }
+            }
+            while (*pLine && (*pLine != '\n') && (*pLine != '\r'))
+            {
+                ++pLine;
+            }
+            while ((*pLine == '\n') || (*pLine == '\r'))
+            {
+                ++pLine;
+            }
+        }
+        return key;
+    }
+
+    // Returns the path of the cache file for the given OBJ file
+    static std::string GetObjCachePath(const char* filename, const std::string& cacheDirectory)
+    {
+        // OBJ files in different directories may share a name, so the name of the
+        // cache file also includes a hash of the full path
+        std::string name(filename);
+        size_t separator = name.find_last_of("/\\");
+        if (separator != std::string::npos)
+        {
+            name = name.substr(separator + 1);
+        }
+        char pathHash[32];
+        sprintf(pathHash, ".%016llx", (unsigned long long)HashBytes(filename, strlen(filename), sHashOffsetBasis));
+
+        std::string path = cacheDirectory;
+        char last = path[path.length() - 1];
+        if ((last != '/') && (last != '\\'))
+        {
+            path += '/';
+        }
+        return path + name + pathHash + ".nvecache";
+    }
+
+    // Loads the model from the given cache file if it exists and was created
+    // from source data matching the given key
+    static NvModelExt* LoadCacheFile(const std::string& cachePath, uint64_t sourceKey)
+    {
+        FILE* fp = OpenModelFile(cachePath.c_str(), "rb");
+        if (NULL == fp)
+        {
+            return NULL;
+        }
+
+        NvModelExt* pModel = NULL;
+        NvModelExtCacheHeader hdr;
+        if ((fread(&hdr, sizeof(NvModelExtCacheHeader), 1, fp) == 1) &&
+            (hdr._magic[0] == 'N') && (hdr._magic[1] == 'V') &&
+            (hdr._magic[2] == 'M') && (hdr._magic[3] == 'C') &&
+            (hdr._headerSize == sizeof(NvModelExtCacheHeader)) &&
+            (hdr._version == NVMODEL_CACHE_VERSION) &&
+            (hdr._sourceKey == sourceKey) &&
+            (hdr._modelSize >= sizeof(NvModelExtFileHeader)) &&
+            (fseek(fp, 0, SEEK_END) == 0) &&
+            (ftell(fp) == long(hdr._headerSize + hdr._modelSize)) &&
+            (fseek(fp, hdr._headerSize, SEEK_SET) == 0))
+        {
+            uint8_t* pData = (uint8_t*)malloc(hdr._modelSize);
+            if ((NULL != pData) && (fread(pData, hdr._modelSize, 1, fp) == 1))
+            {
+                pModel = NvModelExtBin::CreateFromMemory(pData, hdr._modelSize);
+            }
+            free(pData);
+        }
+        fclose(fp);
+        return pModel;
+    }
 
 	NvModelExt* NvModelExt::CreateFromObj(const char* filename, float scale,
 		bool generateNormals, bool generateTangents,
 		float vertMergeThreshold, float normMergeThreshold, uint32_t initialVertCount) {
-		return NvModelExtObj::Create(filename, scale, generateNormals, generateTangents,
-			vertMergeThreshold, normMergeThreshold, initialVertCount);
+		// The cache needs a directory of its own: the OBJ file name is resolved by the
+		// file loader, so a cache file named after it could land anywhere relative to
+		// the working directory and never be found again
+		if (!ms_objCacheEnabled || ms_objCacheDirectory.empty() || (NULL == ms_pLoader))
+		{
+			return NvModelExtObj::Create(filename, scale, generateNormals, generateTangents,
+				vertMergeThreshold, normMergeThreshold, initialVertCount);
+		}
+
+		// Use the provided loader callback to load the file into memory
+		char* pData = ms_pLoader->LoadDataFromFile(filename);
+		if (NULL == pData)
+		{
+			return NvModelExtObj::Create(filename, scale, generateNormals, generateTangents,
+				vertMergeThreshold, normMergeThreshold, initialVertCount);
+		}
+
+		uint64_t sourceKey = ComputeObjSourceKey(ms_pLoader, pData, scale, generateNormals, generateTangents,
+			vertMergeThreshold, normMergeThreshold, ms_optimizeVertexCache);
+		std::string cachePath = GetObjCachePath(filename, ms_objCacheDirectory);
+
+		NvModelExt* pModel = LoadCacheFile(cachePath, sourceKey);
+		if (NULL == pModel)
+		{
+			// Missing or stale cache file, so load the OBJ file and replace the cache
+			// file with the result.  Failing to write the cache file (for example, if
+			// the OBJ file is in a read-only location) doesn't affect the load.
+			pModel = NvModelExtObj::CreateFromMemory(pData, scale, generateNormals, generateTangents,
+				vertMergeThreshold, normMergeThreshold, initialVertCount);
+			if (NULL != pModel)
+			{
+				pModel->WriteCacheFile(cachePath, sourceKey);
+			}
+		}
+
+		// Free the OBJ buffer
+		ms_pLoader->ReleaseData(pData);
+
+		return pModel;
 	}
 
 	NvModelExt* NvModelExt::CreateFromPreprocessed(const char* filename) {
@@ -96,17 +283,20 @@ namespace Nv
         return srcDescs.size();
     }
 
-	bool NvModelExt::WritePreprocessedModel(const char* filename) {
-#ifdef _WIN32
-		FILE* fp = NULL;
-	
-		errno_t err = fopen_s(&fp, filename, "wb");
-		if (err || !fp)
+	bool NvModelExt::WritePreprocessedModel(const char* filename, bool packVertices) {
+		FILE* fp = OpenModelFile(filename, "wb");
+		if (NULL == fp)
 		{
 			LOGE("Unable to write file: %s\n", filename);
 			return false;
 		}
 
+		bool result = WritePreprocessedModel(fp, packVertices);
+		result = (fclose(fp) == 0) && result;
+		return result;
+	}
+
+	bool NvModelExt::WritePreprocessedModel(FILE* fp, bool packVertices) {
         // File structure:
         // NvModelExtFileHeader
         // NvModelTextureBlock
@@ -118,14 +308,60 @@ namespace Nv
         totalBytesWritten += WriteTextureBlock(fp);
         totalBytesWritten += WriteSkeletonBlock(fp);
         totalBytesWritten += WriteMaterials(fp);
-        WriteMeshes(fp);
-		
-        fclose(fp);
+        WriteMeshes(fp, packVertices);
 
-		return true;
+		return (0 == ferror(fp));
+	}
+
+	bool NvModelExt::WriteCacheFile(const std::string& cachePath, uint64_t sourceKey) {
+		// Write to a file unique to this process and model first, so that other
+		// processes never see a partially written cache file
+		char tempSuffix[64];
+#ifdef _WIN32
+		uint32_t processId = uint32_t(_getpid());
 #else
-		return false;
+		uint32_t processId = uint32_t(getpid());
 #endif
+		sprintf(tempSuffix, ".%u.%llx.tmp", processId, (unsigned long long)(size_t)this);
+		std::string tempPath = cachePath + tempSuffix;
+
+		FILE* fp = OpenModelFile(tempPath.c_str(), "wb");
+		if (NULL == fp)
+		{
+			return false;
+		}
+
+		NvModelExtCacheHeader hdr;
+		hdr._magic[0] = 'N';
+		hdr._magic[1] = 'V';
+		hdr._magic[2] = 'M';
+		hdr._magic[3] = 'C';
+		hdr._headerSize = sizeof(NvModelExtCacheHeader);
+		hdr._version = NVMODEL_CACHE_VERSION;
+		hdr._modelSize = 0;
+		hdr._sourceKey = sourceKey;
+
+		// Write the header once to reserve its space, then again once the size of the model is known
+		bool result = (fwrite(&hdr, sizeof(NvModelExtCacheHeader), 1, fp) == 1) && WritePreprocessedModel(fp);
+		if (result)
+		{
+			hdr._modelSize = uint32_t(ftell(fp)) - hdr._headerSize;
+			result = (fseek(fp, 0, SEEK_SET) == 0) && (fwrite(&hdr, sizeof(NvModelExtCacheHeader), 1, fp) == 1);
+		}
+		result = (fclose(fp) == 0) && result;
+
+		if (result && (rename(tempPath.c_str(), cachePath.c_str()) != 0))
+		{
+			// Not all platforms allow rename to replace an existing file
+			remove(cachePath.c_str());
+			result = (rename(tempPath.c_str(), cachePath.c_str()) == 0);
+		}
+
+		if (!result)
+		{
+			remove(tempPath.c_str());
+		}
+		return result;
 	}
 
     int32_t NvModelExt::WriteFileHeader(FILE* fp) const {
@@ -313,16 +549,22 @@ namespace Nv
         return bytesWritten;
     }
 
-    int32_t NvModelExt::WriteMeshes(FILE* fp) {
+    int32_t NvModelExt::WriteMeshes(FILE* fp, bool packVertices) {
         int32_t totalBytesWritten = 0;
 
         uint32_t meshCount = GetMeshCount();
 
+#ifdef _DEBUG
+        // Totals for the packing report
+        VertexPackingReport modelReport;
+#endif
+
         // write mesh data blocks
         for (uint32_t i = 0; i < meshCount; i++) {
             SubMesh* pMesh = GetSubMesh(i);
             
             NvModelSubMeshHeader mhdr;
+            memset(&mhdr, 0, sizeof(NvModelSubMeshHeader));
             mhdr._vertexCount = pMesh->getVertexCount();
             mhdr._indexCount = pMesh->getIndexCount();
             mhdr._vertexSize = pMesh->getVertexSize();
@@ -344,6 +586,62 @@ namespace Nv
             mhdr._matIndex = pMesh->m_materialId;
             mhdr._parentBone = pMesh->m_parentBone;
 
+            // Submeshes that were loaded packed have no float vertices, so they
+            // are always written packed
+            const uint8_t* pVertexData = reinterpret_cast<const uint8_t*>(pMesh->getVertices());
+            const uint8_t* pIndexData = reinterpret_cast<const uint8_t*>(pMesh->getIndices());
+            uint32_t vertexDataSize = mhdr._indexArrayBase - mhdr._vertArrayBase;
+            uint32_t indexDataSize = pMesh->getIndexCount() * sizeof(uint32_t);
+            PackedVertexLayout layout;
+            std::vector<uint8_t> packedVertices;
+            std::vector<uint8_t> packedIndices;
+            if (pMesh->HasPackedVertices())
+            {
+                layout = pMesh->getPackedLayout();
+                pVertexData = pMesh->getPackedVertices();
+                pIndexData = pMesh->getPackedIndices();
+            }
+            else if (packVertices)
+            {
+                VertexPacker::Pack(pMesh, layout, packedVertices, packedIndices);
+                pVertexData = packedVertices.empty() ? NULL : &packedVertices[0];
+                pIndexData = packedIndices.empty() ? NULL : &packedIndices[0];
+
+#ifdef _DEBUG
+                VertexPackingReport report = VertexPacker::ComputeReport(pMesh, layout, packedVertices, packedIndices);
+                modelReport.m_floatBytes += report.m_floatBytes;
+                modelReport.m_packedBytes += report.m_packedBytes;
+                modelReport.m_maxPositionError = std::max(modelReport.m_maxPositionError, report.m_maxPositionError);
+                modelReport.m_maxNormalError = std::max(modelReport.m_maxNormalError, report.m_maxNormalError);
+                modelReport.m_maxTexCoordError = std::max(modelReport.m_maxTexCoordError, report.m_maxTexCoordError);
+                modelReport.m_maxTangentError = std::max(modelReport.m_maxTangentError, report.m_maxTangentError);
+#endif
+            }
+
+            if (layout.m_vertexSize > 0)
+            {
+                vertexDataSize = layout.m_vertexSize * pMesh->getVertexCount();
+                indexDataSize = ((layout.m_indexSize * pMesh->getIndexCount()) + 3) & ~3;
+                mhdr._indexSize = layout.m_indexSize;
+                mhdr._indexArrayBase = mhdr._vertArrayBase + vertexDataSize;
+                mhdr._packedVertexSize = layout.m_vertexSize;
+                mhdr._packedPositionFormat = layout.m_positionFormat;
+                mhdr._packedNormalFormat = layout.m_normalFormat;
+                mhdr._packedTexCoordFormat = layout.m_texCoordFormat;
+                mhdr._packedTangentFormat = layout.m_tangentFormat;
+                mhdr._packedPositionOffset = layout.m_positionOffset;
+                mhdr._packedNormalOffset = layout.m_normalOffset;
+                mhdr._packedTexCoordOffset = layout.m_texCoordOffset;
+                mhdr._packedTangentOffset = layout.m_tangentOffset;
+                mhdr._packedColorOffset = layout.m_colorOffset;
+                mhdr._packedBoneIndexOffset = layout.m_boneIndexOffset;
+                mhdr._packedBoneWeightOffset = layout.m_boneWeightOffset;
+                for (int c = 0; c < 3; c++) {
+                    mhdr._positionScale[c] = layout.m_positionScale[c];
+                    mhdr._positionBias[c] = layout.m_positionBias[c];
+                }
+            }
+
             // Write out the header
             totalBytesWritten += fwrite(&mhdr, sizeof(NvModelSubMeshHeader), 1, fp) * sizeof(NvModelSubMeshHeader);
 
@@ -355,11 +653,22 @@ namespace Nv
             }
 
             // write vertex data
-            totalBytesWritten += fwrite(pMesh->getVertices(), sizeof(float), pMesh->getVertexCount() * pMesh->getVertexSize(), fp) * sizeof(float);
+            totalBytesWritten += fwrite(pVertexData, 1, vertexDataSize, fp);
 
             // write index data
-            totalBytesWritten += fwrite(pMesh->getIndices(), sizeof(uint32_t), pMesh->getIndexCount(), fp) * sizeof(uint32_t);
+            totalBytesWritten += fwrite(pIndexData, 1, indexDataSize, fp);
         }
+
+#ifdef _DEBUG
+        if (modelReport.m_floatBytes > 0)
+        {
+            LOGI("NvModelExt packed vertices: %u -> %u bytes (%.1f%%), max error: position %g, normal %.3f deg, texcoord %g, tangent %.3f deg",
+                modelReport.m_floatBytes, modelReport.m_packedBytes,
+                100.0f * float(modelReport.m_packedBytes) / float(modelReport.m_floatBytes),
+                modelReport.m_maxPositionError, modelReport.m_maxNormalError,
+                modelReport.m_maxTexCoordError, modelReport.m_maxTangentError);
+        }
+#endif
         return totalBytesWritten;
     }
 
@@ -34,33 +34,41 @@
 #include "NvModel/NvModelExt.h"
 #include "NvModelExtBin.h"
 #include "NvModelExtFile.h"
+#include "NvModelVertexPacker.h"
 #include "NvModel/NvSkeleton.h"
 
 namespace Nv
 {
-	NvModelExtBin::NvModelExtBin()
+	NvModelExtBin::NvModelExtBin() :
+		m_materials(NULL),
+		m_materialCount(0),
+		m_textureCount(0),
+		m_subMeshes(NULL),
+		m_meshCount(0)
 	{
 	}
 
 	NvModelExtBin::~NvModelExtBin()
 	{
+		delete[] m_subMeshes;
+		delete[] m_materials;
 	}
 
 	NvModelExtBin* NvModelExtBin::Create(const char* pFileName) {
-		NvModelExtBin* model = new NvModelExtBin;
 		if (NULL == ms_pLoader)
 		{
 			return NULL;
 		}
 
 		// Use the provided loader callback to load the file into memory
-		char *pData = ms_pLoader->LoadDataFromFile(pFileName);
+		size_t size = 0;
+		char *pData = ms_pLoader->LoadDataFromFileWithSize(pFileName, size);
 		if (NULL == pData)
 		{
 			return NULL;
 		}
 
-		model->LoadFromPreprocessed((uint8_t*)pData);
+		NvModelExtBin* model = CreateFromMemory((uint8_t*)pData, size);
 
 		// Free the OBJ buffer
 		ms_pLoader->ReleaseData(pData);
@@ -68,6 +76,16 @@ namespace Nv
 		return model;
 	}
 
+	NvModelExtBin* NvModelExtBin::CreateFromMemory(uint8_t* pData, size_t size) {
+		NvModelExtBin* model = new NvModelExtBin;
+		if (!model->LoadFromPreprocessed(pData, (0 == size) ? ~uint64_t(0) : uint64_t(size)))
+		{
+			delete model;
+			return NULL;
+		}
+		return model;
+	}
+
     // Helper function for reading in texture descriptions
     void ReadTextureDescs(NvModelTextureDesc* pSrcDescs, TextureDescArray& destArray, int32_t offset, int32_t count)
     {
@@ -86,9 +104,33 @@ namespace Nv
         }
     }
 
-    bool NvModelExtBin::LoadFromPreprocessed(uint8_t* data) {
+    // True if count elements of elementSize bytes, starting offset bytes into a
+    // block of blockSize bytes, lie within the block.  Negative offsets and
+    // counts are rejected, and the count is checked by division, so corrupt
+    // values cannot wrap around.
+    static bool IsArrayInBlock(int64_t offset, int64_t count, uint64_t elementSize, uint64_t blockSize)
+    {
+        if ((offset < 0) || (count < 0) || (uint64_t(offset) > blockSize))
+        {
+            return false;
+        }
+        return (0 == elementSize) || (uint64_t(count) <= (blockSize - uint64_t(offset)) / elementSize);
+    }
+
+    // True if a texture desc range of a material lies within its block; the
+    // offset of an empty range isn't used
+    static bool AreTextureDescsInBlock(int32_t offset, int32_t count, uint64_t descBytes)
+    {
+        return (0 == count) || IsArrayInBlock(int64_t(offset) * sizeof(NvModelTextureDesc), count, sizeof(NvModelTextureDesc), descBytes);
+    }
+
+    bool NvModelExtBin::LoadFromPreprocessed(uint8_t* data, uint64_t size) {
         NvModelExtFileHeader* hdr = (NvModelExtFileHeader*)data;
 
+        if (size < sizeof(NvModelExtFileHeader))
+        {
+            return false;
+        }
         if (hdr->_magic[0] != 'N' || hdr->_magic[1] != 'V' ||
             hdr->_magic[2] != 'M' || hdr->_magic[3] != 'E')
         {
@@ -101,10 +143,12 @@ namespace Nv
         case 2:
             return LoadFromPreprocessed_v2(data);
         case 3:
-            return LoadFromPreprocessed_v3(data);
+            return LoadFromPreprocessed_v3(data, size);
         case 4:
+            return LoadFromPreprocessed_v4(data, size);
+        case 5:
         default:
-            return LoadFromPreprocessed_v4(data);
+            return LoadFromPreprocessed_v5(data, size);
         }
     }
 
@@ -363,9 +407,14 @@ namespace Nv
         return true;
     }
 
-    bool NvModelExtBin::LoadFromPreprocessed_v3(uint8_t* data) {
+    bool NvModelExtBin::LoadFromPreprocessed_v3(uint8_t* data, uint64_t size) {
         NvModelExtFileHeader* hdr = (NvModelExtFileHeader*)data;
 
+        if (hdr->_headerSize > size)
+        {
+            return false;
+        }
+
         for (int i = 0; i < 3; i++) {
             m_boundingBoxMin[i] = hdr->_boundingBoxMin[i];
             m_boundingBoxMax[i] = hdr->_boundingBoxMax[i];
@@ -378,17 +427,32 @@ namespace Nv
         m_subMeshes = new SubMeshBin[m_meshCount];
         m_materials = new Material[m_materialCount];
 
-        uint8_t* pCurrentBufferPointer = ReadTextureBlock(data + hdr->_headerSize);
-        pCurrentBufferPointer = ReadSkeletonBlock(pCurrentBufferPointer);
-        pCurrentBufferPointer = ReadMaterials(pCurrentBufferPointer);
-        pCurrentBufferPointer = ReadMeshes_v3(pCurrentBufferPointer);
+        uint8_t* pCurrentBufferPointer = ReadTextureBlock(data + hdr->_headerSize, size - hdr->_headerSize);
+        if (NULL != pCurrentBufferPointer)
+        {
+            pCurrentBufferPointer = ReadSkeletonBlock(pCurrentBufferPointer, size - (pCurrentBufferPointer - data));
+        }
+        if (NULL != pCurrentBufferPointer)
+        {
+            pCurrentBufferPointer = ReadMaterials(pCurrentBufferPointer, size - (pCurrentBufferPointer - data));
+        }
+        if (NULL == pCurrentBufferPointer)
+        {
+            return false;
+        }
+        ReadMeshes_v3(pCurrentBufferPointer);
 
         return true;
     }
 
-    bool NvModelExtBin::LoadFromPreprocessed_v4(uint8_t* data) {
+    bool NvModelExtBin::LoadFromPreprocessed_v4(uint8_t* data, uint64_t size) {
         NvModelExtFileHeader* hdr = (NvModelExtFileHeader*)data;
 
+        if (hdr->_headerSize > size)
+        {
+            return false;
+        }
+
         for (int i = 0; i < 3; i++) {
             m_boundingBoxMin[i] = hdr->_boundingBoxMin[i];
             m_boundingBoxMax[i] = hdr->_boundingBoxMax[i];
@@ -401,17 +465,74 @@ namespace Nv
         m_subMeshes = new SubMeshBin[m_meshCount];
         m_materials = new Material[m_materialCount];
 
-        uint8_t* pCurrentBufferPointer = ReadTextureBlock(data + hdr->_headerSize);
-        pCurrentBufferPointer = ReadSkeletonBlock(pCurrentBufferPointer);
-        pCurrentBufferPointer = ReadMaterials(pCurrentBufferPointer);
-        pCurrentBufferPointer = ReadMeshes(pCurrentBufferPointer);
+        uint8_t* pCurrentBufferPointer = ReadTextureBlock(data + hdr->_headerSize, size - hdr->_headerSize);
+        if (NULL != pCurrentBufferPointer)
+        {
+            pCurrentBufferPointer = ReadSkeletonBlock(pCurrentBufferPointer, size - (pCurrentBufferPointer - data));
+        }
+        if (NULL != pCurrentBufferPointer)
+        {
+            pCurrentBufferPointer = ReadMaterials(pCurrentBufferPointer, size - (pCurrentBufferPointer - data));
+        }
+        if (NULL == pCurrentBufferPointer)
+        {
+            return false;
+        }
+        ReadMeshes_v4(pCurrentBufferPointer);
 
         return true;
     }
 
-    uint8_t* NvModelExtBin::ReadTextureBlock(uint8_t* pTextureBlock)
+    bool NvModelExtBin::LoadFromPreprocessed_v5(uint8_t* data, uint64_t size) {
+        NvModelExtFileHeader* hdr = (NvModelExtFileHeader*)data;
+
+        // Every submesh and material needs at least its header, which bounds
+        // the arrays allocated below
+        if ((hdr->_headerSize < sizeof(NvModelExtFileHeader)) ||
+            !IsArrayInBlock(hdr->_headerSize, hdr->_subMeshCount, sizeof(NvModelSubMeshHeader), size) ||
+            !IsArrayInBlock(hdr->_headerSize, hdr->_matCount, sizeof(NvModelMaterialHeader), size))
+        {
+            return false;
+        }
+
+        for (int i = 0; i < 3; i++) {
+            m_boundingBoxMin[i] = hdr->_boundingBoxMin[i];
+            m_boundingBoxMax[i] = hdr->_boundingBoxMax[i];
+            m_boundingBoxCenter[i] = hdr->_boundingBoxCenter[i];
+        }
+
+        m_meshCount = hdr->_subMeshCount;
+        m_materialCount = hdr->_matCount;
+
+        m_subMeshes = new SubMeshBin[m_meshCount];
+        m_materials = new Material[m_materialCount];
+
+        uint8_t* pCurrentBufferPointer = ReadTextureBlock(data + hdr->_headerSize, size - hdr->_headerSize);
+        if (NULL != pCurrentBufferPointer)
+        {
+            pCurrentBufferPointer = ReadSkeletonBlock(pCurrentBufferPointer, size - (pCurrentBufferPointer - data));
+        }
+        if (NULL != pCurrentBufferPointer)
+        {
+            pCurrentBufferPointer = ReadMaterials(pCurrentBufferPointer, size - (pCurrentBufferPointer - data));
+        }
+        if (NULL != pCurrentBufferPointer)
+        {
+            pCurrentBufferPointer = ReadMeshes(pCurrentBufferPointer, size - (pCurrentBufferPointer - data));
+        }
+
+        return (NULL != pCurrentBufferPointer);
+    }
+
+    uint8_t* NvModelExtBin::ReadTextureBlock(uint8_t* pTextureBlock, uint64_t available)
     {
         NvModelTextureBlockHeader* pTBH = reinterpret_cast<NvModelTextureBlockHeader*>(pTextureBlock);
+        if ((available < sizeof(NvModelTextureBlockHeader)) ||
+            (pTBH->_textureBlockSize > available) ||
+            !IsArrayInBlock(sizeof(NvModelTextureBlockHeader), pTBH->_textureCount, sizeof(uint32_t), pTBH->_textureBlockSize))
+        {
+            return NULL;
+        }
         m_textureCount = pTBH->_textureCount;
 
         // Read Texture names
@@ -422,9 +543,16 @@ namespace Nv
             // so that's where our string table offsets array starts
             uint32_t* pOffsets = reinterpret_cast<uint32_t*>(pTextureBlock + sizeof(NvModelTextureBlockHeader));
             char* pStringTable = reinterpret_cast<char*>(pOffsets + m_textureCount);
+            uint64_t stringTableSize = pTBH->_textureBlockSize - (reinterpret_cast<uint8_t*>(pStringTable) - pTextureBlock);
             for (uint32_t textureIndex = 0; textureIndex < m_textureCount; ++textureIndex)
             {
+                // Each name must end within the block
                 char* pString = pStringTable + pOffsets[textureIndex];
+                if ((pOffsets[textureIndex] >= stringTableSize) ||
+                    (NULL == memchr(pString, 0, size_t(stringTableSize - pOffsets[textureIndex]))))
+                {
+                    return NULL;
+                }
                 m_textures[textureIndex] = pString;
             }
         }
@@ -432,9 +560,39 @@ namespace Nv
         return pTextureBlock + pTBH->_textureBlockSize;
     }
 
-    uint8_t* NvModelExtBin::ReadSkeletonBlock(uint8_t* pSkeletonBlock)
+    uint8_t* NvModelExtBin::ReadSkeletonBlock(uint8_t* pSkeletonBlock, uint64_t available)
     {
         NvModelSkeletonDataBlockHeader* pSDBH = reinterpret_cast<NvModelSkeletonDataBlockHeader*>(pSkeletonBlock);
+        if ((available < sizeof(NvModelSkeletonDataBlockHeader)) ||
+            (pSDBH->_skeletonBlockSize > available) ||
+            !IsArrayInBlock(sizeof(NvModelSkeletonDataBlockHeader), pSDBH->_boneCount, sizeof(NvModelBoneData), pSDBH->_skeletonBlockSize))
+        {
+            return NULL;
+        }
+
+        // Each bone is followed by its name and its child and mesh indices, and
+        // its parent must come before it
+        uint64_t boneOffset = sizeof(NvModelSkeletonDataBlockHeader);
+        for (uint32_t boneIndex = 0; boneIndex < pSDBH->_boneCount; ++boneIndex)
+        {
+            if (!IsArrayInBlock(boneOffset, 1, sizeof(NvModelBoneData), pSDBH->_skeletonBlockSize))
+            {
+                return NULL;
+            }
+            NvModelBoneData* pSrcNode = reinterpret_cast<NvModelBoneData*>(pSkeletonBlock + boneOffset);
+            uint64_t nameOffset = boneOffset + sizeof(NvModelBoneData);
+            if ((pSrcNode->_parentIndex < -1) || (pSrcNode->_parentIndex >= int32_t(boneIndex)) ||
+                (pSrcNode->_nameLength <= 0) || (pSrcNode->_numChildren < 0) || (pSrcNode->_numMeshes < 0) ||
+                !IsArrayInBlock(nameOffset, pSrcNode->_nameLength, 1, pSDBH->_skeletonBlockSize) ||
+                (NULL == memchr(pSkeletonBlock + nameOffset, 0, pSrcNode->_nameLength)) ||
+                !IsArrayInBlock(nameOffset + pSrcNode->_nameLength, int64_t(pSrcNode->_numChildren) + pSrcNode->_numMeshes,
+                    sizeof(int32_t), pSDBH->_skeletonBlockSize))
+            {
+                return NULL;
+            }
+            boneOffset = nameOffset + pSrcNode->_nameLength + (int64_t(pSrcNode->_numChildren) + pSrcNode->_numMeshes) * sizeof(int32_t);
+        }
+
         uint32_t boneCount = pSDBH->_boneCount;
         if (boneCount > 0)
         {
@@ -471,17 +629,40 @@ namespace Nv
                     }
                 }
                 m_pSkeleton = new NvSkeleton(pDestNodes, boneCount);
+                delete[] pDestNodes;
             }
         }
 
         return pSkeletonBlock + pSDBH->_skeletonBlockSize;
     }
 
-    uint8_t* NvModelExtBin::ReadMaterials(uint8_t* pMaterials)
+    uint8_t* NvModelExtBin::ReadMaterials(uint8_t* pMaterials, uint64_t available)
     {
         NvModelMaterialHeader* pSrcMat = reinterpret_cast<NvModelMaterialHeader*>(pMaterials);
         for (uint32_t matIndex = 0; matIndex < m_materialCount; ++matIndex)
         {
+            // The header and its texture descs must lie within the block
+            uint64_t matOffset = reinterpret_cast<uint8_t*>(pSrcMat) - pMaterials;
+            if ((available - matOffset < sizeof(NvModelMaterialHeader)) ||
+                (pSrcMat->_materialBlockSize < sizeof(NvModelMaterialHeader)) ||
+                (pSrcMat->_materialBlockSize > available - matOffset))
+            {
+                return NULL;
+            }
+            uint64_t descBytes = pSrcMat->_materialBlockSize - sizeof(NvModelMaterialHeader);
+            if (!AreTextureDescsInBlock(pSrcMat->_ambientTextureOffset, pSrcMat->_ambientTextureCount, descBytes) ||
+                !AreTextureDescsInBlock(pSrcMat->_diffuseTextureOffset, pSrcMat->_diffuseTextureCount, descBytes) ||
+                !AreTextureDescsInBlock(pSrcMat->_specularTextureOffset, pSrcMat->_specularTextureCount, descBytes) ||
+                !AreTextureDescsInBlock(pSrcMat->_bumpMapTextureOffset, pSrcMat->_bumpMapTextureCount, descBytes) ||
+                !AreTextureDescsInBlock(pSrcMat->_reflectionTextureOffset, pSrcMat->_reflectionTextureCount, descBytes) ||
+                !AreTextureDescsInBlock(pSrcMat->_displacementMapTextureOffset, pSrcMat->_displacementMapTextureCount, descBytes) ||
+                !AreTextureDescsInBlock(pSrcMat->_specularPowerTextureOffset, pSrcMat->_specularPowerTextureCount, descBytes) ||
+                !AreTextureDescsInBlock(pSrcMat->_alphaMapTextureOffset, pSrcMat->_alphaMapTextureCount, descBytes) ||
+                !AreTextureDescsInBlock(pSrcMat->_decalTextureOffset, pSrcMat->_decalTextureCount, descBytes))
+            {
+                return NULL;
+            }
+
             Material* pDestMat = GetMaterial(matIndex);
             memcpy(&pDestMat->m_ambient, &(pSrcMat->_ambient), 3 * sizeof(float));
             memcpy(&pDestMat->m_diffuse, &(pSrcMat->_diffuse), 3 * sizeof(float));
@@ -564,13 +745,13 @@ namespace Nv
         return pMeshes;
     }
 
-    uint8_t* NvModelExtBin::ReadMeshes(uint8_t* pMeshes)
+    uint8_t* NvModelExtBin::ReadMeshes_v4(uint8_t* pMeshes)
     {
 
         // read mesh headers
         for (uint32_t i = 0; i < m_meshCount; i++)
         {
-            NvModelSubMeshHeader* pSrcMesh = reinterpret_cast<NvModelSubMeshHeader*>(pMeshes);
+            NvModelSubMeshHeader_v4* pSrcMesh = reinterpret_cast<NvModelSubMeshHeader_v4*>(pMeshes);
             SubMesh* pDestMesh = m_subMeshes + i;
 
             pDestMesh->m_vertexCount = pSrcMesh->_vertexCount;
@@ -592,7 +773,7 @@ namespace Nv
             int32_t boneCount = pSrcMesh->_boneMapCount;
             if (boneCount > 0)
             {
-                uint8_t* pBoneMap = pMeshes + sizeof(NvModelSubMeshHeader);
+                uint8_t* pBoneMap = pMeshes + sizeof(NvModelSubMeshHeader_v4);
                 uint32_t boneMapSize = sizeof(int32_t) * boneCount;
                 pDestMesh->m_boneMap.resize(boneCount);
                 memcpy(&(pDestMesh->m_boneMap[0]), pBoneMap, boneMapSize);
@@ -616,6 +797,133 @@ namespace Nv
         return pMeshes;
     }
 
+    uint8_t* NvModelExtBin::ReadMeshes(uint8_t* pMeshes, uint64_t available)
+    {
+
+        // read mesh headers
+        for (uint32_t i = 0; i < m_meshCount; i++)
+        {
+            NvModelSubMeshHeader* pSrcMesh = reinterpret_cast<NvModelSubMeshHeader*>(pMeshes);
+            SubMesh* pDestMesh = m_subMeshes + i;
+
+            // The header, bone map and vertex array must lie within the data; the
+            // index array is checked below, once the size of an index is known
+            if (available < sizeof(NvModelSubMeshHeader))
+            {
+                return NULL;
+            }
+            bool packed = (0 != pSrcMesh->_packedVertexSize);
+            uint64_t vertexBytes = packed ? uint64_t(int64_t(pSrcMesh->_packedVertexSize)) : uint64_t(pSrcMesh->_vertexSize) * sizeof(float);
+            if (!IsArrayInBlock(sizeof(NvModelSubMeshHeader), pSrcMesh->_boneMapCount, sizeof(int32_t) + sizeof(nv::matrix4f), available) ||
+                (packed && (pSrcMesh->_packedVertexSize < 0)) ||
+                !IsArrayInBlock(pSrcMesh->_vertArrayBase, pSrcMesh->_vertexCount, vertexBytes, available))
+            {
+                return NULL;
+            }
+
+            pDestMesh->m_vertexCount = pSrcMesh->_vertexCount;
+            pDestMesh->m_indexCount = pSrcMesh->_indexCount;
+            pDestMesh->m_vertSize = pSrcMesh->_vertexSize;
+            pDestMesh->m_normalOffset = pSrcMesh->_nOffset;
+            pDestMesh->m_texCoordOffset = pSrcMesh->_tcOffset;
+            pDestMesh->m_texCoordCount = pSrcMesh->_tcSize;
+            pDestMesh->m_tangentOffset = pSrcMesh->_sTanOffset;
+            pDestMesh->m_colorOffset = pSrcMesh->_cOffset;
+            pDestMesh->m_colorCount = pSrcMesh->_colorCount;
+            pDestMesh->m_boneIndexOffset = pSrcMesh->_boneIndexOffset;
+            pDestMesh->m_boneWeightOffset = pSrcMesh->_boneWeightOffset;
+            pDestMesh->m_bonesPerVertex = pSrcMesh->_bonesPerVertex;
+            pDestMesh->m_materialId = pSrcMesh->_matIndex;
+            pDestMesh->m_parentBone = pSrcMesh->_parentBone;
+
+            // Read in the bone map
+            int32_t boneCount = pSrcMesh->_boneMapCount;
+            if (boneCount > 0)
+            {
+                uint8_t* pBoneMap = pMeshes + sizeof(NvModelSubMeshHeader);
+                uint32_t boneMapSize = sizeof(int32_t) * boneCount;
+                pDestMesh->m_boneMap.resize(boneCount);
+                memcpy(&(pDestMesh->m_boneMap[0]), pBoneMap, boneMapSize);
+
+                uint8_t* pBoneTransforms = pBoneMap + boneMapSize;
+                uint32_t boneTransformsSize = sizeof(nv::matrix4f) * boneCount;
+                pDestMesh->m_meshToBoneTransforms.resize(boneCount);
+                memcpy(&(pDestMesh->m_meshToBoneTransforms[0]), pBoneTransforms, boneTransformsSize);
+            }
+
+            if (!packed)
+            {
+                if (!IsArrayInBlock(pSrcMesh->_indexArrayBase, pSrcMesh->_indexCount, sizeof(uint32_t), available))
+                {
+                    return NULL;
+                }
+
+                uint32_t vertBufferSize = pDestMesh->m_vertSize * pDestMesh->m_vertexCount * sizeof(float);
+                pDestMesh->m_vertices = new float[pDestMesh->m_vertSize * pDestMesh->m_vertexCount];
+                memcpy(pDestMesh->m_vertices, pMeshes + pSrcMesh->_vertArrayBase, vertBufferSize);
+
+                uint32_t indexBufferSize = pDestMesh->m_indexCount * sizeof(uint32_t);
+                pDestMesh->m_indices = new uint32_t[pDestMesh->m_indexCount];
+                memcpy(pDestMesh->m_indices, pMeshes + pSrcMesh->_indexArrayBase, indexBufferSize);
+
+                pMeshes += pSrcMesh->_indexArrayBase + indexBufferSize;
+                available -= pSrcMesh->_indexArrayBase + indexBufferSize;
+                continue;
+            }
+
+            PackedVertexLayout layout;
+            layout.m_positionFormat = static_cast<VertexFormat>(pSrcMesh->_packedPositionFormat);
+            layout.m_normalFormat = static_cast<VertexFormat>(pSrcMesh->_packedNormalFormat);
+            layout.m_texCoordFormat = static_cast<VertexFormat>(pSrcMesh->_packedTexCoordFormat);
+            layout.m_tangentFormat = static_cast<VertexFormat>(pSrcMesh->_packedTangentFormat);
+            layout.m_positionOffset = pSrcMesh->_packedPositionOffset;
+            layout.m_normalOffset = pSrcMesh->_packedNormalOffset;
+            layout.m_texCoordOffset = pSrcMesh->_packedTexCoordOffset;
+            layout.m_tangentOffset = pSrcMesh->_packedTangentOffset;
+            layout.m_colorOffset = pSrcMesh->_packedColorOffset;
+            layout.m_boneIndexOffset = pSrcMesh->_packedBoneIndexOffset;
+            layout.m_boneWeightOffset = pSrcMesh->_packedBoneWeightOffset;
+            layout.m_vertexSize = pSrcMesh->_packedVertexSize;
+            layout.m_indexSize = pSrcMesh->_indexSize;
+            layout.m_positionScale = nv::vec3f(pSrcMesh->_positionScale);
+            layout.m_positionBias = nv::vec3f(pSrcMesh->_positionBias);
+
+            // The index array is padded to a multiple of 4 bytes
+            if (!VertexPacker::IsLayoutValid(pDestMesh, layout) ||
+                !IsArrayInBlock(pSrcMesh->_indexArrayBase, (int64_t(layout.m_indexSize) * pDestMesh->m_indexCount + 3) / 4,
+                    sizeof(uint32_t), available))
+            {
+                return NULL;
+            }
+
+            const uint8_t* pPackedVertices = pMeshes + pSrcMesh->_vertArrayBase;
+            const uint8_t* pPackedIndices = pMeshes + pSrcMesh->_indexArrayBase;
+            uint32_t vertBufferSize = layout.m_vertexSize * pDestMesh->m_vertexCount;
+            uint32_t indexBufferSize = ((layout.m_indexSize * pDestMesh->m_indexCount) + 3) & ~3;
+
+            if (ms_decodePackedVertices)
+            {
+                pDestMesh->m_vertices = new float[pDestMesh->m_vertSize * pDestMesh->m_vertexCount];
+                VertexPacker::UnpackVertices(pDestMesh, layout, pPackedVertices, pDestMesh->m_vertexCount, pDestMesh->m_vertices);
+
+                pDestMesh->m_indices = new uint32_t[pDestMesh->m_indexCount];
+                VertexPacker::UnpackIndices(pPackedIndices, layout.m_indexSize, pDestMesh->m_indexCount, pDestMesh->m_indices);
+            }
+            else
+            {
+                pDestMesh->m_packedLayout = layout;
+                pDestMesh->m_packedVertices = new uint8_t[vertBufferSize];
+                memcpy(pDestMesh->m_packedVertices, pPackedVertices, vertBufferSize);
+                pDestMesh->m_packedIndices = new uint8_t[indexBufferSize];
+                memcpy(pDestMesh->m_packedIndices, pPackedIndices, indexBufferSize);
+            }
+
+            pMeshes += pSrcMesh->_indexArrayBase + indexBufferSize;
+            available -= pSrcMesh->_indexArrayBase + indexBufferSize;
+        }
+        return pMeshes;
+    }
+
 
 
 }
@@ -50,6 +50,14 @@ namespace Nv
 
 		static NvModelExtBin* Create(const char* pFileName);
 
+		/// Creates a model from preprocessed model data that has already been loaded into memory
+		/// \param[in] pData Pointer to the preprocessed model data.  The model copies everything
+		///            it needs, so the data may be released once the model has been created.
+		/// \param[in] size Size of the data in bytes, or 0 if unknown.  Version 3 and later
+		///            files whose blocks or meshes don't fit in it are rejected.
+		/// \return A pointer to the new model, or NULL if the data isn't a preprocessed model
+		static NvModelExtBin* CreateFromMemory(uint8_t* pData, size_t size);
+
 		/// Returns the number of meshes contained in the model
 		/// \return Number of meshes contained in the model
 		virtual uint32_t GetMeshCount() const { return m_meshCount; }
@@ -94,17 +102,21 @@ namespace Nv
 	protected:
 		NvModelExtBin();
 
-        bool LoadFromPreprocessed(uint8_t* data);
+        bool LoadFromPreprocessed(uint8_t* data, uint64_t size);
         bool LoadFromPreprocessed_v1(uint8_t* data);
         bool LoadFromPreprocessed_v2(uint8_t* data);
-        bool LoadFromPreprocessed_v3(uint8_t* data);
-        bool LoadFromPreprocessed_v4(uint8_t* data);
-
-        uint8_t* ReadTextureBlock(uint8_t* pTextureBlock);
-        uint8_t* ReadSkeletonBlock(uint8_t* pSkeletonBlock);
-        uint8_t* ReadMaterials(uint8_t* pMaterials);
+        bool LoadFromPreprocessed_v3(uint8_t* data, uint64_t size);
+        bool LoadFromPreprocessed_v4(uint8_t* data, uint64_t size);
+        bool LoadFromPreprocessed_v5(uint8_t* data, uint64_t size);
+
+        // Each reader is given the number of bytes from the start of its block to
+        // the end of the data, and returns NULL if the block doesn't fit in them
+        uint8_t* ReadTextureBlock(uint8_t* pTextureBlock, uint64_t available);
+        uint8_t* ReadSkeletonBlock(uint8_t* pSkeletonBlock, uint64_t available);
+        uint8_t* ReadMaterials(uint8_t* pMaterials, uint64_t available);
         uint8_t* ReadMeshes_v3(uint8_t* pMeshes);
-        uint8_t* ReadMeshes(uint8_t* pMeshes);
+        uint8_t* ReadMeshes_v4(uint8_t* pMeshes);
+        uint8_t* ReadMeshes(uint8_t* pMeshes, uint64_t available);
 
 
 		Material* m_materials;
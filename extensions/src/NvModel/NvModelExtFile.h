@@ -36,9 +36,9 @@
 
 namespace Nv
 {
-    static const uint32_t NVMODEL_FILE_VERSION = 4;
+    static const uint32_t NVMODEL_FILE_VERSION = 5;
 
-    // File structure (v4):
+    // File structure (v4 and v5):
     // All structures and component elements MUST be 4-byte aligned
     // NvModelExtFileHeader
     // NvModelTextureBlock
@@ -164,6 +164,38 @@ namespace Nv
         int32_t _matIndex;
     };
 
+    struct NvModelSubMeshHeader_v4 {
+        uint32_t _vertexCount;
+        uint32_t _indexCount;
+        uint32_t _vertexSize; // size of each vert IN BYTES!
+        uint32_t _indexSize; // size of each index IN BYTES!
+        int32_t _pOffset;
+        int32_t _nOffset;
+        int32_t _tcOffset;
+        int32_t _sTanOffset;
+        int32_t _cOffset;
+        int32_t _boneIndexOffset;
+        int32_t _boneWeightOffset;
+        int32_t _posSize;
+        int32_t _tcSize;
+        int32_t _colorCount;
+        int32_t _bonesPerVertex;
+        int32_t _boneMapCount;
+
+        // offset in bytes from the start of the block
+        // (in version 1, this was the offset in bytes 
+        //  from the start of the file)
+        int32_t _vertArrayBase;
+
+        // offset in bytes from the start of the block
+        // (in version 1, this was the offset in bytes 
+        //  from the start of the file)
+        int32_t _indexArrayBase;
+        int32_t _matIndex;
+
+        int32_t _parentBone;
+    };
+
     struct NvModelSubMeshHeader {
         uint32_t _vertexCount;
         uint32_t _indexCount;
@@ -194,6 +226,25 @@ namespace Nv
         int32_t _matIndex;
 
         int32_t _parentBone;
+
+        // Size of each packed vert IN BYTES, or 0 if the verts are stored
+        // as _vertexSize floats.  The layout below is only valid if non-zero.
+        // Packed indices are _indexSize bytes each, and the index array is
+        // padded to a multiple of 4 bytes.
+        int32_t _packedVertexSize;
+        int32_t _packedPositionFormat; // VertexFormat
+        int32_t _packedNormalFormat;
+        int32_t _packedTexCoordFormat;
+        int32_t _packedTangentFormat;
+        int32_t _packedPositionOffset; // offsets within the packed vert IN BYTES
+        int32_t _packedNormalOffset;
+        int32_t _packedTexCoordOffset;
+        int32_t _packedTangentOffset;
+        int32_t _packedColorOffset;
+        int32_t _packedBoneIndexOffset;
+        int32_t _packedBoneWeightOffset;
+        float _positionScale[3];
+        float _positionBias[3];
     };
 
     struct NvModelMaterialHeader_v1 {
@@ -248,6 +299,23 @@ namespace Nv
         int32_t _illumModel;
 	};
 
+    // Version of the cache files written by NvModelExt::CreateFromObj.  Must be
+    // incremented whenever a change to OBJ loading or processing would produce
+    // a different model from the same source file, so that existing cache files
+    // are rebuilt rather than reused.
+    static const uint32_t NVMODEL_CACHE_VERSION = 3;
+
+    // Cache file structure:
+    // NvModelExtCacheHeader
+    // Preprocessed model file (see above), of _modelSize bytes
+    struct NvModelExtCacheHeader {
+        uint8_t _magic[4];
+        uint32_t _headerSize; // includes magic
+        uint32_t _version;
+        uint32_t _modelSize;
+        uint64_t _sourceKey; // hash of the source files and the load options used to create the model
+    };
+
 }
 
 #endif
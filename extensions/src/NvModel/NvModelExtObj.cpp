@@ -37,6 +37,12 @@
 #include <NV/NvTokenizer.h>
 #include "NvModelMeshFace.h"
 #include "NvModelSubMeshObj.h"
+#include "NvModelVertexCacheOptimizer.h"
+#include <NV/NvLogs.h>
+#include <NsAllocator.h>
+#include <NsJobSystem.h>
+#include <algorithm>
+#include <string.h>
 
 namespace Nv
 {
@@ -81,25 +87,332 @@ namespace Nv
     };
 #endif
 
+    // Files smaller than this are parsed on the calling thread, as the cost of
+    // starting worker threads would outweigh the time saved tokenizing in parallel
+    static const size_t sObjParallelMinSize = 1024 * 1024;
+
+    // Approximate size of each section of the file tokenized by a worker thread.
+    // Chunks are extended to end on a line boundary.
+    static const size_t sObjChunkSize = 2 * 1024 * 1024;
+
+    struct NvModelExtObj::ObjParseState
+    {
+        ObjParseState(SubMeshObj* pSubMesh) :
+            m_currentMaterial(0),
+            m_currentSmoothingGroup(0),
+            m_currentSubMesh(pSubMesh),
+            m_bHas4CompPos(false),
+            m_bHas3CompTex(false),
+            m_bBoundingBoxInitialized(false),
+            m_nextPosIndex(0),
+            m_nextNormalIndex(0),
+            m_nextTexCoordIndex(0)
+        {}
+
+        int32_t m_currentMaterial;
+        int32_t m_currentSmoothingGroup;
+        SubMeshObj* m_currentSubMesh;
+
+        bool m_bHas4CompPos;
+        bool m_bHas3CompTex;
+        bool m_bBoundingBoxInitialized;
+        int32_t m_nextPosIndex;
+        int32_t m_nextNormalIndex;
+        int32_t m_nextTexCoordIndex;
+
+        // Scratch storage for the OBJ indices of the face being parsed, three per
+        // vertex, so that it doesn't need to be reallocated for every face
+        std::vector<int32_t> m_faceIndices;
+    };
+
+    struct NvModelExtObj::ObjChunk
+    {
+        enum RecordType
+        {
+            Record_Position = 0,
+            Record_Normal = 1,
+            Record_TexCoord = 2,
+            Record_Face = 3,
+            Record_Statement = 4
+        };
+
+        // A single line of the chunk, either already converted to binary
+        // (vertex components and faces) or, for anything that the fast path
+        // doesn't handle, the location of the text to be parsed when replayed.
+        struct Record
+        {
+            uint32_t m_type;
+
+            // Component count for vertex components, vertex count for faces
+            // or character count for statements
+            uint32_t m_count;
+
+            // Offset of the first index in m_faceIndices for faces or of the first
+            // character relative to m_pBegin for statements
+            uint32_t m_offset;
+
+            // Face format (OBJFaceFormat) for faces
+            uint32_t m_format;
+
+            float m_values[4];
+        };
+
+        const char* m_pBegin;
+        const char* m_pEnd;
+        std::vector<Record> m_records;
+        std::vector<int32_t> m_faceIndices;
+    };
+
+    static inline bool IsObjWhitespace(char c)
+    {
+        return (c == ' ') || (c == '\t');
+    }
+
+    static inline bool IsObjEOL(char c)
+    {
+        return (c == '\n') || (c == '\r');
+    }
+
+    static inline bool IsObjDigit(char c)
+    {
+        return (c >= '0') && (c <= '9');
+    }
+
+    // Parses a whitespace delimited float the same way NvTokenizer::getTokenFloat does.
+    // Decimal values with up to 15 significant digits and small exponents are converted
+    // exactly without calling strtod (which dominates the cost of parsing large files),
+    // others are handed to strtod.  Returns false for tokens containing characters that 
+    // aren't part of a plain decimal number, leaving those lines to the tokenizer.
+    static bool ParseObjFloat(const char* pBegin, const char* pEnd, float& out)
+    {
+        static const double sPow10[] =
+        {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        for (const char* p = pBegin; p < pEnd; ++p)
+        {
+            char c = *p;
+            if (!IsObjDigit(c) && (c != '.') && (c != '-') && (c != '+') && (c != 'e') && (c != 'E'))
+            {
+                return false;
+            }
+        }
+
+        const char* p = pBegin;
+        bool bNegative = false;
+        if ((p < pEnd) && ((*p == '-') || (*p == '+')))
+        {
+            bNegative = (*p == '-');
+            ++p;
+        }
+
+        uint64_t mantissa = 0;
+        int32_t exponent = 0;
+        uint32_t digitCount = 0;
+        uint32_t significantDigits = 0;
+        for (; (p < pEnd) && IsObjDigit(*p); ++p, ++digitCount)
+        {
+            if ((mantissa != 0) || (*p != '0'))
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                ++significantDigits;
+            }
+        }
+        if ((p < pEnd) && (*p == '.'))
+        {
+            for (++p; (p < pEnd) && IsObjDigit(*p); ++p, ++digitCount)
+            {
+                if ((mantissa != 0) || (*p != '0'))
+                {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    ++significantDigits;
+                }
+                --exponent;
+            }
+        }
+
+        bool bExact = (digitCount > 0) && (significantDigits <= 15);
+        if (bExact && (p < pEnd) && ((*p == 'e') || (*p == 'E')))
+        {
+            ++p;
+            bool bNegativeExp = false;
+            if ((p < pEnd) && ((*p == '-') || (*p == '+')))
+            {
+                bNegativeExp = (*p == '-');
+                ++p;
+            }
+            int32_t exp = 0;
+            uint32_t expDigits = 0;
+            for (; (p < pEnd) && IsObjDigit(*p) && (expDigits < 4); ++p, ++expDigits)
+            {
+                exp = exp * 10 + (*p - '0');
+            }
+            bExact = (expDigits > 0);
+            exponent += bNegativeExp ? -exp : exp;
+        }
+
+        if (bExact && (p == pEnd) && (exponent >= -22) && (exponent <= 22))
+        {
+            // Both the mantissa and the power of ten are exactly representable as
+            // doubles, so a single multiply or divide gives the correctly rounded
+            // result, matching strtod
+            double value = (double)mantissa;
+            value = (exponent < 0) ? (value / sPow10[-exponent]) : (value * sPow10[exponent]);
+            out = (float)(bNegative ? -value : value);
+            return true;
+        }
+
+        char buffer[64];
+        size_t length = pEnd - pBegin;
+        if (length >= sizeof(buffer))
+        {
+            return false;
+        }
+        memcpy(buffer, pBegin, length);
+        buffer[length] = '\0';
+        out = (float)strtod(buffer, NULL);
+        return true;
+    }
+
+    // Parses an OBJ index the same way NvTokenizer::getTokenInt does, accepting
+    // only plain decimal values that fit in an int32_t
+    static bool ParseObjIndex(const char* pBegin, const char* pEnd, int32_t& out)
+    {
+        const char* p = pBegin;
+        bool bNegative = false;
+        if ((p < pEnd) && ((*p == '-') || (*p == '+')))
+        {
+            bNegative = (*p == '-');
+            ++p;
+        }
+
+        // A leading zero would make strtol treat the value as octal
+        size_t digitCount = pEnd - p;
+        if ((digitCount == 0) || (digitCount > 9) || ((*p == '0') && (digitCount > 1)))
+        {
+            return false;
+        }
+
+        int32_t value = 0;
+        for (; p < pEnd; ++p)
+        {
+            if (!IsObjDigit(*p))
+            {
+                return false;
+            }
+            value = value * 10 + (*p - '0');
+        }
+        out = bNegative ? -value : value;
+        return true;
+    }
+
+    // Parses all of the whitespace delimited floats between pBegin and pEnd,
+    // returning the number read, or ~0 if there were more than maxCount or
+    // one of them couldn't be parsed
+    static uint32_t ParseObjFloats(const char* pBegin, const char* pEnd, float* pOut, uint32_t maxCount)
+    {
+        uint32_t count = 0;
+        const char* p = pBegin;
+        for (;;)
+        {
+            while ((p < pEnd) && IsObjWhitespace(*p))
+            {
+                ++p;
+            }
+            if (p == pEnd)
+            {
+                return count;
+            }
+            const char* pToken = p;
+            while ((p < pEnd) && !IsObjWhitespace(*p))
+            {
+                ++p;
+            }
+            if ((count == maxCount) || !ParseObjFloat(pToken, p, pOut[count]))
+            {
+                return ~0U;
+            }
+            ++count;
+        }
+    }
+
 	NvModelExtObj* NvModelExtObj::Create(const char* filename, float scale, 
 		bool generateNormals, bool generateTangents,
 		float vertMergeThreshold, float normMergeThreshold, uint32_t initialVertCount)
 	{
-		NvModelExtObj* pModel = new NvModelExtObj(vertMergeThreshold, normMergeThreshold);
+		NvModelExtObj* pModel = new NvModelExtObj(vertMergeThreshold, normMergeThreshold, initialVertCount);
 		pModel->LoadObjFromFile(filename);
-		pModel->RescaleToOrigin(scale);
+		pModel->ProcessLoadedModel(scale, generateNormals, generateTangents);
+		return pModel;
+	}
+
+	NvModelExtObj* NvModelExtObj::CreateFromMemory(const char* pFileData, float scale,
+		bool generateNormals, bool generateTangents,
+		float vertMergeThreshold, float normMergeThreshold, uint32_t initialVertCount)
+	{
+		NvModelExtObj* pModel = new NvModelExtObj(vertMergeThreshold, normMergeThreshold, initialVertCount);
+		if (!pModel->LoadObjFromMemory(pFileData))
+		{
+			// Don't hand out (or cache) a model that stopped part way through the file
+			delete pModel;
+			return NULL;
+		}
+		pModel->ProcessLoadedModel(scale, generateNormals, generateTangents);
+		return pModel;
+	}
+
+	void NvModelExtObj::ProcessLoadedModel(float scale, bool generateNormals, bool generateTangents)
+	{
+		RescaleToOrigin(scale);
 		if (generateNormals)
-			pModel->GenerateNormals();
+			GenerateNormals();
 
 		if (generateTangents)
-			pModel->GenerateTangents();
+			GenerateTangents();
 
-		for (uint32_t i = 0; i < pModel->m_subMeshes.size(); i++) {
-			pModel->InitProcessedVerts(i);
-			pModel->InitProcessedIndices(i);
+		for (uint32_t i = 0; i < m_subMeshes.size(); i++) {
+			InitProcessedVerts(i);
+			InitProcessedIndices(i);
 		}
 
-		return pModel;
+		if (ms_optimizeVertexCache)
+			OptimizeVertexCache();
+	}
+
+	void NvModelExtObj::OptimizeVertexCache()
+	{
+		// Accumulate the transforms each submesh needs before and after
+		// optimization, so debug builds can report the model's overall ratios
+		float missesBefore = 0.0f;
+		float missesAfter = 0.0f;
+		uint32_t triCount = 0;
+		uint32_t vertCount = 0;
+		for (uint32_t i = 0; i < m_subMeshes.size(); i++) {
+			SubMeshObj* pSubMesh = m_subMeshes[i];
+			if ((NULL == pSubMesh->m_indices) || (pSubMesh->m_indexCount < 3))
+				continue;
+
+			VertexCacheStats before, after;
+			VertexCacheOptimizer::Optimize(pSubMesh->m_indices, pSubMesh->m_indexCount,
+				pSubMesh->m_vertices, pSubMesh->m_vertexCount, pSubMesh->m_vertSize, &before, &after);
+
+			uint32_t subMeshTris = pSubMesh->m_indexCount / 3;
+			missesBefore += before.m_acmr * subMeshTris;
+			missesAfter += after.m_acmr * subMeshTris;
+			triCount += subMeshTris;
+			vertCount += pSubMesh->m_vertexCount;
+		}
+
+#ifdef _DEBUG
+		if ((triCount > 0) && (vertCount > 0))
+		{
+			LOGI("NvModelExt vertex cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+				missesBefore / triCount, missesAfter / triCount,
+				missesBefore / vertCount, missesAfter / vertCount);
+		}
+#endif
 	}
 
 	NvModelExtObj::NvModelExtObj(float vertMergeThreshold, float normMergeThreshold, uint32_t initialVertCount) :
@@ -213,470 +526,553 @@ namespace Nv
 
 	bool NvModelExtObj::LoadObjFromMemory(const char* pFileData)
     {
-        NvTokenizer tok(pFileData, "/");
+        ObjParseState state(GetSubMeshForMaterial(0));
 
-        int32_t currentMaterial = 0;
-        int32_t currentSmoothingGroup = 0;
-		SubMeshObj* currentSubMesh = GetSubMeshForMaterial(0);
+        uint32_t threadCount = 1;
+        if (NULL != ms_pJobSystem)
+        {
+            threadCount = ms_objParseThreadCount;
+            if (0 == threadCount)
+            {
+                threadCount = ms_pJobSystem->getThreadCount();
+            }
+        }
+
+        size_t length = strlen(pFileData);
+        bool result;
+        if ((threadCount > 1) && (length >= sObjParallelMinSize))
+        {
+            result = ParseObjParallel(pFileData, length, threadCount, state);
+        }
+        else
+        {
+            result = ParseObjSerial(pFileData, state);
+        }
+
+        if (!result)
+        {
+            return false;
+        }
+
+        m_numPositionComponents = state.m_bHas4CompPos ? 4 : 3;
+        m_numTexCoordComponents = state.m_bHas3CompTex ? 3 : 2;
+
+        OptimizeModel();
 
-        bool bHas4CompPos = false;
-        bool bHas3CompTex = false;
-        bool bBoundingBoxInitialized = false;
-        int32_t nextPosIndex = 0;
-        int32_t nextNormalIndex = 0;
-        int32_t nextTexCoordIndex = 0;
+        return true;
+    }
 
+	bool NvModelExtObj::ParseObjSerial(const char* pLoadData, ObjParseState& state)
+    {
+        NvTokenizer tok(pLoadData, "/");
         while (!tok.atEOF())
         {
-            if (!tok.readToken())
+            if (!ParseObjStatement(tok, state))
             {
-                tok.consumeToEOL();
-                continue; // likely EOL we didn't explicitly handle?
+                return false;
             }
+        }
+        return true;
+    }
 
-            const char* tmp = tok.getLastTokenPtr();
-            uint32_t compCount = 0;
+	bool NvModelExtObj::ParseObjParallel(const char* pLoadData, size_t length, uint32_t threadCount, ObjParseState& state)
+    {
+        // Split the file into chunks that each end on a line boundary, so that
+        // every statement is wholly contained in a single chunk
+        std::vector<ObjChunk> chunks;
+        chunks.reserve(length / sObjChunkSize + 1);
+        const char* pFileEnd = pLoadData + length;
+        const char* pChunkBegin = pLoadData;
+        while (pChunkBegin < pFileEnd)
+        {
+            const char* pChunkEnd = pChunkBegin + std::min(sObjChunkSize, size_t(pFileEnd - pChunkBegin));
+            while ((pChunkEnd < pFileEnd) && !IsObjEOL(*pChunkEnd))
+            {
+                ++pChunkEnd;
+            }
+            while ((pChunkEnd < pFileEnd) && IsObjEOL(*pChunkEnd))
+            {
+                ++pChunkEnd;
+            }
 
-            switch (tmp[0])
+            chunks.push_back(ObjChunk());
+            chunks.back().m_pBegin = pChunkBegin;
+            chunks.back().m_pEnd = pChunkEnd;
+            pChunkBegin = pChunkEnd;
+        }
+
+        // Keep up to threadCount chunks being tokenized at once, while this thread
+        // adds each chunk's contents to the model as soon as it has been tokenized.
+        // Vertex welding and face assembly depend on everything that came before them
+        // in the file, so they stay on this thread and happen in file order.
+        nvidia::shdfnd::JobSystem& jobSystem = *ms_pJobSystem;
+        nvidia::shdfnd::JobCounter* counters = new nvidia::shdfnd::JobCounter[chunks.size()];
+        size_t nextChunkToStart = 0;
+        bool result = true;
+        for (size_t chunkIndex = 0; chunkIndex < chunks.size(); ++chunkIndex)
+        {
+            while (result && (nextChunkToStart < chunks.size()) && (nextChunkToStart < chunkIndex + threadCount))
             {
-            case '#':
+                jobSystem.run(TokenizeObjChunk, &chunks[nextChunkToStart], counters[nextChunkToStart]);
+                ++nextChunkToStart;
+            }
+
+            if (chunkIndex >= nextChunkToStart)
             {
-                //comment line, eat the remainder
-                tok.consumeToEOL();
-                break;
+                // Parsing failed before this chunk was started
+                continue;
             }
-            case 'v':
+
+            jobSystem.wait(counters[chunkIndex]);
+
+            ObjChunk& chunk = chunks[chunkIndex];
+            if (result)
             {
-                // Some kind of vertex component
-                switch (tmp[1])
-                {
-                case '\0':
-                {
-                    nv::vec4f pos;
-                    //vertex position, 3 or 4 components
-                    pos.w = 1.0f;  //default w coordinate
+                result = ReplayObjChunk(chunk, state);
+            }
 
-                    compCount = tok.getTokenFloatArray((float*)pos, 4);
-                    NV_ASSERT(compCount > 2 && compCount < 5);
-                    if (bBoundingBoxInitialized)
-                    {
-                        // Grow our bounding box, if necessary
-                        m_boundingBoxMin = nv::min(m_boundingBoxMin, (nv::vec3f)pos);
-                        m_boundingBoxMax = nv::max(m_boundingBoxMax, (nv::vec3f)pos);
-                    }
-                    else
-                    {
-                        // Make sure that our bounding box starts out with a valid, contained point
-                        m_boundingBoxMin = (nv::vec3f)pos;
-                        m_boundingBoxMax = (nv::vec3f)pos;
-                        bBoundingBoxInitialized = true;
-                    }
+            // Release the chunk's records now that they've been consumed
+            std::vector<ObjChunk::Record>().swap(chunk.m_records);
+            std::vector<int32_t>().swap(chunk.m_faceIndices);
+        }
 
-                    int32_t index = m_positions.Append(pos);
-                    NV_ASSERT(index != -1);
-                    ++nextPosIndex;
-                    bHas4CompPos |= (compCount == 4);
-                    break;
-                }
-                case 'n':
+        delete[] counters;
+
+        return result;
+    }
+
+	void NvModelExtObj::TokenizeObjChunk(void* pChunk, uint32_t /*workerIndex*/)
+    {
+        ObjChunk& chunk = *(ObjChunk*)pChunk;
+
+        // Roughly one record per 32 bytes of text is typical of OBJ files
+        chunk.m_records.reserve((chunk.m_pEnd - chunk.m_pBegin) / 32);
+
+        const char* p = chunk.m_pBegin;
+        while (p < chunk.m_pEnd)
+        {
+            const char* pLineEnd = p;
+            while ((pLineEnd < chunk.m_pEnd) && !IsObjEOL(*pLineEnd))
+            {
+                ++pLineEnd;
+            }
+            const char* pNextLine = pLineEnd;
+            while ((pNextLine < chunk.m_pEnd) && IsObjEOL(*pNextLine))
+            {
+                ++pNextLine;
+            }
+
+            const char* pLine = p;
+            p = pNextLine;
+
+            while ((pLine < pLineEnd) && IsObjWhitespace(*pLine))
+            {
+                ++pLine;
+            }
+            if (pLine == pLineEnd)
+            {
+                // Blank line
+                continue;
+            }
+
+            // Only statements that begin with one of these can affect the model
+            // (see ParseObjStatement). Comments, groups, objects and any unsupported
+            // statements are ignored.
+            switch (pLine[0])
+            {
+            case 'v':
+            case 'f':
+            case 's':
+            case 'm':
+            case 'u':
+            case '"':
+            case '\'':
+                break;
+            default:
+                continue;
+            }
+
+            const char* pKeywordEnd = pLine;
+            while ((pKeywordEnd < pLineEnd) && !IsObjWhitespace(*pKeywordEnd))
+            {
+                ++pKeywordEnd;
+            }
+            size_t keywordLength = pKeywordEnd - pLine;
+
+            ObjChunk::Record record;
+            record.m_count = 0;
+            record.m_offset = 0;
+            record.m_format = 0;
+            if ((keywordLength == 1) && (pLine[0] == 'v'))
+            {
+                record.m_type = ObjChunk::Record_Position;
+                record.m_values[3] = 1.0f;  //default w coordinate
+                record.m_count = ParseObjFloats(pKeywordEnd, pLineEnd, record.m_values, 4);
+                if ((record.m_count < 3) || (record.m_count > 4))
                 {
-                    //normal, 3 components
-                    nv::vec3f norm;
-                    compCount = tok.getTokenFloatArray((float*)norm, 3);
-                    NV_ASSERT(compCount == 3);
-                    int32_t index = m_normals.Append(norm);
-                    NV_ASSERT(index != -1);
-                    ++nextNormalIndex;
-                    break;
+                    record.m_count = 0;
                 }
-                case 't':
+            }
+            else if ((keywordLength == 2) && (pLine[0] == 'v') && (pLine[1] == 'n'))
+            {
+                record.m_type = ObjChunk::Record_Normal;
+                record.m_count = ParseObjFloats(pKeywordEnd, pLineEnd, record.m_values, 3);
+                if (record.m_count != 3)
                 {
-                    //texcoord, 2 or 3 components
-                    nv::vec3f texCoord;
-                    texCoord.z = 0.0f;  //default r coordinate
-                    compCount = tok.getTokenFloatArray((float*)texCoord, 3);
-                    NV_ASSERT(compCount > 1 && compCount < 4);
-                    if (compCount == 3)
-                    {
-                        // Often, the file will contain 3 texture coordinates, but the third is all 0s
-                        // Attempt to detect this case and reduce our texture coordinate size of possible.
-                        if ((texCoord.z > -0.0001f) && (texCoord.z < 0.0001f))
-                        {
-                            compCount = 2;
-                        }
-                    }
-                    int32_t index = m_texCoords.Append(texCoord);
-                    NV_ASSERT(index != -1);
-                    ++nextTexCoordIndex;
-                    bHas3CompTex |= (compCount == 3);
-                    break;
+                    record.m_count = 0;
                 }
-                case 'p':
+            }
+            else if ((keywordLength == 2) && (pLine[0] == 'v') && (pLine[1] == 't'))
+            {
+                record.m_type = ObjChunk::Record_TexCoord;
+                record.m_values[2] = 0.0f;  //default r coordinate
+                record.m_count = ParseObjFloats(pKeywordEnd, pLineEnd, record.m_values, 3);
+                if ((record.m_count < 2) || (record.m_count > 3))
                 {
-                    // Parameter space vertices not supported...
-                    break;
+                    record.m_count = 0;
                 }
-                }
-                tok.consumeToEOL();
-                break;
             }
-            case 'f':
+            else if ((keywordLength == 1) && (pLine[0] == 'f'))
             {
-                //face
-                MeshFace face;
-                MeshVertex vert;
-
-                face.m_material = uint32_t(currentMaterial);
-                face.m_smoothingGroup = currentSmoothingGroup;
-                face.m_pSubMesh = currentSubMesh;
-
-                // determine the type, and read the initial vertex, all entries in a face must have the same format
-                // formats are:
-                // 1  #         : Position Only
-                // 2  #/#       : Position and TexCoord
-                // 3  #/#/#     : Position, TexCoord and Normal
-                // 4  #//#      : Position and Normal
+                // Faces are only handled here if every vertex is in one of the four
+                // well-formed layouts, and all vertices share the same one
+                record.m_type = ObjChunk::Record_Face;
+                record.m_offset = uint32_t(chunk.m_faceIndices.size());
                 OBJFaceFormat format = Face_Invalid;
-
-                // Some obj files have malformed face entries that contain a trailing delimiter when 
-                // defining Position and TexCoord vertices.  We'll check for this case so that we
-                // can consume the extra delimiter and try to recover
-                bool bTrailingDelimiter = false;
-
-                // Indices in OBJ files are 1-based and may be absolute or relative.
-                // To facilitate this, we'll read indices into a temporary value that 
-                // can be remapped before we store it into our actual data structures.
-                int32_t objIndex;
-                if (!tok.getTokenInt(objIndex))
+                const char* pVert = pKeywordEnd;
+                for (;;)
                 {
-                    NV_ASSERT(0);
-                    return false;
-                }
-
-                // Remap from the files 1-based, and possibly negative, value to a non-negative,
-                // 0-based index, then use that index to retrieve the correct index from the 
-                // compacting data store of positions.  We'll do this for all vertex components
-                // that we read in from the file.
-                vert.m_pos = m_positions.Remap(RemapObjIndex(objIndex, nextPosIndex));
-
-                if (tok.consumeOneDelim())
-                {
-                    if (tok.consumeOneDelim())
+                    while ((pVert < pLineEnd) && IsObjWhitespace(*pVert))
                     {
-                        // Two delimiters in a row means it has to be format #//#
-                        format = Face_PosNormal;
+                        ++pVert;
+                    }
+                    if (pVert == pLineEnd)
+                    {
+                        break;
+                    }
 
-                        // and we need to read in the normal
-                        if (!tok.getTokenInt(objIndex))
+                    // Split the vertex into its (up to three) slash separated fields
+                    const char* pFields[4] = { pVert, NULL, NULL, NULL };
+                    uint32_t fieldCount = 1;
+                    for (; (pVert < pLineEnd) && !IsObjWhitespace(*pVert); ++pVert)
+                    {
+                        if (*pVert == '/')
                         {
-                            NV_ASSERT(0);
-                            return false;
+                            if (fieldCount == 3)
+                            {
+                                fieldCount = 4;
+                                break;
+                            }
+                            pFields[fieldCount++] = pVert + 1;
                         }
-                        vert.m_normal = m_normals.Remap(RemapObjIndex(objIndex, nextNormalIndex));
                     }
-                    else
+                    const char* pFieldEnds[3] =
+                    {
+                        (fieldCount > 1) ? pFields[1] - 1 : pVert,
+                        (fieldCount > 2) ? pFields[2] - 1 : pVert,
+                        pVert
+                    };
+
+                    int32_t indices[3] = { 0, 0, 0 };
+                    OBJFaceFormat vertFormat = Face_Invalid;
+                    if (!ParseObjIndex(pFields[0], pFieldEnds[0], indices[0]))
+                    {
+                        vertFormat = Face_Invalid;
+                    }
+                    else if (fieldCount == 1)
+                    {
+                        vertFormat = Face_PosOnly;
+                    }
+                    else if (fieldCount == 2)
                     {
-                        // The next token is the texture coordinate
-                        if (!tok.getTokenInt(objIndex))
+                        if (ParseObjIndex(pFields[1], pFieldEnds[1], indices[1]))
                         {
-                            NV_ASSERT(0);
-                            return false;
+                            vertFormat = Face_PosTex;
                         }
-
-                        vert.m_texcoord = m_texCoords.Remap(RemapObjIndex(objIndex, nextTexCoordIndex));
-
-                        // If there's a delimiter following this, then there's also a normal
-                        if (tok.consumeOneDelim())
+                    }
+                    else if (fieldCount == 3)
+                    {
+                        if (pFields[1] == pFieldEnds[1])
                         {
-                            // Therefore, format #/#/# and we need to fetch the normal
-                            // Also, check for malformed face with a trailing delimiter by not consuming
-                            // whitespace when reading this token (some bad OBJ files have a #/#/ format
-                            // which is not standard).
-                            tok.setConsumeWS(false);
-                            if (tok.getTokenInt(objIndex))
-                            {
-                                vert.m_normal = m_normals.Remap(RemapObjIndex(objIndex, nextNormalIndex));
-                                format = Face_PosTexNormal;
-                            }
-                            else
+                            if (ParseObjIndex(pFields[2], pFieldEnds[2], indices[2]))
                             {
-                                // Set our format to correctly reflect the actual data in the face definition,
-                                // but also set our flag so we can consume that extra delimiter each time
-                                bTrailingDelimiter = true;
-                                format = Face_PosTex;
+                                vertFormat = Face_PosNormal;
                             }
-                            // Restoring our setting to consume whitespace
-                            tok.setConsumeWS(true);
                         }
-                        else
+                        else if (ParseObjIndex(pFields[1], pFieldEnds[1], indices[1]) &&
+                            ParseObjIndex(pFields[2], pFieldEnds[2], indices[2]))
                         {
-                            // otherwise it's format #/#, so no normal
-                            format = Face_PosTex;
+                            vertFormat = Face_PosTexNormal;
                         }
                     }
+
+                    if ((vertFormat == Face_Invalid) || ((format != Face_Invalid) && (vertFormat != format)))
+                    {
+                        format = Face_Invalid;
+                        break;
+                    }
+                    format = vertFormat;
+                    chunk.m_faceIndices.insert(chunk.m_faceIndices.end(), indices, indices + 3);
+                    ++record.m_count;
                 }
-                else
+
+                record.m_format = uint32_t(format);
+                if ((format == Face_Invalid) || (record.m_count < 3))
                 {
-                    // A single token and no delimiters means a position only format
-                    format = Face_PosOnly;
+                    chunk.m_faceIndices.resize(record.m_offset);
+                    record.m_count = 0;
                 }
+            }
 
-                // Add our new vertex to the submesh, checking to see if one
-                // just like it has already been added, using the original one
-                // instead if so.
-                face.m_verts[0] = currentSubMesh->FindOrAddVertex(vert);
-                switch (format)
-                {
-                case Face_PosOnly:
+            if (record.m_count == 0)
+            {
+                // Leave everything else, and anything the fast path couldn't
+                // handle, to be parsed by the tokenizer when the chunk is replayed
+                record.m_type = ObjChunk::Record_Statement;
+                record.m_offset = uint32_t(pLine - chunk.m_pBegin);
+                record.m_count = uint32_t(pLineEnd - pLine);
+            }
+            chunk.m_records.push_back(record);
+        }
+    }
+
+	bool NvModelExtObj::ReplayObjChunk(const ObjChunk& chunk, ObjParseState& state)
+    {
+        std::vector<ObjChunk::Record>::const_iterator it = chunk.m_records.begin();
+        std::vector<ObjChunk::Record>::const_iterator itEnd = chunk.m_records.end();
+        for (; it != itEnd; ++it)
+        {
+            const ObjChunk::Record& record = *it;
+            switch (record.m_type)
+            {
+            case ObjChunk::Record_Position:
+                AddObjPosition(nv::vec4f(record.m_values[0], record.m_values[1], record.m_values[2], record.m_values[3]), record.m_count, state);
+                break;
+            case ObjChunk::Record_Normal:
+                AddObjNormal(nv::vec3f(record.m_values[0], record.m_values[1], record.m_values[2]), state);
+                break;
+            case ObjChunk::Record_TexCoord:
+                AddObjTexCoord(nv::vec3f(record.m_values[0], record.m_values[1], record.m_values[2]), record.m_count, state);
+                break;
+            case ObjChunk::Record_Face:
+                AddObjFace(OBJFaceFormat(record.m_format), &chunk.m_faceIndices[record.m_offset], record.m_count, state);
+                break;
+            default:
+            {
+                // Tokenize a null-terminated copy of the line, as the chunk's text
+                // continues past the end of the statement
+                std::string statement(chunk.m_pBegin + record.m_offset, record.m_count);
+                if (!ParseObjSerial(statement.c_str(), state))
                 {
-                    // Get the second vertex
-                    if (!tok.getTokenInt(objIndex))
-                    {
-                        NV_ASSERT(0);
-                        return false;
-                    }
-                    vert.m_pos = m_positions.Remap(RemapObjIndex(objIndex, nextPosIndex));
-                    face.m_verts[1] = currentSubMesh->FindOrAddVertex(vert);
-
-                    // If there are more than three vertices in this face, then we need to create
-                    // a triangle fan.  If there are only three vertices, then it will be a fan of
-                    // one triangle.
-                    bool bGeneratedFaceNormal = false;
-                    while (tok.getTokenInt(objIndex))
-                    {
-                        vert.m_pos = m_positions.Remap(RemapObjIndex(objIndex, nextPosIndex));
-                        face.m_verts[2] = currentSubMesh->FindOrAddVertex(vert);
+                    return false;
+                }
+                break;
+            }
+            }
+        }
+        return true;
+    }
 
-                        // Generate our face normal.  We only need to do this once and reuse
-                        // it for all triangles in the face.
-                        if (!bGeneratedFaceNormal)
-                        {
-                            face.CalculateFaceNormal(m_positions.GetVectors());
-                            bGeneratedFaceNormal = true;
-                        }
+	bool NvModelExtObj::ParseObjStatement(NvTokenizer& tok, ObjParseState& state)
+    {
+        if (!tok.readToken())
+        {
+            tok.consumeToEOL();
+            return true; // likely EOL we didn't explicitly handle?
+        }
 
-                        currentSubMesh->m_rawFaces.push_back(face);
+        int32_t& currentMaterial = state.m_currentMaterial;
+        int32_t& currentSmoothingGroup = state.m_currentSmoothingGroup;
+        SubMeshObj*& currentSubMesh = state.m_currentSubMesh;
 
-                        // Move this vertex into the second position so that the next vertex,
-                        // if there is one, will create a triangle with the first vertex, this 
-                        // vertex and the next one.
-                        face.m_verts[1] = face.m_verts[2];
-                    }
-                    break;
-                }
-                case Face_PosTex:
+        const char* tmp = tok.getLastTokenPtr();
+        uint32_t compCount = 0;
+
+        switch (tmp[0])
+        {
+        case '#':
+        {
+            //comment line, eat the remainder
+            tok.consumeToEOL();
+            break;
+        }
+        case 'v':
+        {
+            // Some kind of vertex component
+            switch (tmp[1])
+            {
+            case '\0':
+            {
+                nv::vec4f pos;
+                //vertex position, 3 or 4 components
+                pos.w = 1.0f;  //default w coordinate
+
+                compCount = tok.getTokenFloatArray((float*)pos, 4);
+                NV_ASSERT(compCount > 2 && compCount < 5);
+                AddObjPosition(pos, compCount, state);
+                break;
+            }
+            case 'n':
+            {
+                //normal, 3 components
+                nv::vec3f norm;
+                compCount = tok.getTokenFloatArray((float*)norm, 3);
+                NV_ASSERT(compCount == 3);
+                AddObjNormal(norm, state);
+                break;
+            }
+            case 't':
+            {
+                //texcoord, 2 or 3 components
+                nv::vec3f texCoord;
+                texCoord.z = 0.0f;  //default r coordinate
+                compCount = tok.getTokenFloatArray((float*)texCoord, 3);
+                NV_ASSERT(compCount > 1 && compCount < 4);
+                AddObjTexCoord(texCoord, compCount, state);
+                break;
+            }
+            case 'p':
+            {
+                // Parameter space vertices not supported...
+                break;
+            }
+            }
+            tok.consumeToEOL();
+            break;
+        }
+        case 'f':
+        {
+            //face
+
+            // determine the type, and read the initial vertex, all entries in a face must have the same format
+            // formats are:
+            // 1  #         : Position Only
+            // 2  #/#       : Position and TexCoord
+            // 3  #/#/#     : Position, TexCoord and Normal
+            // 4  #//#      : Position and Normal
+            OBJFaceFormat format = Face_Invalid;
+
+            // Some obj files have malformed face entries that contain a trailing delimiter when 
+            // defining Position and TexCoord vertices.  We'll check for this case so that we
+            // can consume the extra delimiter and try to recover
+            bool bTrailingDelimiter = false;
+
+            // Indices in OBJ files are 1-based and may be absolute or relative.
+            // They're collected as they appear in the file, three per vertex (position,
+            // texture coordinate and normal), and remapped by AddObjFace once the whole
+            // face has been read.
+            int32_t objIndices[3] = { 0, 0, 0 };
+            if (!tok.getTokenInt(objIndices[0]))
+            {
+                NV_ASSERT(0);
+                return false;
+            }
+
+            if (tok.consumeOneDelim())
+            {
+                if (tok.consumeOneDelim())
                 {
-                    // Get the second vertex
-                    if (!tok.getTokenInt(objIndex))
-                    {
-                        NV_ASSERT(0);
-                        return false;
-                    }
-                    vert.m_pos = m_positions.Remap(RemapObjIndex(objIndex, nextPosIndex));
+                    // Two delimiters in a row means it has to be format #//#
+                    format = Face_PosNormal;
 
-                    // Consume the '/' between the position and texture
-                    if (!tok.consumeOneDelim())
+                    // and we need to read in the normal
+                    if (!tok.getTokenInt(objIndices[2]))
                     {
                         NV_ASSERT(0);
                         return false;
                     }
-
-                    if (!tok.getTokenInt(objIndex))
+                }
+                else
+                {
+                    // The next token is the texture coordinate
+                    if (!tok.getTokenInt(objIndices[1]))
                     {
                         NV_ASSERT(0);
                         return false;
                     }
-                    vert.m_texcoord = m_texCoords.Remap(RemapObjIndex(objIndex, nextTexCoordIndex));
 
-                    if (bTrailingDelimiter)
-                    {
-                        if (!tok.consumeOneDelim())
-                        {
-                            NV_ASSERT(0);
-                            return false;
-                        }
-                    }
-                    face.m_verts[1] = currentSubMesh->FindOrAddVertex(vert);
-
-                    // If there are more than three vertices in this face, then we need to create
-                    // a triangle fan.  If there are only three vertices, then it will be a fan of
-                    // one triangle.
-                    bool bGeneratedFaceNormal = false;
-                    while (tok.getTokenInt(objIndex))
+                    // If there's a delimiter following this, then there's also a normal
+                    if (tok.consumeOneDelim())
                     {
-                        vert.m_pos = m_positions.Remap(RemapObjIndex(objIndex, nextPosIndex));
-
-                        // Consume the '/' between the position and texture
-                        if (!tok.consumeOneDelim())
+                        // Therefore, format #/#/# and we need to fetch the normal
+                        // Also, check for malformed face with a trailing delimiter by not consuming
+                        // whitespace when reading this token (some bad OBJ files have a #/#/ format
+                        // which is not standard).
+                        tok.setConsumeWS(false);
+                        if (tok.getTokenInt(objIndices[2]))
                         {
-                            NV_ASSERT(0);
-                            return false;
+                            format = Face_PosTexNormal;
                         }
-
-                        if (!tok.getTokenInt(objIndex))
-                        {
-                            NV_ASSERT(0);
-                            return false;
-                        }
-                        vert.m_texcoord = m_texCoords.Remap(RemapObjIndex(objIndex, nextTexCoordIndex));
-                        face.m_verts[2] = currentSubMesh->FindOrAddVertex(vert);
-
-                        // Generate our face normal.  We only need to do this once and reuse
-                        // it for all triangles in the face.
-                        if (!bGeneratedFaceNormal)
+                        else
                         {
-                            face.CalculateFaceNormal(m_positions.GetVectors());
-                            bGeneratedFaceNormal = true;
+                            // Set our format to correctly reflect the actual data in the face definition,
+                            // but also set our flag so we can consume that extra delimiter each time
+                            bTrailingDelimiter = true;
+                            format = Face_PosTex;
                         }
-
-                        currentSubMesh->m_rawFaces.push_back(face);
-
-                        // Move this vertex into the second position so that the next vertex,
-                        // if there is one, will create a triangle with the first vertex, this 
-                        // vertex and the next one.
-                        face.m_verts[1] = face.m_verts[2];
+                        // Restoring our setting to consume whitespace
+                        tok.setConsumeWS(true);
                     }
-                    break;
-                }
-                case Face_PosTexNormal:
-                {
-                    // Get the second vertex
-                    if (!tok.getTokenInt(objIndex))
+                    else
                     {
-                        NV_ASSERT(0);
-                        return false;
+                        // otherwise it's format #/#, so no normal
+                        format = Face_PosTex;
                     }
-                    vert.m_pos = m_positions.Remap(RemapObjIndex(objIndex, nextPosIndex));
+                }
+            }
+            else
+            {
+                // A single token and no delimiters means a position only format
+                format = Face_PosOnly;
+            }
 
-                    // Consume the '/' between the position and texture
-                    if (!tok.consumeOneDelim())
-                    {
-                        NV_ASSERT(0);
-                        return false;
-                    }
+            std::vector<int32_t>& faceIndices = state.m_faceIndices;
+            faceIndices.clear();
+            faceIndices.insert(faceIndices.end(), objIndices, objIndices + 3);
 
-                    if (!tok.getTokenInt(objIndex))
+            // Read the remaining vertices, each of which must have the same format as the first
+            while (tok.getTokenInt(objIndices[0]))
+            {
+                switch (format)
+                {
+                case Face_PosOnly:
+                    break;
+                case Face_PosTex:
+                {
+                    // Consume the '/' between the position and texture
+                    if (!tok.consumeOneDelim() || !tok.getTokenInt(objIndices[1]))
                     {
                         NV_ASSERT(0);
                         return false;
                     }
-                    vert.m_texcoord = m_texCoords.Remap(RemapObjIndex(objIndex, nextTexCoordIndex));
 
-                    // Consume the '/' between the texture and the normal
-                    if (!tok.consumeOneDelim())
+                    if (bTrailingDelimiter && !tok.consumeOneDelim())
                     {
                         NV_ASSERT(0);
                         return false;
                     }
-
-                    if (!tok.getTokenInt(objIndex))
+                    break;
+                }
+                case Face_PosTexNormal:
+                {
+                    // Consume the '/' between the position and texture, and the 
+                    // one between the texture and the normal
+                    if (!tok.consumeOneDelim() || !tok.getTokenInt(objIndices[1]) ||
+                        !tok.consumeOneDelim() || !tok.getTokenInt(objIndices[2]))
                     {
                         NV_ASSERT(0);
                         return false;
                     }
-                    vert.m_normal = m_normals.Remap(RemapObjIndex(objIndex, nextNormalIndex));
-                    face.m_verts[1] = currentSubMesh->FindOrAddVertex(vert);
-
-                    // If there are more than three vertices in this face, then we need to create
-                    // a triangle fan.  If there are only three vertices, then it will be a fan of
-                    // one triangle.
-                    while (tok.getTokenInt(objIndex))
-                    {
-                        vert.m_pos = m_positions.Remap(RemapObjIndex(objIndex, nextPosIndex));
-
-                        // Consume the '/' between the position and texture
-                        if (!tok.consumeOneDelim())
-                        {
-                            NV_ASSERT(0);
-                            return false;
-                        }
-
-                        if (!tok.getTokenInt(objIndex))
-                        {
-                            NV_ASSERT(0);
-                            return false;
-                        }
-                        vert.m_texcoord = m_texCoords.Remap(RemapObjIndex(objIndex, nextTexCoordIndex));
-
-                        // Consume the '/' between the texture and the normal
-                        if (!tok.consumeOneDelim())
-                        {
-                            NV_ASSERT(0);
-                            return false;
-                        }
-
-                        if (!tok.getTokenInt(objIndex))
-                        {
-                            NV_ASSERT(0);
-                            return false;
-                        }
-                        vert.m_normal = m_normals.Remap(RemapObjIndex(objIndex, nextNormalIndex));
-                        face.m_verts[2] = currentSubMesh->FindOrAddVertex(vert);
-
-                        currentSubMesh->m_rawFaces.push_back(face);
-
-                        // Move this vertex into the second position so that the next vertex,
-                        // if there is one, will create a triangle with the first vertex, this 
-                        // vertex and the next one.
-                        face.m_verts[1] = face.m_verts[2];
-                    }
                     break;
                 }
                 case Face_PosNormal:
                 {
-                    // Get the second vertex
-                    if (!tok.getTokenInt(objIndex))
-                    {
-                        NV_ASSERT(0);
-                        return false;
-                    }
-                    vert.m_pos = m_positions.Remap(RemapObjIndex(objIndex, nextPosIndex));
-
                     // Consume the '//' between the position and normal indices
-                    if (!tok.consumeOneDelim() || !tok.consumeOneDelim())
-                    {
-                        NV_ASSERT(0);
-                        return false;
-                    }
-
-                    if (!tok.getTokenInt(objIndex))
+                    if (!tok.consumeOneDelim() || !tok.consumeOneDelim() || !tok.getTokenInt(objIndices[2]))
                     {
                         NV_ASSERT(0);
                         return false;
                     }
-                    vert.m_normal = m_normals.Remap(RemapObjIndex(objIndex, nextNormalIndex));
-                    face.m_verts[1] = currentSubMesh->FindOrAddVertex(vert);
-
-                    // If there are more than three vertices in this face, then we need to create
-                    // a triangle fan.  If there are only three vertices, then it will be a fan with
-                    // one triangle.
-                    while (tok.getTokenInt(objIndex))
-                    {
-                        vert.m_pos = m_positions.Remap(RemapObjIndex(objIndex, nextPosIndex));
-                        NV_ASSERT(RemapObjIndex(objIndex, nextPosIndex) == (objIndex - 1));
-
-                        // Consume the '//' between the position and normal indices
-                        if (!tok.consumeOneDelim() || !tok.consumeOneDelim())
-                        {
-                            NV_ASSERT(0);
-                            return false;
-                        }
-
-                        if (!tok.getTokenInt(objIndex))
-                        {
-                            NV_ASSERT(0);
-                            return false;
-                        }
-                        vert.m_normal = m_normals.Remap(RemapObjIndex(objIndex, nextNormalIndex));
-                        face.m_verts[2] = currentSubMesh->FindOrAddVertex(vert);
-
-                        currentSubMesh->m_rawFaces.push_back(face);
-
-                        // Move this vertex into the second position so that the next vertex,
-                        // if there is one, will create a triangle with the first vertex, this 
-                        // vertex and the next one.
-                        face.m_verts[1] = face.m_verts[2];
-                    }
                     break;
                 }
                 default:
@@ -685,117 +1081,237 @@ namespace Nv
                     return false;
                 }
                 }
-                tok.consumeToEOL();
-                break;
+                faceIndices.insert(faceIndices.end(), objIndices, objIndices + 3);
             }
-            case 's':
-                if (!tok.getTokenInt(currentSmoothingGroup)) // should return 0 if no conversion possible, as in the case of the 'off' setting
-                {
-                    NV_ASSERT(0);
-                    return false;
-                }
-                tok.consumeToEOL();
-
-#if DEBUG_SMOOTHING_AS_MATS
-                {
-                    // See if the material already exists
-                    char tmp[16];
-                    sprintf_s(tmp, 16, "%d", currentSmoothingGroup);
-                    std::string materialName = tmp;
 
-                    MaterialMap::iterator fIt = m_materialMap.find(materialName);
-                    if (fIt == m_materialMap.end())
-                    {
-                        // We need to add the material
-                        currentMaterial = m_rawMaterials.size();
-                        m_materialMap[materialName] = currentMaterial;
-
-                        Material newMaterial;
-                        newMaterial.m_name = materialName;
-                        newMaterial.m_diffuse = sColors[currentMaterial % sColorCount];
-                        m_rawMaterials.push_back(newMaterial);
-                    }
-                    else
-                    {
-                        currentMaterial = fIt->second;
-                    }
-                    currentSubMesh = GetSubMeshForMaterial(currentMaterial);
-                }
-#endif
-                break;
-            case 'm':
+            // A face needs at least two vertices before it can start a fan
+            if (faceIndices.size() < 6)
             {
-#if DEBUG_SMOOTHING_AS_MATS
-                // Using artificially constructed materials, defined by smoothing groups, so 
-                // ignore all real materials
-                tok.consumeToEOL();
-                break; 
-#endif
-                // mtllib
-                std::string materialLibName;
-                if (!tok.getTokenString(materialLibName))
-                {
-                    NV_ASSERT(0);
-                    return false;
-                }
-
-                // Load the material library so that subsequent faces can use the materials it defines
-                LoadMaterialLibraryFromFile(materialLibName);
-
-                tok.consumeToEOL();
-                break;
+                NV_ASSERT(0);
+                return false;
             }
-            case 'u':
+
+            AddObjFace(format, &faceIndices[0], uint32_t(faceIndices.size() / 3), state);
+            tok.consumeToEOL();
+            break;
+        }
+        case 's':
+            if (!tok.getTokenInt(currentSmoothingGroup)) // should return 0 if no conversion possible, as in the case of the 'off' setting
             {
-#if DEBUG_SMOOTHING_AS_MATS
-                tok.consumeToEOL();
-                break;
-#endif
-                // usemtl
-                std::string materialName;
-                if (!tok.getTokenString(materialName))
-                {
-                    NV_ASSERT(0);
-                    return false;
-                }
+                NV_ASSERT(0);
+                return false;
+            }
+            tok.consumeToEOL();
 
+#if DEBUG_SMOOTHING_AS_MATS
+            {
                 // See if the material already exists
+                char tmp[16];
+                sprintf_s(tmp, 16, "%d", currentSmoothingGroup);
+                std::string materialName = tmp;
+
                 MaterialMap::iterator fIt = m_materialMap.find(materialName);
                 if (fIt == m_materialMap.end())
                 {
                     // We need to add the material
-                    currentMaterial = int32_t(m_rawMaterials.size());
+                    currentMaterial = m_rawMaterials.size();
                     m_materialMap[materialName] = currentMaterial;
 
                     Material newMaterial;
+                    newMaterial.m_name = materialName;
+                    newMaterial.m_diffuse = sColors[currentMaterial % sColorCount];
                     m_rawMaterials.push_back(newMaterial);
                 }
                 else
                 {
                     currentMaterial = fIt->second;
                 }
-
-                // Switch to the submesh that uses the active material
                 currentSubMesh = GetSubMeshForMaterial(currentMaterial);
-                tok.consumeToEOL();
-                break;
             }
-            case 'g':
-            case 'o':
-                //all presently ignored
-            default:
-                tok.consumeToEOL();
+#endif
+            break;
+        case 'm':
+        {
+#if DEBUG_SMOOTHING_AS_MATS
+            // Using artificially constructed materials, defined by smoothing groups, so 
+            // ignore all real materials
+            tok.consumeToEOL();
+            break; 
+#endif
+            // mtllib
+            std::string materialLibName;
+            if (!tok.getTokenString(materialLibName))
+            {
+                NV_ASSERT(0);
+                return false;
             }
+
+            // Load the material library so that subsequent faces can use the materials it defines
+            LoadMaterialLibraryFromFile(materialLibName);
+
+            tok.consumeToEOL();
+            break;
         }
+        case 'u':
+        {
+#if DEBUG_SMOOTHING_AS_MATS
+            tok.consumeToEOL();
+            break;
+#endif
+            // usemtl
+            std::string materialName;
+            if (!tok.getTokenString(materialName))
+            {
+                NV_ASSERT(0);
+                return false;
+            }
 
-        m_numPositionComponents = bHas4CompPos ? 4 : 3;
-        m_numTexCoordComponents = bHas3CompTex ? 3 : 2;
+            // See if the material already exists
+            MaterialMap::iterator fIt = m_materialMap.find(materialName);
+            if (fIt == m_materialMap.end())
+            {
+                // We need to add the material
+                currentMaterial = int32_t(m_rawMaterials.size());
+                m_materialMap[materialName] = currentMaterial;
 
-        OptimizeModel();
+                Material newMaterial;
+                m_rawMaterials.push_back(newMaterial);
+            }
+            else
+            {
+                currentMaterial = fIt->second;
+            }
+
+            // Switch to the submesh that uses the active material
+            currentSubMesh = GetSubMeshForMaterial(currentMaterial);
+            tok.consumeToEOL();
+            break;
+        }
+        case 'g':
+        case 'o':
+            //all presently ignored
+        default:
+            tok.consumeToEOL();
+        }
 
         return true;
     }
 
+	void NvModelExtObj::AddObjPosition(const nv::vec4f& pos, uint32_t compCount, ObjParseState& state)
+    {
+        if (state.m_bBoundingBoxInitialized)
+        {
+            // Grow our bounding box, if necessary
+            m_boundingBoxMin = nv::min(m_boundingBoxMin, (nv::vec3f)pos);
+            m_boundingBoxMax = nv::max(m_boundingBoxMax, (nv::vec3f)pos);
+        }
+        else
+        {
+            // Make sure that our bounding box starts out with a valid, contained point
+            m_boundingBoxMin = (nv::vec3f)pos;
+            m_boundingBoxMax = (nv::vec3f)pos;
+            state.m_bBoundingBoxInitialized = true;
+        }
+
+        int32_t index = m_positions.Append(pos);
+        NV_ASSERT(index != -1);
+        ++state.m_nextPosIndex;
+        state.m_bHas4CompPos |= (compCount == 4);
+    }
+
+	void NvModelExtObj::AddObjNormal(const nv::vec3f& norm, ObjParseState& state)
+    {
+        // The normal compactor's merge test and search radius assume unit
+        // vectors, and OBJ files don't guarantee them
+        nv::vec3f unitNorm = norm;
+        float normLen = length(norm);
+        if (normLen > 0.0000001f)
+        {
+            unitNorm *= 1.0f / normLen;
+        }
+        int32_t index = m_normals.Append(unitNorm);
+        NV_ASSERT(index != -1);
+        ++state.m_nextNormalIndex;
+    }
+
+	void NvModelExtObj::AddObjTexCoord(const nv::vec3f& texCoord, uint32_t compCount, ObjParseState& state)
+    {
+        if (compCount == 3)
+        {
+            // Often, the file will contain 3 texture coordinates, but the third is all 0s
+            // Attempt to detect this case and reduce our texture coordinate size of possible.
+            if ((texCoord.z > -0.0001f) && (texCoord.z < 0.0001f))
+            {
+                compCount = 2;
+            }
+        }
+        int32_t index = m_texCoords.Append(texCoord);
+        NV_ASSERT(index != -1);
+        ++state.m_nextTexCoordIndex;
+        state.m_bHas3CompTex |= (compCount == 3);
+    }
+
+	void NvModelExtObj::AddObjFace(OBJFaceFormat format, const int32_t* pObjIndices, uint32_t vertCount, ObjParseState& state)
+    {
+        MeshFace face;
+        MeshVertex vert;
+
+        face.m_material = uint32_t(state.m_currentMaterial);
+        face.m_smoothingGroup = state.m_currentSmoothingGroup;
+        face.m_pSubMesh = state.m_currentSubMesh;
+
+        bool bHasTexCoord = (format == Face_PosTex) || (format == Face_PosTexNormal);
+        bool bHasNormal = (format == Face_PosNormal) || (format == Face_PosTexNormal);
+
+        // Faces without vertex normals get a face normal, which we only need to
+        // generate once and reuse for all triangles in the face.
+        bool bGenerateFaceNormal = !bHasNormal;
+
+        for (uint32_t vertIndex = 0; vertIndex < vertCount; ++vertIndex, pObjIndices += 3)
+        {
+            // Remap from the files 1-based, and possibly negative, value to a non-negative,
+            // 0-based index, then use that index to retrieve the correct index from the 
+            // compacting data store of positions.  We'll do this for all vertex components
+            // that we read in from the file.
+            vert.m_pos = m_positions.Remap(RemapObjIndex(pObjIndices[0], state.m_nextPosIndex));
+            if (bHasTexCoord)
+            {
+                vert.m_texcoord = m_texCoords.Remap(RemapObjIndex(pObjIndices[1], state.m_nextTexCoordIndex));
+            }
+            if (bHasNormal)
+            {
+                vert.m_normal = m_normals.Remap(RemapObjIndex(pObjIndices[2], state.m_nextNormalIndex));
+            }
+
+            // Add our new vertex to the submesh, checking to see if one
+            // just like it has already been added, using the original one
+            // instead if so.
+            int32_t meshVertIndex = state.m_currentSubMesh->FindOrAddVertex(vert);
+            if (vertIndex < 2)
+            {
+                face.m_verts[vertIndex] = meshVertIndex;
+                continue;
+            }
+
+            // If there are more than three vertices in this face, then we need to create
+            // a triangle fan.  If there are only three vertices, then it will be a fan of
+            // one triangle.
+            face.m_verts[2] = meshVertIndex;
+
+            if (bGenerateFaceNormal)
+            {
+                face.CalculateFaceNormal(m_positions.GetVectors());
+                bGenerateFaceNormal = false;
+            }
+
+            state.m_currentSubMesh->m_rawFaces.push_back(face);
+
+            // Move this vertex into the second position so that the next vertex,
+            // if there is one, will create a triangle with the first vertex, this 
+            // vertex and the next one.
+            face.m_verts[1] = face.m_verts[2];
+        }
+    }
 	void NvModelExtObj::OptimizeModel()
     {
         RemoveEmptySubmeshes();
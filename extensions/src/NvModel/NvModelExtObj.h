@@ -63,6 +63,19 @@ namespace Nv
 		static NvModelExtObj* Create(const char* filename, float scale, 
 			bool generateNormals, bool generateTangents,
 			float vertMergeThreshold = 0.01f, float normMergeThreshold = 0.001f, uint32_t initialVertCount = 3000);
+
+        /// Factory method to create a model from OBJ data that has already been loaded into memory
+        /// \param[in] pFileData Pointer to the null-terminated OBJ file data
+        /// \param[in] scale The target radius to which we want the model scaled, or <0 if no scaling should be done
+        /// \param[in] generateNormals Indicate whether per-vertex normals should be estimated and added
+        /// \param[in] generateTangents Indicate whether per-vertex tangent vectors should be estimated and added
+        /// \param[in] vertMergeThreshold Vertices within this distance of each other will be merged together
+        /// \param[in] normMergeThreshold Normals whose dot product is within this value of 1.0 will be merged together
+        /// \param[in] initialVertCount Initial size of all containers to minimize re-allocations while loading the mesh
+        /// \return A pointer to the new model, or NULL if the OBJ data could not be parsed
+		static NvModelExtObj* CreateFromMemory(const char* pFileData, float scale,
+			bool generateNormals, bool generateTangents,
+			float vertMergeThreshold = 0.01f, float normMergeThreshold = 0.001f, uint32_t initialVertCount = 3000);
 		virtual ~NvModelExtObj();
 
         /// Loads the model data from the OBJ file with the given file name
@@ -155,9 +168,71 @@ namespace Nv
             Face_PosNormal = 4
         };
 
+        // Parser state carried from one OBJ statement to the next
+        struct ObjParseState;
+
+        // A line-aligned section of an OBJ file and the records tokenized from it
+        struct ObjChunk;
+
+        // Applies the post-load processing requested of the factory methods and
+        // builds the final vertex and index arrays of each submesh
+        void ProcessLoadedModel(float scale, bool generateNormals, bool generateTangents);
+
+        // Reorders the triangles and vertices of each submesh for better reuse
+        // of the post-transform vertex cache
+        void OptimizeVertexCache();
+
         // Creates a default material to be used by any mesh that doesn't specify one
         void InitializeDefaultMaterial();
 
+        /// Parses an OBJ file on the calling thread
+        /// \param[in] pLoadData Pointer to the null-terminated OBJ file data
+        /// \param[in,out] state Parser state to start from and update
+        /// \return True if the file was parsed successfully, false on a malformed statement
+        bool ParseObjSerial(const char* pLoadData, ObjParseState& state);
+
+        /// Parses an OBJ file by tokenizing line-aligned chunks of it as jobs on
+        /// the job system, then adding their contents to the model in file order
+        /// \param[in] pLoadData Pointer to the OBJ file data
+        /// \param[in] length Length of the OBJ file data in bytes
+        /// \param[in] threadCount Number of chunks to tokenize at once
+        /// \param[in,out] state Parser state to start from and update
+        /// \return True if the file was parsed successfully, false on a malformed statement
+        bool ParseObjParallel(const char* pLoadData, size_t length, uint32_t threadCount, ObjParseState& state);
+
+        /// Parses the statement at the tokenizer's current position, up to and
+        /// including the end of its line
+        /// \param[in] tok Tokenizer positioned at the start of a line
+        /// \param[in,out] state Parser state to update
+        /// \return True if the statement was valid, false if it was malformed
+        bool ParseObjStatement(NvTokenizer& tok, ObjParseState& state);
+
+        /// Adds the records tokenized from a chunk to the model
+        /// \param[in] chunk Chunk whose records are to be added
+        /// \param[in,out] state Parser state to update
+        /// \return True if all records were valid, false if one was malformed
+        bool ReplayObjChunk(const ObjChunk& chunk, ObjParseState& state);
+
+        /// Job that converts the lines of a chunk into records
+        /// \param[in,out] pChunk Pointer to the ObjChunk to tokenize
+        /// \param[in] workerIndex Index of the job system thread running the job
+        static void TokenizeObjChunk(void* pChunk, uint32_t workerIndex);
+
+        ///@{
+        /// Adds a vertex component read from a "v", "vn" or "vt" statement
+        void AddObjPosition(const nv::vec4f& pos, uint32_t compCount, ObjParseState& state);
+        void AddObjNormal(const nv::vec3f& norm, ObjParseState& state);
+        void AddObjTexCoord(const nv::vec3f& texCoord, uint32_t compCount, ObjParseState& state);
+        ///@}
+
+        /// Adds a face read from an "f" statement, triangulated as a fan
+        /// \param[in] format Format shared by all of the face's vertices
+        /// \param[in] pObjIndices Position, texture coordinate and normal OBJ indices
+        ///            of each vertex, in that order.  Indices unused by the format are ignored.
+        /// \param[in] vertCount Number of vertices in the face
+        /// \param[in,out] state Parser state to update
+        void AddObjFace(OBJFaceFormat format, const int32_t* pObjIndices, uint32_t vertCount, ObjParseState& state);
+
         // Clears out all data to prepare for loading a new model
         void ResetModel();
 
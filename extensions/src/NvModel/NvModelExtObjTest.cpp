@@ -0,0 +1,359 @@
+//----------------------------------------------------------------------------------
+// File:        NvModel/NvModelExtObjTest.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+// Test and benchmark of the OBJ parser on an OBJ file.
+//
+// The file is loaded once without a job system, which parses it serially,
+// and then with job systems of 2 to 8 threads, which tokenize it in chunks
+// with ParseObjParallel.  Every load must produce the same submeshes,
+// vertices, indices, materials and bounding box, bit for bit.
+//
+// With "bench" as the first argument it instead times the loads, with normal
+// and tangent generation off so that parsing dominates, and reports MB of OBJ
+// text per second for the serial parser and for 2 threads up to the given
+// count, by default the number of hardware threads.  Files under 1MB are
+// always parsed serially.
+//
+// Usage: NvModelExtObjTest <file.obj>
+//        NvModelExtObjTest bench <file.obj> [threads] [loads]
+// Returns 0 if all checks pass.  It builds with, from the extensions directory:
+//   g++ -O2 -std=c++11 -pthread -DLINUX -DNDEBUG -Iinclude -Iinclude/NsFoundation
+//       -Iinclude/NvFoundation src/NvModel/NvModelExtObjTest.cpp src/NvModel/NvModelExt.cpp
+//       src/NvModel/NvModelExtBin.cpp src/NvModel/NvModelExtObj.cpp src/NvModel/NvModelMeshFace.cpp
+//       src/NvModel/NvModelSubMeshObj.cpp src/NvModel/NvModelVertexCacheOptimizer.cpp
+//       src/NvModel/NvModelVertexPacker.cpp src/NvModel/NvSkeleton.cpp
+//       src/NvModel/NvModelExtBuilder.cpp
+// and the NsFoundation sources listed in NsConcurrentPoolTest.cpp.  NVPlatformLog
+// is defined here, since NvAppBase is not linked.
+
+#include "NvModelExtObj.h"
+#include <NvModel/NvModelSubMesh.h>
+#include <NsAllocator.h>
+#include <NsGlobals.h>
+#include <NsJobSystem.h>
+#include <NsThread.h>
+#include <NsVersionNumber.h>
+#include <NvAllocatorCallback.h>
+#include <NvErrorCallback.h>
+#include <algorithm>
+#include <chrono>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+using namespace Nv;
+
+void NVPlatformLog(const char* fmt, ...)
+{
+    (void)fmt;
+}
+
+namespace
+{
+    class TestAllocator : public nvidia::NvAllocatorCallback
+    {
+    public:
+        virtual void* allocate(size_t size, const char*, const char*, int)
+        {
+            // the foundation expects 16 byte aligned allocations
+#if defined(_WIN32)
+            return _aligned_malloc(size, 16);
+#else
+            void* ptr = NULL;
+            return posix_memalign(&ptr, 16, size) == 0 ? ptr : NULL;
+#endif
+        }
+
+        virtual void deallocate(void* ptr)
+        {
+#if defined(_WIN32)
+            _aligned_free(ptr);
+#else
+            free(ptr);
+#endif
+        }
+    };
+
+    class TestErrorCallback : public nvidia::NvErrorCallback
+    {
+    public:
+        virtual void reportError(nvidia::NvErrorCode::Enum, const char* message, const char* file, int line)
+        {
+            fprintf(stderr, "%s(%d): %s\n", file, line, message);
+        }
+    };
+
+    /// Reads a whole file into a null-terminated buffer.
+    char* ReadFile(const char* fileName, size_t& length)
+    {
+        FILE* fp = fopen(fileName, "rb");
+        if (NULL == fp)
+        {
+            return NULL;
+        }
+        fseek(fp, 0, SEEK_END);
+        length = size_t(ftell(fp));
+        fseek(fp, 0, SEEK_SET);
+        char* pData = new char[length + 1];
+        if (fread(pData, 1, length, fp) != length)
+        {
+            delete[] pData;
+            pData = NULL;
+        }
+        else
+        {
+            pData[length] = '\0';
+        }
+        fclose(fp);
+        return pData;
+    }
+
+    /// Loads material libraries from the directory of the OBJ file.
+    class DirectoryLoader : public NvModelFileLoader
+    {
+    public:
+        DirectoryLoader(const std::string& directory) : m_directory(directory) {}
+
+        virtual char* LoadDataFromFile(const char* fileName)
+        {
+            size_t length;
+            return ReadFile((m_directory + fileName).c_str(), length);
+        }
+
+        virtual void ReleaseData(char* pData)
+        {
+            delete[] pData;
+        }
+
+    private:
+        std::string m_directory;
+    };
+
+    /// FNV-1a hash of everything a load produces.
+    class ModelHash
+    {
+    public:
+        ModelHash() : m_hash(14695981039346656037ULL) {}
+
+        void Add(const void* pData, size_t size)
+        {
+            const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+            for (size_t i = 0; i < size; ++i)
+            {
+                m_hash = (m_hash ^ pBytes[i]) * 1099511628211ULL;
+            }
+        }
+
+        template <typename T> void Add(const T& value)
+        {
+            Add(&value, sizeof(value));
+        }
+
+        uint64_t Get() const { return m_hash; }
+
+    private:
+        uint64_t m_hash;
+    };
+
+    uint64_t HashModel(NvModelExtObj* pModel)
+    {
+        ModelHash hash;
+        hash.Add(pModel->GetMinExt());
+        hash.Add(pModel->GetMaxExt());
+        hash.Add(pModel->GetMaterialCount());
+        hash.Add(pModel->GetTextureCount());
+        for (uint32_t textureIndex = 0; textureIndex < pModel->GetTextureCount(); ++textureIndex)
+        {
+            std::string name = pModel->GetTextureName(textureIndex);
+            hash.Add(name.c_str(), name.size());
+        }
+
+        hash.Add(pModel->GetMeshCount());
+        for (uint32_t meshIndex = 0; meshIndex < pModel->GetMeshCount(); ++meshIndex)
+        {
+            SubMesh* pMesh = pModel->GetSubMesh(meshIndex);
+            hash.Add(pMesh->m_materialId);
+            hash.Add(pMesh->getVertexSize());
+            hash.Add(pMesh->getVertexCount());
+            hash.Add(pMesh->getIndexCount());
+            hash.Add(pMesh->getNormalOffset());
+            hash.Add(pMesh->getTexCoordOffset());
+            hash.Add(pMesh->getTangentOffset());
+            hash.Add(pMesh->getVertices(), sizeof(float) * pMesh->getVertexSize() * pMesh->getVertexCount());
+            hash.Add(pMesh->getIndices(), sizeof(uint32_t) * pMesh->getIndexCount());
+        }
+        return hash.Get();
+    }
+
+    /// Loads the file on a job system of the given number of threads, or
+    /// serially if 1, and returns the hash of the model, or 0 if it failed.
+    uint64_t LoadAndHash(const char* pData, uint32_t threadCount, bool generateNormals)
+    {
+        nvidia::shdfnd::JobSystem* pJobSystem = NULL;
+        if (threadCount > 1)
+        {
+            pJobSystem = NV_NEW(nvidia::shdfnd::JobSystem)(threadCount - 1);
+        }
+        NvModelExt::SetJobSystem(pJobSystem);
+        NvModelExt::SetObjParseThreadCount(threadCount);
+
+        NvModelExtObj* pModel = NvModelExtObj::CreateFromMemory(pData, -1.0f, generateNormals, generateNormals);
+        uint64_t hash = (NULL != pModel) ? HashModel(pModel) : 0;
+        delete pModel;
+
+        NvModelExt::SetJobSystem(NULL);
+        NV_DELETE(pJobSystem);
+        return hash;
+    }
+
+    double Bench(const char* pData, size_t length, uint32_t threadCount, uint32_t loadCount)
+    {
+        nvidia::shdfnd::JobSystem* pJobSystem = NULL;
+        if (threadCount > 1)
+        {
+            pJobSystem = NV_NEW(nvidia::shdfnd::JobSystem)(threadCount - 1);
+        }
+        NvModelExt::SetJobSystem(pJobSystem);
+        NvModelExt::SetObjParseThreadCount(threadCount);
+
+        // The fastest of the loads, to keep other work on the machine out of it
+        double best = 0.0;
+        for (uint32_t loadIndex = 0; loadIndex < loadCount; ++loadIndex)
+        {
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            NvModelExtObj* pModel = NvModelExtObj::CreateFromMemory(pData, -1.0f, false, false);
+            std::chrono::duration<double> seconds = std::chrono::high_resolution_clock::now() - start;
+            delete pModel;
+            if ((0 == loadIndex) || (seconds.count() < best))
+            {
+                best = seconds.count();
+            }
+        }
+
+        NvModelExt::SetJobSystem(NULL);
+        NV_DELETE(pJobSystem);
+        return double(length) / (best * 1.0e6);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool bench = (argc > 1) && (strcmp(argv[1], "bench") == 0);
+    int fileArg = bench ? 2 : 1;
+    if (argc <= fileArg)
+    {
+        printf("Usage: NvModelExtObjTest [bench] <file.obj> [threads] [loads]\n");
+        return 1;
+    }
+
+    const char* fileName = argv[fileArg];
+    size_t length = 0;
+    char* pData = ReadFile(fileName, length);
+    if (NULL == pData)
+    {
+        printf("Could not read %s\n", fileName);
+        return 1;
+    }
+
+    std::string directory(fileName);
+    size_t slash = directory.find_last_of("/\\");
+    directory = (std::string::npos == slash) ? std::string() : directory.substr(0, slash + 1);
+    DirectoryLoader loader(directory);
+    NvModelExt::SetFileLoader(&loader);
+
+    TestAllocator allocator;
+    TestErrorCallback errorCallback;
+    nvidia::shdfnd::initializeSharedFoundation(NV_FOUNDATION_VERSION, allocator, errorCallback);
+
+    int result = 0;
+    if (bench)
+    {
+        uint32_t maxThreads = (argc > 3) ? uint32_t(atoi(argv[3])) : nvidia::shdfnd::Thread::getNbPhysicalCores();
+        uint32_t loadCount = (argc > 4) ? uint32_t(atoi(argv[4])) : 5;
+        printf("%s: %.2f MB, best of %u loads\n", fileName, length / 1.0e6, loadCount);
+        printf("threads   MB/s\n");
+        for (uint32_t threadCount = 1; threadCount <= std::max(maxThreads, 1u); ++threadCount)
+        {
+            printf("%7u %6.1f%s\n", threadCount, Bench(pData, length, threadCount, loadCount),
+                (1 == threadCount) ? "  (serial)" : "");
+        }
+    }
+    else
+    {
+        static const uint32_t THREAD_COUNTS[] = { 2, 3, 4, 8 };
+        uint32_t failures = 0;
+        uint32_t checks = 0;
+        uint64_t modelHash = 0;
+        for (int normals = 0; normals < 2; ++normals)
+        {
+            uint64_t serialHash = LoadAndHash(pData, 1, 0 != normals);
+            if (0 == serialHash)
+            {
+                printf("%s did not load\n", fileName);
+                failures++;
+                break;
+            }
+            if (0 == normals)
+            {
+                modelHash = serialHash;
+            }
+            for (uint32_t i = 0; i < sizeof(THREAD_COUNTS) / sizeof(THREAD_COUNTS[0]); ++i)
+            {
+                checks++;
+                uint64_t hash = LoadAndHash(pData, THREAD_COUNTS[i], 0 != normals);
+                if (hash != serialHash)
+                {
+                    printf("%u threads%s: model %016llx, serial %016llx\n", THREAD_COUNTS[i],
+                        normals ? " with normals" : "", (unsigned long long)hash, (unsigned long long)serialHash);
+                    failures++;
+                }
+            }
+        }
+        printf("%s: %.2f MB, model %016llx, %u of %u parallel loads differ from the serial load: %s\n",
+            fileName, length / 1.0e6, (unsigned long long)modelHash, failures, checks,
+            (0 == failures) ? "passed" : "FAILED");
+        result = (0 == failures) ? 0 : 1;
+    }
+
+    nvidia::shdfnd::terminateSharedFoundation();
+    NvModelExt::SetFileLoader(NULL);
+    delete[] pData;
+    return result;
+}
@@ -33,6 +33,7 @@
 //----------------------------------------------------------------------------------
 
 #include "NvModelObj.h"
+#include "NvModelVertexCacheOptimizer.h"
 
 #include <iostream>
 #include <sstream>
@@ -690,7 +691,22 @@ void NvModelObj::compileModel(NvModelPrimType::Enum prim) {
 		m_maxExtent = nv::max(m_maxExtent, nv::vec3f(&pit[0]));
 	}
 
+	if (needsTriangles && ms_optimizeVertexCache && !indices[2].empty())
+	{
+		// Reorder for the vertex cache before the arrays are copied.  Only the
+		// triangle list is kept, so the edge and adjacency lists built above
+		// don't need to follow the renumbered vertices.
+		Nv::VertexCacheStats before, after;
+		Nv::VertexCacheOptimizer::Optimize(&indices[2][0], (uint32_t)indices[2].size(),
+			&vertices[0], (uint32_t)(vertices.size() / _vtxSize), _vtxSize, &before, &after);
+#ifdef _DEBUG
+		LOGI("NvModel vertex cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+			before.m_acmr, after.m_acmr, before.m_atvr, after.m_atvr);
+#endif
+	}
+
 	// allocate and copy vectors to arrays
+	releaseData();
 	_vertexCount = vertices.size() / _vtxSize;
 	_indexCount = indices[2].size();
 
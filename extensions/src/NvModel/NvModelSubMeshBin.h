@@ -45,6 +45,11 @@ namespace Nv
         SubMeshBin() { 
         }
 
+        ~SubMeshBin() {
+            delete[] m_packedVertices;
+            delete[] m_packedIndices;
+        }
+
         /// Checks to see if the submesh's vertices contain normals
         /// \return True if the submesh's vertices contain normals, 
         ///         false if no normals exist.
@@ -38,7 +38,8 @@
 #include <NvAssert.h>
 #include <NV/NvLogs.h>
 #include <vector>
-#include <map>
+#include <algorithm>
+#include <math.h>
 
 namespace Nv
 {
@@ -48,6 +49,13 @@ namespace Nv
     // by the order in which it was added to the compactor, to its position in the 
     // compacted set.  The container may be given a comparator object to control
     // the methods used to compare the vectors for merging.  
+    //
+    // Candidates for merging are found through a uniform spatial hash grid over
+    // the first three components of the vectors.  The grid cells are twice the
+    // comparator's search radius on a side, so every vector that could merge with
+    // a given one lies in at most 8 neighbouring cells.  Cells are stored in a flat,
+    // open-addressed table, and the vectors within a cell are chained by index, so
+    // adding a vector never allocates a node.
     template <class T, typename Cmp >
     class VectorCompactor
     {
@@ -57,8 +65,12 @@ namespace Nv
         VectorCompactor(float epsilon, uint32_t reserveSize, Cmp comp = Cmp()) :
             m_mappedIndices(0, -1),
             m_epsilon(epsilon),
-            m_comp(comp)
+            m_comp(comp),
+            m_cellCount(0)
         {
+            m_searchRadius = m_comp.SearchRadius(epsilon);
+            m_invCellSize = (m_searchRadius > 0.0f) ? (0.5f / m_searchRadius) : 0.0f;
+            ResizeCellTable(MIN_CELL_TABLE_SIZE);
             Reserve(reserveSize);
         }
 
@@ -67,7 +79,8 @@ namespace Nv
         {
             m_vecs.resize(0);
             m_mappedIndices.resize(0);
-            m_vecMap.clear();
+            m_nextInCell.resize(0);
+            ClearCellTable();
         }
 
         // Reserve an initial size for the container and its underlying structures.
@@ -78,6 +91,18 @@ namespace Nv
         {
             m_vecs.reserve(size);
             m_mappedIndices.reserve(size);
+            m_nextInCell.reserve(size);
+
+            // Keep the cell table at most half full for the reserved vector count
+            uint32_t tableSize = (uint32_t)m_cellTable.size();
+            while (tableSize < 2 * size)
+            {
+                tableSize *= 2;
+            }
+            if (tableSize != m_cellTable.size())
+            {
+                ResizeCellTable(tableSize);
+            }
         }
 
         // Adds a vector to the container.  The vector's original index will be 
@@ -129,10 +154,10 @@ namespace Nv
         // Returns the number of vectors in the compacted set of vectors
         uint32_t GetVectorCount() { return (uint32_t)(m_vecs.size()); }
 
-        // Note that the key can not be modified once added, so doing this rescale
-        // causes the keys to be out of sync with the vectors themselves.  No new
-        // vectors should be added after this method is called, or they may be
-        // sorted incorrectly.
+        // Rescales all of the vectors in the compacted set.  The spatial grid is
+        // rebuilt from the rescaled vectors, so vectors added afterwards are
+        // still welded against them, but note that the merge tolerance is not
+        // rescaled along with them.
         // \param[in] scale Scale factor to multiply all vectors by
         // \param[in] center Object space point about which center the vectors before scaling them
         void RescaleToOrigin(float scale, const T& center)
@@ -145,27 +170,156 @@ namespace Nv
                 (*it) = scale * ((*it) - center);
                 ++it;
             }
+
+            RebuildCellTable();
         }
 
     protected:
-        // Structure used to order vectors added to the container.  We use a one-dimensional
-        // container to hold the vectors, so simply sort them by a single coordinate.
-        struct VecCompare
+        // Smallest number of slots in the cell table.  Must be a power of two.
+        static const uint32_t MIN_CELL_TABLE_SIZE = 64;
+
+        // Value of CellSlot::m_head, and of m_nextInCell, that terminates a chain
+        static const int32_t END_OF_CHAIN = -1;
+
+        // An entry in the open-addressed cell table.  An occupied slot holds
+        // the integer coordinates of one grid cell and the index of the most
+        // recently added vector in that cell.  The remaining vectors in the
+        // cell are chained through m_nextInCell.  An empty slot has a head of
+        // END_OF_CHAIN.
+        struct CellSlot
+        {
+            int32_t m_cell[3];
+            int32_t m_head;
+        };
+
+        // Computes the grid cell containing the given vector, along with the
+        // direction (-1 or +1) of the neighbouring cell in each dimension that
+        // is within the search radius of the vector
+        void ComputeCell(const T& v, int32_t cell[3], int32_t neighbor[3]) const
         {
-            bool operator()(const T& lhs, const std::pair<T, int32_t>& rhs) const
+            int32_t dims = (v.size() < 3) ? v.size() : 3;
+            for (int32_t i = 0; i < 3; ++i)
             {
-                return lhs[0] < rhs.first[0];
+                cell[i] = 0;
+                neighbor[i] = 0;
             }
 
-            bool operator()(const T& lhs, const T&rhs) const
+            for (int32_t i = 0; i < dims; ++i)
             {
-                return lhs[0] < rhs[0];
+                float scaled = v[i] * m_invCellSize;
+                float base = floorf(scaled);
+
+                // Keep far-away or non-finite values from overflowing the
+                // integer cell coordinates; they simply share the edge cells
+                if (!(base > -1.0e9f))
+                {
+                    base = -1.0e9f;
+                }
+                else if (base > 1.0e9f)
+                {
+                    base = 1.0e9f;
+                }
+
+                cell[i] = (int32_t)base;
+                neighbor[i] = ((scaled - base) < 0.5f) ? -1 : 1;
             }
-        };
+        }
 
-        // Useful typedefs for internal containers and associated objects
-        typedef typename std::pair<T, int32_t> VecMapPair;
-        typedef typename std::multimap<T, int32_t, VecCompare> VecMap;
+        static uint32_t HashCell(const int32_t cell[3])
+        {
+            return ((uint32_t)cell[0] * 73856093u) ^
+                ((uint32_t)cell[1] * 19349663u) ^
+                ((uint32_t)cell[2] * 83492791u);
+        }
+
+        // Returns the slot holding the given cell, or the empty slot at which
+        // the cell would be inserted
+        uint32_t FindSlot(const int32_t cell[3]) const
+        {
+            uint32_t mask = (uint32_t)m_cellTable.size() - 1;
+            uint32_t slot = HashCell(cell) & mask;
+            for (;;)
+            {
+                const CellSlot& entry = m_cellTable[slot];
+                if ((entry.m_head == END_OF_CHAIN) ||
+                    ((entry.m_cell[0] == cell[0]) &&
+                     (entry.m_cell[1] == cell[1]) &&
+                     (entry.m_cell[2] == cell[2])))
+                {
+                    return slot;
+                }
+                slot = (slot + 1) & mask;
+            }
+        }
+
+        void ClearCellTable()
+        {
+            CellSlot empty;
+            empty.m_cell[0] = empty.m_cell[1] = empty.m_cell[2] = 0;
+            empty.m_head = END_OF_CHAIN;
+            std::fill(m_cellTable.begin(), m_cellTable.end(), empty);
+            m_cellCount = 0;
+        }
+
+        // Resizes the cell table to the given power-of-two number of slots,
+        // re-inserting all occupied cells.  The per-cell chains are unaffected.
+        void ResizeCellTable(uint32_t size)
+        {
+            std::vector<CellSlot> oldTable;
+            oldTable.swap(m_cellTable);
+            m_cellTable.resize(size);
+            ClearCellTable();
+
+            typename std::vector<CellSlot>::const_iterator it = oldTable.begin();
+            typename std::vector<CellSlot>::const_iterator itEnd = oldTable.end();
+            for (; it != itEnd; ++it)
+            {
+                if (it->m_head != END_OF_CHAIN)
+                {
+                    m_cellTable[FindSlot(it->m_cell)] = *it;
+                    ++m_cellCount;
+                }
+            }
+        }
+
+        // Re-inserts every compacted vector into an empty grid, in order
+        void RebuildCellTable()
+        {
+            ClearCellTable();
+            m_nextInCell.resize(0);
+
+            int32_t cell[3];
+            int32_t neighbor[3];
+            int32_t count = (int32_t)m_vecs.size();
+            for (int32_t index = 0; index < count; ++index)
+            {
+                ComputeCell(m_vecs[index], cell, neighbor);
+                LinkIntoCell(index, cell);
+            }
+        }
+
+        // Adds the vector with the given compacted index to the head of the
+        // chain for the given cell
+        void LinkIntoCell(int32_t index, const int32_t cell[3])
+        {
+            uint32_t slot = FindSlot(cell);
+            CellSlot& entry = m_cellTable[slot];
+            if (entry.m_head == END_OF_CHAIN)
+            {
+                entry.m_cell[0] = cell[0];
+                entry.m_cell[1] = cell[1];
+                entry.m_cell[2] = cell[2];
+                ++m_cellCount;
+            }
+            m_nextInCell.push_back(entry.m_head);
+            entry.m_head = index;
+
+            // Keep the table at most half full so that probe sequences stay short
+            if (2 * m_cellCount > m_cellTable.size())
+            {
+                ResizeCellTable(2 * (uint32_t)m_cellTable.size());
+            }
+        }
 
         // Finds an existing vector in the set of compacted vectors that is
         // close enough to the given vector to merge and returns the index
@@ -176,82 +330,88 @@ namespace Nv
         // \return The index of the vector in the compacted set
         int32_t FindOrAddObject(const T& v)
         {
-            // If we have nothing yet, then we simply add this vector to the set
-            if (m_vecs.empty())
-            {
-                return Add(v, m_vecMap.begin());
-            }
+            int32_t cell[3];
+            int32_t neighbor[3];
+            ComputeCell(v, cell, neighbor);
 
-            // We'll need to find the subset of existing vectors that are potential candidates
-            // for welding by finding all within the epsilon of the given vector.  We
-            // will use a vector whose components are all epsilon to add and subtract
-            // from the given vector to define the extents of our search.  Since we don't
-            // know how many components our contained vectors will have, we will use a
-            // vec4f to initialize it, as all vectors can be initialized from one.
-            T epsilonVec = T(nv::vec4f(m_epsilon, m_epsilon, m_epsilon, m_epsilon));
-
-            // Find the first vector whose x is greater than our minimum
-            T minVec = v - epsilonVec;
-            typename VecMap::iterator rangeStart = m_vecMap.lower_bound(minVec);
-
-            if (rangeStart == m_vecMap.end())
+            // Without a search radius, nothing can be merged
+            if (m_searchRadius <= 0.0f)
             {
-                // All existing positions are "below" our minimum point, so insert a 
-                // new vector at the end of the map
-                return Add(v, --rangeStart);
+                return Add(v, cell);
             }
 
-            // Find the first vector whose x is greater than our maximum, thus out of our 
-            // range of candidates
-            T maxVec = v + epsilonVec;
-            typename VecMap::iterator rangeEnd = m_vecMap.upper_bound(maxVec);
-
-            if (rangeStart == rangeEnd)
-            {
-                // No positions are in the range we're looking for, so insert one 
-                // at the closest point in the map
-                return Add(v, --rangeStart);
-            }
+            // Any vector close enough to merge is in the vector's own cell or in
+            // one of the cells on the near side of it in each dimension, so we
+            // visit the (up to) 8 cells of that 2x2x2 block.  When several
+            // candidates are equally close, the earliest added one wins.
+            int32_t bestIndex = END_OF_CHAIN;
+            float bestDist2 = 0.0f;
 
-            // Use the first candidate within our possible range to initialize 
-            // our search as the closest candidate
-            typename VecMap::iterator closestPosition = rangeStart;
-            typename VecMap::iterator currentIt = rangeStart;
-            float bestDist2 = m_comp.Diff(v, rangeStart->first);
+            // Candidates have always been limited to those whose first component
+            // is within epsilon of the given vector's; keep doing so, so that the
+            // set of merged vectors does not change
+            float minX = v[0] - m_epsilon;
+            float maxX = v[0] + m_epsilon;
 
-            // Check all the other vectors in the range for a closer fit
-            for (++currentIt; currentIt != rangeEnd; ++currentIt)
+            for (uint32_t corner = 0; corner < 8; ++corner)
             {
-                float dist2 = m_comp.Diff(v, currentIt->first);
-                if (dist2 < bestDist2)
+                int32_t probe[3];
+                bool visit = true;
+                for (int32_t i = 0; i < 3; ++i)
                 {
-                    bestDist2 = dist2;
-                    closestPosition = currentIt;
+                    int32_t step = (corner >> i) & 1;
+                    if (step && !neighbor[i])
+                    {
+                        // Unused dimension; only one cell to visit along it
+                        visit = false;
+                        break;
+                    }
+                    probe[i] = cell[i] + step * neighbor[i];
+                }
+                if (!visit)
+                {
+                    continue;
+                }
+
+                const CellSlot& entry = m_cellTable[FindSlot(probe)];
+                for (int32_t index = entry.m_head; index != END_OF_CHAIN; index = m_nextInCell[index])
+                {
+                    const T& candidate = m_vecs[index];
+                    if ((candidate[0] < minX) || (candidate[0] > maxX))
+                    {
+                        continue;
+                    }
+
+                    float dist2 = m_comp.Diff(v, candidate);
+                    if ((bestIndex == END_OF_CHAIN) || (dist2 < bestDist2) ||
+                        ((dist2 == bestDist2) && (index < bestIndex)))
+                    {
+                        bestDist2 = dist2;
+                        bestIndex = index;
+                    }
                 }
             }
 
             // Once we have our closest match, see if it's close enough
-            if (!m_comp.ShouldMerge(bestDist2, m_epsilon))
+            if ((bestIndex == END_OF_CHAIN) || !m_comp.ShouldMerge(bestDist2, m_epsilon))
             {
                 // It wasn't, so we need to add the given vector as a new one
-                return Add(v, rangeStart);
+                return Add(v, cell);
             }
 
             // We found a suitable vector for re-use
-            return closestPosition->second;
+            return bestIndex;
         }
 
-        // Adds the given vector to the compacted set, using the given hint
-        // to find the right spot
-        int32_t Add(const T& v, const typename VecMap::iterator& hint)
+        // Adds the given vector to the compacted set, in the given grid cell
+        int32_t Add(const T& v, const int32_t cell[3])
         {
             // The remapped index will be the current number of vectors in the compacted set
             int32_t index = int32_t(m_vecs.size());
             m_vecs.push_back(v);
 
-            // Add a map entry for the given vector to our vector map, pointing it towards
-            // the proper location in the compacted set
-            m_vecMap.insert(hint, VecMapPair(v, index));
+            // Add the vector to its grid cell so that later vectors may be merged with it
+            LinkIntoCell(index, cell);
 
             // Return the new, compacted set index to the caller to be added to the remapping vector
             return index;
@@ -259,9 +419,15 @@ namespace Nv
 
         Cmp m_comp;         // The comparator object used to evaluate vectors for merging
         float m_epsilon;    // The tolerance to be used when evaluating vectors for merging
+        float m_searchRadius;   // Largest per-component difference between two vectors that can merge
+        float m_invCellSize;    // Reciprocal of the grid cell size (twice the search radius)
 
         VecArray m_vecs;    // The compacted set of vectors
-        VecMap m_vecMap;    // The map of existing vectors to their index in the compacted set
+
+        std::vector<CellSlot> m_cellTable;  // Open-addressed table of occupied grid cells
+        uint32_t m_cellCount;               // Number of occupied slots in m_cellTable
+        std::vector<int32_t> m_nextInCell;  // One entry per compacted vector, holding the
+                                            // index of the next older vector in the same cell
 
         std::vector<int32_t> m_mappedIndices;   // One entry per vector added to the container, 
                                                 // containing the index in the compacted set that 
@@ -285,6 +451,12 @@ namespace Nv
         {
             return diff < (epsilon * epsilon);
         }
+
+        // Points can only merge if every component is within epsilon
+        float SearchRadius(float epsilon)
+        {
+            return epsilon;
+        }
     };
 
     // Normal Comparator
@@ -302,6 +474,15 @@ namespace Nv
         {
             return (diff < epsilon);
         }
+
+        // For unit vectors, |v1 - v2|^2 = 2 * (1 - dot(v1, v2)), so normals can
+        // only merge if every component is within sqrt(2 * epsilon).  Longer
+        // vectors could merge from further apart and be missed, so normals
+        // must be normalized before they are added.
+        float SearchRadius(float epsilon)
+        {
+            return (epsilon > 0.0f) ? sqrtf(2.0f * epsilon) : 0.0f;
+        }
     };
 
     // Helper struct to simplify declarations of compactors for different vector usages
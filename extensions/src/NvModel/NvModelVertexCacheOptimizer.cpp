@@ -0,0 +1,361 @@
+//----------------------------------------------------------------------------------
+// File:        NvModel/NvModelVertexCacheOptimizer.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvModelVertexCacheOptimizer.h"
+
+#include <NvAssert.h>
+#include <vector>
+#include <math.h>
+#include <string.h>
+
+namespace Nv
+{
+    // Scoring constants from "Linear-Speed Vertex Cache Optimisation"
+    static const float sCacheDecayPower = 1.5f;
+    static const float sLastTriScore = 0.75f;
+    static const float sValenceBoostScale = 2.0f;
+    static const float sValenceBoostPower = 0.5f;
+
+    // Valences up to this are scored from a table, higher ones are computed directly
+    static const uint32_t sMaxTableValence = 32;
+
+    static const uint32_t sCacheSize = VertexCacheOptimizer::DEFAULT_CACHE_SIZE;
+
+    // Precomputed vertex scores for each cache position and small valences
+    struct VertexScoreTable
+    {
+        VertexScoreTable()
+        {
+            const float scaler = 1.0f / float(sCacheSize - 3);
+            for (uint32_t i = 0; i < sCacheSize; ++i)
+            {
+                // The vertices of the most recently added triangle all get the same,
+                // fixed score, so that the next triangle isn't biased towards any one
+                // of its edges
+                m_cacheScores[i] = (i < 3) ? sLastTriScore : powf(1.0f - float(i - 3) * scaler, sCacheDecayPower);
+            }
+
+            m_valenceScores[0] = 0.0f;
+            for (uint32_t i = 1; i <= sMaxTableValence; ++i)
+            {
+                m_valenceScores[i] = sValenceBoostScale * powf(float(i), -sValenceBoostPower);
+            }
+        }
+
+        // Score of a vertex at the given position in the cache (or -1 if it isn't
+        // in it) that is still used by the given number of unemitted triangles
+        float Score(int32_t cachePosition, uint32_t remainingValence) const
+        {
+            if (0 == remainingValence)
+            {
+                // No triangles left to emit that use this vertex
+                return -1.0f;
+            }
+
+            float score = (cachePosition >= 0) ? m_cacheScores[cachePosition] : 0.0f;
+
+            // Boost vertices with few remaining triangles, so that they're finished
+            // off quickly rather than being left behind as lone triangles
+            score += (remainingValence <= sMaxTableValence) ? m_valenceScores[remainingValence]
+                : (sValenceBoostScale * powf(float(remainingValence), -sValenceBoostPower));
+            return score;
+        }
+
+        float m_cacheScores[sCacheSize];
+        float m_valenceScores[sMaxTableValence + 1];
+    };
+
+    VertexCacheStats VertexCacheOptimizer::ComputeStats(const uint32_t* pIndices, uint32_t indexCount,
+        uint32_t vertexCount, uint32_t cacheSize)
+    {
+        VertexCacheStats stats;
+        if ((indexCount < 3) || (0 == vertexCount))
+        {
+            return stats;
+        }
+
+        // Rather than maintaining the FIFO itself, record the time at which each
+        // vertex last entered it.  A vertex is still in the cache if fewer than
+        // cacheSize other vertices have entered since.
+        std::vector<uint32_t> entryTimes(vertexCount, 0);
+        uint32_t time = cacheSize + 1;
+        uint32_t misses = 0;
+        uint32_t uniqueVertices = 0;
+        for (uint32_t i = 0; i < indexCount; ++i)
+        {
+            uint32_t index = pIndices[i];
+            NV_ASSERT(index < vertexCount);
+            if (0 == entryTimes[index])
+            {
+                ++uniqueVertices;
+            }
+            if (time - entryTimes[index] > cacheSize)
+            {
+                entryTimes[index] = time++;
+                ++misses;
+            }
+        }
+
+        stats.m_acmr = float(misses) / float(indexCount / 3);
+        stats.m_atvr = float(misses) / float(uniqueVertices);
+        return stats;
+    }
+
+    void VertexCacheOptimizer::OptimizeTriangleOrder(uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount)
+    {
+        static const VertexScoreTable scoreTable;
+
+        uint32_t triCount = indexCount / 3;
+        if (triCount < 2)
+        {
+            return;
+        }
+
+        // Build the list of triangles that use each vertex.  A triangle appears
+        // once for every corner that uses the vertex, so degenerate triangles
+        // are handled like any other.
+        std::vector<uint32_t> remainingValence(vertexCount, 0);
+        for (uint32_t i = 0; i < triCount * 3; ++i)
+        {
+            ++remainingValence[pIndices[i]];
+        }
+
+        std::vector<uint32_t> vertTriOffsets(vertexCount + 1, 0);
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            vertTriOffsets[v + 1] = vertTriOffsets[v] + remainingValence[v];
+        }
+
+        std::vector<uint32_t> vertTris(triCount * 3);
+        {
+            std::vector<uint32_t> fill(vertTriOffsets.begin(), vertTriOffsets.end() - 1);
+            for (uint32_t i = 0; i < triCount * 3; ++i)
+            {
+                vertTris[fill[pIndices[i]]++] = i / 3;
+            }
+        }
+
+        std::vector<int32_t> cachePositions(vertexCount, -1);
+        std::vector<float> vertScores(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            vertScores[v] = scoreTable.Score(-1, remainingValence[v]);
+        }
+
+        std::vector<float> triScores(triCount);
+        std::vector<bool> triEmitted(triCount, false);
+        int32_t bestTri = -1;
+        float bestScore = -1.0f;
+        for (uint32_t t = 0; t < triCount; ++t)
+        {
+            const uint32_t* pTri = pIndices + t * 3;
+            triScores[t] = vertScores[pTri[0]] + vertScores[pTri[1]] + vertScores[pTri[2]];
+            if (triScores[t] > bestScore)
+            {
+                bestScore = triScores[t];
+                bestTri = int32_t(t);
+            }
+        }
+
+        // The cache holds up to sCacheSize vertices, plus room for the three
+        // vertices of a newly emitted triangle before the oldest ones are evicted
+        uint32_t cache[sCacheSize + 3];
+        uint32_t newCache[sCacheSize + 3];
+        uint32_t cacheCount = 0;
+
+        std::vector<uint32_t> newIndices(triCount * 3);
+        uint32_t nextUnemittedTri = 0;
+        for (uint32_t emitted = 0; emitted < triCount; ++emitted)
+        {
+            if (bestTri < 0)
+            {
+                // None of the cached vertices are used by a remaining triangle, so
+                // continue with the first remaining triangle in the original order
+                while (triEmitted[nextUnemittedTri])
+                {
+                    ++nextUnemittedTri;
+                }
+                bestTri = int32_t(nextUnemittedTri);
+            }
+
+            const uint32_t* pTri = pIndices + bestTri * 3;
+            memcpy(&newIndices[emitted * 3], pTri, 3 * sizeof(uint32_t));
+            triEmitted[bestTri] = true;
+
+            // Remove the triangle from its vertices' lists of remaining triangles
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                uint32_t v = pTri[corner];
+                uint32_t* pVertTris = &vertTris[vertTriOffsets[v]];
+                uint32_t last = --remainingValence[v];
+                for (uint32_t i = 0; i <= last; ++i)
+                {
+                    if (pVertTris[i] == uint32_t(bestTri))
+                    {
+                        pVertTris[i] = pVertTris[last];
+                        pVertTris[last] = uint32_t(bestTri);
+                        break;
+                    }
+                }
+            }
+
+            // Move the triangle's vertices to the front of the cache, followed
+            // by the previous contents of the cache in their existing order
+            uint32_t newCacheCount = 0;
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                uint32_t v = pTri[corner];
+                if ((corner > 0) && (v == pTri[0]))
+                {
+                    continue;
+                }
+                if ((corner > 1) && (v == pTri[1]))
+                {
+                    continue;
+                }
+                newCache[newCacheCount++] = v;
+            }
+            for (uint32_t i = 0; i < cacheCount; ++i)
+            {
+                uint32_t v = cache[i];
+                if ((v != pTri[0]) && (v != pTri[1]) && (v != pTri[2]))
+                {
+                    newCache[newCacheCount++] = v;
+                }
+            }
+
+            // Rescore every vertex whose cache position changed, including
+            // those that just fell out of the cache
+            for (uint32_t i = 0; i < newCacheCount; ++i)
+            {
+                uint32_t v = newCache[i];
+                cachePositions[v] = (i < sCacheSize) ? int32_t(i) : -1;
+                vertScores[v] = scoreTable.Score(cachePositions[v], remainingValence[v]);
+            }
+
+            // Rescore the remaining triangles that use those vertices, and pick
+            // the best of them to emit next
+            bestTri = -1;
+            bestScore = -1.0f;
+            for (uint32_t i = 0; i < newCacheCount; ++i)
+            {
+                uint32_t v = newCache[i];
+                const uint32_t* pVertTris = &vertTris[vertTriOffsets[v]];
+                for (uint32_t j = 0; j < remainingValence[v]; ++j)
+                {
+                    uint32_t t = pVertTris[j];
+                    const uint32_t* pOtherTri = pIndices + t * 3;
+                    float score = vertScores[pOtherTri[0]] + vertScores[pOtherTri[1]] + vertScores[pOtherTri[2]];
+                    triScores[t] = score;
+                    if (score > bestScore)
+                    {
+                        bestScore = score;
+                        bestTri = int32_t(t);
+                    }
+                }
+            }
+
+            cacheCount = (newCacheCount < sCacheSize) ? newCacheCount : sCacheSize;
+            memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+        }
+
+        memcpy(pIndices, &newIndices[0], triCount * 3 * sizeof(uint32_t));
+    }
+
+    void VertexCacheOptimizer::OptimizeVertexOrder(uint32_t* pIndices, uint32_t indexCount,
+        float* pVertices, uint32_t vertexCount, uint32_t vertexSize)
+    {
+        if (0 == vertexCount)
+        {
+            return;
+        }
+
+        // Number the vertices in the order the triangle list first uses them
+        static const uint32_t sUnassigned = 0xFFFFFFFF;
+        std::vector<uint32_t> remap(vertexCount, sUnassigned);
+        uint32_t nextVertex = 0;
+        for (uint32_t i = 0; i < indexCount; ++i)
+        {
+            uint32_t& newIndex = remap[pIndices[i]];
+            if (sUnassigned == newIndex)
+            {
+                newIndex = nextVertex++;
+            }
+            pIndices[i] = newIndex;
+        }
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            if (sUnassigned == remap[v])
+            {
+                remap[v] = nextVertex++;
+            }
+        }
+
+        std::vector<float> oldVertices(pVertices, pVertices + vertexCount * vertexSize);
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            memcpy(pVertices + remap[v] * vertexSize, &oldVertices[v * vertexSize], vertexSize * sizeof(float));
+        }
+    }
+
+    void VertexCacheOptimizer::Optimize(uint32_t* pIndices, uint32_t indexCount,
+        float* pVertices, uint32_t vertexCount, uint32_t vertexSize,
+        VertexCacheStats* pStatsBefore, VertexCacheStats* pStatsAfter)
+    {
+        VertexCacheStats before = ComputeStats(pIndices, indexCount, vertexCount);
+
+        // The greedy reordering can occasionally do slightly worse than an order
+        // that was already good (small meshes whose vertices all fit in the cache,
+        // for example), in which case the original triangle order is kept
+        std::vector<uint32_t> originalIndices(pIndices, pIndices + indexCount);
+        OptimizeTriangleOrder(pIndices, indexCount, vertexCount);
+        VertexCacheStats after = ComputeStats(pIndices, indexCount, vertexCount);
+        if (after.m_acmr > before.m_acmr)
+        {
+            memcpy(pIndices, &originalIndices[0], indexCount * sizeof(uint32_t));
+            after = before;
+        }
+
+        // Renumbering the vertices doesn't change which ones hit the cache
+        OptimizeVertexOrder(pIndices, indexCount, pVertices, vertexCount, vertexSize);
+
+        if (NULL != pStatsBefore)
+        {
+            *pStatsBefore = before;
+        }
+        if (NULL != pStatsAfter)
+        {
+            *pStatsAfter = after;
+        }
+    }
+}
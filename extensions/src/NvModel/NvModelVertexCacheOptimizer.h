@@ -0,0 +1,112 @@
+//----------------------------------------------------------------------------------
+// File:        NvModel/NvModelVertexCacheOptimizer.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef _NVMODELVERTEXCACHEOPTIMIZER_H_
+#define _NVMODELVERTEXCACHEOPTIMIZER_H_
+#pragma once
+
+#include <NvSimpleTypes.h>
+
+namespace Nv
+{
+    // Measures of how well a triangle list makes use of the GPU's post-transform
+    // vertex cache, as determined by simulating a FIFO cache of a given size
+    struct VertexCacheStats
+    {
+        VertexCacheStats() : m_acmr(0.0f), m_atvr(0.0f) {}
+
+        // Average cache miss ratio: vertices transformed per triangle.  Ranges from
+        // 3.0 (every vertex of every triangle is transformed) down to about 0.5 for
+        // large, regular meshes.
+        float m_acmr;
+
+        // Average transform to vertex ratio: vertices transformed per unique vertex
+        // referenced.  1.0 means every vertex is transformed exactly once.
+        float m_atvr;
+    };
+
+    // Reorders indexed triangle lists for better GPU vertex reuse.  Triangles are
+    // first reordered using Tom Forsyth's "Linear-Speed Vertex Cache Optimisation",
+    // which greedily emits the triangle whose vertices score highest, given their
+    // position in a simulated LRU cache and the number of triangles still using
+    // them.  The vertices are then renumbered in the order that the new triangle
+    // order first uses them, so that vertex fetches walk the vertex buffer linearly.
+    class VertexCacheOptimizer
+    {
+    public:
+        // Cache size assumed when scoring vertices and when computing statistics
+        static const uint32_t DEFAULT_CACHE_SIZE = 32;
+
+        /// Computes the cache statistics of a triangle list
+        /// \param[in] pIndices Array of indexCount vertex indices, three per triangle
+        /// \param[in] indexCount Number of indices in the list
+        /// \param[in] vertexCount Number of vertices referenced by the indices
+        /// \param[in] cacheSize Number of entries in the simulated FIFO cache
+        /// \return Statistics describing the list's vertex cache efficiency
+        static VertexCacheStats ComputeStats(const uint32_t* pIndices, uint32_t indexCount,
+            uint32_t vertexCount, uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+
+        /// Reorders the triangles of a triangle list to improve vertex cache reuse.
+        /// The vertices referenced by each triangle, and their winding, are unchanged.
+        /// \param[in,out] pIndices Array of indexCount vertex indices, three per triangle
+        /// \param[in] indexCount Number of indices in the list
+        /// \param[in] vertexCount Number of vertices referenced by the indices
+        static void OptimizeTriangleOrder(uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount);
+
+        /// Reorders the vertices of a mesh into the order in which its triangle
+        /// list first uses them, and updates the indices to match.  Vertices
+        /// that aren't referenced by any triangle are moved to the end.
+        /// \param[in,out] pIndices Array of indexCount vertex indices, three per triangle
+        /// \param[in] indexCount Number of indices in the list
+        /// \param[in,out] pVertices Array of vertexCount vertices, each vertexSize floats long
+        /// \param[in] vertexCount Number of vertices in the vertex array
+        /// \param[in] vertexSize Size of each vertex, in floats
+        static void OptimizeVertexOrder(uint32_t* pIndices, uint32_t indexCount,
+            float* pVertices, uint32_t vertexCount, uint32_t vertexSize);
+
+        /// Reorders both the triangles and the vertices of a mesh, as described above.
+        /// If reordering the triangles wouldn't lower the ACMR, their order is kept.
+        /// \param[in,out] pIndices Array of indexCount vertex indices, three per triangle
+        /// \param[in] indexCount Number of indices in the list
+        /// \param[in,out] pVertices Array of vertexCount vertices, each vertexSize floats long
+        /// \param[in] vertexCount Number of vertices in the vertex array
+        /// \param[in] vertexSize Size of each vertex, in floats
+        /// \param[out] pStatsBefore If non-NULL, receives the statistics of the original mesh
+        /// \param[out] pStatsAfter If non-NULL, receives the statistics of the optimized mesh
+        static void Optimize(uint32_t* pIndices, uint32_t indexCount,
+            float* pVertices, uint32_t vertexCount, uint32_t vertexSize,
+            VertexCacheStats* pStatsBefore = NULL, VertexCacheStats* pStatsAfter = NULL);
+    };
+}
+
+#endif
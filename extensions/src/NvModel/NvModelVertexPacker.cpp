@@ -0,0 +1,521 @@
+//----------------------------------------------------------------------------------
+// File:        NvModel/NvModelVertexPacker.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvModelVertexPacker.h"
+
+#include <NvAssert.h>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+namespace Nv
+{
+    // Sizes, in floats, of the attributes that are packed
+    static const int32_t sPositionFloats = 3;
+    static const int32_t sNormalFloats = 3;
+    static const int32_t sTexCoordFloats = 2;
+    static const int32_t sTangentFloats = 3;
+
+    // Sizes, in bytes, of the packed attributes.  Positions are padded to keep
+    // every attribute 4-byte aligned.
+    static const int32_t sPackedPositionSize = 4 * sizeof(uint16_t);
+    static const int32_t sPackedUnitVectorSize = 2 * sizeof(int16_t);
+    static const int32_t sPackedTexCoordSize = 2 * sizeof(uint16_t);
+
+    static uint16_t FloatToHalf(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        uint16_t sign = uint16_t((bits >> 16) & 0x8000);
+        int32_t exponent = int32_t((bits >> 23) & 0xFF) - 127 + 15;
+        uint32_t mantissa = bits & 0x007FFFFF;
+
+        if (exponent >= 31)
+        {
+            // Infinity and NaN keep their class, overflows become infinity
+            bool isNaN = (((bits >> 23) & 0xFF) == 0xFF) && (0 != mantissa);
+            return sign | 0x7C00 | (isNaN ? 0x0200 : 0);
+        }
+
+        if (exponent <= 0)
+        {
+            if (exponent < -10)
+            {
+                return sign;
+            }
+
+            // Denormal half: shift the mantissa, including its implicit leading
+            // one, into place, rounding to nearest even
+            mantissa |= 0x00800000;
+            uint32_t shift = uint32_t(14 - exponent);
+            uint32_t halfMantissa = mantissa >> shift;
+            uint32_t remainder = mantissa & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+            if ((remainder > halfway) || ((remainder == halfway) && (halfMantissa & 1)))
+            {
+                ++halfMantissa;
+            }
+            return sign | uint16_t(halfMantissa);
+        }
+
+        // Normal half, rounding to nearest even.  A carry out of the mantissa
+        // correctly increments the exponent, up to infinity.
+        uint32_t half = (uint32_t(exponent) << 10) | (mantissa >> 13);
+        uint32_t remainder = mantissa & 0x1FFF;
+        if ((remainder > 0x1000) || ((remainder == 0x1000) && (half & 1)))
+        {
+            ++half;
+        }
+        return sign | uint16_t(half);
+    }
+
+    static float HalfToFloat(uint16_t half)
+    {
+        uint32_t sign = uint32_t(half & 0x8000) << 16;
+        uint32_t exponent = (half >> 10) & 0x1F;
+        uint32_t mantissa = half & 0x03FF;
+
+        uint32_t bits;
+        if (0 == exponent)
+        {
+            if (0 == mantissa)
+            {
+                bits = sign;
+            }
+            else
+            {
+                // Denormal half, which is a normal float
+                exponent = 127 - 15 + 1;
+                while (0 == (mantissa & 0x0400))
+                {
+                    mantissa <<= 1;
+                    --exponent;
+                }
+                bits = sign | (exponent << 23) | ((mantissa & 0x03FF) << 13);
+            }
+        }
+        else if (31 == exponent)
+        {
+            bits = sign | 0x7F800000 | (mantissa << 13);
+        }
+        else
+        {
+            bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+        }
+
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    static int16_t FloatToSnorm16(float value)
+    {
+        value = (value < -1.0f) ? -1.0f : ((value > 1.0f) ? 1.0f : value);
+        return int16_t(floorf(value * 32767.0f + 0.5f));
+    }
+
+    static float Snorm16ToFloat(int16_t value)
+    {
+        float f = float(value) * (1.0f / 32767.0f);
+        return (f < -1.0f) ? -1.0f : f;
+    }
+
+    // Octahedral encoding maps the unit sphere onto the faces of an octahedron,
+    // then unfolds its lower half over the upper half to fill a square
+    static void EncodeOctahedral(const float* pVector, int16_t* pEncoded)
+    {
+        float length = fabsf(pVector[0]) + fabsf(pVector[1]) + fabsf(pVector[2]);
+        if (0.0f == length)
+        {
+            pEncoded[0] = 0;
+            pEncoded[1] = 0;
+            return;
+        }
+
+        float x = pVector[0] / length;
+        float y = pVector[1] / length;
+        if (pVector[2] < 0.0f)
+        {
+            float foldedX = (1.0f - fabsf(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+            float foldedY = (1.0f - fabsf(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+            x = foldedX;
+            y = foldedY;
+        }
+
+        pEncoded[0] = FloatToSnorm16(x);
+        pEncoded[1] = FloatToSnorm16(y);
+    }
+
+    static void DecodeOctahedral(const int16_t* pEncoded, float* pVector)
+    {
+        float x = Snorm16ToFloat(pEncoded[0]);
+        float y = Snorm16ToFloat(pEncoded[1]);
+        float z = 1.0f - fabsf(x) - fabsf(y);
+        if (z < 0.0f)
+        {
+            float unfoldedX = (1.0f - fabsf(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+            float unfoldedY = (1.0f - fabsf(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+            x = unfoldedX;
+            y = unfoldedY;
+        }
+
+        float invLength = 1.0f / sqrtf(x * x + y * y + z * z);
+        pVector[0] = x * invLength;
+        pVector[1] = y * invLength;
+        pVector[2] = z * invLength;
+    }
+
+    // Finds the floats of a vertex in the float layout that aren't part of a
+    // packed attribute, which are copied unchanged after the packed attributes
+    static void GetUnpackedSlots(const SubMesh* pMesh, std::vector<int32_t>& slots)
+    {
+        std::vector<bool> packed(pMesh->m_vertSize, false);
+        struct Attrib { int32_t m_offset; int32_t m_size; };
+        const Attrib attribs[] = {
+            { 0, sPositionFloats },
+            { pMesh->m_normalOffset, sNormalFloats },
+            { pMesh->m_texCoordOffset, sTexCoordFloats },
+            { pMesh->m_tangentOffset, sTangentFloats } };
+        for (uint32_t i = 0; i < sizeof(attribs) / sizeof(attribs[0]); ++i)
+        {
+            if ((0 == i) || (attribs[i].m_offset > 0))
+            {
+                for (int32_t j = 0; j < attribs[i].m_size; ++j)
+                {
+                    packed[attribs[i].m_offset + j] = true;
+                }
+            }
+        }
+
+        slots.clear();
+        for (int32_t i = 0; i < pMesh->m_vertSize; ++i)
+        {
+            if (!packed[i])
+            {
+                slots.push_back(i);
+            }
+        }
+    }
+
+    // Returns the packed offset of an attribute that is copied unchanged
+    static int32_t GetUnpackedAttribOffset(int32_t floatOffset, const std::vector<int32_t>& slots, int32_t slotsOffset)
+    {
+        if (floatOffset <= 0)
+        {
+            return -1;
+        }
+        for (uint32_t i = 0; i < slots.size(); ++i)
+        {
+            if (slots[i] == floatOffset)
+            {
+                return slotsOffset + i * sizeof(float);
+            }
+        }
+        return -1;
+    }
+
+    void VertexPacker::Pack(const SubMesh* pMesh, PackedVertexLayout& layout,
+        std::vector<uint8_t>& vertices, std::vector<uint8_t>& indices)
+    {
+        uint32_t vertexCount = pMesh->m_vertexCount;
+        int32_t vertSize = pMesh->m_vertSize;
+        const float* pSrc = pMesh->m_vertices;
+
+        // Build the packed layout, with the packed attributes first
+        layout = PackedVertexLayout();
+        layout.m_positionFormat = VERTEX_FORMAT_UNORM16;
+        layout.m_positionOffset = 0;
+        int32_t packedSize = sPackedPositionSize;
+        if (pMesh->m_normalOffset > 0)
+        {
+            layout.m_normalFormat = VERTEX_FORMAT_OCTAHEDRAL16;
+            layout.m_normalOffset = packedSize;
+            packedSize += sPackedUnitVectorSize;
+        }
+        if (pMesh->m_texCoordOffset > 0)
+        {
+            layout.m_texCoordFormat = VERTEX_FORMAT_HALF;
+            layout.m_texCoordOffset = packedSize;
+            packedSize += sPackedTexCoordSize;
+        }
+        if (pMesh->m_tangentOffset > 0)
+        {
+            layout.m_tangentFormat = VERTEX_FORMAT_OCTAHEDRAL16;
+            layout.m_tangentOffset = packedSize;
+            packedSize += sPackedUnitVectorSize;
+        }
+
+        std::vector<int32_t> slots;
+        GetUnpackedSlots(pMesh, slots);
+        int32_t slotsOffset = packedSize;
+        layout.m_colorOffset = GetUnpackedAttribOffset(pMesh->m_colorOffset, slots, slotsOffset);
+        layout.m_boneIndexOffset = GetUnpackedAttribOffset(pMesh->m_boneIndexOffset, slots, slotsOffset);
+        layout.m_boneWeightOffset = GetUnpackedAttribOffset(pMesh->m_boneWeightOffset, slots, slotsOffset);
+        layout.m_vertexSize = packedSize + int32_t(slots.size() * sizeof(float));
+
+        // Quantize positions relative to the bounds of the submesh
+        nv::vec3f minPos(0.0f, 0.0f, 0.0f);
+        nv::vec3f maxPos(0.0f, 0.0f, 0.0f);
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            nv::vec3f pos(pSrc + v * vertSize);
+            minPos = (0 == v) ? pos : nv::min(minPos, pos);
+            maxPos = (0 == v) ? pos : nv::max(maxPos, pos);
+        }
+        layout.m_positionBias = minPos;
+        layout.m_positionScale = maxPos - minPos;
+
+        vertices.assign(vertexCount * layout.m_vertexSize, 0);
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            const float* pVert = pSrc + v * vertSize;
+            uint8_t* pDest = &vertices[v * layout.m_vertexSize];
+
+            uint16_t position[4] = { 0, 0, 0, 0 };
+            for (int32_t c = 0; c < sPositionFloats; ++c)
+            {
+                float extent = layout.m_positionScale[c];
+                float t = (extent > 0.0f) ? ((pVert[c] - layout.m_positionBias[c]) / extent) : 0.0f;
+                t = (t < 0.0f) ? 0.0f : ((t > 1.0f) ? 1.0f : t);
+                position[c] = uint16_t(floorf(t * 65535.0f + 0.5f));
+            }
+            memcpy(pDest + layout.m_positionOffset, position, sPackedPositionSize);
+
+            if (layout.m_normalOffset >= 0)
+            {
+                int16_t normal[2];
+                EncodeOctahedral(pVert + pMesh->m_normalOffset, normal);
+                memcpy(pDest + layout.m_normalOffset, normal, sPackedUnitVectorSize);
+            }
+            if (layout.m_texCoordOffset >= 0)
+            {
+                uint16_t texCoord[2];
+                texCoord[0] = FloatToHalf(pVert[pMesh->m_texCoordOffset]);
+                texCoord[1] = FloatToHalf(pVert[pMesh->m_texCoordOffset + 1]);
+                memcpy(pDest + layout.m_texCoordOffset, texCoord, sPackedTexCoordSize);
+            }
+            if (layout.m_tangentOffset >= 0)
+            {
+                int16_t tangent[2];
+                EncodeOctahedral(pVert + pMesh->m_tangentOffset, tangent);
+                memcpy(pDest + layout.m_tangentOffset, tangent, sPackedUnitVectorSize);
+            }
+            for (uint32_t i = 0; i < slots.size(); ++i)
+            {
+                memcpy(pDest + slotsOffset + i * sizeof(float), pVert + slots[i], sizeof(float));
+            }
+        }
+
+        // Indices are padded to a multiple of 4 bytes to keep whatever follows aligned
+        uint32_t indexCount = pMesh->m_indexCount;
+        layout.m_indexSize = (vertexCount <= 0x10000) ? sizeof(uint16_t) : sizeof(uint32_t);
+        indices.assign(((indexCount * layout.m_indexSize) + 3) & ~3, 0);
+        if (sizeof(uint16_t) == layout.m_indexSize)
+        {
+            uint16_t* pDestIndices = reinterpret_cast<uint16_t*>(indices.empty() ? NULL : &indices[0]);
+            for (uint32_t i = 0; i < indexCount; ++i)
+            {
+                pDestIndices[i] = uint16_t(pMesh->m_indices[i]);
+            }
+        }
+        else if (indexCount > 0)
+        {
+            memcpy(&indices[0], pMesh->m_indices, indexCount * sizeof(uint32_t));
+        }
+    }
+
+    void VertexPacker::UnpackVertices(const SubMesh* pMesh, const PackedVertexLayout& layout,
+        const uint8_t* pPacked, uint32_t vertexCount, float* pVertices)
+    {
+        int32_t vertSize = pMesh->m_vertSize;
+        std::vector<int32_t> slots;
+        GetUnpackedSlots(pMesh, slots);
+        int32_t slotsOffset = layout.m_vertexSize - int32_t(slots.size() * sizeof(float));
+
+        nv::vec3f positionScale = layout.m_positionScale * (1.0f / 65535.0f);
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            const uint8_t* pSrc = pPacked + v * layout.m_vertexSize;
+            float* pVert = pVertices + v * vertSize;
+
+            uint16_t position[4];
+            memcpy(position, pSrc + layout.m_positionOffset, sPackedPositionSize);
+            for (int32_t c = 0; c < sPositionFloats; ++c)
+            {
+                pVert[c] = layout.m_positionBias[c] + float(position[c]) * positionScale[c];
+            }
+
+            if ((pMesh->m_normalOffset > 0) && (layout.m_normalOffset >= 0))
+            {
+                int16_t normal[2];
+                memcpy(normal, pSrc + layout.m_normalOffset, sPackedUnitVectorSize);
+                DecodeOctahedral(normal, pVert + pMesh->m_normalOffset);
+            }
+            if ((pMesh->m_texCoordOffset > 0) && (layout.m_texCoordOffset >= 0))
+            {
+                uint16_t texCoord[2];
+                memcpy(texCoord, pSrc + layout.m_texCoordOffset, sPackedTexCoordSize);
+                pVert[pMesh->m_texCoordOffset] = HalfToFloat(texCoord[0]);
+                pVert[pMesh->m_texCoordOffset + 1] = HalfToFloat(texCoord[1]);
+            }
+            if ((pMesh->m_tangentOffset > 0) && (layout.m_tangentOffset >= 0))
+            {
+                int16_t tangent[2];
+                memcpy(tangent, pSrc + layout.m_tangentOffset, sPackedUnitVectorSize);
+                DecodeOctahedral(tangent, pVert + pMesh->m_tangentOffset);
+            }
+            for (uint32_t i = 0; i < slots.size(); ++i)
+            {
+                memcpy(pVert + slots[i], pSrc + slotsOffset + i * sizeof(float), sizeof(float));
+            }
+        }
+    }
+
+    // True if an attribute of the given size at the given offset lies within a
+    // vertex; a negative offset means the attribute is absent
+    static bool IsAttribInVertex(int32_t offset, int32_t size, int32_t vertSize)
+    {
+        return (offset < 0) || (int64_t(offset) + size <= vertSize);
+    }
+
+    bool VertexPacker::IsLayoutValid(const SubMesh* pMesh, const PackedVertexLayout& layout)
+    {
+        if ((sizeof(uint16_t) != layout.m_indexSize) && (sizeof(uint32_t) != layout.m_indexSize))
+        {
+            return false;
+        }
+
+        // The float attributes that are decoded, offset 0 meaning absent as in GetUnpackedSlots()
+        int32_t vertSize = pMesh->m_vertSize;
+        if ((vertSize < sPositionFloats) ||
+            !IsAttribInVertex(pMesh->m_normalOffset, sNormalFloats, vertSize) ||
+            !IsAttribInVertex(pMesh->m_texCoordOffset, sTexCoordFloats, vertSize) ||
+            !IsAttribInVertex(pMesh->m_tangentOffset, sTangentFloats, vertSize))
+        {
+            return false;
+        }
+
+        // Their packed forms, and the floats copied unchanged at the end of the vertex,
+        // which also bound the size of a float vertex before the slots are counted
+        int32_t maxPackedFloats = sPositionFloats + sNormalFloats + sTexCoordFloats + sTangentFloats;
+        if (vertSize - maxPackedFloats > int32_t(layout.m_vertexSize / sizeof(float)))
+        {
+            return false;
+        }
+        std::vector<int32_t> slots;
+        GetUnpackedSlots(pMesh, slots);
+        return (layout.m_positionOffset >= 0) &&
+            IsAttribInVertex(layout.m_positionOffset, sPackedPositionSize, layout.m_vertexSize) &&
+            IsAttribInVertex(layout.m_normalOffset, sPackedUnitVectorSize, layout.m_vertexSize) &&
+            IsAttribInVertex(layout.m_texCoordOffset, sPackedTexCoordSize, layout.m_vertexSize) &&
+            IsAttribInVertex(layout.m_tangentOffset, sPackedUnitVectorSize, layout.m_vertexSize) &&
+            (int64_t(slots.size() * sizeof(float)) <= layout.m_vertexSize);
+    }
+
+    void VertexPacker::UnpackIndices(const uint8_t* pPacked, uint32_t indexSize, uint32_t indexCount, uint32_t* pIndices)
+    {
+        if (sizeof(uint16_t) == indexSize)
+        {
+            const uint16_t* pSrc = reinterpret_cast<const uint16_t*>(pPacked);
+            for (uint32_t i = 0; i < indexCount; ++i)
+            {
+                pIndices[i] = pSrc[i];
+            }
+        }
+        else
+        {
+            NV_ASSERT(sizeof(uint32_t) == indexSize);
+            memcpy(pIndices, pPacked, indexCount * sizeof(uint32_t));
+        }
+    }
+
+    // Angle, in degrees, between two vectors
+    static float AngleBetween(const float* pA, const float* pB)
+    {
+        nv::vec3f a(pA);
+        nv::vec3f b(pB);
+        float lengths = nv::length(a) * nv::length(b);
+        if (0.0f == lengths)
+        {
+            return 0.0f;
+        }
+        float cosAngle = nv::dot(a, b) / lengths;
+        cosAngle = (cosAngle > 1.0f) ? 1.0f : ((cosAngle < -1.0f) ? -1.0f : cosAngle);
+        return acosf(cosAngle) * (180.0f / 3.14159265f);
+    }
+
+    VertexPackingReport VertexPacker::ComputeReport(const SubMesh* pMesh, const PackedVertexLayout& layout,
+        const std::vector<uint8_t>& packedVertices, const std::vector<uint8_t>& packedIndices)
+    {
+        VertexPackingReport report;
+        if ((NULL == pMesh->m_vertices) || (0 == pMesh->m_vertexCount) || packedVertices.empty())
+        {
+            return report;
+        }
+
+        uint32_t floatCount = pMesh->m_vertexCount * pMesh->m_vertSize;
+        report.m_floatBytes = (floatCount + pMesh->m_indexCount) * sizeof(float);
+        report.m_packedBytes = uint32_t(packedVertices.size() + packedIndices.size());
+
+        std::vector<float> decoded(floatCount);
+        UnpackVertices(pMesh, layout, &packedVertices[0], pMesh->m_vertexCount, &decoded[0]);
+        for (uint32_t v = 0; v < pMesh->m_vertexCount; ++v)
+        {
+            const float* pOriginal = pMesh->m_vertices + v * pMesh->m_vertSize;
+            const float* pDecoded = &decoded[v * pMesh->m_vertSize];
+
+            float positionError = nv::length(nv::vec3f(pOriginal) - nv::vec3f(pDecoded));
+            report.m_maxPositionError = std::max(report.m_maxPositionError, positionError);
+            if (pMesh->m_normalOffset > 0)
+            {
+                float normalError = AngleBetween(pOriginal + pMesh->m_normalOffset, pDecoded + pMesh->m_normalOffset);
+                report.m_maxNormalError = std::max(report.m_maxNormalError, normalError);
+            }
+            if (pMesh->m_texCoordOffset > 0)
+            {
+                for (int32_t c = 0; c < sTexCoordFloats; ++c)
+                {
+                    float texCoordError = fabsf(pOriginal[pMesh->m_texCoordOffset + c] - pDecoded[pMesh->m_texCoordOffset + c]);
+                    report.m_maxTexCoordError = std::max(report.m_maxTexCoordError, texCoordError);
+                }
+            }
+            if (pMesh->m_tangentOffset > 0)
+            {
+                float tangentError = AngleBetween(pOriginal + pMesh->m_tangentOffset, pDecoded + pMesh->m_tangentOffset);
+                report.m_maxTangentError = std::max(report.m_maxTangentError, tangentError);
+            }
+        }
+        return report;
+    }
+}
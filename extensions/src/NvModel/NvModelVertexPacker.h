@@ -0,0 +1,112 @@
+//----------------------------------------------------------------------------------
+// File:        NvModel/NvModelVertexPacker.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef _NVMODELVERTEXPACKER_H_
+#define _NVMODELVERTEXPACKER_H_
+#pragma once
+
+#include <NvSimpleTypes.h>
+#include <NvModel/NvModelSubMesh.h>
+#include <vector>
+
+namespace Nv
+{
+    // Size and precision of a submesh's packed vertices, compared to its float vertices
+    struct VertexPackingReport
+    {
+        VertexPackingReport()
+            : m_floatBytes(0), m_packedBytes(0)
+            , m_maxPositionError(0.0f), m_maxNormalError(0.0f)
+            , m_maxTexCoordError(0.0f), m_maxTangentError(0.0f) {}
+
+        uint32_t m_floatBytes;      // Size of the float vertices and 32-bit indices
+        uint32_t m_packedBytes;     // Size of the packed vertices and indices
+        float m_maxPositionError;   // Largest distance between a position and its decoded value
+        float m_maxNormalError;     // Largest angle, in degrees, between a normal and its decoded value
+        float m_maxTexCoordError;   // Largest difference between a texture coordinate component and its decoded value
+        float m_maxTangentError;    // Largest angle, in degrees, between a tangent and its decoded value
+    };
+
+    // Converts submesh vertices between the float layout used by SubMesh::getVertices()
+    // and the packed layout described by PackedVertexLayout.  Positions are packed as
+    // UNORM16 relative to the submesh bounds, normals and tangents in 16-bit octahedral
+    // encoding and texture coordinates as half floats.  Any other floats in the vertex
+    // are copied unchanged after the packed attributes.  Indices are packed to 16 bits
+    // when every vertex can be addressed with them.
+    class VertexPacker
+    {
+    public:
+        /// Packs the float vertices and indices of a submesh
+        /// \param[in] pMesh Submesh whose float vertices and indices are to be packed
+        /// \param[out] layout Receives the layout of the packed vertices
+        /// \param[out] vertices Receives the packed vertices
+        /// \param[out] indices Receives the packed indices
+        static void Pack(const SubMesh* pMesh, PackedVertexLayout& layout,
+            std::vector<uint8_t>& vertices, std::vector<uint8_t>& indices);
+
+        /// Decodes packed vertices into the float layout of a submesh
+        /// \param[in] pMesh Submesh whose float layout (m_vertSize and the float
+        ///            attrib offsets) describes the vertices to produce
+        /// \param[in] layout Layout of the packed vertices
+        /// \param[in] pPacked Array of vertexCount packed vertices
+        /// \param[in] vertexCount Number of vertices to decode
+        /// \param[out] pVertices Array of vertexCount * pMesh->m_vertSize floats
+        static void UnpackVertices(const SubMesh* pMesh, const PackedVertexLayout& layout,
+            const uint8_t* pPacked, uint32_t vertexCount, float* pVertices);
+
+        /// Checks that a packed layout read from a file can be decoded safely
+        /// \param[in] pMesh Submesh whose float layout the packed vertices decode to
+        /// \param[in] layout Layout of the packed vertices
+        /// \return True if every attribute that UnpackVertices() reads or writes lies
+        ///         within a packed or float vertex, and the index size is 2 or 4
+        static bool IsLayoutValid(const SubMesh* pMesh, const PackedVertexLayout& layout);
+
+        /// Widens packed indices to 32 bits
+        /// \param[in] pPacked Array of indexCount packed indices
+        /// \param[in] indexSize Size of each packed index, in bytes
+        /// \param[in] indexCount Number of indices to widen
+        /// \param[out] pIndices Array of indexCount indices
+        static void UnpackIndices(const uint8_t* pPacked, uint32_t indexSize, uint32_t indexCount, uint32_t* pIndices);
+
+        /// Measures how much smaller and less precise the packed form of a submesh is
+        /// \param[in] pMesh Submesh with float vertices and indices
+        /// \param[in] layout Layout of the packed vertices, as returned by Pack()
+        /// \param[in] vertices Packed vertices, as returned by Pack()
+        /// \param[in] indices Packed indices, as returned by Pack()
+        /// \return The size and precision of the packed submesh
+        static VertexPackingReport ComputeReport(const SubMesh* pMesh, const PackedVertexLayout& layout,
+            const std::vector<uint8_t>& vertices, const std::vector<uint8_t>& indices);
+    };
+}
+
+#endif
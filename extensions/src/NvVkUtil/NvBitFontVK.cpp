@@ -574,7 +574,7 @@ NvBFTextRenderVK::NvBFTextRenderVK() //: m_vbo(0)
 		return;
 	}
 
-	result = vkMapMemory(vk.device(), m_vbo.mem, 0, bufferSize, 0, (void**)&m_vboMapping);
+	result = vk.mapMemory(m_vbo, 0, bufferSize, (void**)&m_vboMapping);
 	if (result != VK_SUCCESS) {
 		m_vboMapping = NULL;
 	}
@@ -655,7 +655,7 @@ void NvBFTextRenderVK::UpdateText(int count, const BFVert* data, bool midrender)
 	memcpy(m_vboMapping, data, count * VERT_PER_QUAD * sizeof(NvBitFontVertex));
 	VkMappedMemoryRange range = { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
 	range.memory = m_vbo.mem;
-	range.offset = 0;
+	range.offset = m_vbo.memOffset;
 	range.size = count * VERT_PER_QUAD * sizeof(NvBitFontVertex);
 	vkFlushMappedMemoryRanges(NvUIVKctx().mVk->device(), 1, &range);
 }
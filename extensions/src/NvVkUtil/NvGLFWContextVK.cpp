@@ -98,7 +98,7 @@ bool NvGLFWContextVK::readFramebufferRGBX32(uint8_t *dest, int32_t& w, int32_t&
 		vkDeviceWaitIdle(device());
 
 		uint8_t* ptr = NULL;
-		result = vkMapMemory(device(), dstBuffer.mem, 0, size, 0, (void**)&ptr);
+		result = mapMemory(dstBuffer, 0, size, (void**)&ptr);
 
 		uint32_t rowSize = w * 4;
 		ptr += rowSize * (h - 1);
@@ -109,6 +109,9 @@ bool NvGLFWContextVK::readFramebufferRGBX32(uint8_t *dest, int32_t& w, int32_t&
 			ptr -= rowSize;
 		}
 
+		vkDestroyBuffer(device(), dstBuffer(), NULL);
+		freeMemory(dstBuffer);
+
 		return true;
 	}
 
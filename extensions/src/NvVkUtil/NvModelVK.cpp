@@ -35,6 +35,7 @@
 #include "NV/NvLogs.h"
 #include "NvVkUtil/NvModelVK.h"
 #include "NvModel/NvModel.h"
+#include "NvAssetLoader/NvAssetLoader.h"
 #include "../NvModel/NvModelObj.h"
 
 NvModelVK* NvModelVK::CreateFromObj(NvVkContext& vk, uint8_t* data, float scale, bool computeNormals, bool computeTangents) {
@@ -63,6 +64,30 @@ NvModelVK* NvModelVK::CreateFromPreprocessed(NvVkContext& vk, uint8_t* data) {
 	return modelVK;
 }
 
+static void ReleaseMappedModelData(uint8_t* data) {
+	NvAssetLoaderUnmap((char*)data);
+}
+
+NvModelVK* NvModelVK::CreateFromPreprocessedFile(NvVkContext& vk, const char* filename) {
+	int32_t length;
+	char* data = NvAssetLoaderMap(filename, length);
+	if (!data)
+		return NULL;
+
+	NvModel* model = NvModel::CreateFromPreprocessedInPlace((uint8_t*)data, (size_t)length, ReleaseMappedModelData);
+	if (!model) {
+		NvAssetLoaderUnmap(data);
+		return NULL;
+	}
+
+	NvModelVK* modelVK = new NvModelVK;
+	modelVK->model = model;
+	modelVK->computeCenter();
+	modelVK->initBuffers(vk);
+
+	return modelVK;
+}
+
 NvModelVK::NvModelVK()
 {
 	model = NULL;
@@ -33,6 +33,7 @@
 //----------------------------------------------------------------------------------
 #include "NvSampleAppVK.h"
 #include "NvAppWrapperContextVK.h"
+#include "NvVkUtil/NvGPUTimerVK.h"
 #include "NV/NvLogs.h"
 #include "NvAppBase/NvFramerateCounter.h"
 #include "NvAppBase/NvInputTransformer.h"
@@ -69,6 +70,10 @@ NvSampleAppVK::NvSampleAppVK() :
 
 NvSampleAppVK::~NvSampleAppVK()
 {
+	// The sample has released its resources by now, in shutdownRendering or its
+	// own destructor, so the memory they were sub-allocated from can go
+	if (mContext)
+		vk().shutdownMemoryAllocator();
 }
 
 bool NvSampleAppVK::platformInitRendering(void) {
@@ -261,6 +266,13 @@ bool NvSampleAppVK::initialize(const NvPlatformInfo& platform, int32_t width, in
 void NvSampleAppVK::platformLogTestResults(float frameRate, int32_t frames) {
 }
 
+bool NvSampleAppVK::platformGetGPUFrameTime(float& ms) {
+	// The context already times each frame's main command buffer
+	NvGPUTimerVK& timer = vk().getFrameTimer();
+	ms = timer.getScaledCycles();
+	return timer.getStartStopCycles() > 0;
+}
+
 
 static const int32_t uniqueTypeID = 0x20000002;
 
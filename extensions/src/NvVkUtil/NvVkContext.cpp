@@ -35,6 +35,7 @@
 #include "NvAssetLoader/NvAssetLoader.h"
 #include "NvImage/NvImage.h"
 #include "NvVkUtil/NvGPUTimerVK.h"
+#include "NvVkUtil/NvVkMemoryAllocator.h"
 
 #include "NV/NvLogs.h"
 #include <NvAssert.h>
@@ -219,7 +220,7 @@ size_t NvVkStagingBuffer::append(size_t sz, const void* data)
 		if (result != VK_SUCCESS)
 			return -1;
 
-		result = vkMapMemory(mVk->device(), mBuffer.mem, 0, mAllocated, 0, (void**)&mMapping);
+		result = mVk->mapMemory(mBuffer, 0, mAllocated, (void**)&mMapping);
 		if (result != VK_SUCCESS)
 			return -1;
 
@@ -236,9 +237,8 @@ size_t NvVkStagingBuffer::append(size_t sz, const void* data)
 void NvVkStagingBuffer::deinit()
 {
 	if (mAllocated){
-		vkUnmapMemory(mVk->device(), mBuffer.mem);
 		vkDestroyBuffer(mVk->device(), mBuffer(), NULL);
-		vkFreeMemory(mVk->device(), mBuffer.mem, NULL);
+		mVk->freeMemory(mBuffer);
 		mMapping = NULL;
 		mAllocated = 0;
 	}
@@ -276,10 +276,34 @@ void checkVkResult(const char* file, int32_t line, VkResult result)
 	}
 }
 
-VkResult NvVkContext::allocMemAndBindImage(NvVkImage& image, VkFlags memProps)
+NvVkMemoryAllocator& NvVkContext::memoryAllocator()
+{
+	if (!mMemoryAllocator) {
+		mMemorySource = new NvVkDeviceMemorySource(device());
+		mMemoryAllocator = new NvVkMemoryAllocator(*mMemorySource,
+			physicalDeviceMemoryProperties(), physicalDeviceLimits());
+	}
+	return *mMemoryAllocator;
+}
+
+void NvVkContext::shutdownMemoryAllocator()
+{
+	if (!mMemoryAllocator)
+		return;
+
+	// The GPU may still be reading memory that is about to be freed
+	vkDeviceWaitIdle(device());
+	mStaging.deinit();
+
+	delete mMemoryAllocator;
+	mMemoryAllocator = NULL;
+	delete mMemorySource;
+	mMemorySource = NULL;
+}
+
+VkResult NvVkContext::allocMemAndBindImage(NvVkImage& image, VkFlags memProps, VkImageTiling tiling)
 {
 	VkResult result;
-	VkPhysicalDeviceMemoryProperties& memoryProperties = physicalDeviceMemoryProperties();
 
 	VkMemoryRequirements  memReqs;
 	vkGetImageMemoryRequirements(device(), image(), &memReqs);
@@ -288,30 +312,18 @@ VkResult NvVkContext::allocMemAndBindImage(NvVkImage& image, VkFlags memProps)
 		return VK_SUCCESS;
 	}
 
-	// Find an available memory type that satisfies the requested properties.
-	uint32_t memoryTypeIndex;
-	for (memoryTypeIndex = 0; memoryTypeIndex < memoryProperties.memoryTypeCount; ++memoryTypeIndex) {
-		if ((memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & memProps) == memProps) {
-			break;
-		}
-	}
-	if (memoryTypeIndex >= memoryProperties.memoryTypeCount) {
-		return VK_ERROR_FORMAT_NOT_SUPPORTED;
-	}
+	NvVkMemoryAllocator::ResourceKind kind = (tiling == VK_IMAGE_TILING_OPTIMAL)
+		? NvVkMemoryAllocator::RESOURCE_OPTIMAL : NvVkMemoryAllocator::RESOURCE_LINEAR;
 
-	VkMemoryAllocateInfo memInfo = {
-		VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,             // sType
-		0,                                               // pNext
-		memReqs.size,                                    // allocationSize
-		memoryTypeIndex,                                 // memoryTypeIndex
-	};
-
-	result = vkAllocateMemory(device(), &memInfo, NULL, &image.mem);
+	result = memoryAllocator().allocate(memReqs, memProps, kind, image.allocation);
 	if (result != VK_SUCCESS) {
 		return result;
 	}
 
-	result = vkBindImageMemory(device(), image(), image.mem, 0);
+	image.mem = image.allocation->memory;
+	image.memOffset = image.allocation->offset;
+
+	result = vkBindImageMemory(device(), image(), image.mem, image.memOffset);
 	if (result != VK_SUCCESS) {
 		return result;
 	}
@@ -319,6 +331,15 @@ VkResult NvVkContext::allocMemAndBindImage(NvVkImage& image, VkFlags memProps)
 	return VK_SUCCESS;
 }
 
+void NvVkContext::freeMemory(NvVkImage& image)
+{
+	if (mMemoryAllocator)
+		mMemoryAllocator->free(image.allocation);
+	image.allocation = NULL;
+	image.mem = VK_NULL_HANDLE;
+	image.memOffset = 0;
+}
+
 VkResult NvVkContext::createImage(VkImageCreateInfo& info, NvVkImage& image, VkFlags memProps) {
 	VkResult result;
 
@@ -326,7 +347,7 @@ VkResult NvVkContext::createImage(VkImageCreateInfo& info, NvVkImage& image, VkF
 	if (result != VK_SUCCESS)
 		return result;
 
-	result = allocMemAndBindImage(image, memProps);
+	result = allocMemAndBindImage(image, memProps, info.tiling);
 	if (result != VK_SUCCESS)
 		return result;
 
@@ -437,7 +458,6 @@ VkFormat NvVkContext::pickOptimalFormat(uint32_t count, const VkFormat *formats,
 VkResult NvVkContext::allocMemAndBindBuffer(NvVkBuffer& buffer, VkFlags memProps)
 {
 	VkResult result;
-	VkPhysicalDeviceMemoryProperties& memoryProperties = physicalDeviceMemoryProperties();
 
 	VkMemoryRequirements  memReqs;
 	vkGetBufferMemoryRequirements(device(), buffer(), &memReqs);
@@ -446,30 +466,15 @@ VkResult NvVkContext::allocMemAndBindBuffer(NvVkBuffer& buffer, VkFlags memProps
 		return VK_SUCCESS;
 	}
 
-	// Find an available memory type that satisfies the requested properties.
-	uint32_t memoryTypeIndex;
-	for (memoryTypeIndex = 0; memoryTypeIndex < memoryProperties.memoryTypeCount; ++memoryTypeIndex) {
-		if ((memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & memProps) == memProps) {
-			break;
-		}
-	}
-	if (memoryTypeIndex >= memoryProperties.memoryTypeCount) {
-		return VK_ERROR_FORMAT_NOT_SUPPORTED;
-	}
-
-	VkMemoryAllocateInfo memInfo = {
-		VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,             // sType
-		0,                                               // pNext
-		memReqs.size,                                    // allocationSize
-		memoryTypeIndex,                                 // memoryTypeIndex
-	};
-
-	result = vkAllocateMemory(device(), &memInfo, NULL, &buffer.mem);
+	result = memoryAllocator().allocate(memReqs, memProps, NvVkMemoryAllocator::RESOURCE_LINEAR, buffer.allocation);
 	if (result != VK_SUCCESS) {
 		return result;
 	}
 
-	result = vkBindBufferMemory(device(), buffer(), buffer.mem, 0);
+	buffer.mem = buffer.allocation->memory;
+	buffer.memOffset = buffer.allocation->offset;
+
+	result = vkBindBufferMemory(device(), buffer(), buffer.mem, buffer.memOffset);
 	if (result != VK_SUCCESS) {
 		return result;
 	}
@@ -477,6 +482,26 @@ VkResult NvVkContext::allocMemAndBindBuffer(NvVkBuffer& buffer, VkFlags memProps
 	return VK_SUCCESS;
 }
 
+void NvVkContext::freeMemory(NvVkBuffer& buffer)
+{
+	if (mMemoryAllocator)
+		mMemoryAllocator->free(buffer.allocation);
+	buffer.allocation = NULL;
+	buffer.mem = VK_NULL_HANDLE;
+	buffer.memOffset = 0;
+}
+
+VkResult NvVkContext::mapMemory(NvVkBuffer& buffer, VkDeviceSize offset, VkDeviceSize size, void** data)
+{
+	NvVkAllocation* allocation = buffer.allocation;
+	if (!allocation || !allocation->mapped)
+		return VK_ERROR_MEMORY_MAP_FAILED;
+
+	NV_ASSERT(offset + size <= allocation->size);
+	*data = allocation->mapped + offset;
+	return VK_SUCCESS;
+}
+
 VkResult NvVkContext::fillBuffer(NvVkStagingBuffer* staging, NvVkBuffer& buffer, size_t offset, size_t size, const void* data)
 {
 	if (!staging) {
@@ -789,13 +814,11 @@ bool NvVkContext::uploadTexture(const NvImage* image, NvVkTexture& tex) {
 		return false;
 
 	void* destPtr = NULL;
-	result = vkMapMemory(device(), texBuffer.mem, 0, texBufferInfo.size, 0, &destPtr);
+	result = mapMemory(texBuffer, 0, texBufferInfo.size, &destPtr);
 	if (result != VK_SUCCESS)
 		return false;
 
 	memcpy(destPtr, image->getDataBlock(), texBufferInfo.size);
-
-	vkUnmapMemory(device(), texBuffer.mem);
 	
 	uint32_t regionCount = info.arrayLayers * info.mipLevels;
 	VkBufferImageCopy* texCopyRegions 
@@ -882,7 +905,7 @@ bool NvVkContext::uploadTexture(const NvImage* image, NvVkTexture& tex) {
 	vkWaitForFences(device(), 1, &copyFence, VK_TRUE, 100000000000);
 
 	vkDestroyBuffer(device(), texBuffer(), NULL);
-	vkFreeMemory(device(), texBuffer.mem, NULL);
+	freeMemory(texBuffer);
 
 	VkImageViewCreateInfo texViewCreateInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
 	texViewCreateInfo.image = tex.image();
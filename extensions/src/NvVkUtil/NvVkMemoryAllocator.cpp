@@ -0,0 +1,566 @@
+//----------------------------------------------------------------------------------
+// File:        NvVkUtil/NvVkMemoryAllocator.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvVkUtil/NvVkMemoryAllocator.h"
+
+#include <NsBitUtils.h>
+#include <NvAssert.h>
+
+#include <algorithm>
+#include <string.h>
+
+using nvidia::shdfnd::highestSetBit;
+using nvidia::shdfnd::lowestSetBit;
+
+// TLSF parameters.  Free ranges are indexed by the power of two of their size
+// (the first level) and by SL_COUNT linear steps within it (the second
+// level).  Sizes below SMALL_RANGE share first level zero in steps of
+// MIN_ALIGNMENT.
+enum {
+	ALIGNMENT_SHIFT = 4,
+	SL_BITS = 4,
+	SL_COUNT = 1 << SL_BITS,
+	FL_SHIFT = SL_BITS + ALIGNMENT_SHIFT,
+	FL_COUNT = 32
+};
+
+static const VkDeviceSize MIN_ALIGNMENT = VkDeviceSize(1) << ALIGNMENT_SHIFT;
+static const VkDeviceSize SMALL_RANGE = VkDeviceSize(1) << FL_SHIFT;
+static const VkDeviceSize MAX_POOLED_RANGE = VkDeviceSize(1) << (FL_SHIFT + FL_COUNT - 2);
+
+static inline VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static inline uint32_t highestSetBit64(VkDeviceSize value) {
+	uint32_t hi = uint32_t(value >> 32);
+	return hi ? 32 + highestSetBit(hi) : highestSetBit(uint32_t(value));
+}
+
+// Maps a size to the free list holding ranges of that size
+static inline void mapping(VkDeviceSize size, uint32_t& fl, uint32_t& sl) {
+	if (size < SMALL_RANGE) {
+		fl = 0;
+		sl = uint32_t(size >> ALIGNMENT_SHIFT);
+	} else {
+		uint32_t bit = highestSetBit64(size);
+		sl = uint32_t(size >> (bit - SL_BITS)) ^ SL_COUNT;
+		fl = bit - FL_SHIFT + 1;
+	}
+}
+
+// Maps a size to the first free list whose ranges are all at least that size
+static inline void mappingSearch(VkDeviceSize size, uint32_t& fl, uint32_t& sl) {
+	if (size >= SMALL_RANGE)
+		size += (VkDeviceSize(1) << (highestSetBit64(size) - SL_BITS)) - 1;
+	mapping(size, fl, sl);
+}
+
+struct NvVkMemoryAllocator::Range : public NvVkAllocation {
+	Block* block;
+	Range* prevPhys; ///< Neighbours in the block, in address order
+	Range* nextPhys;
+	Range* prevFree; ///< Neighbours in the free list, while free
+	Range* nextFree;
+	bool isFree;
+};
+
+struct NvVkMemoryAllocator::Block {
+	Pool* pool;
+	VkDeviceMemory memory;
+	VkDeviceSize size;
+	uint8_t* mapped;
+	Range* first; ///< Lowest-addressed range
+	uint32_t index; ///< Position in Pool::blocks or Pool::dedicated
+	bool dedicated;
+};
+
+struct NvVkMemoryAllocator::Pool {
+	Pool(uint32_t typeIndex, VkDeviceSize poolBlockSize, VkDeviceSize poolAlignment, bool hostVisible) :
+		memoryTypeIndex(typeIndex),
+		blockSize(poolBlockSize),
+		alignment(poolAlignment),
+		mapped(hostVisible),
+		flBitmap(0),
+		emptyBlock(NULL),
+		allocationCount(0),
+		deviceAllocations(0),
+		usedBytes(0),
+		dedicatedBytes(0) {
+		memset(slBitmap, 0, sizeof(slBitmap));
+		memset(freeLists, 0, sizeof(freeLists));
+	}
+
+	void insertFree(Range* range) {
+		uint32_t fl, sl;
+		mapping(range->size, fl, sl);
+		Range* head = freeLists[fl][sl];
+		range->prevFree = NULL;
+		range->nextFree = head;
+		if (head)
+			head->prevFree = range;
+		freeLists[fl][sl] = range;
+		flBitmap |= 1u << fl;
+		slBitmap[fl] |= 1u << sl;
+	}
+
+	void removeFree(Range* range) {
+		uint32_t fl, sl;
+		mapping(range->size, fl, sl);
+		if (range->prevFree)
+			range->prevFree->nextFree = range->nextFree;
+		else
+			freeLists[fl][sl] = range->nextFree;
+		if (range->nextFree)
+			range->nextFree->prevFree = range->prevFree;
+
+		if (!freeLists[fl][sl]) {
+			slBitmap[fl] &= ~(1u << sl);
+			if (!slBitmap[fl])
+				flBitmap &= ~(1u << fl);
+		}
+	}
+
+	// Returns the head of the first non-empty free list whose ranges are all
+	// at least size bytes, or NULL
+	Range* searchFree(VkDeviceSize size) const {
+		uint32_t fl, sl;
+		mappingSearch(size, fl, sl);
+		if (fl >= FL_COUNT)
+			return NULL;
+
+		uint32_t slMap = slBitmap[fl] & (~0u << sl);
+		if (!slMap) {
+			uint32_t flMap = (fl + 1 < FL_COUNT) ? (flBitmap & (~0u << (fl + 1))) : 0;
+			if (!flMap)
+				return NULL;
+			fl = lowestSetBit(flMap);
+			slMap = slBitmap[fl];
+		}
+		sl = lowestSetBit(slMap);
+		return freeLists[fl][sl];
+	}
+
+	// Finds a free range that can hold size bytes at the given alignment
+	Range* findFree(VkDeviceSize size, VkDeviceSize rangeAlignment) const {
+		Range* range = searchFree(size);
+		if (!range || rangeAlignment <= alignment ||
+			alignUp(range->offset, rangeAlignment) - range->offset + size <= range->size)
+			return range;
+
+		// The good fit is misaligned; fall back to a range that fits even
+		// with the worst-case padding
+		return searchFree(size + rangeAlignment - alignment);
+	}
+
+	uint32_t memoryTypeIndex;
+	VkDeviceSize blockSize;
+	VkDeviceSize alignment; ///< Minimum alignment and size granule of ranges
+	bool mapped; ///< Blocks are host-visible and kept mapped
+
+	uint32_t flBitmap;
+	uint32_t slBitmap[FL_COUNT];
+	Range* freeLists[FL_COUNT][SL_COUNT];
+
+	std::vector<Block*> blocks;
+	std::vector<Block*> dedicated;
+	Block* emptyBlock; ///< The one empty block kept for reuse, if any
+
+	uint32_t allocationCount;
+	uint32_t deviceAllocations;
+	VkDeviceSize usedBytes;
+	VkDeviceSize dedicatedBytes;
+};
+
+VkResult NvVkDeviceMemorySource::allocate(uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory& memory)
+{
+	VkMemoryAllocateInfo memInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+	memInfo.allocationSize = size;
+	memInfo.memoryTypeIndex = memoryTypeIndex;
+
+	return vkAllocateMemory(mDevice, &memInfo, NULL, &memory);
+}
+
+void NvVkDeviceMemorySource::free(VkDeviceMemory memory)
+{
+	vkFreeMemory(mDevice, memory, NULL);
+}
+
+VkResult NvVkDeviceMemorySource::map(VkDeviceMemory memory, VkDeviceSize size, void** data)
+{
+	return vkMapMemory(mDevice, memory, 0, size, 0, data);
+}
+
+NvVkMemoryAllocator::NvVkMemoryAllocator(NvVkMemorySource& source,
+	const VkPhysicalDeviceMemoryProperties& memoryProperties,
+	const VkPhysicalDeviceLimits& limits,
+	VkDeviceSize blockSize) :
+	mSource(source),
+	mMemoryProperties(memoryProperties),
+	mBlockSize(std::min(alignUp(blockSize, SMALL_RANGE), MAX_POOLED_RANGE)),
+	mNonCoherentAtomSize(std::max(limits.nonCoherentAtomSize, MIN_ALIGNMENT)),
+	mSeparateKinds(limits.bufferImageGranularity > MIN_ALIGNMENT),
+	mPools(memoryProperties.memoryTypeCount * RESOURCE_KIND_COUNT, (Pool*)NULL),
+	mSpareRanges(NULL)
+{
+}
+
+NvVkMemoryAllocator::~NvVkMemoryAllocator()
+{
+	for (size_t i = 0; i < mPools.size(); i++) {
+		Pool* pool = mPools[i];
+		if (!pool)
+			continue;
+
+		while (!pool->blocks.empty())
+			destroyBlock(*pool, pool->blocks.back());
+		while (!pool->dedicated.empty())
+			destroyBlock(*pool, pool->dedicated.back());
+		delete pool;
+	}
+
+	while (mSpareRanges) {
+		Range* range = mSpareRanges;
+		mSpareRanges = range->nextFree;
+		delete range;
+	}
+}
+
+VkResult NvVkMemoryAllocator::allocate(const VkMemoryRequirements& reqs, VkFlags memProps,
+	ResourceKind kind, NvVkAllocation*& allocation)
+{
+	allocation = NULL;
+
+	// Try each allowed memory type with the requested properties in order,
+	// moving on if one is out of memory
+	VkResult result = VK_ERROR_FORMAT_NOT_SUPPORTED;
+	for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; i++) {
+		if (!(reqs.memoryTypeBits & (1u << i)) ||
+			(mMemoryProperties.memoryTypes[i].propertyFlags & memProps) != memProps)
+			continue;
+
+		Range* range;
+		result = allocateFromType(i, reqs.size, reqs.alignment, kind, range);
+		if (result == VK_SUCCESS) {
+			allocation = range;
+			break;
+		}
+	}
+
+	return result;
+}
+
+VkResult NvVkMemoryAllocator::allocateFromType(uint32_t memoryTypeIndex, VkDeviceSize size,
+	VkDeviceSize alignment, ResourceKind kind, Range*& range)
+{
+	uint32_t poolIndex = memoryTypeIndex * RESOURCE_KIND_COUNT + (mSeparateKinds ? kind : RESOURCE_LINEAR);
+	Pool* pool = mPools[poolIndex];
+	if (!pool) {
+		VkFlags flags = mMemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+		const VkMemoryHeap& heap = mMemoryProperties.memoryHeaps[mMemoryProperties.memoryTypes[memoryTypeIndex].heapIndex];
+		bool hostVisible = (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+
+		// Keep non-coherent ranges on atom boundaries so that flushing one
+		// never touches its neighbours
+		VkDeviceSize poolAlignment = MIN_ALIGNMENT;
+		if (hostVisible && !(flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+			poolAlignment = mNonCoherentAtomSize;
+
+		VkDeviceSize blockSize = std::max(std::min(mBlockSize, heap.size / 8), SMALL_RANGE);
+		blockSize = alignUp(blockSize, poolAlignment);
+
+		pool = new Pool(memoryTypeIndex, blockSize, poolAlignment, hostVisible);
+		mPools[poolIndex] = pool;
+	}
+
+	alignment = std::max(alignment, pool->alignment);
+	size = alignUp(size, pool->alignment);
+
+	VkResult result;
+	Block* block;
+
+	// Requests that would take a large share of a block, and large images
+	// such as render targets, get memory of their own
+	if (size > pool->blockSize / 2 ||
+		(kind == RESOURCE_OPTIMAL && size >= pool->blockSize / 8)) {
+		result = createBlock(*pool, size, true, block);
+		if (result != VK_SUCCESS)
+			return result;
+
+		range = block->first;
+		range->isFree = false;
+		pool->dedicatedBytes += size;
+		return VK_SUCCESS;
+	}
+
+	range = pool->findFree(size, alignment);
+	if (range) {
+		pool->removeFree(range);
+	} else {
+		result = createBlock(*pool, pool->blockSize, false, block);
+		if (result != VK_SUCCESS)
+			return result;
+		range = block->first;
+	}
+
+	block = range->block;
+	if (block == pool->emptyBlock)
+		pool->emptyBlock = NULL;
+
+	// Split off the padding in front of the aligned start.  The neighbours of
+	// a free range are always in use, so the pieces need no merging.
+	VkDeviceSize pad = alignUp(range->offset, alignment) - range->offset;
+	NV_ASSERT(pad + size <= range->size);
+	if (pad) {
+		Range* front = newRange();
+		*static_cast<NvVkAllocation*>(front) = *range;
+		front->size = pad;
+		front->block = block;
+		front->prevPhys = range->prevPhys;
+		front->nextPhys = range;
+		front->isFree = true;
+		if (front->prevPhys)
+			front->prevPhys->nextPhys = front;
+		else
+			block->first = front;
+		range->prevPhys = front;
+		range->offset += pad;
+		range->size -= pad;
+		pool->insertFree(front);
+	}
+
+	if (range->size > size) {
+		Range* back = newRange();
+		*static_cast<NvVkAllocation*>(back) = *range;
+		back->offset = range->offset + size;
+		back->size = range->size - size;
+		back->block = block;
+		back->prevPhys = range;
+		back->nextPhys = range->nextPhys;
+		back->isFree = true;
+		if (back->nextPhys)
+			back->nextPhys->prevPhys = back;
+		range->nextPhys = back;
+		range->size = size;
+		pool->insertFree(back);
+	}
+
+	range->isFree = false;
+	range->mapped = block->mapped ? block->mapped + range->offset : NULL;
+	pool->allocationCount++;
+	pool->usedBytes += range->size;
+
+	return VK_SUCCESS;
+}
+
+void NvVkMemoryAllocator::free(NvVkAllocation* allocation)
+{
+	if (!allocation)
+		return;
+
+	Range* range = static_cast<Range*>(allocation);
+	Block* block = range->block;
+	Pool& pool = *block->pool;
+	NV_ASSERT(!range->isFree);
+
+	if (block->dedicated) {
+		pool.dedicatedBytes -= block->size;
+		destroyBlock(pool, block);
+		return;
+	}
+
+	pool.allocationCount--;
+	pool.usedBytes -= range->size;
+	range->isFree = true;
+
+	// Merge with free neighbours
+	Range* prev = range->prevPhys;
+	if (prev && prev->isFree) {
+		pool.removeFree(prev);
+		prev->size += range->size;
+		prev->nextPhys = range->nextPhys;
+		if (prev->nextPhys)
+			prev->nextPhys->prevPhys = prev;
+		deleteRange(range);
+		range = prev;
+	}
+
+	Range* next = range->nextPhys;
+	if (next && next->isFree) {
+		pool.removeFree(next);
+		range->size += next->size;
+		range->nextPhys = next->nextPhys;
+		if (range->nextPhys)
+			range->nextPhys->prevPhys = range;
+		deleteRange(next);
+	}
+
+	// Keep a single empty block around to absorb alloc/free churn
+	if (!range->prevPhys && !range->nextPhys) {
+		if (pool.emptyBlock) {
+			destroyBlock(pool, block);
+			return;
+		}
+		pool.emptyBlock = block;
+	}
+
+	pool.insertFree(range);
+}
+
+VkResult NvVkMemoryAllocator::createBlock(Pool& pool, VkDeviceSize size, bool dedicated, Block*& block)
+{
+	VkDeviceMemory memory;
+	VkResult result = mSource.allocate(pool.memoryTypeIndex, size, memory);
+	if (result != VK_SUCCESS)
+		return result;
+
+	void* mapped = NULL;
+	if (pool.mapped) {
+		result = mSource.map(memory, size, &mapped);
+		if (result != VK_SUCCESS) {
+			mSource.free(memory);
+			return result;
+		}
+	}
+
+	pool.deviceAllocations++;
+
+	std::vector<Block*>& list = dedicated ? pool.dedicated : pool.blocks;
+
+	block = new Block;
+	block->pool = &pool;
+	block->memory = memory;
+	block->size = size;
+	block->mapped = (uint8_t*)mapped;
+	block->index = (uint32_t)list.size();
+	block->dedicated = dedicated;
+	list.push_back(block);
+
+	Range* range = newRange();
+	range->memory = memory;
+	range->offset = 0;
+	range->size = size;
+	range->mapped = block->mapped;
+	range->memoryTypeIndex = pool.memoryTypeIndex;
+	range->block = block;
+	range->prevPhys = NULL;
+	range->nextPhys = NULL;
+	range->isFree = true;
+	block->first = range;
+
+	return VK_SUCCESS;
+}
+
+void NvVkMemoryAllocator::destroyBlock(Pool& pool, Block* block)
+{
+	Range* range = block->first;
+	while (range) {
+		Range* next = range->nextPhys;
+		deleteRange(range);
+		range = next;
+	}
+
+	mSource.free(block->memory);
+
+	std::vector<Block*>& list = block->dedicated ? pool.dedicated : pool.blocks;
+	list[block->index] = list.back();
+	list[block->index]->index = block->index;
+	list.pop_back();
+
+	if (pool.emptyBlock == block)
+		pool.emptyBlock = NULL;
+
+	delete block;
+}
+
+NvVkMemoryAllocator::Range* NvVkMemoryAllocator::newRange()
+{
+	Range* range = mSpareRanges;
+	if (range)
+		mSpareRanges = range->nextFree;
+	else
+		range = new Range;
+	return range;
+}
+
+void NvVkMemoryAllocator::deleteRange(Range* range)
+{
+	range->nextFree = mSpareRanges;
+	mSpareRanges = range;
+}
+
+void NvVkMemoryAllocator::addPoolStats(const Pool& pool, Stats& stats) const
+{
+	stats.blockCount += (uint32_t)pool.blocks.size();
+	stats.allocationCount += pool.allocationCount;
+	stats.dedicatedCount += (uint32_t)pool.dedicated.size();
+	stats.deviceAllocations += pool.deviceAllocations;
+	stats.usedBytes += pool.usedBytes;
+	stats.dedicatedBytes += pool.dedicatedBytes;
+
+	for (size_t i = 0; i < pool.blocks.size(); i++) {
+		const Block* block = pool.blocks[i];
+		VkDeviceSize freeBytes = 0;
+		VkDeviceSize largest = 0;
+		for (const Range* range = block->first; range; range = range->nextPhys) {
+			if (!range->isFree)
+				continue;
+			stats.freeRangeCount++;
+			freeBytes += range->size;
+			largest = std::max(largest, range->size);
+		}
+
+		stats.blockBytes += block->size;
+		stats.fragmentedBytes += freeBytes - largest;
+		stats.largestFreeRange = std::max(stats.largestFreeRange, largest);
+	}
+}
+
+void NvVkMemoryAllocator::getStats(Stats& stats) const
+{
+	memset(&stats, 0, sizeof(stats));
+	for (size_t i = 0; i < mPools.size(); i++) {
+		if (mPools[i])
+			addPoolStats(*mPools[i], stats);
+	}
+}
+
+void NvVkMemoryAllocator::getStats(uint32_t memoryTypeIndex, Stats& stats) const
+{
+	memset(&stats, 0, sizeof(stats));
+	for (uint32_t kind = 0; kind < RESOURCE_KIND_COUNT; kind++) {
+		const Pool* pool = mPools[memoryTypeIndex * RESOURCE_KIND_COUNT + kind];
+		if (pool)
+			addPoolStats(*pool, stats);
+	}
+}
@@ -0,0 +1,335 @@
+//----------------------------------------------------------------------------------
+// File:        NvVkUtil/NvVkMemoryAllocatorTest.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+// CPU-only test and benchmark of NvVkMemoryAllocator.
+//
+// The allocator is driven through a fake NvVkMemorySource over a synthetic
+// memory-type table shaped like a discrete NVIDIA GPU, so no device is needed.
+// A seeded random mix of buffer, staging and image requests is allocated and
+// freed, then every live allocation is checked for alignment, size, memory
+// type, mapping, overlap and bufferImageGranularity conflicts, and every
+// memory object must be returned to the source once the allocator is gone.
+//
+// Usage: NvVkMemoryAllocatorTest [operations] [live allocations] [granularity]
+// Returns 0 if all checks pass.  Besides the Visual Studio project, it builds
+// with, from the extensions directory:
+//   g++ -O2 -std=c++11 -DLINUX -DNDEBUG -Iinclude -Iinclude/NsFoundation
+//       -Iinclude/NvFoundation -Iinclude/NvVkUtil -Iinclude/NvVkUtil/nosdk
+//       src/NvVkUtil/NvVkMemoryAllocatorTest.cpp src/NvVkUtil/NvVkMemoryAllocator.cpp
+
+#include "NvVkUtil/NvVkMemoryAllocator.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// NvVkDeviceMemorySource is never used here, so the entry points it calls
+// only need to link
+extern "C" {
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateMemory(VkDevice, const VkMemoryAllocateInfo*,
+	const VkAllocationCallbacks*, VkDeviceMemory*) { return VK_ERROR_OUT_OF_DEVICE_MEMORY; }
+VKAPI_ATTR void VKAPI_CALL vkFreeMemory(VkDevice, VkDeviceMemory, const VkAllocationCallbacks*) {}
+VKAPI_ATTR VkResult VKAPI_CALL vkMapMemory(VkDevice, VkDeviceMemory, VkDeviceSize, VkDeviceSize,
+	VkMemoryMapFlags, void**) { return VK_ERROR_MEMORY_MAP_FAILED; }
+}
+
+// Memory objects are numbered from 1, and object n is "mapped" at n << 32 so
+// that mapped addresses can be checked against offsets
+static const uint64_t FAKE_MAPPING_STRIDE = 1ULL << 32;
+
+static uint64_t handleValue(VkDeviceMemory memory) {
+	return (uint64_t)(uintptr_t)memory;
+}
+
+class FakeMemorySource : public NvVkMemorySource {
+public:
+	FakeMemorySource(const VkPhysicalDeviceMemoryProperties& props) :
+		mProps(props), mNextHandle(1), mPeakLive(0)
+	{
+		for (uint32_t i = 0; i < VK_MAX_MEMORY_HEAPS; i++)
+			mHeapUsed[i] = 0;
+	}
+
+	virtual VkResult allocate(uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory& memory) {
+		uint32_t heap = mProps.memoryTypes[memoryTypeIndex].heapIndex;
+		if (mHeapUsed[heap] + size > mProps.memoryHeaps[heap].size)
+			return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+
+		mHeapUsed[heap] += size;
+		memory = (VkDeviceMemory)(uintptr_t)mNextHandle++;
+		Object& object = mObjects[handleValue(memory)];
+		object.size = size;
+		object.heap = heap;
+		mPeakLive = std::max(mPeakLive, mObjects.size());
+		return VK_SUCCESS;
+	}
+
+	virtual void free(VkDeviceMemory memory) {
+		std::map<uint64_t, Object>::iterator it = mObjects.find(handleValue(memory));
+		if (it == mObjects.end()) {
+			mBadFrees++;
+			return;
+		}
+		mHeapUsed[it->second.heap] -= it->second.size;
+		mObjects.erase(it);
+	}
+
+	virtual VkResult map(VkDeviceMemory memory, VkDeviceSize, void** data) {
+		*data = (void*)(uintptr_t)(FAKE_MAPPING_STRIDE * handleValue(memory));
+		return VK_SUCCESS;
+	}
+
+	struct Object {
+		VkDeviceSize size;
+		uint32_t heap;
+	};
+
+	const VkPhysicalDeviceMemoryProperties& mProps;
+	std::map<uint64_t, Object> mObjects;
+	VkDeviceSize mHeapUsed[VK_MAX_MEMORY_HEAPS];
+	uint64_t mNextHandle;
+	size_t mPeakLive;
+	static uint32_t mBadFrees;
+};
+
+uint32_t FakeMemorySource::mBadFrees = 0;
+
+// A 4 GiB device-local heap and a 16 GiB system heap with the memory types
+// an NVIDIA driver reports
+static VkPhysicalDeviceMemoryProperties makeMemoryProperties() {
+	VkPhysicalDeviceMemoryProperties props;
+	memset(&props, 0, sizeof(props));
+	props.memoryHeapCount = 2;
+	props.memoryHeaps[0].size = 4ULL << 30;
+	props.memoryHeaps[0].flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+	props.memoryHeaps[1].size = 16ULL << 30;
+	props.memoryTypeCount = 4;
+	props.memoryTypes[0].heapIndex = 1;
+	props.memoryTypes[1].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	props.memoryTypes[1].heapIndex = 0;
+	props.memoryTypes[2].propertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	props.memoryTypes[2].heapIndex = 1;
+	props.memoryTypes[3].propertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+	props.memoryTypes[3].heapIndex = 1;
+	return props;
+}
+
+struct Request {
+	VkMemoryRequirements reqs;
+	VkFlags memProps;
+	NvVkMemoryAllocator::ResourceKind kind;
+	bool free;
+	uint32_t victim;
+};
+
+struct LiveAllocation {
+	NvVkAllocation* allocation;
+	VkMemoryRequirements reqs;
+	NvVkMemoryAllocator::ResourceKind kind;
+};
+
+struct PlacedRange {
+	VkDeviceSize begin;
+	VkDeviceSize end;
+	NvVkMemoryAllocator::ResourceKind kind;
+
+	bool operator<(const PlacedRange& other) const { return begin < other.begin; }
+};
+
+// Sizes spread evenly over orders of magnitude, rounded to 16 bytes
+static VkDeviceSize randomSize(std::mt19937_64& rng, double lo, double hi) {
+	std::uniform_real_distribution<double> dist(log(lo), log(hi));
+	return ((VkDeviceSize)exp(dist(rng)) + 15) & ~VkDeviceSize(15);
+}
+
+// A mix of device-local buffers, host-visible staging buffers and optimal
+// images; once liveTarget allocations are live, frees are as likely as allocations
+static std::vector<Request> makeRequests(uint32_t count, uint32_t liveTarget) {
+	std::mt19937_64 rng(1234);
+	std::vector<Request> requests(count);
+	uint32_t live = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		Request& r = requests[i];
+		memset(&r, 0, sizeof(r));
+		r.free = (live > 0) && (rng() % (live >= liveTarget ? 2 : 4) == 0);
+		if (r.free) {
+			r.victim = (uint32_t)(rng() % live);
+			live--;
+			continue;
+		}
+
+		uint32_t choice = rng() % 10;
+		if (choice < 6) {
+			r.reqs.size = randomSize(rng, 64, 1 << 20);
+			r.reqs.alignment = 256;
+			r.reqs.memoryTypeBits = 0xf;
+			r.memProps = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			r.kind = NvVkMemoryAllocator::RESOURCE_LINEAR;
+		} else if (choice < 8) {
+			r.reqs.size = randomSize(rng, 256, 256 << 10);
+			r.reqs.alignment = 64;
+			r.reqs.memoryTypeBits = 0xf;
+			r.memProps = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			r.kind = NvVkMemoryAllocator::RESOURCE_LINEAR;
+		} else {
+			r.reqs.size = randomSize(rng, 4096, 16 << 20);
+			r.reqs.alignment = (rng() % 2) ? 1024 : 65536;
+			r.reqs.memoryTypeBits = 0x2;
+			r.memProps = 0;
+			r.kind = NvVkMemoryAllocator::RESOURCE_OPTIMAL;
+		}
+		live++;
+	}
+	return requests;
+}
+
+// Checks every live allocation; returns the number of problems found
+static uint32_t verify(const std::vector<LiveAllocation>& live, const FakeMemorySource& source,
+	const VkPhysicalDeviceMemoryProperties& props, VkDeviceSize granularity) {
+	uint32_t errors = 0;
+	std::map<uint64_t, std::vector<PlacedRange> > byMemory;
+	for (size_t i = 0; i < live.size(); i++) {
+		const LiveAllocation& l = live[i];
+		const NvVkAllocation& a = *l.allocation;
+		if ((a.offset % l.reqs.alignment) != 0 || a.size < l.reqs.size ||
+			!(l.reqs.memoryTypeBits & (1u << a.memoryTypeIndex)))
+			errors++;
+
+		bool hostVisible = (props.memoryTypes[a.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+		uint64_t expectedMapping = hostVisible ? FAKE_MAPPING_STRIDE * handleValue(a.memory) + a.offset : 0;
+		if ((uint64_t)(uintptr_t)a.mapped != expectedMapping)
+			errors++;
+
+		PlacedRange range = { a.offset, a.offset + a.size, l.kind };
+		byMemory[handleValue(a.memory)].push_back(range);
+	}
+
+	std::map<uint64_t, std::vector<PlacedRange> >::iterator it;
+	for (it = byMemory.begin(); it != byMemory.end(); ++it) {
+		std::vector<PlacedRange>& ranges = it->second;
+		std::sort(ranges.begin(), ranges.end());
+		for (size_t i = 1; i < ranges.size(); i++) {
+			// no overlap, and linear and optimal resources never share a page
+			if (ranges[i].begin < ranges[i - 1].end)
+				errors++;
+			if (ranges[i].kind != ranges[i - 1].kind &&
+				ranges[i].begin / granularity == (ranges[i - 1].end - 1) / granularity)
+				errors++;
+		}
+
+		std::map<uint64_t, FakeMemorySource::Object>::const_iterator object = source.mObjects.find(it->first);
+		if (object == source.mObjects.end() || ranges.back().end > object->second.size)
+			errors++;
+	}
+	return errors;
+}
+
+int main(int argc, char** argv) {
+	uint32_t operations = (argc > 1) ? (uint32_t)atoi(argv[1]) : 200000;
+	uint32_t liveTarget = (argc > 2) ? (uint32_t)atoi(argv[2]) : 4000;
+	VkDeviceSize granularity = (argc > 3) ? (VkDeviceSize)atoll(argv[3]) : 1024;
+
+	VkPhysicalDeviceMemoryProperties props = makeMemoryProperties();
+	VkPhysicalDeviceLimits limits;
+	memset(&limits, 0, sizeof(limits));
+	limits.bufferImageGranularity = granularity;
+	limits.nonCoherentAtomSize = 64;
+
+	std::vector<Request> requests = makeRequests(operations, liveTarget);
+	FakeMemorySource source(props);
+	uint32_t errors = 0;
+	uint32_t failed = 0;
+	{
+		NvVkMemoryAllocator allocator(source, props, limits);
+		std::vector<LiveAllocation> live;
+		live.reserve(liveTarget * 2);
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < requests.size(); i++) {
+			const Request& r = requests[i];
+			if (r.free) {
+				if (live.empty())
+					continue;
+				size_t victim = r.victim % live.size();
+				allocator.free(live[victim].allocation);
+				live[victim] = live.back();
+				live.pop_back();
+			} else {
+				LiveAllocation l;
+				l.reqs = r.reqs;
+				l.kind = r.kind;
+				if (allocator.allocate(r.reqs, r.memProps, r.kind, l.allocation) != VK_SUCCESS) {
+					failed++;
+					continue;
+				}
+				live.push_back(l);
+			}
+		}
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+		errors += verify(live, source, props, granularity);
+
+		NvVkMemoryAllocator::Stats stats;
+		allocator.getStats(stats);
+		printf("%u operations, %.1f ns each; %u live allocations in %u blocks (%.1f MiB), %u dedicated\n",
+			operations, ns / operations, stats.allocationCount, stats.blockCount,
+			stats.blockBytes / 1048576.0, stats.dedicatedCount);
+		printf("fragmentation %.3f, %u memory objects allocated (peak %u live) for %u requests\n",
+			stats.fragmentation(), stats.deviceAllocations, (uint32_t)source.mPeakLive,
+			(uint32_t)(requests.size()));
+
+		if (stats.allocationCount + stats.dedicatedCount != live.size())
+			errors++;
+
+		for (size_t i = 0; i < live.size(); i++)
+			allocator.free(live[i].allocation);
+
+		// freeing everything leaves at most one empty block per pool
+		allocator.getStats(stats);
+		if (stats.allocationCount != 0 || stats.dedicatedCount != 0 || stats.usedBytes != 0)
+			errors++;
+	}
+
+	// destroying the allocator returns every memory object
+	if (!source.mObjects.empty() || FakeMemorySource::mBadFrees != 0)
+		errors++;
+
+	printf("%u failed allocations, %u errors: %s\n", failed, errors, errors ? "FAILED" : "passed");
+	return errors ? 1 : 0;
+}
@@ -225,15 +225,14 @@ bool NvVkMultibufferedRenderTarget::resize(int32_t& w, int32_t& h) {
 
 		while (!_memory.empty())
 		{
-			VkDeviceMemory mem = _memory.front();
-
-			vkFreeMemory(_vk.device(), mem, NULL);
+			_vk.freeMemory(_memory.front());
 
 			_memory.pop();
 		}
 
 		vkDestroyImage(vk().device(), _depthStencil(), NULL);
 		_depthStencil() = VK_NULL_HANDLE;
+		_vk.freeMemory(_depthStencil);
 
 		_frames.clear();
 		result = vkDeviceWaitIdle(vk().device());
@@ -383,7 +382,7 @@ bool NvVkMultibufferedRenderTarget::resize(int32_t& w, int32_t& h) {
 			CHECK_VK_RESULT();
 
 			frameImages[i] = image();
-			_memory.push(image.mem);
+			_memory.push(image);
 
 			_vk.transitionImageLayout(frameImages[i],
 				VK_IMAGE_ASPECT_COLOR_BIT,
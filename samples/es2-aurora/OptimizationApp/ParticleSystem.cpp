@@ -33,7 +33,7 @@
 //----------------------------------------------------------------------------------
 
 #include "ParticleSystem.h"
-#include "IceRevisitedRadix.h"
+#include <NsSort.h>
 #include "Perlin/ImprovedNoise.h"
 #include <algorithm>
 
@@ -89,9 +89,11 @@ private:
 
     vec4f *m_pos;
     float *m_zs;
+    uint32_t *m_sortIndices;
+    uint32_t *m_sortScratch;
     GLushort *m_sortedIndices16;
     int32_t m_count;
-    RadixSort m_sorter;
+    int32_t m_lastSortCount;
 
     int32_t m_numActive;
     ImprovedNoise m_noise;
@@ -101,7 +103,10 @@ private:
 ParticleInitializer::ParticleInitializer(): 
     m_pos(NULL), 
     m_zs(NULL),
+    m_sortIndices(NULL),
+    m_sortScratch(NULL),
     m_sortedIndices16(NULL),
+    m_lastSortCount(0),
     m_numActive(0), 
     m_width(480), 
     m_elapsedTime(0.0f) 
@@ -111,6 +116,8 @@ ParticleInitializer::ParticleInitializer():
 
     m_pos = new vec4f [m_count];
     m_zs = new float [m_count];
+    m_sortIndices = new uint32_t [m_count];
+    m_sortScratch = new uint32_t [m_count];
     m_sortedIndices16 = new GLushort [m_count];
 
     initGrid(GRID_RESOLUTION);
@@ -121,6 +128,8 @@ ParticleInitializer::~ParticleInitializer()
 {
     delete [] m_pos;
     delete [] m_zs;
+    delete [] m_sortIndices;
+    delete [] m_sortScratch;
     delete [] m_sortedIndices16;
 }
 
@@ -247,13 +256,15 @@ void ParticleInitializer::depthSortEfficient(const vec3f& halfVector)
         m_zs[i] = z;
     }
 
-    // sort
-    m_sorter.Sort(m_zs, getNumActive());
+    // sort, starting from last frame's order while the particle count is unchanged
+    const int32_t numActive = getNumActive();
+    nvidia::shdfnd::radixSortIndices(m_zs, (uint32_t)numActive, m_sortIndices, m_sortScratch,
+        numActive == m_lastSortCount);
+    m_lastSortCount = numActive;
 
-    const GLuint *sortedIndices32 = m_sorter.GetIndices();
-    for (int32_t i = 0; i < getNumActive(); ++i)
+    for (int32_t i = 0; i < numActive; ++i)
     {
-        m_sortedIndices16[i] = (GLushort) sortedIndices32[i];
+        m_sortedIndices16[i] = (GLushort) m_sortIndices[i];
     }
 }
 
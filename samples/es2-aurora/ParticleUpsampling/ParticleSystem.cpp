@@ -33,6 +33,7 @@
 //----------------------------------------------------------------------------------
 
 #include "ParticleSystem.h"
+#include <NsSort.h>
 
 inline float frand()
 {
@@ -51,12 +52,15 @@ inline nv::vec3f randVec()
 
 ParticleSystem::ParticleSystem()
 : m_numActive(0)
+, m_lastSortCount(0)
 {
     const int32_t N = GRID_RESOLUTION;
     m_count = N * N * N;
 
     m_pos = new nv::vec3f [m_count];
     m_zs = new float [m_count];
+    m_sortIndices = new uint32_t [m_count];
+    m_sortScratch = new uint32_t [m_count];
     m_sortedIndices16 = new GLushort [m_count];
 
     initGrid(N);
@@ -67,6 +71,8 @@ ParticleSystem::~ParticleSystem()
 {
     delete [] m_pos;
     delete [] m_zs;
+    delete [] m_sortIndices;
+    delete [] m_sortScratch;
     delete [] m_sortedIndices16;
 }
 
@@ -111,12 +117,13 @@ void ParticleSystem::depthSort(vec3f halfVector)
         m_zs[i] = z;
     }
 
-    // sort
-    m_sorter.Sort(m_zs, (udword)m_numActive);
+    // sort, starting from last frame's order while the particle count is unchanged
+    nvidia::shdfnd::radixSortIndices(m_zs, (uint32_t)m_numActive, m_sortIndices, m_sortScratch,
+        m_numActive == m_lastSortCount);
+    m_lastSortCount = m_numActive;
 
-    const GLuint *sortedIndices32 = (GLuint*)m_sorter.GetIndices();
     for (int32_t i = 0; i < m_numActive; ++i)
     {
-        m_sortedIndices16[i] = (GLushort) sortedIndices32[i];
+        m_sortedIndices16[i] = (GLushort) m_sortIndices[i];
     }
 }
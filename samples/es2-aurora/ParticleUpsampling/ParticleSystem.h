@@ -36,7 +36,6 @@
 #define PARTICLE_SYSTEM_H
 
 #include <NvSimpleTypes.h>
-#include "IceRevisitedRadix.h"
 #include "NV/NvMath.h"
 #include "NV/NvPlatformGL.h"
 #include "Perlin/ImprovedNoise.h"
@@ -88,13 +87,15 @@ public:
 private:
     vec3f *m_pos;
     float *m_zs;
+    uint32_t *m_sortIndices;
+    uint32_t *m_sortScratch;
     GLushort *m_sortedIndices16;
 
     int32_t m_count;
     int32_t m_numActive;
+    int32_t m_lastSortCount;
 
     ImprovedNoise m_noise;
-    RadixSort m_sorter;
 };
 
 #endif // PARTICLE_SYSTEM_H
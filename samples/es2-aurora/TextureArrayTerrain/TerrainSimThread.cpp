@@ -38,84 +38,59 @@
 
 using namespace nvidia::shdfnd;
 
-int32_t TerrainSimThread::g_runningThreads = 0;
-int32_t TerrainSimThread::g_livingThreads = 0;
-int32_t TerrainSimThread::g_threadsCounter = 0;
-Sync* TerrainSimThread::g_globalTerrainSimThreadCondition = NULL;
+JobSystem* TerrainSimThread::g_jobSystem = NULL;
+JobCounter TerrainSimThread::g_runningSimulations;
 NvStopWatch* TerrainSimThread::m_threadStopWatch;
 
 TerrainSimThread::TerrainSimThread(TerrainSim *sim)
-:m_simulation(sim), m_threadId(++TerrainSimThread::g_threadsCounter),
-    m_thread(threadThunk, this)
+:m_queued(0), m_startTime(0.0f), m_endTime(0.0f), m_simulation(sim)
 {
 
 }
 
-void TerrainSimThread::Init(NvStopWatch* stopWatch) {
-	g_globalTerrainSimThreadCondition = new Sync;
-	m_threadStopWatch = stopWatch;
+void TerrainSimThread::Init(NvStopWatch* stopWatch, JobSystem& jobSystem) {
+    m_threadStopWatch = stopWatch;
+    g_jobSystem = &jobSystem;
 }
 
 
 void TerrainSimThread::runSimulation()
 {
-    //LOGI("runSimulation %d\n", m_threadId);
-    m_localStartCondition.set();
+    // A simulation that is already running loops until the params stop changing,
+    // so it picks up this request too.  Queueing a second one could run both at once.
+    if (atomicCompareExchange(&m_queued, 1, 0) == 0)
+        g_jobSystem->run(simulationJob, this, g_runningSimulations);
 }
 
 void TerrainSimThread::waitForAllThreads()
 {
-    while(g_runningThreads>0)
-    {
-        g_globalTerrainSimThreadCondition->wait();
-        g_globalTerrainSimThreadCondition->reset();
-    }
+    if (g_jobSystem)
+        g_jobSystem->wait(g_runningSimulations);
 }
 
 void TerrainSimThread::waitForAllThreadsToExit()
 {
-    while(g_livingThreads>0)
+    if (g_jobSystem)
     {
-        g_globalTerrainSimThreadCondition->wait();
-        g_globalTerrainSimThreadCondition->reset();
+        g_jobSystem->wait(g_runningSimulations);
+        g_jobSystem = NULL;
     }
 }
 
-void TerrainSimThread::Run()
+void TerrainSimThread::simulationJob(void* thiz, uint32_t)
 {
-    atomicIncrement(&g_livingThreads);
-
-    while(!m_thread.quitIsSignalled())
-    {
-        //LOGI("TerrainSimThread::Run() %d entry\n", m_threadId);
-        atomicIncrement(&g_runningThreads); 
-        m_startTime = m_threadStopWatch->getTime();
+    TerrainSimThread* me = (TerrainSimThread*)thiz;
 
-        m_simulation->simulate();
+    me->m_startTime = m_threadStopWatch->getTime();
 
-        m_endTime = m_threadStopWatch->getTime();
-        //LOGI("Thread Run %d = [start, end] - Exec Time : [%f, %f] - %f\n", m_threadId, m_startTime, m_endTime, m_endTime - m_startTime);
+    me->m_simulation->simulate();
 
-        atomicDecrement(&g_runningThreads);
-        g_globalTerrainSimThreadCondition->set();
+    me->m_endTime = m_threadStopWatch->getTime();
+    //LOGI("Thread Run = [start, end] - Exec Time : [%f, %f] - %f\n", me->m_startTime, me->m_endTime, me->m_endTime - me->m_startTime);
 
-        if (!m_thread.quitIsSignalled()) {
-            m_localStartCondition.wait();
-            m_localStartCondition.reset();
-        }
-    }
-    
-    atomicDecrement(&g_livingThreads);
-    g_globalTerrainSimThreadCondition->set();
-}
-
-void* TerrainSimThread::threadThunk(void* thiz) 
-{
-    ((TerrainSimThread*)thiz)->Run();
-    return NULL;
+    atomicExchange(&me->m_queued, 0);
 }
 
 TerrainSimThread::~TerrainSimThread()
 {
-    atomicDecrement(&g_threadsCounter);
 }
@@ -36,15 +36,14 @@
 #define _TERRAIN_SIM_THREAD_
 
 #include <NvSimpleTypes.h>
-#include <NsThread.h>
-#include <NsSync.h>
+#include <NsJobSystem.h>
 
 #include "TerrainSim.h"
 #include "NV/NvLogs.h"
 
 class NvStopWatch;
 
-//The class to handle the threads for simulation
+//The class to handle the simulation jobs of a tile.  All of the tiles share one job system.
 class TerrainSimThread
 {
 
@@ -55,73 +54,60 @@ public:
     //dtor
     ~TerrainSimThread();
 
-    //implementing the run method called by the Start() method from r3::Thread class
-    void Run();
-
-    //get the Start Time of the Thread
+    //get the Start Time of the last simulation
     float getStartTime() const{ return m_startTime; }
 
-    //get the end time of the Thread
+    //get the end time of the last simulation
     float getEndTime() const{ return m_endTime; }
 
-    //get the execution time of the Thread
+    //get the execution time of the last simulation
     float getExecTime() const{ return m_endTime - m_startTime; }
 
-    //run a simulation on the respective thread
+    //queue a simulation, unless one is already queued or running for this tile
     void runSimulation();
 
-    //wait for ay threads still running the simulation
+    //wait for all of the queued simulations, helping with them meanwhile
     static void waitForAllThreads();
 
+    //wait for all of the queued simulations and stop using the job system
     static void waitForAllThreadsToExit();
 
+    //run the first simulation
     void start()
     {
-        m_thread.start();
+        runSimulation();
     }
 
-    //stop the thread
+    //nothing to stop; a queued simulation always runs to completion
     void stop()
     { 
-        m_thread.signalQuit();
-        runSimulation();
     }
     
-    //reset the thread counter
-    static void resetCounter(){ g_threadsCounter = 0; }
-
     static NvStopWatch& getThreadStopWatch() { return *m_threadStopWatch; }
 
-	static void Init(NvStopWatch* stopWatch);
+	//run the simulations on the app's job system
+	static void Init(NvStopWatch* stopWatch, nvidia::shdfnd::JobSystem& jobSystem);
 
 private:
-    static NvStopWatch* m_threadStopWatch;
+    //a simulation, run as a job
+    static void simulationJob(void* thiz, uint32_t threadIndex);
 
-    // a global threads counter
-    static int32_t g_threadsCounter;
-
-    //a global counter to specify the number of currently running threads
-    static int32_t g_runningThreads;
+    static NvStopWatch* m_threadStopWatch;
 
-    static int32_t g_livingThreads;
+    //the app's scheduler, shared by every tile
+    static nvidia::shdfnd::JobSystem* g_jobSystem;
 
-    //global Condition Variable for thread synchronization
-    static nvidia::shdfnd::Sync* g_globalTerrainSimThreadCondition;
+    //counts the simulations that have been queued and not yet finished
+    static nvidia::shdfnd::JobCounter g_runningSimulations;
 
-    //an ID for the thread
-    int32_t m_threadId;
+    //non-zero while a simulation of this tile is queued or running
+    volatile int32_t m_queued;
 
     //variables to store the start and the end times
     float m_startTime, m_endTime;
 
     //pointer to the simulation object
     TerrainSim *m_simulation;
-
-    //local condition variable to handle the running of the next loop (simulation)
-    nvidia::shdfnd::Sync m_localStartCondition;
-
-    static void* threadThunk(void* thiz);
-    nvidia::shdfnd::Thread m_thread;
 };
 
 
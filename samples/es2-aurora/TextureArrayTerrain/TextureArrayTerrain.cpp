@@ -378,9 +378,7 @@ void TextureArrayTerrain::updateBufferData()
 
 void TextureArrayTerrain::initTerrainSurfaces(int32_t w, int32_t h, int32_t numTiles)
 {
-    TerrainSimThread::resetCounter();
-
-	TerrainSimThread::Init(createStopWatch());
+	TerrainSimThread::Init(createStopWatch(), getJobSystem());
 
     m_ppTerrain = new TerrainGenerator*[numTiles];
 
@@ -533,7 +531,14 @@ GLuint NvImageLoadTextureArrayFromDDSData(const char* ddsFile[], int32_t count)
     int32_t error = glGetError();
 
     for (int32_t i = 0; i < count; i++) {
-        NvImage* image = NvImage::CreateFromDDSFile(ddsFile[i]);
+        // Only the top level is uploaded, so stream just that level rather than reading
+        // the whole mip chain of every layer into memory
+        NvImage* image = NvImage::CreateStreamingFromDDSFile(ddsFile[i], 0);
+
+        if (image && !image->streamLevel(0)) {
+            delete image;
+            image = NULL;
+        }
 
         if (image) {
             int32_t w = image->getWidth();
@@ -77,6 +77,7 @@ ComputeWaterSimulation::ComputeWaterSimulation()
 
 ComputeWaterSimulation::~ComputeWaterSimulation()
 {
+	WaveSimThread::Shutdown();
 	LOGI("ComputeWaterSimulation: destroyed\n");
 }
 
@@ -637,7 +638,7 @@ void ComputeWaterSimulation::initWaves(int numWaves)
 {
 	mWaveScale = (float)mGridSize / MAX_GRID_SIZE;
 
-	WaveSimThread::Init(createStopWatch());
+	WaveSimThread::Init(createStopWatch(), getJobSystem());
 
 	// TODO: fix delete
 	//WaveSimRenderer::m_renderersCount = 0;
@@ -93,7 +93,6 @@ void Wave::addRandomDisturbance(int radius, float height)
 void Wave::simulateAndCalcNormals(float timestep)
 {
 	m_simulation.simulate(timestep);
-	m_simulation.calcGradients();
 }
 
 void Wave::resetThreadStopWatch()
@@ -32,11 +32,99 @@
 //
 //----------------------------------------------------------------------------------
 #include "WaveSim.h"
+#include <NsTempAllocator.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define WAVESIM_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define WAVESIM_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Steps one row of the grid: the velocity update, the damping and the height
+// integration in a single sweep.  up, row and down are the current heights of
+// the row and its neighbours, v its current velocities; the new ones go to
+// rowOut and vOut.
+// The operations are done in the same order on every path so that the vector
+// and scalar results match exactly.
+static void stepRow(const float* up, const float* row, const float* down, const float* v,
+					float* vOut, float* rowOut, int width, float dt, float damping)
+{
+	int i = 1;
+#if WAVESIM_SSE2
+	const __m128 dt4 = _mm_set1_ps(dt);
+	const __m128 quarter4 = _mm_set1_ps(0.25f);
+	const __m128 damping4 = _mm_set1_ps(damping);
+	for(; i + 4 <= width - 1; i += 4)
+	{
+		const __m128 c = _mm_loadu_ps(row + i);
+		__m128 sum = _mm_add_ps(_mm_loadu_ps(row + i - 1), _mm_loadu_ps(row + i + 1));
+		sum = _mm_add_ps(_mm_add_ps(sum, _mm_loadu_ps(up + i)), _mm_loadu_ps(down + i));
+		__m128 vel = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(dt4, sum), quarter4), c);
+		vel = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(v + i), vel), damping4);
+		_mm_storeu_ps(vOut + i, vel);
+		_mm_storeu_ps(rowOut + i, _mm_add_ps(c, _mm_mul_ps(dt4, vel)));
+	}
+#elif WAVESIM_NEON
+	const float32x4_t dt4 = vdupq_n_f32(dt);
+	const float32x4_t quarter4 = vdupq_n_f32(0.25f);
+	const float32x4_t damping4 = vdupq_n_f32(damping);
+	for(; i + 4 <= width - 1; i += 4)
+	{
+		const float32x4_t c = vld1q_f32(row + i);
+		float32x4_t sum = vaddq_f32(vld1q_f32(row + i - 1), vld1q_f32(row + i + 1));
+		sum = vaddq_f32(vaddq_f32(sum, vld1q_f32(up + i)), vld1q_f32(down + i));
+		float32x4_t vel = vsubq_f32(vmulq_f32(vmulq_f32(dt4, sum), quarter4), c);
+		vel = vmulq_f32(vaddq_f32(vld1q_f32(v + i), vel), damping4);
+		vst1q_f32(vOut + i, vel);
+		vst1q_f32(rowOut + i, vaddq_f32(c, vmulq_f32(dt4, vel)));
+	}
+#endif
+	for(; i < width - 1; i++)
+	{
+		float vel = v[i] + (dt * (row[i-1] + row[i+1] + up[i] + down[i])*0.25f - row[i]);
+		vel *= damping;
+		vOut[i] = vel;
+		rowOut[i] = row[i] + dt*vel;
+	}
+
+	rowOut[0] = row[0];
+	rowOut[width-1] = row[width-1];
+}
+
+// Computes the gradients of one row from its heights and its neighbours'
+static void gradientRow(const float* up, const float* row, const float* down, float* gradients, int width)
+{
+	int i = 1;
+#if WAVESIM_SSE2
+	for(; i + 4 <= width - 1; i += 4)
+	{
+		const __m128 dx = _mm_sub_ps(_mm_loadu_ps(row + i + 1), _mm_loadu_ps(row + i - 1));
+		const __m128 dz = _mm_sub_ps(_mm_loadu_ps(down + i), _mm_loadu_ps(up + i));
+		_mm_storeu_ps(gradients + i*2, _mm_unpacklo_ps(dx, dz));
+		_mm_storeu_ps(gradients + i*2 + 4, _mm_unpackhi_ps(dx, dz));
+	}
+#elif WAVESIM_NEON
+	for(; i + 4 <= width - 1; i += 4)
+	{
+		float32x4x2_t d;
+		d.val[0] = vsubq_f32(vld1q_f32(row + i + 1), vld1q_f32(row + i - 1));
+		d.val[1] = vsubq_f32(vld1q_f32(down + i), vld1q_f32(up + i));
+		vst2q_f32(gradients + i*2, d);
+	}
+#endif
+	for(; i < width - 1; i++)
+	{
+		gradients[i*2] = row[i+1] - row[i-1];		//dy/dx
+		gradients[i*2+1] = down[i] - up[i];		//dy/dz
+	}
+}
 
 WaveSim::WaveSim(int w, int h, float damping) :
 	m_width(w),
 	m_height(h),
-    m_v(w, h),
     m_current(0),
     //m_c2(0.5f),
     //m_h2(1.0f),
@@ -44,6 +132,8 @@ WaveSim::WaveSim(int w, int h, float damping) :
 {
 	m_u[0].init(m_width,m_height);
 	m_u[1].init(m_width,m_height);
+	m_v[0].init(m_width,m_height);
+	m_v[1].init(m_width,m_height);
 	m_gradients = new float[m_width*m_height*2];
     reset();
 }
@@ -59,7 +149,8 @@ void WaveSim::reset()
     for(int i=0; i<size; i++) {
         m_u[0].data[i] = 0.0f;
         m_u[1].data[i] = 0.0f;
-        m_v.data[i] = 0.0f;
+        m_v[0].data[i] = 0.0f;
+        m_v[1].data[i] = 0.0f;
     }
 }
 
@@ -93,34 +184,82 @@ void WaveSim::addDisturbance(float x, float y, float r, float s)
 // http://www.matthiasmueller.info/talks/GDC2008.pdf
 void WaveSim::simulate(float dt)
 {
-    for(int j=1; j<m_height-1; j++) {
-        for(int i=1; i<m_width-1; i++) {
-            //m_v.get(i, j) += dt*m_c2*( m_u.getClamp(i-1, j) + m_u.getClamp(i+1, j) + m_u.getClamp(i, j-1) + m_u.getClamp(i, j+1) - 4.0f*m_u.get(i, j) ) / m_h2;
-            //m_v.get(i, j) += dt* (m_u.getClamp(i-1, j) + m_u.getClamp(i+1, j) + m_u.getClamp(i, j-1) + m_u.getClamp(i, j+1))*0.25f - m_u.get(i, j);
-            m_v.get(i, j) += dt * (m_u[m_current].get(i-1, j) + m_u[m_current].get(i+1, j) + m_u[m_current].get(i, j-1) + m_u[m_current].get(i, j+1))*0.25f - m_u[m_current].get(i, j);
-        }
-    }
-
-    //float damping = powf(m_damping, dt);
-    for(int j=1; j<m_height-1; j++) {
-        for(int i=1; i<m_width-1; i++) {
-            float &v = m_v.get(i, j);
-            v *= m_damping;
-            m_u[m_current].get(i, j) += dt*v;
-        }
-    }
+    simulateRows(dt, 1, m_height-1);
+    swapBuffers();
 }
 
-void WaveSim::calcGradients()
+void WaveSim::simulateRows(float dt, int rowBegin, int rowEnd)
 {
-	float *ptr;
-	for(int j=1; j<m_height-1; j++)
+	Array2D<float>& src = m_u[m_current];
+	Array2D<float>& dst = m_u[1 - m_current];
+	float** v = m_v[m_current].rowPointers;
+	float** vOut = m_v[1 - m_current].rowPointers;
+	const int w = m_width;
+
+	// The gradients of the first and last rows need the new heights of the
+	// rows around the band.  The border rows never change and are copied, the
+	// rows of other bands are stepped again into scratch rows, since they may
+	// be written concurrently.
+	float* scratch = NULL;
+	if(rowBegin > 1 || rowEnd < m_height-1)
+		scratch = (float*)nvidia::shdfnd::TempAllocator().allocate(sizeof(float)*w*4, __FILE__, __LINE__);
+
+	const float* above;
+	if(rowBegin == 1)
+	{
+		memcpy(dst.rowPointers[0], src.rowPointers[0], sizeof(float)*w);
+		above = dst.rowPointers[0];
+	}
+	else
 	{
-		ptr = m_gradients + j*m_width*2 + 2;
-		for(int i=1; i<m_width-1; i++)
-		{
-			*ptr++ = (m_u[m_current].get(i+1, j) - m_u[m_current].get(i-1, j));		//dy/dx
-			*ptr++ = (m_u[m_current].get(i, j+1) - m_u[m_current].get(i, j-1));		//dy/dz
-		}
+		int j = rowBegin-1;
+		stepRow(src.rowPointers[j-1], src.rowPointers[j], src.rowPointers[j+1], v[j],
+			scratch + w, scratch, w, dt, m_damping);
+		above = scratch;
+	}
+
+	const float* below;
+	if(rowEnd == m_height-1)
+	{
+		memcpy(dst.rowPointers[rowEnd], src.rowPointers[rowEnd], sizeof(float)*w);
+		below = dst.rowPointers[rowEnd];
+	}
+	else
+	{
+		int j = rowEnd;
+		stepRow(src.rowPointers[j-1], src.rowPointers[j], src.rowPointers[j+1], v[j],
+			scratch + w*3, scratch + w*2, w, dt, m_damping);
+		below = scratch + w*2;
+	}
+
+	// the gradients trail the stepped rows by one, so that both neighbours are ready
+	for(int j=rowBegin; j<rowEnd; j++) {
+		stepRow(src.rowPointers[j-1], src.rowPointers[j], src.rowPointers[j+1], v[j],
+			vOut[j], dst.rowPointers[j], w, dt, m_damping);
+		if(j > rowBegin)
+			gradientRow(j-2 < rowBegin ? above : dst.rowPointers[j-2], dst.rowPointers[j-1], dst.rowPointers[j],
+				m_gradients + (j-1)*w*2, w);
 	}
+	gradientRow(rowEnd-2 < rowBegin ? above : dst.rowPointers[rowEnd-2], dst.rowPointers[rowEnd-1], below,
+		m_gradients + (rowEnd-1)*w*2, w);
+
+	if(scratch)
+		nvidia::shdfnd::TempAllocator().deallocate(scratch);
+}
+
+void WaveSim::swapBuffers()
+{
+	m_current = 1 - m_current;
+}
+
+void WaveSim::calcGradients()
+{
+	calcGradients(1, m_height-1);
+}
+
+void WaveSim::calcGradients(int rowBegin, int rowEnd)
+{
+	float **rows = m_u[m_current].rowPointers;
+	for(int j=rowBegin; j<rowEnd; j++)
+		gradientRow(rows[j-1], rows[j], rows[j+1], m_gradients + j*m_width*2, m_width);
 }
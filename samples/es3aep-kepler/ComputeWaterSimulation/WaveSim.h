@@ -55,12 +55,22 @@ public:
     //set the damping
     void setDamping(float _damping);
 
-    //simulate using math for indexing
+    //simulate a step and update the gradients
     void simulate(float dt);
 
+    //step the rows [rowBegin, rowEnd) into the back arrays and update their gradients;
+    //bands of rows can run concurrently, call swapBuffers() once every row is done
+    void simulateRows(float dt, int rowBegin, int rowEnd);
+
+    //make the heights and velocities written by simulateRows() current
+    void swapBuffers();
+
     //calculate the gradients
 	void calcGradients();
 
+	//calculate the gradients of the rows [rowBegin, rowEnd)
+	void calcGradients(int rowBegin, int rowEnd);
+
 	//get the width of the surface
     int getWidth() { return m_width; }
 
@@ -68,7 +78,7 @@ public:
     int getHeight() { return m_height; }
 
     //get the height at a specific grid point
-    float getHeight(int i, int j) { return m_v.get(i, j); }
+    float getHeight(int i, int j) { return m_v[m_current].get(i, j); }
 
     //get the pointer to the current heights array
     float *getHeightField() { return m_u[m_current].data; }
@@ -77,7 +87,7 @@ public:
 	float *getGradients() { return m_gradients; }
 
 	// get the pointer to the current velocity array
-	float* getVelocity() { return m_v.data; }
+	float* getVelocity() { return m_v[m_current].data; }
 
 	//get the normal at a grid point (x,y)
 	nv::vec3f getNormal(int x, int y)
@@ -92,7 +102,7 @@ public:
 private:
 
     Array2D<float> m_u[2];    // height
-    Array2D<float> m_v;    // velocity
+    Array2D<float> m_v[2];    // velocity
 	
 	//float m_scaleY; //used to hold the relative height (y) * 2.0f wrt world coords
 	float *m_gradients;
@@ -106,7 +116,7 @@ private:
     //width/height of the grid
     int m_width, m_height;
 
-    //and index to the current(front) height array
+    //and index to the current(front) height and velocity arrays
     int m_current;
 };
 
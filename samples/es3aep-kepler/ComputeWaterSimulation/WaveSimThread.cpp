@@ -33,38 +33,43 @@
 //----------------------------------------------------------------------------------
 #include "WaveSimThread.h"
 #include "NV/NvStopWatch.h"
-#include <NsAtomic.h>
 
 using namespace nvidia::shdfnd;
 
-int WaveSimThread::g_runningThreads = 0;
-int WaveSimThread::g_threadsCounter = 0;
-Sync* WaveSimThread::g_globalWaveSimThreadCondition = NULL;
+// Rows per job; small enough for the smallest grid to keep a few threads busy
+static const uint32_t ROW_GRAIN_SIZE = 16;
+
+JobSystem* WaveSimThread::g_jobSystem = NULL;
+JobCounter WaveSimThread::g_runningSteps;
 NvStopWatch* WaveSimThread::m_threadStopWatch = NULL;
 
 WaveSimThread::WaveSimThread(WaveSim *sim)
-:m_simulation(sim), m_threadId(++WaveSimThread::g_threadsCounter),
-    m_thread(threadThunk, this)
+:m_startTime(0.0f), m_endTime(0.0f), m_simulation(sim)
 {
 }
 
-void WaveSimThread::Init(NvStopWatch* stopWatch) {
+void WaveSimThread::Init(NvStopWatch* stopWatch, JobSystem& jobSystem) {
 	m_threadStopWatch = stopWatch;
-	g_globalWaveSimThreadCondition = new Sync;
+	g_jobSystem = &jobSystem;
+}
+
+void WaveSimThread::Shutdown()
+{
+	if (g_jobSystem)
+	{
+		waitForAllThreads();
+		g_jobSystem = NULL;
+	}
 }
 
 void WaveSimThread::runSimulation()
 {
-    m_localStartCondition.set();
+	g_jobSystem->run(simulationJob, this, g_runningSteps);
 }
 
 void WaveSimThread::waitForAllThreads()
 {
-    while(g_runningThreads>0)
-    {
-        g_globalWaveSimThreadCondition->wait();
-        g_globalWaveSimThreadCondition->reset();
-    }
+	g_jobSystem->wait(g_runningSteps);
 }
 
 void WaveSimThread::pauseAllThreads()
@@ -75,45 +80,29 @@ void WaveSimThread::pauseAllThreads()
 //	g_globalWaveSimThreadCondition.Release();
 }
 
-void WaveSimThread::Run()
+void WaveSimThread::simulationJob(void* thiz, uint32_t)
 {
-	while(!m_thread.quitIsSignalled())
-	{
-        atomicIncrement(&g_runningThreads); 
-
-		m_startTime = m_threadStopWatch->getTime();
-
-		//TODO:
-		float timestep = 1.0f;
+	WaveSimThread* me = (WaveSimThread*)thiz;
+	uint32_t rows = me->m_simulation->getHeight() - 2;
 
-		m_simulation->simulate(timestep);
-		m_simulation->calcGradients();
+	me->m_startTime = m_threadStopWatch->getTime();
 
-		m_endTime = m_threadStopWatch->getTime();
-		//LOGI("Thread %d = [start, end] - Exec Time : [%f, %f] - %f\n", id, startTime, endTime, endTime - startTime);
+	// the bands only read the front heights, so a step is a single pass,
+	// helping with other jobs while the bands finish
+	g_jobSystem->parallelFor(1, rows + 1, ROW_GRAIN_SIZE, simulationRows, me);
+	me->m_simulation->swapBuffers();
 
-        atomicDecrement(&g_runningThreads);
-        g_globalWaveSimThreadCondition->set();
-
-        if (!m_thread.quitIsSignalled()) {
-            m_localStartCondition.wait();
-            m_localStartCondition.reset();
-        }
-	}
-	
-	//printf("Thread %d has finished.\n", id);
+	me->m_endTime = m_threadStopWatch->getTime();
 }
 
-void* WaveSimThread::threadThunk(void* thiz) 
+void WaveSimThread::simulationRows(void* thiz, uint32_t begin, uint32_t end, uint32_t)
 {
-    ((WaveSimThread*)thiz)->Run();
-    return NULL;
+	//TODO:
+	float timestep = 1.0f;
+
+	((WaveSimThread*)thiz)->m_simulation->simulateRows(timestep, begin, end);
 }
 
 WaveSimThread::~WaveSimThread()
 {
-	m_thread.signalQuit();
-	m_localStartCondition.set();
-	m_thread.waitForQuit();
-    atomicDecrement(&g_threadsCounter);
 }
@@ -35,8 +35,7 @@
 #define _WAVE_SIM_THREAD_
 
 #include <NvSimpleTypes.h>
-#include <NsThread.h>
-#include <NsSync.h>
+#include <NsJobSystem.h>
 
 #include "WaveSim.h"
 #include "NV/NvPlatformGL.h"
@@ -45,10 +44,8 @@
 
 class NvStopWatch;
 
-//#include <StopWatch.h>
-//#include <nvports/androidlogs.h>
-
-//The class to handle the threads for simulation
+//The class to handle the simulation jobs of a surface.  All of the surfaces
+//share one job system, and each step is split into bands of rows.
 class WaveSimThread
 {
 
@@ -59,73 +56,58 @@ public:
 	//dtor
 	~WaveSimThread();
 
-	//implementing the run method called by the Start() method from r3::Thread class
-	void Run();
-
-	//get the Start Time of the Thread
+	//get the Start Time of the last step
 	float getStartTime() const{ return m_startTime; }
 
-	//get the end time of the Thread
+	//get the end time of the last step
 	float getEndTime() const{ return m_endTime; }
 
-	//get the execution time of the Thread
+	//get the execution time of the last step
 	float getExecTime() const{ return m_endTime - m_startTime; }
 
-	//run a simulation on the respective thread
+	//queue a simulation step
 	void runSimulation();
 
-	//wait for ay threads still running the simulation
+	//wait for all of the queued steps, helping with them meanwhile
 	static void waitForAllThreads();
 
 	//pause all the threads
 	static void pauseAllThreads();
 
+	//run the first step
     void start()
     {
-        m_thread.start();
-    }
-    
-    //stop the thread
-	void stop()
-	{ 
-		m_thread.signalQuit();
         runSimulation();
-	}
-	
-	//reset the thread counter
-	static void resetCounter(){ g_threadsCounter = 0; }
+    }
 
 	// a watch to compute the time
 	static NvStopWatch& getThreadStopWatch() { return *m_threadStopWatch; }
 
-	static void Init(NvStopWatch* stopWatch);
+	//run the steps on the app's job system
+	static void Init(NvStopWatch* stopWatch, nvidia::shdfnd::JobSystem& jobSystem);
+
+	//wait for the queued steps and stop using the job system
+	static void Shutdown();
 
 private:
-	static NvStopWatch* m_threadStopWatch;
+	//a simulation step, run as a job
+	static void simulationJob(void* thiz, uint32_t threadIndex);
 
-	// a global threads counter
-	static int g_threadsCounter;
+	static void simulationRows(void* thiz, uint32_t begin, uint32_t end, uint32_t threadIndex);
 
-	//a global counter to specify the number of currently running threads
-	static int g_runningThreads;
+	static NvStopWatch* m_threadStopWatch;
 
-	//global Condition Variable for thread synchronization
-	static nvidia::shdfnd::Sync* g_globalWaveSimThreadCondition;
+	//the app's scheduler, shared by every surface
+	static nvidia::shdfnd::JobSystem* g_jobSystem;
 
-	//an ID for the thread
-	int m_threadId;
+	//counts the steps that have been queued and not yet finished
+	static nvidia::shdfnd::JobCounter g_runningSteps;
 
 	//variables to store the start and the end times
 	float m_startTime, m_endTime;
 
 	//pointer to the simulation object
 	WaveSim *m_simulation;
-
-	//local condition variable to handle the running of the next loop (simulation)
-	nvidia::shdfnd::Sync m_localStartCondition;
-
-    static void* threadThunk(void* thiz);
-    nvidia::shdfnd::Thread m_thread;
 };
 
 
@@ -95,3 +95,9 @@ size_t NvFRead(void* ptr, size_t size, size_t nmemb, NvFile* stream)
     return totalCount;
 }
 
+const char* NvFGetRemaining(NvFile* stream, size_t* size)
+{
+    *size = size_t(stream->mLen - stream->mIndex);
+    return stream->mData + stream->mIndex;
+}
+
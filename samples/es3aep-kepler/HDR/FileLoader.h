@@ -73,4 +73,13 @@ char*       NvFGets(char* s, int size, NvFile* stream);
   */
 size_t      NvFRead(void* ptr, size_t size, size_t nmemb, NvFile* stream);
 
+/**
+  Gives direct access to the part of the file that has not been read yet,
+  without copying it.  The data stays valid until the file is closed.
+  @param stream A pointer to an open file opened via NvFOpen()
+  @param size Receives the number of bytes left in the file
+  @return A pointer to the next unread byte
+  */
+const char* NvFGetRemaining(NvFile* stream, size_t* size);
+
 #endif
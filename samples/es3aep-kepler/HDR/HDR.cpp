@@ -172,17 +172,14 @@ GLuint createCubemapTexture(HDRImage &img, GLint internalformat, bool filtering=
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-   
-	hfloat* out = new hfloat[img.getWidth()*img.getHeight()*3];
-    for(int i=0; i<6; i++) {
-	    FP32toFP16((float*)img.getLevel(0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i), out, img.getWidth(),img.getHeight());
 
+    // the images are loaded as half floats, so the faces go up as they are
+    for(int i=0; i<6; i++) {
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0,
-                     GL_RGB16F, img.getWidth(), img.getHeight(), 0, 
-                     GL_RGB, GL_HALF_FLOAT, out);
+                     img.getInternalFormat(), img.getWidth(), img.getHeight(), 0, 
+                     img.getFormat(), img.getType(), img.getLevel(0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i));
     }
 	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-	delete []out;
     return tex;
 }
 
@@ -394,10 +391,11 @@ void HDR::initRendering(void) {
 	InitRenderTexture(getGLContext()->width(), getGLContext()->height());
 	m_aspectRatio = float(getGLContext()->width())/float(getGLContext()->height());
 
-	//load all HDRImages we need
+	//load all HDRImages we need, as half floats, decoding their scanlines in parallel
+	nvidia::shdfnd::JobSystem* jobSystem = &getJobSystem();
 	for (i=0;i<4;i++) {
 		image[i] = new HDRImage;
-		if (!image[i]->loadHDRIFromFile(s_hdr_tex[i])) {
+		if (!image[i]->loadHDRIFromFile(s_hdr_tex[i], RGBE_OUTPUT_RGBA16F, jobSystem)) {
 			fprintf(stderr, "Error loading image file '%s'\n", s_hdr_tex[i]);
 			exit(-1);
 		}
@@ -411,7 +409,7 @@ void HDR::initRendering(void) {
 	}
 	for (i=0;i<4;i++) {
 		image_rough[i] = new HDRImage;
-		if (!image_rough[i]->loadHDRIFromFile(s_hdr_tex_rough[i])) {
+		if (!image_rough[i]->loadHDRIFromFile(s_hdr_tex_rough[i], RGBE_OUTPUT_RGBA16F, jobSystem)) {
 			fprintf(stderr, "Error loading image file '%s'\n", s_hdr_tex_rough[i]);
 			exit(-1);
 		}
@@ -425,7 +423,7 @@ void HDR::initRendering(void) {
 	}
 	for (i=0;i<4;i++) {
 		image_irrad[i] = new HDRImage;
-		if (!image_irrad[i]->loadHDRIFromFile(s_hdr_tex_irrad[i])) {
+		if (!image_irrad[i]->loadHDRIFromFile(s_hdr_tex_irrad[i], RGBE_OUTPUT_RGBA16F, jobSystem)) {
 			fprintf(stderr, "Error loading image file '%s'\n", s_hdr_tex_irrad[i]);
 			exit(-1);
 		}
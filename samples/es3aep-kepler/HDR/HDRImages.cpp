@@ -34,7 +34,36 @@
 #include <string.h>
 #include <vector>
 #include <NvAssert.h>
+#include <NsJobSystem.h>
 #include "HDRImages.h"
+
+#ifndef GL_RGBA16F
+#define GL_RGBA16F GL_RGBA16F_ARB
+#endif
+
+// Scanlines per decode job
+static const uint32_t SCANLINE_GRAIN_SIZE = 16;
+
+struct ScanlineDecode {
+    const unsigned char* pixels;
+    const int* offsets;
+    int rleScanlines;
+    int width;
+    int height;
+    int format;
+    GLubyte* out;
+    volatile int failed;
+};
+
+static void decodeScanlines(void* userData, uint32_t begin, uint32_t end, uint32_t)
+{
+    ScanlineDecode* decode = (ScanlineDecode*)userData;
+    //hdr images come in upside down, so the rows are written flipped
+    if (RGBE_DecodeScanlines(decode->pixels, decode->offsets, decode->rleScanlines,
+            decode->width, decode->height, begin, end, decode->format, 1, decode->out))
+        decode->failed = 1;
+}
+
 //
 //
 ////////////////////////////////////////////////////////////
@@ -100,7 +129,7 @@ void* HDRImage::getLevel( int level, GLenum face) {
     return _data[ face*_levelCount + level];
 }
 
-bool HDRImage::loadHDRIFromFile( const char* file) {
+bool HDRImage::loadHDRIFromFile( const char* file, int outputFormat, nvidia::shdfnd::JobSystem* jobSystem) {
     int width, height;
     NvFile *fp = NvFOpen(file);
     if (!fp) {
@@ -114,14 +143,32 @@ bool HDRImage::loadHDRIFromFile( const char* file) {
         return false;
     }
 
-    GLubyte *data = (GLubyte*)new float[width*height*3];
-    
-    if (!data) {
+    //decode straight out of the loaded file, once the start of every scanline is known
+    size_t pixelBytes;
+    const unsigned char* pixels = (const unsigned char*)NvFGetRemaining(fp, &pixelBytes);
+    std::vector<int> offsets(height + 1);
+    int rleScanlines;
+
+    if (RGBE_FindScanlines( pixels, (int)pixelBytes, width, height, &offsets[0], &rleScanlines)) {
         NvFClose(fp);
         return false;
     }
 
-    if (RGBE_ReadPixels_RLE( fp, (float*)data, width, height)) {
+    const int elementSize = RGBE_OutputPixelSize(outputFormat);
+    if (!elementSize) {
+        NvFClose(fp);
+        return false;
+    }
+
+    GLubyte *data = new GLubyte[width*height*elementSize];
+
+    ScanlineDecode decode = { pixels, &offsets[0], rleScanlines, width, height, outputFormat, data, 0 };
+    if (jobSystem)
+        jobSystem->parallelFor(0, height, SCANLINE_GRAIN_SIZE, decodeScanlines, &decode);
+    else
+        decodeScanlines(&decode, 0, height, 0);
+
+    if (decode.failed) {
         delete []data;
         NvFClose(fp);
         return false;
@@ -132,17 +179,28 @@ bool HDRImage::loadHDRIFromFile( const char* file) {
     _height = height;
     _depth = 0;
     _levelCount = 1;
-    _type = GL_FLOAT;
-    _format = GL_RGB;
-	// GL_RGB32F_ARB 0x8815
-    _internalFormat = 0x8815;
+    switch (outputFormat) {
+    case RGBE_OUTPUT_RGBA16F:
+        _type = GL_HALF_FLOAT;
+        _format = GL_RGBA;
+        _internalFormat = GL_RGBA16F;
+        break;
+    case RGBE_OUTPUT_RGB9E5:
+        _type = GL_UNSIGNED_INT_5_9_9_9_REV;
+        _format = GL_RGB;
+        _internalFormat = GL_RGB9_E5;
+        break;
+    default:
+        _type = GL_FLOAT;
+        _format = GL_RGB;
+        // GL_RGB32F_ARB 0x8815
+        _internalFormat = 0x8815;
+        break;
+    }
     _faces = 0;
-    _elementSize = 12;
+    _elementSize = elementSize;
     _data.push_back( data);
 
-    //hdr images come in upside down
-    flipSurface( data, _width, _height, _depth);
-
     NvFClose(fp);
 
     return true;
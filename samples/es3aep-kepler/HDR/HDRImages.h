@@ -38,6 +38,8 @@
 #include "rgbe.h"
 #include <NV/NvPlatformGL.h>
 
+namespace nvidia { namespace shdfnd { class JobSystem; } }
+
 typedef unsigned short    hfloat;
 
 hfloat convertFloatToHFloat(float *f);
@@ -88,8 +90,11 @@ public:
    const void* getLevel( int level, GLenum face = GL_TEXTURE_CUBE_MAP_POSITIVE_X) const;
    void* getLevel( int level, GLenum face = GL_TEXTURE_CUBE_MAP_POSITIVE_X);
 
-    //initialize an image   from a file
-   bool loadHDRIFromFile( const char* file);
+    //initialize an image   from a file, decoding to one of the RGBE_OUTPUT_* formats:
+    //RGB32F (12 bytes a pixel), RGBA16F (8) or RGB9E5 (4).  The scanlines are decoded
+    //on the job system's threads when one is given
+   bool loadHDRIFromFile( const char* file, int outputFormat = RGBE_OUTPUT_RGB32F,
+       nvidia::shdfnd::JobSystem* jobSystem = NULL);
 
     //convert a suitable image from a cubemap cross to a cubemap (returns false for unsuitable images)
    bool convertCrossToCubemap();
@@ -451,3 +451,218 @@ int RGBE_ReadPixels_Raw_RLE(NvFile *fp, unsigned char *data, int scanline_width,
   return RGBE_RETURN_SUCCESS;
 }
 
+
+
+int RGBE_OutputPixelSize(int format)
+{
+  switch (format) {
+  case RGBE_OUTPUT_RGB32F:
+    return 3*sizeof(float);
+  case RGBE_OUTPUT_RGBA16F:
+    return 4*sizeof(unsigned short);
+  case RGBE_OUTPUT_RGB9E5:
+    return sizeof(unsigned int);
+  default:
+    return 0;
+  }
+}
+
+int RGBE_FindScanlines(const unsigned char *data, int size, int scanline_width,
+			int num_scanlines, int *offsets, int *rle_scanlines)
+{
+  int y, i, n, count, pos;
+
+  if ((scanline_width <= 0)||(num_scanlines <= 0))
+    return rgbe_error(rgbe_format_error,(char*)"bad image size");
+  pos = 0;
+  y = 0;
+  if ((scanline_width >= 8)&&(scanline_width <= 0x7fff)) {
+    for(;y<num_scanlines;y++) {
+      if (size - pos < 4)
+        return rgbe_error(rgbe_read_error,NULL);
+      if ((data[pos] != 2)||(data[pos+1] != 2)||(data[pos+2] & 0x80))
+        break;  /* not run length encoded from here on */
+      if ((((int)data[pos+2])<<8 | data[pos+3]) != scanline_width)
+        return rgbe_error(rgbe_format_error,(char*)"wrong scanline width");
+      offsets[y] = pos;
+      pos += 4;
+      /* step over the tokens of each of the four channels */
+      for(i=0;i<4;i++) {
+        for(n=0;n<scanline_width;n+=count) {
+          if (size - pos < 2)
+            return rgbe_error(rgbe_read_error,NULL);
+          if (data[pos] > 128) {
+            count = data[pos]-128;
+            pos += 2;
+          }
+          else {
+            count = data[pos];
+            pos += 1+count;
+          }
+          if ((count == 0)||(count > scanline_width - n))
+            return rgbe_error(rgbe_format_error,(char*)"bad scanline data");
+        }
+      }
+      if (pos > size)
+        return rgbe_error(rgbe_read_error,NULL);
+    }
+  }
+  *rle_scanlines = y;
+
+  /* the rest is flat, four bytes a pixel */
+  if ((size - pos)/4/scanline_width < num_scanlines - y)
+    return rgbe_error(rgbe_read_error,NULL);
+  for(;y<num_scanlines;y++) {
+    offsets[y] = pos;
+    pos += 4*scanline_width;
+  }
+  offsets[num_scanlines] = pos;
+  return RGBE_RETURN_SUCCESS;
+}
+
+/* an rgbe color as a half float.  It has at most 8 significant bits, so
+   it converts exactly unless it lands in the half denormals or overflows
+   to infinity.  Both cases are selected rather than branched to, since
+   dark and black pixels mix freely */
+static unsigned short rgbe_float2half(float f)
+{
+  union { float f; unsigned int u; } v, d;
+  unsigned int h;
+
+  v.f = f;
+  /* below 2^-14 the half is denormal: adding 0.5 has the float unit round
+     the value to nearest even in units of 2^-24, the half denormal step */
+  d.f = f + 0.5f;
+  h = (v.u < 0x38800000) ? d.u - 0x3f000000 : (v.u - 0x38000000) >> 13;
+  return (unsigned short)((v.u >= 0x47800000) ? 0x7c00 : h);  /* 2^16 */
+}
+
+/* one 8 bit rgbe mantissa as the 9 bit mantissa of an rgb9e5 pixel whose
+   exponent is the rgbe exponent less 113; shift is how far the rgbe
+   exponent lies below (negative) or above (positive) the range rgb9e5 can
+   hold, where the value is rounded or clamped */
+static unsigned int rgbe_mantissa9(unsigned int m, int shift)
+{
+  m <<= 1;
+  if (shift < 0) {
+    if (shift < -9)
+      return 0;
+    return (m + (1u << (-shift - 1))) >> -shift;
+  }
+  if ((shift > 8)||(m << shift) > 511)
+    return m ? 511 : 0;
+  return m << shift;
+}
+
+/* convert a scanline held as four planes of bytes, the way run length
+   encoded scanlines are stored, to the output format */
+static void rgbe_convert_scanline(const unsigned char *planes, int scanline_width,
+                                  const float *scale, int format, void *out)
+{
+  const unsigned char *r = planes;
+  const unsigned char *g = planes + scanline_width;
+  const unsigned char *b = planes + 2*scanline_width;
+  const unsigned char *e = planes + 3*scanline_width;
+  int i;
+
+  switch (format) {
+  case RGBE_OUTPUT_RGB32F: {
+    float *f = (float*)out;
+    for(i=0;i<scanline_width;i++) {
+      f[0] = r[i] * scale[e[i]];
+      f[1] = g[i] * scale[e[i]];
+      f[2] = b[i] * scale[e[i]];
+      f += 3;
+    }
+    break;
+  }
+  case RGBE_OUTPUT_RGBA16F: {
+    unsigned short *h = (unsigned short*)out;
+    for(i=0;i<scanline_width;i++) {
+      h[0] = rgbe_float2half(r[i] * scale[e[i]]);
+      h[1] = rgbe_float2half(g[i] * scale[e[i]]);
+      h[2] = rgbe_float2half(b[i] * scale[e[i]]);
+      h[3] = 0x3c00;
+      h += 4;
+    }
+    break;
+  }
+  case RGBE_OUTPUT_RGB9E5: {
+    /* both formats share one exponent between the colors, so the mantissas
+       carry over: m*2^(e-136) == (2m)*2^((e-113)-15-9) */
+    unsigned int *p = (unsigned int*)out;
+    for(i=0;i<scanline_width;i++) {
+      int exponent = e[i] ? e[i] - 113 : -1000;
+      int shift = (exponent < 0) ? exponent : ((exponent > 31) ? exponent - 31 : 0);
+      p[i] = rgbe_mantissa9(r[i],shift) |
+        (rgbe_mantissa9(g[i],shift) << 9) |
+        (rgbe_mantissa9(b[i],shift) << 18) |
+        ((unsigned int)(exponent - shift) << 27);
+    }
+    break;
+  }
+  }
+}
+
+int RGBE_DecodeScanlines(const unsigned char *data, const int *offsets,
+			int rle_scanlines, int scanline_width, int num_scanlines,
+			int first, int last, int format, int flip, void *out)
+{
+  unsigned char *scanline_buffer, *ptr, *ptr_end;
+  const unsigned char *src;
+  float scale[256];
+  int i, y, count, pixel_size;
+
+  pixel_size = RGBE_OutputPixelSize(format);
+  if (pixel_size == 0)
+    return rgbe_error(rgbe_format_error,(char*)"unknown output format");
+
+  /* same conversion as rgbe2float, one multiply per color */
+  scale[0] = 0.0f;
+  for(i=1;i<256;i++)
+    scale[i] = (float)ldexp(1.0,i-(int)(128+8));
+
+  scanline_buffer = (unsigned char *)malloc(sizeof(unsigned char)*4*scanline_width);
+  if (scanline_buffer == NULL)
+    return rgbe_error(rgbe_memory_error,(char*)"unable to allocate buffer space");
+
+  for(y=first;y<last;y++) {
+    src = data + offsets[y];
+    if (y >= rle_scanlines) {
+      /* flat pixels, split into planes */
+      for(i=0;i<scanline_width;i++) {
+        scanline_buffer[i] = src[0];
+        scanline_buffer[i+scanline_width] = src[1];
+        scanline_buffer[i+2*scanline_width] = src[2];
+        scanline_buffer[i+3*scanline_width] = src[3];
+        src += 4;
+      }
+    }
+    else {
+      /* RGBE_FindScanlines has checked the tokens, so there is no need to
+         check them again here */
+      src += 4;
+      ptr = &scanline_buffer[0];
+      for(i=0;i<4;i++) {
+        ptr_end = &scanline_buffer[(i+1)*scanline_width];
+        while(ptr < ptr_end) {
+          if (src[0] > 128) {
+            count = src[0]-128;
+            memset(ptr,src[1],count);
+            src += 2;
+          }
+          else {
+            count = src[0];
+            memcpy(ptr,src+1,count);
+            src += 1+count;
+          }
+          ptr += count;
+        }
+      }
+    }
+    rgbe_convert_scanline(scanline_buffer,scanline_width,scale,format,
+      (unsigned char*)out + (size_t)(flip ? num_scanlines-1-y : y)*scanline_width*pixel_size);
+  }
+  free(scanline_buffer);
+  return RGBE_RETURN_SUCCESS;
+}
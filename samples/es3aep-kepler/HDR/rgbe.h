@@ -64,6 +64,11 @@ typedef struct {
 #define RGBE_RETURN_SUCCESS 0
 #define RGBE_RETURN_FAILURE -1
 
+/* pixel formats that RGBE_DecodeScanlines can write */
+#define RGBE_OUTPUT_RGB32F  0  /* three floats per pixel */
+#define RGBE_OUTPUT_RGBA16F 1  /* four half floats per pixel, alpha is 1 */
+#define RGBE_OUTPUT_RGB9E5  2  /* one GL_UNSIGNED_INT_5_9_9_9_REV word per pixel */
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -87,6 +92,21 @@ int RGBE_ReadPixels_RLE(NvFile *fp, float *data, int scanline_width,
 int RGBE_ReadPixels_Raw_RLE(NvFile *fp, unsigned char *data, int scanline_width,
             int num_scanlines);
 
+/* decode pixels straight from memory, e.g. the rest of a file after
+   RGBE_ReadHeader (see NvFGetRemaining).  RGBE_FindScanlines makes a quick
+   pass that only steps over the run length tokens to find where each
+   scanline starts: offsets receives num_scanlines+1 entries and scanlines
+   from *rle_scanlines on are stored flat.  After that any range of
+   scanlines can be decoded on its own, so ranges may be decoded on several
+   threads at once.  With flip set, scanline y is written to row
+   num_scanlines-1-y, which puts the image the right way up for GL. */
+int RGBE_OutputPixelSize(int format);
+int RGBE_FindScanlines(const unsigned char *data, int size, int scanline_width,
+            int num_scanlines, int *offsets, int *rle_scanlines);
+int RGBE_DecodeScanlines(const unsigned char *data, const int *offsets,
+            int rle_scanlines, int scanline_width, int num_scanlines,
+            int first, int last, int format, int flip, void *out);
+
 #ifdef _CPLUSPLUS
 /* define if your compiler understands inline commands */
 #define INLINE inline
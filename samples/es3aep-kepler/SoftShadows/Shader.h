@@ -51,59 +51,61 @@ public:
     
 protected:
 
+    // Values are staged and only reach GL, if they changed, on the next
+    // flushUniforms() before a draw
     void setUniformMatrix(GLint handle, const nv::matrix4f &m)
     {
         NV_ASSERT(handle >= 0);
-        glUniformMatrix4fv(handle, 1, GL_FALSE, m._array);
+        stageUniformMatrix4fv(handle, m._array);
         CHECK_GL_ERROR();
     }
 
     void setUniformTexture(GLint handle, GLint unit)
     {
         NV_ASSERT(handle >= 0);
-        glUniform1i(handle, unit);
+        stageUniform1i(handle, unit);
         CHECK_GL_ERROR();
     }
 
     void setUniformBool(GLint handle, bool b)
     {
         NV_ASSERT(handle >= 0);
-        glUniform1i(handle, b ? 1 : 0);
+        stageUniform1i(handle, b ? 1 : 0);
         CHECK_GL_ERROR();
     }
 
     void setUniformInt(GLint handle, GLint i)
     {
         NV_ASSERT(handle >= 0);
-        glUniform1i(handle, i);
+        stageUniform1i(handle, i);
         CHECK_GL_ERROR();
     }
 
     void setUniformScalar(GLint handle, GLfloat s)
     {
         NV_ASSERT(handle >= 0);
-        glUniform1f(handle, s);
+        stageUniform1f(handle, s);
         CHECK_GL_ERROR();
     }
 
     void setUniformVector(GLint handle, const nv::vec2f &v)
     {
         NV_ASSERT(handle >= 0);
-        glUniform2fv(handle, 1, v._array);
+        stageUniform2fv(handle, v._array);
         CHECK_GL_ERROR();
     }
 
     void setUniformVector(GLint handle, const nv::vec3f &v)
     {
         NV_ASSERT(handle >= 0);
-        glUniform3fv(handle, 1, v._array);
+        stageUniform3fv(handle, v._array);
         CHECK_GL_ERROR();
     }
 
     void setUniformVector(GLint handle, const nv::vec4f &v)
     {
         NV_ASSERT(handle >= 0);
-        glUniform4fv(handle, 1, v._array);
+        stageUniform4fv(handle, v._array);
         CHECK_GL_ERROR();
     }
 };
@@ -58,6 +58,7 @@ static const char *GROUND_NORMAL_MAP_FILENAME = "textures/lichen6_normal.dds";
 void SoftShadowsRenderer::MeshInstance::draw(SceneShader &shader)
 {
     shader.setWorldMatrix(m_worldTransform);
+    shader.flushUniforms();
     m_mesh->render(shader);
     CHECK_GL_ERROR();
 }
@@ -246,6 +247,7 @@ void SoftShadowsRenderer::render(float deltaTime)
         glDisable(GL_DEPTH_TEST);
         glDisable(GL_CULL_FACE);
 
+        m_visTexShader->flushUniforms();
         NvDrawQuadGL(
             m_visTexShader->getPositionAttrHandle(),
             m_visTexShader->getTexCoordAttrHandle());
@@ -800,6 +802,7 @@ void SoftShadowsRenderer::drawGround(SceneShader &shader)
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_groundIndexBuffer);
 
     // Do the actual drawing
+    shader.flushUniforms();
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
 
     // Clear state
@@ -0,0 +1,507 @@
+//----------------------------------------------------------------------------------
+// File:        es3aep-kepler\ThreadedRenderingGL/FlockingKernels.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "FlockingKernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define FLOCKING_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define FLOCKING_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Lanes of floats, and the masks that comparing them produces.  The kernels
+// below are written once against these: four lanes with SSE2 or NEON, and a
+// single lane otherwise, so that the plain C version still skips the work
+// that a fish doesn't need the way the vector versions skip whole groups.
+#if FLOCKING_SSE2
+typedef __m128 FloatN;
+typedef __m128 MaskN;
+static const uint32_t cLaneCount = 4;
+
+static inline FloatN Splat(float f) { return _mm_set1_ps(f); }
+static inline FloatN Load(const float* p) { return _mm_loadu_ps(p); }
+static inline void Store(float* p, FloatN v) { _mm_storeu_ps(p, v); }
+static inline FloatN Add(FloatN a, FloatN b) { return _mm_add_ps(a, b); }
+static inline FloatN Sub(FloatN a, FloatN b) { return _mm_sub_ps(a, b); }
+static inline FloatN Mul(FloatN a, FloatN b) { return _mm_mul_ps(a, b); }
+static inline FloatN Div(FloatN a, FloatN b) { return _mm_div_ps(a, b); }
+static inline FloatN Sqrt(FloatN a) { return _mm_sqrt_ps(a); }
+static inline FloatN Min(FloatN a, FloatN b) { return _mm_min_ps(a, b); }
+static inline FloatN Max(FloatN a, FloatN b) { return _mm_max_ps(a, b); }
+static inline MaskN Less(FloatN a, FloatN b) { return _mm_cmplt_ps(a, b); }
+static inline MaskN LessEqual(FloatN a, FloatN b) { return _mm_cmple_ps(a, b); }
+static inline MaskN Greater(FloatN a, FloatN b) { return _mm_cmpgt_ps(a, b); }
+static inline MaskN NotEqual(FloatN a, FloatN b) { return _mm_cmpneq_ps(a, b); }
+static inline MaskN And(MaskN a, MaskN b) { return _mm_and_ps(a, b); }
+static inline MaskN AndNot(MaskN a, MaskN b) { return _mm_andnot_ps(b, a); }
+static inline MaskN Or(MaskN a, MaskN b) { return _mm_or_ps(a, b); }
+static inline FloatN Select(MaskN m, FloatN a, FloatN b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+static inline bool Any(MaskN m) { return _mm_movemask_ps(m) != 0; }
+#elif FLOCKING_NEON
+typedef float32x4_t FloatN;
+typedef uint32x4_t MaskN;
+static const uint32_t cLaneCount = 4;
+
+static inline FloatN Splat(float f) { return vdupq_n_f32(f); }
+static inline FloatN Load(const float* p) { return vld1q_f32(p); }
+static inline void Store(float* p, FloatN v) { vst1q_f32(p, v); }
+static inline FloatN Add(FloatN a, FloatN b) { return vaddq_f32(a, b); }
+static inline FloatN Sub(FloatN a, FloatN b) { return vsubq_f32(a, b); }
+static inline FloatN Mul(FloatN a, FloatN b) { return vmulq_f32(a, b); }
+#if defined(__aarch64__)
+static inline FloatN Div(FloatN a, FloatN b) { return vdivq_f32(a, b); }
+static inline FloatN Sqrt(FloatN a) { return vsqrtq_f32(a); }
+#else
+// 32-bit NEON only has estimates, so divide and take roots a lane at a time
+// to get the same results as the other versions
+static inline FloatN Div(FloatN a, FloatN b)
+{
+    float lanesA[4], lanesB[4];
+    vst1q_f32(lanesA, a);
+    vst1q_f32(lanesB, b);
+    for (int i = 0; i < 4; ++i) lanesA[i] /= lanesB[i];
+    return vld1q_f32(lanesA);
+}
+static inline FloatN Sqrt(FloatN a)
+{
+    float lanes[4];
+    vst1q_f32(lanes, a);
+    for (int i = 0; i < 4; ++i) lanes[i] = sqrtf(lanes[i]);
+    return vld1q_f32(lanes);
+}
+#endif
+static inline FloatN Min(FloatN a, FloatN b) { return vminq_f32(a, b); }
+static inline FloatN Max(FloatN a, FloatN b) { return vmaxq_f32(a, b); }
+static inline MaskN Less(FloatN a, FloatN b) { return vcltq_f32(a, b); }
+static inline MaskN LessEqual(FloatN a, FloatN b) { return vcleq_f32(a, b); }
+static inline MaskN Greater(FloatN a, FloatN b) { return vcgtq_f32(a, b); }
+static inline MaskN NotEqual(FloatN a, FloatN b) { return vmvnq_u32(vceqq_f32(a, b)); }
+static inline MaskN And(MaskN a, MaskN b) { return vandq_u32(a, b); }
+static inline MaskN AndNot(MaskN a, MaskN b) { return vbicq_u32(a, b); }
+static inline MaskN Or(MaskN a, MaskN b) { return vorrq_u32(a, b); }
+static inline FloatN Select(MaskN m, FloatN a, FloatN b) { return vbslq_f32(m, a, b); }
+static inline bool Any(MaskN m)
+{
+    const uint32x2_t halves = vorr_u32(vget_low_u32(m), vget_high_u32(m));
+    return (vget_lane_u32(halves, 0) | vget_lane_u32(halves, 1)) != 0;
+}
+#else
+typedef float FloatN;
+typedef bool MaskN;
+static const uint32_t cLaneCount = 1;
+
+static inline FloatN Splat(float f) { return f; }
+static inline FloatN Load(const float* p) { return *p; }
+static inline void Store(float* p, FloatN v) { *p = v; }
+static inline FloatN Add(FloatN a, FloatN b) { return a + b; }
+static inline FloatN Sub(FloatN a, FloatN b) { return a - b; }
+static inline FloatN Mul(FloatN a, FloatN b) { return a * b; }
+static inline FloatN Div(FloatN a, FloatN b) { return a / b; }
+static inline FloatN Sqrt(FloatN a) { return sqrtf(a); }
+static inline FloatN Min(FloatN a, FloatN b) { return (a < b) ? a : b; }
+static inline FloatN Max(FloatN a, FloatN b) { return (a > b) ? a : b; }
+static inline MaskN Less(FloatN a, FloatN b) { return a < b; }
+static inline MaskN LessEqual(FloatN a, FloatN b) { return a <= b; }
+static inline MaskN Greater(FloatN a, FloatN b) { return a > b; }
+static inline MaskN NotEqual(FloatN a, FloatN b) { return a != b; }
+static inline MaskN And(MaskN a, MaskN b) { return a && b; }
+static inline MaskN AndNot(MaskN a, MaskN b) { return a && !b; }
+static inline MaskN Or(MaskN a, MaskN b) { return a || b; }
+static inline FloatN Select(MaskN m, FloatN a, FloatN b) { return m ? a : b; }
+static inline bool Any(MaskN m) { return m; }
+#endif
+
+static inline float Sum(FloatN v)
+{
+    float lanes[cLaneCount];
+    Store(lanes, v);
+    float sum = lanes[0];
+    for (uint32_t i = 1; i < cLaneCount; ++i)
+    {
+        sum += lanes[i];
+    }
+    return sum;
+}
+
+static inline FloatN LaneIndices(uint32_t first)
+{
+    static const float sc_offsets[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+    return Add(Splat((float)first), Load(sc_offsets));
+}
+
+static inline FloatN Dot(FloatN ax, FloatN ay, FloatN az, FloatN bx, FloatN by, FloatN bz)
+{
+    return Add(Add(Mul(ax, bx), Mul(ay, by)), Mul(az, bz));
+}
+
+// Same as nv::normalize: vectors of length zero become zero
+static inline void Normalize(FloatN& x, FloatN& y, FloatN& z)
+{
+    const FloatN length = Sqrt(Dot(x, y, z, x, y, z));
+    const MaskN nonZero = Greater(length, Splat(0.0f));
+    x = Select(nonZero, Div(x, length), Splat(0.0f));
+    y = Select(nonZero, Div(y, length), Splat(0.0f));
+    z = Select(nonZero, Div(z, length), Splat(0.0f));
+}
+
+static inline MaskN NearlyVertical(FloatN headingY)
+{
+    return Or(Greater(headingY, Splat(0.999f)), Less(headingY, Splat(-0.999f)));
+}
+
+static void ResizePadded(std::vector<float>& values, uint32_t count)
+{
+    values.resize(PaddedFishCount(count), 0.0f);
+}
+
+void FishVectors::Resize(uint32_t count)
+{
+    ResizePadded(m_positionX, count);
+    ResizePadded(m_positionY, count);
+    ResizePadded(m_positionZ, count);
+    ResizePadded(m_headingX, count);
+    ResizePadded(m_headingY, count);
+    ResizePadded(m_headingZ, count);
+}
+
+void FishSteering::Resize(uint32_t count)
+{
+    ResizePadded(m_repulsionX, count);
+    ResizePadded(m_repulsionY, count);
+    ResizePadded(m_repulsionZ, count);
+    ResizePadded(m_alignmentX, count);
+    ResizePadded(m_alignmentY, count);
+    ResizePadded(m_alignmentZ, count);
+    ResizePadded(m_cohesionX, count);
+    ResizePadded(m_cohesionY, count);
+    ResizePadded(m_cohesionZ, count);
+    ResizePadded(m_repulsionCount, count);
+    ResizePadded(m_speedChange, count);
+}
+
+void AccumulateNeighbors(const NeighborSearch& search, uint32_t fishIndex,
+                         const nv::vec3f& position, const nv::vec3f& heading,
+                         const uint32_t* pRanges, uint32_t numRanges, NeighborSums& sums)
+{
+    const FishVectors& neighbors = *search.m_pNeighbors;
+    const FloatN zero = Splat(0.0f);
+    const FloatN one = Splat(1.0f);
+    const FloatN self = Splat((float)fishIndex);
+    const FloatN posX = Splat(position.x), posY = Splat(position.y), posZ = Splat(position.z);
+    const FloatN headX = Splat(heading.x), headY = Splat(heading.y), headZ = Splat(heading.z);
+    const FloatN originX = Splat(search.m_origin.x), originY = Splat(search.m_origin.y), originZ = Splat(search.m_origin.z);
+    const FloatN repulsionDistance2 = Splat(search.m_repulsionDistance2);
+    const FloatN alignmentDistance2 = Splat(search.m_alignmentDistance2);
+
+    FloatN repulsionX = zero, repulsionY = zero, repulsionZ = zero;
+    FloatN alignmentX = zero, alignmentY = zero, alignmentZ = zero;
+    FloatN nearX = zero, nearY = zero, nearZ = zero;
+    FloatN repulsionCount = zero, nearCount = zero, accelerateCount = zero, decelerateCount = zero;
+
+    for (uint32_t range = 0; range < numRanges; ++range)
+    {
+        const uint32_t slotEnd = pRanges[range * 2 + 1];
+        const FloatN end = Splat((float)slotEnd);
+        for (uint32_t slot = pRanges[range * 2]; slot < slotEnd; slot += cLaneCount)
+        {
+            const FloatN neighborIndex = Load(search.m_pNeighborIndices + slot);
+            const MaskN valid = And(Less(LaneIndices(slot), end), NotEqual(neighborIndex, self));
+
+            const FloatN neighborX = Load(&neighbors.m_positionX[slot]);
+            const FloatN neighborY = Load(&neighbors.m_positionY[slot]);
+            const FloatN neighborZ = Load(&neighbors.m_positionZ[slot]);
+            const FloatN deltaX = Sub(neighborX, posX);
+            const FloatN deltaY = Sub(neighborY, posY);
+            const FloatN deltaZ = Sub(neighborZ, posZ);
+            const FloatN dist2 = Dot(deltaX, deltaY, deltaZ, deltaX, deltaY, deltaZ);
+
+            // Neighbors further away are only headed towards, which the caller
+            // works out from the sum of all of the positions
+            const MaskN near = And(valid, LessEqual(dist2, alignmentDistance2));
+            if (!Any(near))
+            {
+                continue;
+            }
+            nearX = Add(nearX, Select(near, Sub(neighborX, originX), zero));
+            nearY = Add(nearY, Select(near, Sub(neighborY, originY), zero));
+            nearZ = Add(nearZ, Select(near, Sub(neighborZ, originZ), zero));
+            nearCount = Add(nearCount, Select(near, one, zero));
+
+            // Close enough to align with, but not to avoid
+            const MaskN tooClose = And(near, LessEqual(dist2, repulsionDistance2));
+            const MaskN aligning = AndNot(near, tooClose);
+            alignmentX = Add(alignmentX, Select(aligning, Load(&neighbors.m_headingX[slot]), zero));
+            alignmentY = Add(alignmentY, Select(aligning, Load(&neighbors.m_headingY[slot]), zero));
+            alignmentZ = Add(alignmentZ, Select(aligning, Load(&neighbors.m_headingZ[slot]), zero));
+            if (!Any(tooClose))
+            {
+                continue;
+            }
+
+            // Neighbors too close for a good direction are left to the order of
+            // the indices: the first one accelerates
+            const FloatN dist = Sqrt(dist2);
+            const MaskN overlapping = And(tooClose, Less(dist, Splat(0.001f)));
+            const MaskN selfIsLater = Greater(self, neighborIndex);
+            decelerateCount = Add(decelerateCount, Select(And(overlapping, selfIsLater), one, zero));
+            accelerateCount = Add(accelerateCount, Select(AndNot(overlapping, selfIsLater), one, zero));
+
+            // Otherwise slow down for neighbors in front, speed up for ones behind
+            // and turn away from ones to the side
+            const MaskN apart = AndNot(tooClose, overlapping);
+            const FloatN normX = Div(deltaX, dist);
+            const FloatN normY = Div(deltaY, dist);
+            const FloatN normZ = Div(deltaZ, dist);
+            const FloatN dotPosition = Dot(headX, headY, headZ, normX, normY, normZ);
+            const MaskN inFront = And(apart, Greater(dotPosition, Splat(0.95f)));
+            const MaskN behind = And(apart, Less(dotPosition, Splat(-0.95f)));
+            const MaskN toSide = AndNot(AndNot(apart, inFront), behind);
+            decelerateCount = Add(decelerateCount, Select(inFront, one, zero));
+            accelerateCount = Add(accelerateCount, Select(behind, one, zero));
+            repulsionX = Sub(repulsionX, Select(toSide, normX, zero));
+            repulsionY = Sub(repulsionY, Select(toSide, normY, zero));
+            repulsionZ = Sub(repulsionZ, Select(toSide, normZ, zero));
+            repulsionCount = Add(repulsionCount, Select(toSide, one, zero));
+        }
+    }
+
+    sums.m_repulsion += nv::vec3f(Sum(repulsionX), Sum(repulsionY), Sum(repulsionZ));
+    sums.m_alignment += nv::vec3f(Sum(alignmentX), Sum(alignmentY), Sum(alignmentZ));
+    sums.m_nearOffset += nv::vec3f(Sum(nearX), Sum(nearY), Sum(nearZ));
+    sums.m_repulsionCount += (uint32_t)Sum(repulsionCount);
+    sums.m_nearCount += (uint32_t)Sum(nearCount);
+    sums.m_accelerateCount += (uint32_t)Sum(accelerateCount);
+    sums.m_decelerateCount += (uint32_t)Sum(decelerateCount);
+}
+
+void IntegrateFish(const FishIntegrationParams& params, const FishSteering& steering,
+                   FishVectors& fish, float* pSpeeds, float* pAnimTimes, uint32_t count,
+                   nv::vec3f& positionSum, float& distance2Sum)
+{
+    const FloatN zero = Splat(0.0f);
+    const FloatN end = Splat((float)count);
+    const FloatN frameTime = Splat(params.m_frameTime);
+    const FloatN goalX = Splat(params.m_goal.x), goalY = Splat(params.m_goal.y), goalZ = Splat(params.m_goal.z);
+    const FloatN centroidX = Splat(params.m_lastCentroid.x);
+    const FloatN centroidY = Splat(params.m_lastCentroid.y);
+    const FloatN centroidZ = Splat(params.m_lastCentroid.z);
+    const FloatN maxSpeed = Splat(params.m_maxSpeed);
+    const FloatN speedStep = Splat(params.m_maxSpeed * params.m_frameTime);
+    const FloatN bias = Splat(0.2f);
+
+    FloatN sumX = zero, sumY = zero, sumZ = zero, sumDistance2 = zero;
+
+    for (uint32_t first = 0; first < count; first += cLaneCount)
+    {
+        const MaskN valid = Less(LaneIndices(first), end);
+        const FloatN oldPosX = Load(&fish.m_positionX[first]);
+        const FloatN oldPosY = Load(&fish.m_positionY[first]);
+        const FloatN oldPosZ = Load(&fish.m_positionZ[first]);
+        const FloatN oldHeadX = Load(&fish.m_headingX[first]);
+        const FloatN oldHeadY = Load(&fish.m_headingY[first]);
+        const FloatN oldHeadZ = Load(&fish.m_headingZ[first]);
+        const FloatN oldSpeed = Load(pSpeeds + first);
+
+        FloatN goalHeadX = Sub(goalX, oldPosX);
+        FloatN goalHeadY = Sub(goalY, oldPosY);
+        FloatN goalHeadZ = Sub(goalZ, oldPosZ);
+        Normalize(goalHeadX, goalHeadY, goalHeadZ);
+
+        // Swim away from the centers of the overlapping schools that we are in
+        FloatN avoidX = zero, avoidY = zero, avoidZ = zero;
+        for (uint32_t school = 0; school < params.m_numSchoolsToAvoid; ++school)
+        {
+            const nv::vec3f& center = params.m_avoidCenters[school];
+            FloatN fromX = Sub(oldPosX, Splat(center.x));
+            FloatN fromY = Sub(oldPosY, Splat(center.y));
+            FloatN fromZ = Sub(oldPosZ, Splat(center.z));
+            const FloatN schoolDist2 = Dot(fromX, fromY, fromZ, fromX, fromY, fromZ);
+            const MaskN wayTooClose = Less(schoolDist2, Splat(0.0001f));
+            const float radius = params.m_avoidRadii[school];
+            const MaskN inside = AndNot(LessEqual(schoolDist2, Splat(radius * radius)), wayTooClose);
+
+            const FloatN schoolDist = Sqrt(schoolDist2);
+            fromX = Div(fromX, schoolDist);
+            fromY = Div(fromY, schoolDist);
+            fromZ = Div(fromZ, schoolDist);
+            Normalize(fromX, fromY, fromZ);
+            const FloatN weight = Splat(params.m_avoidWeights[school]);
+            avoidX = Add(avoidX, Select(inside, Mul(fromX, weight), zero));
+            avoidY = Add(avoidY, Select(inside, Mul(fromY, weight), Select(wayTooClose, Splat(1.0f), zero)));
+            avoidZ = Add(avoidZ, Select(inside, Mul(fromZ, weight), zero));
+        }
+        if (params.m_numSchoolsToAvoid > 0)
+        {
+            const FloatN numSchools = Splat((float)params.m_numSchoolsToAvoid);
+            avoidX = Div(avoidX, numSchools);
+            avoidY = Div(avoidY, numSchools);
+            avoidZ = Div(avoidZ, numSchools);
+        }
+
+        const FloatN offsetX = Sub(oldPosX, centroidX);
+        const FloatN offsetY = Sub(oldPosY, centroidY);
+        const FloatN offsetZ = Sub(oldPosZ, centroidZ);
+        sumDistance2 = Add(sumDistance2, Select(valid, Dot(offsetX, offsetY, offsetZ, offsetX, offsetY, offsetZ), zero));
+
+        // Move along our current heading before working out the new one
+        const FloatN step = Mul(oldSpeed, frameTime);
+        const FloatN posX = Add(oldPosX, Mul(step, oldHeadX));
+        const FloatN posY = Max(Add(oldPosY, Mul(step, oldHeadY)), Splat(params.m_minHeight));
+        const FloatN posZ = Add(oldPosZ, Mul(step, oldHeadZ));
+
+        // Combine all of the "forces" into the new driving vector.  Repulsion
+        // overrides alignment and cohesion.
+        const FloatN goalScale = Splat(params.m_goalScale);
+        FloatN desiredX = Mul(goalHeadX, goalScale);
+        FloatN desiredY = Mul(goalHeadY, goalScale);
+        FloatN desiredZ = Mul(goalHeadZ, goalScale);
+        {
+            const MaskN repulsing = Greater(Load(&steering.m_repulsionCount[first]), zero);
+            const FloatN repulsionScale = Splat(params.m_repulsionScale);
+            const FloatN repulsedX = Add(desiredX, Mul(Load(&steering.m_repulsionX[first]), repulsionScale));
+            const FloatN repulsedY = Add(desiredY, Mul(Load(&steering.m_repulsionY[first]), repulsionScale));
+            const FloatN repulsedZ = Add(desiredZ, Mul(Load(&steering.m_repulsionZ[first]), repulsionScale));
+
+            FloatN alignX = Load(&steering.m_alignmentX[first]);
+            FloatN alignY = Load(&steering.m_alignmentY[first]);
+            FloatN alignZ = Load(&steering.m_alignmentZ[first]);
+            Normalize(alignX, alignY, alignZ);
+            FloatN cohereX = Load(&steering.m_cohesionX[first]);
+            FloatN cohereY = Load(&steering.m_cohesionY[first]);
+            FloatN cohereZ = Load(&steering.m_cohesionZ[first]);
+            Normalize(cohereX, cohereY, cohereZ);
+            const FloatN alignmentScale = Splat(params.m_alignmentScale);
+            const FloatN cohesionScale = Splat(params.m_cohesionScale);
+            const FloatN flockedX = Add(Add(desiredX, Mul(alignX, alignmentScale)), Mul(cohereX, cohesionScale));
+            const FloatN flockedY = Add(Add(desiredY, Mul(alignY, alignmentScale)), Mul(cohereY, cohesionScale));
+            const FloatN flockedZ = Add(Add(desiredZ, Mul(alignZ, alignmentScale)), Mul(cohereZ, cohesionScale));
+
+            desiredX = Select(repulsing, repulsedX, flockedX);
+            desiredY = Select(repulsing, repulsedY, flockedY);
+            desiredZ = Select(repulsing, repulsedZ, flockedZ);
+        }
+        if (params.m_numSchoolsToAvoid > 0)
+        {
+            const FloatN avoidanceScale = Splat(params.m_schoolAvoidanceScale);
+            desiredX = Add(desiredX, Mul(avoidX, avoidanceScale));
+            desiredY = Add(desiredY, Mul(avoidY, avoidanceScale));
+            desiredZ = Add(desiredZ, Mul(avoidZ, avoidanceScale));
+        }
+
+        // Modify our current heading by the new influences
+        FloatN headX = desiredX, headY = desiredY, headZ = desiredZ;
+        if (params.m_frameInertia > 0.0f)
+        {
+            const FloatN frameInertia = Splat(params.m_frameInertia);
+            headX = Add(oldHeadX, Div(desiredX, frameInertia));
+            headY = Add(oldHeadY, Div(desiredY, frameInertia));
+            headZ = Add(oldHeadZ, Div(desiredZ, frameInertia));
+        }
+        Normalize(headX, headY, headZ);
+
+        // Headings too close to the vertical axis cause rotational instability
+        // in the shader, so bias them towards the goal, then away from the
+        // centroid and finally along a horizontal axis until they aren't
+        MaskN vertical = And(valid, NearlyVertical(headY));
+        if (Any(vertical))
+        {
+            FloatN fixX = Add(headX, Mul(goalHeadX, bias));
+            FloatN fixY = Add(headY, Mul(goalHeadY, bias));
+            FloatN fixZ = Add(headZ, Mul(goalHeadZ, bias));
+            Normalize(fixX, fixY, fixZ);
+            headX = Select(vertical, fixX, headX);
+            headY = Select(vertical, fixY, headY);
+            headZ = Select(vertical, fixZ, headZ);
+
+            vertical = And(vertical, NearlyVertical(headY));
+            if (Any(vertical))
+            {
+                FloatN awayX = Sub(posX, centroidX);
+                FloatN awayY = Sub(posY, centroidY);
+                FloatN awayZ = Sub(posZ, centroidZ);
+                Normalize(awayX, awayY, awayZ);
+                fixX = Add(headX, Mul(awayX, bias));
+                fixY = Add(headY, Mul(awayY, bias));
+                fixZ = Add(headZ, Mul(awayZ, bias));
+                Normalize(fixX, fixY, fixZ);
+                headX = Select(vertical, fixX, headX);
+                headY = Select(vertical, fixY, headY);
+                headZ = Select(vertical, fixZ, headZ);
+
+                vertical = And(vertical, NearlyVertical(headY));
+                if (Any(vertical))
+                {
+                    fixX = headX;
+                    fixY = headY;
+                    fixZ = Add(headZ, Splat(-0.4f));
+                    Normalize(fixX, fixY, fixZ);
+                    headX = Select(vertical, fixX, headX);
+                    headY = Select(vertical, fixY, headY);
+                    headZ = Select(vertical, fixZ, headZ);
+                }
+            }
+        }
+
+        // Speed up or slow down to avoid neighbors, otherwise return to the
+        // cruising speed.  Fish can go from 0 to max speed in 1 second.
+        const FloatN speedChange = Load(&steering.m_speedChange[first]);
+        const FloatN slower = Sub(oldSpeed, speedStep);
+        const FloatN faster = Add(oldSpeed, speedStep);
+        const FloatN cruising = Select(Less(oldSpeed, maxSpeed), Min(faster, maxSpeed),
+                                Select(Greater(oldSpeed, maxSpeed), Max(slower, maxSpeed), oldSpeed));
+        FloatN speed = Select(Greater(speedChange, zero), Min(faster, Splat(params.m_maxAvoidanceSpeed)), cruising);
+        speed = Select(Less(speedChange, zero), Max(slower, Splat(params.m_minAvoidanceSpeed)), speed);
+
+        // Use the speed to make the tail move at a reasonable rate
+        const FloatN animTime = Add(Load(pAnimTimes + first), Mul(Mul(frameTime, speed), speed));
+
+        // Leave the padding past the last fish untouched
+        Store(&fish.m_positionX[first], Select(valid, posX, oldPosX));
+        Store(&fish.m_positionY[first], Select(valid, posY, oldPosY));
+        Store(&fish.m_positionZ[first], Select(valid, posZ, oldPosZ));
+        Store(&fish.m_headingX[first], Select(valid, headX, oldHeadX));
+        Store(&fish.m_headingY[first], Select(valid, headY, oldHeadY));
+        Store(&fish.m_headingZ[first], Select(valid, headZ, oldHeadZ));
+        Store(pSpeeds + first, Select(valid, speed, oldSpeed));
+        Store(pAnimTimes + first, Select(valid, animTime, Load(pAnimTimes + first)));
+
+        sumX = Add(sumX, Select(valid, posX, zero));
+        sumY = Add(sumY, Select(valid, posY, zero));
+        sumZ = Add(sumZ, Select(valid, posZ, zero));
+    }
+
+    positionSum = nv::vec3f(Sum(sumX), Sum(sumY), Sum(sumZ));
+    distance2Sum = Sum(sumDistance2);
+}
@@ -149,30 +149,28 @@ bool School::Initialize(uint32_t index,
         m_schoolGoal.x, m_schoolGoal.y, m_schoolGoal.z);*/
 
     // Initialize the fish book-keeping structures
-    m_fishAnimStates.resize(m_instancesCapacity);
-    m_fishInstanceStates.resize(m_instancesCapacity);
+    m_fish.Resize(m_instancesCapacity);
+    m_fishSpeeds.resize(PaddedFishCount(m_instancesCapacity), 0.0f);
+    m_fishAnimTimes.resize(PaddedFishCount(m_instancesCapacity), 0.0f);
+    m_fishAnimStartOffsets.resize(PaddedFishCount(m_instancesCapacity), 0.0f);
 
     nv::vec3f centroid(0.0f, 0.0f, 0.0f);
 
     for (uint32_t fishIndex = 0; fishIndex < m_instancesActive; ++fishIndex)
     {
-        FishInstanceData& fishInstData = m_fishInstanceStates[fishIndex];
-
-        fishInstData.m_position = ScaledRandomVector(m_flockParams.m_spawnRange);
-        fishInstData.m_position += position;
-        if (fishInstData.m_position.y < m_fishHalfExtents.y)
+        nv::vec3f fishPosition = ScaledRandomVector(m_flockParams.m_spawnRange);
+        fishPosition += position;
+        if (fishPosition.y < m_fishHalfExtents.y)
         {
-            fishInstData.m_position.y = m_fishHalfExtents.y;
+            fishPosition.y = m_fishHalfExtents.y;
         }
-        fishInstData.m_heading = nv::vec3f(0.0f, 0.0f, 1.0f);
-        fishInstData.m_tailTime = 0.0f;
-        fishInstData.m_schoolId = m_index;
+        m_fish.SetPosition(fishIndex, fishPosition);
+        m_fish.SetHeading(fishIndex, nv::vec3f(0.0f, 0.0f, 1.0f));
 
-        FishAnimState& fishAnimState = m_fishAnimStates[fishIndex];
-        fishAnimState.m_speed = 0;
-        fishAnimState.m_animTime = 0.0f;
-        fishAnimState.m_animStartOffset = Random01() * NV_PI * 2.0f;
-        centroid += fishInstData.m_position;
+        m_fishSpeeds[fishIndex] = 0;
+        m_fishAnimTimes[fishIndex] = 0.0f;
+        m_fishAnimStartOffsets[fishIndex] = Random01() * NV_PI * 2.0f;
+        centroid += fishPosition;
     }
     if (m_instancesActive > 0)
     {
@@ -260,16 +258,9 @@ void School::ResetToLocation(const nv::vec3f& loc)
 {
     for (uint32_t fishIndex = 0; fishIndex < m_instancesActive; ++fishIndex)
     {
-        FishInstanceData& fishInstData = m_fishInstanceStates[fishIndex];
-        
-        fishInstData.m_position = ScaledRandomVector(m_flockParams.m_spawnRange);
-        fishInstData.m_position += loc;
-        fishInstData.m_heading = ScaledRandomVector(1.0f);
-        fishInstData.m_tailTime = 0.0f;
-        fishInstData.m_schoolId = m_index;
-    
-        FishAnimState& fishAnimState = m_fishAnimStates[fishIndex];
-        fishAnimState.m_speed = 0;
+        m_fish.SetPosition(fishIndex, ScaledRandomVector(m_flockParams.m_spawnRange) + loc);
+        m_fish.SetHeading(fishIndex, ScaledRandomVector(1.0f));
+        m_fishSpeeds[fishIndex] = 0;
     }
     m_lastCentroid = loc;
     m_schoolGoal = loc;
@@ -330,8 +321,6 @@ bool School::SetModel(Nv::NvModelExtGL* pModel,
     return true;
 }
 
-uint32_t neighborOffset = 0;
-uint32_t neighborSkip = 1;
 
 void School::Animate(float frameTime, SchoolStateManager* pStateManager, bool avoid)
 {
@@ -364,276 +353,184 @@ void School::Animate(float frameTime, SchoolStateManager* pStateManager, bool av
     float neighborDistance2 =
         m_flockParams.m_neighborDistance * m_flockParams.m_neighborDistance;
 
-    uint32_t numSchools = pStateManager->GetNumReadStates();
     SchoolState* pSchools = pStateManager->GetReadStates();
 
     // We will avoid, at most, 8 other schools
-    const uint32_t cMaxSchoolsToAvoid = 8;
+    const uint32_t cMaxSchoolsToAvoid = FishIntegrationParams::cMaxSchoolsToAvoid;
     uint32_t schoolsToAvoid[cMaxSchoolsToAvoid];
     uint32_t numSchoolsToAvoid = 0;
     
     SchoolState* pSchool = pSchools;
     if (avoid) 
     {
-        // Find schools that are at least as aggressive as our school, and overlap our school
-        for (uint32_t schoolIndex = 0; (schoolIndex < numSchools) && (numSchoolsToAvoid < cMaxSchoolsToAvoid); ++schoolIndex, ++pSchool)
-        {
-            if (schoolIndex == m_index)
-            {
-                // Don't avoid ourself
-                continue;
-            }
-
-            // Should we avoid the school?
-            if (pSchool->m_aggression < m_flockParams.m_aggression)
-            {
-                // No.
-                continue;
-            }
-
-            nv::vec3f toSchool = pSchool->m_center - m_lastCentroid;
-            float schoolDist2 = nv::square_norm(toSchool);
-            float sumRadii = pSchool->m_radius + m_lastRadius;  // Add some buffer distance of avoidance?
-
-            if (schoolDist2 < (sumRadii * sumRadii))
-            {
-                schoolsToAvoid[numSchoolsToAvoid] = schoolIndex;
-                ++numSchoolsToAvoid;
-            }
-        }
-    }
-
-    int32_t clampedNeighborOffset = neighborOffset % m_instancesActive;
-
-    for (uint32_t fishIndex = 0; fishIndex < m_instancesActive; ++fishIndex)
-    {
-        FishInstanceData& fishInstData = m_fishInstanceStates[fishIndex];
-        nv::vec3f goalHeading = nv::normalize(m_schoolGoal - fishInstData.m_position);
-        nv::vec3f alignmentSum(0.0f, 0.0f, 0.0f);
-        uint32_t alignmentCount = 0;
-        nv::vec3f repulsionSum(0.0f, 0.0f, 0.0f);
-        uint32_t repulsionCount = 0;
-        uint32_t accelerateCount = 0;
-        uint32_t decelerateCount = 0;
-        nv::vec3f cohesionSum(0.0f, 0.0f, 0.0f);
-        uint32_t cohesionCount = 0;
-
-        uint32_t neighborIndex = clampedNeighborOffset;
-        uint32_t skip = 6 - neighborSkip;
-        for (; neighborIndex < m_instancesActive; neighborIndex += skip)
+        // Find schools that are at least as aggressive as our school, and overlap our school.
+        // Only the schools with centers within our radius plus the largest radius can overlap
+        // us, so just those are looked up in the index of the school centers.  The ones with
+        // the lowest indices are kept.
+        const uint32_t* pSortedSchools = pStateManager->GetReadGrid().GetSortedIndices();
+        float searchRadius = m_lastRadius + pStateManager->GetMaxReadRadius();
+        pStateManager->GetReadGrid().Query(m_lastCentroid, searchRadius,
+            [&](uint32_t slotBegin, uint32_t slotEnd)
         {
-            if (neighborIndex == fishIndex) continue;
-            FishInstanceData& neighbor = m_fishInstanceStates[neighborIndex];
-            nv::vec3f deltaPos = neighbor.m_position - fishInstData.m_position;
-            float dist2 = nv::dot(deltaPos, deltaPos);
-            if (dist2 <= neighborDistance2)
+            for (uint32_t slot = slotBegin; slot < slotEnd; ++slot)
             {
-                // It's too close, so we need to avoid
-                float dist = sqrt(dist2);
-
-                // If we're so close that we can't get a good normalized direction, then speed up or slow
-                // down.  Just to make sure they don't choose to do the same thing, we'll use the
-                // order of their indices to choose which to do.
-                if (dist < 0.001f)
+                uint32_t schoolIndex = pSortedSchools[slot];
+                if (schoolIndex == m_index)
                 {
-                    // The first one will accelerate
-                    if (fishIndex > neighborIndex)
-                    {
-                        ++decelerateCount;
-                    }
-                    else
-                    {
-                        ++accelerateCount;
-                    }
+                    // Don't avoid ourself
+                    continue;
                 }
-                else
+
+                // Should we avoid the school?
+                SchoolState* pOtherSchool = pSchools + schoolIndex;
+                if (pOtherSchool->m_aggression < m_flockParams.m_aggression)
                 {
-                    // If our neighbor is to the side of use, we'll 
-                    // use repulsion to move away.  If he's in front of
-                    // or behind us, we'll decelerate or accelerate to
-                    // move away, respectively.
-                    nv::vec3f deltaNorm = deltaPos / dist;
-                    float dotPosition = nv::dot(fishInstData.m_heading, deltaNorm);
-                    if (dotPosition > 0.95f)
-                    {
-                        // Neighbor is forward
-                        ++decelerateCount;
-                    }
-                    else if (dotPosition < -0.95f)
-                    {
-                        // Neighbor is behind
-                        ++accelerateCount;
-                    }
-                    else
-                    {
-                        // Neighbor is to side
-                        repulsionSum -= deltaNorm;
-                        ++repulsionCount;
-                    }
+                    // No.
+                    continue;
                 }
-            }
-            else if (dist2 > (neighborDistance2 * 2.0f))
-            {
-                // It's far enough away that we should head towards him
-                cohesionSum += deltaPos;
-                ++cohesionCount;
-            }
-            else
-            {
-                // It's far enough to not need to avoid but close enough to not need to swim
-                // towards, so just try to go the same direction
-                alignmentSum += neighbor.m_heading;
-                ++alignmentCount;
-            }
-        }
-        nv::vec3f avoidanceVec(0.0f, 0.0f, 0.0f);
-        if (avoid) {
-            if (numSchoolsToAvoid > 0)
-            {
-                for (uint32_t avoidSchoolIndex = 0; avoidSchoolIndex < numSchoolsToAvoid; ++avoidSchoolIndex)
-                {
-                    // Get a pointer to the school state for the school we're avoiding
-                    pSchool = pSchools + schoolsToAvoid[avoidSchoolIndex];
 
-                    nv::vec3f fromSchool = fishInstData.m_position - pSchool->m_center;
-                    float schoolDist2 = nv::square_norm(fromSchool);
-                    if (schoolDist2 < 0.0001f)
+                nv::vec3f toSchool = pOtherSchool->m_center - m_lastCentroid;
+                float schoolDist2 = nv::square_norm(toSchool);
+                float sumRadii = pOtherSchool->m_radius + m_lastRadius;  // Add some buffer distance of avoidance?
+
+                if (schoolDist2 < (sumRadii * sumRadii))
+                {
+                    // Insert in index order, dropping the highest index when full
+                    uint32_t insertAt = numSchoolsToAvoid;
+                    while ((insertAt > 0) && (schoolsToAvoid[insertAt - 1] > schoolIndex))
                     {
-                        // Way too close
-                        avoidanceVec += nv::vec3f(0.0f, 1.0f, 0.0f);
+                        --insertAt;
                     }
-                    else if (schoolDist2 <= (pSchool->m_radius * pSchool->m_radius))
+                    if (insertAt < cMaxSchoolsToAvoid)
                     {
-                        avoidanceVec += nv::normalize(fromSchool / sqrt(schoolDist2)) * (pSchool->m_aggression - m_flockParams.m_aggression + 0.1f);
+                        uint32_t last = (numSchoolsToAvoid < cMaxSchoolsToAvoid) ? numSchoolsToAvoid : (cMaxSchoolsToAvoid - 1);
+                        for (uint32_t i = last; i > insertAt; --i)
+                        {
+                            schoolsToAvoid[i] = schoolsToAvoid[i - 1];
+                        }
+                        schoolsToAvoid[insertAt] = schoolIndex;
+                        if (numSchoolsToAvoid < cMaxSchoolsToAvoid)
+                        {
+                            ++numSchoolsToAvoid;
+                        }
                     }
                 }
-                avoidanceVec /= numSchoolsToAvoid;
             }
-        }
-        // Add the distance between our last position and our last centroid, squared, to the
-        // calculation for the new radius squared
-        float distFromCentroid2 = nv::square_norm(fishInstData.m_position - m_lastCentroid);
-        newRadius2 += distFromCentroid2;
-
-        // Update our position with our current heading and speed before
-        // calculating new values
-        FishAnimState& fishAnimState = m_fishAnimStates[fishIndex];
-        fishInstData.m_position += fishAnimState.m_speed * frameTime * fishInstData.m_heading;
-        if (fishInstData.m_position.y < m_fishHalfExtents.y)
-        {
-            fishInstData.m_position.y = m_fishHalfExtents.y;
-        }
+        });
+    }
 
-        // Combine all of our "forces" into our new driving vector
-        nv::vec3f desiredHeading = (goalHeading * m_flockParams.m_goalScale);
-        // Repulsion overrides everything
-        if (repulsionCount > 0)
-        {
-            desiredHeading += repulsionSum * m_flockParams.m_repulsionScale;
-        }
-        else
-        {
-            // Alignment and cohesion can work together
-            desiredHeading += nv::normalize(alignmentSum) * m_flockParams.m_alignmentScale;
-            desiredHeading += nv::normalize(cohesionSum) * m_flockParams.m_cohesionScale;
-        }
+    // Bin the fish by position so that each one only visits the fish close enough
+    // to avoid or to align with.  Every fish further away adds its offset to the
+    // cohesion, so the cohesion is found from the sum of all of the positions minus
+    // the visited ones.  The sums are taken relative to the last centroid to keep
+    // their precision.  Neighbors are seen as they were at the start of the frame.
+    float alignmentDistance2 = neighborDistance2 * 2.0f;
+    float alignmentDistance = sqrt(alignmentDistance2) * 1.0001f;
+    m_neighborGrid.Build(m_fish.m_positionX.data(), m_fish.m_positionY.data(), m_fish.m_positionZ.data(),
+        m_instancesActive, sizeof(float), alignmentDistance);
+    m_neighbors.Resize(m_instancesActive);
+    m_neighborIndices.resize(PaddedFishCount(m_instancesActive), 0.0f);
+    m_steering.Resize(m_instancesActive);
+
+    const uint32_t* pSortedIndices = m_neighborGrid.GetSortedIndices();
+    nv::vec3f offsetSum(0.0f, 0.0f, 0.0f);
+    for (uint32_t slot = 0; slot < m_instancesActive; ++slot)
+    {
+        const uint32_t fishIndex = pSortedIndices[slot];
+        const nv::vec3f position = m_fish.GetPosition(fishIndex);
+        m_neighbors.SetPosition(slot, position);
+        m_neighbors.SetHeading(slot, m_fish.GetHeading(fishIndex));
+        m_neighborIndices[slot] = (float)fishIndex;
+        offsetSum += position - m_lastCentroid;
+    }
 
-        if (avoid) {
-            // Always try to avoid other schools, if necessary
-            desiredHeading += avoidanceVec * m_flockParams.m_schoolAvoidanceScale;
-        }
+    NeighborSearch search;
+    search.m_pNeighbors = &m_neighbors;
+    search.m_pNeighborIndices = m_neighborIndices.data();
+    search.m_origin = m_lastCentroid;
+    search.m_repulsionDistance2 = neighborDistance2;
+    search.m_alignmentDistance2 = alignmentDistance2;
 
-        // Modify our current heading by the new influences
-        if (frameInertia <= 0.0f)
-        {
-            fishInstData.m_heading = nv::normalize(desiredHeading);
-        }
-        else
-        {
-            fishInstData.m_heading = nv::normalize(fishInstData.m_heading + (desiredHeading / frameInertia));
-        }
-
-        // Headings too close to the vertical axis will cause rotational instability
-        // in the shader, and possibly collapse of the reconstructed transform.
-        // check to see if we're too close to the vertical, and if so, then try to
-        // move in a reasonable direction away from it
-        float vertical = nv::dot(fishInstData.m_heading, nv::vec3f(0.0f, 1.0f, 0.0f));
-        if (vertical > 0.999f || vertical < -0.999f)
+    for (uint32_t fishIndex = 0; fishIndex < m_instancesActive; ++fishIndex)
+    {
+        const nv::vec3f position = m_fish.GetPosition(fishIndex);
+        const nv::vec3f heading = m_fish.GetHeading(fishIndex);
+
+        // Gather the rows of cells around the fish, so that the kernel can
+        // sum them several neighbors at a time
+        const uint32_t cMaxRanges = 16;
+        uint32_t ranges[cMaxRanges * 2];
+        uint32_t numRanges = 0;
+        NeighborSums sums;
+        m_neighborGrid.Query(position, alignmentDistance, [&](uint32_t slotBegin, uint32_t slotEnd)
         {
-            // Try biasing our heading toward the goal.  
-            fishInstData.m_heading = nv::normalize(fishInstData.m_heading + (goalHeading * 0.2f));
-
-            // Test the new vector
-            vertical = nv::dot(fishInstData.m_heading, nv::vec3f(0.0f, 1.0f, 0.0f));
-            if (vertical > 0.999f || vertical < -0.999f)
+            if (numRanges == cMaxRanges)
             {
-                // also head away from the centroid.
-
-                fishInstData.m_heading = nv::normalize(fishInstData.m_heading +
-                    (nv::normalize(fishInstData.m_position - m_lastCentroid) * 0.2f));
-
-                // Test the new vector
-                vertical = nv::dot(fishInstData.m_heading, nv::vec3f(0.0f, 1.0f, 0.0f));
-                if (vertical > 0.999f || vertical < -0.999f)
-                {
-                    // Still not good? Bias it by a horizontal axis.  It won't look good, but
-                    // it's better than nothing.
-                    fishInstData.m_heading = nv::normalize(
-                        fishInstData.m_heading + nv::vec3f(0.0f, 0.0f, -0.4f));
-                }
+                AccumulateNeighbors(search, fishIndex, position, heading, ranges, numRanges, sums);
+                numRanges = 0;
             }
-        }
-
-        // Accelerate if necessary
-        // Assume that acceleration == speed/second
-        // (i.e. fish can go from 0 to max speed in 1 second)
-        if (decelerateCount > accelerateCount)
+            ranges[numRanges * 2] = slotBegin;
+            ranges[numRanges * 2 + 1] = slotEnd;
+            ++numRanges;
+        });
+        AccumulateNeighbors(search, fishIndex, position, heading, ranges, numRanges, sums);
+
+        // Head towards every fish that wasn't close enough to visit
+        uint32_t cohesionCount = m_instancesActive - 1 - sums.m_nearCount;
+        nv::vec3f offset = position - m_lastCentroid;
+        nv::vec3f cohesionSum = (offsetSum - offset - sums.m_nearOffset) - offset * (float)cohesionCount;
+
+        m_steering.m_repulsionX[fishIndex] = sums.m_repulsion.x;
+        m_steering.m_repulsionY[fishIndex] = sums.m_repulsion.y;
+        m_steering.m_repulsionZ[fishIndex] = sums.m_repulsion.z;
+        m_steering.m_alignmentX[fishIndex] = sums.m_alignment.x;
+        m_steering.m_alignmentY[fishIndex] = sums.m_alignment.y;
+        m_steering.m_alignmentZ[fishIndex] = sums.m_alignment.z;
+        m_steering.m_cohesionX[fishIndex] = cohesionSum.x;
+        m_steering.m_cohesionY[fishIndex] = cohesionSum.y;
+        m_steering.m_cohesionZ[fishIndex] = cohesionSum.z;
+        m_steering.m_repulsionCount[fishIndex] = (float)sums.m_repulsionCount;
+        if (sums.m_decelerateCount > sums.m_accelerateCount)
         {
             // Decelerate to avoid fish in front
-            fishAnimState.m_speed -= m_flockParams.m_maxSpeed * frameTime;
-            if (fishAnimState.m_speed < minAvoidanceSpeed)
-            {
-                fishAnimState.m_speed = minAvoidanceSpeed;
-            }
+            m_steering.m_speedChange[fishIndex] = -1.0f;
         }
-        else if (accelerateCount > 0)
+        else if (sums.m_accelerateCount > 0)
         {
-            // Assume that speed == acceleration 
-            // (i.e. fish can go from 0 to max speed in 1 second)
-            fishAnimState.m_speed += m_flockParams.m_maxSpeed * frameTime;
-            if (fishAnimState.m_speed > maxAvoidanceSpeed)
-            {
-                fishAnimState.m_speed = maxAvoidanceSpeed;
-            }
-        }
-        else if (fishAnimState.m_speed < m_flockParams.m_maxSpeed)
-        {
-            // Accelerate to maximum cruising speed
-            fishAnimState.m_speed += m_flockParams.m_maxSpeed * frameTime;
-            if (fishAnimState.m_speed > m_flockParams.m_maxSpeed)
-            {
-                fishAnimState.m_speed = m_flockParams.m_maxSpeed;
-            }
+            m_steering.m_speedChange[fishIndex] = 1.0f;
         }
-        else if (fishAnimState.m_speed > m_flockParams.m_maxSpeed)
+        else
         {
-            // Decelerate to maximum cruising speed
-            fishAnimState.m_speed -= m_flockParams.m_maxSpeed * frameTime;
-            if (fishAnimState.m_speed < m_flockParams.m_maxSpeed)
-            {
-                fishAnimState.m_speed = m_flockParams.m_maxSpeed;
-            }
+            m_steering.m_speedChange[fishIndex] = 0.0f;
         }
+    }
 
-        // Increase our animation time, using our current speed to make the 
-        // tail move at a reasonable rate
-        fishAnimState.m_animTime += frameTime * fishAnimState.m_speed * fishAnimState.m_speed;
-        fishInstData.m_tailTime = fishAnimState.m_animStartOffset + fishAnimState.m_animTime;
-
-        // Add our new position to the calculation of the school centroid for
-        // this frame
-        newCentroid += fishInstData.m_position;
+    // Steer and move all of the fish
+    FishIntegrationParams params;
+    params.m_frameTime = frameTime;
+    params.m_frameInertia = frameInertia;
+    params.m_goal = m_schoolGoal;
+    params.m_lastCentroid = m_lastCentroid;
+    params.m_minHeight = m_fishHalfExtents.y;
+    params.m_goalScale = m_flockParams.m_goalScale;
+    params.m_alignmentScale = m_flockParams.m_alignmentScale;
+    params.m_repulsionScale = m_flockParams.m_repulsionScale;
+    params.m_cohesionScale = m_flockParams.m_cohesionScale;
+    params.m_schoolAvoidanceScale = m_flockParams.m_schoolAvoidanceScale;
+    params.m_maxSpeed = m_flockParams.m_maxSpeed;
+    params.m_minAvoidanceSpeed = minAvoidanceSpeed;
+    params.m_maxAvoidanceSpeed = maxAvoidanceSpeed;
+    params.m_numSchoolsToAvoid = numSchoolsToAvoid;
+    for (uint32_t avoidSchoolIndex = 0; avoidSchoolIndex < numSchoolsToAvoid; ++avoidSchoolIndex)
+    {
+        pSchool = pSchools + schoolsToAvoid[avoidSchoolIndex];
+        params.m_avoidCenters[avoidSchoolIndex] = pSchool->m_center;
+        params.m_avoidRadii[avoidSchoolIndex] = pSchool->m_radius;
+        params.m_avoidWeights[avoidSchoolIndex] = pSchool->m_aggression - m_flockParams.m_aggression + 0.1f;
     }
+    IntegrateFish(params, m_steering, m_fish, m_fishSpeeds.data(), m_fishAnimTimes.data(),
+        m_instancesActive, newCentroid, newRadius2);
+
     // Update our centroid based on the school's fish positions
     m_lastCentroid = newCentroid / m_instancesActive;
 
@@ -678,7 +575,16 @@ void School::UpdateInstanceDataBuffer()
         m_pInstanceData->EndUpdate();
         return;
     }
-    memcpy(pCurrInstance, &m_fishInstanceStates[0], sizeof(FishInstanceData) * m_instancesActive);
+
+    // Interleave the fish state straight into the mapped buffer, writing each
+    // instance in order since the mapping may be write-combined
+    for (uint32_t fishIndex = 0; fishIndex < m_instancesActive; ++fishIndex, ++pCurrInstance)
+    {
+        pCurrInstance->m_position = m_fish.GetPosition(fishIndex);
+        pCurrInstance->m_heading = m_fish.GetHeading(fishIndex);
+        pCurrInstance->m_tailTime = m_fishAnimStartOffsets[fishIndex] + m_fishAnimTimes[fishIndex];
+        pCurrInstance->m_schoolId = m_index;
+    }
     m_pInstanceData->EndUpdate();
 }
 
@@ -38,6 +38,8 @@
 //#include "NvGLUtils/NvSimpleUBO.h"
 #include "NvGLUtils/NvModelExtGL.h"
 #include "VertexFormatBinder.h"
+#include "SpatialGrid.h"
+#include "FlockingKernels.h"
 
 #include "NvSharedVBOGL_MappedSubRanges.h"
 #include "NvSharedVBOGL_Orphaning.h"
@@ -361,10 +363,9 @@ private:
         float     m_tailTime;
         uint32_t  m_schoolId;
     };
-    typedef std::vector<FishInstanceData> FishInstanceDataSet;
-    /// Portion of the current state of the fish that will be copied to the
-    /// instance data buffer
-    FishInstanceDataSet m_fishInstanceStates;
+
+    /// Current positions and headings of the fish in the school
+    FishVectors m_fish;
 
     /// Uniform buffer object providing school-specific parameters to the
     /// shader
@@ -395,17 +396,21 @@ private:
 
     SchoolFlockingParams m_flockParams;
 
-    /// Current animation state of each fish in the school
-    struct FishAnimState
-    {
-        float m_speed;
-        float m_animTime;
-        float m_animStartOffset;
-    };
-    typedef std::vector<FishAnimState> FishAnimStateSet;
-    /// Portion of the current state of the fish that has to do
-    /// with animation and won't be used in the instance data buffer
-    FishAnimStateSet m_fishAnimStates;
+    /// Current animation state of each fish in the school, padded like m_fish
+    std::vector<float> m_fishSpeeds;
+    std::vector<float> m_fishAnimTimes;
+    std::vector<float> m_fishAnimStartOffsets;
+
+    /// Spatial index of the fish, rebuilt each frame to find their neighbors
+    SpatialGrid m_neighborGrid;
+
+    /// Positions, headings and indices of the fish at the start of the frame,
+    /// in the order of the slots of m_neighborGrid
+    FishVectors m_neighbors;
+    std::vector<float> m_neighborIndices;
+
+    /// Influence of each fish's neighbors, found at the start of Animate
+    FishSteering m_steering;
 
     /// Thread safe Random number generation
     uint32_t m_rndState;
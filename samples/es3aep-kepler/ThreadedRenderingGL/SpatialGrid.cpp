@@ -0,0 +1,136 @@
+//----------------------------------------------------------------------------------
+// File:        es3aep-kepler\ThreadedRenderingGL/SpatialGrid.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "SpatialGrid.h"
+
+SpatialGrid::SpatialGrid()
+    : m_origin(0.0f, 0.0f, 0.0f)
+    , m_invCellSize(1.0f)
+{
+    m_dims[0] = m_dims[1] = m_dims[2] = 1;
+    m_cellStarts.resize(2, 0);
+}
+
+void SpatialGrid::Build(const float* pX, const float* pY, const float* pZ,
+                        uint32_t count, uint32_t stride, float cellSize)
+{
+    const uint8_t* pBytes[3] = { (const uint8_t*)pX, (const uint8_t*)pY, (const uint8_t*)pZ };
+
+    m_sortedIndices.resize(count);
+    m_pointCells.resize(count);
+
+    nv::vec3f minCorner(0.0f, 0.0f, 0.0f);
+    nv::vec3f maxCorner(0.0f, 0.0f, 0.0f);
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        if (count > 0)
+        {
+            minCorner[axis] = maxCorner[axis] = *(const float*)pBytes[axis];
+        }
+        for (uint32_t i = 1; i < count; ++i)
+        {
+            const float coord = *(const float*)(pBytes[axis] + i * stride);
+            minCorner[axis] = (coord < minCorner[axis]) ? coord : minCorner[axis];
+            maxCorner[axis] = (coord > maxCorner[axis]) ? coord : maxCorner[axis];
+        }
+    }
+    const nv::vec3f extent = maxCorner - minCorner;
+
+    // Keep the number of cells in proportion to the number of points, so that
+    // a few stray points can't make the grid huge
+    const double maxCells = (count < 32) ? 64.0 : 2.0 * count;
+    if (cellSize < 1.0e-4f)
+    {
+        cellSize = 1.0e-4f;
+    }
+    for (;;)
+    {
+        double numCells = 1.0;
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            numCells *= floor(extent[axis] / cellSize) + 1.0;
+        }
+        if (numCells <= maxCells)
+        {
+            break;
+        }
+        cellSize *= 2.0f;
+    }
+
+    m_origin = minCorner;
+    m_invCellSize = 1.0f / cellSize;
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        m_dims[axis] = (int32_t)(extent[axis] * m_invCellSize) + 1;
+    }
+    const uint32_t numCells = (uint32_t)(m_dims[0] * m_dims[1] * m_dims[2]);
+
+    // Counting sort of the points by cell
+    m_cellStarts.assign(numCells + 1, 0);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        int32_t cell[3];
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            const float coord = *(const float*)(pBytes[axis] + i * stride);
+            cell[axis] = (int32_t)((coord - m_origin[axis]) * m_invCellSize);
+            if (cell[axis] >= m_dims[axis])
+            {
+                cell[axis] = m_dims[axis] - 1;
+            }
+        }
+        const uint32_t cellIndex = (uint32_t)((cell[2] * m_dims[1] + cell[1]) * m_dims[0] + cell[0]);
+        m_pointCells[i] = cellIndex;
+        ++m_cellStarts[cellIndex];
+    }
+
+    uint32_t slot = 0;
+    for (uint32_t cellIndex = 0; cellIndex < numCells; ++cellIndex)
+    {
+        const uint32_t cellCount = m_cellStarts[cellIndex];
+        m_cellStarts[cellIndex] = slot;
+        slot += cellCount;
+    }
+
+    // Placing the points advances each cell's start to the next cell's start,
+    // so shift them back afterwards
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        m_sortedIndices[m_cellStarts[m_pointCells[i]]++] = i;
+    }
+    for (uint32_t cellIndex = numCells; cellIndex > 0; --cellIndex)
+    {
+        m_cellStarts[cellIndex] = m_cellStarts[cellIndex - 1];
+    }
+    m_cellStarts[0] = 0;
+}
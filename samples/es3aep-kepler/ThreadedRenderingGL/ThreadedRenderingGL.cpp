@@ -47,6 +47,7 @@
 #include "NvAssert.h"
 #include "BindlessTextureHelper.h"
 #include <NvUI/NvBitFont.h>
+#include <NsThread.h>
 
 #include <stdint.h>
 
@@ -55,7 +56,6 @@
 #define ARRAY_SIZE(a) ( sizeof(a) / sizeof( (a)[0] ))
 #define NV_UNUSED( variable ) ( void )( variable )
 
-#define USE_STATIC_THREAD_WORK 1
 #define SIMPLE_DEMO 1
 #define STRESS_TEST 0
 
@@ -68,6 +68,7 @@
 #else
 #define MAX_SCHOOL_COUNT 5000
 #endif
+#define MIN_SCHOOL_COUNT 8
 
 #if STRESS_TEST
 #define SCHOOL_COUNT MAX_SCHOOL_COUNT
@@ -79,154 +80,23 @@
 
 uint32_t s_threadMask = 0;
 
-extern uint32_t neighborOffset;
-extern uint32_t neighborSkip;
-
-// Global function to pass to each animation worker thread which will extract the
-// ThreadData from the argument passed in and use that to invoke the actual
-// animate function on the application instance
-#ifdef WIN32
-DWORD WINAPI animateJobFunctionThunk(VOID *arg)
-#else
-void* animateJobFunctionThunk(void *arg)
-#endif
+void ThreadedRenderingGL::animateSchoolsJob(void* app, uint32_t begin, uint32_t end,
+    uint32_t threadIndex)
 {
-    ThreadedRenderingGL::ThreadData* data = (ThreadedRenderingGL::ThreadData*)arg;
-    data->m_app->animateJobFunction(data->m_index);
-
-    return 0;
-}
-
-void ThreadedRenderingGL::animateJobFunction(uint32_t threadIndex)
-{
-    NvThreadManager* threadManager = getThreadManagerInstance();
-    NV_ASSERT(nullptr != threadManager);
-
-    // Our m_running member gives us a mechanism to signal all worker threads
-    // to quit when we need to shut them all down
-    while (m_running) {
-        // We use the m_frameStartCV condition variable to wake threads up 
-        // and notify them that there is work available to be done.  The 
-        // condition variable is protected by the m_frameStartLock mutex.
-        m_frameStartLock->lockMutex();
-        {
-            // Sleep the thread until there is work to be done
-            m_frameStartCV->waitConditionVariable(
-                m_frameStartLock);
-
-            // See if we were told to stop running while we
-            // were sleeping
-            if (!m_running) 
-            {
-                // Yes, so release the mutex and pop out of our loop to exit
-                m_frameStartLock->unlockMutex();
-                break;
-            }
-            // m_activeThreads controls how many threads will actually run in 
-            // a frame.  
-            if (threadIndex >= m_activeThreads)	
-            {
-                // Our index is too high, then we need to go back to 
-                // sleep for this frame by returning to the top of the
-                // loop and waiting on the next frame to start.  Don't
-                // forget to unlock the Mutex, though, as we'll lock
-                // it at the start of the frame.
-                m_frameStartLock->unlockMutex();
-                continue;
-            }
-        }
-        // We have work to do, but it's independent of other threads, so we 
-        // don't need the frame start mutex anymore.
-        m_frameStartLock->unlockMutex();
-        uint32_t schoolsDone = 0;
+    ThreadedRenderingGL* pApp = (ThreadedRenderingGL*)app;
 
-        {
-            CPU_TIMER_SCOPE(CPU_TIMER_THREAD_BASE_TOTAL + threadIndex);
-            // Quick debugging helper so that we can quickly see which threads 
-            // activated this frame.
-            s_threadMask |= 1 << threadIndex; 
-
-            // There are two ways that we can dole out work to be done by the threads:
-            //    1) Each thread is given (number of schools / number of threads) to
-            //       process and simply loops over its range of schools, updating
-            //       the shared count of updated schools once, after all have been updated
-            //    2) Each thread pulls a single school off of the work queue and
-            //       updates it, then grabs the next one, repeating this process 
-            //       until the "Needs Update" queue is empty, updating the shared
-            //       count of updated schools after each one
-
-#ifdef USE_STATIC_THREAD_WORK
-            // In the first method, there is less contention for the frame start mutex
-            // and there is no need for the "Needs Update" queue at all.  Also, there
-            // are less waits between updating each school.  However, this results in 
-            // less efficient thread utilization if the number of fish in each school is
-            // different (i.e. each school has a different amount of work to do during
-            // its update).  In our fixed school size case, this is not an issue, so 
-            // thread utilization should not be significantly impacted.
-            ThreadData& me = m_threads[threadIndex];
-
-            schoolsDone = me.m_schoolCount;
-            if (!m_animPaused || m_bForceSchoolUpdate)
-            {
-                ThreadData& thread = m_threads[threadIndex];
-                uint32_t schoolMax = me.m_baseSchoolIndex + schoolsDone;
-                for (uint32_t i = me.m_baseSchoolIndex; i < schoolMax; i++) 
-                {
-                    updateSchool(threadIndex, i, m_schools[i]);
-                }
-            }
+    NvCPUTimerScope cpuTimer(&pApp->m_CPUTimers[CPU_TIMER_THREAD_BASE_TOTAL + threadIndex]);
+    // Quick debugging helper so that we can quickly see which threads 
+    // activated this frame.
+    s_threadMask |= 1 << threadIndex; 
 
-#else
-            // In the second method, we need to synchronize access to the "Needs 
-            // Update" queue that contains all of the schools that still need
-            // to be updated.  This can result in contention for that resource,
-            // thus more waiting, but if the workload for each school varies from
-            // that of other schools, it can result in higher thread utilization.
-            m_needsUpdateQueueLock->lockMutex();
-            while (m_running && !m_needsUpdateQueue.empty())
-            { 
-                job = m_needsUpdateQueue.front();
-                m_needsUpdateQueue.pop_front();
-                m_needsUpdateQueueLock->unlockMutex();
-
-                //ANIMATE
-#if FISH_DEBUG
-                LOGI("Thread %d animating school %d...\n", threadIndex, job.index);
-#endif
-
-                if (!m_animPaused || m_bForceSchoolUpdate)
-                {
-                    updateSchool(threadIndex, job.index, job.school);
-                }
-
-                schoolsDone++;
-
-#if FISH_DEBUG
-                LOGI("Thread %d animated school %d.\n", threadIndex, job.index);
-#endif
-
-                m_needsUpdateQueueLock->lockMutex();
-            }
-            m_needsUpdateQueueLock->unlockMutex();
-#endif
-
-            // Increment our m_doneCount by the number of schools that we've 
-            // updated, making sure to synchronize access of the value with
-            // our other worker threads.
-            {
-                m_doneCountLock->lockMutex();
-                {
-                    m_doneCount += schoolsDone;
-                    // Notify the main thread that more schools are finished 
-                    // so that it can decide if it's time to render them
-                    m_doneCountCV->signalConditionVariable();
-                }
-                m_doneCountLock->unlockMutex();
-            }
-        }
+    // The job system splits the range of schools in halves as idle threads
+    // steal them, so threads that finish early take work from the others
+    // rather than waiting, even if the schools differ in cost.
+    for (uint32_t i = begin; i < end; i++) 
+    {
+        pApp->updateSchool(threadIndex, i, pApp->m_schools[i]);
     }
-
-    LOGI("Thread %d Exit.\n", threadIndex);
 }
 
 class ThreadedRenderingModelLoader : public Nv::NvModelFileLoader
@@ -240,6 +110,14 @@ public:
         return NvAssetLoaderRead(fileName, length);
     }
 
+    virtual char* LoadDataFromFileWithSize(const char* fileName, size_t& size)
+    {
+        int32_t length;
+        char* pData = NvAssetLoaderRead(fileName, length);
+        size = (NULL != pData) ? size_t(length) : 0;
+        return pData;
+    }
+
     virtual void ReleaseData(char* pData)
     {
         NvAssetLoaderFree(pData);
@@ -254,13 +132,9 @@ nv::vec3f ThreadedRenderingGL::ms_tankMax(30.0f, 25.0f, 30.0f);
 ThreadedRenderingGL::ThreadedRenderingGL() :
     NvSampleAppGL(),
     m_bFollowingSchool(false),
-    m_frameStartLock(nullptr),
-    m_frameStartCV(nullptr),
-    m_needsUpdateQueueLock(nullptr),
-    m_doneCount(0),
-    m_doneCountLock(nullptr),
-    m_doneCountCV(nullptr), 
+    m_jobSystem(nullptr),
     m_activeThreads(0),
+    m_maxThreads(1),
     m_bAZDOAvailable(false),
     m_bAZDOEnabled(false),
     m_pMultiDrawModelSet(nullptr),
@@ -268,7 +142,6 @@ ThreadedRenderingGL::ThreadedRenderingGL() :
     m_fences(nullptr),
     m_numDrawAheadFrames(3), // Must be >0
     m_currentFenceIndex(0),
-    m_running(true),
     m_shader_GroundPlane(nullptr),
     m_shader_Skybox(nullptr),
     m_shader_Fish(nullptr),
@@ -337,10 +210,6 @@ ThreadedRenderingGL::ThreadedRenderingGL() :
     m_meanCPUMainCopyVBO(0.0f),
     m_meanGPUFrameMS(0.0f)
 {
-#if STRESS_TEST
-    // Full complexity for the stress test
-    neighborSkip = 5;
-#endif
     ms_tankMax.x = ms_tankMax.z = (float)m_uiTankSize;
     ms_tankMin.x = ms_tankMin.z = -ms_tankMax.x;
     m_startingCameraPosition = (ms_tankMin + ms_tankMax) * 0.5f;
@@ -367,13 +236,6 @@ ThreadedRenderingGL::ThreadedRenderingGL() :
         m_models[i] = nullptr;
     }
 
-    for (uint32_t i = 0; i < MAX_ANIMATION_THREAD_COUNT; i++)
-    {
-        m_threads[i].m_thread = NULL;
-        m_threads[i].m_app = this;
-        m_threads[i].m_index = i;
-    }
-
     initializeSchoolDescriptions(50);
 
     // We have the option of not synchronizing access to our instancing buffers.  This will
@@ -458,6 +320,7 @@ void ThreadedRenderingGL::initRendering(void)
     NvAssetLoaderAddSearchPath("es3aep-kepler/ThreadedRenderingGL");
     ThreadedRenderingModelLoader loader;
     Nv::NvModelExt::SetFileLoader(&loader);
+    Nv::NvModelExt::SetJobSystem(&getJobSystem());
 
     // Load all shaders
     m_shader_GroundPlane = NvGLSLProgram::createFromFiles("src_shaders/groundplane_VS.glsl", "src_shaders/groundplane_FS.glsl");
@@ -883,11 +746,22 @@ void ThreadedRenderingGL::updateSchoolTankSizes()
 
 uint32_t ThreadedRenderingGL::setAnimationThreadNum(uint32_t numThreads)
 {
-    if (MAX_ANIMATION_THREAD_COUNT < numThreads)
+    if (m_maxThreads < numThreads)
     {
-        numThreads = MAX_ANIMATION_THREAD_COUNT;
+        numThreads = m_maxThreads;
+    }
+    if (numThreads < 1)
+    {
+        numThreads = 1;
+    }
+
+    // The main thread is one of the job system's threads
+    if (numThreads != m_activeThreads)
+    {
+        cleanThreads();
+        m_jobSystem = NV_NEW(nvidia::shdfnd::JobSystem)(numThreads - 1);
+        m_activeThreads = numThreads;
     }
-    m_activeThreads = numThreads;
 
 #if FISH_DEBUG
     LOGI("Active Animation Thread Count = %d", m_activeAnimThreads);
@@ -944,7 +818,7 @@ void ThreadedRenderingGL::initUI(void)
 
         NvTweakVarBase* var;
         mTweakBar->addLabel("Fish Settings", true);
-        mTweakBar->addValue("Number of Schools", m_uiSchoolCount, MAX_ANIMATION_THREAD_COUNT, m_maxSchools, 10, UIACTION_SCHOOLCOUNT);
+        mTweakBar->addValue("Number of Schools", m_uiSchoolCount, MIN_SCHOOL_COUNT, m_maxSchools, 10, UIACTION_SCHOOLCOUNT);
         mTweakBar->addValue("Fish per School", m_uiInstanceCount, 1, MAX_INSTANCE_COUNT, 1, UIACTION_INSTCOUNT);
         mTweakBar->addValue("Max Roam Distance", m_uiTankSize, 1, 60, 1, UIACTION_TANKSIZE);
 
@@ -952,7 +826,7 @@ void ThreadedRenderingGL::initUI(void)
         mTweakBar->addLabel("Rendering Settings", true);
         mTweakBar->addValue("Batch Size (Fish per Draw Call)", m_uiBatchSize, 1, MAX_INSTANCE_COUNT, 1, UIACTION_BATCHSIZE,
             &m_pBatchSlider, &m_pBatchVar);
-        mTweakBar->addValue("Number of Worker Threads", m_uiThreadCount, 1, MAX_ANIMATION_THREAD_COUNT, 1, UIACTION_ANIMTHREADCOUNT);
+        mTweakBar->addValue("Number of Worker Threads", m_uiThreadCount, 1, m_maxThreads, 1, UIACTION_ANIMTHREADCOUNT);
         mTweakBar->addMenu("Mode", m_uiRenderingTechnique, &(RENDER_TECHNIQUES[0]), 
             m_bAZDOAvailable?TECHNIQUE_COUNT : TECHNIQUE_GLAZDO_POOLED,
             UIACTION_RENDERINGTECHNIQUE);
@@ -965,8 +839,6 @@ void ThreadedRenderingGL::initUI(void)
         var = mTweakBar->addValue("Use Avoidance", m_avoidance);
         addTweakKeyBind(var, NvKey::K_R);
 
-        mTweakBar->addValue("Flocking Complexity", neighborSkip, 1, 5);
-
         mTweakBar->addLabel("Reset Schools", true);
         m_pFishFireworksVar = mTweakBar->addButton("Fish Fireworks", UIACTION_RESET_FISHFIREWORKS);
         addTweakButtonBind(m_pFishFireworksVar, NvGamepad::BUTTON_Y);
@@ -1676,8 +1548,6 @@ float ThreadedRenderingGL::getClampedFrameTime() {
 
 void ThreadedRenderingGL::draw(void)
 {
-    neighborOffset = (neighborOffset + 1) % (6 - neighborSkip);
-
     s_threadMask = 0;
 
     if (m_bTankSizeChanged)
@@ -1776,77 +1646,15 @@ void ThreadedRenderingGL::draw(void)
     {
         CPU_TIMER_SCOPE(CPU_TIMER_MAIN_WAIT);
 
-        for (uint32_t i = 0; i < MAX_ANIMATION_THREAD_COUNT; i++) {
-            ThreadData& thread = m_threads[i];
-            thread.m_cmdBufferOpen = false;
-            thread.m_drawCallCount = 0;
-        }
-
-#ifdef USE_STATIC_THREAD_WORK
-        // If we're assigning a fixed number of schools for each thread
-        // to update, set up each of the ThreadData structures with 
-        // the appropriate ranges
-        uint32_t schoolsPerThread = m_activeSchools / m_activeThreads;
-        uint32_t remainderSchools = m_activeSchools % m_activeThreads;
-        uint32_t baseSchool = 0;
-        for (uint32_t i = 0; i < m_activeThreads; i++) {
-            ThreadData& thread = m_threads[i];
-            thread.m_baseSchoolIndex = baseSchool;
-            thread.m_schoolCount = schoolsPerThread;
-            // distribute the remainder evenly
-            if (remainderSchools > 0) {
-                thread.m_schoolCount++;
-                remainderSchools--;
-            }
-                
-            baseSchool += thread.m_schoolCount;
-        }
-#endif
-
-        m_doneCount = 0;
         m_drawCallCount = 0;
 
-#ifndef USE_STATIC_THREAD_WORK
-        // If each thread will request a new school to update after
-        // it has completed its current one, we need to populate
-        // our queue with the work required.  Since we are processing
-        // a sequential vector of schools, we could simply have a
-        // "next index" variable that we synchronize on and 
-        // increment, but this implementation illustrates a more
-        // general way to deal with a work queue.
-        m_NeedsUpdateQueueLock->lockMutex();
+        // Update the schools, with the main thread helping until all of
+        // them are done.  A few ranges per thread leaves something to steal.
+        if (!m_animPaused || m_bForceSchoolUpdate)
         {
-            uint32_t schoolIndex = 0;
-            for (; schoolIndex < m_activeSchools; ++schoolIndex)
-            {
-                ThreadJob job;
-                job.school = m_schools[schoolIndex];
-                job.index = schoolIndex;
-
-                m_NeedsUpdateQueue.push_back(job);
-            }
+            uint32_t grainSize = m_activeSchools / (4 * m_activeThreads) + 1;
+            m_jobSystem->parallelFor(0, m_activeSchools, grainSize, animateSchoolsJob, this);
         }
-        m_NeedsUpdateQueueLock->unlockMutex();
-#endif
-
-        // Work is ready to begin.  Signal the threads that we're
-        // ready for them to start updating schools
-        m_frameStartLock->lockMutex();
-        {
-            m_frameStartCV->broadcastConditionVariable();
-        }
-        m_frameStartLock->unlockMutex();
-
-        // Now wait until all schools have finished doing their updates
-        // before moving on to rendering.
-        m_doneCountLock->lockMutex();
-        {
-            while (m_doneCount != m_activeSchools)
-            {
-                m_doneCountCV->waitConditionVariable(m_doneCountLock);
-            }
-        }
-        m_doneCountLock->unlockMutex();
     }
 
     // Rendering
@@ -1977,89 +1785,23 @@ void ThreadedRenderingGL::cleanRendering(void)
 
 void ThreadedRenderingGL::initThreads(void)
 {
-    NV_ASSERT(nullptr != pDevice);
-
-    NvThreadManager* threadManager = getThreadManagerInstance();
-    NV_ASSERT(nullptr != threadManager);
-
-    NV_ASSERT(m_FrameStartLock == NULL);
-    NV_ASSERT(m_FrameStartCV == NULL);
-    NV_ASSERT(m_NeedsUpdateQueueLock == NULL);
-    NV_ASSERT(m_DoneCountLock == NULL);
-    NV_ASSERT(m_DoneCountCV == NULL);
-
-    // Create our synchronization objects
-    m_frameStartLock =
-        threadManager->initializeMutex(false, NvMutex::MutexLockLevelInitial);
-    m_frameStartCV =
-        threadManager->initializeConditionVariable();
-    m_needsUpdateQueueLock =
-        threadManager->initializeMutex(false, NvMutex::MutexLockLevelInitial);
-    m_doneCountLock =
-        threadManager->initializeMutex(false, NvMutex::MutexLockLevelInitial);
-    m_doneCountCV = threadManager->initializeConditionVariable();
-
-    NV_ASSERT(m_FrameStartLock != NULL);
-    NV_ASSERT(m_FrameStartCV != NULL);
-    NV_ASSERT(m_NeedsUpdateQueueLock != NULL);
-    NV_ASSERT(m_DoneCountLock != NULL);
-    NV_ASSERT(m_DoneCountCV != NULL);
-
-    // Initialize each of our animation worker threads
-    for (intptr_t i = 0; i < MAX_ANIMATION_THREAD_COUNT; i++)
-    {
-        ThreadData& thread = m_threads[i];
-        if (thread.m_thread != NULL)
-            delete thread.m_thread;
-
-        void* threadIndex = reinterpret_cast<void*>(i);
-        m_threads[i].m_thread =
-            threadManager->createThread(animateJobFunctionThunk, &thread,
-                                        &(m_threadStacks[i]),
-                                        THREAD_STACK_SIZE,
-                                        NvThread::DefaultThreadPriority);
-
-        NV_ASSERT(thread.m_thread != NULL);
-
-        thread.m_thread->startThread();
-    }
-
-    m_uiThreadCount = setAnimationThreadNum(MAX_ANIMATION_THREAD_COUNT);
+    m_maxThreads = nvidia::shdfnd::Thread::getNbPhysicalCores();
+    if (m_maxThreads < 1)
+        m_maxThreads = 1;
+    if (m_maxThreads > MAX_ANIMATION_THREAD_COUNT)
+        m_maxThreads = MAX_ANIMATION_THREAD_COUNT;
+
+    m_uiThreadCount = setAnimationThreadNum(m_maxThreads);
 }
 
 void ThreadedRenderingGL::cleanThreads(void)
 {
-    NV_ASSERT(nullptr != pDevice);
-
-    NvThreadManager* threadManager = getThreadManagerInstance();
-    NV_ASSERT(nullptr != threadManager);
-
-    m_running = false;
-    if (m_frameStartCV)
-        m_frameStartCV->broadcastConditionVariable();
-
-    for (uint32_t i = 0; i < MAX_ANIMATION_THREAD_COUNT; i++)
+    if (m_jobSystem)
     {
-        if (m_threads[i].m_thread != NULL)
-        {
-            m_threads[i].m_thread->waitThread();
-            threadManager->destroyThread(m_threads[i].m_thread);
-            m_threads[i].m_thread = NULL;
-        }
+        NV_DELETE(m_jobSystem);
+        m_jobSystem = nullptr;
     }
-
-    if (m_needsUpdateQueueLock)
-        threadManager->finalizeMutex(m_needsUpdateQueueLock);
-    if (m_doneCountLock)
-        threadManager->finalizeMutex(m_doneCountLock);
-    if (m_doneCountCV)
-        threadManager->finalizeConditionVariable(m_doneCountCV);
-
-    m_frameStartLock = NULL;
-    m_frameStartCV = NULL;
-    m_needsUpdateQueueLock = NULL;
-    m_doneCountLock = NULL;
-    m_doneCountCV = NULL;
+    m_activeThreads = 0;
 }
 
 //  Draws the skybox with lighting in color and depth
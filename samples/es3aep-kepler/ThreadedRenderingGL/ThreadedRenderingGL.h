@@ -48,7 +48,7 @@
 #include "NvMultiDrawModelSet.h"
 #include "School.h"
 #include <cstdlib>
-#include <deque>
+#include <NsJobSystem.h>
 #include "SchoolStateManager.h"
 
 #define CPU_TIMER_SCOPE(TIMER_ID) NvCPUTimerScope cpuTimer(&m_CPUTimers[TIMER_ID])
@@ -72,8 +72,9 @@ public:
     virtual void draw(void);
 
     enum {
-        MAX_ANIMATION_THREAD_COUNT = 8,
-        THREAD_STACK_SIZE = 8192U
+        // Upper bound on the threads that animate schools, the main thread
+        // included; it only sizes the per-thread timers
+        MAX_ANIMATION_THREAD_COUNT = 32
     };
 
     /// IDs for threads based on the work that they do and the
@@ -148,22 +149,13 @@ public:
         float m_causticTiling;
     };
 
-    /// Book-keeping structure holding data pertinent to a thread
-    /// working on a school
-    struct ThreadData {
-        NvThread* m_thread;
-        ThreadedRenderingGL* m_app;
-        uint32_t m_index;
-        bool m_cmdBufferOpen;
-        uint32_t m_drawCallCount;
-        uint32_t m_baseSchoolIndex;
-        uint32_t m_schoolCount;
-    };
-
-    /// Worker function called by each animation thread to update 
-    /// the flocking animation in the school(s) that it handles
+    /// Job that updates the schools [begin, end)
+    /// \param app Pointer to the application instance
+    /// \param begin Index of the first school to update
+    /// \param end Index one past the last school to update
     /// \param threadIndex Index of the thread calling the method
-    void animateJobFunction(uint32_t threadIndex);
+    static void animateSchoolsJob(void* app, uint32_t begin, uint32_t end,
+        uint32_t threadIndex);
 
     /// Method to update the given school
     /// \param threadIndex Index of the thread calling the function
@@ -269,49 +261,18 @@ private:
     //             the null terminator.
     void buildFullStatsString(char* buffer, int32_t size);
 
-    // Array of stack objects used by the animation threads
-    NVTHREAD_STACK_ALIGN char m_threadStacks[MAX_ANIMATION_THREAD_COUNT][THREAD_STACK_SIZE];
-    
     // Flag indicating whether the camera is currently following a school
     bool m_bFollowingSchool;
 
-    // Array of thread book-keeping structures for the animation threads
-    ThreadData m_threads[MAX_ANIMATION_THREAD_COUNT];
-
-    // Wrapper object to hold schools that need animated along with their index in the array of schools
-    struct ThreadJob
-    {
-        School* m_school;
-        uint32_t m_index;
-    };
-
-    // Mutex and condition variable to signal threads that a new frame is 
-    // started and there's work to be done
-    NvMutex* m_frameStartLock;
-    NvConditionVariable* m_frameStartCV;
-
-    // Queue containing entries for each school that needs to be updated.
-    // (Only used if USE_STATIC_THREAD_WORK is not defined)
-    std::deque<ThreadJob> m_needsUpdateQueue;
-
-    // Mutex to control access to the queue so that only one thread will 
-    // attempt to retrieve a block of work off of the update queue at a time
-    // (Only used if USE_STATIC_THREAD_WORK is not defined)
-    NvMutex* m_needsUpdateQueueLock;
-
-    // Counter of the number of schools that have completed their update so that
-    // a frame can continue its rendering once all schools are updated.
-    uint32_t m_doneCount;
-
-    // Mutex to synchronize access to the count of threads that have completed their work
-    NvMutex* m_doneCountLock;
-
-    // Condition variable to signal that more schools have been completed and that the
-    // m_doneCount value has been modified.
-    NvConditionVariable* m_doneCountCV;
+    // Work-stealing scheduler that animates the schools, with the main
+    // thread helping while it waits for them
+    nvidia::shdfnd::JobSystem* m_jobSystem;
 
     // Number of threads that will run each frame to update schools
     uint32_t m_activeThreads;
+
+    // Highest thread count offered by the UI, one per core
+    uint32_t m_maxThreads;
     
     // Number of frames we want to draw ahead.  Also used to tell the VBO
     // policies how many frames worth of buffer we will need.
@@ -336,8 +297,6 @@ private:
     GLsync* m_fences;
     uint32_t m_currentFenceIndex;
 
-    bool m_running;
-
     NvInputHandler_CameraFly* m_pInputHandler;
 
     // Member fields that hold shader objects
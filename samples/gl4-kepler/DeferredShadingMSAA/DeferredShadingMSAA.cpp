@@ -705,7 +705,10 @@ void DeferredShadingMSAA::draw(void)
             }
         }
 
-        std::ostringstream s;
+        // Rebuilt every frame, so keep the text in the frame's scratch memory
+        typedef std::basic_ostringstream<char, std::char_traits<char>,
+            nvidia::shdfnd::FrameArenaStlAllocator<char> > FrameStringStream;
+        FrameStringStream s;
         s << "geometry: " << std::fixed << std::setprecision(2) << gpuTimesMS[TIMER_GEOMETRY] << " ms" << std::endl;
         s << "compositing: " << std::fixed << std::setprecision(2) << gpuTimesMS[TIMER_COMPOSITING] << " ms" << std::endl;
         m_statsText->SetString(s.str().c_str());
@@ -958,6 +961,14 @@ public:
 		return NvAssetLoaderRead(fileName, length);
 	}
 
+	virtual char* LoadDataFromFileWithSize(const char* fileName, size_t& size)
+	{
+		int32_t length;
+		char* pData = NvAssetLoaderRead(fileName, length);
+		size = (NULL != pData) ? size_t(length) : 0;
+		return pData;
+	}
+
 	virtual void ReleaseData(char* pData)
 	{
 		NvAssetLoaderFree(pData);
@@ -969,6 +980,7 @@ Nv::NvModelExtGL* DeferredShadingMSAA::LoadModelExt(const char *model_filename)
 {
 	MSAALoader loader;
 	Nv::NvModelExt::SetFileLoader(&loader);
+	Nv::NvModelExt::SetJobSystem(&getJobSystem());
 
 	Nv::NvModelExt* pModel = Nv::NvModelExt::CreateFromObj(model_filename, 40.0f, true, true);
 
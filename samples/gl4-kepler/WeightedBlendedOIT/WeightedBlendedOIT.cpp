@@ -219,7 +219,10 @@ void WeightedBlendedOIT::draw(void)
             }
         }
 
-        std::ostringstream s;
+        // Rebuilt every frame, so keep the text in the frame's scratch memory
+        typedef std::basic_ostringstream<char, std::char_traits<char>,
+            nvidia::shdfnd::FrameArenaStlAllocator<char> > FrameStringStream;
+        FrameStringStream s;
         s << "geometry: " << std::fixed << std::setprecision(2) << gpuTimesMS[TIMER_GEOMETRY] << " ms" << std::endl;
         s << "compositing: " << std::fixed << std::setprecision(2) << gpuTimesMS[TIMER_COMPOSITING] << " ms" << std::endl;
         m_statsText->SetString(s.str().c_str());
@@ -117,16 +117,16 @@ public:
     GLint getPositionAttrHandle() const { return m_positionAttrHandle; }
     GLint getNormalAttrHandle() const { return m_normalAttrHandle; }
 
-    void setModelMatrix(const nv::matrix4f& modelMatrix) { setUniformMatrix4fv(m_modelMatrixUHandle, const_cast<GLfloat*>(modelMatrix.get_value())); }
-    void setViewMatrix(const nv::matrix4f& viewMatrix) { setUniformMatrix4fv(m_viewMatrixUHandle, const_cast<GLfloat*>(viewMatrix.get_value())); }
-    void setProjMatrix(const nv::matrix4f& projMatrix) { setUniformMatrix4fv(m_projMatrixUHandle, const_cast<GLfloat*>(projMatrix.get_value())); }
-    void setLightDir(const nv::vec3f& lightDir) { setUniform3fv(m_lightDirUHandle, lightDir.get_value()); }
-    void setLightVPSBMatrices(const nv::matrix4f lightVPSBMatrices[], int32_t count) { setUniformMatrix4fv(m_lightVPSBMatricesUHandle, const_cast<GLfloat*>(lightVPSBMatrices[0].get_value()), count); }
-    void setNormalizedFarPlanes(const nv::vec4f& normalizedFarPlanes) { setUniform4fv(m_normalizedFarPlanesUHandle, normalizedFarPlanes.get_value()); }
-    void setAmbient(const nv::vec3f& ambient) { setUniform3fv(m_ambientUHandle, ambient.get_value()); }
-    void setDiffuseAlbedo(const nv::vec3f& diffuseAlbedo) { setUniform3fv(m_diffuseAlbedoUHandle, diffuseAlbedo.get_value()); }
-    void setSpecularAlbedo(const nv::vec3f& specularAlbedo) { setUniform3fv(m_specularAlbedoUHandle, specularAlbedo.get_value()); }
-    void setSpecularPower(const float& specularPower) { setUniform1f(m_specularPowerUHandle, specularPower); }
+    void setModelMatrix(const nv::matrix4f& modelMatrix) { stageUniformMatrix4fv(m_modelMatrixUHandle, modelMatrix.get_value()); }
+    void setViewMatrix(const nv::matrix4f& viewMatrix) { stageUniformMatrix4fv(m_viewMatrixUHandle, viewMatrix.get_value()); }
+    void setProjMatrix(const nv::matrix4f& projMatrix) { stageUniformMatrix4fv(m_projMatrixUHandle, projMatrix.get_value()); }
+    void setLightDir(const nv::vec3f& lightDir) { stageUniform3fv(m_lightDirUHandle, lightDir.get_value()); }
+    void setLightVPSBMatrices(const nv::matrix4f lightVPSBMatrices[], int32_t count) { stageUniformMatrix4fv(m_lightVPSBMatricesUHandle, lightVPSBMatrices[0].get_value(), count); }
+    void setNormalizedFarPlanes(const nv::vec4f& normalizedFarPlanes) { stageUniform4fv(m_normalizedFarPlanesUHandle, normalizedFarPlanes.get_value()); }
+    void setAmbient(const nv::vec3f& ambient) { stageUniform3fv(m_ambientUHandle, ambient.get_value()); }
+    void setDiffuseAlbedo(const nv::vec3f& diffuseAlbedo) { stageUniform3fv(m_diffuseAlbedoUHandle, diffuseAlbedo.get_value()); }
+    void setSpecularAlbedo(const nv::vec3f& specularAlbedo) { stageUniform3fv(m_specularAlbedoUHandle, specularAlbedo.get_value()); }
+    void setSpecularPower(const float& specularPower) { stageUniform1f(m_specularPowerUHandle, specularPower); }
 
 private:
     GLint m_positionAttrHandle;
@@ -37,12 +37,14 @@
 #include <NvAppBase/NvFramerateCounter.h>
 #include <NvUI/NvTweakBar.h>
 #include <NvUI/NvTweakVar.h>
+#include <cstdlib>
 
 struct UIReactionIDs {
     enum Enum
     {
         Method       = 0x10000001,
         SegmentCount = 0x10000002,
+        CpuCulling   = 0x10000003,
     };
 };
 
@@ -55,11 +57,13 @@ CascadedShadowMapping::CascadedShadowMapping()
     : m_renderer(new CascadedShadowMappingRenderer(*this, *m_transformer))
     , m_method(ShadowMapMethod::GsNoCull)
     , m_frustumSegmentCount(4)
+    , m_cpuCulling(true)
 {
     // Required in all subclasses to avoid silent link issues
     forceLinkHack();
     m_renderer->setShadowMapMethod(static_cast<ShadowMapMethod::Enum>(m_method));
     m_renderer->setFrustumSegmentCount(m_frustumSegmentCount);
+    m_renderer->setCpuCulling(m_cpuCulling);
 }
 
 CascadedShadowMapping::~CascadedShadowMapping() {
@@ -93,6 +97,18 @@ void CascadedShadowMapping::initRendering(void) {
     if (!requireExtension("GL_NV_geometry_shader_passthrough"))
         return;
 
+    // "-knights <n>" lays out an n x n grid of knights to stress the culling
+    const std::vector<std::string>& cmd = getCommandLine();
+    for (std::vector<std::string>::const_iterator iter = cmd.begin(); iter != cmd.end(); ++iter)
+    {
+        if (*iter == "-knights" && (iter + 1) != cmd.end()) {
+            ++iter;
+            const int knightCount = atoi(iter->c_str());
+            if (knightCount > 0)
+                m_renderer->setKnightCount(static_cast<unsigned int>(knightCount));
+        }
+    }
+
     m_renderer->initRendering();
 
     CHECK_GL_ERROR();
@@ -111,6 +127,7 @@ void CascadedShadowMapping::initUI(void) {
         };
         mTweakBar->addEnum("Shadow Map Method", m_method, shadowMapMethods, TWEAKENUM_ARRAYSIZE(shadowMapMethods), UIReactionIDs::Method);
         mTweakBar->addValue("Number of Frustum Segments", m_frustumSegmentCount, 1, MAX_CAMERA_FRUSTUM_SPLIT_COUNT, 1, UIReactionIDs::SegmentCount);
+        mTweakBar->addValue("CPU Instance Culling", m_cpuCulling, UIReactionIDs::CpuCulling);
     }
 
     mFramerate->setMaxReportRate(0.25f);
@@ -127,6 +144,10 @@ NvUIEventResponse CascadedShadowMapping::handleReaction(const NvUIReaction &reac
         break;
     case UIReactionIDs::SegmentCount:
         m_renderer->setFrustumSegmentCount(m_frustumSegmentCount);
+        break;
+    case UIReactionIDs::CpuCulling:
+        m_renderer->setCpuCulling(m_cpuCulling);
+        break;
     default:
         return nvuiEventNotHandled;
     }
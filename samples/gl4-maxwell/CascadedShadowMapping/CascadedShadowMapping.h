@@ -54,6 +54,7 @@ private:
     CascadedShadowMappingRenderer* m_renderer;
     uint32_t m_method;
     uint32_t m_frustumSegmentCount;
+    bool m_cpuCulling;
 };
 
 NvAppBase* NvAppFactory() {
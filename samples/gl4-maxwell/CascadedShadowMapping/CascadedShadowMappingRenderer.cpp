@@ -43,6 +43,7 @@
 #include <NvGLUtils/NvGLSLProgram.h>
 #include <NvAppBase/gl/NvSampleAppGL.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <ctime>
 
@@ -73,6 +74,8 @@ CascadedShadowMappingRenderer::CascadedShadowMappingRenderer(NvSampleAppGL& app,
     , m_lightFBO(0)
     , m_lightTex(0)
     , m_method(ShadowMapMethod::GsNoCull)
+    , m_knightCount(10)
+    , m_cpuCulling(true)
 {
     srand(static_cast<unsigned int>(time(nullptr)));
     m_camera.setMotionMode(NvCameraMotionType::FIRST_PERSON);
@@ -118,7 +121,7 @@ void CascadedShadowMappingRenderer::initRendering()
     m_lightVsOnlyMulticastProgram->init("shaders/LightVsOnly.vert");
 
     // Setup geometry.
-    initGeometry(10);
+    initGeometry(m_knightCount);
 
     // Setup resources for shadow pass.
     glGenFramebuffers(1, &m_lightFBO);
@@ -187,6 +190,7 @@ void CascadedShadowMappingRenderer::shutdownRendering()
     }
 
     m_modelInstances.clear();
+    m_instanceBounds.clear();
     for (unsigned int i = 0; i < m_models.size(); ++i) {
         delete m_models[i];
         m_models[i] = nullptr;
@@ -205,6 +209,16 @@ void CascadedShadowMappingRenderer::setFrustumSegmentCount(unsigned int frustumS
     updateFrustumSegmentFarPlanes();
 }
 
+void CascadedShadowMappingRenderer::setCpuCulling(bool enabled)
+{
+    m_cpuCulling = enabled;
+}
+
+void CascadedShadowMappingRenderer::setKnightCount(unsigned int knightCount)
+{
+    m_knightCount = knightCount;
+}
+
 void CascadedShadowMappingRenderer::initCamera(
     NvCameraXformType::Enum index,
     const nv::vec3f& eye,
@@ -249,14 +263,14 @@ void CascadedShadowMappingRenderer::initGeometry(const unsigned int& knightCount
     nv::matrix4f floorModelMatrix;
     floorModelMatrix.set_scale(halfFloorSize);
     nv::vec3f floorMaterialColor(1.0f, 1.0f, 1.0f);
-    ModelData floorData = { floorGL, floorModelMatrix, floorMaterialColor };
     m_models.push_back(floorGL);
-    m_modelInstances.push_back(floorData);
+    addInstance(floorGL, floorModelMatrix, floorMaterialColor);
 
     // Add knights.
     KnightNvModel* knight = new KnightNvModel();
 	NvModelGL* knightGL = NvModelGL::CreateFromModel(knight);
     m_models.push_back(knightGL);
+    m_modelInstances.reserve(m_modelInstances.size() + knightCount * knightCount);
     for (unsigned int row = 0; row < knightCount; ++row) {
         for (unsigned int col = 0; col < knightCount; ++col) {
             nv::matrix4f knightModelMatrix;
@@ -265,13 +279,30 @@ void CascadedShadowMappingRenderer::initGeometry(const unsigned int& knightCount
             nv::translation(translate, -halfFloorSize + row * 5.0f + 2.5f, 1.75767496f, -halfFloorSize + col * 5.0f + 2.5f);
             knightModelMatrix = translate * scale;
             nv::vec3f knightMaterialColor(1.0f, 1.0f, 1.0f);
-            ModelData knightData = { knightGL, knightModelMatrix, knightMaterialColor };
-            m_modelInstances.push_back(knightData);
+            addInstance(knightGL, knightModelMatrix, knightMaterialColor);
         }
     }
 
 }
 
+void CascadedShadowMappingRenderer::addInstance(NvModelGL* model, const nv::matrix4f& modelMatrix, const nv::vec3f& materialColor)
+{
+    ModelData data = { model, modelMatrix, materialColor };
+    m_modelInstances.push_back(data);
+
+    // Bounding sphere of the model's box, moved to world space and grown by
+    // the largest axis scale of the model matrix
+    const nv::vec3f minExt = model->GetMinExt();
+    const nv::vec3f maxExt = model->GetMaxExt();
+    const nv::vec4f center = modelMatrix * nv::vec4f((minExt + maxExt) * 0.5f, 1.0f);
+    float scale = 0.0f;
+    for (int32_t axis = 0; axis < 3; ++axis) {
+        const nv::vec4f column = modelMatrix.get_column(axis);
+        scale = std::max(scale, nv::length(nv::vec3f(column.x, column.y, column.z)));
+    }
+    m_instanceBounds.add(nv::vec3f(center.x, center.y, center.z), nv::length(maxExt - minExt) * 0.5f * scale);
+}
+
 void CascadedShadowMappingRenderer::updateFrustumSegmentFarPlanes()
 {
     for (unsigned int i = 1; i <= m_frustumSegmentCount; ++i)
@@ -337,6 +368,7 @@ void CascadedShadowMappingRenderer::updateLightProjAndViewports()
 
     // Update light projection matrix to only cover the area viewable by the camera
     nv::ortho3D(m_lightProjMatrix, frustumMin.x, frustumMax.x, frustumMin.y, frustumMax.y, 0.0f, frustumMin.z);
+    m_lightViewProjMatrix = m_lightProjMatrix * m_lightViewMatrix;
 
     // Find a bounding box of segment in light view space.
     float nearSegmentPlane = 0.0f;
@@ -387,6 +419,35 @@ void CascadedShadowMappingRenderer::updateLightProjAndViewports()
     }
 }
 
+void CascadedShadowMappingRenderer::cullInstances()
+{
+    const uint32_t instanceCount = static_cast<uint32_t>(m_modelInstances.size());
+    const uint32_t allSegments = (1u << m_frustumSegmentCount) - 1;
+    if (!m_cpuCulling) {
+        m_lightVisibility.assign(instanceCount, allSegments);
+        m_cameraVisibility.assign(instanceCount, 1u);
+        return;
+    }
+
+    // Every segment renders the whole light projection into its own layer
+    // through a viewport that is larger than the layer; what lands inside
+    // the layer is the segment's frustum, as a sub-range of clip space
+    CullFrustum segmentFrusta[MAX_CAMERA_FRUSTUM_SPLIT_COUNT];
+    for (unsigned int i = 0; i < m_frustumSegmentCount; ++i) {
+        const nv::vec4f& viewport = m_lightViewports[i];
+        const float xMin = std::max(-1.0f, -1.0f - 2.0f * viewport.x / viewport.z);
+        const float xMax = std::min(1.0f, -1.0f + 2.0f * (LIGHT_TEXTURE_SIZE - viewport.x) / viewport.z);
+        const float yMin = std::max(-1.0f, -1.0f - 2.0f * viewport.y / viewport.w);
+        const float yMax = std::min(1.0f, -1.0f + 2.0f * (LIGHT_TEXTURE_SIZE - viewport.y) / viewport.w);
+        segmentFrusta[i].setFromMatrix(m_lightViewProjMatrix, xMin, yMin, xMax, yMax);
+    }
+    m_instanceBounds.cull(segmentFrusta, m_frustumSegmentCount, m_lightVisibility);
+
+    CullFrustum cameraFrustum;
+    cameraFrustum.setFromMatrix(m_projMatrix * m_camera.getModelViewMat());
+    m_instanceBounds.cull(&cameraFrustum, 1, m_cameraVisibility);
+}
+
 void CascadedShadowMappingRenderer::renderLight()
 {
     LightProgram *shader = 0;
@@ -414,6 +475,7 @@ void CascadedShadowMappingRenderer::renderLight()
 
     glBindFramebuffer(GL_FRAMEBUFFER, m_lightFBO);
     updateLightProjAndViewports();
+    cullInstances();
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
     glCullFace(GL_BACK);
@@ -421,26 +483,31 @@ void CascadedShadowMappingRenderer::renderLight()
     const GLfloat one = 1.0f;
     glClearBufferfv(GL_DEPTH, 0, &one);
 
-    shader->setUniform1i("frustumSegmentCount", m_frustumSegmentCount);
+    // Staged values that did not change since the last frame are not re-sent
+    shader->stageUniform1i(shader->getUniformLocation("frustumSegmentCount"), m_frustumSegmentCount);
 
-    // VS only method uses static viewport mask
-    if (m_method == ShadowMapMethod::VsOnlyMulticast) {
-        int mask = 0;
-        for (unsigned int i = 0; i < m_frustumSegmentCount; ++i)
-            mask += 1 << i;
-        shader->setUniform1i("viewportMask", mask);
-    }
+    // VS only method takes its viewport mask from the instance's segments
+    const GLint viewportMaskLocation = (m_method == ShadowMapMethod::VsOnlyMulticast) ?
+        shader->getUniformLocation("viewportMask") : -1;
 
     // Send viewport parameters for culling
     if (m_method == ShadowMapMethod::GsCull || m_method == ShadowMapMethod::MulticastCull || m_method == ShadowMapMethod::FgsMulticastCull) {
-        shader->setUniform2f("shadowMapSize", LIGHT_TEXTURE_SIZE, LIGHT_TEXTURE_SIZE);
-        shader->setUniform4fv("viewports", m_lightViewports[0]._array, m_frustumSegmentCount);
+        shader->stageUniform2f(shader->getUniformLocation("shadowMapSize"), LIGHT_TEXTURE_SIZE, LIGHT_TEXTURE_SIZE);
+        shader->stageUniform4fv(shader->getUniformLocation("viewports"), m_lightViewports[0]._array, m_frustumSegmentCount);
     }
 
     for (unsigned int i = 0; i < m_modelInstances.size(); ++i)
     {
-        const nv::matrix4f mvpMatrix = m_lightProjMatrix * m_lightViewMatrix * m_modelInstances[i].modelMatrix;
+        // Instances outside every segment cast no shadow into the map
+        const uint32_t segmentMask = m_lightVisibility[i];
+        if (!segmentMask)
+            continue;
+
+        const nv::matrix4f mvpMatrix = m_lightViewProjMatrix * m_modelInstances[i].modelMatrix;
         shader->setMvpMatrix(mvpMatrix);
+        if (viewportMaskLocation >= 0)
+            shader->stageUniform1i(viewportMaskLocation, segmentMask);
+        shader->flushUniforms();
         m_modelInstances[i].model->drawElements(shader->getPositionAttrHandle());
     }
 
@@ -474,8 +541,12 @@ void CascadedShadowMappingRenderer::renderCamera()
 
     for (unsigned int i = 0; i < m_modelInstances.size(); ++i)
     {
+        if (!m_cameraVisibility[i])
+            continue;
+
         m_cameraProgram->setModelMatrix(m_modelInstances[i].modelMatrix);
         m_cameraProgram->setDiffuseAlbedo(m_modelInstances[i].materialColor);
+        m_cameraProgram->flushUniforms();
         m_modelInstances[i].model->drawElements(
             m_cameraProgram->getPositionAttrHandle(),
             m_cameraProgram->getNormalAttrHandle()
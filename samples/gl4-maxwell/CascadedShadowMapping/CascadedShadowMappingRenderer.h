@@ -36,6 +36,7 @@
 #include <NvAppBase/NvInputTransformer.h>
 #include <NvGLUtils/NvModelGL.h>
 #include "CascadedShadowMappingCommon.h"
+#include "InstanceCulling.h"
 
 class CameraProgram;
 class LightVsOnlyProgram;
@@ -61,6 +62,10 @@ public:
 
     void setShadowMapMethod(ShadowMapMethod::Enum method);
     void setFrustumSegmentCount(unsigned int frustumSegmentCount);
+    void setCpuCulling(bool enabled);
+    // Knights are placed on a knightCount x knightCount grid; takes effect
+    // on the next initRendering
+    void setKnightCount(unsigned int knightCount);
 private:
     NvSampleAppGL&      m_app;
     // Camera params.
@@ -81,6 +86,7 @@ private:
     nv::vec3f    m_lightDir;
     nv::matrix4f m_lightViewMatrix;
     nv::matrix4f m_lightProjMatrix;
+    nv::matrix4f m_lightViewProjMatrix; // m_lightProjMatrix * m_lightViewMatrix
     nv::matrix4f m_lightSegmentVPSBMatrices[MAX_CAMERA_FRUSTUM_SPLIT_COUNT];
     nv::vec4f    m_lightViewports[MAX_CAMERA_FRUSTUM_SPLIT_COUNT];
 
@@ -96,6 +102,14 @@ private:
     std::vector<NvModelGL*> m_models;
     std::vector<ModelData>  m_modelInstances;
     ShadowMapMethod::Enum   m_method;
+    unsigned int            m_knightCount;
+
+    // CPU culling: world-space bounds of m_modelInstances and, per instance,
+    // the bit mask of the cascades (light) or of the view (camera) it touches
+    bool                    m_cpuCulling;
+    InstanceBounds          m_instanceBounds;
+    std::vector<uint32_t>   m_lightVisibility;
+    std::vector<uint32_t>   m_cameraVisibility;
 
 private:
     CascadedShadowMappingRenderer(const CascadedShadowMappingRenderer&);
@@ -112,10 +126,12 @@ private:
         const nv::vec3f& up);
 
     void initGeometry(const unsigned int& knightCount);
+    void addInstance(NvModelGL* model, const nv::matrix4f& modelMatrix, const nv::vec3f& materialColor);
 
     void frustumBoundingBoxLightViewSpace(float nearPlane, float farPlane, nv::vec4f& min, nv::vec4f& max);
     void updateFrustumSegmentFarPlanes();
     void updateLightProjAndViewports();
+    void cullInstances();
 
     void renderLight();
     void renderCamera();
@@ -0,0 +1,186 @@
+//----------------------------------------------------------------------------------
+// File:        gl4-maxwell\CascadedShadowMapping/InstanceCulling.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "InstanceCulling.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define CULLING_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define CULLING_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Lanes of floats and of the bit masks built from comparing them: four lanes
+// with SSE2 or NEON, a single lane otherwise
+#if CULLING_SSE2
+typedef __m128 FloatN;
+typedef __m128i BitsN;
+static const uint32_t cLaneCount = 4;
+
+static inline FloatN Splat(float f) { return _mm_set1_ps(f); }
+static inline FloatN Load(const float* p) { return _mm_loadu_ps(p); }
+static inline FloatN Add(FloatN a, FloatN b) { return _mm_add_ps(a, b); }
+static inline FloatN MulAdd(FloatN a, FloatN b, FloatN c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+static inline FloatN Min(FloatN a, FloatN b) { return _mm_min_ps(a, b); }
+static inline BitsN NoBits() { return _mm_setzero_si128(); }
+// bit in every lane where x >= 0
+static inline BitsN BitIfNotNegative(FloatN x, uint32_t bit)
+{
+    const __m128i inside = _mm_castps_si128(_mm_cmpge_ps(x, _mm_setzero_ps()));
+    return _mm_and_si128(inside, _mm_set1_epi32((int)bit));
+}
+static inline BitsN Or(BitsN a, BitsN b) { return _mm_or_si128(a, b); }
+static inline void Store(uint32_t* p, BitsN v) { _mm_storeu_si128((__m128i*)p, v); }
+#elif CULLING_NEON
+typedef float32x4_t FloatN;
+typedef uint32x4_t BitsN;
+static const uint32_t cLaneCount = 4;
+
+static inline FloatN Splat(float f) { return vdupq_n_f32(f); }
+static inline FloatN Load(const float* p) { return vld1q_f32(p); }
+static inline FloatN Add(FloatN a, FloatN b) { return vaddq_f32(a, b); }
+static inline FloatN MulAdd(FloatN a, FloatN b, FloatN c) { return vmlaq_f32(c, a, b); }
+static inline FloatN Min(FloatN a, FloatN b) { return vminq_f32(a, b); }
+static inline BitsN NoBits() { return vdupq_n_u32(0); }
+static inline BitsN BitIfNotNegative(FloatN x, uint32_t bit)
+{
+    return vandq_u32(vcgeq_f32(x, vdupq_n_f32(0.0f)), vdupq_n_u32(bit));
+}
+static inline BitsN Or(BitsN a, BitsN b) { return vorrq_u32(a, b); }
+static inline void Store(uint32_t* p, BitsN v) { vst1q_u32(p, v); }
+#else
+typedef float FloatN;
+typedef uint32_t BitsN;
+static const uint32_t cLaneCount = 1;
+
+static inline FloatN Splat(float f) { return f; }
+static inline FloatN Load(const float* p) { return *p; }
+static inline FloatN Add(FloatN a, FloatN b) { return a + b; }
+static inline FloatN MulAdd(FloatN a, FloatN b, FloatN c) { return a * b + c; }
+static inline FloatN Min(FloatN a, FloatN b) { return a < b ? a : b; }
+static inline BitsN NoBits() { return 0; }
+static inline BitsN BitIfNotNegative(FloatN x, uint32_t bit) { return (x >= 0.0f) ? bit : 0; }
+static inline BitsN Or(BitsN a, BitsN b) { return a | b; }
+static inline void Store(uint32_t* p, BitsN v) { *p = v; }
+#endif
+
+void CullFrustum::setFromMatrix(const nv::matrix4f& viewProj, float xMin, float yMin, float xMax, float yMax)
+{
+    // Each bound on a clip coordinate, e.g. x >= xMin * w, is a plane in the
+    // space the matrix transforms from
+    const nv::vec4f rowX = viewProj.get_row(0);
+    const nv::vec4f rowY = viewProj.get_row(1);
+    const nv::vec4f rowZ = viewProj.get_row(2);
+    const nv::vec4f rowW = viewProj.get_row(3);
+
+    planes[0] = rowX - rowW * xMin;
+    planes[1] = rowW * xMax - rowX;
+    planes[2] = rowY - rowW * yMin;
+    planes[3] = rowW * yMax - rowY;
+    planes[4] = rowZ + rowW;
+    planes[5] = rowW - rowZ;
+
+    // Unit normals, so that the plane distance can be compared with a radius
+    for (unsigned int i = 0; i < 6; ++i) {
+        const float len = nv::length(nv::vec3f(planes[i].x, planes[i].y, planes[i].z));
+        if (len > 0.0f)
+            planes[i] /= len;
+    }
+}
+
+InstanceBounds::InstanceBounds()
+    : m_count(0)
+{
+}
+
+void InstanceBounds::clear()
+{
+    m_centerX.clear();
+    m_centerY.clear();
+    m_centerZ.clear();
+    m_radius.clear();
+    m_count = 0;
+}
+
+void InstanceBounds::add(const nv::vec3f& center, float radius)
+{
+    if (m_count == m_radius.size()) {
+        // Grow by a whole group.  The padding spheres sit at the origin with
+        // no radius; their masks are computed and dropped
+        const size_t padded = m_count + cLaneCount;
+        m_centerX.resize(padded, 0.0f);
+        m_centerY.resize(padded, 0.0f);
+        m_centerZ.resize(padded, 0.0f);
+        m_radius.resize(padded, 0.0f);
+    }
+
+    m_centerX[m_count] = center.x;
+    m_centerY[m_count] = center.y;
+    m_centerZ[m_count] = center.z;
+    m_radius[m_count] = radius;
+    ++m_count;
+}
+
+void InstanceBounds::cull(const CullFrustum* frusta, uint32_t frustumCount, std::vector<uint32_t>& masks) const
+{
+    const uint32_t padded = (uint32_t)m_radius.size();
+    masks.resize(padded);
+    if (!padded)
+        return;
+
+    for (uint32_t i = 0; i < padded; i += cLaneCount) {
+        const FloatN x = Load(&m_centerX[i]);
+        const FloatN y = Load(&m_centerY[i]);
+        const FloatN z = Load(&m_centerZ[i]);
+        const FloatN r = Load(&m_radius[i]);
+
+        BitsN bits = NoBits();
+        for (uint32_t f = 0; f < frustumCount; ++f) {
+            // The sphere is outside if it lies entirely behind any plane, so
+            // keep the smallest signed distance plus radius over the planes
+            const nv::vec4f* planes = frusta[f].planes;
+            FloatN nearest = MulAdd(Splat(planes[0].x), x, MulAdd(Splat(planes[0].y), y,
+                MulAdd(Splat(planes[0].z), z, Splat(planes[0].w))));
+            for (unsigned int p = 1; p < 6; ++p) {
+                const FloatN dist = MulAdd(Splat(planes[p].x), x, MulAdd(Splat(planes[p].y), y,
+                    MulAdd(Splat(planes[p].z), z, Splat(planes[p].w))));
+                nearest = Min(nearest, dist);
+            }
+            bits = Or(bits, BitIfNotNegative(Add(nearest, r), 1u << f));
+        }
+        Store(&masks[i], bits);
+    }
+
+    masks.resize(m_count);
+}
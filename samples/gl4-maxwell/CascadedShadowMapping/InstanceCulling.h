@@ -0,0 +1,74 @@
+//----------------------------------------------------------------------------------
+// File:        gl4-maxwell\CascadedShadowMapping/InstanceCulling.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#pragma once
+
+#include <NV/NvMath.h>
+#include <vector>
+
+// Frustum as six planes with unit normals pointing inwards: a point p is
+// inside when dot(plane.xyz, p) + plane.w >= 0 for every plane.
+struct CullFrustum {
+    nv::vec4f planes[6];
+
+    // Planes of the clip-space region xMin <= x/w <= xMax, yMin <= y/w <= yMax,
+    // -1 <= z/w <= 1 of a view-projection matrix.  The default bounds give the
+    // whole view volume; narrower bounds select the part of it that lands
+    // inside a viewport.
+    void setFromMatrix(const nv::matrix4f& viewProj,
+        float xMin = -1.0f, float yMin = -1.0f, float xMax = 1.0f, float yMax = 1.0f);
+};
+
+// World-space bounding spheres of the model instances.  They are stored one
+// array per component, padded to the SIMD width, so that four spheres are
+// tested against a plane at a time.
+class InstanceBounds {
+public:
+    InstanceBounds();
+
+    void clear();
+    void add(const nv::vec3f& center, float radius);
+    uint32_t size() const { return m_count; }
+
+    // Tests every sphere against each frustum.  masks receives one word per
+    // sphere, with bit i set when the sphere is at least partly inside
+    // frusta[i].  At most 32 frusta.
+    void cull(const CullFrustum* frusta, uint32_t frustumCount, std::vector<uint32_t>& masks) const;
+
+private:
+    std::vector<float> m_centerX;
+    std::vector<float> m_centerY;
+    std::vector<float> m_centerZ;
+    std::vector<float> m_radius;
+    uint32_t m_count;
+};
@@ -83,7 +83,7 @@ public:
 
     GLint getPositionAttrHandle() const { return m_positionAttrHandle; }
 
-    void setMvpMatrix(const nv::matrix4f& mvpMatrix) { setUniformMatrix4fv(m_mvpMatrixUHandle, const_cast<float*>(mvpMatrix.get_value())); }
+    void setMvpMatrix(const nv::matrix4f& mvpMatrix) { stageUniformMatrix4fv(m_mvpMatrixUHandle, mvpMatrix.get_value()); }
 
 protected:
     GLint m_positionAttrHandle;
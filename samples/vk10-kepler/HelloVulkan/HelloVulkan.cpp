@@ -259,11 +259,8 @@ void HelloVulkan::shutdownRendering(void) {
 
 	vkDestroyCommandPool(device(), mCmdPool, NULL);
 
-    if (mVertexBuffer.mem != VK_NULL_HANDLE)
-		vkFreeMemory(device(), mVertexBuffer.mem, NULL);
-
-	if (mIndexBuffer.mem != VK_NULL_HANDLE)
-		vkFreeMemory(device(), mIndexBuffer.mem, NULL);
+	vk().freeMemory(mVertexBuffer);
+	vk().freeMemory(mIndexBuffer);
 }
 
 void HelloVulkan::initUI(void) {
@@ -62,6 +62,14 @@ public:
 		return NvAssetLoaderRead(fileName, length);
 	}
 
+	virtual char* LoadDataFromFileWithSize(const char* fileName, size_t& size)
+	{
+		int32_t length;
+		char* pData = NvAssetLoaderRead(fileName, length);
+		size = (NULL != pData) ? size_t(length) : 0;
+		return pData;
+	}
+
 	virtual void ReleaseData(char* pData)
 	{
 		NvAssetLoaderFree(pData);
@@ -74,6 +82,16 @@ ModelTestVk::ModelTestVk()
 	m_transformer->setTranslationVec(nv::vec3f(0.0f, 0.0f, -3.0f));
 	m_transformer->setRotationVec(nv::vec3f(NV_PI*0.35f, 0.0f, 0.0f));
 
+	// Prefetching only pays off on slow storage; with the files already in the
+	// OS cache it is measurably slower, so it is left to the command line
+	mPrefetchAssets = false;
+	const std::vector<std::string>& cmd = getCommandLine();
+	for (std::vector<std::string>::const_iterator iter = cmd.begin(); iter != cmd.end(); ++iter)
+	{
+		if (*iter == "-prefetch")
+			mPrefetchAssets = true;
+	}
+
 	// Required in all subclasses to avoid silent link issues
 	forceLinkHack();
 }
@@ -87,6 +105,19 @@ void ModelTestVk::initRendering(void) {
 	VkResult result;
 	NvAssetLoaderAddSearchPath("vk10-kepler/ModelTestVk");
 
+	if (mPrefetchAssets) {
+		// Read the files that are loaded further down in the background, while
+		// the cube map and the preprocessed models are being set up
+		const char* prefetchNames[] = {
+			"models/sponza.nve",
+#ifndef SOURCE_SHADERS
+			"shaders/base_model.nvs",
+			"shaders/cube_map.nvs",
+#endif
+		};
+		NvAssetLoaderPrefetch(prefetchNames, sizeof(prefetchNames) / sizeof(prefetchNames[0]));
+	}
+
 	/////////////////
 	// Setup textures
 	NvVkTexture tex;
@@ -132,11 +163,7 @@ void ModelTestVk::initRendering(void) {
 	};
 
 	for (uint32_t i = 0; i < mModelCount; i++) {
-		int32_t length;
-		char *modelData = NvAssetLoaderRead(nvmNames[i], length);
-		NvModelVK* model = NvModelVK::CreateFromPreprocessed(vk(), (uint8_t *)modelData);
-		mModels[i] = model;
-		NvAssetLoaderFree(modelData);
+		mModels[i] = NvModelVK::CreateFromPreprocessedFile(vk(), nvmNames[i]);
 	}
 
 	{
@@ -163,7 +190,7 @@ void ModelTestVk::initRendering(void) {
 	CHECK_VK_RESULT();
 
 	uint8_t* matPtr;
-	result = vkMapMemory(device(), mMatBlockBuffer.mem, 0, matBlockSize, 0, (void**)&matPtr);
+	result = vk().mapMemory(mMatBlockBuffer, 0, matBlockSize, (void**)&matPtr);
 	CHECK_VK_RESULT();
 
 	for (uint32_t i = 0; i < matCount; i++) {
@@ -93,4 +93,6 @@ private:
 	VkPipeline* mModelPipelines;
 	VkPipeline mModelExtPipeline;
 	VkPipeline mQuadPipeline;
+
+	bool mPrefetchAssets;
 };
@@ -0,0 +1,210 @@
+//----------------------------------------------------------------------------------
+// File:        vk10-kepler\ThreadedRenderingVk/FlockingKernels.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef FLOCKINGKERNELS_H_
+#define FLOCKINGKERNELS_H_
+#include "NV/NvMath.h"
+#include <vector>
+
+/// Positions and headings of a set of fish, stored as one array per component
+/// so that the flocking kernels can work on several fish at a time.  Every
+/// array is padded to a multiple of four entries, so a kernel may read a whole
+/// group of four past the last fish.
+struct FishVectors
+{
+    std::vector<float> m_positionX;
+    std::vector<float> m_positionY;
+    std::vector<float> m_positionZ;
+    std::vector<float> m_headingX;
+    std::vector<float> m_headingY;
+    std::vector<float> m_headingZ;
+
+    /// Resizes the arrays to hold the given number of fish, plus the padding
+    void Resize(uint32_t count);
+
+    nv::vec3f GetPosition(uint32_t index) const
+    {
+        return nv::vec3f(m_positionX[index], m_positionY[index], m_positionZ[index]);
+    }
+
+    void SetPosition(uint32_t index, const nv::vec3f& position)
+    {
+        m_positionX[index] = position.x;
+        m_positionY[index] = position.y;
+        m_positionZ[index] = position.z;
+    }
+
+    nv::vec3f GetHeading(uint32_t index) const
+    {
+        return nv::vec3f(m_headingX[index], m_headingY[index], m_headingZ[index]);
+    }
+
+    void SetHeading(uint32_t index, const nv::vec3f& heading)
+    {
+        m_headingX[index] = heading.x;
+        m_headingY[index] = heading.y;
+        m_headingZ[index] = heading.z;
+    }
+};
+
+/// Influence of each fish's neighbors on its heading and speed, found by
+/// AccumulateNeighbors and applied by IntegrateFish.  Padded like FishVectors.
+struct FishSteering
+{
+    std::vector<float> m_repulsionX;
+    std::vector<float> m_repulsionY;
+    std::vector<float> m_repulsionZ;
+    std::vector<float> m_alignmentX;
+    std::vector<float> m_alignmentY;
+    std::vector<float> m_alignmentZ;
+    std::vector<float> m_cohesionX;
+    std::vector<float> m_cohesionY;
+    std::vector<float> m_cohesionZ;
+
+    /// Number of neighbors being avoided by turning away from them
+    std::vector<float> m_repulsionCount;
+
+    /// -1 to slow down, 1 to speed up or 0 to return to cruising speed
+    std::vector<float> m_speedChange;
+
+    /// Resizes the arrays to hold the given number of fish, plus the padding
+    void Resize(uint32_t count);
+};
+
+/// Sums over the neighbors of one fish, gathered by AccumulateNeighbors
+struct NeighborSums
+{
+    NeighborSums()
+        : m_repulsion(0.0f, 0.0f, 0.0f)
+        , m_alignment(0.0f, 0.0f, 0.0f)
+        , m_nearOffset(0.0f, 0.0f, 0.0f)
+        , m_repulsionCount(0)
+        , m_nearCount(0)
+        , m_accelerateCount(0)
+        , m_decelerateCount(0)
+    {}
+
+    /// Sum of the directions away from the neighbors to the side that are too close
+    nv::vec3f m_repulsion;
+    /// Sum of the headings of the neighbors close enough to align with
+    nv::vec3f m_alignment;
+    /// Sum of the offsets from the search's origin of every visited neighbor
+    nv::vec3f m_nearOffset;
+    uint32_t m_repulsionCount;
+    /// Number of neighbors within the alignment distance
+    uint32_t m_nearCount;
+    uint32_t m_accelerateCount;
+    uint32_t m_decelerateCount;
+};
+
+/// The neighbors that AccumulateNeighbors searches, and how close they have to be
+struct NeighborSearch
+{
+    /// Positions and headings of the neighbors, in slot order
+    const FishVectors* m_pNeighbors;
+    /// Index of the fish in each slot, as a float, padded like m_pNeighbors
+    const float* m_pNeighborIndices;
+    /// Point that the offsets in NeighborSums::m_nearOffset are relative to
+    nv::vec3f m_origin;
+    /// Squared distance within which neighbors are avoided
+    float m_repulsionDistance2;
+    /// Squared distance within which neighbors are aligned with.  Neighbors
+    /// further away are skipped.
+    float m_alignmentDistance2;
+};
+
+/// Adds the influences of the neighbors in the given ranges of slots to sums
+/// \param search Neighbors to search
+/// \param fishIndex Index of the fish, so that it can skip itself
+/// \param position Position of the fish
+/// \param heading Heading of the fish
+/// \param pRanges Pairs of first and one past the last slots to visit
+/// \param numRanges Number of pairs in pRanges
+/// \param sums Sums to add the neighbors to
+void AccumulateNeighbors(const NeighborSearch& search, uint32_t fishIndex,
+                         const nv::vec3f& position, const nv::vec3f& heading,
+                         const uint32_t* pRanges, uint32_t numRanges, NeighborSums& sums);
+
+/// School-wide values used by IntegrateFish
+struct FishIntegrationParams
+{
+    static const uint32_t cMaxSchoolsToAvoid = 8;
+
+    float m_frameTime;
+    /// Inertia of the heading for this frame; zero or less to ignore the
+    /// current heading
+    float m_frameInertia;
+    nv::vec3f m_goal;
+    nv::vec3f m_lastCentroid;
+    /// Lowest height the fish can swim at
+    float m_minHeight;
+
+    float m_goalScale;
+    float m_alignmentScale;
+    float m_repulsionScale;
+    float m_cohesionScale;
+    float m_schoolAvoidanceScale;
+
+    float m_maxSpeed;
+    float m_minAvoidanceSpeed;
+    float m_maxAvoidanceSpeed;
+
+    /// Other schools to swim away from, with how strongly to avoid each one
+    uint32_t m_numSchoolsToAvoid;
+    nv::vec3f m_avoidCenters[cMaxSchoolsToAvoid];
+    float m_avoidRadii[cMaxSchoolsToAvoid];
+    float m_avoidWeights[cMaxSchoolsToAvoid];
+};
+
+/// Steers the fish, moves them along their previous headings and updates their
+/// speeds and animation times, several at a time
+/// \param params School-wide values
+/// \param steering Influence of each fish's neighbors
+/// \param fish Positions and headings of the fish
+/// \param pSpeeds Speed of each fish, padded like fish
+/// \param pAnimTimes Animation time of each fish, padded like fish
+/// \param count Number of fish to update
+/// \param positionSum Returns the sum of the new positions
+/// \param distance2Sum Returns the sum of the squared distances of the previous
+///                     positions from params.m_lastCentroid
+void IntegrateFish(const FishIntegrationParams& params, const FishSteering& steering,
+                   FishVectors& fish, float* pSpeeds, float* pAnimTimes, uint32_t count,
+                   nv::vec3f& positionSum, float& distance2Sum);
+
+/// Rounds a number of fish up to the padded size of the arrays holding them
+inline uint32_t PaddedFishCount(uint32_t count)
+{
+    return (count + 3) & ~3u;
+}
+
+#endif // FLOCKINGKERNELS_H_
@@ -68,7 +68,7 @@ namespace Nv
 		if (result != VK_SUCCESS)
 			return false;
 
-		result = vkMapMemory(vk->device(), m_vbo.mem, 0, m_bufferSize, 0, (void**)&m_vboData);
+		result = vk->mapMemory(m_vbo, 0, m_bufferSize, (void**)&m_vboData);
 		if (result != VK_SUCCESS)
 			return false;
 
@@ -136,7 +136,7 @@ namespace Nv
 	void NvSharedVBOVK::EndUpdate() {
 		VkMappedMemoryRange range = { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
 		range.memory = m_vbo.mem;
-		range.offset = getDynamicOffset();
+		range.offset = m_vbo.memOffset + getDynamicOffset();
 		range.size = m_dataSize;
 		vkFlushMappedMemoryRanges(m_vk->device(), 1, &range);
 	}
@@ -51,7 +51,7 @@ namespace Nv
 			if (result != VK_SUCCESS)
 				return false;
 
-			result = vkMapMemory(vk.device(), m_buffer.mem, 0, size, 0, (void**)&m_mapped);
+			result = vk.mapMemory(m_buffer, 0, size, (void**)&m_mapped);
 			if (result != VK_SUCCESS)
 				return false;
 
@@ -38,6 +38,8 @@
 #include "NvVkUtil/NvSimpleUBO.h"
 #include "NvVkUtil/NvModelExtVK.h"
 #include "NvSharedVBOVK.h"
+#include "SpatialGrid.h"
+#include "FlockingKernels.h"
 
 #include <NV/NvPlatformGL.h>
 #include "NvGLUtils/NvModelExtGL.h"
@@ -345,17 +347,24 @@ private:
 
 	SchoolFlockingParams m_flockParams;
 
-	/// Current state of each fish in the school
-	struct FishState
-	{
-		nv::vec3f m_position;
-		nv::vec3f m_heading;
-		float m_speed;
-        float m_animTime;
-        float m_animStartOffset;
-	};
-	typedef std::vector<FishState> FishSet;
-	FishSet m_fish;
+	/// Current positions and headings of the fish in the school
+	FishVectors m_fish;
+
+	/// Current animation state of each fish in the school, padded like m_fish
+	std::vector<float> m_fishSpeeds;
+	std::vector<float> m_fishAnimTimes;
+	std::vector<float> m_fishAnimStartOffsets;
+
+	/// Spatial index of the fish, rebuilt each frame to find their neighbors
+	SpatialGrid m_neighborGrid;
+
+	/// Positions, headings and indices of the fish at the start of the frame,
+	/// in the order of the slots of m_neighborGrid
+	FishVectors m_neighbors;
+	std::vector<float> m_neighborIndices;
+
+	/// Influence of each fish's neighbors, found at the start of Animate
+	FishSteering m_steering;
 
 	float m_tailStartZ;
 
@@ -34,6 +34,7 @@
 #ifndef SCHOOLSTATEMANAGER_H_
 #define SCHOOLSTATEMANAGER_H_
 #include "NV/NvMath.h"
+#include "SpatialGrid.h"
 
 /// Structure to hold last computed state for a particular School
 struct SchoolState
@@ -58,6 +59,7 @@ public:
     SchoolStateManager(uint32_t maxSchools)
         : m_capacity(maxSchools)
         , m_numReadStates(0)
+        , m_maxReadRadius(0.0f)
         , m_numWriteStates(0)
     {
         m_readBuffer = new SchoolState[maxSchools];
@@ -86,6 +88,18 @@ public:
 
         // The number of writable states is the number passed in
         m_numWriteStates = numSchools;
+
+        // Index the readable states by center, in cells big enough that
+        // two overlapping schools are never more than a cell apart
+        m_maxReadRadius = 0.0f;
+        for (uint32_t i = 0; i < m_numReadStates; ++i)
+        {
+            if (m_readBuffer[i].m_radius > m_maxReadRadius)
+            {
+                m_maxReadRadius = m_readBuffer[i].m_radius;
+            }
+        }
+        m_readGrid.Build(&m_readBuffer[0].m_center, m_numReadStates, sizeof(SchoolState), m_maxReadRadius * 2.0f);
     }
 
     /// Return the number of states written to last frame, thus readable this frame
@@ -95,6 +109,12 @@ public:
     /// Retrieve a pointer to the readable buffer of SchoolStates for this frame
     SchoolState* GetReadStates() { return m_readBuffer; }
 
+    /// Retrieve the spatial index of the readable SchoolStates' centers
+    const SpatialGrid& GetReadGrid() const { return m_readGrid; }
+
+    /// Return the largest radius of the readable SchoolStates
+    float GetMaxReadRadius() const { return m_maxReadRadius; }
+
     /// Return the number of states writable to for this frame
     /// \return The number of states in the writable buffer
     uint32_t GetNumWriteStates() const { return m_numWriteStates; }
@@ -117,6 +137,12 @@ protected:
     /// Pointer to the currently readable set of SchoolStates
     SchoolState* m_readBuffer;
 
+    /// Spatial index of the centers in m_readBuffer
+    SpatialGrid m_readGrid;
+
+    /// Largest radius in m_readBuffer
+    float m_maxReadRadius;
+
     /// Current number of SchoolStates in m_writeBuffer
     uint32_t m_numWriteStates;
 
@@ -0,0 +1,135 @@
+//----------------------------------------------------------------------------------
+// File:        vk10-kepler\ThreadedRenderingVk/SpatialGrid.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef SPATIALGRID_H_
+#define SPATIALGRID_H_
+#include "NV/NvMath.h"
+#include <vector>
+
+/// Uniform grid over a set of points, used to find the points near a location
+/// without testing all of them.  The grid is rebuilt from scratch each frame:
+/// the points are counting-sorted by cell, so the points of a row of cells are
+/// one contiguous range of "slots".
+class SpatialGrid
+{
+public:
+    SpatialGrid();
+
+    /// Bins the points into cells
+    /// \param pX Pointer to the X coordinate of the first point
+    /// \param pY Pointer to the Y coordinate of the first point
+    /// \param pZ Pointer to the Z coordinate of the first point
+    /// \param count Number of points
+    /// \param stride Distance, in bytes, from one coordinate to the same
+    ///               coordinate of the next point
+    /// \param cellSize Minimum edge length of a cell.  The cells are made larger
+    ///                 if the points are spread out enough to need more than a
+    ///                 couple of cells per point.
+    void Build(const float* pX, const float* pY, const float* pZ,
+               uint32_t count, uint32_t stride, float cellSize);
+
+    /// Bins the points into cells
+    /// \param pPoints Pointer to the first point
+    /// \param count Number of points
+    /// \param stride Distance, in bytes, from one point to the next
+    /// \param cellSize Minimum edge length of a cell
+    void Build(const nv::vec3f* pPoints, uint32_t count, uint32_t stride, float cellSize)
+    {
+        Build(&pPoints->x, &pPoints->y, &pPoints->z, count, stride, cellSize);
+    }
+
+    /// Calls visitor(slotBegin, slotEnd) for the slots of every row of cells that
+    /// overlaps the axis-aligned box around center.  Every point within radius
+    /// of center is visited, along with some that are further away.
+    /// \param center Center of the query
+    /// \param radius Half the edge length of the box
+    /// \param visitor Function object called with each range of slots
+    template <class Visitor>
+    void Query(const nv::vec3f& center, float radius, const Visitor& visitor) const
+    {
+        int32_t lo[3], hi[3];
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            float minCell = floorf((center[axis] - radius - m_origin[axis]) * m_invCellSize);
+            float maxCell = floorf((center[axis] + radius - m_origin[axis]) * m_invCellSize);
+            if (maxCell < 0.0f || minCell >= (float)m_dims[axis])
+            {
+                return;
+            }
+            lo[axis] = (minCell < 0.0f) ? 0 : (int32_t)minCell;
+            hi[axis] = (maxCell >= (float)m_dims[axis]) ? (m_dims[axis] - 1) : (int32_t)maxCell;
+        }
+
+        for (int32_t z = lo[2]; z <= hi[2]; ++z)
+        {
+            for (int32_t y = lo[1]; y <= hi[1]; ++y)
+            {
+                const uint32_t row = (uint32_t)((z * m_dims[1] + y) * m_dims[0]);
+                const uint32_t slotBegin = m_cellStarts[row + lo[0]];
+                const uint32_t slotEnd = m_cellStarts[row + hi[0] + 1];
+                if (slotBegin < slotEnd)
+                {
+                    visitor(slotBegin, slotEnd);
+                }
+            }
+        }
+    }
+
+    /// Retrieves the index of the point held in each slot
+    /// \return Array of GetNumPoints() point indices, in cell order
+    const uint32_t* GetSortedIndices() const { return m_sortedIndices.empty() ? nullptr : &m_sortedIndices[0]; }
+
+    /// Retrieves the number of points binned by the last Build
+    uint32_t GetNumPoints() const { return (uint32_t)m_sortedIndices.size(); }
+
+private:
+    /// Minimum corner of the grid
+    nv::vec3f m_origin;
+
+    /// Reciprocal of the edge length of a cell
+    float m_invCellSize;
+
+    /// Number of cells along each axis
+    int32_t m_dims[3];
+
+    /// First slot of each cell, plus one past the last slot
+    std::vector<uint32_t> m_cellStarts;
+
+    /// Index of the point in each slot
+    std::vector<uint32_t> m_sortedIndices;
+
+    /// Cell of each point, kept between the two passes of Build
+    std::vector<uint32_t> m_pointCells;
+};
+
+#endif // SPATIALGRID_H_
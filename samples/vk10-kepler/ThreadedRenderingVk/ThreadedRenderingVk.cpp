@@ -74,9 +74,6 @@
 
 uint32_t s_threadMask = 0;
 
-extern uint32_t neighborOffset;
-extern uint32_t neighborSkip;
-
 
 #ifdef WIN32
 DWORD WINAPI AnimateJobFunctionThunk(VOID *arg)
@@ -204,6 +201,14 @@ public:
 		return NvAssetLoaderRead(fileName, length);
 	}
 
+	virtual char* LoadDataFromFileWithSize(const char* fileName, size_t& size)
+	{
+		int32_t length;
+		char* pData = NvAssetLoaderRead(fileName, length);
+		size = (NULL != pData) ? size_t(length) : 0;
+		return pData;
+	}
+
 	virtual void ReleaseData(char* pData)
 	{
 		NvAssetLoaderFree(pData);
@@ -357,6 +362,7 @@ void ThreadedRenderingVk::initRendering(void)
 	VkResult result;
 	NvAssetLoaderAddSearchPath("vk10-kepler/ThreadedRenderingVk");
 	Nv::NvModelExt::SetFileLoader(&loader);
+	Nv::NvModelExt::SetJobSystem(&getJobSystem());
 
 	if (!isGLSupported()) {
 		showDialog("GL/VK Interop Not Supported", "NVIDIA GL/VK interop extension not supported\n"
@@ -845,7 +851,6 @@ void ThreadedRenderingVk::drawGL(NvAppContextGL* gl) {
         m_threadedRendering = m_requestedThreadedRendering;
     }
 
-	neighborOffset = (neighborOffset + 1) % (6 - neighborSkip);
 	s_threadMask = 0;
 
     if (m_bTankSizeChanged)
@@ -1287,8 +1292,6 @@ void ThreadedRenderingVk::initUI(void)
 		var = mTweakBar->addValue("Use Avoidance", m_avoidance);
 		addTweakKeyBind(var, NvKey::K_R);
 
-		mTweakBar->addValue("Flocking Complexity", neighborSkip, 1, 5);
-
 		mTweakBar->addLabel("Reset Schools", true);
 		m_pFishFireworksVar = mTweakBar->addButton("Fish Fireworks", UIACTION_RESET_FISHFIREWORKS);
         addTweakButtonBind(m_pFishFireworksVar, NvGamepad::BUTTON_Y);
@@ -1880,8 +1883,6 @@ void ThreadedRenderingVk::draw(void)
 		vkDeviceWaitIdle(device());
 	VkResult result;
 
-	neighborOffset = (neighborOffset + 1) % (6 - neighborSkip);
-
 	s_threadMask = 0;
 
     if (m_bTankSizeChanged)